@@ -4,6 +4,7 @@
  */
 
 #include "common-utils.h"
+#include "gstmuxstreamsmeta.h"
 
 #include <json-glib/json-glib.h>
 
@@ -163,15 +164,28 @@ gst_class_label_reset (GstClassLabel * label)
 const gchar *
 gst_mux_stream_name (guint index)
 {
-  g_return_val_if_fail ((G_N_ELEMENTS (mux_stream_names) > index), NULL);
-  return mux_stream_names[index];
+  gchar name[16] = { 0, };
+
+  g_return_val_if_fail ((GST_MUX_MAX_STREAMS > index), NULL);
+
+  if (G_N_ELEMENTS (mux_stream_names) > index)
+    return mux_stream_names[index];
+
+  // Less common higher stream indexes, use interned string for their names.
+  g_snprintf (name, sizeof (name), "mux-stream-%02u", index);
+  return g_intern_string (name);
 }
 
 gint
 gst_mux_buffer_get_memory_stream_id (GstBuffer * buffer, gint mem_idx)
 {
+  GstMuxStreamsMeta *meta = NULL;
   gint num = -1;
 
+  // Prefer the streams bitset meta, offset mask is limited to 32 streams.
+  if ((meta = gst_buffer_get_mux_streams_meta (buffer)) != NULL)
+    return (mem_idx >= 0) ? gst_mux_streams_meta_nth_stream (meta, mem_idx) : -1;
+
   if (GST_BUFFER_OFFSET (buffer) == GST_BUFFER_OFFSET_NONE)
     return -1;
 
@@ -50,6 +50,8 @@ G_BEGIN_DECLS
 // The bit offset where the stream ID can be embedded in a variable
 #define GST_MUX_STREAM_ID_OFFSET       24
 #define GST_MUX_STREAM_ID_MASK         (0xFF << GST_MUX_STREAM_ID_OFFSET)
+// Maximum number of streams which can be identified by the embedded stream ID.
+#define GST_MUX_MAX_STREAMS            256
 
 // The bit offset for stage and sequence ID embedded in a single variable.
 #define GST_META_STAGE_ID_OFFSET       16
@@ -112,6 +114,8 @@ gst_mux_stream_name (guint index);
  * @mem_idx: The index of the memory inside the muxed buffer.
  *
  * Extract the stream ID of the buffer memory inside the muxed buffer.
+ * The #GstMuxStreamsMeta is used if present, otherwise the channels mask
+ * in the buffer offset field.
  *
  * Returns: Stream ID on success or -1 on failure.
  */
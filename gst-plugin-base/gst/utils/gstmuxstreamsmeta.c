@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "gstmuxstreamsmeta.h"
+
+#include <string.h>
+
+#define GST_MUX_STREAMS_N_WORDS \
+    (GST_MUX_MAX_STREAMS / GST_MUX_STREAMS_WORD_BITS)
+
+static gboolean
+gst_mux_streams_meta_init (GstMeta * meta, gpointer params, GstBuffer * buffer)
+{
+  GstMuxStreamsMeta *smeta = GST_MUX_STREAMS_META_CAST (meta);
+
+  memset (smeta->mask, 0, sizeof (smeta->mask));
+  return TRUE;
+}
+
+static gboolean
+gst_mux_streams_meta_transform (GstBuffer * transbuffer, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstMuxStreamsMeta *dmeta = NULL, *smeta = NULL;
+
+  if (!GST_META_TRANSFORM_IS_COPY (type)) {
+    // Return FALSE, if transform type is not supported.
+    return FALSE;
+  }
+
+  smeta = GST_MUX_STREAMS_META_CAST (meta);
+  dmeta = gst_buffer_add_mux_streams_meta (transbuffer);
+
+  if (NULL == dmeta)
+    return FALSE;
+
+  memcpy (dmeta->mask, smeta->mask, sizeof (dmeta->mask));
+
+  GST_DEBUG ("Duplicate Mux Streams metadata");
+  return TRUE;
+}
+
+GType
+gst_mux_streams_meta_api_get_type (void)
+{
+  static GType gtype = 0;
+  static const gchar *tags[] = { NULL };
+
+  if (g_once_init_enter (&gtype)) {
+    GType type = gst_meta_api_type_register ("GstMuxStreamsMetaAPI", tags);
+    g_once_init_leave (&gtype, type);
+  }
+  return gtype;
+}
+
+const GstMetaInfo *
+gst_mux_streams_meta_get_info (void)
+{
+  static const GstMetaInfo *minfo = NULL;
+
+  if (g_once_init_enter ((GstMetaInfo **) &minfo)) {
+    const GstMetaInfo *info = gst_meta_register (
+        GST_MUX_STREAMS_META_API_TYPE, "GstMuxStreamsMeta",
+        sizeof (GstMuxStreamsMeta), gst_mux_streams_meta_init,
+        NULL, gst_mux_streams_meta_transform);
+
+    g_once_init_leave ((GstMetaInfo **) &minfo, (GstMetaInfo *) info);
+  }
+  return minfo;
+}
+
+GstMuxStreamsMeta *
+gst_buffer_add_mux_streams_meta (GstBuffer * buffer)
+{
+  GstMuxStreamsMeta *outmeta = NULL;
+
+  g_return_val_if_fail (buffer != NULL, NULL);
+
+  outmeta = GST_MUX_STREAMS_META_CAST (
+      gst_buffer_add_meta (buffer, GST_MUX_STREAMS_META_INFO, NULL));
+
+  if (NULL == outmeta) {
+    GST_ERROR ("Failed to add Mux Streams meta to buffer %p!", buffer);
+    return NULL;
+  }
+
+  return outmeta;
+}
+
+GstMuxStreamsMeta *
+gst_buffer_get_mux_streams_meta (GstBuffer * buffer)
+{
+  g_return_val_if_fail (buffer != NULL, NULL);
+
+  return GST_MUX_STREAMS_META_CAST (
+      gst_buffer_get_meta (buffer, GST_MUX_STREAMS_META_API_TYPE));
+}
+
+void
+gst_mux_streams_meta_set (GstMuxStreamsMeta * meta, guint stream_id)
+{
+  g_return_if_fail (meta != NULL);
+  g_return_if_fail (stream_id < GST_MUX_MAX_STREAMS);
+
+  meta->mask[stream_id / GST_MUX_STREAMS_WORD_BITS] |=
+      G_GUINT64_CONSTANT (1) << (stream_id % GST_MUX_STREAMS_WORD_BITS);
+}
+
+gboolean
+gst_mux_streams_meta_is_set (const GstMuxStreamsMeta * meta, guint stream_id)
+{
+  g_return_val_if_fail (meta != NULL, FALSE);
+
+  if (stream_id >= GST_MUX_MAX_STREAMS)
+    return FALSE;
+
+  return (meta->mask[stream_id / GST_MUX_STREAMS_WORD_BITS] >>
+      (stream_id % GST_MUX_STREAMS_WORD_BITS)) & 0b01;
+}
+
+guint
+gst_mux_streams_meta_n_streams (const GstMuxStreamsMeta * meta)
+{
+  guint idx = 0, n_streams = 0;
+
+  g_return_val_if_fail (meta != NULL, 0);
+
+  for (idx = 0; idx < GST_MUX_STREAMS_N_WORDS; idx++)
+    n_streams += __builtin_popcountll (meta->mask[idx]);
+
+  return n_streams;
+}
+
+gint
+gst_mux_streams_meta_nth_stream (const GstMuxStreamsMeta * meta, guint index)
+{
+  guint64 word = 0;
+  guint idx = 0, n_bits = 0;
+
+  g_return_val_if_fail (meta != NULL, -1);
+
+  for (idx = 0; idx < GST_MUX_STREAMS_N_WORDS; idx++) {
+    n_bits = __builtin_popcountll (meta->mask[idx]);
+
+    // Skip whole words until the one containing the requested set bit.
+    if (index >= n_bits) {
+      index -= n_bits;
+      continue;
+    }
+
+    // Clear the lowest set bits preceding the requested one.
+    for (word = meta->mask[idx]; index > 0; index--)
+      word &= word - 1;
+
+    return (idx * GST_MUX_STREAMS_WORD_BITS) + __builtin_ctzll (word);
+  }
+
+  return -1;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GST_MUX_STREAMS_META_H__
+#define __GST_MUX_STREAMS_META_H__
+
+#include <gst/gst.h>
+#include "common-utils.h"
+
+G_BEGIN_DECLS
+
+#define GST_MUX_STREAMS_META_API_TYPE  (gst_mux_streams_meta_api_get_type())
+#define GST_MUX_STREAMS_META_INFO      (gst_mux_streams_meta_get_info())
+#define GST_MUX_STREAMS_META_CAST(obj) ((GstMuxStreamsMeta *) obj)
+
+// Number of bits in a single word of the streams bitset.
+#define GST_MUX_STREAMS_WORD_BITS      64
+
+typedef struct _GstMuxStreamsMeta GstMuxStreamsMeta;
+
+/**
+ * GstMuxStreamsMeta:
+ * @meta: Parent #GstMeta
+ * @mask: Bitset with a bit set for each stream present in the muxed buffer.
+ *
+ * Extra buffer metadata describing which streams have memory blocks in a
+ * muxed buffer. The memory blocks are placed in ascending stream ID order,
+ * the N-th memory block (or N-th group of depth blocks) belongs to the N-th
+ * set bit in the mask.
+ *
+ * Replaces the channels mask in the buffer offset field, which is limited to
+ * the number of bits in that field.
+ */
+struct _GstMuxStreamsMeta {
+  GstMeta meta;
+
+  guint64 mask[GST_MUX_MAX_STREAMS / GST_MUX_STREAMS_WORD_BITS];
+};
+
+GST_API GType
+gst_mux_streams_meta_api_get_type (void);
+
+GST_API const GstMetaInfo *
+gst_mux_streams_meta_get_info (void);
+
+/**
+ * gst_buffer_add_mux_streams_meta:
+ * @buffer: A #GstBuffer
+ *
+ * Attaches GstMuxStreamsMeta metadata with an empty streams mask to @buffer.
+ *
+ * Returns: (transfer none): the #GstMuxStreamsMeta on @buffer.
+ */
+GST_API GstMuxStreamsMeta *
+gst_buffer_add_mux_streams_meta (GstBuffer * buffer);
+
+/**
+ * gst_buffer_get_mux_streams_meta:
+ * @buffer: A #GstBuffer
+ *
+ * Find the #GstMuxStreamsMeta on @buffer.
+ *
+ * Returns: (transfer none) (nullable): the #GstMuxStreamsMeta or %NULL when
+ *          there is no such metadata on @buffer.
+ */
+GST_API GstMuxStreamsMeta *
+gst_buffer_get_mux_streams_meta (GstBuffer * buffer);
+
+/**
+ * gst_mux_streams_meta_set:
+ * @meta: A #GstMuxStreamsMeta
+ * @stream_id: The ID of the stream.
+ *
+ * Mark the stream with @stream_id as present in the muxed buffer.
+ */
+GST_API void
+gst_mux_streams_meta_set (GstMuxStreamsMeta * meta, guint stream_id);
+
+/**
+ * gst_mux_streams_meta_is_set:
+ * @meta: A #GstMuxStreamsMeta
+ * @stream_id: The ID of the stream.
+ *
+ * Returns: TRUE if the stream with @stream_id is present in the muxed buffer.
+ */
+GST_API gboolean
+gst_mux_streams_meta_is_set (const GstMuxStreamsMeta * meta, guint stream_id);
+
+/**
+ * gst_mux_streams_meta_n_streams:
+ * @meta: A #GstMuxStreamsMeta
+ *
+ * Returns: The number of streams present in the muxed buffer.
+ */
+GST_API guint
+gst_mux_streams_meta_n_streams (const GstMuxStreamsMeta * meta);
+
+/**
+ * gst_mux_streams_meta_nth_stream:
+ * @meta: A #GstMuxStreamsMeta
+ * @index: Index of the stream among the ones present in the muxed buffer.
+ *
+ * Find the ID of the stream which is at @index position in the muxed buffer.
+ *
+ * Returns: Stream ID on success or -1 if there are not enough streams.
+ */
+GST_API gint
+gst_mux_streams_meta_nth_stream (const GstMuxStreamsMeta * meta, guint index);
+
+G_END_DECLS
+
+#endif /* __GST_MUX_STREAMS_META_H__ */
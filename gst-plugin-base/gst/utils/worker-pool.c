@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "worker-pool.h"
+
+typedef struct _GstWorkerJob GstWorkerJob;
+
+struct _GstWorkerJob {
+  // The user job data.
+  gpointer          data;
+  // Memory accounted for this job.
+  gsize             size;
+
+  // Output buffer, valid once the job is done.
+  GstBuffer         *result;
+  // Whether the job has been processed (or discarded).
+  gboolean          done;
+};
+
+struct _GstWorkerPool {
+  // Lock protecting the jobs queue and the counters.
+  GMutex                   lock;
+  // Signalled each time a job leaves the pool.
+  GCond                    wakeup;
+
+  // Threads processing the jobs.
+  GThreadPool              *threads;
+
+  // Maximum number of concurrent jobs and memory budget.
+  guint                    n_threads;
+  gsize                    max_bytes;
+
+  // Submitted jobs in order, either waiting, running or waiting for output.
+  GQueue                   jobs;
+  // Sum of the sizes of all jobs in the queue.
+  gsize                    n_bytes;
+
+  // Whether one of the threads is currently delivering output buffers.
+  gboolean                 outputting;
+  // Whether the pool is flushing and jobs are being discarded.
+  gboolean                 flushing;
+
+  GstWorkerPoolProcessFunc process;
+  GstWorkerPoolOutputFunc  output;
+  GDestroyNotify           destroy;
+  gpointer                 userdata;
+};
+
+static void
+gst_worker_pool_deliver (GstWorkerPool * pool)
+{
+  GstWorkerJob *job = NULL;
+  gboolean flushing = FALSE;
+
+  g_mutex_lock (&pool->lock);
+
+  // Another thread is delivering, it will also pick up the completed jobs.
+  if (pool->outputting) {
+    g_mutex_unlock (&pool->lock);
+    return;
+  }
+
+  pool->outputting = TRUE;
+
+  // Deliver all consecutive completed jobs from the head of the queue.
+  while (((job = g_queue_peek_head (&pool->jobs)) != NULL) && job->done) {
+    flushing = pool->flushing;
+    g_mutex_unlock (&pool->lock);
+
+    if ((job->result != NULL) && !flushing)
+      pool->output (job->result, pool->userdata);
+    else if (job->result != NULL)
+      gst_buffer_unref (job->result);
+
+    if (pool->destroy != NULL)
+      pool->destroy (job->data);
+
+    g_mutex_lock (&pool->lock);
+
+    g_queue_pop_head (&pool->jobs);
+    pool->n_bytes -= job->size;
+
+    g_slice_free (GstWorkerJob, job);
+    g_cond_broadcast (&pool->wakeup);
+  }
+
+  pool->outputting = FALSE;
+  g_mutex_unlock (&pool->lock);
+}
+
+static void
+gst_worker_pool_thread (gpointer data, gpointer userdata)
+{
+  GstWorkerPool *pool = (GstWorkerPool *) userdata;
+  GstWorkerJob *job = (GstWorkerJob *) data;
+  gboolean flushing = FALSE;
+
+  g_mutex_lock (&pool->lock);
+  flushing = pool->flushing;
+  g_mutex_unlock (&pool->lock);
+
+  // Pending jobs are discarded without processing while flushing.
+  if (!flushing)
+    job->result = pool->process (job->data, pool->userdata);
+
+  g_mutex_lock (&pool->lock);
+  job->done = TRUE;
+  g_mutex_unlock (&pool->lock);
+
+  gst_worker_pool_deliver (pool);
+}
+
+GstWorkerPool *
+gst_worker_pool_new (GstWorkerPoolProcessFunc process,
+    GstWorkerPoolOutputFunc output, GDestroyNotify destroy, gpointer userdata)
+{
+  GstWorkerPool *pool = NULL;
+  GError *error = NULL;
+
+  g_return_val_if_fail (process != NULL, NULL);
+  g_return_val_if_fail (output != NULL, NULL);
+
+  pool = g_slice_new0 (GstWorkerPool);
+
+  g_mutex_init (&pool->lock);
+  g_cond_init (&pool->wakeup);
+
+  g_queue_init (&pool->jobs);
+
+  pool->n_threads = 1;
+  pool->max_bytes = 0;
+
+  pool->process = process;
+  pool->output = output;
+  pool->destroy = destroy;
+  pool->userdata = userdata;
+
+  pool->threads = g_thread_pool_new (gst_worker_pool_thread, pool,
+      pool->n_threads, FALSE, &error);
+
+  if (pool->threads == NULL) {
+    GST_ERROR ("Failed to create thread pool, error: '%s'!",
+        GST_STR_NULL (error->message));
+    g_clear_error (&error);
+
+    g_cond_clear (&pool->wakeup);
+    g_mutex_clear (&pool->lock);
+
+    g_slice_free (GstWorkerPool, pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+void
+gst_worker_pool_free (GstWorkerPool * pool)
+{
+  g_return_if_fail (pool != NULL);
+
+  gst_worker_pool_set_flushing (pool, TRUE);
+
+  g_thread_pool_free (pool->threads, FALSE, TRUE);
+
+  g_cond_clear (&pool->wakeup);
+  g_mutex_clear (&pool->lock);
+
+  g_slice_free (GstWorkerPool, pool);
+}
+
+gboolean
+gst_worker_pool_set_limits (GstWorkerPool * pool, guint n_threads,
+    gsize max_bytes)
+{
+  GError *error = NULL;
+
+  g_return_val_if_fail (pool != NULL, FALSE);
+  g_return_val_if_fail (n_threads != 0, FALSE);
+
+  if (!g_thread_pool_set_max_threads (pool->threads, n_threads, &error)) {
+    GST_ERROR ("Failed to set %u pool threads, error: '%s'!", n_threads,
+        GST_STR_NULL (error->message));
+    g_clear_error (&error);
+    return FALSE;
+  }
+
+  g_mutex_lock (&pool->lock);
+
+  pool->n_threads = n_threads;
+  pool->max_bytes = max_bytes;
+
+  // Limits may have been raised, wake up the blocked submissions.
+  g_cond_broadcast (&pool->wakeup);
+
+  g_mutex_unlock (&pool->lock);
+
+  GST_DEBUG ("Worker pool limits: %u threads, %" G_GSIZE_FORMAT " bytes",
+      n_threads, max_bytes);
+  return TRUE;
+}
+
+static inline gboolean
+gst_worker_pool_is_full (GstWorkerPool * pool, gsize size)
+{
+  // Always accept a job when the pool is empty, even if it exceeds the budget.
+  if (g_queue_is_empty (&pool->jobs))
+    return FALSE;
+
+  if (g_queue_get_length (&pool->jobs) >= (2 * pool->n_threads))
+    return TRUE;
+
+  return (pool->max_bytes != 0) && ((pool->n_bytes + size) > pool->max_bytes);
+}
+
+gboolean
+gst_worker_pool_submit (GstWorkerPool * pool, gpointer data, gsize size)
+{
+  GstWorkerJob *job = NULL;
+  GError *error = NULL;
+
+  g_return_val_if_fail (pool != NULL, FALSE);
+
+  g_mutex_lock (&pool->lock);
+
+  while (!pool->flushing && gst_worker_pool_is_full (pool, size))
+    g_cond_wait (&pool->wakeup, &pool->lock);
+
+  if (pool->flushing) {
+    g_mutex_unlock (&pool->lock);
+
+    if (pool->destroy != NULL)
+      pool->destroy (data);
+
+    return FALSE;
+  }
+
+  job = g_slice_new0 (GstWorkerJob);
+  job->data = data;
+  job->size = size;
+
+  g_queue_push_tail (&pool->jobs, job);
+  pool->n_bytes += size;
+
+  g_mutex_unlock (&pool->lock);
+
+  if (!g_thread_pool_push (pool->threads, job, &error)) {
+    GST_ERROR ("Failed to push job into thread pool, error: '%s'!",
+        GST_STR_NULL (error->message));
+    g_clear_error (&error);
+
+    // Mark the job as done without output so that it leaves the queue.
+    g_mutex_lock (&pool->lock);
+    job->done = TRUE;
+    g_mutex_unlock (&pool->lock);
+
+    gst_worker_pool_deliver (pool);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+void
+gst_worker_pool_drain (GstWorkerPool * pool)
+{
+  g_return_if_fail (pool != NULL);
+
+  g_mutex_lock (&pool->lock);
+
+  while (!g_queue_is_empty (&pool->jobs))
+    g_cond_wait (&pool->wakeup, &pool->lock);
+
+  g_mutex_unlock (&pool->lock);
+}
+
+void
+gst_worker_pool_set_flushing (GstWorkerPool * pool, gboolean flushing)
+{
+  g_return_if_fail (pool != NULL);
+
+  g_mutex_lock (&pool->lock);
+
+  pool->flushing = flushing;
+  g_cond_broadcast (&pool->wakeup);
+
+  // Wait until the running jobs are finished and the rest are discarded.
+  while (flushing && !g_queue_is_empty (&pool->jobs))
+    g_cond_wait (&pool->wakeup, &pool->lock);
+
+  g_mutex_unlock (&pool->lock);
+}
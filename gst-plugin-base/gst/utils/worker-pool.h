@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GST_WORKER_POOL_H__
+#define __GST_WORKER_POOL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstWorkerPool GstWorkerPool;
+
+/**
+ * GstWorkerPoolProcessFunc:
+ * @job: The job submitted to the pool.
+ * @userdata: The user data passed to gst_worker_pool_new().
+ *
+ * Called from one of the pool threads, different jobs may be processed
+ * concurrently.
+ *
+ * Returns: (transfer full) (nullable): Output buffer or NULL on failure.
+ */
+typedef GstBuffer * (*GstWorkerPoolProcessFunc) (gpointer job,
+                                                 gpointer userdata);
+
+/**
+ * GstWorkerPoolOutputFunc:
+ * @buffer: (transfer full): Output buffer of a processed job.
+ * @userdata: The user data passed to gst_worker_pool_new().
+ *
+ * Called for each output buffer in the order in which the jobs were
+ * submitted. Calls are serialized but can be made from any pool thread,
+ * the pool must not be drained, flushed or freed from within this function.
+ */
+typedef void (*GstWorkerPoolOutputFunc) (GstBuffer * buffer,
+                                         gpointer userdata);
+
+/**
+ * gst_worker_pool_new:
+ * @process: Function processing a job in the pool threads.
+ * @output: Function receiving the output buffers in submission order.
+ * @destroy: (nullable): Function for freeing a job once it is done.
+ * @userdata: User data passed to the functions above.
+ *
+ * Creates a pool of worker threads which process jobs asynchronously but
+ * deliver their results in the order of submission. By default the pool
+ * uses single thread and has no memory budget.
+ *
+ * Returns: Pointer to worker pool on success or NULL on failure.
+ */
+GST_API GstWorkerPool *
+gst_worker_pool_new (GstWorkerPoolProcessFunc process,
+                     GstWorkerPoolOutputFunc output,
+                     GDestroyNotify destroy, gpointer userdata);
+
+/**
+ * gst_worker_pool_free:
+ * @pool: Pointer to worker pool.
+ *
+ * Discards all pending jobs, waits for the running ones and frees the pool.
+ */
+GST_API void
+gst_worker_pool_free (GstWorkerPool * pool);
+
+/**
+ * gst_worker_pool_set_limits:
+ * @pool: Pointer to worker pool.
+ * @n_threads: Maximum number of concurrently processed jobs.
+ * @max_bytes: Memory budget for all jobs in the pool, 0 for no limit.
+ *
+ * Besides the memory budget the number of jobs waiting in the pool is also
+ * limited to twice the number of threads.
+ *
+ * Returns: TRUE on success or FALSE on failure.
+ */
+GST_API gboolean
+gst_worker_pool_set_limits (GstWorkerPool * pool, guint n_threads,
+                            gsize max_bytes);
+
+/**
+ * gst_worker_pool_submit:
+ * @pool: Pointer to worker pool.
+ * @job: (transfer full): The job which is going to be processed.
+ * @size: Memory in bytes accounted for this job until it is done.
+ *
+ * Submit a job for processing, blocks while the pool limits are reached.
+ * A job larger than the whole memory budget is accepted once the pool is
+ * empty. On failure the job is freed with the destroy function.
+ *
+ * Returns: TRUE on success or FALSE if the pool is flushing.
+ */
+GST_API gboolean
+gst_worker_pool_submit (GstWorkerPool * pool, gpointer job, gsize size);
+
+/**
+ * gst_worker_pool_drain:
+ * @pool: Pointer to worker pool.
+ *
+ * Blocks until all submitted jobs are processed and their output delivered.
+ */
+GST_API void
+gst_worker_pool_drain (GstWorkerPool * pool);
+
+/**
+ * gst_worker_pool_set_flushing:
+ * @pool: Pointer to worker pool.
+ * @flushing: Whether the pool is flushing or not.
+ *
+ * When set to flushing, blocked submissions are released, pending jobs are
+ * discarded without being processed and the output of running jobs is
+ * dropped. Blocks until there are no more jobs in the pool.
+ */
+GST_API void
+gst_worker_pool_set_flushing (GstWorkerPool * pool, gboolean flushing);
+
+G_END_DECLS
+
+#endif // __GST_WORKER_POOL_H__
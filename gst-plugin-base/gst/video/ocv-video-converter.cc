@@ -49,9 +49,26 @@
 #define GST_OCV_NEUTRAL_CHROMA      128
 #define GST_OCV_FALLBACK_FORMAT     GST_VIDEO_FORMAT_NV12
 
+// Dimensions of the tiles in which the remap is split between the threads.
+#define GST_OCV_REMAP_TILE_WIDTH    256
+#define GST_OCV_REMAP_TILE_HEIGHT   64
+// Maximum number of cached remap configurations.
+#define GST_OCV_MAX_REMAPS          8
+// Field of view in degrees used if not present in the calibration file.
+#define GST_OCV_DEFAULT_FOV         180.0
+
 #define FORMAT_IS_PACKED(format)    (format == GST_VIDEO_FORMAT_YUY2 || \
     format == GST_VIDEO_FORMAT_UYVY || format == GST_VIDEO_FORMAT_YVYU)
 
+#define FORMAT_IS_REMAPPABLE(format) \
+    (format == GST_VIDEO_FORMAT_NV12 || format == GST_VIDEO_FORMAT_NV21 || \
+     format == GST_VIDEO_FORMAT_NV16 || format == GST_VIDEO_FORMAT_NV61 || \
+     format == GST_VIDEO_FORMAT_I420 || format == GST_VIDEO_FORMAT_YV12 || \
+     format == GST_VIDEO_FORMAT_GRAY8 || format == GST_VIDEO_FORMAT_RGB || \
+     format == GST_VIDEO_FORMAT_BGR || format == GST_VIDEO_FORMAT_RGBA || \
+     format == GST_VIDEO_FORMAT_BGRA || format == GST_VIDEO_FORMAT_RGBx || \
+     format == GST_VIDEO_FORMAT_BGRx)
+
 #define GST_OCV_OBJ_IS_YUV(obj)     (obj && (obj->flags & GST_OCV_FLAG_YUV))
 #define GST_OCV_OBJ_IS_RGB(obj)     (obj && (obj->flags & GST_OCV_FLAG_RGB))
 #define GST_OCV_OBJ_IS_GRAY(obj)    (obj && (obj->flags & GST_OCV_FLAG_GRAY))
@@ -69,6 +86,7 @@
 typedef struct _GstOcvPlane GstOcvPlane;
 typedef struct _GstOcvObject GstOcvObject;
 typedef struct _GstOcvStageBuffer GstOcvStageBuffer;
+typedef struct _GstOcvRemap GstOcvRemap;
 
 // Custom format conversions
 enum {
@@ -144,6 +162,13 @@ typedef enum {
   GST_OCV_FLIP_BOTH
 } GstOpenCVFlip;
 
+typedef enum {
+  GST_OCV_WARP_NONE,
+  GST_OCV_WARP_PERSPECTIVE,
+  GST_OCV_WARP_FISHEYE,
+  GST_OCV_WARP_EQUIRECT,
+} GstOpenCVWarp;
+
 /**
  * GstOcvPlane:
  * @stgid: Index of the used staging buffer or -1 if created from original frame.
@@ -172,6 +197,8 @@ struct _GstOcvPlane
  * @flip: Flip direction or 0 if none.
  * @rotate: Clockwise rotation degrees or 0 if none.
  * @resize: Whether the object needs to be upscaled or downscaled.
+ * @warp: Geometry remap which needs to be applied or 0 if none.
+ * @quad: Source quadrilateral relative to the object, used for perspective.
  * @planes: Array of blit planes.
  * @n_planes: Number of used planes based on format.
  *
@@ -186,6 +213,9 @@ struct _GstOcvObject
   GstVideoConvRotate rotate;
   gboolean           resize;
 
+  GstOpenCVWarp      warp;
+  GstVideoQuadrilateral quad;
+
   GstOcvPlane        planes[GST_VIDEO_MAX_PLANES];
   guint8             n_planes;
 };
@@ -207,6 +237,35 @@ struct _GstOcvStageBuffer
   gboolean used;
 };
 
+/**
+ * GstOcvRemap:
+ * @warp: The geometry remap for which the maps were built.
+ * @quad: Source quadrilateral, used only for perspective remap.
+ * @format: Video format of the source and destination objects.
+ * @s_width: Width of the source object in pixels.
+ * @s_height: Height of the source object in pixels.
+ * @d_width: Width of the destination object in pixels.
+ * @d_height: Height of the destination object in pixels.
+ * @xymaps: Per plane fixed-point integer source coordinates (CV_16SC2).
+ * @amaps: Per plane interpolation table indexes (CV_16UC1).
+ *
+ * Cached coordinate maps for a single remap configuration.
+ */
+struct _GstOcvRemap
+{
+  GstOpenCVWarp         warp;
+  GstVideoQuadrilateral quad;
+  GstVideoFormat        format;
+
+  guint32               s_width;
+  guint32               s_height;
+  guint32               d_width;
+  guint32               d_height;
+
+  cv::Mat               xymaps[GST_VIDEO_MAX_PLANES];
+  cv::Mat               amaps[GST_VIDEO_MAX_PLANES];
+};
+
 struct _GstOcvVideoConverter
 {
   // Global mutex lock.
@@ -214,8 +273,80 @@ struct _GstOcvVideoConverter
 
   // Staging buffers used as intermediaries during the OpenCV operations.
   GArray   *stgbufs;
+
+  // Lens geometry correction applied on each blit.
+  GstOpenCVWarp lenswarp;
+
+  // Lens calibration: camera matrix, fisheye distortion, dimensions and FOV.
+  gdouble  camera[9];
+  gdouble  distortion[4];
+  guint32  calwidth;
+  guint32  calheight;
+  gdouble  fov;
+
+  // List of GstOcvRemap with cached maps, the oldest one is first.
+  GPtrArray *remaps;
 };
 
+GType
+gst_ocv_remap_mode_get_type (void)
+{
+  static GType gtype = 0;
+  static const GEnumValue variants[] = {
+    { GST_OCV_REMAP_MODE_NONE,
+        "No lens geometry correction", "none"
+    },
+    { GST_OCV_REMAP_MODE_FISHEYE,
+        "Undistort fisheye lens into rectilinear image", "fisheye"
+    },
+    { GST_OCV_REMAP_MODE_EQUIRECT,
+        "Unwrap fisheye lens into equirectangular image", "equirect"
+    },
+    {0, NULL, NULL},
+  };
+
+  if (!gtype)
+      gtype = g_enum_register_static ("GstOcvRemapMode", variants);
+
+  return gtype;
+}
+
+static inline gint
+gst_ocv_get_remap_mode (const GstStructure * settings)
+{
+  const GValue *value = NULL;
+  const gchar *string = NULL;
+  GValue newvalue = G_VALUE_INIT;
+  gint mode = GST_OCV_REMAP_MODE_NONE;
+
+  if ((settings == NULL) ||
+      !gst_structure_has_field (settings, GST_VCE_OPT_OCV_REMAP_MODE))
+    return mode;
+
+  value = gst_structure_get_value (settings, GST_VCE_OPT_OCV_REMAP_MODE);
+
+  if (G_VALUE_TYPE (value) == gst_ocv_remap_mode_get_type ())
+    return g_value_get_enum (value);
+
+  // Try to reinitialize the settings value if expected type does not match.
+  string = g_value_get_string (value);
+  g_value_init (&newvalue, gst_ocv_remap_mode_get_type ());
+
+  if (!gst_value_deserialize (&newvalue, string))
+    GST_ERROR ("Failed to decipher remap mode, using default: NONE");
+  else
+    mode = g_value_get_enum (&newvalue);
+
+  g_value_unset (&newvalue);
+  return mode;
+}
+
+static inline void
+gst_ocv_remap_free (gpointer data)
+{
+  delete (GstOcvRemap *) data;
+}
+
 static inline void
 gst_ocv_stage_buffer_free (gpointer data)
 {
@@ -1342,6 +1473,385 @@ gst_ocv_video_converter_resize (GstOcvVideoConverter * convert,
   return TRUE;
 }
 
+static inline void
+gst_ocv_perspective_coords (const GstVideoQuadrilateral * quad,
+    guint32 width, guint32 height, cv::Mat & mapx, cv::Mat & mapy)
+{
+  const gdouble *m = NULL;
+  guint32 x = 0, y = 0;
+
+  // Corners of the destination in the same order as the quadrilateral points.
+  cv::Point2f d_points[4] = {
+      cv::Point2f (0.0, 0.0), cv::Point2f (0.0, height),
+      cv::Point2f (width, 0.0), cv::Point2f (width, height) };
+  cv::Point2f s_points[4] = {
+      cv::Point2f (quad->a.x, quad->a.y), cv::Point2f (quad->b.x, quad->b.y),
+      cv::Point2f (quad->c.x, quad->c.y), cv::Point2f (quad->d.x, quad->d.y) };
+
+  // Inverse homography, maps destination pixels onto the source quadrilateral.
+  cv::Mat matrix = cv::getPerspectiveTransform (d_points, s_points);
+  m = matrix.ptr<gdouble> ();
+
+  mapx.create (height, width, CV_32FC1);
+  mapy.create (height, width, CV_32FC1);
+
+  for (y = 0; y < height; y++) {
+    gfloat *px = mapx.ptr<gfloat> (y), *py = mapy.ptr<gfloat> (y);
+    gdouble v = y + 0.5;
+
+    for (x = 0; x < width; x++) {
+      gdouble u = x + 0.5;
+      gdouble w = m[6] * u + m[7] * v + m[8];
+
+      px[x] = ((m[0] * u + m[1] * v + m[2]) / w) - 0.5;
+      py[x] = ((m[3] * u + m[4] * v + m[5]) / w) - 0.5;
+    }
+  }
+}
+
+static inline cv::Mat
+gst_ocv_scaled_camera (GstOcvVideoConverter * convert, guint32 width,
+    guint32 height)
+{
+  cv::Mat camera = cv::Mat (3, 3, CV_64F, convert->camera).clone ();
+  gdouble *m = camera.ptr<gdouble> ();
+  gdouble w_scale = ((gdouble) width) / convert->calwidth;
+  gdouble h_scale = ((gdouble) height) / convert->calheight;
+
+  // Calibration is done for the full frame, scale it to the given dimensions.
+  m[0] *= w_scale; m[1] *= w_scale; m[2] *= w_scale;
+  m[3] *= h_scale; m[4] *= h_scale; m[5] *= h_scale;
+
+  return camera;
+}
+
+static inline void
+gst_ocv_fisheye_coords (GstOcvVideoConverter * convert, guint32 s_width,
+    guint32 s_height, guint32 d_width, guint32 d_height, cv::Mat & mapx,
+    cv::Mat & mapy)
+{
+  cv::Mat distortion (1, 4, CV_64F, convert->distortion);
+  cv::Mat camera = gst_ocv_scaled_camera (convert, s_width, s_height);
+  cv::Mat newcamera = gst_ocv_scaled_camera (convert, d_width, d_height);
+
+  cv::fisheye::initUndistortRectifyMap (camera, distortion,
+      cv::Mat::eye (3, 3, CV_64F), newcamera, cv::Size (d_width, d_height),
+      CV_32FC1, mapx, mapy);
+}
+
+static inline void
+gst_ocv_equirect_coords (GstOcvVideoConverter * convert, guint32 s_width,
+    guint32 s_height, guint32 d_width, guint32 d_height, cv::Mat & mapx,
+    cv::Mat & mapy)
+{
+  const gdouble *k = convert->distortion, *m = NULL;
+  gdouble hfov = 0.0, vfov = 0.0;
+  guint32 x = 0, y = 0;
+
+  cv::Mat camera = gst_ocv_scaled_camera (convert, s_width, s_height);
+  m = camera.ptr<gdouble> ();
+
+  // Horizontal FOV spans the whole width, vertical one keeps pixels square.
+  hfov = convert->fov * G_PI / 180.0;
+  vfov = hfov * d_height / d_width;
+
+  mapx.create (d_height, d_width, CV_32FC1);
+  mapy.create (d_height, d_width, CV_32FC1);
+
+  for (y = 0; y < d_height; y++) {
+    gfloat *px = mapx.ptr<gfloat> (y), *py = mapy.ptr<gfloat> (y);
+    gdouble latitude = (((y + 0.5) / d_height) - 0.5) * vfov;
+
+    for (x = 0; x < d_width; x++) {
+      gdouble longitude = (((x + 0.5) / d_width) - 0.5) * hfov;
+      gdouble rx = 0.0, ry = 0.0, rz = 0.0, rho = 0.0;
+      gdouble theta = 0.0, theta2 = 0.0, distorted = 0.0;
+
+      // Unit ray for this longitude and latitude in camera coordinates.
+      rx = cos (latitude) * sin (longitude);
+      ry = sin (latitude);
+      rz = cos (latitude) * cos (longitude);
+
+      rho = sqrt (rx * rx + ry * ry);
+      theta = atan2 (rho, rz);
+      theta2 = theta * theta;
+
+      // Equidistant fisheye projection with the Kannala-Brandt distortion.
+      distorted = theta * (1.0 + theta2 * (k[0] + theta2 * (k[1] +
+          theta2 * (k[2] + theta2 * k[3]))));
+
+      if (rho > 0.0) {
+        rx = distorted * rx / rho;
+        ry = distorted * ry / rho;
+      }
+
+      px[x] = m[0] * rx + m[1] * ry + m[2];
+      py[x] = m[4] * ry + m[5];
+    }
+  }
+}
+
+static inline GstOcvRemap *
+gst_ocv_remap_new (GstOcvVideoConverter * convert, const GstOcvObject * s_obj,
+    const GstOcvObject * d_obj)
+{
+  GstOcvRemap *remap = NULL;
+  guint8 idx = 0;
+
+  remap = new GstOcvRemap ();
+
+  remap->warp = s_obj->warp;
+  remap->quad = s_obj->quad;
+  remap->format = s_obj->format;
+  remap->s_width = s_obj->planes[0].width;
+  remap->s_height = s_obj->planes[0].height;
+  remap->d_width = d_obj->planes[0].width;
+  remap->d_height = d_obj->planes[0].height;
+
+  try {
+    cv::Mat mapx, mapy;
+
+    // Calculate the source coordinates for every pixel of the first plane.
+    switch (remap->warp) {
+      case GST_OCV_WARP_PERSPECTIVE:
+        gst_ocv_perspective_coords (&(remap->quad), remap->d_width,
+            remap->d_height, mapx, mapy);
+        break;
+      case GST_OCV_WARP_FISHEYE:
+        gst_ocv_fisheye_coords (convert, remap->s_width, remap->s_height,
+            remap->d_width, remap->d_height, mapx, mapy);
+        break;
+      case GST_OCV_WARP_EQUIRECT:
+        gst_ocv_equirect_coords (convert, remap->s_width, remap->s_height,
+            remap->d_width, remap->d_height, mapx, mapy);
+        break;
+      default:
+        GST_ERROR ("Unknown remap %d!", remap->warp);
+        delete remap;
+        return NULL;
+    }
+
+    // Derive the subsampled planes maps and convert them into fixed-point.
+    for (idx = 0; idx < d_obj->n_planes; idx++) {
+      const GstOcvPlane *s_plane = &s_obj->planes[idx];
+      const GstOcvPlane *d_plane = &d_obj->planes[idx];
+      cv::Mat p_mapx = mapx, p_mapy = mapy, scaled;
+      gdouble w_ratio = 0.0, h_ratio = 0.0;
+
+      // Linear resize samples the full map at the subsampled pixel centres.
+      if ((d_plane->width != remap->d_width) ||
+          (d_plane->height != remap->d_height)) {
+        cv::Size size (d_plane->width, d_plane->height);
+
+        cv::resize (mapx, p_mapx, size, 0, 0, cv::INTER_LINEAR);
+        cv::resize (mapy, p_mapy, size, 0, 0, cv::INTER_LINEAR);
+      }
+
+      w_ratio = ((gdouble) s_plane->width) / remap->s_width;
+      h_ratio = ((gdouble) s_plane->height) / remap->s_height;
+
+      // Scale into a new matrix as the plane map may share the full one.
+      // Coordinates address pixel centres, i.e. (x + 0.5) * ratio - 0.5.
+      if (w_ratio != 1.0) {
+        p_mapx.convertTo (scaled, CV_32FC1, w_ratio, 0.5 * w_ratio - 0.5);
+        p_mapx = scaled;
+        scaled = cv::Mat ();
+      }
+
+      if (h_ratio != 1.0) {
+        p_mapy.convertTo (scaled, CV_32FC1, h_ratio, 0.5 * h_ratio - 0.5);
+        p_mapy = scaled;
+      }
+
+      cv::convertMaps (p_mapx, p_mapy, remap->xymaps[idx], remap->amaps[idx],
+          CV_16SC2, false);
+    }
+  } catch (cv::Exception& e) {
+    GST_ERROR ("Failed to build remap coordinates: %s", e.what ());
+    delete remap;
+    return NULL;
+  }
+
+  GST_DEBUG ("Created remap %d for %s %ux%u -> %ux%u", remap->warp,
+      gst_video_format_to_string (remap->format), remap->s_width,
+      remap->s_height, remap->d_width, remap->d_height);
+
+  return remap;
+}
+
+// The cached remap may be evicted or flushed by another thread as soon as the
+// lock is released. Hand out references to its maps (cv::Mat headers are
+// reference counted) instead of the remap itself.
+static inline gboolean
+gst_ocv_video_converter_fetch_remap (GstOcvVideoConverter * convert,
+    const GstOcvObject * s_obj, const GstOcvObject * d_obj, cv::Mat * xymaps,
+    cv::Mat * amaps)
+{
+  GstOcvRemap *remap = NULL;
+  guint idx = 0;
+  gboolean found = FALSE;
+
+  GST_OCV_LOCK (convert);
+
+  for (idx = 0; idx < convert->remaps->len; idx++) {
+    remap = (GstOcvRemap *) g_ptr_array_index (convert->remaps, idx);
+
+    if ((remap->warp == s_obj->warp) && (remap->format == s_obj->format) &&
+        (remap->s_width == s_obj->planes[0].width) &&
+        (remap->s_height == s_obj->planes[0].height) &&
+        (remap->d_width == d_obj->planes[0].width) &&
+        (remap->d_height == d_obj->planes[0].height) &&
+        ((remap->warp != GST_OCV_WARP_PERSPECTIVE) ||
+            (memcmp (&(remap->quad), &(s_obj->quad),
+                sizeof (GstVideoQuadrilateral)) == 0))) {
+      found = TRUE;
+      break;
+    }
+  }
+
+  if (!found && (remap = gst_ocv_remap_new (convert, s_obj, d_obj)) != NULL) {
+    // Drop the oldest configuration, maps are rebuilt if it is needed again.
+    if (convert->remaps->len >= GST_OCV_MAX_REMAPS)
+      g_ptr_array_remove_index (convert->remaps, 0);
+
+    g_ptr_array_add (convert->remaps, remap);
+    found = TRUE;
+  }
+
+  for (idx = 0; found && (idx < GST_VIDEO_MAX_PLANES); idx++) {
+    xymaps[idx] = remap->xymaps[idx];
+    amaps[idx] = remap->amaps[idx];
+  }
+
+  GST_OCV_UNLOCK (convert);
+  return found;
+}
+
+static inline void
+gst_ocv_remap_plane (const cv::Mat & src, cv::Mat & dst, const cv::Mat & xymap,
+    const cv::Mat & amap, const cv::Scalar & border)
+{
+  gint n_columns = 0, n_rows = 0;
+
+  n_columns = (dst.cols + GST_OCV_REMAP_TILE_WIDTH - 1) / GST_OCV_REMAP_TILE_WIDTH;
+  n_rows = (dst.rows + GST_OCV_REMAP_TILE_HEIGHT - 1) / GST_OCV_REMAP_TILE_HEIGHT;
+
+  // Split the destination in tiles and distribute them between the threads.
+  cv::parallel_for_ (cv::Range (0, n_columns * n_rows),
+      [&] (const cv::Range & range) {
+        for (gint num = range.start; num < range.end; num++) {
+          cv::Rect tile ((num % n_columns) * GST_OCV_REMAP_TILE_WIDTH,
+              (num / n_columns) * GST_OCV_REMAP_TILE_HEIGHT,
+              GST_OCV_REMAP_TILE_WIDTH, GST_OCV_REMAP_TILE_HEIGHT);
+
+          tile &= cv::Rect (0, 0, dst.cols, dst.rows);
+
+          cv::Mat d_tile = dst (tile);
+          cv::remap (src, d_tile, xymap (tile), amap (tile), cv::INTER_LINEAR,
+              cv::BORDER_CONSTANT, border);
+        }
+      });
+}
+
+static inline gboolean
+gst_ocv_video_converter_remap (GstOcvVideoConverter * convert,
+    GstOcvObject * s_obj, GstOcvObject * d_obj)
+{
+  GstOcvObject l_obj = {};
+  cv::Mat xymaps[GST_VIDEO_MAX_PLANES], amaps[GST_VIDEO_MAX_PLANES];
+  GstOpenCVFlip flip = GST_OCV_FLIP_NONE;
+  GstVideoConvRotate rotate = GST_VCE_ROTATE_0;
+  guint8 idx = 0;
+
+  GST_TRACE ("Performing remap");
+
+  if (!FORMAT_IS_REMAPPABLE (s_obj->format)) {
+    GST_WARNING ("Remap is not supported for %s format!",
+        gst_video_format_to_string (s_obj->format));
+    return FALSE;
+  }
+
+  // Cache the flip and rotation flags.
+  flip = s_obj->flip;
+  rotate = s_obj->rotate;
+
+  // Use stage object if other operations are pending
+  if ((flip != GST_OCV_FLIP_NONE) || (rotate != GST_VCE_ROTATE_0) ||
+      (s_obj->format != d_obj->format)) {
+    guint width = 0, height = 0;
+    gboolean success = FALSE;
+
+    width = d_obj->planes[0].width;
+    height = d_obj->planes[0].height;
+
+    // Dimensions are swapped if 90/270 degree rotation is required.
+    if (rotate == GST_VCE_ROTATE_90 || rotate == GST_VCE_ROTATE_270) {
+      width = d_obj->planes[0].height;
+      height = d_obj->planes[0].width;
+    }
+
+    // Temporary store the destination object data into local intermediary.
+    gst_ocv_copy_object (d_obj, &l_obj);
+
+    // Override destination object with stage object data, revert it later.
+    success = gst_ocv_video_converter_stage_object_init (convert, d_obj,
+        width, height, s_obj->format);
+    g_return_val_if_fail (success, FALSE);
+  }
+
+  if (!gst_ocv_video_converter_fetch_remap (convert, s_obj, d_obj, xymaps,
+          amaps)) {
+    GST_ERROR ("Failed to fetch remap maps!");
+
+    if (d_obj->flags & GST_OCV_FLAG_STAGED) {
+      gst_ocv_video_converter_stage_object_deinit (convert, d_obj);
+      gst_ocv_copy_object (&l_obj, d_obj);
+    }
+    return FALSE;
+  }
+
+  for (idx = 0; idx < s_obj->n_planes; idx++) {
+    GstOcvPlane *s_plane = &s_obj->planes[idx], *d_plane = &d_obj->planes[idx];
+    cv::Scalar border = cv::Scalar::all (0);
+
+    cv::Mat src_mat (s_plane->height, s_plane->width, s_plane->type,
+        s_plane->data, s_plane->stride);
+
+    cv::Mat dst_mat (d_plane->height, d_plane->width, d_plane->type,
+        d_plane->data, d_plane->stride);
+
+    // Pixels outside of the source are filled with black.
+    if (GST_OCV_OBJ_IS_YUV (s_obj) && (idx != 0))
+      border = cv::Scalar::all (GST_OCV_NEUTRAL_CHROMA);
+
+    gst_ocv_remap_plane (src_mat, dst_mat, xymaps[idx], amaps[idx], border);
+
+    GST_LOG ("Remapped plane No. %u - Src dims: %d (width) x %d (height) @ %d "
+        "(stride); Dst dims: %d (width) x %d (height) @ %d (stride)", idx,
+        s_plane->width, s_plane->height, s_plane->stride,
+        d_plane->width, d_plane->height, d_plane->stride);
+  }
+
+  // If source is a stage object from previous operation, release stage buffers.
+  if (s_obj->flags & GST_OCV_FLAG_STAGED)
+    gst_ocv_video_converter_stage_object_deinit (convert, s_obj);
+
+  // Set the destination/stage object as source for the next operation.
+  gst_ocv_copy_object (d_obj, s_obj);
+
+  // Transfer any pending rotate and flip, remap also took care of the resize.
+  s_obj->flip = flip;
+  s_obj->rotate = rotate;
+  s_obj->resize = FALSE;
+  s_obj->warp = GST_OCV_WARP_NONE;
+
+  // Restore the original destination object in case a stage was used.
+  if (d_obj->flags & GST_OCV_FLAG_STAGED)
+    gst_ocv_copy_object (&l_obj, d_obj);
+
+  return TRUE;
+}
+
 static inline void
 gst_ocv_video_converter_copy_plane (const GstOcvPlane * s_plane,
     const GstOcvPlane * d_plane)
@@ -2150,7 +2660,8 @@ gst_ocv_video_converter_prepare_frame (GstOcvVideoConverter * convert,
 
   // Use stage object if other operations are pending
   if (d_obj->format != GST_OCV_FALLBACK_FORMAT || resize ||
-      (rotate != GST_VCE_ROTATE_0) || (flip != GST_OCV_FLIP_NONE)) {
+      (rotate != GST_VCE_ROTATE_0) || (flip != GST_OCV_FLIP_NONE) ||
+      (s_obj->warp != GST_OCV_WARP_NONE)) {
     gboolean success = FALSE;
 
     // Temporary store the destination object data into local intermediary.
@@ -2406,6 +2917,7 @@ gst_ocv_video_converter_process (GstOcvVideoConverter * convert,
     // destination format doesn't exist
     normalize = FORMAT_IS_PACKED (s_obj->format) &&
         ((flip || rotate || upscale || downscale) ||
+        (s_obj->warp != GST_OCV_WARP_NONE) ||
         (gst_ocv_get_conversion_mode (s_obj, d_obj) == GST_OCV_INVALID_CONVERSION));
 
     if (normalize && !gst_ocv_video_converter_prepare_frame (convert, s_obj, d_obj))  {
@@ -2413,6 +2925,20 @@ gst_ocv_video_converter_process (GstOcvVideoConverter * convert,
       return FALSE;
     }
 
+    // Apply geometry remap first, it also performs any required scaling.
+    if (s_obj->warp != GST_OCV_WARP_NONE) {
+      if (!gst_ocv_video_converter_remap (convert, s_obj, d_obj)) {
+        GST_ERROR ("Failed to remap image!");
+        return FALSE;
+      }
+
+      // Remap was done directly into the destination, nothing else to do.
+      if (!(s_obj->flags & GST_OCV_FLAG_STAGED))
+        continue;
+
+      downscale = upscale = FALSE;
+    }
+
     cvt_color = s_obj->format != d_obj->format;
 
     GST_LOG ("Starting processing of object pair %u; flip is: %d, rotate: %d, "
@@ -2527,16 +3053,42 @@ gst_ocv_video_converter_compose (GstOcvVideoConverter * convert,
       // Intialization of the source OCV object.
       object = &(objects[n_objects]);
 
-      if (blit->mask & GST_VCE_MASK_SOURCE) {
-        if (!gst_video_quadrilateral_is_rectangle (&(blit->source))) {
-          GST_ERROR ("Composition %u: Blit %u: Source quadrilateral is not a "
-              "rectangle! A(%f, %f) B(%f, %f) C(%fd, %f) D(%f, %f)", idx, num,
-              blit->source.a.x, blit->source.a.y, blit->source.b.x,
-              blit->source.b.y, blit->source.c.x, blit->source.c.y,
-              blit->source.d.x, blit->source.d.y);
-          return FALSE;
-        }
-
+      // Intialization of the source geometry remap.
+      object->warp = convert->lenswarp;
+
+      if ((blit->mask & GST_VCE_MASK_SOURCE) &&
+          !gst_video_quadrilateral_is_rectangle (&(blit->source))) {
+        GstVideoQuadrilateral *quad = &(blit->source);
+        gfloat x = 0.0, y = 0.0;
+
+        GST_TRACE ("Composition %u: Blit %u: Perspective remap of source "
+            "quadrilateral A(%f, %f) B(%f, %f) C(%f, %f) D(%f, %f)", idx, num,
+            quad->a.x, quad->a.y, quad->b.x, quad->b.y, quad->c.x, quad->c.y,
+            quad->d.x, quad->d.y);
+
+        // Use the bounding box of the quadrilateral as source region.
+        x = MIN (MIN (quad->a.x, quad->b.x), MIN (quad->c.x, quad->d.x));
+        y = MIN (MIN (quad->a.y, quad->b.y), MIN (quad->c.y, quad->d.y));
+
+        rectangle.x = MAX (floorf (x), 0);
+        rectangle.y = MAX (floorf (y), 0);
+        rectangle.w = ceilf (MAX (MAX (quad->a.x, quad->b.x),
+            MAX (quad->c.x, quad->d.x))) - rectangle.x;
+        rectangle.h = ceilf (MAX (MAX (quad->a.y, quad->b.y),
+            MAX (quad->c.y, quad->d.y))) - rectangle.y;
+
+        // Quadrilateral points relative to the source region.
+        object->quad.a.x = quad->a.x - rectangle.x;
+        object->quad.a.y = quad->a.y - rectangle.y;
+        object->quad.b.x = quad->b.x - rectangle.x;
+        object->quad.b.y = quad->b.y - rectangle.y;
+        object->quad.c.x = quad->c.x - rectangle.x;
+        object->quad.c.y = quad->c.y - rectangle.y;
+        object->quad.d.x = quad->d.x - rectangle.x;
+        object->quad.d.y = quad->d.y - rectangle.y;
+
+        object->warp = GST_OCV_WARP_PERSPECTIVE;
+      } else if (blit->mask & GST_VCE_MASK_SOURCE) {
         rectangle.x = blit->source.a.x;
         rectangle.y = blit->source.a.y;
         rectangle.w = blit->source.d.x - blit->source.a.x;
@@ -2620,7 +3172,60 @@ gst_ocv_video_converter_wait_fence (GstOcvVideoConverter * convert,
 void
 gst_ocv_video_converter_flush (GstOcvVideoConverter * convert)
 {
-  GST_WARNING ("Not implemented!");
+  GST_OCV_LOCK (convert);
+
+  // Drop the cached remap coordinates, they will be rebuilt on demand.
+  g_ptr_array_set_size (convert->remaps, 0);
+
+  GST_OCV_UNLOCK (convert);
+}
+
+static inline gboolean
+gst_ocv_video_converter_load_calibration (GstOcvVideoConverter * convert,
+    const gchar * filename)
+{
+  cv::Mat camera, distortion;
+  gint width = 0, height = 0;
+  gdouble fov = GST_OCV_DEFAULT_FOV;
+
+  try {
+    cv::FileStorage storage (filename, cv::FileStorage::READ);
+
+    if (!storage.isOpened ()) {
+      GST_ERROR ("Failed to open calibration file '%s'!", filename);
+      return FALSE;
+    }
+
+    storage["camera_matrix"] >> camera;
+    storage["distortion_coefficients"] >> distortion;
+    storage["image_width"] >> width;
+    storage["image_height"] >> height;
+
+    if (!storage["fov"].empty ())
+      storage["fov"] >> fov;
+  } catch (cv::Exception& e) {
+    GST_ERROR ("Failed to parse calibration file '%s': %s", filename, e.what ());
+    return FALSE;
+  }
+
+  if ((camera.rows != 3) || (camera.cols != 3) || (distortion.total () != 4) ||
+      (width <= 0) || (height <= 0) || (fov <= 0.0)) {
+    GST_ERROR ("Invalid calibration in '%s', expecting 3x3 camera matrix, 4 "
+        "distortion coefficients and image dimensions!", filename);
+    return FALSE;
+  }
+
+  camera.convertTo (cv::Mat (3, 3, CV_64F, convert->camera), CV_64F);
+  distortion.reshape (1, 1).convertTo (
+      cv::Mat (1, 4, CV_64F, convert->distortion), CV_64F);
+
+  convert->calwidth = width;
+  convert->calheight = height;
+  convert->fov = fov;
+
+  GST_INFO ("Loaded calibration %dx%d FOV %.1f from '%s'", width, height,
+      fov, filename);
+  return TRUE;
 }
 
 GstOcvVideoConverter *
@@ -2647,6 +3252,33 @@ gst_ocv_video_converter_new (GstStructure * settings)
   // Set clearing function for the allocated stage memory.
   g_array_set_clear_func (convert->stgbufs, gst_ocv_stage_buffer_free);
 
+  convert->remaps = g_ptr_array_new_with_free_func (gst_ocv_remap_free);
+
+  switch (gst_ocv_get_remap_mode (settings)) {
+    case GST_OCV_REMAP_MODE_FISHEYE:
+      convert->lenswarp = GST_OCV_WARP_FISHEYE;
+      break;
+    case GST_OCV_REMAP_MODE_EQUIRECT:
+      convert->lenswarp = GST_OCV_WARP_EQUIRECT;
+      break;
+    default:
+      convert->lenswarp = GST_OCV_WARP_NONE;
+      break;
+  }
+
+  if (convert->lenswarp != GST_OCV_WARP_NONE) {
+    const gchar *filename = gst_structure_get_string (settings,
+        GST_VCE_OPT_OCV_CALIBRATION);
+
+    if (filename == NULL) {
+      GST_ERROR ("Remap mode requires '%s' option!", GST_VCE_OPT_OCV_CALIBRATION);
+      goto cleanup;
+    }
+
+    if (!gst_ocv_video_converter_load_calibration (convert, filename))
+      goto cleanup;
+  }
+
   GST_INFO ("Created OpenCV Converter %p", convert);
   return convert;
 
@@ -2664,6 +3296,9 @@ gst_ocv_video_converter_free (GstOcvVideoConverter * convert)
   if (convert->stgbufs != NULL)
     g_array_free (convert->stgbufs, TRUE);
 
+  if (convert->remaps != NULL)
+    g_ptr_array_free (convert->remaps, TRUE);
+
   g_mutex_clear (&convert->lock);
 
   GST_INFO ("Destroyed OpenCV converter: %p", convert);
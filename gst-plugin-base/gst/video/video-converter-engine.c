@@ -33,6 +33,44 @@ GST_DEBUG_CATEGORY (gst_video_converter_engine_debug);
 #define UINT64_CONVERSION_SCALE  (G_MAXUINT64 / G_MAXUINT8)
 #define FLOAT_CONVERSION_SCALE   (1.0 / G_MAXUINT8)
 
+// Maximum number of published outputs referenced by a single engine.
+// Limits the buffers held back from the pool of the publishing element.
+#define GST_VCE_MAX_PUBLISHED    2
+
+// Lock protecting the published entries attached to input buffers.
+static GRecMutex cachelock;
+
+static G_DEFINE_QUARK (VideoConvEngineCacheQuark, gst_video_converter_cache);
+
+typedef struct _GstVideoConvCacheEntry GstVideoConvCacheEntry;
+
+/**
+ * GstVideoConvCacheEntry:
+ * @refcount: References from the input buffer and the publishing engine.
+ * @pts: Presentation timestamp of the input buffer at publish time.
+ * @dts: Decoding timestamp of the input buffer at publish time.
+ * @offset: Offset of the input buffer at publish time.
+ * @blit: Blit parameters, buffer and info fields are not used.
+ * @composition: Composition parameters, pointer fields are not used.
+ * @info: Output video info of the composition.
+ * @output: Output buffer of the composition, NULL once retracted.
+ *
+ * Result of a finished composition, attached as qdata to its input buffer.
+ */
+struct _GstVideoConvCacheEntry {
+  guint               refcount;
+
+  GstClockTime        pts;
+  GstClockTime        dts;
+  guint64             offset;
+
+  GstVideoBlit        blit;
+  GstVideoComposition composition;
+  GstVideoInfo        info;
+
+  GstBuffer           *output;
+};
+
 /**
  * GstVideoConvNewFunction:
  * @settings: Structure with backend specific settings.
@@ -91,6 +129,7 @@ typedef void (*GstVideoConvFlushFunction) (gpointer converter);
  * @compose: Pointer to the compose function of the underlying converter.
  * @wait_fence: Pointer to the wait_fence function of the underlying converter.
  * @flush: Pointer to the flush function of the underlying converter.
+ * @published: Entries published by this engine, oldest first.
  *
  * Base class for video converter engine.
  */
@@ -105,6 +144,8 @@ struct _GstVideoConvEngine {
   GstVideoConvComposeFunction   compose;
   GstVideoConvWaitFenceFunction wait_fence;
   GstVideoConvFlushFunction     flush;
+
+  GQueue                        *published;
 };
 
 G_DEFINE_TYPE (GstVideoConvEngine, gst_video_converter_engine, G_TYPE_OBJECT)
@@ -127,6 +168,107 @@ gst_video_converter_engine_init (GstVideoConvEngine * engine)
   engine->compose = NULL;
   engine->wait_fence = NULL;
   engine->flush = NULL;
+
+  engine->published = g_queue_new ();
+}
+
+static void
+gst_video_conv_cache_entry_unref (GstVideoConvCacheEntry * entry)
+{
+  if (--entry->refcount != 0)
+    return;
+
+  if (entry->output != NULL)
+    gst_buffer_unref (entry->output);
+
+  g_slice_free (GstVideoConvCacheEntry, entry);
+}
+
+static void
+gst_video_conv_cache_release (GPtrArray * entries)
+{
+  g_rec_mutex_lock (&cachelock);
+  g_ptr_array_unref (entries);
+  g_rec_mutex_unlock (&cachelock);
+}
+
+static gboolean
+gst_video_conv_cache_entry_is_valid (const GstVideoConvCacheEntry * entry,
+    const GstBuffer * buffer)
+{
+  // Pooled input buffers keep their qdata when they are reused for new frames.
+  return (entry->output != NULL) && (entry->pts == GST_BUFFER_PTS (buffer)) &&
+      (entry->dts == GST_BUFFER_DTS (buffer)) &&
+      (entry->offset == GST_BUFFER_OFFSET (buffer));
+}
+
+static gboolean
+gst_video_conv_cache_entry_matches (const GstVideoConvCacheEntry * entry,
+    const GstVideoComposition * composition)
+{
+  const GstVideoBlit *blit = &(composition->blits[0]);
+  const GstVideoInfo *info = composition->info;
+  guint idx = 0;
+
+  if ((entry->blit.mask != blit->mask) || (entry->blit.alpha != blit->alpha) ||
+      (entry->blit.rotate != blit->rotate))
+    return FALSE;
+
+  if ((blit->mask & GST_VCE_MASK_SOURCE) &&
+      (memcmp (&(entry->blit.source), &(blit->source),
+          sizeof (GstVideoQuadrilateral)) != 0))
+    return FALSE;
+
+  if ((blit->mask & GST_VCE_MASK_DESTINATION) &&
+      (memcmp (&(entry->blit.destination), &(blit->destination),
+          sizeof (GstVideoRectangle)) != 0))
+    return FALSE;
+
+  if ((GST_VIDEO_INFO_FORMAT (&entry->info) != GST_VIDEO_INFO_FORMAT (info)) ||
+      (GST_VIDEO_INFO_WIDTH (&entry->info) != GST_VIDEO_INFO_WIDTH (info)) ||
+      (GST_VIDEO_INFO_HEIGHT (&entry->info) != GST_VIDEO_INFO_HEIGHT (info)) ||
+      (GST_VIDEO_INFO_SIZE (&entry->info) != GST_VIDEO_INFO_SIZE (info)))
+    return FALSE;
+
+  for (idx = 0; idx < GST_VIDEO_INFO_N_PLANES (info); idx++) {
+    if ((GST_VIDEO_INFO_PLANE_STRIDE (&entry->info, idx) !=
+            GST_VIDEO_INFO_PLANE_STRIDE (info, idx)) ||
+        (GST_VIDEO_INFO_PLANE_OFFSET (&entry->info, idx) !=
+            GST_VIDEO_INFO_PLANE_OFFSET (info, idx)))
+      return FALSE;
+  }
+
+  if ((entry->composition.bgfill != composition->bgfill) ||
+      (composition->bgfill &&
+          (entry->composition.bgcolor != composition->bgcolor)) ||
+      (entry->composition.datatype != composition->datatype))
+    return FALSE;
+
+  for (idx = 0; idx < GST_VCE_MAX_CHANNELS; idx++) {
+    if ((entry->composition.offsets[idx] != composition->offsets[idx]) ||
+        (entry->composition.scales[idx] != composition->scales[idx]))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gst_video_converter_engine_retract (GstVideoConvEngine * engine, guint n_keep)
+{
+  GstVideoConvCacheEntry *entry = NULL;
+
+  g_rec_mutex_lock (&cachelock);
+
+  while (g_queue_get_length (engine->published) > n_keep) {
+    entry = g_queue_pop_head (engine->published);
+
+    // Entry stays attached to its input buffer until it is pruned or released.
+    gst_clear_buffer (&(entry->output));
+    gst_video_conv_cache_entry_unref (entry);
+  }
+
+  g_rec_mutex_unlock (&cachelock);
 }
 
 static inline gboolean
@@ -411,6 +553,9 @@ gst_video_converter_engine_free (GstVideoConvEngine * engine)
   if (engine == NULL)
     return;
 
+  gst_video_converter_engine_retract (engine, 0);
+  g_queue_free (engine->published);
+
   engine->free (engine->converter);
   g_object_unref (engine);
 }
@@ -443,4 +588,122 @@ gst_video_converter_engine_flush (GstVideoConvEngine * engine)
   g_return_if_fail (engine != NULL);
 
   engine->flush (engine->converter);
+  gst_video_converter_engine_retract (engine, 0);
+}
+
+GstBuffer *
+gst_video_converter_engine_lookup (GstVideoConvEngine * engine,
+    const GstVideoComposition * composition)
+{
+  GstVideoConvCacheEntry *entry = NULL;
+  GPtrArray *entries = NULL;
+  GstBuffer *inbuffer = NULL, *outbuffer = NULL;
+  guint idx = 0;
+
+  g_return_val_if_fail (engine != NULL, NULL);
+  g_return_val_if_fail (composition != NULL, NULL);
+
+  if (composition->n_blits != 1)
+    return NULL;
+
+  inbuffer = composition->blits[0].buffer;
+
+  if ((inbuffer == NULL) || !GST_BUFFER_PTS_IS_VALID (inbuffer))
+    return NULL;
+
+  g_rec_mutex_lock (&cachelock);
+
+  entries = gst_mini_object_get_qdata (GST_MINI_OBJECT (inbuffer),
+      gst_video_converter_cache_quark ());
+
+  for (idx = 0; (entries != NULL) && (idx < entries->len); idx++) {
+    entry = g_ptr_array_index (entries, idx);
+
+    if (gst_video_conv_cache_entry_is_valid (entry, inbuffer) &&
+        gst_video_conv_cache_entry_matches (entry, composition)) {
+      outbuffer = gst_buffer_ref (entry->output);
+      break;
+    }
+  }
+
+  g_rec_mutex_unlock (&cachelock);
+
+  if (outbuffer != NULL)
+    GST_LOG ("Reusing %" GST_PTR_FORMAT " for %" GST_PTR_FORMAT, outbuffer,
+        inbuffer);
+
+  return outbuffer;
+}
+
+void
+gst_video_converter_engine_publish (GstVideoConvEngine * engine,
+    const GstVideoComposition * composition)
+{
+  GstVideoConvCacheEntry *entry = NULL;
+  GPtrArray *entries = NULL;
+  GstBuffer *inbuffer = NULL;
+  guint idx = 0;
+
+  g_return_if_fail (engine != NULL);
+  g_return_if_fail (composition != NULL);
+
+  if ((composition->n_blits != 1) || (composition->buffer == NULL))
+    return;
+
+  inbuffer = composition->blits[0].buffer;
+
+  // Timestamps are part of the signature used to detect reused input buffers.
+  if ((inbuffer == NULL) || !GST_BUFFER_PTS_IS_VALID (inbuffer))
+    return;
+
+  g_rec_mutex_lock (&cachelock);
+
+  entries = gst_mini_object_get_qdata (GST_MINI_OBJECT (inbuffer),
+      gst_video_converter_cache_quark ());
+
+  if (entries == NULL) {
+    entries = g_ptr_array_new_with_free_func (
+        (GDestroyNotify) gst_video_conv_cache_entry_unref);
+    gst_mini_object_set_qdata (GST_MINI_OBJECT (inbuffer),
+        gst_video_converter_cache_quark (), entries,
+        (GDestroyNotify) gst_video_conv_cache_release);
+  }
+
+  // Prune retracted entries and those from previous uses of the input buffer.
+  for (idx = entries->len; idx > 0; idx--) {
+    entry = g_ptr_array_index (entries, idx - 1);
+
+    if (!gst_video_conv_cache_entry_is_valid (entry, inbuffer))
+      g_ptr_array_remove_index_fast (entries, idx - 1);
+  }
+
+  entry = g_slice_new0 (GstVideoConvCacheEntry);
+  entry->refcount = 2;
+
+  entry->pts = GST_BUFFER_PTS (inbuffer);
+  entry->dts = GST_BUFFER_DTS (inbuffer);
+  entry->offset = GST_BUFFER_OFFSET (inbuffer);
+
+  entry->blit = composition->blits[0];
+  entry->blit.buffer = NULL;
+  entry->blit.info = NULL;
+
+  entry->composition = *composition;
+  entry->composition.blits = NULL;
+  entry->composition.buffer = NULL;
+  entry->composition.info = NULL;
+
+  entry->info = *(composition->info);
+  entry->output = gst_buffer_ref (composition->buffer);
+
+  g_ptr_array_add (entries, entry);
+  g_queue_push_tail (engine->published, entry);
+
+  g_rec_mutex_unlock (&cachelock);
+
+  GST_LOG ("Published %" GST_PTR_FORMAT " for %" GST_PTR_FORMAT,
+      composition->buffer, inbuffer);
+
+  // Release the oldest outputs so that the producer pool is not exhausted.
+  gst_video_converter_engine_retract (engine, GST_VCE_MAX_PUBLISHED);
 }
@@ -51,6 +51,25 @@ GST_DEBUG_CATEGORY_EXTERN (gst_video_converter_engine_debug);
  */
 #define GST_VCE_OPT_FCV_OP_MODE "fcv-op-mode"
 
+/**
+ * GST_VCE_OPT_OCV_REMAP_MODE:
+ *
+ * #GstOcvRemapMode, set the lens geometry correction applied by the OpenCV
+ * converter on every blit. Requires #GST_VCE_OPT_OCV_CALIBRATION.
+ * Default: #GST_OCV_REMAP_MODE_NONE.
+ */
+#define GST_VCE_OPT_OCV_REMAP_MODE "ocv-remap-mode"
+
+/**
+ * GST_VCE_OPT_OCV_CALIBRATION:
+ *
+ * #G_TYPE_STRING, path to an OpenCV YAML/XML file with the lens calibration
+ * ('camera_matrix', 'distortion_coefficients', 'image_width', 'image_height'
+ * and optional 'fov' in degrees) used by the OpenCV remap modes.
+ * Default: NULL.
+ */
+#define GST_VCE_OPT_OCV_CALIBRATION "ocv-calibration"
+
 typedef struct _GstVideoConvEngine GstVideoConvEngine;
 typedef struct _GstVideoQuadrilateral GstVideoQuadrilateral;
 typedef struct _GstVideoBlit GstVideoBlit;
@@ -79,6 +98,24 @@ typedef enum {
 GST_API GType gst_fcv_op_mode_get_type (void);
 #define GST_TYPE_FCV_OP_MODE (gst_fcv_op_mode_get_type())
 
+/**
+ * GstOcvRemapMode:
+ * @GST_OCV_REMAP_MODE_NONE: No lens geometry correction.
+ * @GST_OCV_REMAP_MODE_FISHEYE: Undistort fisheye lens into rectilinear image.
+ * @GST_OCV_REMAP_MODE_EQUIRECT: Unwrap fisheye lens into equirectangular image.
+ *
+ * Defines the lens geometry correction of the underlying OpenCV based engine.
+ * Non-rectangular source quadrilaterals are always perspective corrected.
+ */
+typedef enum {
+  GST_OCV_REMAP_MODE_NONE,
+  GST_OCV_REMAP_MODE_FISHEYE,
+  GST_OCV_REMAP_MODE_EQUIRECT,
+} GstOcvRemapMode;
+
+GST_API GType gst_ocv_remap_mode_get_type (void);
+#define GST_TYPE_OCV_REMAP_MODE (gst_ocv_remap_mode_get_type())
+
 /**
  * GstVideoConvBackend:
  * @GST_VCE_BACKEND_NONE: Do not use any backend
@@ -312,10 +349,45 @@ gst_video_converter_engine_wait_fence (GstVideoConvEngine * engine,
  * @engine: Pointer to video converter engine.
  *
  * Wait for compositions sumbitted to the engine to finish and flush cached data.
+ * Output buffers published by the engine are no longer available for lookups.
  */
 GST_VIDEO_API void
 gst_video_converter_engine_flush (GstVideoConvEngine * engine);
 
+/**
+ * gst_video_converter_engine_lookup:
+ * @engine: Pointer to video converter engine.
+ * @composition: Composition which is about to be submitted to the engine.
+ *
+ * Look for the result of an identical composition which was already executed
+ * and published by any engine instance, e.g. in parallel branches processing
+ * the same input frame. Only compositions with a single blit are considered.
+ *
+ * The returned buffer is shared with other consumers and must be made
+ * writable before its metadata can be modified.
+ *
+ * Returns: (transfer full): Output buffer of the matching composition or NULL
+ */
+GST_VIDEO_API GstBuffer *
+gst_video_converter_engine_lookup (GstVideoConvEngine * engine,
+                                   const GstVideoComposition * composition);
+
+/**
+ * gst_video_converter_engine_publish:
+ * @engine: Pointer to video converter engine.
+ * @composition: Finished composition.
+ *
+ * Make the output buffer of a finished composition available for lookups
+ * until the input buffer is released or reused. The engine holds references
+ * only to the output buffers of its few most recent publications.
+ *
+ * Must be called only after the composition has finished, i.e. after the
+ * associated fence was waited on.
+ */
+GST_VIDEO_API void
+gst_video_converter_engine_publish (GstVideoConvEngine * engine,
+                                    const GstVideoComposition * composition);
+
 G_END_DECLS
 
 #endif // __GST_VIDEO_CONVERTER_ENGINE_H__
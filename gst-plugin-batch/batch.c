@@ -16,6 +16,7 @@
 #include <gst/audio/audio.h>
 #include <gst/utils/common-utils.h>
 #include <gst/utils/batch-utils.h>
+#include <gst/utils/gstmuxstreamsmeta.h>
 
 #include "batchpads.h"
 
@@ -27,6 +28,11 @@ GST_DEBUG_CATEGORY (gst_batch_debug);
 G_DEFINE_TYPE (GstBatch, gst_batch, GST_TYPE_ELEMENT);
 
 #define DEFAULT_PROP_MOVING_WINDOW_SIZE 1
+#define DEFAULT_PROP_MIN_FILL           0
+#define DEFAULT_PROP_DEADLINE           0
+
+// Number of streams which can be described by the channels mask in the offset.
+#define GST_BATCH_MAX_OFFSET_STREAMS    32
 
 #define GST_BATCH_SINK_CAPS \
     "video/x-raw(ANY); "    \
@@ -40,6 +46,8 @@ enum
 {
   PROP_0,
   PROP_MOVING_WINDOW_SIZE,
+  PROP_MIN_FILL,
+  PROP_DEADLINE,
 };
 
 static GstStaticPadTemplate gst_batch_sink_template =
@@ -175,26 +183,44 @@ gst_batch_all_sink_pads_eos (GstBatch * batch, GstPad * pad)
   return eos;
 }
 
+static gint
+gst_batch_sink_pads_compare (gconstpointer a, gconstpointer b)
+{
+  const GstBatchSinkPad *lpad = a, *rpad = b;
+
+  return (lpad->index > rpad->index) - (lpad->index < rpad->index);
+}
+
 static gboolean
-gst_batch_sink_buffers_available (GstBatch * batch)
+gst_batch_sink_buffers_available (GstBatch * batch, guint * n_ready)
 {
   GList *list = NULL;
-  gboolean available = TRUE, idle = TRUE;
+  guint n_active = 0, n_required = 0;
+
+  *n_ready = 0;
 
   for (list = batch->sinkpads; list != NULL; list = g_list_next (list)) {
     GstBatchSinkPad *sinkpad = GST_BATCH_SINK_PAD (list->data);
 
-    idle &= sinkpad->is_idle;
-
     // Pads which are in EOS or FLUSHING state are not included in the checks.
     if (sinkpad->is_idle)
       continue;
 
-    available &= (g_queue_get_length (sinkpad->buffers) >= batch->depth);
+    n_active++;
+
+    // Take the buffers placed by the streaming thread since the last check.
+    if (gst_batch_sink_pad_collect (sinkpad) >= batch->depth)
+      (*n_ready)++;
   }
 
-  // If all pads are idle then ignore the cumulative buffers 'available' variable.
-  return !idle && available;
+  // If all pads are idle then there are no buffers to wait for.
+  if (n_active == 0)
+    return FALSE;
+
+  // Unless minimum fill is set, buffers from all active pads are required.
+  n_required = (batch->minfill != 0) ? MIN (batch->minfill, n_active) : n_active;
+
+  return (*n_ready >= n_required) ? TRUE : FALSE;
 }
 
 static gboolean
@@ -283,13 +309,11 @@ gst_batch_update_src_caps (GstBatch * batch, GstCaps * caps)
   return success;
 }
 
-static gboolean
-gst_batch_extract_sink_buffer (GstElement * element, GstPad * pad,
-    gpointer userdata)
+static void
+gst_batch_extract_sink_buffer (GstBatch * batch, GstBatchSinkPad * sinkpad,
+    GstBuffer * outbuffer, GstMuxStreamsMeta * streams)
 {
-  GstBatch *batch = GST_BATCH (element);
-  GstBatchSinkPad *sinkpad = GST_BATCH_SINK_PAD (pad);
-  GstBuffer *outbuffer = NULL, *inbuffer = NULL;
+  GstBuffer *inbuffer = NULL;
   GstVideoMeta *vmeta = NULL;
   GstVideoRegionOfInterestMeta *roimeta = NULL;
   GstStructure *structure = NULL;
@@ -298,12 +322,10 @@ gst_batch_extract_sink_buffer (GstElement * element, GstPad * pad,
   // If the number of buffers in the queue is less than the requered depth,
   // not enough buffers have been accumulated for the current sink pad
   if (g_queue_get_length (sinkpad->buffers) < batch->depth)
-    return TRUE;
-
-  outbuffer = GST_BUFFER (userdata);
+    return;
 
-  // Get the index of current sink pad, which is going to be its stream ID.
-  stream_id = g_list_index (batch->sinkpads, sinkpad);
+  // The index of current sink pad is going to be its stream ID.
+  stream_id = sinkpad->index;
 
   // Iterate up to "depth" because that is the exact number of buffer that
   // have to be extracted from the queue
@@ -365,10 +387,16 @@ cleanup:
   // Add meta containing information for tensor decryption downstream.
   gst_buffer_add_protection_meta (outbuffer, structure);
 
-  // Set the corresponding channel bit in the buffer universal offset field.
-  GST_BUFFER_OFFSET (outbuffer) |= (1 << stream_id);
+  // Set the corresponding stream bit in the streams bitset meta.
+  gst_mux_streams_meta_set (streams, stream_id);
 
-  return TRUE;
+  // Keep the channels mask in the buffer universal offset field for backward
+  // compatibility as long as all stream IDs fit, otherwise invalidate it.
+  if ((stream_id < GST_BATCH_MAX_OFFSET_STREAMS) &&
+      (GST_BUFFER_OFFSET (outbuffer) != GST_BUFFER_OFFSET_NONE))
+    GST_BUFFER_OFFSET (outbuffer) |= (G_GUINT64_CONSTANT (1) << stream_id);
+  else
+    GST_BUFFER_OFFSET (outbuffer) = GST_BUFFER_OFFSET_NONE;
 }
 
 static void
@@ -378,23 +406,41 @@ gst_batch_worker_task (gpointer userdata)
   GstBatchSrcPad *srcpad = GST_BATCH_SRC_PAD (batch->srcpad);
   GstBuffer *buffer = NULL;
   GstDataQueueItem *item = NULL;
+  GstMuxStreamsMeta *meta = NULL, streams = { 0, };
   GList *list = NULL;
-  guint channels = 0;
-  gboolean available = FALSE;
+  guint n_ready = 0;
 
   GST_BATCH_LOCK (batch);
 
-  // Wait for data from all pads a maximum of average duration seconds.
-  while (batch->active && !gst_batch_sink_buffers_available (batch)) {
+  // Wait for data from the pads until the batch policy is satisfied or timeout.
+  while (batch->active) {
+    // Announce the wait before checking the queues, this way the streaming
+    // threads will not miss to signal for buffers pushed during the check.
+    g_atomic_int_set (&batch->waiting, TRUE);
+
+    if (gst_batch_sink_buffers_available (batch, &n_ready))
+      break;
+
+    // With deadline the timer starts once first stream has enough buffers.
+    if ((batch->deadline != 0) && (n_ready != 0) && (batch->endtime == (-1))) {
+      batch->endtime = g_get_monotonic_time () +
+          (batch->deadline * G_TIME_SPAN_MILLISECOND);
+    }
+
     if (batch->endtime == (-1)) {
       // End time not yet initialized, wait until first buffers are received.
       g_cond_wait (&batch->wakeup, &batch->lock);
     } else if (!g_cond_wait_until (&batch->wakeup, &batch->lock, batch->endtime)) {
       GST_DEBUG_OBJECT (batch, "Clock timeout, not all pads have buffers!");
+
+      // Take any buffers which arrived while waiting for the timeout.
+      gst_batch_sink_buffers_available (batch, &n_ready);
       break;
     }
   }
 
+  g_atomic_int_set (&batch->waiting, FALSE);
+
   // Immediately exit the worker task if signaled to stop.
   if (!batch->active) {
     GST_BATCH_UNLOCK (batch);
@@ -402,16 +448,7 @@ gst_batch_worker_task (gpointer userdata)
   }
 
   // In case of timeout, check if any sink pad has accumulated enough buffers
-  for (list = batch->sinkpads; list != NULL; list = g_list_next (list)) {
-    GstBatchSinkPad *sinkpad = GST_BATCH_SINK_PAD (list->data);
-
-    if (g_queue_get_length (sinkpad->buffers) >= batch->depth) {
-      available = TRUE;
-      break;
-    }
-  }
-
-  if (!available) {
+  if (n_ready == 0) {
     GST_DEBUG_OBJECT (batch, "Could not accumulate enough buffers for any of "
         "the sink pads");
 
@@ -419,20 +456,30 @@ gst_batch_worker_task (gpointer userdata)
     return;
   }
 
-  // Initialize the end time tracker when first buffers are received.
-  if (batch->endtime == (-1))
-    batch->endtime = g_get_monotonic_time () + (batch->duration / 1000);
+  if (batch->deadline != 0) {
+    // Reset the timer, it will start again when a stream has enough buffers.
+    batch->endtime = -1;
+  } else {
+    // Initialize the end time tracker when first buffers are received.
+    if (batch->endtime == (-1))
+      batch->endtime = g_get_monotonic_time () + (batch->duration / 1000);
 
-  // Add the output buffer duration to the end time for the next wait cycle.
-  batch->endtime += batch->duration / 1000;
+    // Add the output buffer duration to the end time for the next wait cycle.
+    batch->endtime += batch->duration / 1000;
+  }
 
   // Create a new buffer wrapper to hold a reference to input buffer.
   buffer = gst_buffer_new ();
   // Reset the offset field as it will be used to store the channels mask.
   GST_BUFFER_OFFSET (buffer) = 0;
 
-  gst_element_foreach_sink_pad (GST_ELEMENT_CAST (batch),
-      gst_batch_extract_sink_buffer, buffer);
+  // Attach the bitset meta which will be filled with the batched streams.
+  meta = gst_buffer_add_mux_streams_meta (buffer);
+
+  // Sink pads are sorted by index, memory blocks are in stream ID order.
+  for (list = batch->sinkpads; list != NULL; list = g_list_next (list))
+    gst_batch_extract_sink_buffer (batch, GST_BATCH_SINK_PAD (list->data),
+        buffer, meta);
 
   GST_BATCH_UNLOCK (batch);
 
@@ -458,8 +505,8 @@ gst_batch_worker_task (gpointer userdata)
 
   GST_BATCH_SRC_UNLOCK (srcpad);
 
-  // Save the set channel mask for later use.
-  channels = GST_BUFFER_OFFSET (buffer);
+  // Save the set streams mask for later use.
+  streams = *meta;
 
   // If buffer is empty, mark this buffer as GAP.
   if (gst_buffer_get_size (buffer) == 0)
@@ -483,11 +530,10 @@ gst_batch_worker_task (gpointer userdata)
   // Buffer was sent to srcpad, remove the sinkpad buffers from the queues.
   for (list = batch->sinkpads; list != NULL; list = list->next) {
     GstBatchSinkPad *sinkpad = GST_BATCH_SINK_PAD (list->data);
-    guint stream_id = g_list_index (batch->sinkpads, sinkpad);
     guint idx = 0;
 
     // Check if curent sink pad was used for the output buffer.
-    if (!(channels & (1 << stream_id)))
+    if (!gst_mux_streams_meta_is_set (&streams, sinkpad->index))
       continue;
 
     for (idx = 0; idx < batch->moving_window_size; idx++) {
@@ -577,10 +623,8 @@ gst_batch_stop_worker_task (GstBatch * batch)
 
   GST_BATCH_LOCK (batch);
 
-  for (list = batch->sinkpads; list != NULL; list = list->next) {
-    GstBatchSinkPad *sinkpad = GST_BATCH_SINK_PAD (list->data);
-    g_queue_clear_full (sinkpad->buffers, (GDestroyNotify) gst_buffer_unref);
-  }
+  for (list = batch->sinkpads; list != NULL; list = list->next)
+    gst_batch_sink_pad_flush (GST_BATCH_SINK_PAD (list->data));
 
   GST_BATCH_UNLOCK (batch);
 
@@ -852,7 +896,7 @@ gst_batch_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
       GST_BATCH_LOCK (batch);
 
       // When upstream elements query for drain, flush buffers in the queue.
-      g_queue_clear_full (sinkpad->buffers, (GDestroyNotify) gst_buffer_unref);
+      gst_batch_sink_pad_flush (sinkpad);
       g_cond_broadcast (&batch->wakeup);
 
       GST_BATCH_UNLOCK (batch);
@@ -923,7 +967,7 @@ gst_batch_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
     case GST_EVENT_FLUSH_START:
       GST_BATCH_LOCK (batch);
 
-      g_queue_clear_full (sinkpad->buffers, (GDestroyNotify) gst_buffer_unref);
+      gst_batch_sink_pad_flush (sinkpad);
       sinkpad->is_idle = TRUE;
 
       g_cond_broadcast (&batch->wakeup);
@@ -959,15 +1003,14 @@ gst_batch_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
       // Wait until all queued input buffers have been processed.
       while (batch->active &&
-            (g_queue_get_length (sinkpad->buffers) >= batch->depth)) {
+            (gst_batch_sink_pad_n_buffers (sinkpad) >= batch->depth)) {
         gint64 endtime = g_get_monotonic_time () + 1 * G_TIME_SPAN_SECOND;
 
         if (!g_cond_wait_until (&batch->wakeup, &batch->lock, endtime))
           GST_WARNING_OBJECT (sinkpad, "Timeout while waiting for idle!");
       }
 
-      if (!g_queue_is_empty (sinkpad->buffers))
-        g_queue_clear_full (sinkpad->buffers, (GDestroyNotify) gst_buffer_unref);
+      gst_batch_sink_pad_flush (sinkpad);
 
       GST_TRACE_OBJECT (sinkpad, "Received idle");
       sinkpad->is_idle = TRUE;
@@ -1019,12 +1062,15 @@ gst_batch_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     return GST_FLOW_OK;
   }
 
-  GST_BATCH_LOCK (batch);
+  // Lock-free hand over of the buffer to the worker task.
+  gst_atomic_queue_push (sinkpad->pending, buffer);
 
-  g_queue_push_tail (sinkpad->buffers, buffer);
-  g_cond_broadcast (&batch->wakeup);
-
-  GST_BATCH_UNLOCK (batch);
+  // Signal the worker task only when it is waiting for incoming buffers.
+  if (g_atomic_int_get (&batch->waiting)) {
+    GST_BATCH_LOCK (batch);
+    g_cond_broadcast (&batch->wakeup);
+    GST_BATCH_UNLOCK (batch);
+  }
 
   return GST_FLOW_OK;
 }
@@ -1051,6 +1097,13 @@ gst_batch_request_pad (GstElement * element, GstPadTemplate * templ,
 
   GST_BATCH_UNLOCK (batch);
 
+  // The pad index is used as stream ID which has limited number of bits.
+  if (index >= GST_MUX_MAX_STREAMS) {
+    GST_ERROR_OBJECT (batch, "Pad index %u exceeds the maximum of %u streams!",
+        index, GST_MUX_MAX_STREAMS);
+    return NULL;
+  }
+
   name = g_strdup_printf ("sink_%u", index);
 
   pad = g_object_new (GST_TYPE_BATCH_SINK_PAD, "name", name, "direction",
@@ -1062,6 +1115,8 @@ gst_batch_request_pad (GstElement * element, GstPadTemplate * templ,
     return NULL;
   }
 
+  GST_BATCH_SINK_PAD (pad)->index = index;
+
   gst_pad_set_query_function (pad,
       GST_DEBUG_FUNCPTR (gst_batch_sink_query));
   gst_pad_set_event_function (pad,
@@ -1077,7 +1132,8 @@ gst_batch_request_pad (GstElement * element, GstPadTemplate * templ,
 
   GST_BATCH_LOCK (batch);
 
-  batch->sinkpads = g_list_append (batch->sinkpads, pad);
+  batch->sinkpads = g_list_insert_sorted (batch->sinkpads, pad,
+      gst_batch_sink_pads_compare);
   batch->nextidx = nextindex;
 
   GST_BATCH_UNLOCK (batch);
@@ -1155,6 +1211,12 @@ gst_batch_set_property (GObject * object, guint prop_id,
     case PROP_MOVING_WINDOW_SIZE:
       batch->moving_window_size = g_value_get_uint (value);
       break;
+    case PROP_MIN_FILL:
+      batch->minfill = g_value_get_uint (value);
+      break;
+    case PROP_DEADLINE:
+      batch->deadline = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1171,6 +1233,12 @@ gst_batch_get_property (GObject * object, guint prop_id,
     case PROP_MOVING_WINDOW_SIZE:
       g_value_set_uint (value, batch->moving_window_size);
       break;
+    case PROP_MIN_FILL:
+      g_value_set_uint (value, batch->minfill);
+      break;
+    case PROP_DEADLINE:
+      g_value_set_uint (value, batch->deadline);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1206,6 +1274,21 @@ gst_batch_class_init (GstBatchClass *klass)
           1, 16, DEFAULT_PROP_MOVING_WINDOW_SIZE,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (object, PROP_MIN_FILL,
+      g_param_spec_uint ("min-fill", "Minimum fill",
+          "Minimum number of streams with buffers needed to produce an output "
+          "batch without waiting for the rest (0 = all active streams)",
+          0, GST_MUX_MAX_STREAMS, DEFAULT_PROP_MIN_FILL,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (object, PROP_DEADLINE,
+      g_param_spec_uint ("deadline", "Deadline",
+          "Time in milliseconds to wait for the remaining streams once the "
+          "first stream has buffers, after which a partial batch is produced "
+          "(0 = wait for a fixed window based on the output frame duration)",
+          0, G_MAXUINT, DEFAULT_PROP_DEADLINE,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 
   gst_element_class_add_static_pad_template_with_gtype (element,
       &gst_batch_sink_template, GST_TYPE_BATCH_SINK_PAD);
@@ -1243,6 +1326,9 @@ gst_batch_init (GstBatch * batch)
 
   batch->depth = 1;
   batch->moving_window_size = DEFAULT_PROP_MOVING_WINDOW_SIZE;
+  batch->minfill = DEFAULT_PROP_MIN_FILL;
+  batch->deadline = DEFAULT_PROP_DEADLINE;
+  batch->waiting = FALSE;
 
   g_rec_mutex_init (&batch->worklock);
   g_cond_init (&batch->wakeup);
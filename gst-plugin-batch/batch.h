@@ -58,12 +58,18 @@ struct _GstBatch
   gint64         endtime;
   /// Condition for negotiating output caps and push/pop buffers from the queues.
   GCond          wakeup;
+  /// Atomic flag indicating that the worker task waits for incoming buffers.
+  gint           waiting;
   /// Depth indicating how many buffers should be accumulated from each stream.
   guint          depth;
 
   /// Properties
   /// Indicating how many new buffers will be used for each output frame.
   guint          moving_window_size;
+  /// Minimum number of streams with buffers needed to form a batch.
+  guint          minfill;
+  /// Time in milliseconds to wait for the streams after the first is ready.
+  guint          deadline;
 };
 
 struct _GstBatchClass {
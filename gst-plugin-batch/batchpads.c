@@ -5,18 +5,20 @@
 
 #include "batchpads.h"
 
+#include <gst/utils/gstmuxstreamsmeta.h>
+
 GST_DEBUG_CATEGORY_EXTERN (gst_batch_debug);
 #define GST_CAT_DEFAULT gst_batch_debug
 
 G_DEFINE_TYPE(GstBatchSinkPad, gst_batch_sink_pad, GST_TYPE_PAD);
 G_DEFINE_TYPE(GstBatchSrcPad, gst_batch_src_pad, GST_TYPE_PAD);
 
-#define GST_BINARY_8BIT_FORMAT "%c%c%c%c%c%c%c%c"
-#define GST_BINARY_8BIT_STRING(x) \
-  (x & 0x80 ? '1' : '0'), (x & 0x40 ? '1' : '0'), (x & 0x20 ? '1' : '0'), \
-  (x & 0x10 ? '1' : '0'), (x & 0x08 ? '1' : '0'), (x & 0x04 ? '1' : '0'), \
-  (x & 0x02 ? '1' : '0'), (x & 0x01 ? '1' : '0')
-
+static inline guint
+gst_batch_buffer_n_streams (GstBuffer * buffer)
+{
+  GstMuxStreamsMeta *meta = gst_buffer_get_mux_streams_meta (buffer);
+  return (meta != NULL) ? gst_mux_streams_meta_n_streams (meta) : 0;
+}
 
 static gboolean
 queue_is_full_cb (GstDataQueue * queue, guint visible, guint bytes,
@@ -42,7 +44,10 @@ gst_batch_sink_pad_finalize (GObject * object)
 {
   GstBatchSinkPad *pad = GST_BATCH_SINK_PAD (object);
 
-  g_queue_free_full (pad->buffers, (GDestroyNotify) gst_buffer_unref);
+  gst_batch_sink_pad_flush (pad);
+
+  gst_atomic_queue_unref (pad->pending);
+  g_queue_free (pad->buffers);
 
   G_OBJECT_CLASS (gst_batch_sink_pad_parent_class)->finalize(object);
 }
@@ -60,10 +65,43 @@ gst_batch_sink_pad_init (GstBatchSinkPad * pad)
 {
   gst_segment_init (&pad->segment, GST_FORMAT_UNDEFINED);
 
+  pad->index = 0;
   pad->is_idle = TRUE;
+
+  pad->pending = gst_atomic_queue_new (16);
   pad->buffers = g_queue_new ();
 }
 
+guint
+gst_batch_sink_pad_n_buffers (GstBatchSinkPad * pad)
+{
+  return g_queue_get_length (pad->buffers) +
+      gst_atomic_queue_length (pad->pending);
+}
+
+guint
+gst_batch_sink_pad_collect (GstBatchSinkPad * pad)
+{
+  GstBuffer *buffer = NULL;
+
+  // Move the buffers placed by the streaming thread into the batching queue.
+  while ((buffer = gst_atomic_queue_pop (pad->pending)) != NULL)
+    g_queue_push_tail (pad->buffers, buffer);
+
+  return g_queue_get_length (pad->buffers);
+}
+
+void
+gst_batch_sink_pad_flush (GstBatchSinkPad * pad)
+{
+  GstBuffer *buffer = NULL;
+
+  while ((buffer = gst_atomic_queue_pop (pad->pending)) != NULL)
+    gst_buffer_unref (buffer);
+
+  g_queue_clear_full (pad->buffers, (GDestroyNotify) gst_buffer_unref);
+}
+
 static void
 gst_batch_src_pad_worker_task (gpointer userdata)
 {
@@ -78,12 +116,11 @@ gst_batch_src_pad_worker_task (gpointer userdata)
     item->object = NULL;
 
     GST_TRACE_OBJECT (srcpad, "Pushing buffer %p of size %" G_GSIZE_FORMAT
-        " with %u memory blocks, channels mask " GST_BINARY_8BIT_FORMAT
-        ", timestamp %" GST_TIME_FORMAT ", duration %" GST_TIME_FORMAT
-        " flags 0x%X", buffer, gst_buffer_get_size (buffer),
-        gst_buffer_n_memory (buffer), GST_BINARY_8BIT_STRING (buffer->offset),
-        GST_TIME_ARGS (buffer->pts), GST_TIME_ARGS (buffer->duration),
-        GST_BUFFER_FLAGS (buffer));
+        " with %u memory blocks from %u streams, timestamp %" GST_TIME_FORMAT
+        ", duration %" GST_TIME_FORMAT " flags 0x%X", buffer,
+        gst_buffer_get_size (buffer), gst_buffer_n_memory (buffer),
+        gst_batch_buffer_n_streams (buffer), GST_TIME_ARGS (buffer->pts),
+        GST_TIME_ARGS (buffer->duration), GST_BUFFER_FLAGS (buffer));
 
     gst_pad_push (GST_PAD (srcpad), buffer);
 
@@ -82,10 +82,15 @@ struct _GstBatchSinkPad {
   /// Segment.
   GstSegment   segment;
 
+  /// Index of the pad, used as stream ID of its buffers in the batch.
+  guint        index;
+
   /// Flag indicating that there is no more work for processing.
   gboolean     is_idle;
 
-  /// Queue for managing incoming buffers.
+  /// Lock-free queue in which the streaming thread places incoming buffers.
+  GstAtomicQueue *pending;
+  /// Queue for managing buffers taken by the worker task for batching.
   GQueue       *buffers;
 };
 
@@ -123,6 +128,10 @@ struct _GstBatchSrcPadClass {
 GType gst_batch_sink_pad_get_type (void);
 GType gst_batch_src_pad_get_type (void);
 
+guint gst_batch_sink_pad_n_buffers (GstBatchSinkPad * pad);
+guint gst_batch_sink_pad_collect (GstBatchSinkPad * pad);
+void gst_batch_sink_pad_flush (GstBatchSinkPad * pad);
+
 
 gboolean gst_batch_src_pad_event (GstPad * pad, GstObject * parent,
                                   GstEvent * event);
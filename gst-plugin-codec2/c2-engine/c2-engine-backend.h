@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GST_C2_ENGINE_BACKEND_H__
+#define __GST_C2_ENGINE_BACKEND_H__
+
+#include <memory>
+
+#include <gst/gst.h>
+
+#include "c2-engine.h"
+
+/** GstC2BackendListener
+ *
+ * Implemented by the engine, receives the output of the backends. The methods
+ * may be called from any thread of the backend.
+ **/
+class GstC2BackendListener {
+ public:
+  virtual ~GstC2BackendListener() = default;
+
+  /** EventAvailable
+   * @type: Engine event type (GST_C2_EVENT_*).
+   * @payload: Event specific payload, frame index for GST_C2_EVENT_DROP and
+   *           error code for GST_C2_EVENT_ERROR.
+   *
+   * Notify for an event from the component.
+   **/
+  virtual void EventAvailable(uint32_t type, void* payload) = 0;
+
+  /** BufferAvailable
+   * @buffer: Encoded or decoded output buffer (transfer full).
+   * @complete: Whether this is the last output buffer of the frame.
+   *
+   * Notify for an output buffer. The frame index is placed in the buffer
+   * offset field and the timestamp in the buffer PTS.
+   **/
+  virtual void BufferAvailable(GstBuffer* buffer, bool complete) = 0;
+};
+
+/** GstC2Backend
+ *
+ * Internal interface which hides the component implementation from the
+ * engine. Every successfully queued frame must eventually be reported back
+ * either through BufferAvailable() with complete flag set or through a
+ * GST_C2_EVENT_DROP event, an EOS or error event completes all of them.
+ **/
+class GstC2Backend {
+ public:
+  virtual ~GstC2Backend() = default;
+
+  /** GetParameter
+   * @type: Engine parameter type.
+   * @payload: Pointer to the structure or variable which will be filled.
+   *
+   * return: True on success or false on failure.
+   **/
+  virtual bool GetParameter(uint32_t type, void* payload) = 0;
+
+  /** SetParameter
+   * @type: Engine parameter type.
+   * @payload: Pointer to the structure or variable with the parameter data.
+   *
+   * return: True on success or false on failure.
+   **/
+  virtual bool SetParameter(uint32_t type, void* payload) = 0;
+
+  /** Start
+   *
+   * Allow the component to process frames.
+   *
+   * return: True on success or false on failure.
+   **/
+  virtual bool Start() = 0;
+
+  /** Stop
+   *
+   * Stop the component from processing any further frames.
+   *
+   * return: True on success or false on failure.
+   **/
+  virtual bool Stop() = 0;
+
+  /** Flush
+   *
+   * Discard all pending frames in the component.
+   *
+   * return: True on success or false on failure.
+   **/
+  virtual bool Flush() = 0;
+
+  /** Queue
+   * @item: The frame which will be encoded or decoded.
+   *
+   * Submit a frame to the component. The item and its user data are valid
+   * only for the duration of this call.
+   *
+   * return: True on success or false on failure.
+   **/
+  virtual bool Queue(GstC2QueueItem* item) = 0;
+
+  /** QueueEOS
+   *
+   * Submit an EOS, the backend signals GST_C2_EVENT_EOS once all frames
+   * queued before it have been output.
+   *
+   * return: True on success or false on failure.
+   **/
+  virtual bool QueueEOS() = 0;
+};
+
+#if defined(ENABLE_C2_HW_BACKEND)
+/** GstC2HwBackendNew
+ * @name: The Codec2 component name.
+ * @mode: Component mode/type (GST_C2_MODE_*).
+ * @listener: Listener receiving the component output.
+ *
+ * Create backend for the Codec2 hardware components.
+ * Throws an exception on failure.
+ **/
+std::unique_ptr<GstC2Backend> GstC2HwBackendNew(const char* name, uint32_t mode,
+                                                GstC2BackendListener* listener);
+#endif // ENABLE_C2_HW_BACKEND
+
+#if defined(ENABLE_C2_SW_BACKEND)
+/** GstC2SwBackendNew
+ * @name: The Codec2 component name, the codec is derived from it.
+ * @mode: Component mode/type (GST_C2_MODE_*).
+ * @listener: Listener receiving the component output.
+ *
+ * Create software backend based on libavcodec for the video components.
+ * Throws an exception on failure.
+ **/
+std::unique_ptr<GstC2Backend> GstC2SwBackendNew(const char* name, uint32_t mode,
+                                                GstC2BackendListener* listener);
+#endif // ENABLE_C2_SW_BACKEND
+
+#endif // __GST_C2_ENGINE_BACKEND_H__
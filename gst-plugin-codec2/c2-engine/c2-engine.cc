@@ -5,21 +5,10 @@
 
 #include "c2-engine.h"
 
-#include "c2-module.h"
+#include "c2-engine-backend.h"
 #include "c2-engine-params.h"
-#include "c2-engine-utils.h"
 
 #define GST_CAT_DEFAULT ensure_debug_category()
-static G_DEFINE_QUARK (GstC2BufferQuark, gst_c2_buffer_qdata);
-
-#define GST_C2_MODE_VIDEO_ENCODE(engine) \
-  ((engine->mode == GST_C2_MODE_VIDEO_ENCODE) ? TRUE : FALSE)
-#define GST_C2_MODE_VIDEO_DECODE(engine) \
-  ((engine->mode == GST_C2_MODE_VIDEO_DECODE) ? TRUE : FALSE)
-#define GST_C2_MODE_AUDIO_ENCODE(engine) \
-  ((engine->mode == GST_C2_MODE_AUDIO_ENCODE) ? TRUE : FALSE)
-#define GST_C2_MODE_AUDIO_DECODE(engine) \
-  ((engine->mode == GST_C2_MODE_AUDIO_DECODE) ? TRUE : FALSE)
 
 #define GST_C2_ENGINE_INCREMENT_PENDING_WORK(engine) \
 { \
@@ -40,6 +29,7 @@ static G_DEFINE_QUARK (GstC2BufferQuark, gst_c2_buffer_qdata);
 { \
   g_mutex_lock (&engine->lock); \
   engine->n_pending = 0; \
+  g_hash_table_remove_all (engine->works); \
   g_cond_broadcast (&engine->workdone); \
   g_mutex_unlock (&engine->lock); \
 }
@@ -56,30 +46,65 @@ static G_DEFINE_QUARK (GstC2BufferQuark, gst_c2_buffer_qdata);
   g_mutex_unlock (&engine->lock); \
 }
 
+// Upper limits of the pending work depth for each component mode.
 #define MAX_NUM_PENDING_WORK_VIDEO_ENCODE   (26)
 #define MAX_NUM_PENDING_WORK_VIDEO_DECODE   (11)
 #define MAX_NUM_PENDING_WORK_AUDIO_ENCODE   (11)
 #define MAX_NUM_PENDING_WORK_AUDIO_DECODE   (11)
 
+// Lower limit of the adaptive pending work depth.
+#define MIN_NUM_PENDING_WORK                (2)
+// Number of completed works needed before the depth is adapted.
+#define NUM_PENDING_WORK_WARMUP             (8)
+
+// Exponential moving average, the newest sample has a weight of 1/8.
+#define GST_C2_ENGINE_AVERAGE(average, sample) \
+  average = (average == 0) ? (sample) : (average + ((sample) - average) / 8)
+
+typedef struct _GstC2PendingWork GstC2PendingWork;
+
+struct _GstC2PendingWork {
+  /// Frame index, must be first as it is used as hash table key.
+  guint64 index;
+  /// Monotonic time at which the work was submitted to the backend.
+  gint64  queued;
+};
+
+class GstC2EngineListener;
+
 struct _GstC2Engine {
   /// Component name, used mainly for debugging.
-  gchar           *name;
-  /// Codec2 component instance.
-  C2Module        *c2module;
+  gchar                *name;
+  /// Component implementation, either hardware or software.
+  GstC2Backend         *backend;
+  /// Receives the component output and forwards it to the callbacks.
+  GstC2EngineListener  *listener;
   /// Component mode/type: Encode or Decode.
-  guint32         mode;
+  guint32              mode;
 
   /// Draining state & pending frames lock.
-  GMutex          lock;
+  GMutex               lock;
   /// Tracking the number of pending frames.
-  guint32         n_pending;
+  guint32              n_pending;
   /// Maximum number of pending frames allowed before blocking.
-  guint32         max_pending_work;
+  guint32              max_pending_work;
+  /// Upper limit for the maximum number of pending frames.
+  guint32              max_pending_limit;
   /// Condition signalled when pending frame has been processed.
-  GCond           workdone;
-
-  GstC2Callbacks  *callbacks;
-  gpointer        userdata;
+  GCond                workdone;
+
+  /// Pending works indexed by frame index, used for latency measurement.
+  GHashTable           *works;
+  /// Monotonic time at which the last frame was received for queueing.
+  gint64               lastqueued;
+  /// Moving averages of the work latency and interval between frames in us.
+  gint64               avg_latency;
+  gint64               avg_interval;
+  /// Number of latency samples.
+  guint32              n_samples;
+
+  GstC2Callbacks       *callbacks;
+  gpointer             userdata;
 };
 
 static GstDebugCategory *
@@ -96,181 +121,147 @@ ensure_debug_category (void)
   return (GstDebugCategory *) catonce;
 }
 
-// Wrapper class for C2 buffer which is attached to the corresponding
-// GST buffer and will be deleted when the GST buffer is released. By deleting
-// this wrapper the shared pointer to the C2 buffer will be released as well.
-class GstC2BufferQData {
- public:
-  GstC2BufferQData(std::shared_ptr<C2Buffer>& c2buffer) : c2buffer_(c2buffer) {}
-  ~GstC2BufferQData() = default;
+static void
+gst_c2_engine_work_queued (GstC2Engine * engine, guint64 index)
+{
+  GstC2PendingWork *work = g_new0 (GstC2PendingWork, 1);
 
- private:
-  std::shared_ptr<C2Buffer> c2buffer_;
-};
+  work->index = index;
+  work->queued = g_get_monotonic_time ();
+
+  g_mutex_lock (&engine->lock);
+
+  g_hash_table_replace (engine->works, work, work);
+  engine->n_pending++;
+
+  g_mutex_unlock (&engine->lock);
+}
 
 static void
-gst_c2_buffer_qdata_release (gpointer userdata)
+gst_c2_engine_work_failed (GstC2Engine * engine, guint64 index)
 {
-  GstC2BufferQData *qdata = reinterpret_cast<GstC2BufferQData*>(userdata);
-  delete qdata;
+  g_mutex_lock (&engine->lock);
+
+  if (g_hash_table_remove (engine->works, &index) && (engine->n_pending > 0))
+    engine->n_pending--;
+
+  g_cond_broadcast (&engine->workdone);
+  g_mutex_unlock (&engine->lock);
 }
 
-// Nofifier class for C2 buffers and events. Translates the C2 data into the
-// GStreamer equivalent and then calls the registered engine callbacks.
-class GstC2Notifier : public IC2Notifier {
- public:
-  GstC2Notifier(GstC2Engine* engine) : engine_(engine) {}
-
-  void EventHandler(C2EventType event, void* payload) override {
-
-    guint type = GST_C2_EVENT_UNKNOWN;
-
-    switch (event) {
-      case C2EventType::kError:
-        type = GST_C2_EVENT_ERROR;
-        GST_C2_ENGINE_ZERO_OUT_PENDING_WORK (engine_);
-        break;
-      case C2EventType::kEOS:
-        GST_C2_ENGINE_ZERO_OUT_PENDING_WORK (engine_);
-        type = GST_C2_EVENT_EOS;
-        break;
-      case C2EventType::kDrop:
-        type = GST_C2_EVENT_DROP;
-        break;
-      default:
-        GST_WARNING ("Unknown event '%u'!", static_cast<uint32_t>(event));
-        return;
-    }
+static void
+gst_c2_engine_work_done (GstC2Engine * engine, guint64 index, gboolean sample)
+{
+  GstC2PendingWork *work = NULL;
+  guint32 depth = 0;
 
-    engine_->callbacks->event (type, payload, engine_->userdata);
+  g_mutex_lock (&engine->lock);
+
+  work = (GstC2PendingWork *) g_hash_table_lookup (engine->works, &index);
 
-    if (event == C2EventType::kDrop)
-      GST_C2_ENGINE_DECREMENT_PENDING_WORK (engine_);
+  if ((work != NULL) && sample) {
+    GST_C2_ENGINE_AVERAGE (engine->avg_latency,
+        g_get_monotonic_time () - work->queued);
+    engine->n_samples++;
   }
 
-  void FrameAvailable(std::shared_ptr<C2Buffer>& c2buffer, uint64_t index,
-                      uint64_t timestamp, C2FrameData::flags_t flags) override {
-
-    GstBuffer *buffer = NULL;
-    GstAllocator *allocator = NULL;
-    GstMemory *memory = NULL;
-    uint32_t fd = 0, size = 0;
-
-    // Allocate a new buffer and copy output data from the codec
-    // This is needed due to circular buffer implementation in the Codec2
-    // where the output buffers are reusable and a caching issues will appears
-    // in the next plugins
-    if (GST_C2_MODE_AUDIO_ENCODE (engine_) ||
-        GST_C2_MODE_AUDIO_DECODE (engine_)) {
-#if defined(ENABLE_AUDIO_PLUGINS)
-      const C2ConstLinearBlock block = c2buffer->data().linearBlocks().front();
-      size = block.size();
-      C2ReadView view = block.map().get();
-      buffer = gst_buffer_new_and_alloc (size);
-      gst_buffer_fill (buffer, 0, view.data(), size);
-#else
-      GST_ERROR ("Audio is not supported!");
-      return;
-#endif //ENABLE_AUDIO_PLUGINS
-    } else {
-      if ((buffer = gst_buffer_new ()) == NULL) {
-        GST_ERROR ("Failed to create GST buffer!");
-        return;
-      }
-
-      if (c2buffer->data().type() == C2BufferData::LINEAR) {
-        const C2ConstLinearBlock block = c2buffer->data().linearBlocks().front();
-        const C2Handle *handle = block.handle();
-
-        size = block.size();
-        fd = handle->data[0];
-      } else if (c2buffer->data().type() == C2BufferData::GRAPHIC) {
-        const C2ConstGraphicBlock block = c2buffer->data().graphicBlocks().front();
-        auto handle = static_cast<const android::C2HandleGBM*>(block.handle());
-
-        size = handle->mInts.size;
-        fd = handle->mFds.buffer_fd;
-
-        if (!GstC2Utils::ExtractHandleInfo (buffer, handle)) {
-          GST_ERROR ("Failed to extract GBM handle info!");
-          gst_buffer_unref (buffer);
-          return;
-        }
-
-        GstVideoMeta *vmeta = gst_buffer_get_video_meta (buffer);
-
-        vmeta->width = block.crop().width;
-        vmeta->height = block.crop().height;
-
-        GST_LOG ("Crop rectangle (%d,%d) [%dx%d] ", block.crop().left,
-            block.crop().top, block.crop().width, block.crop().height);
-      } else {
-        GST_ERROR ("Unknown Codec2 buffer type!");
-        gst_buffer_unref (buffer);
-        return;
-      }
-
-      if ((allocator = gst_fd_allocator_new ()) == NULL) {
-        GST_ERROR ("Failed to create FD allocator!");
-        gst_buffer_unref (buffer);
-        return;
-      }
-
-      if ((memory = gst_fd_allocator_alloc (allocator, fd, size,
-              GST_FD_MEMORY_FLAG_DONT_CLOSE)) == NULL) {
-        GST_ERROR ("Failed to create memory block!");
-        gst_buffer_unref (buffer);
-        gst_object_unref (allocator);
-        return;
-      }
-
-      gst_buffer_append_memory (buffer, memory);
-      gst_object_unref (allocator);
+  if (work != NULL)
+    g_hash_table_remove (engine->works, &index);
+
+  if (engine->n_pending > 0)
+    engine->n_pending--;
+
+  // Keep just enough frames in flight to cover the component latency at the
+  // current input rate, plus one frame in order to absorb jitter.
+  if ((engine->n_samples >= NUM_PENDING_WORK_WARMUP) &&
+      (engine->avg_interval > 0)) {
+    depth = (engine->avg_latency + engine->avg_interval - 1) /
+        engine->avg_interval + 1;
+    depth = CLAMP (depth, MIN_NUM_PENDING_WORK, engine->max_pending_limit);
+
+    if (depth != engine->max_pending_work) {
+      GST_LOG ("Pending work depth %u -> %u, latency %" G_GINT64_FORMAT
+          " us, interval %" G_GINT64_FORMAT " us", engine->max_pending_work,
+          depth, engine->avg_latency, engine->avg_interval);
+      engine->max_pending_work = depth;
     }
+  }
 
-    // Check whetehr this is a key/sync frame.
-    std::shared_ptr<const C2Info> c2info =
-        c2buffer->getInfo (C2StreamPictureTypeInfo::output::PARAM_TYPE);
-    auto pictype =
-        std::static_pointer_cast<const C2StreamPictureTypeInfo::output>(c2info);
-
-    if (pictype && (pictype->value == C2Config::SYNC_FRAME))
-      GST_BUFFER_FLAG_SET (buffer, GST_VIDEO_BUFFER_FLAG_SYNC);
+  g_cond_broadcast (&engine->workdone);
+  g_mutex_unlock (&engine->lock);
+}
 
-    if (flags & C2FrameData::FLAG_CODEC_CONFIG)
-      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_HEADER);
+// Receives the output of the backend, translates it into engine callbacks
+// and keeps track of the pending works.
+class GstC2EngineListener : public GstC2BackendListener {
+ public:
+  GstC2EngineListener(GstC2Engine* engine) : engine_(engine) {}
 
-    if (flags & C2FrameData::FLAG_DROP_FRAME)
-      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DROPPABLE);
+  void EventAvailable(uint32_t type, void* payload) override {
 
-    if (!(flags & C2FrameData::FLAG_INCOMPLETE))
-      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_MARKER);
+    if ((type == GST_C2_EVENT_ERROR) || (type == GST_C2_EVENT_EOS))
+      GST_C2_ENGINE_ZERO_OUT_PENDING_WORK (engine_);
 
-    GST_BUFFER_OFFSET (buffer) = index;
-    GST_BUFFER_TIMESTAMP (buffer) =
-        gst_util_uint64_scale (timestamp, GST_SECOND, 1000000);
+    engine_->callbacks->event (type, payload, engine_->userdata);
 
-    // extract codec2 buffer info to gst buffer
-    GstC2Utils::AppendCodecMeta (buffer, c2buffer);
+    if (type == GST_C2_EVENT_DROP) {
+      guint64 index = *(reinterpret_cast<guint64*>(payload));
+      gst_c2_engine_work_done (engine_, index, FALSE);
+    }
+  }
 
-    GstC2BufferQData *qdata = new GstC2BufferQData(c2buffer);
+  void BufferAvailable(GstBuffer* buffer, bool complete) override {
 
-    // Set a notification function to signal when the buffer is no longer used.
-    gst_mini_object_set_qdata (GST_MINI_OBJECT (buffer),
-        gst_c2_buffer_qdata_quark (), qdata, gst_c2_buffer_qdata_release);
+    guint64 index = GST_BUFFER_OFFSET (buffer);
 
-    GST_TRACE ("Available %" GST_PTR_FORMAT, buffer);
     engine_->callbacks->buffer (buffer, engine_->userdata);
 
     // Deincrement the number of pending works if frame is complete.
-    if (!(flags & C2FrameData::FLAG_INCOMPLETE))
-      GST_C2_ENGINE_DECREMENT_PENDING_WORK (engine_);
+    if (complete)
+      gst_c2_engine_work_done (engine_, index, TRUE);
   }
 
  private:
   GstC2Engine* engine_;
 };
 
+static std::unique_ptr<GstC2Backend>
+gst_c2_engine_create_backend (GstC2Engine * engine, const gchar * name)
+{
+  const gchar *selection = g_getenv ("GST_C2_ENGINE_BACKEND");
+
+  // The backend can be forced, by default hardware is preferred and software
+  // is used as fallback when available.
+#if defined(ENABLE_C2_HW_BACKEND)
+  if ((selection == NULL) || g_str_equal (selection, "hardware")) {
+    try {
+      return GstC2HwBackendNew (name, engine->mode, engine->listener);
+    } catch (std::exception& e) {
+      GST_ERROR ("Failed to create C2 module, error: '%s'!", e.what());
+
+      if (selection != NULL)
+        return nullptr;
+    }
+  }
+#endif // ENABLE_C2_HW_BACKEND
+
+#if defined(ENABLE_C2_SW_BACKEND)
+  if ((selection == NULL) || g_str_equal (selection, "software")) {
+    try {
+      GST_INFO ("Using software backend for '%s'", name);
+      return GstC2SwBackendNew (name, engine->mode, engine->listener);
+    } catch (std::exception& e) {
+      GST_ERROR ("Failed to create software backend, error: '%s'!", e.what());
+      return nullptr;
+    }
+  }
+#endif // ENABLE_C2_SW_BACKEND
+
+  GST_ERROR ("No backend available for '%s' (selection: %s)!", name,
+      GST_STR_NULL (selection));
+  return nullptr;
+}
+
 GstC2Engine *
 gst_c2_engine_new (const gchar * name, guint32 mode, GstC2Callbacks * callbacks,
     gpointer userdata)
@@ -285,54 +276,46 @@ gst_c2_engine_new (const gchar * name, guint32 mode, GstC2Callbacks * callbacks,
 
   engine->mode = mode;
 
-  C2ModeType component_mode;
   switch (mode) {
     case GST_C2_MODE_VIDEO_ENCODE:
-      component_mode = C2ModeType::kVideoEncode;
-      engine->max_pending_work = MAX_NUM_PENDING_WORK_VIDEO_ENCODE;
+      engine->max_pending_limit = MAX_NUM_PENDING_WORK_VIDEO_ENCODE;
       break;
     case GST_C2_MODE_VIDEO_DECODE:
-      component_mode = C2ModeType::kVideoDecode;
-      engine->max_pending_work = MAX_NUM_PENDING_WORK_VIDEO_DECODE;
+      engine->max_pending_limit = MAX_NUM_PENDING_WORK_VIDEO_DECODE;
       break;
     case GST_C2_MODE_AUDIO_ENCODE:
-      component_mode = C2ModeType::kAudioEncode;
-      engine->max_pending_work = MAX_NUM_PENDING_WORK_AUDIO_ENCODE;
+      engine->max_pending_limit = MAX_NUM_PENDING_WORK_AUDIO_ENCODE;
       break;
     case GST_C2_MODE_AUDIO_DECODE:
-      component_mode = C2ModeType::kAudioDecode;
-      engine->max_pending_work = MAX_NUM_PENDING_WORK_AUDIO_DECODE;
+      engine->max_pending_limit = MAX_NUM_PENDING_WORK_AUDIO_DECODE;
       break;
     default:
-      component_mode = C2ModeType::kVideoEncode;
-      engine->max_pending_work = MAX_NUM_PENDING_WORK_VIDEO_ENCODE;
+      engine->max_pending_limit = MAX_NUM_PENDING_WORK_VIDEO_ENCODE;
       break;
   }
 
-  try {
-    engine->c2module = C2Factory::GetModule (name, component_mode);
-  } catch (std::exception& e) {
-    GST_ERROR ("Failed to create C2 module, error: '%s'!", e.what());
-    gst_c2_engine_free (engine);
-    return NULL;
-  }
+  // Start with the upper limit until enough latency samples are gathered.
+  engine->max_pending_work = engine->max_pending_limit;
+
+  engine->works = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+      g_free, NULL);
+
+  engine->callbacks = callbacks;
+  engine->userdata = userdata;
 
-  try {
-    std::shared_ptr<IC2Notifier> notifier =
-        std::make_shared<GstC2Notifier>(engine);
+  engine->listener = new GstC2EngineListener(engine);
 
-    engine->c2module->Initialize (notifier);
-  } catch (std::exception& e) {
-    GST_ERROR ("Failed to initialize, error: '%s'!", e.what());
+  std::unique_ptr<GstC2Backend> backend =
+      gst_c2_engine_create_backend (engine, name);
+
+  if (!backend) {
     gst_c2_engine_free (engine);
     return NULL;
   }
 
+  engine->backend = backend.release();
   engine->name = g_strdup (name);
 
-  engine->callbacks = callbacks;
-  engine->userdata = userdata;
-
   engine->n_pending = 0;
 
   GST_INFO ("Created C2 engine: %p", engine);
@@ -344,11 +327,15 @@ gst_c2_engine_free (GstC2Engine * engine)
 {
   GST_INFO ("Destroyed C2 engine: %p", engine);
 
+  delete engine->backend;
+  delete engine->listener;
+
+  g_hash_table_destroy (engine->works);
+
   g_cond_clear (&engine->workdone);
   g_mutex_clear (&engine->lock);
 
   g_free (engine->name);
-  delete engine->c2module;
 
   g_free (engine);
 }
@@ -356,70 +343,40 @@ gst_c2_engine_free (GstC2Engine * engine)
 gboolean
 gst_c2_engine_get_parameter (GstC2Engine * engine, guint type, gpointer payload)
 {
-  C2Module *c2module = engine->c2module;
-
-  try {
-    C2Param::Index index = GstC2Utils::ParamIndex(type);
-
-    std::unique_ptr<C2Param> c2param = c2module->QueryParam (index);
-    GstC2Utils::PackPayload(type, c2param, payload);
-
-    GST_DEBUG ("Query parameter '%s' was successful", GstC2Utils::ParamName(type));
-  } catch (std::exception& e) {
-    GST_ERROR ("Failed to query c2module parameter, error: '%s'!", e.what());
+  if (!engine->backend->GetParameter (type, payload))
     return FALSE;
-  }
 
+  GST_DEBUG ("Query parameter %u was successful", type);
   return TRUE;
 }
 
 gboolean
 gst_c2_engine_set_parameter (GstC2Engine * engine, guint type, gpointer payload)
 {
-  C2Module *c2module = engine->c2module;
-
-  try {
-    std::unique_ptr<C2Param> c2param;
-    GstC2Utils::UnpackPayload(type, payload, c2param);
-
-    c2module->SetParam (c2param);
-    GST_DEBUG ("Set parameter '%s' was successful", GstC2Utils::ParamName(type));
-  } catch (std::exception& e) {
-    GST_ERROR ("Failed to set c2module parameter, error: '%s'!", e.what());
+  if (!engine->backend->SetParameter (type, payload))
     return FALSE;
-  }
 
+  GST_DEBUG ("Set parameter %u was successful", type);
   return TRUE;
 }
 
 gboolean
 gst_c2_engine_start (GstC2Engine * engine)
 {
-  C2Module *c2module = engine->c2module;
-
-  try {
-    c2module->Start ();
-    GST_DEBUG ("Started c2module '%s'", engine->name);
-  } catch (std::exception& e) {
-    GST_ERROR ("Failed to start c2module, error: '%s'!", e.what());
+  if (!engine->backend->Start ())
     return FALSE;
-  }
 
+  GST_DEBUG ("Started c2module '%s'", engine->name);
   return TRUE;
 }
 
 gboolean
 gst_c2_engine_stop (GstC2Engine * engine)
 {
-  C2Module *c2module = engine->c2module;
-
-  try {
-    c2module->Stop ();
-    GST_DEBUG ("Stopped c2module '%s'", engine->name);
-  } catch (std::exception& e) {
-    GST_ERROR ("Failed to stop c2module, error: '%s'!", e.what());
+  if (!engine->backend->Stop ())
     return FALSE;
-  }
+
+  GST_DEBUG ("Stopped c2module '%s'", engine->name);
 
   // Wait until all work is completed or EOS.
   GST_C2_ENGINE_CHECK_AND_WAIT_PENDING_WORK (engine, 0);
@@ -430,15 +387,10 @@ gst_c2_engine_stop (GstC2Engine * engine)
 gboolean
 gst_c2_engine_flush (GstC2Engine * engine)
 {
-  C2Module *c2module = engine->c2module;
-
-  try {
-    c2module->Flush (C2Component::FLUSH_COMPONENT);
-    GST_DEBUG ("Flushed c2module '%s'", engine->name);
-  } catch (std::exception& e) {
-    GST_ERROR ("Failed to flush c2module, error: '%s'!", e.what());
+  if (!engine->backend->Flush ())
     return FALSE;
-  }
+
+  GST_DEBUG ("Flushed c2module '%s'", engine->name);
 
   // Wait until all work is completed or EOS.
   GST_C2_ENGINE_CHECK_AND_WAIT_PENDING_WORK (engine, 0);
@@ -449,30 +401,10 @@ gst_c2_engine_flush (GstC2Engine * engine)
 gboolean
 gst_c2_engine_drain (GstC2Engine * engine, gboolean eos)
 {
-  C2Module *c2module = engine->c2module;
-  std::shared_ptr<C2Buffer> c2buffer;
-  std::list<std::unique_ptr<C2Param>> settings;
-
-  uint64_t index = 0;
-  uint64_t timestamp = 0;
-  uint32_t flags = C2FrameData::FLAG_END_OF_STREAM;
-
-  // TODO: Switch to Drain API when drain with EOS is supported.
-  // try {
-  //   c2module->Drain (eos ? C2Component::DRAIN_COMPONENT_WITH_EOS :
-  //       C2Component::DRAIN_COMPONENT_NO_EOS);
-  //   GST_DEBUG ("Drain c2module '%s'", engine->name);
-  // } catch (std::exception& e) {
-  //   GST_ERROR ("Failed to drain c2module, error: '%s'!", e.what());
-  //   return FALSE;
-  // }
-
-  try {
-    GST_C2_ENGINE_INCREMENT_PENDING_WORK (engine);
-    c2module->Queue (c2buffer, settings, index, timestamp, flags);
-  } catch (std::exception& e) {
+  GST_C2_ENGINE_INCREMENT_PENDING_WORK (engine);
+
+  if (!engine->backend->QueueEOS ()) {
     GST_C2_ENGINE_DECREMENT_PENDING_WORK (engine);
-    GST_ERROR ("Failed to queue EOS, error: '%s'!", e.what());
     return FALSE;
   }
 
@@ -485,137 +417,28 @@ gst_c2_engine_drain (GstC2Engine * engine, gboolean eos)
 gboolean
 gst_c2_engine_queue (GstC2Engine * engine, GstC2QueueItem * item)
 {
-  C2Module *c2module = engine->c2module;
-  GstBuffer *buffer = item->buffer;
-  std::shared_ptr<C2Buffer> c2buffer;
-  std::list<std::unique_ptr<C2Param>> settings;
-
-  uint64_t index = item->index;
-  uint64_t timestamp = 0;
-  uint32_t flags = 0;
-  uint32_t n_subframes = item->n_subframes;
+  gint64 now = g_get_monotonic_time ();
 
-  // Check and wait in case maximum number of pending frames has been reached.
-  GST_C2_ENGINE_CHECK_AND_WAIT_PENDING_WORK (engine, engine->max_pending_work);
-
-  if (GST_C2_MODE_VIDEO_ENCODE (engine) && (gst_buffer_n_memory (buffer) > 0) &&
-      gst_is_fd_memory (gst_buffer_peek_memory (buffer, 0))) {
-
-    c2buffer = GstC2Utils::ImportGraphicBuffer (buffer, n_subframes);
-  } else if (GST_C2_MODE_VIDEO_ENCODE (engine) &&
-            gst_buffer_n_memory (buffer) > 0) {
-    GstVideoMeta *vmeta = gst_buffer_get_video_meta (buffer);
-    g_return_val_if_fail (vmeta != NULL, FALSE);
-
-    C2PixelFormat format = GstC2Utils::PixelFormat(vmeta->format, n_subframes);
-
-    uint32_t width = vmeta->width;
-    uint32_t height = vmeta->height;
-    bool isheic = GST_BUFFER_FLAG_IS_SET (buffer, GST_VIDEO_BUFFER_FLAG_HEIC);
-
-    std::shared_ptr<C2GraphicBlock> block;
-
-    try {
-      std::shared_ptr<C2GraphicMemory> c2mem = c2module->GetGraphicMemory();
-      block = c2mem->Fetch(width, height, format, isheic);
-    } catch (std::exception& e) {
-      GST_ERROR ("Failed to fetch memory block, error: '%s'!", e.what());
-      return FALSE;
-    }
-
-    c2buffer = GstC2Utils::CreateBuffer (buffer, block);
-#if defined(ENABLE_LINEAR_DMABUF)
-  } else if ((GST_C2_MODE_VIDEO_DECODE (engine) ||
-              GST_C2_MODE_AUDIO_ENCODE (engine) ||
-              GST_C2_MODE_AUDIO_DECODE (engine)) &&
-              gst_buffer_n_memory (buffer) > 0 &&
-              gst_is_fd_memory (gst_buffer_peek_memory (buffer, 0))) {
-
-    c2buffer = GstC2Utils::ImportLinearBuffer (buffer);
-#endif // ENABLE_LINEAR_DMABUF
-  } else if (GST_C2_MODE_VIDEO_DECODE (engine) &&
-             gst_buffer_n_memory (buffer) > 0) {
-    std::shared_ptr<C2LinearBlock> block;
-    uint32_t size = gst_buffer_get_size (buffer);
-
-    try {
-      std::shared_ptr<C2LinearMemory> c2mem = c2module->GetLinearMemory();
-      block = c2mem->Fetch(size);
-    } catch (std::exception& e) {
-      GST_ERROR ("Failed to fetch memory block, error: '%s'!", e.what());
-      return FALSE;
-    }
+  // Measure the input rate when the frame arrives, before blocking.
+  g_mutex_lock (&engine->lock);
 
-    c2buffer = GstC2Utils::CreateBuffer (buffer, block);
-  } else if ((GST_C2_MODE_AUDIO_ENCODE (engine) ||
-              GST_C2_MODE_AUDIO_DECODE (engine)) &&
-              gst_buffer_n_memory (buffer) > 0) {
-    std::shared_ptr<C2LinearBlock> block;
-    uint32_t size = gst_buffer_get_size (buffer);
-#if defined(ENABLE_AUDIO_PLUGINS)
-    try {
-      qc2audio::QC2Status status = qc2audio::QC2_OK;
-      std::shared_ptr<qc2audio::QC2Buffer> outbuffer;
-      std::shared_ptr<qc2audio::QC2BufferCirclePools> c2circlePool =
-          c2module->GetLinearCirclePool(size);
-      status = c2circlePool->take(&outbuffer, nullptr);
-      c2buffer = GstC2Utils::CreateBuffer(buffer, outbuffer);
-    } catch (std::exception& e) {
-      GST_ERROR ("Failed to fetch memory block, error: '%s'!", e.what());
-      return FALSE;
-    }
+  if (engine->lastqueued != 0)
+    GST_C2_ENGINE_AVERAGE (engine->avg_interval, now - engine->lastqueued);
 
-    if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER))
-      flags |= C2FrameData::FLAG_CODEC_CONFIG;
-#else
-    GST_ERROR ("Audio is not supported!");
-    return FALSE;
-#endif //ENABLE_AUDIO_PLUGINS
-  }
+  engine->lastqueued = now;
+  g_mutex_unlock (&engine->lock);
 
-  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DROPPABLE))
-    flags |= C2FrameData::FLAG_DROP_FRAME;
-
-  if (GST_CLOCK_TIME_IS_VALID (GST_BUFFER_DTS (buffer)))
-    timestamp = GST_TIME_AS_USECONDS (GST_BUFFER_DTS (buffer));
-  else if (GST_CLOCK_TIME_IS_VALID (GST_BUFFER_PTS (buffer)))
-    timestamp = GST_TIME_AS_USECONDS (GST_BUFFER_PTS (buffer));
-
-  // Get per frame settings.
-  if (item->userdata) {
-    std::unique_ptr<C2Param> c2param;
-
-    switch (item->userdatatype) {
-      case GST_C2_USERDATA_TYPE_ROI_RECTANGLE: {
-        GstC2QuantRegions *roiparam =
-            reinterpret_cast<GstC2QuantRegions*>(item->userdata);
-        GstC2Utils::UnpackPayload(GST_C2_PARAM_ROI_ENCODE, roiparam, c2param);
-        break;
-      }
-      case GST_C2_USERDATA_TYPE_ROI_MB_MAP: {
-        GstC2QuantMbmapInfo *mbmapinfo =
-            reinterpret_cast<GstC2QuantMbmapInfo*>(item->userdata);
-        GstC2Utils::UnpackPayload(GST_C2_PARAM_ROI_MBMAP_INFO,
-            mbmapinfo, c2param);
-        break;
-      }
-      default:
-        GST_ERROR ("Invalid userdata type '%u'!",
-            static_cast<uint32_t>(item->userdatatype));
-        return FALSE;
-    }
+  // Check and wait in case maximum number of pending frames has been reached.
+  GST_C2_ENGINE_CHECK_AND_WAIT_PENDING_WORK (engine, engine->max_pending_work);
 
-    settings.push_back(std::move(c2param));
-  }
+  // Account the work before queueing as the output may arrive immediately.
+  gst_c2_engine_work_queued (engine, item->index);
 
-  try {
-    c2module->Queue (c2buffer, settings, index, timestamp, flags);
-    GST_DEBUG ("Queued buffer %p", buffer);
-  } catch (std::exception& e) {
-    GST_ERROR ("Failed to queue frame, error: '%s'!", e.what());
+  if (!engine->backend->Queue (item)) {
+    gst_c2_engine_work_failed (engine, item->index);
     return FALSE;
   }
 
-  GST_C2_ENGINE_INCREMENT_PENDING_WORK (engine);
+  GST_DEBUG ("Queued buffer %p", item->buffer);
   return TRUE;
 }
@@ -0,0 +1,490 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "c2-engine-backend.h"
+
+#include "c2-module.h"
+#include "c2-engine-params.h"
+#include "c2-engine-utils.h"
+
+#define GST_CAT_DEFAULT ensure_debug_category()
+static G_DEFINE_QUARK (GstC2BufferQuark, gst_c2_buffer_qdata);
+
+static GstDebugCategory *
+ensure_debug_category (void)
+{
+  static gsize catonce = 0;
+
+  if (g_once_init_enter (&catonce)) {
+    gsize catdone = (gsize) _gst_debug_category_new ("c2-engine", 0,
+        "Codec2 Engine");
+    g_once_init_leave (&catonce, catdone);
+  }
+
+  return (GstDebugCategory *) catonce;
+}
+
+// Wrapper class for C2 buffer which is attached to the corresponding
+// GST buffer and will be deleted when the GST buffer is released. By deleting
+// this wrapper the shared pointer to the C2 buffer will be released as well.
+class GstC2BufferQData {
+ public:
+  GstC2BufferQData(std::shared_ptr<C2Buffer>& c2buffer) : c2buffer_(c2buffer) {}
+  ~GstC2BufferQData() = default;
+
+ private:
+  std::shared_ptr<C2Buffer> c2buffer_;
+};
+
+static void
+gst_c2_buffer_qdata_release (gpointer userdata)
+{
+  GstC2BufferQData *qdata = reinterpret_cast<GstC2BufferQData*>(userdata);
+  delete qdata;
+}
+
+// Nofifier class for C2 buffers and events. Translates the C2 data into the
+// GStreamer equivalent and then passes it to the engine listener.
+class GstC2Notifier : public IC2Notifier {
+ public:
+  GstC2Notifier(uint32_t mode, GstC2BackendListener* listener)
+      : mode_(mode), listener_(listener) {}
+
+  void EventHandler(C2EventType event, void* payload) override {
+
+    guint type = GST_C2_EVENT_UNKNOWN;
+
+    switch (event) {
+      case C2EventType::kError:
+        type = GST_C2_EVENT_ERROR;
+        break;
+      case C2EventType::kEOS:
+        type = GST_C2_EVENT_EOS;
+        break;
+      case C2EventType::kDrop:
+        type = GST_C2_EVENT_DROP;
+        break;
+      default:
+        GST_WARNING ("Unknown event '%u'!", static_cast<uint32_t>(event));
+        return;
+    }
+
+    listener_->EventAvailable (type, payload);
+  }
+
+  void FrameAvailable(std::shared_ptr<C2Buffer>& c2buffer, uint64_t index,
+                      uint64_t timestamp, C2FrameData::flags_t flags) override {
+
+    GstBuffer *buffer = NULL;
+    GstAllocator *allocator = NULL;
+    GstMemory *memory = NULL;
+    uint32_t fd = 0, size = 0;
+
+    // Allocate a new buffer and copy output data from the codec
+    // This is needed due to circular buffer implementation in the Codec2
+    // where the output buffers are reusable and a caching issues will appears
+    // in the next plugins
+    if ((mode_ == GST_C2_MODE_AUDIO_ENCODE) ||
+        (mode_ == GST_C2_MODE_AUDIO_DECODE)) {
+#if defined(ENABLE_AUDIO_PLUGINS)
+      const C2ConstLinearBlock block = c2buffer->data().linearBlocks().front();
+      size = block.size();
+      C2ReadView view = block.map().get();
+      buffer = gst_buffer_new_and_alloc (size);
+      gst_buffer_fill (buffer, 0, view.data(), size);
+#else
+      GST_ERROR ("Audio is not supported!");
+      return;
+#endif //ENABLE_AUDIO_PLUGINS
+    } else {
+      if ((buffer = gst_buffer_new ()) == NULL) {
+        GST_ERROR ("Failed to create GST buffer!");
+        return;
+      }
+
+      if (c2buffer->data().type() == C2BufferData::LINEAR) {
+        const C2ConstLinearBlock block = c2buffer->data().linearBlocks().front();
+        const C2Handle *handle = block.handle();
+
+        size = block.size();
+        fd = handle->data[0];
+      } else if (c2buffer->data().type() == C2BufferData::GRAPHIC) {
+        const C2ConstGraphicBlock block = c2buffer->data().graphicBlocks().front();
+        auto handle = static_cast<const android::C2HandleGBM*>(block.handle());
+
+        size = handle->mInts.size;
+        fd = handle->mFds.buffer_fd;
+
+        if (!GstC2Utils::ExtractHandleInfo (buffer, handle)) {
+          GST_ERROR ("Failed to extract GBM handle info!");
+          gst_buffer_unref (buffer);
+          return;
+        }
+
+        GstVideoMeta *vmeta = gst_buffer_get_video_meta (buffer);
+
+        vmeta->width = block.crop().width;
+        vmeta->height = block.crop().height;
+
+        GST_LOG ("Crop rectangle (%d,%d) [%dx%d] ", block.crop().left,
+            block.crop().top, block.crop().width, block.crop().height);
+      } else {
+        GST_ERROR ("Unknown Codec2 buffer type!");
+        gst_buffer_unref (buffer);
+        return;
+      }
+
+      if ((allocator = gst_fd_allocator_new ()) == NULL) {
+        GST_ERROR ("Failed to create FD allocator!");
+        gst_buffer_unref (buffer);
+        return;
+      }
+
+      if ((memory = gst_fd_allocator_alloc (allocator, fd, size,
+              GST_FD_MEMORY_FLAG_DONT_CLOSE)) == NULL) {
+        GST_ERROR ("Failed to create memory block!");
+        gst_buffer_unref (buffer);
+        gst_object_unref (allocator);
+        return;
+      }
+
+      gst_buffer_append_memory (buffer, memory);
+      gst_object_unref (allocator);
+    }
+
+    // Check whetehr this is a key/sync frame.
+    std::shared_ptr<const C2Info> c2info =
+        c2buffer->getInfo (C2StreamPictureTypeInfo::output::PARAM_TYPE);
+    auto pictype =
+        std::static_pointer_cast<const C2StreamPictureTypeInfo::output>(c2info);
+
+    if (pictype && (pictype->value == C2Config::SYNC_FRAME))
+      GST_BUFFER_FLAG_SET (buffer, GST_VIDEO_BUFFER_FLAG_SYNC);
+
+    if (flags & C2FrameData::FLAG_CODEC_CONFIG)
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_HEADER);
+
+    if (flags & C2FrameData::FLAG_DROP_FRAME)
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DROPPABLE);
+
+    if (!(flags & C2FrameData::FLAG_INCOMPLETE))
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_MARKER);
+
+    GST_BUFFER_OFFSET (buffer) = index;
+    GST_BUFFER_TIMESTAMP (buffer) =
+        gst_util_uint64_scale (timestamp, GST_SECOND, 1000000);
+
+    // extract codec2 buffer info to gst buffer
+    GstC2Utils::AppendCodecMeta (buffer, c2buffer);
+
+    GstC2BufferQData *qdata = new GstC2BufferQData(c2buffer);
+
+    // Set a notification function to signal when the buffer is no longer used.
+    gst_mini_object_set_qdata (GST_MINI_OBJECT (buffer),
+        gst_c2_buffer_qdata_quark (), qdata, gst_c2_buffer_qdata_release);
+
+    GST_TRACE ("Available %" GST_PTR_FORMAT, buffer);
+    listener_->BufferAvailable (buffer,
+        !(flags & C2FrameData::FLAG_INCOMPLETE));
+  }
+
+ private:
+  uint32_t              mode_;
+  GstC2BackendListener* listener_;
+};
+
+// Backend for the Codec2 hardware components.
+class GstC2HwBackend : public GstC2Backend {
+ public:
+  GstC2HwBackend(const char* name, uint32_t mode,
+                 GstC2BackendListener* listener);
+  ~GstC2HwBackend() override;
+
+  bool GetParameter(uint32_t type, void* payload) override;
+  bool SetParameter(uint32_t type, void* payload) override;
+
+  bool Start() override;
+  bool Stop() override;
+  bool Flush() override;
+
+  bool Queue(GstC2QueueItem* item) override;
+  bool QueueEOS() override;
+
+ private:
+  bool IsVideoEncode() const { return mode_ == GST_C2_MODE_VIDEO_ENCODE; }
+  bool IsVideoDecode() const { return mode_ == GST_C2_MODE_VIDEO_DECODE; }
+  bool IsAudio() const {
+    return (mode_ == GST_C2_MODE_AUDIO_ENCODE) ||
+        (mode_ == GST_C2_MODE_AUDIO_DECODE);
+  }
+
+  /// Component mode/type: Encode or Decode.
+  uint32_t  mode_;
+  /// Codec2 component instance.
+  C2Module  *c2module_;
+};
+
+GstC2HwBackend::GstC2HwBackend(const char* name, uint32_t mode,
+                               GstC2BackendListener* listener)
+    : mode_(mode), c2module_(nullptr) {
+
+  C2ModeType component_mode;
+
+  switch (mode) {
+    case GST_C2_MODE_VIDEO_DECODE:
+      component_mode = C2ModeType::kVideoDecode;
+      break;
+    case GST_C2_MODE_AUDIO_ENCODE:
+      component_mode = C2ModeType::kAudioEncode;
+      break;
+    case GST_C2_MODE_AUDIO_DECODE:
+      component_mode = C2ModeType::kAudioDecode;
+      break;
+    case GST_C2_MODE_VIDEO_ENCODE:
+    default:
+      component_mode = C2ModeType::kVideoEncode;
+      break;
+  }
+
+  c2module_ = C2Factory::GetModule (name, component_mode);
+
+  try {
+    std::shared_ptr<IC2Notifier> notifier =
+        std::make_shared<GstC2Notifier>(mode, listener);
+
+    c2module_->Initialize (notifier);
+  } catch (std::exception& e) {
+    delete c2module_;
+    throw;
+  }
+}
+
+GstC2HwBackend::~GstC2HwBackend() {
+  delete c2module_;
+}
+
+bool GstC2HwBackend::GetParameter(uint32_t type, void* payload) {
+
+  try {
+    C2Param::Index index = GstC2Utils::ParamIndex(type);
+
+    std::unique_ptr<C2Param> c2param = c2module_->QueryParam (index);
+    GstC2Utils::PackPayload(type, c2param, payload);
+  } catch (std::exception& e) {
+    GST_ERROR ("Failed to query c2module parameter, error: '%s'!", e.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool GstC2HwBackend::SetParameter(uint32_t type, void* payload) {
+
+  try {
+    std::unique_ptr<C2Param> c2param;
+    GstC2Utils::UnpackPayload(type, payload, c2param);
+
+    c2module_->SetParam (c2param);
+  } catch (std::exception& e) {
+    GST_ERROR ("Failed to set c2module parameter, error: '%s'!", e.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool GstC2HwBackend::Start() {
+
+  try {
+    c2module_->Start ();
+  } catch (std::exception& e) {
+    GST_ERROR ("Failed to start c2module, error: '%s'!", e.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool GstC2HwBackend::Stop() {
+
+  try {
+    c2module_->Stop ();
+  } catch (std::exception& e) {
+    GST_ERROR ("Failed to stop c2module, error: '%s'!", e.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool GstC2HwBackend::Flush() {
+
+  try {
+    c2module_->Flush (C2Component::FLUSH_COMPONENT);
+  } catch (std::exception& e) {
+    GST_ERROR ("Failed to flush c2module, error: '%s'!", e.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool GstC2HwBackend::QueueEOS() {
+
+  std::shared_ptr<C2Buffer> c2buffer;
+  std::list<std::unique_ptr<C2Param>> settings;
+
+  uint64_t index = 0;
+  uint64_t timestamp = 0;
+  uint32_t flags = C2FrameData::FLAG_END_OF_STREAM;
+
+  // TODO: Switch to Drain API when drain with EOS is supported.
+  // try {
+  //   c2module_->Drain (eos ? C2Component::DRAIN_COMPONENT_WITH_EOS :
+  //       C2Component::DRAIN_COMPONENT_NO_EOS);
+  // } catch (std::exception& e) {
+  //   GST_ERROR ("Failed to drain c2module, error: '%s'!", e.what());
+  //   return false;
+  // }
+
+  try {
+    c2module_->Queue (c2buffer, settings, index, timestamp, flags);
+  } catch (std::exception& e) {
+    GST_ERROR ("Failed to queue EOS, error: '%s'!", e.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool GstC2HwBackend::Queue(GstC2QueueItem* item) {
+
+  GstBuffer *buffer = item->buffer;
+  std::shared_ptr<C2Buffer> c2buffer;
+  std::list<std::unique_ptr<C2Param>> settings;
+
+  uint64_t index = item->index;
+  uint64_t timestamp = 0;
+  uint32_t flags = 0;
+  uint32_t n_subframes = item->n_subframes;
+
+  if (IsVideoEncode() && (gst_buffer_n_memory (buffer) > 0) &&
+      gst_is_fd_memory (gst_buffer_peek_memory (buffer, 0))) {
+
+    c2buffer = GstC2Utils::ImportGraphicBuffer (buffer, n_subframes);
+  } else if (IsVideoEncode() && gst_buffer_n_memory (buffer) > 0) {
+    GstVideoMeta *vmeta = gst_buffer_get_video_meta (buffer);
+    g_return_val_if_fail (vmeta != NULL, false);
+
+    C2PixelFormat format = GstC2Utils::PixelFormat(vmeta->format, n_subframes);
+
+    uint32_t width = vmeta->width;
+    uint32_t height = vmeta->height;
+    bool isheic = GST_BUFFER_FLAG_IS_SET (buffer, GST_VIDEO_BUFFER_FLAG_HEIC);
+
+    std::shared_ptr<C2GraphicBlock> block;
+
+    try {
+      std::shared_ptr<C2GraphicMemory> c2mem = c2module_->GetGraphicMemory();
+      block = c2mem->Fetch(width, height, format, isheic);
+    } catch (std::exception& e) {
+      GST_ERROR ("Failed to fetch memory block, error: '%s'!", e.what());
+      return false;
+    }
+
+    c2buffer = GstC2Utils::CreateBuffer (buffer, block);
+#if defined(ENABLE_LINEAR_DMABUF)
+  } else if ((IsVideoDecode() || IsAudio()) &&
+              gst_buffer_n_memory (buffer) > 0 &&
+              gst_is_fd_memory (gst_buffer_peek_memory (buffer, 0))) {
+
+    c2buffer = GstC2Utils::ImportLinearBuffer (buffer);
+#endif // ENABLE_LINEAR_DMABUF
+  } else if (IsVideoDecode() && gst_buffer_n_memory (buffer) > 0) {
+    std::shared_ptr<C2LinearBlock> block;
+    uint32_t size = gst_buffer_get_size (buffer);
+
+    try {
+      std::shared_ptr<C2LinearMemory> c2mem = c2module_->GetLinearMemory();
+      block = c2mem->Fetch(size);
+    } catch (std::exception& e) {
+      GST_ERROR ("Failed to fetch memory block, error: '%s'!", e.what());
+      return false;
+    }
+
+    c2buffer = GstC2Utils::CreateBuffer (buffer, block);
+  } else if (IsAudio() && gst_buffer_n_memory (buffer) > 0) {
+    std::shared_ptr<C2LinearBlock> block;
+    uint32_t size = gst_buffer_get_size (buffer);
+#if defined(ENABLE_AUDIO_PLUGINS)
+    try {
+      qc2audio::QC2Status status = qc2audio::QC2_OK;
+      std::shared_ptr<qc2audio::QC2Buffer> outbuffer;
+      std::shared_ptr<qc2audio::QC2BufferCirclePools> c2circlePool =
+          c2module_->GetLinearCirclePool(size);
+      status = c2circlePool->take(&outbuffer, nullptr);
+      c2buffer = GstC2Utils::CreateBuffer(buffer, outbuffer);
+    } catch (std::exception& e) {
+      GST_ERROR ("Failed to fetch memory block, error: '%s'!", e.what());
+      return false;
+    }
+
+    if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER))
+      flags |= C2FrameData::FLAG_CODEC_CONFIG;
+#else
+    GST_ERROR ("Audio is not supported!");
+    return false;
+#endif //ENABLE_AUDIO_PLUGINS
+  }
+
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DROPPABLE))
+    flags |= C2FrameData::FLAG_DROP_FRAME;
+
+  if (GST_CLOCK_TIME_IS_VALID (GST_BUFFER_DTS (buffer)))
+    timestamp = GST_TIME_AS_USECONDS (GST_BUFFER_DTS (buffer));
+  else if (GST_CLOCK_TIME_IS_VALID (GST_BUFFER_PTS (buffer)))
+    timestamp = GST_TIME_AS_USECONDS (GST_BUFFER_PTS (buffer));
+
+  // Get per frame settings.
+  if (item->userdata) {
+    std::unique_ptr<C2Param> c2param;
+
+    switch (item->userdatatype) {
+      case GST_C2_USERDATA_TYPE_ROI_RECTANGLE: {
+        GstC2QuantRegions *roiparam =
+            reinterpret_cast<GstC2QuantRegions*>(item->userdata);
+        GstC2Utils::UnpackPayload(GST_C2_PARAM_ROI_ENCODE, roiparam, c2param);
+        break;
+      }
+      case GST_C2_USERDATA_TYPE_ROI_MB_MAP: {
+        GstC2QuantMbmapInfo *mbmapinfo =
+            reinterpret_cast<GstC2QuantMbmapInfo*>(item->userdata);
+        GstC2Utils::UnpackPayload(GST_C2_PARAM_ROI_MBMAP_INFO,
+            mbmapinfo, c2param);
+        break;
+      }
+      default:
+        GST_ERROR ("Invalid userdata type '%u'!",
+            static_cast<uint32_t>(item->userdatatype));
+        return false;
+    }
+
+    settings.push_back(std::move(c2param));
+  }
+
+  try {
+    c2module_->Queue (c2buffer, settings, index, timestamp, flags);
+  } catch (std::exception& e) {
+    GST_ERROR ("Failed to queue frame, error: '%s'!", e.what());
+    return false;
+  }
+
+  return true;
+}
+
+std::unique_ptr<GstC2Backend> GstC2HwBackendNew(const char* name, uint32_t mode,
+                                                GstC2BackendListener* listener) {
+  return std::make_unique<GstC2HwBackend>(name, mode, listener);
+}
@@ -0,0 +1,1013 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "c2-engine-backend.h"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
+}
+
+#include "c2-engine-params.h"
+
+#define GST_CAT_DEFAULT ensure_debug_category()
+
+// Maximum number of frames which a decoder may hold back for reordering,
+// frames pending for longer than that produced no picture and are dropped.
+#define GST_C2_SW_MAX_REORDER_DEPTH   (16)
+
+// Maximum number of regions of interest passed to the encoder per frame.
+#define GST_C2_SW_MAX_ROI_REGIONS     (256)
+
+static GstDebugCategory *
+ensure_debug_category (void)
+{
+  static gsize catonce = 0;
+
+  if (g_once_init_enter (&catonce)) {
+    gsize catdone = (gsize) _gst_debug_category_new ("c2-engine", 0,
+        "Codec2 Engine");
+    g_once_init_leave (&catonce, catdone);
+  }
+
+  return (GstDebugCategory *) catonce;
+}
+
+enum class GstC2SwJobType {
+  kFrame,
+  kEOS,
+  kFlush,
+  kStop,
+};
+
+struct GstC2SwJob {
+  GstC2SwJobType type;
+  /// Raw input frame for encoders.
+  AVFrame        *frame;
+  /// Compressed input packet for decoders.
+  AVPacket       *packet;
+};
+
+static void
+gst_c2_sw_job_free (gpointer data)
+{
+  GstC2SwJob *job = reinterpret_cast<GstC2SwJob*>(data);
+
+  av_frame_free (&job->frame);
+  av_packet_free (&job->packet);
+
+  delete job;
+}
+
+// Software backend running the libavcodec encoders and decoders on a worker
+// thread. The frame index is used as the libavcodec timestamp, so the codec
+// reordering carries it through to the output.
+class GstC2SwBackend : public GstC2Backend {
+ public:
+  GstC2SwBackend(const char* name, uint32_t mode,
+                 GstC2BackendListener* listener);
+  ~GstC2SwBackend() override;
+
+  bool GetParameter(uint32_t type, void* payload) override;
+  bool SetParameter(uint32_t type, void* payload) override;
+
+  bool Start() override;
+  bool Stop() override;
+  bool Flush() override;
+
+  bool Queue(GstC2QueueItem* item) override;
+  bool QueueEOS() override;
+
+ private:
+  bool IsEncoder() const { return mode_ == GST_C2_MODE_VIDEO_ENCODE; }
+
+  static gpointer WorkerThread(gpointer userdata);
+
+  bool OpenContext();
+  void CloseContext();
+
+  void ConfigureEncoder();
+  AVFrame* ImportFrame(GstBuffer* buffer);
+  void AttachRegions(AVFrame* frame, GstC2QueueItem* item);
+  AVPacket* ImportPacket(GstBuffer* buffer);
+
+  bool ProcessJob(GstC2SwJob* job);
+  bool ReceiveOutput();
+  void OutputPacket(AVPacket* packet);
+  void OutputFrame(AVFrame* frame);
+
+  void DropPending(uint64_t before);
+  void DiscardJobs();
+  void ReportError(int error);
+
+  /// Component mode/type: Encode or Decode.
+  uint32_t              mode_;
+  /// Listener receiving the output buffers and events.
+  GstC2BackendListener* listener_;
+  /// Selected libavcodec encoder or decoder.
+  const AVCodec*        codec_;
+  /// Codec context, accessed only from the worker thread once started.
+  AVCodecContext*       context_;
+
+  /// Worker thread and its job queue.
+  GThread*              worker_;
+  GAsyncQueue*          jobs_;
+
+  /// Lock protecting the parameters and the pending timestamps.
+  GMutex                lock_;
+  /// Timestamps in nanoseconds of the in flight frames, keyed by frame index.
+  std::map<uint64_t, GstClockTime> timestamps_;
+
+  /// Parameters which are applied on the codec context.
+  GstVideoFormat        informat_;
+  GstVideoFormat        outformat_;
+  /// Pixel format of the encoder input frames.
+  AVPixelFormat         pixfmt_;
+  GstC2Resolution       resolution_;
+  gdouble               framerate_;
+  uint32_t              bitrate_;
+  GstC2RateControl      ratecontrol_;
+  GstC2Gop              gop_;
+  int64_t               keyframe_interval_;
+  GstC2QuantInit        qpinit_;
+  GstC2QuantRanges      qpranges_;
+  uint32_t              profile_level_;
+  /// Whether next input frame is forced to be a sync frame.
+  bool                  syncframe_;
+};
+
+GstC2SwBackend::GstC2SwBackend(const char* name, uint32_t mode,
+                               GstC2BackendListener* listener)
+    : mode_(mode), listener_(listener), codec_(nullptr), context_(nullptr),
+      worker_(nullptr), jobs_(nullptr), informat_(GST_VIDEO_FORMAT_NV12),
+      outformat_(GST_VIDEO_FORMAT_NV12), pixfmt_(AV_PIX_FMT_YUV420P),
+      resolution_(), framerate_(30.0), bitrate_(0),
+      ratecontrol_(GST_C2_RATE_CTRL_VBR_CFR),
+      gop_(), keyframe_interval_(0), qpinit_(), qpranges_(),
+      profile_level_(0), syncframe_(false) {
+
+  const char* encoder = nullptr;
+  AVCodecID id = AV_CODEC_ID_NONE;
+
+  if ((mode != GST_C2_MODE_VIDEO_ENCODE) && (mode != GST_C2_MODE_VIDEO_DECODE))
+    throw std::runtime_error("Only video is supported in software");
+
+  // Derive the codec from the component name, e.g. 'c2.qti.avc.encoder'.
+  if (g_strrstr (name, ".avc.") != NULL) {
+    id = AV_CODEC_ID_H264;
+    encoder = "libx264";
+    profile_level_ = GST_C2_PROFILE_AVC_HIGH | (GST_C2_LEVEL_AVC_4_1 << 16);
+  } else if ((g_strrstr (name, ".hevc.") != NULL) ||
+             (g_strrstr (name, ".heic.") != NULL)) {
+    id = AV_CODEC_ID_HEVC;
+    encoder = "libx265";
+    profile_level_ =
+        GST_C2_PROFILE_HEVC_MAIN | (GST_C2_LEVEL_HEVC_MAIN_4_1 << 16);
+  } else if (g_strrstr (name, ".vp8.") != NULL) {
+    id = AV_CODEC_ID_VP8;
+  } else if (g_strrstr (name, ".vp9.") != NULL) {
+    id = AV_CODEC_ID_VP9;
+  } else {
+    throw std::runtime_error(std::string("Unsupported component ") + name);
+  }
+
+  if (IsEncoder()) {
+    codec_ = (encoder != nullptr) ? avcodec_find_encoder_by_name (encoder) :
+        nullptr;
+
+    if (codec_ == nullptr)
+      codec_ = avcodec_find_encoder (id);
+  } else {
+    codec_ = avcodec_find_decoder (id);
+  }
+
+  if (codec_ == nullptr)
+    throw std::runtime_error(std::string("No libavcodec codec for ") + name);
+
+  g_mutex_init (&lock_);
+  jobs_ = g_async_queue_new_full (gst_c2_sw_job_free);
+
+  GST_INFO ("Created software backend '%s' for '%s'", codec_->name, name);
+}
+
+GstC2SwBackend::~GstC2SwBackend() {
+
+  Stop ();
+
+  g_async_queue_unref (jobs_);
+  g_mutex_clear (&lock_);
+}
+
+bool GstC2SwBackend::GetParameter(uint32_t type, void* payload) {
+
+  g_mutex_lock (&lock_);
+
+  switch (type) {
+    case GST_C2_PARAM_IN_PIXEL_FORMAT:
+      reinterpret_cast<GstC2PixelInfo*>(payload)->format = informat_;
+      reinterpret_cast<GstC2PixelInfo*>(payload)->n_subframes = 0;
+      break;
+    case GST_C2_PARAM_OUT_PIXEL_FORMAT:
+      reinterpret_cast<GstC2PixelInfo*>(payload)->format = outformat_;
+      reinterpret_cast<GstC2PixelInfo*>(payload)->n_subframes = 0;
+      break;
+    case GST_C2_PARAM_IN_RESOLUTION:
+    case GST_C2_PARAM_OUT_RESOLUTION:
+      *(reinterpret_cast<GstC2Resolution*>(payload)) = resolution_;
+      break;
+    case GST_C2_PARAM_IN_FRAMERATE:
+    case GST_C2_PARAM_OUT_FRAMERATE:
+      *(reinterpret_cast<gdouble*>(payload)) = framerate_;
+      break;
+    case GST_C2_PARAM_PROFILE_LEVEL:
+      *(reinterpret_cast<guint32*>(payload)) = profile_level_;
+      break;
+    case GST_C2_PARAM_RATE_CONTROL:
+      *(reinterpret_cast<GstC2RateControl*>(payload)) = ratecontrol_;
+      break;
+    case GST_C2_PARAM_BITRATE:
+      *(reinterpret_cast<guint32*>(payload)) = bitrate_;
+      break;
+    case GST_C2_PARAM_GOP_CONFIG:
+      *(reinterpret_cast<GstC2Gop*>(payload)) = gop_;
+      break;
+    case GST_C2_PARAM_KEY_FRAME_INTERVAL:
+      *(reinterpret_cast<gint64*>(payload)) = keyframe_interval_;
+      break;
+    case GST_C2_PARAM_QP_INIT:
+      *(reinterpret_cast<GstC2QuantInit*>(payload)) = qpinit_;
+      break;
+    case GST_C2_PARAM_QP_RANGES:
+      *(reinterpret_cast<GstC2QuantRanges*>(payload)) = qpranges_;
+      break;
+    default:
+      g_mutex_unlock (&lock_);
+      GST_ERROR ("Parameter %u is not supported in software!", type);
+      return false;
+  }
+
+  g_mutex_unlock (&lock_);
+  return true;
+}
+
+bool GstC2SwBackend::SetParameter(uint32_t type, void* payload) {
+
+  g_mutex_lock (&lock_);
+
+  switch (type) {
+    case GST_C2_PARAM_IN_PIXEL_FORMAT:
+      informat_ = reinterpret_cast<GstC2PixelInfo*>(payload)->format;
+      break;
+    case GST_C2_PARAM_OUT_PIXEL_FORMAT:
+      outformat_ = reinterpret_cast<GstC2PixelInfo*>(payload)->format;
+      break;
+    case GST_C2_PARAM_IN_RESOLUTION:
+    case GST_C2_PARAM_OUT_RESOLUTION:
+      resolution_ = *(reinterpret_cast<GstC2Resolution*>(payload));
+      break;
+    case GST_C2_PARAM_IN_FRAMERATE:
+    case GST_C2_PARAM_OUT_FRAMERATE:
+      framerate_ = *(reinterpret_cast<gdouble*>(payload));
+      break;
+    case GST_C2_PARAM_PROFILE_LEVEL:
+      profile_level_ = *(reinterpret_cast<guint32*>(payload));
+      break;
+    case GST_C2_PARAM_RATE_CONTROL:
+      ratecontrol_ = *(reinterpret_cast<GstC2RateControl*>(payload));
+      break;
+    case GST_C2_PARAM_BITRATE:
+      bitrate_ = *(reinterpret_cast<guint32*>(payload));
+      break;
+    case GST_C2_PARAM_GOP_CONFIG:
+      gop_ = *(reinterpret_cast<GstC2Gop*>(payload));
+      break;
+    case GST_C2_PARAM_KEY_FRAME_INTERVAL:
+      keyframe_interval_ = *(reinterpret_cast<gint64*>(payload));
+      break;
+    case GST_C2_PARAM_QP_INIT:
+      qpinit_ = *(reinterpret_cast<GstC2QuantInit*>(payload));
+      break;
+    case GST_C2_PARAM_QP_RANGES:
+      qpranges_ = *(reinterpret_cast<GstC2QuantRanges*>(payload));
+      break;
+    case GST_C2_PARAM_TRIGGER_SYNC_FRAME:
+      syncframe_ = *(reinterpret_cast<gboolean*>(payload));
+      break;
+    default:
+      // The remaining tunings have no libavcodec equivalent.
+      GST_DEBUG ("Ignoring parameter %u in software", type);
+      break;
+  }
+
+  g_mutex_unlock (&lock_);
+  return true;
+}
+
+bool GstC2SwBackend::Start() {
+
+  if (worker_ != nullptr)
+    return true;
+
+  if (!OpenContext ())
+    return false;
+
+  worker_ = g_thread_new ("C2SwBackend", WorkerThread, this);
+  return true;
+}
+
+bool GstC2SwBackend::Stop() {
+
+  if (worker_ == nullptr)
+    return true;
+
+  DiscardJobs ();
+
+  GstC2SwJob *job = new GstC2SwJob { GstC2SwJobType::kStop, nullptr, nullptr };
+  g_async_queue_push (jobs_, job);
+
+  g_thread_join (worker_);
+  worker_ = nullptr;
+
+  CloseContext ();
+
+  // Frames still inside the codec will never be output.
+  DropPending (G_MAXUINT64);
+  return true;
+}
+
+bool GstC2SwBackend::Flush() {
+
+  if (worker_ == nullptr)
+    return true;
+
+  DiscardJobs ();
+
+  GstC2SwJob *job = new GstC2SwJob { GstC2SwJobType::kFlush, nullptr, nullptr };
+  g_async_queue_push (jobs_, job);
+
+  return true;
+}
+
+bool GstC2SwBackend::Queue(GstC2QueueItem* item) {
+
+  GstBuffer *buffer = item->buffer;
+  GstC2SwJob *job = nullptr;
+  GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+
+  if (worker_ == nullptr) {
+    GST_ERROR ("Software backend is not started!");
+    return false;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (GST_BUFFER_DTS (buffer)))
+    timestamp = GST_BUFFER_DTS (buffer);
+  else if (GST_CLOCK_TIME_IS_VALID (GST_BUFFER_PTS (buffer)))
+    timestamp = GST_BUFFER_PTS (buffer);
+
+  job = new GstC2SwJob { GstC2SwJobType::kFrame, nullptr, nullptr };
+
+  if (IsEncoder ()) {
+    if ((job->frame = ImportFrame (buffer)) == nullptr) {
+      gst_c2_sw_job_free (job);
+      return false;
+    }
+
+    job->frame->pts = item->index;
+    AttachRegions (job->frame, item);
+
+    g_mutex_lock (&lock_);
+
+    if (syncframe_) {
+      job->frame->pict_type = AV_PICTURE_TYPE_I;
+      syncframe_ = false;
+    }
+
+    g_mutex_unlock (&lock_);
+  } else {
+    if ((job->packet = ImportPacket (buffer)) == nullptr) {
+      gst_c2_sw_job_free (job);
+      return false;
+    }
+
+    job->packet->pts = item->index;
+    job->packet->dts = item->index;
+  }
+
+  g_mutex_lock (&lock_);
+  timestamps_[item->index] = timestamp;
+  g_mutex_unlock (&lock_);
+
+  g_async_queue_push (jobs_, job);
+  return true;
+}
+
+bool GstC2SwBackend::QueueEOS() {
+
+  if (worker_ == nullptr) {
+    GST_ERROR ("Software backend is not started!");
+    return false;
+  }
+
+  GstC2SwJob *job = new GstC2SwJob { GstC2SwJobType::kEOS, nullptr, nullptr };
+  g_async_queue_push (jobs_, job);
+
+  return true;
+}
+
+gpointer GstC2SwBackend::WorkerThread(gpointer userdata) {
+
+  GstC2SwBackend *backend = reinterpret_cast<GstC2SwBackend*>(userdata);
+  bool active = true;
+
+  while (active) {
+    GstC2SwJob *job =
+        reinterpret_cast<GstC2SwJob*>(g_async_queue_pop (backend->jobs_));
+
+    active = backend->ProcessJob (job);
+    gst_c2_sw_job_free (job);
+  }
+
+  return NULL;
+}
+
+bool GstC2SwBackend::OpenContext() {
+
+  if ((context_ = avcodec_alloc_context3 (codec_)) == nullptr) {
+    GST_ERROR ("Failed to allocate codec context!");
+    return false;
+  }
+
+  // Let libavcodec pick the number of threads.
+  context_->thread_count = 0;
+
+  if (IsEncoder ())
+    ConfigureEncoder ();
+
+  gint error = avcodec_open2 (context_, codec_, NULL);
+
+  if (error < 0) {
+    GST_ERROR ("Failed to open '%s', error: %d!", codec_->name, error);
+    avcodec_free_context (&context_);
+    return false;
+  }
+
+  GST_DEBUG ("Opened '%s' %dx%d", codec_->name, context_->width,
+      context_->height);
+  return true;
+}
+
+void GstC2SwBackend::CloseContext() {
+
+  avcodec_free_context (&context_);
+}
+
+void GstC2SwBackend::ConfigureEncoder() {
+
+  AVPixelFormat format = AV_PIX_FMT_YUV420P;
+  const gchar *profile = NULL;
+
+  g_mutex_lock (&lock_);
+
+  // Feed NV12 directly when supported, otherwise it is deinterleaved.
+  if ((informat_ == GST_VIDEO_FORMAT_NV12) && (codec_->pix_fmts != nullptr)) {
+    for (const AVPixelFormat* fmt = codec_->pix_fmts; *fmt != -1; fmt++) {
+      if (*fmt == AV_PIX_FMT_NV12)
+        format = AV_PIX_FMT_NV12;
+    }
+  }
+
+  pixfmt_ = format;
+  context_->pix_fmt = format;
+  context_->width = resolution_.width;
+  context_->height = resolution_.height;
+  context_->framerate = av_d2q (framerate_, 100000);
+  context_->time_base = av_inv_q (context_->framerate);
+
+  if (bitrate_ != 0)
+    context_->bit_rate = bitrate_;
+
+  switch (ratecontrol_) {
+    case GST_C2_RATE_CTRL_CONSTANT:
+    case GST_C2_RATE_CTRL_CBR_VFR:
+      context_->rc_max_rate = context_->bit_rate;
+      context_->rc_min_rate = context_->bit_rate;
+      context_->rc_buffer_size = context_->bit_rate;
+      break;
+    case GST_C2_RATE_CTRL_DISABLE:
+      if (qpinit_.p_frames_enable)
+        av_opt_set_int (context_->priv_data, "qp", qpinit_.p_frames, 0);
+      break;
+    case GST_C2_RATE_CTRL_CQ:
+      av_opt_set_int (context_->priv_data, "crf", 23, 0);
+      break;
+    default:
+      break;
+  }
+
+  if (gop_.n_pframes != 0 || gop_.n_bframes != 0) {
+    context_->max_b_frames = gop_.n_bframes;
+    context_->gop_size = (gop_.n_pframes + 1) * (gop_.n_bframes + 1);
+  }
+
+  // Key frame interval has precedence over the GOP configuration.
+  if (keyframe_interval_ > 0)
+    context_->gop_size =
+        MAX (1, (gint) ((keyframe_interval_ * framerate_) / G_USEC_PER_SEC));
+
+  if ((qpranges_.min_p_qp != 0) || (qpranges_.max_p_qp != 0)) {
+    context_->qmin = qpranges_.min_p_qp;
+    context_->qmax = qpranges_.max_p_qp;
+  }
+
+  switch (profile_level_ & 0xFFFF) {
+    case GST_C2_PROFILE_AVC_BASELINE:
+    case GST_C2_PROFILE_AVC_CONSTRAINED_BASELINE:
+      profile = "baseline";
+      break;
+    case GST_C2_PROFILE_AVC_MAIN:
+      profile = "main";
+      break;
+    case GST_C2_PROFILE_AVC_HIGH:
+    case GST_C2_PROFILE_AVC_CONSTRAINED_HIGH:
+      profile = "high";
+      break;
+    case GST_C2_PROFILE_HEVC_MAIN:
+      profile = "main";
+      break;
+    default:
+      break;
+  }
+
+  if (profile != NULL)
+    av_opt_set (context_->priv_data, "profile", profile, 0);
+
+  if (codec_->id == AV_CODEC_ID_H264) {
+    const gchar *level =
+        gst_c2_utils_h264_level_to_string (profile_level_ >> 16);
+
+    // Level is stored as 10 times the level number, e.g. 41 for '4.1'.
+    if (level != NULL && g_ascii_isdigit (level[0]))
+      context_->level = (gint) (g_ascii_strtod (level, NULL) * 10 + 0.5);
+  }
+
+  g_mutex_unlock (&lock_);
+
+  // Encoders are used for live capture, favour speed and latency.
+  av_opt_set (context_->priv_data, "preset", "veryfast", 0);
+}
+
+AVFrame* GstC2SwBackend::ImportFrame(GstBuffer* buffer) {
+
+  GstVideoMeta *vmeta = gst_buffer_get_video_meta (buffer);
+  GstVideoInfo info;
+  GstVideoFrame vframe;
+  AVFrame *frame = nullptr;
+  guint idx = 0;
+
+  g_return_val_if_fail (vmeta != NULL, nullptr);
+
+  if ((vmeta->format != GST_VIDEO_FORMAT_NV12) &&
+      (vmeta->format != GST_VIDEO_FORMAT_I420)) {
+    GST_ERROR ("Unsupported input format %s in software!",
+        gst_video_format_to_string (vmeta->format));
+    return nullptr;
+  }
+
+  gst_video_info_set_format (&info, vmeta->format, vmeta->width, vmeta->height);
+
+  for (idx = 0; idx < vmeta->n_planes; idx++) {
+    GST_VIDEO_INFO_PLANE_OFFSET (&info, idx) = vmeta->offset[idx];
+    GST_VIDEO_INFO_PLANE_STRIDE (&info, idx) = vmeta->stride[idx];
+  }
+
+  if (!gst_video_frame_map (&vframe, &info, buffer, GST_MAP_READ)) {
+    GST_ERROR ("Failed to map input buffer!");
+    return nullptr;
+  }
+
+  frame = av_frame_alloc ();
+
+  g_mutex_lock (&lock_);
+  frame->format = pixfmt_;
+  g_mutex_unlock (&lock_);
+
+  frame->width = vmeta->width;
+  frame->height = vmeta->height;
+
+  if (av_frame_get_buffer (frame, 0) < 0) {
+    GST_ERROR ("Failed to allocate input frame!");
+    gst_video_frame_unmap (&vframe);
+    av_frame_free (&frame);
+    return nullptr;
+  }
+
+  // Copy the luma plane, chroma is copied as is or (de)interleaved.
+  av_image_copy_plane (frame->data[0], frame->linesize[0],
+      (const uint8_t *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0),
+      GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0), frame->width, frame->height);
+
+  gint width = (frame->width + 1) / 2, height = (frame->height + 1) / 2;
+  gboolean nv12 = (vmeta->format == GST_VIDEO_FORMAT_NV12);
+
+  if (nv12 && (frame->format == AV_PIX_FMT_NV12)) {
+    av_image_copy_plane (frame->data[1], frame->linesize[1],
+        (const uint8_t *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 1),
+        GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 1), width * 2, height);
+  } else if (!nv12 && (frame->format == AV_PIX_FMT_YUV420P)) {
+    for (idx = 1; idx < 3; idx++)
+      av_image_copy_plane (frame->data[idx], frame->linesize[idx],
+          (const uint8_t *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, idx),
+          GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, idx), width, height);
+  } else if (nv12) {
+    for (gint row = 0; row < height; row++) {
+      const guint8 *uv = (const guint8 *)
+          GST_VIDEO_FRAME_PLANE_DATA (&vframe, 1) +
+          row * GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 1);
+      guint8 *u = frame->data[1] + row * frame->linesize[1];
+      guint8 *v = frame->data[2] + row * frame->linesize[2];
+
+      for (gint col = 0; col < width; col++) {
+        u[col] = uv[col * 2];
+        v[col] = uv[col * 2 + 1];
+      }
+    }
+  } else {
+    for (gint row = 0; row < height; row++) {
+      const guint8 *u = (const guint8 *)
+          GST_VIDEO_FRAME_PLANE_DATA (&vframe, 1) +
+          row * GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 1);
+      const guint8 *v = (const guint8 *)
+          GST_VIDEO_FRAME_PLANE_DATA (&vframe, 2) +
+          row * GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 2);
+      guint8 *uv = frame->data[1] + row * frame->linesize[1];
+
+      for (gint col = 0; col < width; col++) {
+        uv[col * 2] = u[col];
+        uv[col * 2 + 1] = v[col];
+      }
+    }
+  }
+
+  gst_video_frame_unmap (&vframe);
+  return frame;
+}
+
+void GstC2SwBackend::AttachRegions(AVFrame* frame, GstC2QueueItem* item) {
+
+  AVRegionOfInterest regions[GST_C2_SW_MAX_ROI_REGIONS];
+  guint n_regions = 0;
+
+  if (item->userdata == NULL)
+    return;
+
+  if (item->userdatatype == GST_C2_USERDATA_TYPE_ROI_RECTANGLE) {
+    GstC2QuantRegions *roi =
+        reinterpret_cast<GstC2QuantRegions*>(item->userdata);
+
+    for (guint idx = 0; idx < roi->n_rects; idx++) {
+      GstC2QuantRectangle *rect = &roi->rects[idx];
+      AVRegionOfInterest *region = &regions[n_regions++];
+
+      region->self_size = sizeof (AVRegionOfInterest);
+      region->left = rect->x;
+      region->top = rect->y;
+      region->right = rect->x + rect->w;
+      region->bottom = rect->y + rect->h;
+      // Offset is relative to the QP range, negative values improve quality.
+      region->qoffset = av_make_q (CLAMP (rect->qp, -51, 51), 51);
+    }
+  } else if (item->userdatatype == GST_C2_USERDATA_TYPE_ROI_MB_MAP) {
+    GstC2QuantMbmapInfo *mbmap =
+        reinterpret_cast<GstC2QuantMbmapInfo*>(item->userdata);
+    guint side = mbmap->mb_side_length;
+
+    if (!mbmap->enable || (side == 0) || (mbmap->qp_bias_map == NULL))
+      return;
+
+    guint n_columns = (frame->width + side - 1) / side;
+    guint n_mbs = MIN (mbmap->total_mbs, mbmap->qp_bias_map->len);
+
+    // Merge horizontal runs of macroblocks with the same bias into regions.
+    for (guint idx = 0; idx < n_mbs; ) {
+      gint8 bias = g_array_index (mbmap->qp_bias_map, gint8, idx);
+      guint start = idx;
+
+      while ((++idx < n_mbs) && ((idx % n_columns) != 0) &&
+          (g_array_index (mbmap->qp_bias_map, gint8, idx) == bias));
+
+      if ((bias == 0) || (n_regions == GST_C2_SW_MAX_ROI_REGIONS))
+        continue;
+
+      AVRegionOfInterest *region = &regions[n_regions++];
+
+      region->self_size = sizeof (AVRegionOfInterest);
+      region->left = (start % n_columns) * side;
+      region->right = region->left + (idx - start) * side;
+      region->top = (start / n_columns) * side;
+      region->bottom = region->top + side;
+      region->qoffset = av_make_q (CLAMP (bias, -51, 51), 51);
+    }
+  }
+
+  if (n_regions == 0)
+    return;
+
+  AVFrameSideData *sidedata = av_frame_new_side_data (frame,
+      AV_FRAME_DATA_REGIONS_OF_INTEREST, n_regions * sizeof (*regions));
+
+  if (sidedata != NULL)
+    memcpy (sidedata->data, regions, n_regions * sizeof (*regions));
+}
+
+AVPacket* GstC2SwBackend::ImportPacket(GstBuffer* buffer) {
+
+  AVPacket *packet = av_packet_alloc ();
+  GstMapInfo map;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_ERROR ("Failed to map input buffer!");
+    av_packet_free (&packet);
+    return nullptr;
+  }
+
+  if (av_new_packet (packet, map.size) < 0) {
+    GST_ERROR ("Failed to allocate input packet!");
+    gst_buffer_unmap (buffer, &map);
+    av_packet_free (&packet);
+    return nullptr;
+  }
+
+  memcpy (packet->data, map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+
+  return packet;
+}
+
+bool GstC2SwBackend::ProcessJob(GstC2SwJob* job) {
+
+  gint error = 0;
+
+  switch (job->type) {
+    case GstC2SwJobType::kFrame:
+      error = IsEncoder () ? avcodec_send_frame (context_, job->frame) :
+          avcodec_send_packet (context_, job->packet);
+
+      if (error < 0) {
+        ReportError (error);
+        return true;
+      }
+
+      ReceiveOutput ();
+      return true;
+    case GstC2SwJobType::kEOS:
+      error = IsEncoder () ? avcodec_send_frame (context_, NULL) :
+          avcodec_send_packet (context_, NULL);
+
+      if ((error < 0) && (error != AVERROR_EOF)) {
+        ReportError (error);
+        return true;
+      }
+
+      ReceiveOutput ();
+
+      DropPending (G_MAXUINT64);
+
+      // Codec context can't be used after draining, reopen it.
+      CloseContext ();
+
+      if (!OpenContext ()) {
+        ReportError (AVERROR_UNKNOWN);
+        return true;
+      }
+
+      listener_->EventAvailable (GST_C2_EVENT_EOS, NULL);
+      return true;
+    case GstC2SwJobType::kFlush:
+      CloseContext ();
+
+      if (!OpenContext ())
+        ReportError (AVERROR_UNKNOWN);
+
+      DropPending (G_MAXUINT64);
+      return true;
+    case GstC2SwJobType::kStop:
+      return false;
+  }
+
+  return true;
+}
+
+bool GstC2SwBackend::ReceiveOutput() {
+
+  gint error = 0;
+
+  if (IsEncoder ()) {
+    AVPacket *packet = av_packet_alloc ();
+
+    while ((error = avcodec_receive_packet (context_, packet)) == 0) {
+      OutputPacket (packet);
+      av_packet_unref (packet);
+    }
+
+    av_packet_free (&packet);
+  } else {
+    AVFrame *frame = av_frame_alloc ();
+
+    while ((error = avcodec_receive_frame (context_, frame)) == 0) {
+      OutputFrame (frame);
+      av_frame_unref (frame);
+    }
+
+    av_frame_free (&frame);
+  }
+
+  if ((error < 0) && (error != AVERROR(EAGAIN)) && (error != AVERROR_EOF))
+    ReportError (error);
+
+  return error != AVERROR_EOF;
+}
+
+void GstC2SwBackend::OutputPacket(AVPacket* packet) {
+
+  GstBuffer *buffer = NULL;
+  GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+  uint64_t index = packet->pts;
+
+  g_mutex_lock (&lock_);
+
+  auto it = timestamps_.find (index);
+
+  if (it != timestamps_.end ()) {
+    timestamp = it->second;
+    timestamps_.erase (it);
+  }
+
+  g_mutex_unlock (&lock_);
+
+  buffer = gst_buffer_new_allocate (NULL, packet->size, NULL);
+  gst_buffer_fill (buffer, 0, packet->data, packet->size);
+
+  if (packet->flags & AV_PKT_FLAG_KEY)
+    GST_BUFFER_FLAG_SET (buffer, GST_VIDEO_BUFFER_FLAG_SYNC);
+
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_MARKER);
+
+  GST_BUFFER_OFFSET (buffer) = index;
+  GST_BUFFER_TIMESTAMP (buffer) = timestamp;
+
+  GST_TRACE ("Available %" GST_PTR_FORMAT, buffer);
+  listener_->BufferAvailable (buffer, true);
+}
+
+void GstC2SwBackend::OutputFrame(AVFrame* frame) {
+
+  GstBuffer *buffer = NULL;
+  GstVideoInfo info;
+  GstVideoFrame vframe;
+  GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+  uint64_t index = frame->best_effort_timestamp;
+  GstVideoFormat format = GST_VIDEO_FORMAT_UNKNOWN;
+  gint width = (frame->width + 1) / 2, height = (frame->height + 1) / 2;
+
+  g_mutex_lock (&lock_);
+
+  auto it = timestamps_.find (index);
+
+  if (it != timestamps_.end ()) {
+    timestamp = it->second;
+    timestamps_.erase (it);
+  }
+
+  format = outformat_;
+  g_mutex_unlock (&lock_);
+
+  if ((frame->format != AV_PIX_FMT_YUV420P) &&
+      (frame->format != AV_PIX_FMT_YUVJ420P)) {
+    GST_ERROR ("Unsupported decoded format %d in software!", frame->format);
+    ReportError (AVERROR_PATCHWELCOME);
+    return;
+  }
+
+  if (format != GST_VIDEO_FORMAT_I420)
+    format = GST_VIDEO_FORMAT_NV12;
+
+  gst_video_info_set_format (&info, format, frame->width, frame->height);
+
+  buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&info), NULL);
+
+  gst_buffer_add_video_meta_full (buffer, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_INFO_FORMAT (&info), GST_VIDEO_INFO_WIDTH (&info),
+      GST_VIDEO_INFO_HEIGHT (&info), GST_VIDEO_INFO_N_PLANES (&info),
+      info.offset, info.stride);
+
+  gst_video_frame_map (&vframe, &info, buffer, GST_MAP_WRITE);
+
+  av_image_copy_plane ((uint8_t *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0),
+      GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0), frame->data[0],
+      frame->linesize[0], frame->width, frame->height);
+
+  if (format == GST_VIDEO_FORMAT_I420) {
+    for (guint idx = 1; idx < 3; idx++)
+      av_image_copy_plane (
+          (uint8_t *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, idx),
+          GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, idx), frame->data[idx],
+          frame->linesize[idx], width, height);
+  } else {
+    for (gint row = 0; row < height; row++) {
+      guint8 *uv = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 1) +
+          row * GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 1);
+      const guint8 *u = frame->data[1] + row * frame->linesize[1];
+      const guint8 *v = frame->data[2] + row * frame->linesize[2];
+
+      for (gint col = 0; col < width; col++) {
+        uv[col * 2] = u[col];
+        uv[col * 2 + 1] = v[col];
+      }
+    }
+  }
+
+  gst_video_frame_unmap (&vframe);
+
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_MARKER);
+
+  GST_BUFFER_OFFSET (buffer) = index;
+  GST_BUFFER_TIMESTAMP (buffer) = timestamp;
+
+  GST_TRACE ("Available %" GST_PTR_FORMAT, buffer);
+  listener_->BufferAvailable (buffer, true);
+
+  // Input packets without picture data (e.g. parameter sets only) never
+  // produce a frame, release them once they fall behind the reorder window.
+  if (index > GST_C2_SW_MAX_REORDER_DEPTH)
+    DropPending (index - GST_C2_SW_MAX_REORDER_DEPTH);
+}
+
+void GstC2SwBackend::DropPending(uint64_t before) {
+
+  while (true) {
+    uint64_t index = 0;
+
+    g_mutex_lock (&lock_);
+
+    if (timestamps_.empty () || (timestamps_.begin ()->first >= before)) {
+      g_mutex_unlock (&lock_);
+      break;
+    }
+
+    index = timestamps_.begin ()->first;
+    timestamps_.erase (timestamps_.begin ());
+
+    g_mutex_unlock (&lock_);
+
+    GST_DEBUG ("Dropping frame %" G_GUINT64_FORMAT, index);
+    listener_->EventAvailable (GST_C2_EVENT_DROP, &index);
+  }
+}
+
+void GstC2SwBackend::DiscardJobs() {
+
+  GstC2SwJob *job = nullptr;
+
+  // Frames which haven't reached the codec are reported as dropped.
+  while ((job = reinterpret_cast<GstC2SwJob*>(
+      g_async_queue_try_pop (jobs_))) != nullptr) {
+
+    if (job->type == GstC2SwJobType::kFrame) {
+      uint64_t index = (job->frame != nullptr) ? job->frame->pts :
+          job->packet->pts;
+
+      g_mutex_lock (&lock_);
+      timestamps_.erase (index);
+      g_mutex_unlock (&lock_);
+
+      listener_->EventAvailable (GST_C2_EVENT_DROP, &index);
+    } else if (job->type == GstC2SwJobType::kEOS) {
+      listener_->EventAvailable (GST_C2_EVENT_EOS, NULL);
+    }
+
+    gst_c2_sw_job_free (job);
+  }
+}
+
+void GstC2SwBackend::ReportError(int error) {
+
+  gchar string[AV_ERROR_MAX_STRING_SIZE] = { 0, };
+  guint32 code = -error;
+
+  av_strerror (error, string, sizeof (string));
+  GST_ERROR ("Codec '%s' failed, error: '%s'!", codec_->name, string);
+
+  listener_->EventAvailable (GST_C2_EVENT_ERROR, &code);
+}
+
+std::unique_ptr<GstC2Backend> GstC2SwBackendNew(const char* name, uint32_t mode,
+                                                GstC2BackendListener* listener) {
+  return std::make_unique<GstC2SwBackend>(name, mode, listener);
+}
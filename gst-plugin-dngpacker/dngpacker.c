@@ -17,6 +17,37 @@ GST_DEBUG_CATEGORY (gst_dngpacker_debug);
 #define gst_dngpacker_parent_class parent_class
 G_DEFINE_TYPE (GstDngPacker, gst_dngpacker, GST_TYPE_ELEMENT);
 
+#define DEFAULT_PROP_THREADS      0
+#define DEFAULT_PROP_WORKERS      2
+#define DEFAULT_PROP_MAX_MEMORY   0
+
+#define DEFAULT_MIN_BUFFERS       2
+#define DEFAULT_MAX_BUFFERS       0
+
+enum
+{
+  PROP_0,
+  PROP_THREADS,
+  PROP_WORKERS,
+  PROP_MAX_MEMORY,
+};
+
+typedef struct _GstDngPackerJob GstDngPackerJob;
+
+struct _GstDngPackerJob {
+  GstDngPacker   *packer;
+
+  // RAW and optional JPEG thumbnail buffers together with their mappings.
+  GstBuffer      *rawbuf;
+  GstMapInfo     rawmap;
+  gboolean       rawmapped;
+
+  GstBuffer      *imgbuf;
+  GstMapInfo     imgmap;
+
+  DngPackRequest request;
+};
+
 #define GST_DNGPACKER_MISMATCH_CHECK(ele, buf, set) do {                    \
   if (buf != set)                                                           \
     GST_WARNING_OBJECT (ele,                                                \
@@ -88,6 +119,31 @@ gst_data_queue_free_item (gpointer userdata)
   g_slice_free (GstDataQueueItem, item);
 }
 
+// RAW queue item, buffers dropped before reaching a job are accounted here.
+typedef struct _GstDngPackerRawItem {
+  GstDataQueueItem item;
+  GstDngPacker     *packer;
+} GstDngPackerRawItem;
+
+static void
+gst_dngpacker_raw_item_free (gpointer userdata)
+{
+  GstDngPackerRawItem *rawitem = userdata;
+  GstDngPacker *packer = rawitem->packer;
+
+  if (rawitem->item.object != NULL) {
+    gst_buffer_unref (GST_BUFFER (rawitem->item.object));
+
+    GST_DNGPACKER_LOCK (packer);
+    packer->process_buf_num--;
+    if (packer->process_buf_num == 0)
+      g_cond_signal (&packer->cond_buf_idle);
+    GST_DNGPACKER_UNLOCK (packer);
+  }
+
+  g_slice_free (GstDngPackerRawItem, rawitem);
+}
+
 static gboolean
 queue_is_full_cb (GstDataQueue * queue, guint visible, guint bytes,
     guint64 time, gpointer checkdata)
@@ -188,112 +244,240 @@ gst_dngpacker_update_packer_request (GstDngPacker *packer, GstVideoMeta *meta,
   }
 }
 
+static GstBuffer *
+gst_dngpacker_acquire_output_buffer (GstDngPacker * packer, gsize size)
+{
+  GstStructure *config = NULL;
+  GstBuffer *buffer = NULL;
+  guint poolsize = 0;
+
+  if (packer->outpool != NULL) {
+    config = gst_buffer_pool_get_config (packer->outpool);
+    gst_buffer_pool_config_get_params (config, NULL, &poolsize, NULL, NULL);
+    gst_structure_free (config);
+  }
+
+  // (Re)create the pool when the DNG no longer fits, e.g. bigger thumbnail.
+  if (poolsize < size) {
+    if (packer->outpool != NULL) {
+      gst_buffer_pool_set_active (packer->outpool, FALSE);
+      gst_clear_object (&packer->outpool);
+    }
+
+    // Leave some headroom for the variable size of the JPEG thumbnail.
+    poolsize = size + (size / 16);
+
+    packer->outpool = gst_buffer_pool_new ();
+
+    config = gst_buffer_pool_get_config (packer->outpool);
+    gst_buffer_pool_config_set_params (config, NULL, poolsize,
+        DEFAULT_MIN_BUFFERS, DEFAULT_MAX_BUFFERS);
+
+    if (!gst_buffer_pool_set_config (packer->outpool, config) ||
+        !gst_buffer_pool_set_active (packer->outpool, TRUE)) {
+      GST_WARNING_OBJECT (packer, "Failed to setup output buffer pool!");
+      gst_clear_object (&packer->outpool);
+      return NULL;
+    }
+
+    GST_DEBUG_OBJECT (packer, "Created output pool with %u bytes buffers",
+        poolsize);
+  }
+
+  if (gst_buffer_pool_acquire_buffer (packer->outpool, &buffer, NULL) !=
+          GST_FLOW_OK) {
+    GST_WARNING_OBJECT (packer, "Failed to acquire output buffer!");
+    return NULL;
+  }
+
+  return buffer;
+}
+
+static void
+gst_dngpacker_job_free (gpointer data)
+{
+  GstDngPackerJob *job = (GstDngPackerJob *) data;
+  GstDngPacker *packer = job->packer;
+
+  if (job->imgbuf != NULL) {
+    gst_buffer_unmap (job->imgbuf, &job->imgmap);
+    gst_buffer_unref (job->imgbuf);
+  }
+
+  if (job->rawbuf != NULL) {
+    if (job->rawmapped)
+      gst_buffer_unmap (job->rawbuf, &job->rawmap);
+
+    gst_buffer_unref (job->rawbuf);
+  }
+
+  g_slice_free (GstDngPackerJob, job);
+
+  GST_DNGPACKER_LOCK (packer);
+  packer->process_buf_num--;
+  if (packer->process_buf_num == 0)
+    g_cond_signal (&packer->cond_buf_idle);
+  GST_DNGPACKER_UNLOCK (packer);
+}
+
+static GstBuffer *
+gst_dngpacker_process_job (gpointer data, gpointer userdata)
+{
+  GstDngPacker *packer = GST_DNGPACKER (userdata);
+  GstDngPackerJob *job = (GstDngPackerJob *) data;
+  DngPackRequest *request = &job->request;
+  GstBuffer *out_buf = NULL;
+  GstMapInfo out_map_info;
+  GstClockTime time = GST_CLOCK_TIME_NONE;
+  int dng_ret = 0;
+
+  request->output = NULL;
+  request->output_capacity = 0;
+  request->output_size = 0;
+
+  // Write the DNG directly into a pooled buffer sized for the worst case.
+  GST_DNGPACKER_LOCK (packer);
+  out_buf = gst_dngpacker_acquire_output_buffer (packer,
+      dngpacker_utils_get_output_size (request->raw_width, request->raw_height,
+          request->jpg_size));
+  GST_DNGPACKER_UNLOCK (packer);
+
+  if ((out_buf != NULL) &&
+      !gst_buffer_map (out_buf, &out_map_info, GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (packer, "Failed to map output buffer!");
+    gst_clear_buffer (&out_buf);
+  }
+
+  if (out_buf != NULL) {
+    request->output = out_map_info.data;
+    request->output_capacity = out_map_info.size;
+  }
+
+  // Get start time for performance measurements.
+  time = gst_util_get_timestamp ();
+
+  dng_ret = dngpacker_utils_pack_dng (packer->packer_utils, request);
+
+  if (out_buf != NULL)
+    gst_buffer_unmap (out_buf, &out_map_info);
+
+  // The DNG did not fit in the pooled buffer and was moved into memory
+  // allocated by the packer, which is wrapped below instead.
+  if ((dng_ret == 0) && (out_buf != NULL) &&
+      (request->output != out_map_info.data)) {
+    GST_WARNING_OBJECT (packer, "DNG of %" G_GSIZE_FORMAT " bytes exceeded "
+        "output buffer of %" G_GSIZE_FORMAT " bytes!", request->output_size,
+        request->output_capacity);
+    gst_clear_buffer (&out_buf);
+  }
+
+  if (dng_ret != 0) {
+    if (out_buf != NULL)
+      gst_buffer_unref (out_buf);
+
+    g_log("GstDngPacker", G_LOG_LEVEL_WARNING,
+        "Dng generation failed, please check log for details\n");
+    return NULL;
+  }
+
+  // Get time difference between current time and start.
+  time = GST_CLOCK_DIFF (time, gst_util_get_timestamp ());
+
+  GST_LOG_OBJECT (packer, "Dng Pack Done, consuming %" G_GINT64_FORMAT ".%03"
+      G_GINT64_FORMAT " ms", GST_TIME_AS_MSECONDS (time),
+      (GST_TIME_AS_USECONDS (time) % 1000));
+
+  // Fall back to the memory allocated by the packer if there was no pool.
+  if (out_buf == NULL)
+    out_buf = gst_buffer_new_wrapped (request->output, request->output_size);
+  else
+    gst_buffer_set_size (out_buf, request->output_size);
+
+  return out_buf;
+}
+
+static void
+gst_dngpacker_push_output (GstBuffer * buffer, gpointer userdata)
+{
+  GstDngPacker *packer = GST_DNGPACKER (userdata);
+
+  gst_pad_push (packer->dng_src_pad, buffer);
+}
+
 static void
 gst_dngpacker_task (gpointer userdata)
 {
   GstDngPacker *packer = GST_DNGPACKER (userdata);
   GstDataQueueItem *raw_item, *image_item;
-  GstBuffer *raw_buf, *img_buf, *out_buf;
+  GstDngPackerJob *job = NULL;
   guint8 *image_data = NULL;
   gsize image_data_size = 0;
-  GstMapInfo raw_map_info, image_map_info;
   GstVideoMeta *vmeta;
-  DngPackRequest request;
-  GstClockTime time = GST_CLOCK_TIME_NONE;
-  int dng_ret = 0;
 
   raw_item = image_item = NULL;
-  raw_buf = img_buf = NULL;
 
   // if raw buffer queue is under flushing, return directly
-  if (!gst_data_queue_peek (packer->raw_buf_queue, &raw_item))
+  if (!gst_data_queue_pop (packer->raw_buf_queue, &raw_item))
       return;
 
-  raw_buf = GST_BUFFER (raw_item->object);
-  vmeta = gst_buffer_get_video_meta (raw_buf);
+  // take over the raw buffer, the job is freed once the DNG is pushed
+  job = g_slice_new0 (GstDngPackerJob);
+  job->packer = packer;
+  job->rawbuf = GST_BUFFER (raw_item->object);
+
+  raw_item->object = NULL;
+  raw_item->destroy (raw_item);
+
+  vmeta = gst_buffer_get_video_meta (job->rawbuf);
 
   if (vmeta)
     GST_DEBUG_OBJECT (packer, "format=%d flags=%x width=%d height=%d "
         "n_planes=%d stride[0]=%d", vmeta->format, vmeta->flags, vmeta->width,
         vmeta->height, vmeta->n_planes, vmeta->stride[0]);
 
-  if (!gst_buffer_map (raw_buf, &raw_map_info, GST_MAP_READ)) {
+  if (!gst_buffer_map (job->rawbuf, &job->rawmap, GST_MAP_READ)) {
     GST_ERROR_OBJECT (packer, "gst raw buffer map failed");
-    goto free_raw_item;
+    gst_dngpacker_job_free (job);
+    return;
   }
 
+  job->rawmapped = TRUE;
+
   GST_DEBUG_OBJECT (packer, "mapped raw buffer:data(%zu) size=%ld",
-      (size_t) raw_map_info.data, raw_map_info.size);
+      (size_t) job->rawmap.data, job->rawmap.size);
 
   if (packer->img_sink_pad) {
-    if (gst_data_queue_peek (packer->image_buf_queue, &image_item)) {
-      img_buf = GST_BUFFER (image_item->object);
+    if (gst_data_queue_pop (packer->image_buf_queue, &image_item)) {
+      job->imgbuf = GST_BUFFER (image_item->object);
 
-      if (!gst_buffer_map (img_buf, &image_map_info, GST_MAP_READ)) {
-        GST_ERROR_OBJECT (packer, "gst image buffer map failed");
-
-        if (gst_data_queue_pop (packer->image_buf_queue, &image_item))
-          image_item->destroy (image_item);
+      image_item->object = NULL;
+      image_item->destroy (image_item);
 
-        img_buf = NULL;
-        image_data = NULL;
-        image_data_size = 0;
+      if (!gst_buffer_map (job->imgbuf, &job->imgmap, GST_MAP_READ)) {
+        GST_ERROR_OBJECT (packer, "gst image buffer map failed");
+        gst_clear_buffer (&job->imgbuf);
       } else {
         GST_DEBUG_OBJECT (packer, "mapped image buffer:data(%zu) size=%ld",
-            (size_t) image_map_info.data, image_map_info.size);
+            (size_t) job->imgmap.data, job->imgmap.size);
 
-        image_data = image_map_info.data;
-        image_data_size = image_map_info.size;
+        image_data = job->imgmap.data;
+        image_data_size = job->imgmap.size;
       }
     } else {
-      goto unmap_raw_buf;
+      gst_dngpacker_job_free (job);
+      return;
     }
   }
 
-  gst_dngpacker_update_packer_request (packer, vmeta, raw_map_info.size,
-      raw_map_info.data, image_data_size, image_data, &request);
-
-  // Get start time for performance measurements.
-  time = gst_util_get_timestamp ();
-
-  dng_ret = dngpacker_utils_pack_dng (packer->packer_utils, &request);
-
-  if (dng_ret == 0) {
-
-    // Get time difference between current time and start.
-    time = GST_CLOCK_DIFF (time, gst_util_get_timestamp ());
+  gst_dngpacker_update_packer_request (packer, vmeta, job->rawmap.size,
+      job->rawmap.data, image_data_size, image_data, &job->request);
 
-    GST_LOG_OBJECT (packer, "Dng Pack Done, consuming %" G_GINT64_FORMAT ".%03"
-        G_GINT64_FORMAT " ms", GST_TIME_AS_MSECONDS (time),
-        (GST_TIME_AS_USECONDS (time) % 1000));
+  job->request.n_threads = packer->n_threads;
 
-    out_buf = gst_buffer_new_wrapped (request.output, request.output_size);
-    gst_pad_push (packer->dng_src_pad, out_buf);
-  } else {
-    g_log("GstDngPacker", G_LOG_LEVEL_WARNING,
-        "Dng generation failed, please check log for details\n");
-  }
-
-  if (img_buf != NULL) {
-    gst_buffer_unmap (img_buf, &image_map_info);
-
-    GST_DEBUG_OBJECT (packer, "remove image data queue item");
-    if (gst_data_queue_pop (packer->image_buf_queue, &image_item))
-      image_item->destroy (image_item);
-  }
-
-unmap_raw_buf:
-  gst_buffer_unmap (raw_buf, &raw_map_info);
-
-free_raw_item:
-  if (gst_data_queue_pop (packer->raw_buf_queue, &raw_item))
-    raw_item->destroy (raw_item);
-
-  GST_DNGPACKER_LOCK (packer);
-  packer->process_buf_num--;
-  if (packer->process_buf_num == 0)
-    g_cond_signal (&packer->cond_buf_idle);
-  GST_DNGPACKER_UNLOCK (packer);
+  // Pack asynchronously, blocks while the worker pool limits are reached.
+  gst_worker_pool_submit (packer->workpool, job, job->rawmap.size +
+      dngpacker_utils_get_output_size (job->request.raw_width,
+          job->request.raw_height, job->request.jpg_size));
 }
 
 static gboolean
@@ -474,6 +658,33 @@ gst_dngpacker_raw_sink_pad_event (GstPad * pad, GstObject * parent,
 
       break;
     }
+    case GST_EVENT_FLUSH_START:
+    {
+      gboolean success = FALSE;
+
+      gst_data_queue_set_flushing (packer->raw_buf_queue, TRUE);
+      gst_data_queue_set_flushing (packer->image_buf_queue, TRUE);
+      gst_data_queue_flush (packer->raw_buf_queue);
+      gst_data_queue_flush (packer->image_buf_queue);
+
+      // Forward first in order to release an output push blocked downstream.
+      success = gst_pad_push_event (packer->dng_src_pad, event);
+
+      // Release a task blocked on the pool limits and discard pending jobs.
+      gst_worker_pool_set_flushing (packer->workpool, TRUE);
+      gst_dngpacker_stop_task (packer);
+
+      return success;
+    }
+    case GST_EVENT_FLUSH_STOP:
+    {
+      gst_worker_pool_set_flushing (packer->workpool, FALSE);
+
+      gst_data_queue_set_flushing (packer->raw_buf_queue, FALSE);
+      gst_data_queue_set_flushing (packer->image_buf_queue, FALSE);
+      gst_dngpacker_start_task (packer);
+      break;
+    }
     case GST_EVENT_EOS:
     {
       GST_DNGPACKER_LOCK (packer);
@@ -494,25 +705,30 @@ gst_dngpacker_raw_sink_pad_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer)
 {
   GstDngPacker *packer= GST_DNGPACKER (parent);
+  GstDngPackerRawItem *rawitem = NULL;
   GstDataQueueItem *item = NULL;
 
   GST_TRACE_OBJECT (pad, "Received %" GST_PTR_FORMAT, buffer);
 
-  item = g_slice_new0 (GstDataQueueItem);
+  rawitem = g_slice_new0 (GstDngPackerRawItem);
+  rawitem->packer = packer;
+
+  item = &rawitem->item;
   item->object = GST_MINI_OBJECT (buffer);
   item->size = gst_buffer_get_size (buffer);
   item->duration = GST_BUFFER_DURATION (buffer);
   item->visible = TRUE;
-  item->destroy = gst_data_queue_free_item;
+  item->destroy = gst_dngpacker_raw_item_free;
+
+  // Account the buffer before it becomes visible to the task and the workers.
+  GST_DNGPACKER_LOCK (packer);
+  packer->process_buf_num++;
+  GST_DNGPACKER_UNLOCK (packer);
 
   // Push the buffer into the queue or free it on failure.
   if (!gst_data_queue_push (packer->raw_buf_queue, item)) {
     GST_ERROR_OBJECT (packer, "RAW Pad push failed");
     item->destroy (item);
-  } else {
-    GST_DNGPACKER_LOCK (packer);
-    packer->process_buf_num++;
-    GST_DNGPACKER_UNLOCK (packer);
   }
 
   return GST_FLOW_OK;
@@ -671,6 +887,10 @@ gst_dngpacker_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_worker_pool_set_limits (packer->workpool, packer->n_workers,
+          (gsize) packer->max_memory * 1024 * 1024);
+      gst_worker_pool_set_flushing (packer->workpool, FALSE);
+
       gst_data_queue_set_flushing (packer->raw_buf_queue, FALSE);
       gst_data_queue_set_flushing (packer->image_buf_queue, FALSE);
       gst_dngpacker_start_task (packer);
@@ -680,7 +900,16 @@ gst_dngpacker_change_state (GstElement * element, GstStateChange transition)
       gst_data_queue_set_flushing (packer->image_buf_queue, TRUE);
       gst_data_queue_flush (packer->raw_buf_queue);
       gst_data_queue_flush (packer->image_buf_queue);
+
+      // Release a task blocked on the pool limits and discard pending jobs.
+      // Dropped buffers are accounted when their queue items or jobs are freed.
+      gst_worker_pool_set_flushing (packer->workpool, TRUE);
       gst_dngpacker_stop_task (packer);
+
+      if (packer->outpool != NULL) {
+        gst_buffer_pool_set_active (packer->outpool, FALSE);
+        gst_clear_object (&packer->outpool);
+      }
       break;
     default:
       break;
@@ -695,9 +924,18 @@ static void
 gst_dngpacker_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
-  /* GstDngPacker *packer = GST_DNGPACKER (object); */
+  GstDngPacker *packer = GST_DNGPACKER (object);
 
   switch (prop_id) {
+    case PROP_THREADS:
+      packer->n_threads = g_value_get_uint (value);
+      break;
+    case PROP_WORKERS:
+      packer->n_workers = g_value_get_uint (value);
+      break;
+    case PROP_MAX_MEMORY:
+      packer->max_memory = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -708,9 +946,18 @@ static void
 gst_dngpacker_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
-  /* GstDngPacker *packer = GST_DNGPACKER (object); */
+  GstDngPacker *packer = GST_DNGPACKER (object);
 
   switch (prop_id) {
+    case PROP_THREADS:
+      g_value_set_uint (value, packer->n_threads);
+      break;
+    case PROP_WORKERS:
+      g_value_set_uint (value, packer->n_workers);
+      break;
+    case PROP_MAX_MEMORY:
+      g_value_set_uint (value, packer->max_memory);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -722,6 +969,12 @@ gst_dngpacker_finalize (GObject * object)
 {
   GstDngPacker *packer = GST_DNGPACKER (object);
 
+  if (packer->workpool != NULL)
+    gst_worker_pool_free (packer->workpool);
+
+  if (packer->packer_utils != NULL)
+    dngpacker_utils_deinit (packer->packer_utils);
+
   g_rec_mutex_clear (&packer->task_lock);
 
   g_mutex_clear (&packer->lock);
@@ -730,6 +983,9 @@ gst_dngpacker_finalize (GObject * object)
   gst_object_unref (packer->raw_buf_queue);
   gst_object_unref (packer->image_buf_queue);
 
+  if (packer->outpool != NULL)
+    gst_object_unref (packer->outpool);
+
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (packer));
 }
 
@@ -743,6 +999,26 @@ gst_dngpacker_class_init (GstDngPackerClass *klass)
   oclass->get_property = GST_DEBUG_FUNCPTR (gst_dngpacker_get_property);
   oclass->finalize     = GST_DEBUG_FUNCPTR (gst_dngpacker_finalize);
 
+  g_object_class_install_property (oclass, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads unpacking RAW strips in parallel (0 = automatic)",
+          0, 16, DEFAULT_PROP_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (oclass, PROP_WORKERS,
+      g_param_spec_uint ("workers", "Workers",
+          "Number of images packed in parallel, output keeps the input order",
+          1, 16, DEFAULT_PROP_WORKERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (oclass, PROP_MAX_MEMORY,
+      g_param_spec_uint ("max-memory", "Max memory",
+          "Memory budget in MiB for the images being packed, new input is "
+          "blocked once it is exceeded (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_PROP_MAX_MEMORY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_add_static_pad_template (eclass,
       &gst_dngpacker_raw_sink_template);
   gst_element_class_add_static_pad_template (eclass,
@@ -787,6 +1063,16 @@ gst_dngpacker_init (GstDngPacker * packer)
   g_rec_mutex_init (&packer->task_lock);
   packer->task_active = FALSE;
 
+  packer->n_threads = DEFAULT_PROP_THREADS;
+  packer->n_workers = DEFAULT_PROP_WORKERS;
+  packer->max_memory = DEFAULT_PROP_MAX_MEMORY;
+  packer->outpool = NULL;
+
+  packer->workpool = gst_worker_pool_new (gst_dngpacker_process_job,
+      gst_dngpacker_push_output, gst_dngpacker_job_free, packer);
+  if (packer->workpool == NULL)
+    GST_ERROR_OBJECT (packer, "create worker pool failed");
+
   // create raw sink pad
   packer->raw_sink_pad = gst_pad_new_from_static_template (
       &gst_dngpacker_raw_sink_template, "raw_sink");
@@ -13,6 +13,7 @@
 #include <gst/gst.h>
 #include <gst/base/gstdataqueue.h>
 #include <gst/video/video.h>
+#include <gst/utils/worker-pool.h>
 #include <packer-utils.h>
 
 G_BEGIN_DECLS
@@ -108,6 +109,17 @@ struct _GstDngPacker
 
   /// Dngpacker handle
   DngPackerUtils    *packer_utils;
+
+  /// Pool with output buffers into which the DNG is written directly.
+  GstBufferPool     *outpool;
+
+  /// Worker threads packing several images in parallel.
+  GstWorkerPool     *workpool;
+
+  /// Properties.
+  guint             n_threads;
+  guint             n_workers;
+  guint             max_memory;
 };
 
 struct _GstDngPackerClass {
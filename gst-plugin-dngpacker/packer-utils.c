@@ -5,6 +5,20 @@
 
 #include "packer-utils.h"
 
+#include <glib.h>
+#include <unistd.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define DNGPACKER_HAVE_SIMD
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define DNGPACKER_HAVE_SIMD
+#endif
+
+// Maximum number of threads used for unpacking when set to automatic.
+#define DNG_MAX_THREADS            8
+
 #define LOG(utils, fmt, ...) do                       \
   {                                                   \
     dngpacker_utils_log (utils, __FILE__, __func__,   \
@@ -15,12 +29,17 @@
 struct _DngPackerUtils {
   log_callback cb;
   void *cb_context;
+
+  // Threads unpacking RAW strips, shared by all concurrent pack requests
+  // so that their total number stays bounded by the available cores.
+  GThreadPool *strippool;
+  uint32_t n_threads;
 };
 
 typedef struct _DngPackSettings {
   DngPackerUtils *utils;
 
-  uint16_t            *unpacked_buf;
+  uint8_t             *raw_buf;
   size_t              unpacked_size;
   uint32_t            raw_width;
   uint32_t            raw_height;
@@ -28,6 +47,9 @@ typedef struct _DngPackSettings {
   uint32_t            stride;
   DngPackerCFAPattern cfa;
 
+  uint32_t            rows_per_strip;
+  uint32_t            n_threads;
+
   uint8_t             *jpg_buf;
   size_t              jpg_size;
   uint32_t            jpg_width;
@@ -35,6 +57,24 @@ typedef struct _DngPackSettings {
   uint32_t            jpg_samples_per_pixel;
 } DngPackSettings;
 
+// completion tracking of the strip jobs handed to the strip threads
+typedef struct _DngStripSync {
+  GMutex              lock;
+  GCond               cond;
+  uint32_t            n_busy;
+} DngStripSync;
+
+// structure for unpacking a single RAW strip, possibly in a separate thread
+typedef struct _DngStripJob {
+  DngPackSettings     *settings;
+  DngStripSync        *sync;
+
+  uint32_t            strip;
+  uint16_t            *buf;
+  size_t              size;
+  int                 rc;
+} DngStripJob;
+
 error_callback g_error_callback = NULL;
 
 static void
@@ -83,6 +123,8 @@ typedef struct _MemTIFF {
   size_t size;
   size_t capacity;
   toff_t offset;
+  // data is owned by the caller and cannot be reallocated
+  int external;
   DngPackerUtils *utils;
 } MemTIFF;
 
@@ -106,31 +148,57 @@ mem_read (thandle_t fd, void *buf, tmsize_t size)
   return size;
 }
 
-static tmsize_t
-mem_write (thandle_t fd, void *buf, tmsize_t size)
+// Grow the capacity to at least needed bytes. Caller provided memory cannot be
+// reallocated, its content is moved into allocated memory instead.
+static int
+mem_reserve (MemTIFF *mt, size_t needed)
 {
-  MemTIFF *mt = (MemTIFF *) fd;
+  size_t newcap;
+  uint8_t *newdata;
 
-  if (mt == NULL || buf == NULL)
+  if (needed <= mt->capacity)
     return 0;
 
-  toff_t needed = mt->offset + (toff_t) size;
-  if ((toff_t) mt->capacity < needed) {
-    size_t newcap;
-    uint8_t *newdata;
+  newcap = needed * 2;
+  if (newcap < 1024)
+    newcap = 1024;
+
+  if (mt->external) {
+    LOG (mt->utils, "[WARNING] needed (%zu) > capacity (%zu), moving output "
+        "into allocated memory", needed, mt->capacity);
 
-    newcap = (size_t) (needed * 2);
-    if (newcap < 1024)
-      newcap = 1024;
+    newdata = (uint8_t *) malloc (newcap);
 
+    if (newdata != NULL)
+      memcpy (newdata, mt->data, mt->size);
+  } else {
     newdata = (uint8_t *) realloc (mt->data, newcap);
-    if (!newdata)
-      return 0;
+  }
 
-    mt->data = newdata;
-    mt->capacity = newcap;
+  if (newdata == NULL) {
+    LOG (mt->utils, "[ERROR] allocate %zu bytes for output failed", newcap);
+    return -1;
   }
 
+  mt->data = newdata;
+  mt->capacity = newcap;
+  mt->external = 0;
+
+  return 0;
+}
+
+static tmsize_t
+mem_write (thandle_t fd, void *buf, tmsize_t size)
+{
+  MemTIFF *mt = (MemTIFF *) fd;
+
+  if (mt == NULL || buf == NULL)
+    return 0;
+
+  toff_t needed = mt->offset + (toff_t) size;
+  if (mem_reserve (mt, (size_t) needed) != 0)
+    return 0;
+
   memcpy (mt->data + mt->offset, buf, (size_t) size);
 
   mt->offset += (toff_t) size;
@@ -164,18 +232,8 @@ mem_seek (thandle_t fd, toff_t off, int whence)
       return (toff_t) - 1;
   }
 
-  if ((size_t) newoff > mt->capacity) {
-    size_t newcap;
-    uint8_t *newdata;
-
-    newcap = (size_t) newoff * 2;
-    newdata = (uint8_t *) realloc (mt->data, newcap);
-
-    if (!newdata)
-      return (toff_t) - 1;
-    mt->data = newdata;
-    mt->capacity = newcap;
-  }
+  if (mem_reserve (mt, (size_t) newoff) != 0)
+    return (toff_t) - 1;
 
   mt->offset = newoff;
   if (mt->offset > (toff_t) mt->size)
@@ -210,6 +268,116 @@ mem_unmap (thandle_t fd, void *base, toff_t size)
   return;
 }
 
+#if defined(__aarch64__)
+static uint32_t
+unpack_simd_line_raw10_to_u16 (const uint8_t *src, size_t src_len,
+                               uint16_t *dst, uint32_t width)
+{
+  static const uint8_t msb_idx[8] = { 0, 1, 2, 3, 5, 6, 7, 8 };
+  static const uint8_t lsb_idx[8] = { 4, 4, 4, 4, 9, 9, 9, 9 };
+  static const int8_t lsb_shifts[8] = { 0, -2, -4, -6, 0, -2, -4, -6 };
+  uint8x8_t vmsb_idx = vld1_u8 (msb_idx), vlsb_idx = vld1_u8 (lsb_idx);
+  int8x8_t vshifts = vld1_s8 (lsb_shifts);
+  uint8x8_t vmask = vdup_n_u8 (0x03);
+  size_t pos = 0;
+  uint32_t x = 0;
+
+  // 8 pixels are packed in 10 bytes, but each load reads 16 bytes.
+  for (; (x + 8 <= width) && (pos + 16 <= src_len); x += 8, pos += 10) {
+    uint8x16_t bytes = vld1q_u8 (src + pos);
+    uint8x8_t msb = vqtbl1_u8 (bytes, vmsb_idx);
+    uint8x8_t lsb = vqtbl1_u8 (bytes, vlsb_idx);
+
+    lsb = vand_u8 (vshl_u8 (lsb, vshifts), vmask);
+    vst1q_u16 (dst + x, vorrq_u16 (vshll_n_u8 (msb, 2), vmovl_u8 (lsb)));
+  }
+
+  return x;
+}
+
+static uint32_t
+unpack_simd_line_raw12_to_u16 (const uint8_t *src, size_t src_len,
+                               uint16_t *dst, uint32_t width)
+{
+  static const uint8_t msb_idx[8] = { 0, 1, 3, 4, 6, 7, 9, 10 };
+  static const uint8_t lsb_idx[8] = { 2, 2, 5, 5, 8, 8, 11, 11 };
+  static const int8_t lsb_shifts[8] = { 0, -4, 0, -4, 0, -4, 0, -4 };
+  uint8x8_t vmsb_idx = vld1_u8 (msb_idx), vlsb_idx = vld1_u8 (lsb_idx);
+  int8x8_t vshifts = vld1_s8 (lsb_shifts);
+  uint8x8_t vmask = vdup_n_u8 (0x0F);
+  size_t pos = 0;
+  uint32_t x = 0;
+
+  // 8 pixels are packed in 12 bytes, but each load reads 16 bytes.
+  for (; (x + 8 <= width) && (pos + 16 <= src_len); x += 8, pos += 12) {
+    uint8x16_t bytes = vld1q_u8 (src + pos);
+    uint8x8_t msb = vqtbl1_u8 (bytes, vmsb_idx);
+    uint8x8_t lsb = vqtbl1_u8 (bytes, vlsb_idx);
+
+    lsb = vand_u8 (vshl_u8 (lsb, vshifts), vmask);
+    vst1q_u16 (dst + x, vorrq_u16 (vshll_n_u8 (msb, 4), vmovl_u8 (lsb)));
+  }
+
+  return x;
+}
+#elif defined(__SSSE3__)
+static uint32_t
+unpack_simd_line_raw10_to_u16 (const uint8_t *src, size_t src_len,
+                               uint16_t *dst, uint32_t width)
+{
+  const __m128i msb_idx = _mm_setr_epi8 (0, -1, 1, -1, 2, -1, 3, -1,
+                                         5, -1, 6, -1, 7, -1, 8, -1);
+  const __m128i lsb_idx = _mm_setr_epi8 (4, -1, 4, -1, 4, -1, 4, -1,
+                                         9, -1, 9, -1, 9, -1, 9, -1);
+  // Multiplication moves the 2 low bits of each pixel into bits 6 and 7.
+  const __m128i lsb_factors = _mm_setr_epi16 (64, 16, 4, 1, 64, 16, 4, 1);
+  const __m128i mask = _mm_set1_epi16 (0x03);
+  size_t pos = 0;
+  uint32_t x = 0;
+
+  // 8 pixels are packed in 10 bytes, but each load reads 16 bytes.
+  for (; (x + 8 <= width) && (pos + 16 <= src_len); x += 8, pos += 10) {
+    __m128i bytes = _mm_loadu_si128 ((const __m128i *) (src + pos));
+    __m128i msb = _mm_slli_epi16 (_mm_shuffle_epi8 (bytes, msb_idx), 2);
+    __m128i lsb = _mm_mullo_epi16 (_mm_shuffle_epi8 (bytes, lsb_idx),
+                                   lsb_factors);
+
+    lsb = _mm_and_si128 (_mm_srli_epi16 (lsb, 6), mask);
+    _mm_storeu_si128 ((__m128i *) (dst + x), _mm_or_si128 (msb, lsb));
+  }
+
+  return x;
+}
+
+static uint32_t
+unpack_simd_line_raw12_to_u16 (const uint8_t *src, size_t src_len,
+                               uint16_t *dst, uint32_t width)
+{
+  const __m128i msb_idx = _mm_setr_epi8 (0, -1, 1, -1, 3, -1, 4, -1,
+                                         6, -1, 7, -1, 9, -1, 10, -1);
+  const __m128i lsb_idx = _mm_setr_epi8 (2, -1, 2, -1, 5, -1, 5, -1,
+                                         8, -1, 8, -1, 11, -1, 11, -1);
+  // Multiplication moves the 4 low bits of each pixel into bits 4 to 7.
+  const __m128i lsb_factors = _mm_setr_epi16 (16, 1, 16, 1, 16, 1, 16, 1);
+  const __m128i mask = _mm_set1_epi16 (0x0F);
+  size_t pos = 0;
+  uint32_t x = 0;
+
+  // 8 pixels are packed in 12 bytes, but each load reads 16 bytes.
+  for (; (x + 8 <= width) && (pos + 16 <= src_len); x += 8, pos += 12) {
+    __m128i bytes = _mm_loadu_si128 ((const __m128i *) (src + pos));
+    __m128i msb = _mm_slli_epi16 (_mm_shuffle_epi8 (bytes, msb_idx), 4);
+    __m128i lsb = _mm_mullo_epi16 (_mm_shuffle_epi8 (bytes, lsb_idx),
+                                   lsb_factors);
+
+    lsb = _mm_and_si128 (_mm_srli_epi16 (lsb, 4), mask);
+    _mm_storeu_si128 ((__m128i *) (dst + x), _mm_or_si128 (msb, lsb));
+  }
+
+  return x;
+}
+#endif // __SSSE3__
+
 static int
 unpack_packed_line_raw10_to_u16 (DngPackerUtils *utils, const uint8_t *src,
                                  size_t src_len, uint16_t *dst, uint32_t width)
@@ -225,6 +393,12 @@ unpack_packed_line_raw10_to_u16 (DngPackerUtils *utils, const uint8_t *src,
   // Byte 3 = P3[2:9]
   // Byte 4 = P0[0:1] | P1[0:1] | P2[0:1] | P3[0:1]
 
+#if defined(DNGPACKER_HAVE_SIMD)
+  // Vectorized bulk of the line, the remaining pixels are unpacked below.
+  x = unpack_simd_line_raw10_to_u16 (src, src_len, dst, width);
+  pos = ((size_t) x / 4) * 5;
+#endif
+
   while (x + 4 <= width) {
     if (pos + 5 > src_len) {
       LOG (utils, "[ERROR] pos + 5 (%zu) > src_len (%zu)", pos + 5, src_len);
@@ -310,6 +484,12 @@ unpack_packed_line_raw12_to_u16 (DngPackerUtils *utils, const uint8_t *src,
   // Byte 1 = P1[4:11]
   // Byte 2 = P0[0:3] | P1[0:3]
 
+#if defined(DNGPACKER_HAVE_SIMD)
+  // Vectorized bulk of the line, the remaining pixels are unpacked below.
+  x = unpack_simd_line_raw12_to_u16 (src, src_len, dst, width);
+  pos = ((size_t) x / 2) * 3;
+#endif
+
   while (x + 2 <= width) {
 
     if (pos + 3 > src_len) {
@@ -453,13 +633,191 @@ dngpacker_utils_fetch_jpg_info (uint8_t *jpg_buf, size_t jpg_size,
   return 0;
 }
 
+static uint32_t
+dngpacker_utils_rows_per_strip (uint32_t width)
+{
+  uint32_t rows = DNG_STRIP_SIZE / ((size_t) width * sizeof (uint16_t));
+
+  // keep whole CFA pattern (2 rows) inside each strip
+  rows &= ~((uint32_t) 1);
+
+  return (rows < 2) ? 2 : rows;
+}
+
+static void
+dngpacker_utils_unpack_strip (DngStripJob *job)
+{
+  DngPackSettings *settings = job->settings;
+  uint32_t row = 0, n_rows = 0;
+
+  row = job->strip * settings->rows_per_strip;
+  n_rows = settings->raw_height - row;
+
+  if (n_rows > settings->rows_per_strip)
+    n_rows = settings->rows_per_strip;
+
+  job->size = (size_t) n_rows * settings->raw_width * sizeof (uint16_t);
+  job->rc = unpack_raw_to_u16 (settings->utils, job->buf,
+                               settings->raw_buf + (size_t) row * settings->stride,
+                               settings->raw_width, n_rows, settings->bpp,
+                               settings->stride);
+}
+
+static void
+dngpacker_utils_strip_func (gpointer data, gpointer userdata)
+{
+  DngStripJob *job = (DngStripJob *) data;
+  DngStripSync *sync = job->sync;
+
+  dngpacker_utils_unpack_strip (job);
+
+  g_mutex_lock (&sync->lock);
+
+  if (--sync->n_busy == 0)
+    g_cond_signal (&sync->cond);
+
+  g_mutex_unlock (&sync->lock);
+}
+
+static uint32_t
+dngpacker_utils_start_strips (DngPackSettings *settings, DngStripJob *jobs,
+                              uint32_t strip, uint32_t n_strips)
+{
+  GThreadPool *strippool = settings->utils->strippool;
+  uint32_t idx = 0, n_jobs = 0;
+
+  n_jobs = n_strips - strip;
+
+  if (n_jobs > settings->n_threads)
+    n_jobs = settings->n_threads;
+
+  for (idx = 0; idx < n_jobs; idx++) {
+    jobs[idx].strip = strip + idx;
+    jobs[idx].rc = -1;
+
+    // unpack in the calling thread if single threaded or the push failed
+    if ((settings->n_threads > 1) && (strippool != NULL)) {
+      DngStripSync *sync = jobs[idx].sync;
+
+      g_mutex_lock (&sync->lock);
+      sync->n_busy++;
+      g_mutex_unlock (&sync->lock);
+
+      if (g_thread_pool_push (strippool, &jobs[idx], NULL))
+        continue;
+
+      g_mutex_lock (&sync->lock);
+      sync->n_busy--;
+      g_mutex_unlock (&sync->lock);
+    }
+
+    dngpacker_utils_unpack_strip (&jobs[idx]);
+  }
+
+  return n_jobs;
+}
+
+static void
+dngpacker_utils_join_strips (DngStripSync *sync)
+{
+  g_mutex_lock (&sync->lock);
+
+  while (sync->n_busy > 0)
+    g_cond_wait (&sync->cond, &sync->lock);
+
+  g_mutex_unlock (&sync->lock);
+}
+
+static int
+dngpacker_utils_write_strips (DngPackSettings *settings, TIFF *tif)
+{
+  DngStripJob *jobs = NULL, *current = NULL, *pending = NULL;
+  DngStripSync sync;
+  uint16_t *strip_bufs = NULL;
+  size_t strip_pixels = 0;
+  uint32_t idx = 0, strip = 0, n_strips = 0, n_current = 0, n_pending = 0;
+  int rc = 0;
+
+  n_strips = (settings->raw_height + settings->rows_per_strip - 1) /
+      settings->rows_per_strip;
+  strip_pixels = (size_t) settings->raw_width * settings->rows_per_strip;
+
+  // two sets of strips, one is written while the other is being unpacked
+  strip_bufs = (uint16_t *) malloc (
+      2 * settings->n_threads * strip_pixels * sizeof (uint16_t));
+  jobs = (DngStripJob *) calloc (2 * settings->n_threads, sizeof (DngStripJob));
+
+  if ((strip_bufs == NULL) || (jobs == NULL)) {
+    LOG (settings->utils, "[ERROR] allocate strip buffers failed");
+
+    free (strip_bufs);
+    free (jobs);
+    return -1;
+  }
+
+  // only one set of strips is being unpacked at any time
+  g_mutex_init (&sync.lock);
+  g_cond_init (&sync.cond);
+  sync.n_busy = 0;
+
+  for (idx = 0; idx < 2 * settings->n_threads; idx++) {
+    jobs[idx].settings = settings;
+    jobs[idx].sync = &sync;
+    jobs[idx].buf = strip_bufs + idx * strip_pixels;
+  }
+
+  current = jobs;
+  pending = jobs + settings->n_threads;
+
+  n_current = dngpacker_utils_start_strips (settings, current, 0, n_strips);
+  dngpacker_utils_join_strips (&sync);
+
+  while (n_current > 0) {
+    DngStripJob *swap = NULL;
+
+    // unpack the next strips in the background while writing current ones
+    strip += n_current;
+    n_pending = dngpacker_utils_start_strips (settings, pending, strip, n_strips);
+
+    for (idx = 0; (idx < n_current) && (rc == 0); idx++) {
+      if (current[idx].rc != 0) {
+        LOG (settings->utils, "[ERROR] unpack raw strip %u failed",
+            current[idx].strip);
+        rc = -1;
+      } else if (TIFFWriteRawStrip (tif, current[idx].strip, current[idx].buf,
+                   (tmsize_t) current[idx].size) == -1) {
+        LOG (settings->utils, "[ERROR] TIFF Write Raw Strip %u for RAW failed",
+            current[idx].strip);
+        rc = -1;
+      }
+    }
+
+    dngpacker_utils_join_strips (&sync);
+
+    if (rc != 0)
+      break;
+
+    swap = current;
+    current = pending;
+    pending = swap;
+    n_current = n_pending;
+  }
+
+  g_cond_clear (&sync.cond);
+  g_mutex_clear (&sync.lock);
+
+  free (strip_bufs);
+  free (jobs);
+
+  return rc;
+}
+
 static int
 dngpacker_utils_do_dng_pack (DngPackSettings *settings,
     uint8_t ** ppoutput, size_t *poutlen)
 {
   MemTIFF mt;
   TIFF *tif = NULL;
-  uint16_t *unpacked_buf = NULL;
   uint16_t cfa_repeat[2] = { 2, 2 };
   uint8_t cfa_patterns[][4] = {
     // DNGPACKER_CFA_RGGB
@@ -481,20 +839,32 @@ dngpacker_utils_do_dng_pack (DngPackSettings *settings,
   float as_shot_neutral[3] = { 1.0f, 1.0f, 1.0f };
 
   memset (&mt, 0, sizeof (mt));
-
-  // allocate enough space to avoid realloc
-  mt.capacity = settings->unpacked_size + settings->jpg_size + TIFF_INFO_EXTRA_SIZE;
-  mt.data = (uint8_t *) malloc (mt.capacity);
+  mt.utils = settings->utils;
+
+  if (*ppoutput != NULL) {
+    // write directly into the caller provided (pre-sized) buffer
+    mt.capacity = *poutlen;
+    mt.data = *ppoutput;
+    mt.external = 1;
+  } else {
+    // allocate enough space to avoid realloc
+    mt.capacity = dngpacker_utils_get_output_size (settings->raw_width,
+        settings->raw_height, settings->jpg_size);
+    mt.data = (uint8_t *) malloc (mt.capacity);
+  }
 
   LOG (settings->utils, "[DEBUG] Dng Pack Settings: "
-      "raw(%dx%d) bpp(%d) stride(%d) unpacked_size(%zu) jpg_size(%zu) capacity = %zu",
+      "raw(%dx%d) bpp(%d) stride(%d) unpacked_size(%zu) jpg_size(%zu) capacity = %zu "
+      "rows_per_strip(%d) threads(%d)",
       settings->raw_width,
       settings->raw_height,
       settings->bpp,
       settings->stride,
       settings->unpacked_size,
       settings->jpg_size,
-      mt.capacity);
+      mt.capacity,
+      settings->rows_per_strip,
+      settings->n_threads);
 
   if (mt.data == NULL) {
     LOG (settings->utils, "[ERROR] allocate MemTIFF data buffer failed");
@@ -596,6 +966,9 @@ dngpacker_utils_do_dng_pack (DngPackSettings *settings,
   // image pixel value's data type, use unsigned integer for RAW16 unpacked format
   TIFFSetField (tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
 
+  // image rows per-strip, strips are unpacked and written one after another
+  TIFFSetField (tif, TIFFTAG_ROWSPERSTRIP, settings->rows_per_strip);
+
 
   /*
   * Workaround for a bug introduced in libtiff version 4.5.1 and no fix
@@ -654,16 +1027,11 @@ dngpacker_utils_do_dng_pack (DngPackSettings *settings,
   // white balance scaling factors for neutral rendering of the scene
   TIFFSetField (tif, TIFFTAG_ASSHOTNEUTRAL, 3, as_shot_neutral);
 
-  unpacked_buf = settings->unpacked_buf;
-
-  for (uint32_t row = 0; row < (uint32_t) settings->raw_height; row++) {
-    // write each line data into tiff internal buffer
-    if (TIFFWriteScanline (tif, &unpacked_buf[(size_t) row * settings->raw_width],
-          row, 0) != 1) {
-      LOG (settings->utils, "[ERROR] TIFF Write Scanline for RAW failed");
+  // unpack raw image strip by strip straight into the tiff
+  if (dngpacker_utils_write_strips (settings, tif) != 0) {
+    LOG (settings->utils, "[ERROR] TIFF Write Strips for RAW failed");
 
-      goto close_tiff;
-    }
+    goto close_tiff;
   }
 
   // complete sub-directory
@@ -687,7 +1055,8 @@ close_tiff:
   TIFFClose(tif);
 
 free_mt_data:
-  free (mt.data);
+  if (!mt.external)
+    free (mt.data);
 
   return -1;
 }
@@ -750,35 +1119,25 @@ int dngpacker_utils_pack_dng (DngPackerUtils *utils, DngPackRequest *request)
 
   memset (&settings, 0, sizeof (settings));
 
+  // step1: prepare information for dng packing
+  settings.utils = utils;
+  settings.raw_buf = request->raw_buf;
   settings.unpacked_size =
     (size_t) request->raw_width * (size_t) request->raw_height * sizeof (uint16_t);
-  settings.unpacked_buf = (uint16_t *) malloc (settings.unpacked_size);
-
-  if (settings.unpacked_buf == NULL) {
-    LOG (utils, "[ERROR] allocate dng unpack output buffer failed");
-
-    return -1;
-  }
-
-  // step1: unpack raw image
-  rc = unpack_raw_to_u16 (utils, settings.unpacked_buf, request->raw_buf,
-                          request->raw_width, request->raw_height,
-                          request->raw_bpp, request->raw_stride);
-
-  if (rc != 0) {
-    LOG (utils, "[ERROR] unpack raw packed image failed");
-
-    goto free_unpacked_buf;
-  }
-
-  // step2: prepare information for dng packing
-  settings.utils = utils;
   settings.raw_width = request->raw_width;
   settings.raw_height = request->raw_height;
   settings.bpp = request->raw_bpp;
   settings.stride = request->raw_stride;
   settings.cfa = request->cfa;
 
+  settings.rows_per_strip = dngpacker_utils_rows_per_strip (request->raw_width);
+
+  // strips in flight per request, bounded by the shared strip threads
+  settings.n_threads = request->n_threads;
+
+  if ((settings.n_threads == 0) || (settings.n_threads > utils->n_threads))
+    settings.n_threads = utils->n_threads;
+
   if (request->jpg_buf != NULL) {
     settings.jpg_buf = request->jpg_buf;
     settings.jpg_size = request->jpg_size;
@@ -796,27 +1155,37 @@ int dngpacker_utils_pack_dng (DngPackerUtils *utils, DngPackRequest *request)
     if (rc != 0) {
       LOG (utils, "[ERROR] fetch jpeg information failed");
 
-      goto free_unpacked_buf;
+      return -1;
     }
   }
 
-  // step3: put unpacked raw image and optional jpeg image into dng buffer
+  // step2: unpack raw image strips and put them with the optional jpeg
+  // image into dng buffer
+  if (request->output != NULL)
+    request->output_size = request->output_capacity;
+
   rc = dngpacker_utils_do_dng_pack (&settings, &request->output,
                                     &request->output_size);
 
   if (rc != 0) {
     LOG (utils, "[ERROR] dng pack failed");
 
-    goto free_unpacked_buf;
+    return -1;
   }
 
-  free (settings.unpacked_buf);
   return 0;
+}
 
-free_unpacked_buf:
-  free (settings.unpacked_buf);
+size_t
+dngpacker_utils_get_output_size (uint32_t width, uint32_t height,
+                                 size_t jpg_size)
+{
+  uint32_t rows = dngpacker_utils_rows_per_strip (width);
+  size_t n_strips = (height + rows - 1) / rows;
 
-  return -1;
+  // unpacked raw, thumbnail, tiff directories and strip offset/size tables
+  return (size_t) width * height * sizeof (uint16_t) + jpg_size +
+      TIFF_INFO_EXTRA_SIZE + n_strips * 2 * sizeof (uint64_t);
 }
 
 DngPackerUtils *
@@ -824,17 +1193,48 @@ dngpacker_utils_init (log_callback cb_func, void *cb_context)
 {
   DngPackerUtils *utils = NULL;
 
+  GError *error = NULL;
+  long n_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+
   utils = malloc (sizeof (*utils));
 
   if (utils != NULL) {
     utils->cb = cb_func;
     utils->cb_context = cb_context;
     TIFFSetErrorHandler(dngpacker_tiff_error_handler);
+
+    utils->n_threads = (n_cpus > DNG_MAX_THREADS) ? DNG_MAX_THREADS :
+        ((n_cpus > 0) ? (uint32_t) n_cpus : 1);
+    utils->strippool = NULL;
+
+    // strips are unpacked in the calling thread on a single core
+    if (utils->n_threads > 1)
+      utils->strippool = g_thread_pool_new (dngpacker_utils_strip_func, utils,
+          utils->n_threads, TRUE, &error);
+
+    if ((utils->n_threads > 1) && (utils->strippool == NULL)) {
+      LOG (utils, "[ERROR] create strip threads failed: %s", error->message);
+      g_clear_error (&error);
+
+      utils->n_threads = 1;
+    }
   }
 
   return utils;
 }
 
+void
+dngpacker_utils_deinit (DngPackerUtils *utils)
+{
+  if (utils == NULL)
+    return;
+
+  if (utils->strippool != NULL)
+    g_thread_pool_free (utils->strippool, FALSE, TRUE);
+
+  free (utils);
+}
+
 void
 dngpacker_utils_register_error_cb (error_callback cb)
 {
@@ -12,7 +12,12 @@
 #include <tiffio.h>
 #include <jpeglib.h>
 
-#define TIFF_INFO_EXTRA_SIZE       1024
+// Room for the TIFF header, both IFDs with their tag data and the tables of
+// the JPEG compressed thumbnail.
+#define TIFF_INFO_EXTRA_SIZE       4096
+
+// Approximate size in bytes of a single unpacked RAW strip in the DNG.
+#define DNG_STRIP_SIZE             (256 * 1024)
 
 typedef enum _DngPackerCFAPattern {
   DNGPACKER_CFA_RGGB,
@@ -34,7 +39,16 @@ typedef struct _DngPackRequest {
   size_t                jpg_size;
   uint8_t               *jpg_buf;
 
+  // Number of threads unpacking RAW strips in parallel, 0 for automatic.
+  uint32_t              n_threads;
+
+  // If output is set by the caller the DNG is written directly into it and
+  // output_capacity should not be less than dngpacker_utils_get_output_size().
+  // Otherwise output is allocated with malloc() and must be freed by caller.
+  // In case the DNG does not fit in the caller memory output is replaced by
+  // malloc() allocated memory, which then must be freed by caller as well.
   uint8_t               *output;
+  size_t                output_capacity;
   size_t                output_size;
 } DngPackRequest;
 
@@ -57,6 +71,16 @@ typedef struct _DngPackerUtils DngPackerUtils;
  */
 DngPackerUtils *dngpacker_utils_init (log_callback cb_func, void *cb_context);
 
+/**
+ * dngpacker_utils_deinit
+ * @utils: dng packer instance
+ *
+ * stop the strip threads and destroy the dng packer instance
+ *
+ * Return: NULL
+ */
+void dngpacker_utils_deinit (DngPackerUtils *utils);
+
 /**
  * dngpacker_utils_register_error_cb
  * @error_callback: callback function for error report
@@ -78,4 +102,18 @@ void dngpacker_utils_register_error_cb (error_callback cb);
  */
 int dngpacker_utils_pack_dng (DngPackerUtils *utils, DngPackRequest *request);
 
+/**
+ * dngpacker_utils_get_output_size
+ * @width: raw image width
+ * @height: raw image height
+ * @jpg_size: size of the jpeg thumbnail, 0 if there is none
+ *
+ * calculate the maximum size of the DNG produced for the given raw image
+ * dimensions and thumbnail, used to pre-allocate the output buffer
+ *
+ * Return: maximum DNG size in bytes
+ */
+size_t dngpacker_utils_get_output_size (uint32_t width, uint32_t height,
+                                        size_t jpg_size);
+
 #endif // __PACKER_UTILS_H__
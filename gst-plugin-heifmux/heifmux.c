@@ -23,6 +23,8 @@ G_DEFINE_TYPE (GstHeifMux, gst_heifmux, GST_TYPE_ELEMENT);
 #define DEFAULT_PROP_MIN_BUFFERS     2
 #define DEFAULT_PROP_MAX_BUFFERS     10
 #define DEFAULT_PROP_QUEUE_SIZE      10
+#define DEFAULT_PROP_WORKERS         2
+#define DEFAULT_PROP_MAX_MEMORY      0
 
 static GstStaticPadTemplate gst_heifmux_main_sink_template =
     GST_STATIC_PAD_TEMPLATE ("sink",
@@ -49,6 +51,19 @@ enum
 {
   PROP_0,
   PROP_QUEUE_SIZE,
+  PROP_WORKERS,
+  PROP_MAX_MEMORY,
+};
+
+typedef struct _GstHeifMuxJob GstHeifMuxJob;
+
+struct _GstHeifMuxJob {
+  // Main HEIF image buffer.
+  GstBuffer *mainbuf;
+  // List of mapped thumbnail GstVideoFrame, each holds a buffer reference.
+  GList     *thframes;
+  // Output buffer acquired at submission.
+  GstBuffer *outbuf;
 };
 
 static void
@@ -129,28 +144,128 @@ gst_heifmux_create_pool (GstHeifMux * muxer, GstCaps * caps)
   return pool;
 }
 
+static void
+gst_heifmux_job_free (gpointer data)
+{
+  GstHeifMuxJob *job = (GstHeifMuxJob *) data;
+  GList *list = NULL;
+
+  for (list = job->thframes; list != NULL; list = g_list_next (list)) {
+    GstVideoFrame *frame = list->data;
+
+    gst_video_frame_unmap (frame);
+    g_slice_free (GstVideoFrame, frame);
+  }
+
+  if (job->thframes)
+    g_list_free (job->thframes);
+
+  if (job->outbuf != NULL)
+    gst_buffer_unref (job->outbuf);
+
+  gst_buffer_unref (job->mainbuf);
+  g_slice_free (GstHeifMuxJob, job);
+}
+
+static GstBuffer *
+gst_heifmux_process_job (gpointer data, gpointer userdata)
+{
+  GstHeifMux *muxer = GST_HEIFMUX (userdata);
+  GstHeifMuxJob *job = (GstHeifMuxJob *) data;
+  GstHeifEngine *engine = NULL;
+  GstBuffer *outbuf = NULL;
+  GstClockTime time = GST_CLOCK_TIME_NONE;
+  gboolean success = FALSE;
+
+  GST_INFO_OBJECT (muxer, "Processing main frame %" GST_PTR_FORMAT
+      " with %d thumbnail%s.", job->mainbuf, g_list_length (job->thframes),
+      (g_list_length (job->thframes) != 1) ? "s" : "");
+
+  // Each worker thread needs its own engine, reuse the idle ones.
+  if ((engine = g_async_queue_try_pop (muxer->engines)) == NULL)
+    engine = gst_heif_engine_new ();
+
+  if (engine == NULL) {
+    GST_ERROR_OBJECT (muxer, "Failed to create heif engine!");
+    return NULL;
+  }
+
+  // Take over the output buffer, it may be replaced by the engine.
+  outbuf = job->outbuf;
+  job->outbuf = NULL;
+
+  time = gst_util_get_timestamp ();
+
+  success = gst_heif_engine_execute (engine, job->mainbuf, job->thframes,
+      &outbuf);
+
+  time = GST_CLOCK_DIFF (time, gst_util_get_timestamp ());
+
+  g_async_queue_push (muxer->engines, engine);
+
+  GST_INFO_OBJECT (muxer, "Heif muxer took %" G_GINT64_FORMAT ".%03"
+      G_GINT64_FORMAT " ms", GST_TIME_AS_MSECONDS (time),
+      (GST_TIME_AS_USECONDS (time) % 1000));
+
+  if (!success) {
+    GST_ERROR_OBJECT (muxer, "Failed to execute heif muxer!");
+    gst_buffer_unref (outbuf);
+    return NULL;
+  }
+
+  return outbuf;
+}
+
+static void
+gst_heifmux_submit_output (GstBuffer * outbuf, gpointer userdata)
+{
+  GstHeifMux *muxer = GST_HEIFMUX (userdata);
+  GstDataQueueItem *item = NULL;
+
+  item = g_slice_new0 (GstDataQueueItem);
+  item->object = GST_MINI_OBJECT (outbuf);
+  item->size = gst_buffer_get_size (outbuf);
+  item->duration = GST_BUFFER_DURATION (outbuf);
+  item->visible = TRUE;
+  item->destroy = gst_data_queue_free_item;
+
+  GST_DEBUG_OBJECT (muxer, "Submitting %" GST_PTR_FORMAT, outbuf);
+
+  GST_HEIFMUX_SRC_LOCK (muxer->srcpad);
+  muxer->srcpad->segment.position = GST_BUFFER_TIMESTAMP (outbuf);
+  GST_HEIFMUX_SRC_UNLOCK (muxer->srcpad);
+
+  // Push the buffer into the queue or free it on failure.
+  if (!gst_data_queue_push (muxer->srcpad->buffers, item))
+    item->destroy (item);
+}
+
 static void
 gst_heifmux_worker_task (gpointer userdata)
 {
   GstHeifMux *muxer = GST_HEIFMUX (userdata);
-  GstBuffer *mainbuf = NULL, *outbuf = NULL;
-  GList *thframes = NULL, *list = NULL;
+  GstHeifMuxJob *job = NULL;
+  GstBufferPool *pool = NULL;
+  GList *list = NULL;
   GstDataQueueItem *item = NULL;
-  GstClockTime time = GST_CLOCK_TIME_NONE;
   gsize offset[GST_VIDEO_MAX_PLANES] = { 0, 0, 0, 0 };
   gint  stride[GST_VIDEO_MAX_PLANES] = { 0, 0, 0, 0 };
-  gboolean success = FALSE;
+  gsize size = 0;
 
   if (!gst_data_queue_peek (muxer->sinkpad->buffers, &item))
     return;
 
-  // Get buffer pointer from the queue item.
-  mainbuf = GST_BUFFER (item->object);
+  // Set buffer video metadata while the queue holds the only reference.
+  gst_buffer_add_video_meta_full (GST_BUFFER (item->object),
+      GST_VIDEO_FRAME_FLAG_NONE, GST_VIDEO_FORMAT_ENCODED,
+      muxer->sinkpad->vinfo->width, muxer->sinkpad->vinfo->height, 1,
+      offset, stride);
 
-  // Set buffer video metadata.
-  gst_buffer_add_video_meta_full (mainbuf, GST_VIDEO_FRAME_FLAG_NONE,
-      GST_VIDEO_FORMAT_ENCODED, muxer->sinkpad->vinfo->width,
-      muxer->sinkpad->vinfo->height, 1, offset, stride);
+  job = g_slice_new0 (GstHeifMuxJob);
+
+  // Get buffer reference from the queue item.
+  job->mainbuf = gst_buffer_ref (GST_BUFFER (item->object));
+  size = gst_buffer_get_size (job->mainbuf);
 
   // Adds thumbnails if they are available.
   for (list = muxer->thumbpads; list != NULL; list = g_list_next (list)) {
@@ -160,23 +275,18 @@ gst_heifmux_worker_task (gpointer userdata)
       GstVideoFrame *frame = g_slice_new0 (GstVideoFrame);;
       GstBuffer *buf = GST_BUFFER (item->object);
 
-      if (!gst_video_frame_map (frame, thpad->vinfo, buf, GST_MAP_READ |
-          GST_VIDEO_FRAME_MAP_FLAG_NO_REF)) {
+      // The mapped frame keeps a reference to the thumbnail buffer.
+      if (!gst_video_frame_map (frame, thpad->vinfo, buf, GST_MAP_READ)) {
           GST_ERROR_OBJECT (muxer, "Failed to map thumbnail buffer!");
           g_slice_free (GstVideoFrame, frame);
           goto cleanup;
       }
 
-      thframes = g_list_append (thframes, frame);
+      job->thframes = g_list_append (job->thframes, frame);
+      size += gst_buffer_get_size (buf);
     }
   }
 
-  GST_INFO_OBJECT (muxer, "Processing main frame %" GST_PTR_FORMAT
-      " with %d thumbnail%s.", mainbuf, g_list_length (thframes),
-      (g_list_length (thframes) != 1) ? "s" : "");
-
-  time = gst_util_get_timestamp ();
-
   GST_HEIFMUX_LOCK (muxer);
 
   if (!muxer->active) {
@@ -185,67 +295,40 @@ gst_heifmux_worker_task (gpointer userdata)
     goto cleanup;
   }
 
-  // Get output buffer from the pool.
-  if (GST_FLOW_OK != gst_buffer_pool_acquire_buffer (muxer->outpool,
-      &outbuf, NULL)) {
-    GST_ERROR_OBJECT (muxer, "Failed to acquire output buffer!");
-    GST_HEIFMUX_UNLOCK (muxer);
-    goto cleanup;
-  }
-
-  // Copy the flags and timestamps from the main input buffer.
-  gst_buffer_copy_into (outbuf, mainbuf, GST_BUFFER_COPY_FLAGS |
-      GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
-
-  success = gst_heif_engine_execute (muxer->engine, mainbuf, thframes, &outbuf);
+  pool = gst_object_ref (muxer->outpool);
 
   GST_HEIFMUX_UNLOCK (muxer);
 
-  time = GST_CLOCK_DIFF (time, gst_util_get_timestamp ());
-
-  GST_INFO_OBJECT (muxer, "Heif muxer took %" G_GINT64_FORMAT ".%03"
-      G_GINT64_FORMAT " ms", GST_TIME_AS_MSECONDS (time),
-      (GST_TIME_AS_USECONDS (time) % 1000));
-
-  if (!success) {
-    GST_ERROR_OBJECT (muxer, "Failed to execute heif muxer!");
-    gst_buffer_unref (outbuf);
-    outbuf = NULL;
+  // Output buffers are acquired in submission order so that the pending jobs
+  // never hold all of the pool buffers while the oldest one is waiting.
+  if (GST_FLOW_OK != gst_buffer_pool_acquire_buffer (pool, &job->outbuf,
+      NULL)) {
+    GST_ERROR_OBJECT (muxer, "Failed to acquire output buffer!");
+    gst_object_unref (pool);
     goto cleanup;
   }
 
-  item = g_slice_new0 (GstDataQueueItem);
-  item->object = GST_MINI_OBJECT (outbuf);
-  item->size = gst_buffer_get_size (outbuf);
-  item->duration = GST_BUFFER_DURATION (outbuf);
-  item->visible = TRUE;
-  item->destroy = gst_data_queue_free_item;
+  gst_object_unref (pool);
 
-  GST_DEBUG_OBJECT (muxer, "Submitting %" GST_PTR_FORMAT, outbuf);
+  // Copy the flags and timestamps from the main input buffer.
+  gst_buffer_copy_into (job->outbuf, job->mainbuf, GST_BUFFER_COPY_FLAGS |
+      GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
 
-  GST_HEIFMUX_SRC_LOCK (muxer->srcpad);
-  muxer->srcpad->segment.position = GST_BUFFER_TIMESTAMP (outbuf);
-  GST_HEIFMUX_SRC_UNLOCK (muxer->srcpad);
+  size += gst_buffer_get_size (job->outbuf);
 
-  // Push the buffer into the queue or free it on failure.
-  if (!gst_data_queue_push (muxer->srcpad->buffers, item))
-    item->destroy (item);
+  // Mux asynchronously, blocks while the worker pool limits are reached.
+  gst_worker_pool_submit (muxer->workers, job, size);
+  job = NULL;
 
 cleanup:
-  // Remove and free the sinkpad item from the queue.
+  if (job != NULL)
+    gst_heifmux_job_free (job);
+
+  // Remove and free the items only after submission, this way the sink pad
+  // is not reported as idle while a job is still being prepared.
   if (gst_data_queue_pop (muxer->sinkpad->buffers, &item))
     item->destroy (item);
 
-  for (list = thframes; list != NULL; list = g_list_next (list)) {
-    GstVideoFrame *frame = list->data;
-
-    gst_video_frame_unmap (frame);
-    g_slice_free (GstVideoFrame, frame);
-  }
-
-  if (thframes)
-    g_list_free (thframes);
-
   for (list = muxer->thumbpads; list != NULL; list = g_list_next (list)) {
     GstHeifMuxSinkPad *thpad = GST_HEIFMUX_SINK_PAD (list->data);
 
@@ -403,11 +486,6 @@ gst_heifmux_main_sink_pad_setcaps (GstHeifMux * muxer, GstPad * pad,
 
   sinkpad->vinfo = gst_video_info_copy (&info);
 
-  if (muxer->engine == NULL) {
-    muxer->engine = gst_heif_engine_new ();
-    g_return_val_if_fail (muxer->engine != NULL, FALSE);
-  }
-
   // Unref previouly created pool.
   if (muxer->outpool) {
     gst_buffer_pool_set_active (muxer->outpool, FALSE);
@@ -494,20 +572,42 @@ gst_heifmux_main_sink_pad_event (GstPad * pad, GstObject * parent,
       return gst_pad_push_event (GST_PAD (srcpad), event);
     }
     case GST_EVENT_FLUSH_START:
+    {
+      gboolean success = FALSE;
+
       gst_data_queue_set_flushing (GST_HEIFMUX_SINK_PAD (pad)->buffers, TRUE);
       gst_data_queue_flush (GST_HEIFMUX_SINK_PAD (pad)->buffers);
 
+      // Unblock jobs submitting into a full output queue and a push pending
+      // downstream before waiting for the running jobs below.
+      gst_data_queue_set_flushing (muxer->srcpad->buffers, TRUE);
+      success = gst_pad_push_event (GST_PAD (muxer->srcpad), event);
+      gst_heifmux_src_pad_set_flushing (muxer->srcpad, TRUE);
+
+      // Release a task blocked on the pool limits and discard pending jobs.
+      gst_worker_pool_set_flushing (muxer->workers, TRUE);
       gst_heifmux_stop_task (muxer);
       gst_heifmux_flush_thubmnail_queues (muxer);
 
-      return gst_pad_push_event (pad, event);
+      return success;
+    }
     case GST_EVENT_FLUSH_STOP:
+    {
+      gboolean success = FALSE;
+
       gst_data_queue_set_flushing (GST_HEIFMUX_SINK_PAD (pad)->buffers, FALSE);
+      gst_worker_pool_set_flushing (muxer->workers, FALSE);
+
+      success = gst_pad_push_event (GST_PAD (muxer->srcpad), event);
+      gst_heifmux_src_pad_set_flushing (muxer->srcpad, FALSE);
+
       gst_heifmux_start_task (muxer);
 
-      return gst_pad_push_event (pad, event);
+      return success;
+    }
     case GST_EVENT_EOS:
       GST_HEIFMUX_PAD_WAIT_IDLE (GST_HEIFMUX_SINK_PAD (pad));
+      gst_worker_pool_drain (muxer->workers);
       GST_HEIFMUX_PAD_WAIT_IDLE (muxer->srcpad);
 
       gst_heifmux_flush_thubmnail_queues (muxer);
@@ -780,6 +880,10 @@ gst_heifmux_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_worker_pool_set_limits (muxer->workers, muxer->n_workers,
+          (gsize) muxer->max_memory * 1024 * 1024);
+      gst_worker_pool_set_flushing (muxer->workers, FALSE);
+
       gst_data_queue_set_flushing (muxer->sinkpad->buffers, FALSE);
       gst_heifmux_start_task (muxer);
       break;
@@ -795,6 +899,8 @@ gst_heifmux_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      // Source queue is flushing by now, outputs of running jobs are dropped.
+      gst_worker_pool_set_flushing (muxer->workers, TRUE);
       gst_heifmux_stop_task (muxer);
       gst_heifmux_flush_thubmnail_queues (muxer);
       break;
@@ -827,6 +933,12 @@ gst_heifmux_set_property (GObject * object, guint prop_id,
       muxer->sinkpad->buffers_limit = muxer->queue_size;
       muxer->srcpad->buffers_limit = muxer->queue_size;
       break;
+    case PROP_WORKERS:
+      muxer->n_workers = g_value_get_uint (value);
+      break;
+    case PROP_MAX_MEMORY:
+      muxer->max_memory = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -847,6 +959,12 @@ gst_heifmux_get_property (GObject * object, guint prop_id,
     case PROP_QUEUE_SIZE:
       g_value_set_uint (value, muxer->queue_size);
       break;
+    case PROP_WORKERS:
+      g_value_set_uint (value, muxer->n_workers);
+      break;
+    case PROP_MAX_MEMORY:
+      g_value_set_uint (value, muxer->max_memory);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -860,13 +978,18 @@ gst_heifmux_finalize (GObject * object)
 {
   GstHeifMux *muxer = GST_HEIFMUX (object);
 
+  GstHeifEngine *engine = NULL;
+
+  if (muxer->workers != NULL)
+    gst_worker_pool_free (muxer->workers);
+
   if (muxer->outpool != NULL)
     gst_object_unref (muxer->outpool);
 
-  if (muxer->engine != NULL) {
-    gst_heif_engine_free (muxer->engine);
-    muxer->engine = NULL;
-  }
+  while ((engine = g_async_queue_try_pop (muxer->engines)) != NULL)
+    gst_heif_engine_free (engine);
+
+  g_async_queue_unref (muxer->engines);
 
   g_rec_mutex_clear (&muxer->worklock);
 
@@ -896,6 +1019,19 @@ gst_heifmux_class_init (GstHeifMuxClass * klass)
           3, G_MAXUINT, DEFAULT_PROP_QUEUE_SIZE,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_WORKERS,
+      g_param_spec_uint ("workers", "Workers",
+          "Number of images muxed in parallel, output keeps the input order",
+          1, 16, DEFAULT_PROP_WORKERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_MAX_MEMORY,
+      g_param_spec_uint ("max-memory", "Max memory",
+          "Memory budget in MiB for the images being muxed, new input is "
+          "blocked once it is exceeded (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_PROP_MAX_MEMORY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 
   gst_element_class_set_static_metadata (element,
       "Heif muxer", "HEIF/Thumbnail/Muxer",
@@ -922,7 +1058,7 @@ gst_heifmux_init (GstHeifMux * muxer)
   muxer->sinkpad = NULL;
   muxer->srcpad = NULL;
 
-  muxer->engine = NULL;
+  muxer->engines = g_async_queue_new ();
   muxer->outpool = NULL;
 
   muxer->worktask = NULL;
@@ -930,6 +1066,13 @@ gst_heifmux_init (GstHeifMux * muxer)
   muxer->active = FALSE;
 
   muxer->queue_size = DEFAULT_PROP_QUEUE_SIZE;
+  muxer->n_workers = DEFAULT_PROP_WORKERS;
+  muxer->max_memory = DEFAULT_PROP_MAX_MEMORY;
+
+  muxer->workers = gst_worker_pool_new (gst_heifmux_process_job,
+      gst_heifmux_submit_output, gst_heifmux_job_free, muxer);
+  if (muxer->workers == NULL)
+    GST_ERROR_OBJECT (muxer, "Failed to create worker pool!");
 
   template = gst_static_pad_template_get (&gst_heifmux_main_sink_template);
   muxer->sinkpad = g_object_new (GST_TYPE_HEIFMUX_SINK_PAD, "name", "sink",
@@ -10,6 +10,7 @@
 #include <gst/video/video.h>
 #include <gst/base/gstdataqueue.h>
 #include <gst/utils/common-utils.h>
+#include <gst/utils/worker-pool.h>
 
 #include "heifmuxpads.h"
 #include "heif-engine.h"
@@ -63,11 +64,15 @@ struct _GstHeifMux {
   /// Condition for push/pop buffers from the queues.
   GCond             wakeup;
 
-  /// Heif engine.
-  GstHeifEngine     *engine;
+  /// Worker threads muxing several images in parallel.
+  GstWorkerPool     *workers;
+  /// Idle heif engines, one is used by each worker at a time.
+  GAsyncQueue       *engines;
 
   /// Properties.
   guint             queue_size;
+  guint             n_workers;
+  guint             max_memory;
 };
 
 struct _GstHeifMuxClass {
@@ -151,6 +151,20 @@ gst_heifmux_src_pad_query (GstPad * pad, GstObject * parent, GstQuery * query)
   return gst_pad_query_default (pad, parent, query);
 }
 
+void
+gst_heifmux_src_pad_set_flushing (GstHeifMuxSrcPad * srcpad, gboolean flushing)
+{
+  gst_data_queue_set_flushing (srcpad->buffers, flushing);
+  gst_data_queue_flush (srcpad->buffers);
+
+  // The worker task pauses itself once the queue is flushing.
+  if (flushing)
+    gst_pad_pause_task (GST_PAD (srcpad));
+  else
+    gst_pad_start_task (GST_PAD (srcpad), gst_heifmux_src_pad_worker_task,
+        srcpad, NULL);
+}
+
 gboolean
 gst_heifmux_src_pad_activate_mode (GstPad * pad, GstObject * parent,
     GstPadMode mode, gboolean active)
@@ -144,6 +144,9 @@ gboolean gst_heifmux_src_pad_query (GstPad * pad, GstObject * parent,
 gboolean gst_heifmux_src_pad_activate_mode (GstPad * pad, GstObject * parent,
                                             GstPadMode mode, gboolean active);
 
+void gst_heifmux_src_pad_set_flushing (GstHeifMuxSrcPad * srcpad,
+                                       gboolean flushing);
+
 G_END_DECLS
 
 #endif // __GST_HEIFMUX_PADS_H__
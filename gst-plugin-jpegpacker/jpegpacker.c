@@ -13,6 +13,7 @@
 #include <gst/base/gstbytewriter.h>
 
 #include <gst/utils/common-utils.h>
+#include <gst/utils/worker-pool.h>
 #include "jpegpacker-utils.h"
 
 #define GST_CAT_DEFAULT gst_jpeg_packer_debug
@@ -20,13 +21,17 @@ GST_DEBUG_CATEGORY (gst_jpeg_packer_debug);
 
 G_DEFINE_TYPE (GstJpegPacker, gst_jpeg_packer, GST_TYPE_ELEMENT);
 
-#define DEFAULT_PROP_PACK_TYPE PACK_TYPE_EXIF
+#define DEFAULT_PROP_PACK_TYPE  PACK_TYPE_EXIF
+#define DEFAULT_PROP_WORKERS    2
+#define DEFAULT_PROP_MAX_MEMORY 0
 
 #define GST_TYPE_JPEG_PACKER_PACK_TYPE (gst_jpeg_packer_pack_type_get_type())
 
 enum {
   PROP_0,
   PROP_PACK_TYPE,
+  PROP_WORKERS,
+  PROP_MAX_MEMORY,
 };
 
 typedef struct _GstJpegSection
@@ -46,6 +51,31 @@ typedef struct _GstJpegSection
   gboolean     owned;
 } GstJpegSection;
 
+typedef struct _GstJpegPackerJob
+{
+  /// Element which submitted the job
+  GstJpegPacker *packer;
+
+  /// Primary image followed by the thumbnail images
+  GstBufferList *list;
+
+  /// Parse jpeg images to sections
+  GList         *sections;
+
+  /// Scan data (primary) and its offset in the primary image buffer
+  const guint8  *primary_data;
+  guint         primary_size;
+  guint         primary_offset;
+
+  /// Scan data (thumbnail) and the index of its buffer in the list
+  const guint8  *thumbnail_data;
+  guint         thumbnail_size;
+  guint         thumbnail_idx;
+
+  /// Output jpeg interchange format at the time of submission
+  GstPackerType pack_type;
+} GstJpegPackerJob;
+
 static GType
 gst_jpeg_packer_pack_type_get_type (void)
 {
@@ -103,15 +133,15 @@ static void
 gst_jpeg_section_free (gpointer data, gpointer user_data)
 {
   GstJpegSection *section = (GstJpegSection*)data;
-  GstJpegPacker *packer = (GstJpegPacker *)user_data;
+  GstJpegPackerJob *job = (GstJpegPackerJob *)user_data;
 
   if (!section)
     return;
 
   switch (section->type) {
     case JPEG_MARKER_APP0:
-      if (section->owned && packer &&
-          (section->size - 2 - packer->thumbnail_size == 6))
+      if (section->owned && job &&
+          (section->size - 2 - job->thumbnail_size == 6))
         // APP0 section with exif extension data
         jfif_data_ext_free ((guint8 *)section->data);
       else if (section->owned && (section->size - 2 == 14))
@@ -149,6 +179,12 @@ gst_jpeg_packer_set_property (GObject * object, guint prop_id,
     case PROP_PACK_TYPE:
       packer->pack_type = g_value_get_enum (value);
       break;
+    case PROP_WORKERS:
+      packer->n_workers = g_value_get_uint (value);
+      break;
+    case PROP_MAX_MEMORY:
+      packer->max_memory = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -165,6 +201,12 @@ gst_jpeg_packer_get_property (GObject * object, guint prop_id,
     case PROP_PACK_TYPE:
       g_value_set_enum (value, packer->pack_type);
       break;
+    case PROP_WORKERS:
+      g_value_set_uint (value, packer->n_workers);
+      break;
+    case PROP_MAX_MEMORY:
+      g_value_set_uint (value, packer->max_memory);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -182,14 +224,8 @@ gst_jpeg_packer_finalize (GObject * object)
   if (packer->buffers)
     g_async_queue_unref (packer->buffers);
 
-  if (packer->sections) {
-    g_list_foreach (packer->sections, gst_jpeg_section_free, packer);
-    g_list_free (packer->sections);
-    packer->sections = NULL;
-  }
-
-  packer->primary_data = NULL;
-  packer->thumbnail_data = NULL;
+  if (packer->workers)
+    gst_worker_pool_free (packer->workers);
 
   G_OBJECT_CLASS (gst_jpeg_packer_parent_class)->finalize (object);
 }
@@ -272,6 +308,7 @@ gst_jpeg_packer_release_pad (GstElement * element, GstPad * pad)
 static gboolean
 gst_jpeg_packer_parse_image (GstBuffer **buffer, guint idx, gpointer user_data)
 {
+  GstJpegPackerJob *job = NULL;
   GstJpegPacker *packer = NULL;
   GstBuffer *buf = NULL;
   GstJpegSection *section = NULL;
@@ -286,7 +323,8 @@ gst_jpeg_packer_parse_image (GstBuffer **buffer, guint idx, gpointer user_data)
   g_return_val_if_fail (user_data != NULL, FALSE);
 
   buf = *buffer;
-  packer = (GstJpegPacker *)user_data;
+  job = (GstJpegPackerJob *)user_data;
+  packer = job->packer;
 
   gst_buffer_map (buf, &map, GST_MAP_READ);
   gst_byte_reader_init (&reader, map.data, map.size);
@@ -328,7 +366,7 @@ gst_jpeg_packer_parse_image (GstBuffer **buffer, guint idx, gpointer user_data)
         case JPEG_MARKER_SOI:
         case JPEG_MARKER_EOI:
           section = gst_jpeg_section_new (marker, 0, NULL, FALSE);
-          packer->sections = g_list_append (packer->sections, section);
+          job->sections = g_list_append (job->sections, section);
 
           GST_DEBUG_OBJECT (packer, "marker = %2x", section->type);
           break;
@@ -340,7 +378,7 @@ gst_jpeg_packer_parse_image (GstBuffer **buffer, guint idx, gpointer user_data)
             goto error;
 
           section = gst_jpeg_section_new (marker, section_size, data, FALSE);
-          packer->sections = g_list_append (packer->sections, section);
+          job->sections = g_list_append (job->sections, section);
 
           GST_DEBUG_OBJECT (packer, "marker = %2x, size = %u", section->type,
               section->size);
@@ -353,13 +391,14 @@ gst_jpeg_packer_parse_image (GstBuffer **buffer, guint idx, gpointer user_data)
         break;
       } else if (marker == JPEG_MARKER_SOS) {
         // Scan data
-        packer->primary_size = eoi_pos - gst_byte_reader_get_pos (&reader);
+        job->primary_offset = gst_byte_reader_get_pos (&reader);
+        job->primary_size = eoi_pos - job->primary_offset;
 
-        if (!gst_byte_reader_get_data (&reader, packer->primary_size,
-            &packer->primary_data))
+        if (!gst_byte_reader_get_data (&reader, job->primary_size,
+            &job->primary_data))
           goto error;
 
-        GST_DEBUG_OBJECT (packer, "Primary data, size = %u", packer->primary_size);
+        GST_DEBUG_OBJECT (packer, "Primary data, size = %u", job->primary_size);
       }
 
       if (!gst_byte_reader_peek_uint8 (&reader, &marker))
@@ -367,20 +406,21 @@ gst_jpeg_packer_parse_image (GstBuffer **buffer, guint idx, gpointer user_data)
     }
   } else {
     // Thumbnail image
-    packer->thumbnail_size = map.size;
-    if (packer->thumbnail_size > 0xFFFD) {
+    job->thumbnail_idx = idx;
+    job->thumbnail_size = map.size;
+    if (job->thumbnail_size > 0xFFFD) {
       GST_ERROR_OBJECT (packer, "Thumbnail(%u) exceeds maximum size(0xFFFD)",
-          packer->thumbnail_size);
+          job->thumbnail_size);
 
       gst_buffer_unmap (buf, &map);
       return FALSE;
     }
 
-    if (!gst_byte_reader_get_data (&reader, packer->thumbnail_size,
-        &packer->thumbnail_data))
+    if (!gst_byte_reader_get_data (&reader, job->thumbnail_size,
+        &job->thumbnail_data))
       goto error;
 
-    GST_DEBUG_OBJECT (packer, "Thumbnail data, size = %u", packer->thumbnail_size);
+    GST_DEBUG_OBJECT (packer, "Thumbnail data, size = %u", job->thumbnail_size);
   }
 
   gst_buffer_unmap (buf, &map);
@@ -397,7 +437,7 @@ error:
 }
 
 static gboolean
-gst_jpeg_packer_mangle (GstJpegPacker *packer)
+gst_jpeg_packer_mangle (GstJpegPacker *packer, GstJpegPackerJob *job)
 {
   GstJpegSection *section = NULL, *sec_tmp = NULL;
   GList *iter = NULL, *iter_tmp = NULL;
@@ -405,51 +445,52 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
   guint16 section_size = 0;
 
   g_return_val_if_fail (packer != NULL, FALSE);
+  g_return_val_if_fail (job != NULL, FALSE);
 
   // Jpeg sections should contain SOI, SOS and EOI at least
-  if (g_list_length (packer->sections) < 3) {
+  if (g_list_length (job->sections) < 3) {
     GST_ERROR_OBJECT (packer, "Wrong parsing results");
     return FALSE;
   }
 
   /* Make sure sections orders (SOI - others - EOI) */
   // SOI
-  iter = g_list_first (packer->sections);
+  iter = g_list_first (job->sections);
   while (iter != NULL) {
     sec_tmp = (GstJpegSection *) iter->data;
 
     if (sec_tmp->type == JPEG_MARKER_SOI) {
-      if (iter == g_list_first (packer->sections)) {
+      if (iter == g_list_first (job->sections)) {
         break;
       } else {
         // Move SOI as head
-        packer->sections = g_list_remove_link (packer->sections, iter);
-        packer->sections = g_list_prepend (packer->sections, iter->data);
+        job->sections = g_list_remove_link (job->sections, iter);
+        job->sections = g_list_prepend (job->sections, iter->data);
       }
 
       GST_DEBUG_OBJECT (packer, "SOI section index: %d",
-          g_list_position (packer->sections, iter));
+          g_list_position (job->sections, iter));
       break;
     }
 
     iter = g_list_next (iter);
   }
   // EOI
-  iter = g_list_last (packer->sections);
+  iter = g_list_last (job->sections);
   while (iter != NULL) {
     sec_tmp = (GstJpegSection *) iter->data;
 
     if (sec_tmp->type == JPEG_MARKER_EOI) {
-      if (iter == g_list_last (packer->sections)) {
+      if (iter == g_list_last (job->sections)) {
         break;
       } else {
         // Move EOI as tail
-        packer->sections = g_list_remove_link (packer->sections, iter);
-        packer->sections = g_list_append (packer->sections, iter->data);
+        job->sections = g_list_remove_link (job->sections, iter);
+        job->sections = g_list_append (job->sections, iter->data);
       }
 
       GST_DEBUG_OBJECT (packer, "EOI section index: %d",
-          g_list_position (packer->sections, iter));
+          g_list_position (job->sections, iter));
       break;
     }
 
@@ -457,8 +498,8 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
   }
 
   // Clean original APPx section
-  iter = g_list_first (packer->sections);
-  switch (packer->pack_type) {
+  iter = g_list_first (job->sections);
+  switch (job->pack_type) {
     case PACK_TYPE_EXIF:
       // Remove all APP0 sections which contain jfif data
       while (iter != NULL) {
@@ -467,7 +508,7 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
 
         if (sec_tmp->type == JPEG_MARKER_APP0) {
           gst_jpeg_section_free (sec_tmp, NULL);
-          packer->sections = g_list_delete_link (packer->sections, iter);
+          job->sections = g_list_delete_link (job->sections, iter);
 
           GST_DEBUG_OBJECT (packer, "Cleaned original APP0 section for EXIF");
         }
@@ -483,7 +524,7 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
 
         if (sec_tmp->type == JPEG_MARKER_APP1) {
           gst_jpeg_section_free (sec_tmp, NULL);
-          packer->sections = g_list_delete_link (packer->sections, iter);
+          job->sections = g_list_delete_link (job->sections, iter);
 
           GST_DEBUG_OBJECT (packer, "Cleaned original APP1 section for JFIF");
         }
@@ -496,10 +537,10 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
   }
 
   // Create APPx section
-  switch (packer->pack_type) {
+  switch (job->pack_type) {
     case PACK_TYPE_EXIF:
       // Retrieve original APP1 section
-      iter = g_list_first (packer->sections);
+      iter = g_list_first (job->sections);
       sec_tmp = NULL;
       while (iter != NULL) {
         sec_tmp = (GstJpegSection *) iter->data;
@@ -513,9 +554,9 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
         GST_WARNING_OBJECT (packer, "Failed to retrieve APP1 section");
 
       // Create new exif data in case we have thumbnail data to fill
-      if (packer->thumbnail_size && packer->thumbnail_data != NULL) {
+      if (job->thumbnail_size && job->thumbnail_data != NULL) {
         if (!exif_data_create ((sec_tmp? sec_tmp->size: 0),
-            (sec_tmp? sec_tmp->data : NULL), packer->thumbnail_size,
+            (sec_tmp? sec_tmp->data : NULL), job->thumbnail_size,
             &section_size, &section_data)) {
           GST_ERROR_OBJECT (packer, "Failed to create EXIF data");
           return FALSE;
@@ -530,12 +571,12 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
             Data: variable bytes,
                   EXIF data size + Thumbnail data size.
         */
-        if ((section_size + packer->thumbnail_size) > 0xFFFD) {
+        if ((section_size + job->thumbnail_size) > 0xFFFD) {
           GST_WARNING_OBJECT (packer, "APP1 exceeds maximum size, cut");
-          packer->thumbnail_size = 0xFFFD - section_size;
+          job->thumbnail_size = 0xFFFD - section_size;
         }
 
-        section_size += packer->thumbnail_size;
+        section_size += job->thumbnail_size;
 
         section = gst_jpeg_section_new (JPEG_MARKER_APP1, section_size + 2,
             section_data, TRUE);
@@ -549,13 +590,13 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
         // Remove original APP1 section
         if (iter && section) {
           gst_jpeg_section_free (sec_tmp, NULL);
-          packer->sections = g_list_delete_link (packer->sections, iter);
+          job->sections = g_list_delete_link (job->sections, iter);
 
           GST_DEBUG_OBJECT (packer, "Removed original APP1 section");
         }
 
         // APP1 section should be inserted right after SOI
-        packer->sections = g_list_insert (packer->sections, section, 1);
+        job->sections = g_list_insert (job->sections, section, 1);
 
         GST_INFO_OBJECT (packer, "Added marker = %2x, size = %u", section->type,
             section->size);
@@ -563,7 +604,7 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
       break;
     case PACK_TYPE_JFIF:
       // Retrieve original APP0 section
-      iter = g_list_first (packer->sections);
+      iter = g_list_first (job->sections);
       while (iter != NULL) {
         sec_tmp = (GstJpegSection *) iter->data;
         if (sec_tmp->type == JPEG_MARKER_APP0)
@@ -604,15 +645,15 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
           return FALSE;
         }
 
-        packer->sections = g_list_insert (packer->sections, section, 1);
+        job->sections = g_list_insert (job->sections, section, 1);
 
         GST_INFO_OBJECT (packer, "Added marker = %2x, size = %u", section->type,
             section->size);
       }
 
-      if (packer->thumbnail_size && packer->thumbnail_data != NULL) {
+      if (job->thumbnail_size && job->thumbnail_data != NULL) {
         // Retrieve APP0 extension section, skip SOI and APP0 section
-        iter = g_list_nth (packer->sections, 2);
+        iter = g_list_nth (job->sections, 2);
         while (iter != NULL) {
           sec_tmp = (GstJpegSection *) iter->data;
           if (sec_tmp->type == JPEG_MARKER_APP0)
@@ -638,13 +679,13 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
             Data: 6 bytes + variable bytes =
                   5 bytes ("JFXX\0\0") + 1 byte (ext code) + Thumbnail data size.
         */
-        if ((section_size + packer->thumbnail_size) > 0xFFFD) {
+        if ((section_size + job->thumbnail_size) > 0xFFFD) {
           GST_WARNING_OBJECT (packer, "APP0 exceeds maximum size, cut");
 
-          packer->thumbnail_size = 0xFFFD - section_size;
+          job->thumbnail_size = 0xFFFD - section_size;
         }
 
-        section_size += packer->thumbnail_size;
+        section_size += job->thumbnail_size;
 
         section = gst_jpeg_section_new (JPEG_MARKER_APP0, section_size + 2,
             section_data, TRUE);
@@ -657,13 +698,13 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
 
         if (iter && section) {
           gst_jpeg_section_free (sec_tmp, NULL);
-          packer->sections = g_list_delete_link (packer->sections, iter);
+          job->sections = g_list_delete_link (job->sections, iter);
 
           GST_DEBUG_OBJECT (packer, "Removed original APP0 extention section");
         }
 
         // APP0 extension section should be inserted right after APP0 section
-        packer->sections = g_list_insert (packer->sections, section, 2);
+        job->sections = g_list_insert (job->sections, section, 2);
 
         GST_INFO_OBJECT (packer, "Added marker = %2x, size = %u", section->type,
             section->size);
@@ -677,66 +718,86 @@ gst_jpeg_packer_mangle (GstJpegPacker *packer)
   return TRUE;
 }
 
+static void
+gst_jpeg_packer_append_header (GstBuffer *buffer, GstByteWriter *writer)
+{
+  guint size = gst_byte_writer_get_size (writer);
+  guint8 *data = NULL;
+
+  if (size == 0)
+    return;
+
+  // Move the header bytes written so far into a new memory block.
+  data = gst_byte_writer_reset_and_get_data (writer);
+  gst_buffer_append_memory (buffer,
+      gst_memory_new_wrapped (0, data, size, 0, size, data, g_free));
+}
+
+static gboolean
+gst_jpeg_packer_append_shared (GstBuffer *buffer, GstByteWriter *writer,
+    GstBuffer *inbuf, gsize offset, gsize size)
+{
+  gst_jpeg_packer_append_header (buffer, writer);
+
+  // Shares the input memory, it is only copied if it can't be shared.
+  return gst_buffer_copy_into (buffer, inbuf, GST_BUFFER_COPY_MEMORY,
+      offset, size);
+}
+
+/*
+  Output buffer layout
+    ----------------------------------------------------------------------
+    | Headers | Thumbnail | Headers ... SOS | Primary scan data | EOI |
+    ----------------------------------------------------------------------
+
+    Headers are written into small newly allocated memory blocks while the
+    thumbnail and the primary scan data are memory blocks shared with the
+    input buffers. Downstream mapping the whole buffer triggers a merge.
+*/
 static GstBuffer *
-gst_jpeg_packer_recombine (GstJpegPacker *packer, GstBufferList *bufs)
+gst_jpeg_packer_recombine (GstJpegPacker *packer, GstJpegPackerJob *job)
 {
   GstJpegSection *section = NULL;
-  GstBuffer *buffer = NULL;
-  GstByteWriter *writer;
-  GstMapInfo map;
+  GstBufferList *bufs = NULL;
+  GstBuffer *buffer = NULL, *primary = NULL, *thumbnail = NULL;
+  GstByteWriter writer;
   GList *list = NULL, *r_maps = NULL;
-  guint size = 0;
+  gboolean status = TRUE;
 
   g_return_val_if_fail (packer != NULL, NULL);
-  g_return_val_if_fail (bufs != NULL, NULL);
-  g_return_val_if_fail (packer->sections != NULL, NULL);
+  g_return_val_if_fail (job != NULL, NULL);
+  g_return_val_if_fail (job->list != NULL, NULL);
+  g_return_val_if_fail (job->sections != NULL, NULL);
+
+  bufs = job->list;
 
   // Check SOI and EOI
-  list = g_list_first (packer->sections);
+  list = g_list_first (job->sections);
   section = (GstJpegSection *)list->data;
   if (section->type != JPEG_MARKER_SOI) {
     GST_ERROR_OBJECT (packer, "SOI is not the first one");
     return NULL;
   }
 
-  list = g_list_last (packer->sections);
+  list = g_list_last (job->sections);
   section = (GstJpegSection *)list->data;
   if (section->type != JPEG_MARKER_EOI) {
     GST_ERROR_OBJECT (packer, "EOI is not the last one");
     return NULL;
   }
 
-  // Calculate total size
-  list = g_list_first (packer->sections);
-  while (list != NULL) {
-    section = (GstJpegSection *)list->data;
-    /*
-      Jpeg section size
-        SOI:    (2 + 0) Bytes
-        EOI:    (2 + 0) Bytes
-        Others: (2 + size) Bytes
-    */
-    size += (section->size)? (2 + section->size): 2;
-    list = g_list_next (list);
-  }
-  size += (packer->primary_size + packer->thumbnail_size);
+  primary = gst_buffer_list_get (bufs, 0);
 
-  buffer = gst_buffer_new_allocate (NULL, size, NULL);
-  if (!buffer) {
-    GST_ERROR_OBJECT (packer, "Failed to allocate a new GstBuffer");
-    return NULL;
-  }
-  GST_DEBUG_OBJECT (packer, "Allocated size %" G_GSIZE_FORMAT,
-      gst_buffer_get_size (buffer));
+  if (job->thumbnail_size && job->thumbnail_data != NULL)
+    thumbnail = gst_buffer_list_get (bufs, job->thumbnail_idx);
+
+  buffer = gst_buffer_new ();
 
   // Copy buffer metadata
-  gst_buffer_copy_into (buffer, gst_buffer_list_get (bufs, 0),
+  gst_buffer_copy_into (buffer, primary,
       GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
 
-  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
-  writer = gst_byte_writer_new_with_data (map.data, map.size, TRUE);
-
-  // Input buffers are mapped again to copy data
+  // Input buffers are mapped again as the sections point to their data
   for (guint i = 0; i < gst_buffer_list_length (bufs); ++i) {
     GstMapInfo *m = g_new0 (GstMapInfo, 1);
 
@@ -744,79 +805,83 @@ gst_jpeg_packer_recombine (GstJpegPacker *packer, GstBufferList *bufs)
     r_maps = g_list_append (r_maps, m);
   }
 
+  gst_byte_writer_init_with_size (&writer, 1024, FALSE);
+
   // Write data to output buffer
-  list = g_list_first (packer->sections);
-  while (list != NULL) {
+  list = g_list_first (job->sections);
+  while (list != NULL && status) {
     section = (GstJpegSection *)list->data;
-    gboolean status = TRUE;
 
     // Section Identifier
-    status &= gst_byte_writer_put_uint8 (writer, 0xff);
+    status &= gst_byte_writer_put_uint8 (&writer, 0xff);
 
     // Section Type
-    status &= gst_byte_writer_put_uint8 (writer, section->type);
+    status &= gst_byte_writer_put_uint8 (&writer, section->type);
 
     GST_DEBUG_OBJECT (packer, "marker = %2x, size = %u", section->type,
         section->size);
 
     if (section->size) {
       // Section Length
-      status &= gst_byte_writer_put_uint16_be (writer, section->size);
+      status &= gst_byte_writer_put_uint16_be (&writer, section->size);
 
       // Section Data
       switch (section->type) {
         case JPEG_MARKER_APP0:
-          if (section->owned &&
-              (section->size - 2 - packer->thumbnail_size == 6)) {
+          if (section->owned && thumbnail != NULL &&
+              (section->size - 2 - job->thumbnail_size == 6)) {
             // APP0 extension section
-            status &= gst_byte_writer_put_data (writer, section->data,
-                section->size - 2 - packer->thumbnail_size);
+            status &= gst_byte_writer_put_data (&writer, section->data,
+                section->size - 2 - job->thumbnail_size);
 
-            status &= gst_byte_writer_put_data (writer, packer->thumbnail_data,
-                packer->thumbnail_size);
+            status &= gst_jpeg_packer_append_shared (buffer, &writer,
+                thumbnail, 0, job->thumbnail_size);
             break;
           }
 
-          status &= gst_byte_writer_put_data (writer, section->data,
+          status &= gst_byte_writer_put_data (&writer, section->data,
               section->size - 2);
           break;
         case JPEG_MARKER_APP1:
-          if (section->owned) {
+          if (section->owned && thumbnail != NULL) {
             // APP1 section
-            status &= gst_byte_writer_put_data (writer, section->data,
-                section->size - 2 - packer->thumbnail_size);
+            status &= gst_byte_writer_put_data (&writer, section->data,
+                section->size - 2 - job->thumbnail_size);
 
-            status &= gst_byte_writer_put_data (writer, packer->thumbnail_data,
-                packer->thumbnail_size);
+            status &= gst_jpeg_packer_append_shared (buffer, &writer,
+                thumbnail, 0, job->thumbnail_size);
             break;
           }
 
-          status &= gst_byte_writer_put_data (writer, section->data,
+          status &= gst_byte_writer_put_data (&writer, section->data,
               section->size - 2);
           break;
         default:
-          status &= gst_byte_writer_put_data (writer, section->data,
+          status &= gst_byte_writer_put_data (&writer, section->data,
               section->size - 2);
           break;
       }
     }
 
     if (section->type == JPEG_MARKER_SOS) {
-      status &= gst_byte_writer_put_data (writer, packer->primary_data,
-          packer->primary_size);
+      status &= gst_jpeg_packer_append_shared (buffer, &writer, primary,
+          job->primary_offset, job->primary_size);
 
-      GST_DEBUG_OBJECT (packer, "Scan data, size = %u", packer->primary_size);
+      GST_DEBUG_OBJECT (packer, "Scan data, size = %u", job->primary_size);
     }
 
-    if (!status) {
-      GST_WARNING_OBJECT (packer, "Failed to write to output buffer");
+    list = g_list_next (list);
+  }
 
-      gst_buffer_unref (buffer);
-      buffer = NULL;
-      break;
-    }
+  // Remaining sections after the scan data
+  gst_jpeg_packer_append_header (buffer, &writer);
 
-    list = g_list_next (list);
+  if (!status) {
+    GST_WARNING_OBJECT (packer, "Failed to write to output buffer");
+    gst_clear_buffer (&buffer);
+  } else {
+    GST_DEBUG_OBJECT (packer, "Output size %" G_GSIZE_FORMAT " in %u memory "
+        "blocks", gst_buffer_get_size (buffer), gst_buffer_n_memory (buffer));
   }
 
   // Clean
@@ -828,22 +893,85 @@ gst_jpeg_packer_recombine (GstJpegPacker *packer, GstBufferList *bufs)
   }
   g_list_free (r_maps);
 
-  if (buffer)
-    gst_buffer_unmap (buffer, &map);
+  gst_byte_writer_reset (&writer);
+
+  return buffer;
+}
+
+static void
+gst_jpeg_packer_job_free (gpointer data)
+{
+  GstJpegPackerJob *job = (GstJpegPackerJob *)data;
+
+  if (job->sections) {
+    g_list_foreach (job->sections, gst_jpeg_section_free, job);
+    g_list_free (job->sections);
+  }
+
+  gst_buffer_list_unref (job->list);
+  g_slice_free (GstJpegPackerJob, job);
+}
+
+static gsize
+gst_jpeg_packer_job_size (GstBufferList *list)
+{
+  gsize size = 0;
+
+  // Output shares the input memory, only the new headers are allocated.
+  for (guint i = 0; i < gst_buffer_list_length (list); ++i)
+    size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+
+  return size;
+}
+
+static GstBuffer *
+gst_jpeg_packer_process_job (gpointer data, gpointer user_data)
+{
+  GstJpegPacker *packer = GST_JPEG_PACKER (user_data);
+  GstJpegPackerJob *job = (GstJpegPackerJob *)data;
+  GstBuffer *buffer = NULL;
+
+  GST_DEBUG_OBJECT (packer, "Start process image");
 
-  gst_byte_writer_free (writer);
+  if (!gst_buffer_list_foreach (job->list, gst_jpeg_packer_parse_image, job)) {
+    GST_ERROR_OBJECT (packer, "Failed to parse images");
+    return NULL;
+  }
+
+  if (job->thumbnail_size && job->thumbnail_data != NULL) {
+    if (!gst_jpeg_packer_mangle (packer, job)) {
+      GST_ERROR_OBJECT (packer, "Failed to mangle sections");
+      return NULL;
+    }
+  }
+
+  buffer = gst_jpeg_packer_recombine (packer, job);
+
+  GST_DEBUG_OBJECT (packer, "End process image");
 
   return buffer;
 }
 
+static void
+gst_jpeg_packer_push_output (GstBuffer *buffer, gpointer user_data)
+{
+  GstJpegPacker *packer = GST_JPEG_PACKER (user_data);
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (packer, "Pushing buffer %p", buffer);
+
+  ret = gst_pad_push (packer->srcpad, buffer);
+  if (ret < GST_FLOW_OK)
+    GST_ERROR_OBJECT (packer, "Failed to push buffer downstream.");
+}
+
 static void
 gst_jpeg_packer_srcpad_task (gpointer user_data)
 {
   GstJpegPacker *packer = NULL;
   GstBufferList *list = NULL;
-  GstBuffer *buffer = NULL;
+  GstJpegPackerJob *job = NULL;
   GstTaskState state = GST_TASK_STARTED;
-  GstFlowReturn ret = GST_FLOW_OK;
 
   g_return_if_fail (user_data != NULL);
 
@@ -867,49 +995,22 @@ gst_jpeg_packer_srcpad_task (gpointer user_data)
 
     gst_buffer_list_unref (list);
 
-    gst_pad_push_event (packer->srcpad, gst_event_new_eos ());
-    return;
-  }
-
-  GST_DEBUG_OBJECT (packer, "Start process image");
-
-  if (!gst_buffer_list_foreach (list, gst_jpeg_packer_parse_image, packer)) {
-    GST_ERROR_OBJECT (packer, "Failed to parse images");
+    // Output all images which are still being packed before the EOS.
+    gst_worker_pool_drain (packer->workers);
 
-    gst_buffer_list_unref (list);
+    gst_pad_push_event (packer->srcpad, gst_event_new_eos ());
     return;
   }
 
-  if (packer->thumbnail_size && packer->thumbnail_data != NULL) {
-    if (!gst_jpeg_packer_mangle (packer)) {
-      g_list_foreach (packer->sections, gst_jpeg_section_free, packer);
-      g_list_free (packer->sections);
-      packer->sections = NULL;
-
-      gst_buffer_list_unref (list);
+  job = g_slice_new0 (GstJpegPackerJob);
+  job->packer = packer;
+  job->list = list;
+  job->pack_type = packer->pack_type;
 
-      GST_DEBUG_OBJECT (packer, "Cleared all sections");
-      return;
-    }
-  }
-
-  buffer = gst_jpeg_packer_recombine (packer, list);
-
-  GST_DEBUG_OBJECT (packer, "End process image");
-
-  gst_buffer_list_unref (list);
-
-  g_list_foreach (packer->sections, gst_jpeg_section_free, packer);
-  g_list_free (packer->sections);
-  packer->sections = NULL;
-
-  ret = gst_pad_push (packer->srcpad, buffer);
-  if (ret < GST_FLOW_OK) {
-    GST_ERROR_OBJECT (packer, "Failed to push buffer downstream.");
-    return;
-  }
-
-  GST_DEBUG_OBJECT (packer, "Pushed buffer %p", buffer);
+  // Pack asynchronously, blocks while the worker pool limits are reached.
+  if (!gst_worker_pool_submit (packer->workers, job,
+          gst_jpeg_packer_job_size (list)))
+    GST_DEBUG_OBJECT (packer, "Worker pool is flushing, dropped images");
 }
 
 static void
@@ -951,10 +1052,17 @@ gst_jpeg_packer_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_worker_pool_set_limits (packer->workers, packer->n_workers,
+          (gsize) packer->max_memory * 1024 * 1024);
+      gst_worker_pool_set_flushing (packer->workers, FALSE);
+
       gst_collect_pads_start (packer->collectpad);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_collect_pads_stop (packer->collectpad);
+
+      // Release a blocked srcpad task and discard the pending jobs.
+      gst_worker_pool_set_flushing (packer->workers, TRUE);
       break;
     default:
       break;
@@ -1045,6 +1153,38 @@ gst_jpeg_packer_srcpad_event (GstPad * pad, GstObject * parent, GstEvent * event
   return success;
 }
 
+static gboolean
+gst_jpeg_packer_collectpads_event (GstCollectPads *pads, GstCollectData *data,
+    GstEvent *event, gpointer user_data)
+{
+  GstJpegPacker *packer = GST_JPEG_PACKER (user_data);
+  GstBufferList *list = NULL;
+  gboolean success = TRUE;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      // Forward first in order to release an output push blocked downstream.
+      success = gst_collect_pads_event_default (pads, data, event, FALSE);
+
+      // Release a blocked srcpad task and discard the pending jobs.
+      gst_worker_pool_set_flushing (packer->workers, TRUE);
+
+      // Drop the collected images which were not submitted yet.
+      while ((packer->buffers != NULL) &&
+          (list = g_async_queue_try_pop (packer->buffers)) != NULL)
+        gst_buffer_list_unref (list);
+
+      return success;
+    case GST_EVENT_FLUSH_STOP:
+      gst_worker_pool_set_flushing (packer->workers, FALSE);
+      break;
+    default:
+      break;
+  }
+
+  return gst_collect_pads_event_default (pads, data, event, FALSE);
+}
+
 static GstFlowReturn
 gst_jpeg_packer_collectpads_collected (GstCollectPads *pads, gpointer user_data)
 {
@@ -1130,6 +1270,19 @@ gst_jpeg_packer_class_init (GstJpegPackerClass *klass)
           "Output JPEG interchange format",
           GST_TYPE_JPEG_PACKER_PACK_TYPE, DEFAULT_PROP_PACK_TYPE,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_WORKERS,
+      g_param_spec_uint ("workers", "Workers",
+          "Number of images packed in parallel, output keeps the input order",
+          1, 16, DEFAULT_PROP_WORKERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_MAX_MEMORY,
+      g_param_spec_uint ("max-memory", "Max memory",
+          "Memory budget in MiB for the images being packed, new input is "
+          "blocked once it is exceeded (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_PROP_MAX_MEMORY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 
   gst_element_class_add_static_pad_template (element,
       &gst_jpeg_packer_src_pad_template);
@@ -1168,12 +1321,18 @@ gst_jpeg_packer_init (GstJpegPacker *packer)
 
   gst_collect_pads_set_function (packer->collectpad,
       gst_jpeg_packer_collectpads_collected, packer);
+  gst_collect_pads_set_event_function (packer->collectpad,
+      gst_jpeg_packer_collectpads_event, packer);
 
   packer->buffers = g_async_queue_new ();
-  packer->primary_data = NULL;
-  packer->primary_size = 0;
-  packer->thumbnail_data = NULL;
-  packer->thumbnail_size = 0;
+
+  packer->n_workers = DEFAULT_PROP_WORKERS;
+  packer->max_memory = DEFAULT_PROP_MAX_MEMORY;
+
+  packer->workers = gst_worker_pool_new (gst_jpeg_packer_process_job,
+      gst_jpeg_packer_push_output, gst_jpeg_packer_job_free, packer);
+  if (!packer->workers)
+    GST_ERROR_OBJECT (packer, "Failed to create worker pool");
 
   GST_INFO_OBJECT (packer, "JpegPacker plugin instance inited.");
 }
@@ -8,6 +8,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstcollectpads.h>
+#include <gst/utils/worker-pool.h>
 
 G_BEGIN_DECLS
 
@@ -43,19 +44,17 @@ struct _GstJpegPacker {
   /// Internal queue to save a bundle of input buffers
   GAsyncQueue    *buffers;
 
-  /// Parse jpeg images to sections
-  GList          *sections;
-
-  /// Scan data (primary)
-  const guint8   *primary_data;
-  guint          primary_size;
-
-  /// Scan data (thumbnail)
-  const guint8   *thumbnail_data;
-  guint          thumbnail_size;
+  /// Worker threads packing several images in parallel
+  GstWorkerPool  *workers;
 
   /// Output jpeg interchange format
   GstPackerType  pack_type;
+
+  /// Number of worker threads
+  guint          n_workers;
+
+  /// Memory budget of the worker pool in MiB
+  guint          max_memory;
 };
 
 struct _GstJpegPackerClass {
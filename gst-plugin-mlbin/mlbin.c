@@ -9,6 +9,7 @@
 
 #include <gst/ml/ml-info.h>
 #include <gst/utils/common-utils.h>
+#include <gst/cv/gstcvmeta.h>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -34,6 +35,17 @@ G_DEFINE_TYPE (GST_ML_BIN_STRUCT_NAME, gst_ml_bin, GST_TYPE_BIN);
 #define G_PARAM_SPEC_HAS_NAME(param, name) \
     (g_param_spec_get_name_quark (param) == g_quark_from_static_string (name))
 
+#define DEFAULT_PROP_ADAPTIVE         FALSE
+#define DEFAULT_PROP_MOTION_THRESHOLD 2.0
+#define DEFAULT_PROP_MAX_SKIP         10
+#define DEFAULT_PROP_EXTRAPOLATE      FALSE
+
+// Dimensions of the downscaled luma used for the frame activity estimation.
+#define GST_ML_BIN_THUMBNAIL_WIDTH    64
+#define GST_ML_BIN_THUMBNAIL_HEIGHT   36
+#define GST_ML_BIN_THUMBNAIL_SIZE \
+    (GST_ML_BIN_THUMBNAIL_WIDTH * GST_ML_BIN_THUMBNAIL_HEIGHT)
+
 enum {
   LAST_SIGNAL
 };
@@ -41,6 +53,30 @@ enum {
 enum
 {
   PROP_0,
+  PROP_ADAPTIVE,
+  PROP_MOTION_THRESHOLD,
+  PROP_MAX_SKIP,
+  PROP_EXTRAPOLATE,
+  PROP_LAST,
+};
+
+typedef struct _GstMLBinSkipEntry GstMLBinSkipEntry;
+
+/**
+ * GstMLBinSkipEntry:
+ * @timestamp: Timestamp of the frame for which inference was skipped.
+ * @width: Width of the frame in pixels.
+ * @height: Height of the frame in pixels.
+ * @mvectors: Optional GstCvMotionVector array attached to the frame.
+ *
+ * Frame for which inference was skipped and last results are re-attached.
+ */
+struct _GstMLBinSkipEntry
+{
+  GstClockTime timestamp;
+  gint         width;
+  gint         height;
+  GArray       *mvectors;
 };
 
 static GstStaticPadTemplate gst_ml_bin_sink_template =
@@ -208,6 +244,453 @@ gst_ml_bin_add_element (GstMLBin * mlbin, const gchar * factoryname,
   return element;
 }
 
+static GstMLBinSkipEntry *
+gst_ml_bin_skip_entry_new (GstBuffer * buffer, const GstVideoInfo * vinfo)
+{
+  GstMLBinSkipEntry *entry = g_slice_new0 (GstMLBinSkipEntry);
+  GstCvOptclFlowMeta *meta = gst_buffer_get_cv_optclflow_meta (buffer);
+
+  entry->timestamp = GST_BUFFER_TIMESTAMP (buffer);
+  entry->width = GST_VIDEO_INFO_WIDTH (vinfo);
+  entry->height = GST_VIDEO_INFO_HEIGHT (vinfo);
+
+  if ((meta != NULL) && (meta->mvectors != NULL))
+    entry->mvectors = g_array_ref (meta->mvectors);
+
+  return entry;
+}
+
+static void
+gst_ml_bin_skip_entry_free (GstMLBinSkipEntry * entry)
+{
+  if (entry->mvectors != NULL)
+    g_array_unref (entry->mvectors);
+
+  g_slice_free (GstMLBinSkipEntry, entry);
+}
+
+static void
+gst_ml_bin_reset_activity (GstMLBin * mlbin)
+{
+  GST_ML_BIN_LOCK (mlbin);
+
+  g_clear_pointer (&(mlbin->thumbnail), g_free);
+  mlbin->n_skipped = 0;
+
+  g_queue_clear_full (mlbin->skipped,
+      (GDestroyNotify) gst_ml_bin_skip_entry_free);
+  g_array_set_size (mlbin->lastmeta, 0);
+
+  GST_ML_BIN_UNLOCK (mlbin);
+}
+
+static gdouble
+gst_ml_bin_motion_activity (GstCvOptclFlowMeta * meta)
+{
+  gdouble activity = 0.0;
+  guint idx = 0;
+
+  // Mean magnitude (L1) of the motion vectors in pixels.
+  for (idx = 0; idx < meta->mvectors->len; idx++) {
+    GstCvMotionVector *mvector =
+        &g_array_index (meta->mvectors, GstCvMotionVector, idx);
+
+    activity += ABS (mvector->dx) + ABS (mvector->dy);
+  }
+
+  return activity / meta->mvectors->len;
+}
+
+static gboolean
+gst_ml_bin_frame_activity (GstMLBin * mlbin, GstBuffer * buffer,
+    gdouble * activity, guint8 ** thumbnail)
+{
+  GstVideoFrame frame;
+  const guint8 *data = NULL;
+  guint8 *pixels = NULL;
+  guint idx = 0, x = 0, y = 0, comp = 0;
+  gint stride = 0, pstride = 0, width = 0, height = 0;
+  gdouble delta = 0.0;
+
+  if (!gst_video_frame_map (&frame, mlbin->vinfo, buffer, GST_MAP_READ)) {
+    GST_WARNING_OBJECT (mlbin, "Failed to map buffer %p!", buffer);
+    return FALSE;
+  }
+
+  // Use the luma component for YUV/GRAY and the green component for RGB.
+  comp = GST_VIDEO_INFO_IS_RGB (mlbin->vinfo) ? 1 : 0;
+
+  data = GST_VIDEO_FRAME_COMP_DATA (&frame, comp);
+  stride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, comp);
+  pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, comp);
+  width = GST_VIDEO_FRAME_COMP_WIDTH (&frame, comp);
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (&frame, comp);
+
+  pixels = g_new (guint8, GST_ML_BIN_THUMBNAIL_SIZE);
+
+  // Sample the center of each cell of the grid overlaid on the frame.
+  for (y = 0; y < GST_ML_BIN_THUMBNAIL_HEIGHT; y++) {
+    const guint8 *row = data +
+        (((2 * y + 1) * height) / (2 * GST_ML_BIN_THUMBNAIL_HEIGHT)) * stride;
+
+    for (x = 0; x < GST_ML_BIN_THUMBNAIL_WIDTH; x++, idx++) {
+      guint offset =
+          (((2 * x + 1) * width) / (2 * GST_ML_BIN_THUMBNAIL_WIDTH)) * pstride;
+
+      pixels[idx] = row[offset];
+    }
+  }
+
+  gst_video_frame_unmap (&frame);
+
+  // No reference frame yet, treat it as activity in order to run inference.
+  if (mlbin->thumbnail == NULL) {
+    *activity = G_MAXDOUBLE;
+    *thumbnail = pixels;
+    return TRUE;
+  }
+
+  // Mean absolute difference against the last frame which went through inference.
+  for (idx = 0; idx < GST_ML_BIN_THUMBNAIL_SIZE; idx++)
+    delta += ABS ((gint) pixels[idx] - (gint) mlbin->thumbnail[idx]);
+
+  *activity = delta / GST_ML_BIN_THUMBNAIL_SIZE;
+  *thumbnail = pixels;
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+gst_ml_bin_preprocess_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer userdata)
+{
+  GstMLBin *mlbin = GST_ML_BIN (userdata);
+  GstBuffer *buffer = NULL, *gapbuffer = NULL;
+  GstCvOptclFlowMeta *meta = NULL;
+  guint8 *thumbnail = NULL;
+  gdouble activity = G_MAXDOUBLE;
+  gboolean textout = FALSE;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      GstCaps *caps = NULL;
+
+      gst_event_parse_caps (event, &caps);
+
+      if (mlbin->vinfo == NULL)
+        mlbin->vinfo = gst_video_info_new ();
+
+      if (!gst_video_info_from_caps (mlbin->vinfo, caps))
+        g_clear_pointer (&(mlbin->vinfo), gst_video_info_free);
+
+      gst_ml_bin_reset_activity (mlbin);
+    } else if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+      gst_ml_bin_reset_activity (mlbin);
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  // Output type is updated from the post-processing streaming thread.
+  GST_ML_BIN_LOCK (mlbin);
+  textout = mlbin->textout;
+  GST_ML_BIN_UNLOCK (mlbin);
+
+  // Skip only if the last results can be re-attached to the skipped frames.
+  if (!mlbin->adaptive || !textout || (mlbin->vinfo == NULL) ||
+      GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_GAP))
+    return GST_PAD_PROBE_OK;
+
+  meta = gst_buffer_get_cv_optclflow_meta (buffer);
+
+  // Prefer the optical flow statistics over the frame differencing.
+  if ((meta != NULL) && (meta->mvectors != NULL) && (meta->mvectors->len > 0))
+    activity = gst_ml_bin_motion_activity (meta);
+  else if (!gst_ml_bin_frame_activity (mlbin, buffer, &activity, &thumbnail))
+    return GST_PAD_PROBE_OK;
+
+  GST_LOG_OBJECT (mlbin, "Activity %.2f for %" GST_PTR_FORMAT, activity, buffer);
+
+  // Run inference if there is activity or the max skip interval is reached.
+  if ((activity >= mlbin->threshold) || (mlbin->n_skipped >= mlbin->maxskip)) {
+    if (thumbnail != NULL) {
+      g_free (mlbin->thumbnail);
+      mlbin->thumbnail = thumbnail;
+    }
+
+    mlbin->n_skipped = 0;
+    return GST_PAD_PROBE_OK;
+  }
+
+  g_free (thumbnail);
+  mlbin->n_skipped++;
+
+  GST_ML_BIN_LOCK (mlbin);
+  g_queue_push_tail (mlbin->skipped,
+      gst_ml_bin_skip_entry_new (buffer, mlbin->vinfo));
+  GST_ML_BIN_UNLOCK (mlbin);
+
+  // Replace the frame with an empty GAP buffer which bypasses inference.
+  gapbuffer = gst_buffer_new ();
+  GST_BUFFER_FLAG_SET (gapbuffer, GST_BUFFER_FLAG_GAP);
+  gst_buffer_copy_into (gapbuffer, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+
+  GST_TRACE_OBJECT (mlbin, "Skipping inference for %" GST_PTR_FORMAT, buffer);
+
+  gst_buffer_unref (buffer);
+  GST_PAD_PROBE_INFO_DATA (info) = gapbuffer;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+gst_ml_bin_extrapolate_detections (GstStructure * structure,
+    const GstMLBinSkipEntry * entry)
+{
+  const GValue *bboxes = NULL, *value = NULL;
+  GValue rectangle = G_VALUE_INIT, coord = G_VALUE_INIT;
+  guint idx = 0, num = 0, size = 0, n_vectors = 0;
+
+  // Results derived from ROIs are relative to the ROI, not the frame.
+  if (gst_structure_has_field (structure, "parent-id"))
+    return;
+
+  if ((bboxes = gst_structure_get_value (structure, "bounding-boxes")) == NULL)
+    return;
+
+  size = gst_value_array_get_size (bboxes);
+
+  g_value_init (&rectangle, GST_TYPE_ARRAY);
+  g_value_init (&coord, G_TYPE_FLOAT);
+
+  for (idx = 0; idx < size; idx++) {
+    GstStructure *bbox = NULL;
+    gfloat x = 0.0, y = 0.0, width = 0.0, height = 0.0, dx = 0.0, dy = 0.0;
+
+    value = gst_value_array_get_value (bboxes, idx);
+    bbox = GST_STRUCTURE (g_value_get_boxed (value));
+
+    if ((value = gst_structure_get_value (bbox, "rectangle")) == NULL)
+      continue;
+
+    x = g_value_get_float (gst_value_array_get_value (value, 0));
+    y = g_value_get_float (gst_value_array_get_value (value, 1));
+    width = g_value_get_float (gst_value_array_get_value (value, 2));
+    height = g_value_get_float (gst_value_array_get_value (value, 3));
+
+    // Average the motion vectors originating inside the bounding box.
+    for (num = 0, n_vectors = 0; num < entry->mvectors->len; num++) {
+      GstCvMotionVector *mvector =
+          &g_array_index (entry->mvectors, GstCvMotionVector, num);
+      gfloat mx = ((gfloat) mvector->x) / entry->width;
+      gfloat my = ((gfloat) mvector->y) / entry->height;
+
+      if ((mx < x) || (mx > (x + width)) || (my < y) || (my > (y + height)))
+        continue;
+
+      dx += mvector->dx;
+      dy += mvector->dy;
+      n_vectors++;
+    }
+
+    if (n_vectors == 0)
+      continue;
+
+    x += (dx / n_vectors) / entry->width;
+    y += (dy / n_vectors) / entry->height;
+
+    g_value_set_float (&coord, x);
+    gst_value_array_append_value (&rectangle, &coord);
+    g_value_set_float (&coord, y);
+    gst_value_array_append_value (&rectangle, &coord);
+    g_value_set_float (&coord, width);
+    gst_value_array_append_value (&rectangle, &coord);
+    g_value_set_float (&coord, height);
+    gst_value_array_append_value (&rectangle, &coord);
+
+    gst_structure_set_value (bbox, "rectangle", &rectangle);
+    g_value_reset (&rectangle);
+  }
+
+  g_value_unset (&coord);
+  g_value_unset (&rectangle);
+}
+
+static GstBuffer *
+gst_ml_bin_replicate_meta (GstMLBin * mlbin, GstBuffer * gapbuffer,
+    const GstMLBinSkipEntry * entry)
+{
+  GstBuffer *buffer = NULL;
+  guint idx = 0, num = 0, size = 0, length = 0;
+
+  // The last results are replaced or reset from other streaming threads.
+  GST_ML_BIN_LOCK (mlbin);
+
+  if (mlbin->lastmeta->len == 0) {
+    GST_ML_BIN_UNLOCK (mlbin);
+    return NULL;
+  }
+
+  buffer = gst_buffer_new ();
+
+  for (idx = 0; idx < mlbin->lastmeta->len; idx++) {
+    GValue *list = &g_array_index (mlbin->lastmeta, GValue, idx);
+    GstMemory *mem = NULL;
+    gchar *string = NULL;
+
+    size = gst_value_list_get_size (list);
+
+    for (num = 0; num < size; num++) {
+      const GValue *value = gst_value_list_get_value (list, num);
+      GstStructure *structure = GST_STRUCTURE (g_value_get_boxed (value));
+
+      // Entries are matched against the video buffers by their timestamp.
+      gst_structure_set (structure, "timestamp", G_TYPE_UINT64,
+          GST_BUFFER_TIMESTAMP (gapbuffer), NULL);
+
+      if (mlbin->extrapolate && (entry->mvectors != NULL) &&
+          gst_structure_has_name (structure, "ObjectDetection"))
+        gst_ml_bin_extrapolate_detections (structure, entry);
+    }
+
+    if ((string = gst_value_serialize (list)) == NULL) {
+      GST_ML_BIN_UNLOCK (mlbin);
+
+      GST_WARNING_OBJECT (mlbin, "Failed to serialize last metadata!");
+      gst_buffer_unref (buffer);
+      return NULL;
+    }
+
+    // Increase the length by 1 byte for the '\0' character.
+    length = strlen (string) + 1;
+
+    mem = gst_memory_new_wrapped ((GstMemoryFlags) 0, string,
+        length, 0, length, string, g_free);
+    gst_buffer_append_memory (buffer, mem);
+  }
+
+  GST_ML_BIN_UNLOCK (mlbin);
+
+  gst_buffer_copy_into (buffer, gapbuffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+  return buffer;
+}
+
+static void
+gst_ml_bin_record_meta (GstMLBin * mlbin, GstBuffer * buffer)
+{
+  GstMapInfo memmap = {};
+  GArray *lastmeta = NULL, *oldmeta = NULL;
+  gchar *data = NULL, *token = NULL, *ctx = NULL;
+  GValue list = G_VALUE_INIT;
+
+  if (!gst_buffer_map (buffer, &memmap, GST_MAP_READ)) {
+    GST_WARNING_OBJECT (mlbin, "Failed to map buffer %p!", buffer);
+    return;
+  }
+
+  data = g_malloc (memmap.size + 1);
+  memcpy (data, memmap.data, memmap.size);
+  data[memmap.size] = '\0';
+
+  // Memory blocks are NUL terminated strings, replace them with new lines.
+  for (token = data; token < (data + memmap.size); token++) {
+    if (*token == '\0')
+      *token = '\n';
+  }
+
+  gst_buffer_unmap (buffer, &memmap);
+
+  // Parse into a new array which is swapped in under the lock.
+  lastmeta = g_array_new (FALSE, TRUE, sizeof (GValue));
+  g_array_set_clear_func (lastmeta, (GDestroyNotify) g_value_unset);
+
+  token = strtok_r (data, "\n", &ctx);
+
+  while (token != NULL) {
+    g_value_init (&list, GST_TYPE_LIST);
+
+    if (gst_value_deserialize (&list, token))
+      g_array_append_val (lastmeta, list);
+    else
+      g_value_unset (&list);
+
+    // The GValue content was transfered to the array, reinitialize it.
+    memset (&list, 0, sizeof (list));
+    token = strtok_r (NULL, "\n", &ctx);
+  }
+
+  g_free (data);
+
+  GST_ML_BIN_LOCK (mlbin);
+
+  oldmeta = mlbin->lastmeta;
+  mlbin->lastmeta = lastmeta;
+
+  GST_ML_BIN_UNLOCK (mlbin);
+
+  g_array_free (oldmeta, TRUE);
+}
+
+static GstPadProbeReturn
+gst_ml_bin_postprocess_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer userdata)
+{
+  GstMLBin *mlbin = GST_ML_BIN (userdata);
+  GstMLBinSkipEntry *entry = NULL;
+  GstBuffer *buffer = NULL, *outbuffer = NULL;
+  GstCaps *caps = NULL;
+  gboolean istext = FALSE;
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  GST_ML_BIN_LOCK (mlbin);
+
+  // Drop entries older than this buffer, their output was consumed already.
+  while (((entry = g_queue_peek_head (mlbin->skipped)) != NULL) &&
+      (entry->timestamp < GST_BUFFER_TIMESTAMP (buffer)))
+    gst_ml_bin_skip_entry_free (g_queue_pop_head (mlbin->skipped));
+
+  if ((entry != NULL) && (entry->timestamp == GST_BUFFER_TIMESTAMP (buffer)))
+    entry = g_queue_pop_head (mlbin->skipped);
+  else
+    entry = NULL;
+
+  GST_ML_BIN_UNLOCK (mlbin);
+
+  // Only text results can be re-attached, video results are frame specific.
+  if ((caps = gst_pad_get_current_caps (pad)) != NULL) {
+    istext = gst_caps_has_mimetype (caps, "text/x-raw");
+    gst_caps_unref (caps);
+  }
+
+  GST_ML_BIN_LOCK (mlbin);
+  mlbin->textout = istext;
+  GST_ML_BIN_UNLOCK (mlbin);
+
+  if (!istext) {
+    g_clear_pointer (&entry, gst_ml_bin_skip_entry_free);
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_GAP)) {
+    gst_ml_bin_record_meta (mlbin, buffer);
+  } else if ((entry != NULL) &&
+      (outbuffer = gst_ml_bin_replicate_meta (mlbin, buffer, entry)) != NULL) {
+    GST_TRACE_OBJECT (mlbin, "Re-attached last results to %" GST_PTR_FORMAT,
+        outbuffer);
+
+    gst_buffer_unref (buffer);
+    GST_PAD_PROBE_INFO_DATA (info) = outbuffer;
+  }
+
+  g_clear_pointer (&entry, gst_ml_bin_skip_entry_free);
+  return GST_PAD_PROBE_OK;
+}
+
 static gboolean
 gst_ml_bin_link_plugins (GstMLBin * mlbin)
 {
@@ -401,6 +884,7 @@ gst_ml_bin_constructed (GObject * object)
   GstMLBin *mlbin = GST_ML_BIN (object);
   GstElement *mlinference = NULL, *inmlqueue = NULL, *outmlqueue = NULL;
   GstElement *preprocess = NULL, *inqueue = NULL, *postprocess = NULL;
+  GstPad *pad = NULL;
   gboolean success = FALSE;
 
   // A queue element between the 'mltee' and 'mlpreprocess'.
@@ -436,6 +920,19 @@ gst_ml_bin_constructed (GObject * object)
       GST_ELEMENT_NAME (inqueue), GST_ELEMENT_NAME (preprocess),
       GST_ELEMENT_NAME (inmlqueue), GST_ELEMENT_NAME (mlinference),
       GST_ELEMENT_NAME (outmlqueue), GST_ELEMENT_NAME (postprocess));
+
+  // Probe for skipping inference on frames without activity.
+  pad = gst_element_get_static_pad (preprocess, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, gst_ml_bin_preprocess_probe,
+      mlbin, NULL);
+  gst_object_unref (pad);
+
+  // Probe for re-attaching the last results to the skipped frames.
+  pad = gst_element_get_static_pad (postprocess, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      gst_ml_bin_postprocess_probe, mlbin, NULL);
+  gst_object_unref (pad);
 }
 
 static void
@@ -456,6 +953,27 @@ gst_ml_bin_set_property (GObject * object, guint prop_id,
 
   GST_ML_BIN_LOCK (mlbin);
 
+  switch (prop_id) {
+    case PROP_ADAPTIVE:
+      mlbin->adaptive = g_value_get_boolean (value);
+      GST_ML_BIN_UNLOCK (mlbin);
+      return;
+    case PROP_MOTION_THRESHOLD:
+      mlbin->threshold = g_value_get_double (value);
+      GST_ML_BIN_UNLOCK (mlbin);
+      return;
+    case PROP_MAX_SKIP:
+      mlbin->maxskip = g_value_get_uint (value);
+      GST_ML_BIN_UNLOCK (mlbin);
+      return;
+    case PROP_EXTRAPOLATE:
+      mlbin->extrapolate = g_value_get_boolean (value);
+      GST_ML_BIN_UNLOCK (mlbin);
+      return;
+    default:
+      break;
+  }
+
   if (g_str_has_prefix (propname, "preprocess-")) {
     element = gst_bin_get_by_name (GST_BIN (mlbin), "mlpreprocess");
     offset = strlen ("preprocess-");
@@ -489,6 +1007,27 @@ gst_ml_bin_get_property (GObject * object, guint prop_id,
 
   GST_ML_BIN_LOCK (mlbin);
 
+  switch (prop_id) {
+    case PROP_ADAPTIVE:
+      g_value_set_boolean (value, mlbin->adaptive);
+      GST_ML_BIN_UNLOCK (mlbin);
+      return;
+    case PROP_MOTION_THRESHOLD:
+      g_value_set_double (value, mlbin->threshold);
+      GST_ML_BIN_UNLOCK (mlbin);
+      return;
+    case PROP_MAX_SKIP:
+      g_value_set_uint (value, mlbin->maxskip);
+      GST_ML_BIN_UNLOCK (mlbin);
+      return;
+    case PROP_EXTRAPOLATE:
+      g_value_set_boolean (value, mlbin->extrapolate);
+      GST_ML_BIN_UNLOCK (mlbin);
+      return;
+    default:
+      break;
+  }
+
   if (g_str_has_prefix (propname, "preprocess-")) {
     element = gst_bin_get_by_name (GST_BIN (mlbin), "mlpreprocess");
     offset = strlen ("preprocess-");
@@ -516,6 +1055,13 @@ gst_ml_bin_finalize (GObject * object)
 {
   GstMLBin *mlbin = GST_ML_BIN (object);
 
+  g_queue_free_full (mlbin->skipped,
+      (GDestroyNotify) gst_ml_bin_skip_entry_free);
+  g_array_free (mlbin->lastmeta, TRUE);
+
+  g_clear_pointer (&(mlbin->thumbnail), g_free);
+  g_clear_pointer (&(mlbin->vinfo), gst_video_info_free);
+
   g_mutex_clear (&mlbin->lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (mlbin));
@@ -526,7 +1072,7 @@ gst_ml_bin_class_init (GstMLBinClass *klass)
 {
   GObjectClass *gobject = G_OBJECT_CLASS (klass);
   GstElementClass *element = GST_ELEMENT_CLASS (klass);
-  guint prop_id = PROP_0 + 1;
+  guint prop_id = PROP_LAST;
 
   gobject->constructed = GST_DEBUG_FUNCPTR (gst_ml_bin_constructed);
   gobject->set_property = GST_DEBUG_FUNCPTR (gst_ml_bin_set_property);
@@ -538,6 +1084,35 @@ gst_ml_bin_class_init (GstMLBinClass *klass)
   gst_element_class_add_pad_template (element,
       gst_static_pad_template_get (&gst_ml_bin_src_template));
 
+  g_object_class_install_property (gobject, PROP_ADAPTIVE,
+      g_param_spec_boolean ("adaptive", "Adaptive",
+          "Skip inference on frames without activity compared to the last "
+          "frame which went through inference and re-attach the last results",
+          DEFAULT_PROP_ADAPTIVE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_MOTION_THRESHOLD,
+      g_param_spec_double ("motion-threshold", "Motion Threshold",
+          "Activity score below which a frame is considered static. The score "
+          "is the mean absolute luma difference of the downscaled frame or the "
+          "mean motion vector magnitude in pixels if optical flow meta exists",
+          0.0, 255.0, DEFAULT_PROP_MOTION_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_MAX_SKIP,
+      g_param_spec_uint ("max-skip", "Max Skip",
+          "Maximum number of consecutive frames for which inference is skipped",
+          0, G_MAXUINT, DEFAULT_PROP_MAX_SKIP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_EXTRAPOLATE,
+      g_param_spec_boolean ("extrapolate", "Extrapolate",
+          "Move the re-attached detections with the optical flow motion vectors "
+          "inside each bounding box, requires optical flow meta on the frames",
+          DEFAULT_PROP_EXTRAPOLATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
   gst_object_class_register_preprocess_properties (gobject, &prop_id);
   gst_object_class_register_inference_properties (gobject, &prop_id);
   gst_object_class_register_postprocess_properties (gobject, &prop_id);
@@ -558,6 +1133,20 @@ gst_ml_bin_init (GstMLBin * mlbin)
 
   g_mutex_init (&mlbin->lock);
 
+  mlbin->vinfo = NULL;
+  mlbin->thumbnail = NULL;
+  mlbin->n_skipped = 0;
+  mlbin->skipped = g_queue_new ();
+  mlbin->textout = FALSE;
+
+  mlbin->lastmeta = g_array_new (FALSE, TRUE, sizeof (GValue));
+  g_array_set_clear_func (mlbin->lastmeta, (GDestroyNotify) g_value_unset);
+
+  mlbin->adaptive = DEFAULT_PROP_ADAPTIVE;
+  mlbin->threshold = DEFAULT_PROP_MOTION_THRESHOLD;
+  mlbin->maxskip = DEFAULT_PROP_MAX_SKIP;
+  mlbin->extrapolate = DEFAULT_PROP_EXTRAPOLATE;
+
   // Create sink proxy pad.
   template = gst_static_pad_template_get (&gst_ml_bin_sink_template);
   pad = gst_ghost_pad_new_no_target_from_template ("sink", template);
@@ -8,6 +8,7 @@
 
 #include <gst/gst.h>
 #include <gst/pbutils/pbutils.h>
+#include <gst/video/video.h>
 
 G_BEGIN_DECLS
 
@@ -42,6 +43,25 @@ struct _GstMLBin
 
   /// Global mutex lock.
   GMutex       lock;
+
+  /// Video info of the incoming frames, used for the activity estimation.
+  GstVideoInfo *vinfo;
+  /// Downscaled luma of the last frame which went through inference.
+  guint8       *thumbnail;
+  /// Number of consecutive frames for which inference was skipped.
+  guint        n_skipped;
+  /// Queue with GstMLBinSkipEntry for the frames which bypass inference.
+  GQueue       *skipped;
+  /// Last post-processing text output, a GST_TYPE_LIST per sequence entry.
+  GArray       *lastmeta;
+  /// Whether post-processing outputs text results which can be re-attached.
+  gboolean     textout;
+
+  /// Properties.
+  gboolean     adaptive;
+  gdouble      threshold;
+  guint        maxskip;
+  gboolean     extrapolate;
 };
 
 struct _GstMLBinClass
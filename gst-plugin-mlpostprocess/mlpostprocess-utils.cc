@@ -592,6 +592,70 @@ gst_ml_post_process_boxes_intersection_score (ObjectDetection& l_box,
   return intersection / (l_area + r_area - intersection);
 }
 
+gfloat
+gst_ml_post_process_boxes_overlap_score (ObjectDetection& l_box,
+    ObjectDetection& r_box)
+{
+  gfloat width = 0, height = 0, l_area = 0, r_area = 0;
+
+  width = MIN (l_box.right, r_box.right) - MAX (l_box.left, r_box.left);
+  height = MIN (l_box.bottom, r_box.bottom) - MAX (l_box.top, r_box.top);
+
+  // Negative width or height means that there is no overlapping.
+  if ((width <= 0.0F) || (height <= 0.0F))
+    return 0.0F;
+
+  l_area = (l_box.right - l_box.left) * (l_box.bottom - l_box.top);
+  r_area = (r_box.right - r_box.left) * (r_box.bottom - r_box.top);
+
+  // Intersection over the smaller area, an object cut by a tile border
+  // overlaps almost completely with its full counterpart from another tile.
+  return (width * height) / MIN (l_area, r_area);
+}
+
+void
+gst_ml_object_detections_merge (ObjectDetections& detections, gfloat threshold)
+{
+  ObjectDetections results;
+  std::vector<bool> merged (detections.size (), false);
+  guint idx = 0, num = 0;
+
+  std::sort (detections.begin (), detections.end (),
+      [](ObjectDetection& l_entry, ObjectDetection& r_entry) {
+        return (l_entry.confidence > r_entry.confidence);
+      });
+
+  for (idx = 0; idx < detections.size (); idx++) {
+    ObjectDetection& l_box = detections[idx];
+
+    if (merged[idx])
+      continue;
+
+    for (num = idx + 1; num < detections.size (); num++) {
+      ObjectDetection& r_box = detections[num];
+
+      // If labels do not match, continue with next list entry.
+      if (merged[num] || (l_box.name != r_box.name))
+        continue;
+
+      if (gst_ml_post_process_boxes_overlap_score (l_box, r_box) <= threshold)
+        continue;
+
+      // Extend the box so that it covers parts of the object from other tiles.
+      l_box.left = MIN (l_box.left, r_box.left);
+      l_box.top = MIN (l_box.top, r_box.top);
+      l_box.right = MAX (l_box.right, r_box.right);
+      l_box.bottom = MAX (l_box.bottom, r_box.bottom);
+
+      merged[num] = true;
+    }
+
+    results.push_back (l_box);
+  }
+
+  detections.swap (results);
+}
+
 void
 gst_ml_post_process_box_displacement_correction (ObjectDetection& l_box,
     ObjectDetections& boxes)
@@ -161,6 +161,26 @@ gfloat
 gst_ml_post_process_boxes_intersection_score (ObjectDetection& l_box,
                                               ObjectDetection& r_box);
 
+/* gst_ml_post_process_boxes_overlap_score
+ *
+ * Helper function to get the intersection over the smaller of two boxes.
+ *
+ * return: Score.
+ **/
+gfloat
+gst_ml_post_process_boxes_overlap_score (ObjectDetection& l_box,
+                                         ObjectDetection& r_box);
+
+/* gst_ml_object_detections_merge
+ *
+ * Helper function for greedy merging of overlapping boxes with the same label.
+ * Lower confidence boxes are absorbed by the higher confidence ones.
+ *
+ * return: None.
+ **/
+void
+gst_ml_object_detections_merge (ObjectDetections& detections, gfloat threshold);
+
 /* gst_ml_post_process_box_displacement_correction
  *
  * Helper function to do displacement correction of two boxes.
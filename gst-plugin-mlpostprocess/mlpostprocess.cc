@@ -41,6 +41,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <numeric>
 
 #include <gst/ml/gstmlpool.h>
@@ -113,6 +115,7 @@ G_DEFINE_TYPE (GstMLPostProcess, gst_ml_post_process,
 #define DEFAULT_PROP_NUM_RESULTS        5
 #define DEFAULT_PROP_SETTINGS           NULL
 #define DEFAULT_PROP_BBOX_STABILIZATION FALSE
+#define DEFAULT_PROP_TILE_THRESHOLD     0.5
 
 #define DEFAULT_MIN_BUFFERS             2
 #define DEFAULT_MAX_BUFFERS             10
@@ -130,6 +133,7 @@ enum
   PROP_NUM_RESULTS,
   PROP_SETTINGS,
   PROP_BBOX_STABILIZATION,
+  PROP_TILE_THRESHOLD,
 };
 
 enum
@@ -365,6 +369,161 @@ gst_ml_post_process_poses_affine_correction (GstMLPostProcess * postprocess,
   }
 }
 
+static gboolean
+gst_ml_structure_get_relative_region (GstStructure * info, const gchar * name,
+    gdouble region[4])
+{
+  const GValue *value = NULL;
+  guint idx = 0;
+
+  if ((value = gst_structure_get_value (info, name)) == NULL)
+    return FALSE;
+
+  for (idx = 0; idx < 4; idx++)
+    region[idx] = g_value_get_double (gst_value_array_get_value (value, idx));
+
+  return TRUE;
+}
+
+static inline gboolean
+gst_ml_post_process_tile_is_empty (GstStructure * info)
+{
+  gdouble region[4] = {0};
+
+  if (!gst_ml_structure_get_relative_region (info, "tile-region", region))
+    return FALSE;
+
+  // Batch position for which no tile was placed in the tensor.
+  return (region[2] == 0.0) || (region[3] == 0.0);
+}
+
+static void
+gst_ml_post_process_objects_region_correction (GstMLPostProcess * postprocess,
+    GstStructure * info, ObjectDetections& objects)
+{
+  gdouble region[4] = {0};
+
+  // Tensor contains either a tile or a crop around the previous detections.
+  if (!gst_ml_structure_get_relative_region (info, "tile-region", region) &&
+      !gst_ml_structure_get_relative_region (info, "crop-region", region))
+    return;
+
+  // Translate the coordinates from relative to the region into relative to frame.
+  for (auto& object : objects) {
+    GST_TRACE_OBJECT (postprocess, "Object %s: [%.2f, %.2f, %.2f, %.2f] in region "
+        "[%.2f, %.2f, %.2f, %.2f]", object.name.c_str(), object.left, object.top,
+        object.right, object.bottom, region[0], region[1], region[2], region[3]);
+
+    object.left = region[0] + (object.left * region[2]);
+    object.top = region[1] + (object.top * region[3]);
+    object.right = region[0] + (object.right * region[2]);
+    object.bottom = region[1] + (object.bottom * region[3]);
+
+    if (!object.landmarks)
+      continue;
+
+    for (auto& landmark : object.landmarks.value()) {
+      landmark.x = region[0] + (landmark.x * region[2]);
+      landmark.y = region[1] + (landmark.y * region[3]);
+    }
+  }
+}
+
+static void
+gst_ml_post_process_poses_region_correction (GstMLPostProcess * postprocess,
+    GstStructure * info, PoseEstimations& poses)
+{
+  gdouble region[4] = {0};
+
+  if (!gst_ml_structure_get_relative_region (info, "crop-region", region))
+    return;
+
+  // Translate the coordinates from relative to the crop into relative to frame.
+  for (auto& pose : poses) {
+    for (auto& keypoint : pose.keypoints) {
+      GST_TRACE_OBJECT (postprocess, "Pose %s: Keypoint: [%.2f, %.2f] in region "
+          "[%.2f, %.2f, %.2f, %.2f]", pose.name.c_str(), keypoint.x, keypoint.y,
+          region[0], region[1], region[2], region[3]);
+
+      keypoint.x = region[0] + (keypoint.x * region[2]);
+      keypoint.y = region[1] + (keypoint.y * region[3]);
+    }
+  }
+}
+
+// Cropped results cover only the crop region of the frame, restrict the output
+// frame to that region and clear everything outside of it.
+static VideoFrame
+gst_ml_post_process_frame_region_correction (GstMLPostProcess * postprocess,
+    GstStructure * info, VideoFrame& frame)
+{
+  gdouble region[4] = {0};
+  guint x = 0, y = 0, width = 0, height = 0, bpp = 0;
+
+  if (!gst_ml_structure_get_relative_region (info, "crop-region", region))
+    return frame;
+
+  // Video frame Bytes Per Pixel, output formats are single plane.
+  bpp = frame.bits * frame.n_components / 8;
+
+  x = CLAMP (round (region[0] * frame.width), 0, frame.width - 1);
+  y = CLAMP (round (region[1] * frame.height), 0, frame.height - 1);
+  width = CLAMP (round (region[2] * frame.width), 1, frame.width - x);
+  height = CLAMP (round (region[3] * frame.height), 1, frame.height - y);
+
+  GST_TRACE_OBJECT (postprocess, "Frame %ux%u restricted to crop region "
+      "[%u, %u, %u, %u]", frame.width, frame.height, x, y, width, height);
+
+  memset (frame.planes[0].data, 0, frame.planes[0].size);
+
+  VideoFrame subframe = frame;
+  Plane& plane = subframe.planes[0];
+  guint offset = (y * plane.stride) + (x * bpp);
+
+  plane.data += offset;
+  plane.offset += offset;
+  plane.size -= offset;
+
+  subframe.width = width;
+  subframe.height = height;
+
+  return subframe;
+}
+
+static void
+gst_ml_post_process_merge_tiles (GstMLPostProcess * postprocess,
+    std::any& output)
+{
+  GstStructure *info = NULL;
+  ObjectDetections merged;
+  guint n_entries = 0;
+
+  info = GST_STRUCTURE_CAST (g_ptr_array_index (postprocess->info, 0));
+
+  // Not a tiled tensor, results of each batch position are independent.
+  if (!gst_structure_has_field (info, "tile-region"))
+    return;
+
+  auto& predictions = std::any_cast<DetectionPrediction&>(output);
+
+  if (predictions.empty ())
+    return;
+
+  for (auto& detections : predictions) {
+    merged.insert (merged.end (), detections.begin (), detections.end ());
+    detections.clear ();
+  }
+
+  n_entries = merged.size ();
+  gst_ml_object_detections_merge (merged, postprocess->tile_threshold);
+
+  GST_LOG_OBJECT (postprocess, "Merged %u tile detections into %zu",
+      n_entries, merged.size ());
+
+  // Place the frame results in the first batch position, leave others empty.
+  predictions[0] = std::move (merged);
+}
+
 static gboolean
 gst_ml_post_process_module_execute (GstMLPostProcess * postprocess,
     GstBuffer * buffer, std::any& output)
@@ -416,29 +575,38 @@ gst_ml_post_process_module_execute (GstMLPostProcess * postprocess,
       }
 
       predictions = tensors;
+    } else if (GST_IS_SEGMENTATION_TYPE (postprocess->type)) {
+      predictions = gst_ml_post_process_frame_region_correction (postprocess,
+          GST_STRUCTURE_CAST (g_ptr_array_index (postprocess->info, idx)),
+          std::any_cast<VideoFrame&>(output));
     } else {
       predictions = output;
     }
 
-    if (!(success = gst_ml_frame_to_module_tensors (&mlframe, idx, tensors))) {
-      GST_ERROR_OBJECT (postprocess, "Failed to translate input ML frame!");
-      goto cleanup;
-    }
+    // Get saved info for the current batch
+    info = GST_STRUCTURE_CAST (g_ptr_array_index (postprocess->info, idx));
+
+    // Empty tile positions carry no data, keep only their (empty) entries.
+    if (!gst_ml_post_process_tile_is_empty (info)) {
+      if (!(success = gst_ml_frame_to_module_tensors (&mlframe, idx, tensors))) {
+        GST_ERROR_OBJECT (postprocess, "Failed to translate input ML frame!");
+        goto cleanup;
+      }
 
-    success = postprocess->module->Process (tensors, mlparams, predictions);
+      success = postprocess->module->Process (tensors, mlparams, predictions);
 
-    if (!success) {
-      GST_ERROR_OBJECT (postprocess, "Failed to execute process!");
-      goto cleanup;
+      if (!success) {
+        GST_ERROR_OBJECT (postprocess, "Failed to execute process!");
+        goto cleanup;
+      }
     }
 
-    // Get saved info for the current batch
-    info = GST_STRUCTURE_CAST (g_ptr_array_index (postprocess->info, idx));
-
     // Sorting entries
     if (GST_IS_DETECTION_TYPE (postprocess->type)) {
       gst_ml_post_process_objects_affine_correction (postprocess, info,
           std::any_cast<ObjectDetections&>(predictions));
+      gst_ml_post_process_objects_region_correction (postprocess, info,
+          std::any_cast<ObjectDetections&>(predictions));
       gst_ml_object_detections_sort_and_push (output, predictions);
     } else if (GST_IS_CLASSIFICATION_TYPE (postprocess->type)) {
       gst_ml_image_classifications_sort_and_push (output, predictions);
@@ -447,12 +615,18 @@ gst_ml_post_process_module_execute (GstMLPostProcess * postprocess,
     } else if (GST_IS_POSE_TYPE (postprocess->type)) {
       gst_ml_post_process_poses_affine_correction (postprocess, info,
           std::any_cast<PoseEstimations&>(predictions));
+      gst_ml_post_process_poses_region_correction (postprocess, info,
+          std::any_cast<PoseEstimations&>(predictions));
       gst_ml_pose_estimation_sort_and_push (output, predictions);
     } else if (GST_IS_TEXT_GENERATION_TYPE (postprocess->type)) {
       gst_ml_text_generation_sort_and_push (output, predictions);
     }
   }
 
+  // Merge the detections from overlapping tiles into frame results.
+  if (GST_IS_DETECTION_TYPE (postprocess->type))
+    gst_ml_post_process_merge_tiles (postprocess, output);
+
 cleanup:
   gst_ml_frame_unmap (&mlframe);
   return success;
@@ -584,6 +758,66 @@ gst_ml_post_process_bbox_stabilization (GstMLPostProcess * postprocess,
   }
 }
 
+// Feed the detected regions back upstream, used by an ML video converter in
+// ROI crop mode to limit the next converted frame around the detected objects.
+static void
+gst_ml_post_process_send_detection_regions (GstMLPostProcess * postprocess,
+    std::any& output)
+{
+  GstStructure *structure = NULL, *info = NULL;
+  GValue regions = G_VALUE_INIT, array = G_VALUE_INIT, value = G_VALUE_INIT;
+  guint num = 0, n_entries = 0;
+
+  auto& predictions = std::any_cast<DetectionPrediction&>(output);
+
+  // Only results for a single whole frame describe regions of the frame.
+  if (predictions.size() != 1)
+    return;
+
+  info = GST_STRUCTURE_CAST (g_ptr_array_index (postprocess->info, 0));
+
+  // Results for a ROI from a previous stage are relative to that ROI.
+  if (gst_structure_has_field (info, "parent-id"))
+    return;
+
+  auto& detections = predictions[0];
+
+  n_entries = (detections.size() < postprocess->n_results) ?
+      detections.size() : postprocess->n_results;
+
+  g_value_init (&regions, GST_TYPE_ARRAY);
+  g_value_init (&array, GST_TYPE_ARRAY);
+  g_value_init (&value, G_TYPE_DOUBLE);
+
+  for (num = 0; num < n_entries; num++) {
+    ObjectDetection& entry = detections[num];
+
+    g_value_set_double (&value, entry.left);
+    gst_value_array_append_value (&array, &value);
+    g_value_set_double (&value, entry.top);
+    gst_value_array_append_value (&array, &value);
+    g_value_set_double (&value, entry.right - entry.left);
+    gst_value_array_append_value (&array, &value);
+    g_value_set_double (&value, entry.bottom - entry.top);
+    gst_value_array_append_value (&array, &value);
+
+    gst_value_array_append_value (&regions, &array);
+    g_value_reset (&array);
+  }
+
+  g_value_unset (&value);
+  g_value_unset (&array);
+
+  structure = gst_structure_new_empty ("ml-detection-regions");
+  gst_structure_take_value (structure, "regions", &regions);
+
+  GST_TRACE_OBJECT (postprocess, "Send %u detection regions", n_entries);
+
+  // The nearest ML pre-process upstream consumes the event, result is ignored.
+  gst_pad_push_event (GST_BASE_TRANSFORM_SINK_PAD (postprocess),
+      gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, structure));
+}
+
 static gboolean
 gst_ml_video_detection_fill_video_output (GstMLPostProcess * postprocess,
     std::any& output, GstVideoFrame * vframe)
@@ -622,6 +856,13 @@ gst_ml_video_detection_fill_video_output (GstMLPostProcess * postprocess,
     // Extract the source tensor region with actual data.
     gst_ml_structure_get_source_region (info, &region);
 
+    // Tile and crop results are relative to the whole frame, not to the tensor.
+    if (gst_structure_has_field (info, "tile-region") ||
+        gst_structure_has_field (info, "crop-region")) {
+      region.w = GST_VIDEO_FRAME_WIDTH (vframe);
+      region.h = GST_VIDEO_FRAME_HEIGHT (vframe);
+    }
+
     // Recalculate the region dimensions depending on the ratios.
     if ((region.w * GST_VIDEO_FRAME_HEIGHT (vframe)) >
         (region.h * GST_VIDEO_FRAME_WIDTH (vframe))) {
@@ -1340,6 +1581,12 @@ gst_ml_video_pose_fill_video_output (GstMLPostProcess * postprocess,
     // Extract the source tensor region with actual data.
     gst_ml_structure_get_source_region (info, &region);
 
+    // Cropped results are relative to the whole frame, not to the tensor.
+    if (gst_structure_has_field (info, "crop-region")) {
+      region.w = GST_VIDEO_FRAME_WIDTH (vframe);
+      region.h = GST_VIDEO_FRAME_HEIGHT (vframe);
+    }
+
     // Recalculate the region dimensions depending on the ratios.
     if ((region.w * GST_VIDEO_FRAME_HEIGHT (vframe)) >
         (region.h * GST_VIDEO_FRAME_WIDTH (vframe))) {
@@ -2417,6 +2664,9 @@ gst_ml_post_process_transform (GstBaseTransform * base, GstBuffer * inbuffer,
   if (GST_IS_DETECTION_TYPE (postprocess->type) && postprocess->bbox_stabilization)
     gst_ml_post_process_bbox_stabilization (postprocess, output);
 
+  if (GST_IS_DETECTION_TYPE (postprocess->type))
+    gst_ml_post_process_send_detection_regions (postprocess, output);
+
   time = gst_util_get_timestamp ();
 
   if (postprocess->mode == OUTPUT_MODE_VIDEO) {
@@ -2501,6 +2751,9 @@ gst_ml_post_process_set_property (GObject * object, guint prop_id,
     case PROP_BBOX_STABILIZATION:
       postprocess->bbox_stabilization = g_value_get_boolean (value);
       break;
+    case PROP_TILE_THRESHOLD:
+      postprocess->tile_threshold = g_value_get_double (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2529,6 +2782,9 @@ gst_ml_post_process_get_property (GObject * object, guint prop_id,
     case PROP_BBOX_STABILIZATION:
       g_value_set_boolean (value, postprocess->bbox_stabilization);
       break;
+    case PROP_TILE_THRESHOLD:
+      g_value_set_double (value, postprocess->tile_threshold);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2602,6 +2858,13 @@ gst_ml_post_process_class_init (GstMLPostProcessClass * klass)
           "Enable stabilization of bboxes", DEFAULT_PROP_BBOX_STABILIZATION,
           static_cast <GParamFlags> (
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  g_object_class_install_property (gobject, PROP_TILE_THRESHOLD,
+      g_param_spec_double ("tile-threshold", "Tile Threshold",
+          "Overlap (intersection over the smaller box) above which detections "
+          "with the same label from different tiles of a tiled tensor are "
+          "merged into a single detection", 0.0, 1.0, DEFAULT_PROP_TILE_THRESHOLD,
+          static_cast <GParamFlags> (
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
   gst_element_class_set_static_metadata (element,
       "Machine Learning postprocess", "Filter/Effect/Converter",
@@ -2657,6 +2920,7 @@ gst_ml_post_process_init (GstMLPostProcess * postprocess)
   postprocess->n_results = DEFAULT_PROP_NUM_RESULTS;
   postprocess->settings = DEFAULT_PROP_SETTINGS;
   postprocess->bbox_stabilization = DEFAULT_PROP_BBOX_STABILIZATION;
+  postprocess->tile_threshold = DEFAULT_PROP_TILE_THRESHOLD;
 
   // Handle buffers with GAP flag internally.
   gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (postprocess), TRUE);
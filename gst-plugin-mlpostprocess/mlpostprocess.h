@@ -104,6 +104,7 @@ struct _GstMLPostProcess {
   guint                n_results;
   gchar                *settings;
   gboolean             bbox_stabilization;
+  gdouble              tile_threshold;
 };
 
 struct _GstMLPostProcessClass {
@@ -75,6 +75,14 @@ G_DEFINE_TYPE (GstMLVideoConverter, gst_ml_video_converter,
 #define DEFAULT_PROP_SUBPIXEL_LAYOUT   GST_ML_VIDEO_PIXEL_LAYOUT_REGULAR
 #define DEFAULT_PROP_MEAN              0.0
 #define DEFAULT_PROP_SIGMA             1.0
+#define DEFAULT_PROP_BATCH_DEADLINE    (100 * GST_MSECOND)
+#define DEFAULT_PROP_TILE_OVERLAP      0.2
+#define DEFAULT_PROP_MAX_TILES         0
+#define DEFAULT_PROP_TILE_ON_ROI       FALSE
+#define DEFAULT_PROP_ROI_CROP          FALSE
+#define DEFAULT_PROP_ROI_CROP_PADDING  0.1
+#define DEFAULT_PROP_REFRESH_INTERVAL  30
+#define DEFAULT_PROP_SHARE_OUTPUT      FALSE
 
 // 1.0 / (2^8 - 1)
 #define FLOAT_CONVERSION_SIGMA         (1.0 / 255.0)
@@ -102,16 +110,20 @@ G_DEFINE_TYPE (GstMLVideoConverter, gst_ml_video_converter,
 
 #define GST_CONVERSION_MODE_IS_NON_CUMULATIVE(mode) \
   (mode == GST_ML_CONVERSION_MODE_IMAGE_NON_CUMULATIVE || \
-      mode == GST_ML_CONVERSION_MODE_ROI_NON_CUMULATIVE)
+      mode == GST_ML_CONVERSION_MODE_ROI_NON_CUMULATIVE || \
+      mode == GST_ML_CONVERSION_MODE_IMAGE_TILED)
 #define GST_CONVERSION_MODE_IS_CUMULATIVE(mode) \
   (mode == GST_ML_CONVERSION_MODE_IMAGE_CUMULATIVE || \
-      mode == GST_ML_CONVERSION_MODE_ROI_CUMULATIVE)
+      mode == GST_ML_CONVERSION_MODE_ROI_CUMULATIVE || \
+      mode == GST_ML_CONVERSION_MODE_ROI_PACKED)
 #define GST_CONVERSION_MODE_IS_IMAGE(mode) \
   (mode == GST_ML_CONVERSION_MODE_IMAGE_NON_CUMULATIVE || \
-      mode == GST_ML_CONVERSION_MODE_IMAGE_CUMULATIVE)
+      mode == GST_ML_CONVERSION_MODE_IMAGE_CUMULATIVE || \
+      mode == GST_ML_CONVERSION_MODE_IMAGE_TILED)
 #define GST_CONVERSION_MODE_IS_ROI(mode) \
   (mode == GST_ML_CONVERSION_MODE_ROI_NON_CUMULATIVE || \
-      mode == GST_ML_CONVERSION_MODE_ROI_CUMULATIVE)
+      mode == GST_ML_CONVERSION_MODE_ROI_CUMULATIVE || \
+      mode == GST_ML_CONVERSION_MODE_ROI_PACKED)
 
 
 #define GST_ML_VIDEO_FORMATS \
@@ -151,6 +163,14 @@ enum
   PROP_SUBPIXEL_LAYOUT,
   PROP_MEAN,
   PROP_SIGMA,
+  PROP_BATCH_DEADLINE,
+  PROP_TILE_OVERLAP,
+  PROP_MAX_TILES,
+  PROP_TILE_ON_ROI,
+  PROP_ROI_CROP,
+  PROP_ROI_CROP_PADDING,
+  PROP_REFRESH_INTERVAL,
+  PROP_SHARE_OUTPUT,
 };
 
 static GstStaticCaps gst_ml_video_converter_static_src_caps =
@@ -236,6 +256,21 @@ gst_ml_conversion_mode_get_type (void)
         "there are no ROI metas present inside the received buffer.",
         "roi-batch-cumulative"
     },
+    { GST_ML_CONVERSION_MODE_ROI_PACKED,
+        "Use only ROI metas to fill tensor batch size. Pack ROI metas from "
+        "consecutive buffers and muxed streams until every position of the "
+        "tensor batch is filled. Buffers without ROI metas do not interrupt "
+        "the accumulation and produce GAP buffers. A partially filled batch "
+        "is processed once the oldest stashed ROI exceeds the batch deadline.",
+        "roi-batch-packed"
+    },
+    { GST_ML_CONVERSION_MODE_IMAGE_TILED,
+        "ROI meta is ignored unless tiling on ROI is enabled. Split each "
+        "incoming image into overlapping tiles, one per tensor batch position, "
+        "for detection of small objects in high resolution images. The tile "
+        "grid is calculated once per caps and is bound by the batch size.",
+        "image-tiled"
+    },
     { 0, NULL, NULL },
   };
 
@@ -526,7 +561,8 @@ gst_buffer_new_from_parent_memory (GstBuffer * buffer, guint index, guint depth)
   while ((roimeta = GST_BUFFER_ITERATE_ROI_METAS (buffer, state)) != NULL) {
     guint id = roimeta->id;
 
-    if (!(id & (stream_id << GST_MUX_STREAM_ID_OFFSET)))
+    if (((id & GST_MUX_STREAM_ID_MASK) >> GST_MUX_STREAM_ID_OFFSET) !=
+            (guint) stream_id)
       continue;
 
     roimeta = gst_buffer_add_video_region_of_interest_meta_id (newbuffer,
@@ -790,6 +826,139 @@ gst_ml_video_converter_retrieve_protection_meta (GstMLVideoConverter * mlconvert
   return pmeta;
 }
 
+static gboolean
+gst_ml_video_converter_crop_region (GstMLVideoConverter * mlconverter,
+    GstBuffer * buffer, const GstVideoInfo * info, GstVideoRectangle * region)
+{
+  GstVideoRegionOfInterestMeta *roimeta = NULL;
+  gpointer state = NULL;
+  gint width = 0, height = 0, left = G_MAXINT, top = G_MAXINT;
+  gint right = 0, bottom = 0, minwidth = 0, minheight = 0, pad = 0;
+  gboolean refresh = FALSE;
+
+  width = GST_VIDEO_INFO_WIDTH (info);
+  height = GST_VIDEO_INFO_HEIGHT (info);
+
+  // Periodically convert the full frame in order to pick up new objects.
+  refresh = (mlconverter->refresh != 0) &&
+      ((mlconverter->n_cropped % mlconverter->refresh) == 0);
+  mlconverter->n_cropped++;
+
+  if (refresh)
+    return FALSE;
+
+  GST_OBJECT_LOCK (mlconverter);
+
+  // Regions detected in the previous frame, fed back by the ML post-process.
+  if (mlconverter->detections[2] > 0.0) {
+    left = mlconverter->detections[0] * width;
+    top = mlconverter->detections[1] * height;
+    right = (mlconverter->detections[0] + mlconverter->detections[2]) * width;
+    bottom = (mlconverter->detections[1] + mlconverter->detections[3]) * height;
+  }
+
+  GST_OBJECT_UNLOCK (mlconverter);
+
+  // Union with the regions from previous detections or tracker on the frame.
+  while ((roimeta = GST_BUFFER_ITERATE_ROI_METAS (buffer, state)) != NULL) {
+    if (roimeta->roi_type == g_quark_from_static_string ("ImageRegion"))
+      continue;
+
+    if ((mlconverter->roi_stage_ids->len != 0) &&
+        !gst_region_of_interest_is_valid (roimeta, mlconverter->roi_stage_ids))
+      continue;
+
+    left = MIN (left, (gint) roimeta->x);
+    top = MIN (top, (gint) roimeta->y);
+    right = MAX (right, (gint) (roimeta->x + roimeta->w));
+    bottom = MAX (bottom, (gint) (roimeta->y + roimeta->h));
+  }
+
+  // No regions, nothing is tracked and the full frame needs to be converted.
+  if ((left >= right) || (top >= bottom))
+    return FALSE;
+
+  // Pad the union in order to accommodate for object motion.
+  pad = (right - left) * mlconverter->padding;
+  left -= pad;
+  right += pad;
+
+  pad = (bottom - top) * mlconverter->padding;
+  top -= pad;
+  bottom += pad;
+
+  // Do not crop below the tensor dimensions, that would only upscale the image.
+  minwidth = MIN (GST_ML_INFO_TENSOR_DIM_W (mlconverter->tensorlayout,
+      mlconverter->mlinfo), width);
+  minheight = MIN (GST_ML_INFO_TENSOR_DIM_H (mlconverter->tensorlayout,
+      mlconverter->mlinfo), height);
+
+  if ((right - left) < minwidth) {
+    left -= (minwidth - (right - left)) / 2;
+    right = left + minwidth;
+  }
+
+  if ((bottom - top) < minheight) {
+    top -= (minheight - (bottom - top)) / 2;
+    bottom = top + minheight;
+  }
+
+  // Shift the region inside the frame and clip whatever still does not fit.
+  if (left < 0) {
+    right = MIN (right - left, width);
+    left = 0;
+  } else if (right > width) {
+    left = MAX (left - (right - width), 0);
+    right = width;
+  }
+
+  if (top < 0) {
+    bottom = MIN (bottom - top, height);
+    top = 0;
+  } else if (bottom > height) {
+    top = MAX (top - (bottom - height), 0);
+    bottom = height;
+  }
+
+  // Region covers the whole frame, there is nothing to crop.
+  if (((right - left) == width) && ((bottom - top) == height))
+    return FALSE;
+
+  *region = (GstVideoRectangle){left, top, right - left, bottom - top};
+  return TRUE;
+}
+
+static void
+gst_ml_video_converter_set_crop_region (GstMLVideoConverter * mlconverter,
+    GstProtectionMeta * pmeta, const GstVideoInfo * info,
+    const GstVideoRectangle * region)
+{
+  GValue crop = G_VALUE_INIT, value = G_VALUE_INIT;
+  gdouble width = 0.0, height = 0.0;
+
+  width = GST_VIDEO_INFO_WIDTH (info);
+  height = GST_VIDEO_INFO_HEIGHT (info);
+
+  g_value_init (&crop, GST_TYPE_ARRAY);
+  g_value_init (&value, G_TYPE_DOUBLE);
+
+  // Cropped region in relative frame coordinates, used for the results.
+  g_value_set_double (&value, region->x / width);
+  gst_value_array_append_value (&crop, &value);
+  g_value_set_double (&value, region->y / height);
+  gst_value_array_append_value (&crop, &value);
+  g_value_set_double (&value, region->w / width);
+  gst_value_array_append_value (&crop, &value);
+  g_value_set_double (&value, region->h / height);
+  gst_value_array_append_value (&crop, &value);
+
+  gst_structure_take_value (pmeta->info, "crop-region", &crop);
+  g_value_unset (&value);
+
+  GST_TRACE_OBJECT (mlconverter, "Crop region [%d %d %d %d]", region->x,
+      region->y, region->w, region->h);
+}
+
 static gboolean
 gst_ml_video_converter_update_source (GstMLVideoConverter * mlconverter,
     GstVideoRegionOfInterestMeta * roimeta, GstVideoBlit * vblit,
@@ -805,7 +974,13 @@ gst_ml_video_converter_update_source (GstMLVideoConverter * mlconverter,
   source = &(vblit->source);
   vblit->mask |= GST_VCE_MASK_SOURCE;
 
-  if (roimeta == NULL) {
+  if ((roimeta == NULL) && mlconverter->roicrop &&
+      gst_ml_video_converter_crop_region (mlconverter, vblit->buffer,
+          vblit->info, &region)) {
+    // Limit the source to the area around the previously detected objects.
+    gst_ml_video_converter_set_crop_region (mlconverter, pmeta, vblit->info,
+        &region);
+  } else if (roimeta == NULL) {
     // Initialize the source region with full dimensions of the blit frame.
     region.w = GST_VIDEO_INFO_WIDTH (vblit->info);
     region.h = GST_VIDEO_INFO_HEIGHT (vblit->info);
@@ -1087,7 +1262,8 @@ gst_ml_video_converter_update_blit_params (GstMLVideoConverter * mlconverter,
   } while (++num < n_regions);
 
   // Stash the next suitable ROI meta ID if not all ROI metas were processed.
-  if (mlconverter->mode == GST_ML_CONVERSION_MODE_ROI_CUMULATIVE) {
+  if (GST_CONVERSION_MODE_IS_ROI (mlconverter->mode) &&
+      GST_CONVERSION_MODE_IS_CUMULATIVE (mlconverter->mode)) {
     roimeta = GST_BUFFER_ITERATE_ROI_METAS (inbuffer, state);
 
     while ((roimeta != NULL) &&
@@ -1103,6 +1279,223 @@ gst_ml_video_converter_update_blit_params (GstMLVideoConverter * mlconverter,
   return n_regions;
 }
 
+static inline guint
+gst_video_tiles_count (gint size, gint tilesize, gdouble overlap)
+{
+  gdouble stride = tilesize * (1.0 - overlap);
+
+  if (tilesize >= size)
+    return 1;
+
+  // Number of tiles with at least the requested overlap covering the size.
+  return (guint) ceil ((size - tilesize) / stride) + 1;
+}
+
+static void
+gst_ml_video_converter_setup_tiles (GstMLVideoConverter * mlconverter)
+{
+  GstVideoRectangle tile = { 0, };
+  guint n_batch = 0, n_tiles = 0, n_columns = 0, n_rows = 0, row = 0, column = 0;
+  gint width = 0, height = 0, tensorwidth = 0, tensorheight = 0;
+  gdouble scale = 1.0;
+
+  g_array_set_size (mlconverter->tiles, 0);
+
+  width = GST_VIDEO_INFO_WIDTH (mlconverter->ininfo);
+  height = GST_VIDEO_INFO_HEIGHT (mlconverter->ininfo);
+
+  tensorwidth = GST_ML_INFO_TENSOR_DIM_W (mlconverter->tensorlayout,
+      mlconverter->mlinfo);
+  tensorheight = GST_ML_INFO_TENSOR_DIM_H (mlconverter->tensorlayout,
+      mlconverter->mlinfo);
+  n_batch = GST_ML_INFO_TENSOR_DIM_N (mlconverter->tensorlayout,
+      mlconverter->mlinfo);
+
+  // Each tile occupies a batch position, optionally limit them further.
+  n_tiles = (mlconverter->maxtiles != 0) ?
+      MIN (mlconverter->maxtiles, n_batch) : n_batch;
+
+  // Start with tiles at the tensor resolution and enlarge them until the
+  // grid fits in the allowed number of tiles. Worst case is a single tile.
+  do {
+    tile.w = MIN ((gint) ceil (tensorwidth * scale), width);
+    tile.h = MIN ((gint) ceil (tensorheight * scale), height);
+
+    n_columns = gst_video_tiles_count (width, tile.w, mlconverter->overlap);
+    n_rows = gst_video_tiles_count (height, tile.h, mlconverter->overlap);
+
+    scale *= 1.1;
+  } while ((n_columns * n_rows) > n_tiles);
+
+  // Distribute the tiles evenly, the last ones are aligned to the frame edges.
+  for (row = 0; row < n_rows; row++) {
+    tile.y = (n_rows > 1) ? (row * (height - tile.h)) / (n_rows - 1) : 0;
+
+    for (column = 0; column < n_columns; column++) {
+      tile.x = (n_columns > 1) ?
+          (column * (width - tile.w)) / (n_columns - 1) : 0;
+
+      g_array_append_val (mlconverter->tiles, tile);
+    }
+  }
+
+  GST_DEBUG_OBJECT (mlconverter, "Using %ux%u grid of %dx%d tiles for %dx%d "
+      "frames", n_columns, n_rows, tile.w, tile.h, width, height);
+}
+
+static gboolean
+gst_ml_video_converter_tile_is_active (GstMLVideoConverter * mlconverter,
+    GstBuffer * buffer, const GstVideoRectangle * tile)
+{
+  GstVideoRegionOfInterestMeta *roimeta = NULL;
+  gpointer state = NULL;
+
+  while ((roimeta = GST_BUFFER_ITERATE_ROI_METAS (buffer, state)) != NULL) {
+    if ((mlconverter->roi_stage_ids->len != 0) &&
+        !gst_region_of_interest_is_valid (roimeta, mlconverter->roi_stage_ids))
+      continue;
+
+    // Tile is active if it intersects with any region from the coarse pass.
+    if (((gint) roimeta->x < (tile->x + tile->w)) &&
+        ((gint) (roimeta->x + roimeta->w) > tile->x) &&
+        ((gint) roimeta->y < (tile->y + tile->h)) &&
+        ((gint) (roimeta->y + roimeta->h) > tile->y))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static gboolean
+gst_ml_video_converter_has_active_tiles (GstMLVideoConverter * mlconverter,
+    GstBuffer * buffer)
+{
+  guint idx = 0;
+
+  for (idx = 0; idx < mlconverter->tiles->len; idx++) {
+    GstVideoRectangle *tile =
+        &g_array_index (mlconverter->tiles, GstVideoRectangle, idx);
+
+    if (gst_ml_video_converter_tile_is_active (mlconverter, buffer, tile))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static void
+gst_ml_video_converter_set_tile_region (GstMLVideoConverter * mlconverter,
+    GstProtectionMeta * pmeta, const GstVideoRectangle * tile)
+{
+  GValue region = G_VALUE_INIT, value = G_VALUE_INIT;
+  gdouble width = 0.0, height = 0.0;
+
+  width = GST_VIDEO_INFO_WIDTH (mlconverter->ininfo);
+  height = GST_VIDEO_INFO_HEIGHT (mlconverter->ininfo);
+
+  g_value_init (&region, GST_TYPE_ARRAY);
+  g_value_init (&value, G_TYPE_DOUBLE);
+
+  // Tile region in relative frame coordinates, used for merging the results.
+  g_value_set_double (&value, tile->x / width);
+  gst_value_array_append_value (&region, &value);
+  g_value_set_double (&value, tile->y / height);
+  gst_value_array_append_value (&region, &value);
+  g_value_set_double (&value, tile->w / width);
+  gst_value_array_append_value (&region, &value);
+  g_value_set_double (&value, tile->h / height);
+  gst_value_array_append_value (&region, &value);
+
+  gst_structure_take_value (pmeta->info, "tile-region", &region);
+  g_value_unset (&value);
+}
+
+static gint
+gst_ml_video_converter_update_tile_params (GstMLVideoConverter * mlconverter,
+    GstBuffer * inbuffer)
+{
+  GstVideoComposition *composition = NULL;
+  GstVideoBlit *vblit = NULL;
+  GstBuffer *outbuffer = NULL;
+  GstProtectionMeta *pmeta = NULL;
+  GstVideoQuadrilateral *source = NULL;
+  GstVideoRectangle *destination = NULL, *tile = NULL, empty = { 0, };
+  const GstVideoMeta *meta = NULL;
+  guint idx = 0, n_batch = 0;
+
+  composition = &(mlconverter->composition);
+  outbuffer = composition->buffer;
+
+  n_batch = GST_ML_INFO_TENSOR_DIM_N (mlconverter->tensorlayout,
+      mlconverter->mlinfo);
+
+  meta = gst_buffer_get_video_meta (inbuffer);
+
+  if (!gst_video_info_modify_with_meta (mlconverter->ininfo, meta))
+    GST_WARNING_OBJECT (mlconverter, "Failed to derive info from meta");
+
+  // All tiles of a frame are a single sequence, one entry per batch position.
+  mlconverter->n_seq_entries = n_batch;
+
+  for (idx = 0; idx < mlconverter->tiles->len; idx++) {
+    tile = &g_array_index (mlconverter->tiles, GstVideoRectangle, idx);
+
+    if (mlconverter->tileroi &&
+        !gst_ml_video_converter_tile_is_active (mlconverter, inbuffer, tile))
+      continue;
+
+    mlconverter->seq_idx = mlconverter->batch_idx + 1;
+
+    vblit = &(composition->blits[composition->n_blits]);
+    vblit->buffer = gst_buffer_ref (inbuffer);
+    vblit->info = mlconverter->ininfo;
+
+    pmeta = gst_ml_video_converter_retrieve_protection_meta (mlconverter,
+        inbuffer, outbuffer);
+
+    source = &(vblit->source);
+    vblit->mask |= GST_VCE_MASK_SOURCE;
+
+    source->a = (GstVideoPoint){tile->x, tile->y};
+    source->b = (GstVideoPoint){tile->x, tile->y + tile->h};
+    source->c = (GstVideoPoint){tile->x + tile->w, tile->y};
+    source->d = (GstVideoPoint){tile->x + tile->w, tile->y + tile->h};
+
+    // Update blit destination rectangle based on the disposition.
+    gst_ml_video_converter_update_destination (mlconverter, vblit, pmeta);
+    gst_ml_video_converter_set_tile_region (mlconverter, pmeta, tile);
+
+    destination = &(vblit->destination);
+
+    // Add the Y axis offset for this tile in the output buffer.
+    destination->y += mlconverter->batch_idx *
+        (GST_VIDEO_INFO_HEIGHT (composition->info) / n_batch);
+
+    GST_BUFFER_OFFSET (outbuffer) |= 1 << mlconverter->batch_idx++;
+
+    GST_TRACE_OBJECT (mlconverter, "Batch[%u / %u] Tile[%d %d %d %d] "
+        "Destination[%d %d %d %d]", mlconverter->batch_idx, n_batch, tile->x,
+        tile->y, tile->w, tile->h, destination->x, destination->y,
+        destination->w, destination->h);
+
+    composition->n_blits++;
+  }
+
+  // Remaining batch positions are left empty, post-processing skips them.
+  for (; mlconverter->batch_idx < n_batch; mlconverter->batch_idx++) {
+    mlconverter->seq_idx = mlconverter->batch_idx + 1;
+
+    pmeta = gst_ml_video_converter_retrieve_protection_meta (mlconverter,
+        inbuffer, outbuffer);
+
+    gst_ml_structure_set_source_region (pmeta->info, &empty);
+    gst_ml_video_converter_set_tile_region (mlconverter, pmeta, &empty);
+  }
+
+  // All batch positions were consumed by this frame.
+  return n_batch;
+}
+
 static void
 gst_ml_video_converter_cleanup_composition (GstMLVideoConverter * mlconverter)
 {
@@ -1218,8 +1611,12 @@ gst_ml_video_converter_setup_composition (GstMLVideoConverter * mlconverter,
             GST_PTR_FORMAT, mem_idx, buffer);
       }
 
-      n_filled_positions =
-          gst_ml_video_converter_update_blit_params (mlconverter, buffer);
+      if (mlconverter->mode == GST_ML_CONVERSION_MODE_IMAGE_TILED)
+        n_filled_positions =
+            gst_ml_video_converter_update_tile_params (mlconverter, buffer);
+      else
+        n_filled_positions =
+            gst_ml_video_converter_update_blit_params (mlconverter, buffer);
 
       if (!(success = (n_filled_positions > -1)))
         goto cleanup;
@@ -1270,6 +1667,33 @@ cleanup:
   return success;
 }
 
+static gboolean
+gst_ml_video_converter_deadline_expired (GstMLVideoConverter * mlconverter,
+    GstBuffer * inbuffer)
+{
+  GstBuffer *buffer = NULL;
+  GstClockTimeDiff elapsed = 0;
+
+  // Deadline is not applicable or disabled, wait until the batch is filled.
+  if ((mlconverter->mode != GST_ML_CONVERSION_MODE_ROI_PACKED) ||
+      (mlconverter->deadline == 0))
+    return FALSE;
+
+  // No stashed buffers, there is no pending ROI which may be delayed.
+  if ((buffer = g_queue_peek_head (mlconverter->bufqueue)) == NULL)
+    return FALSE;
+
+  if (!GST_BUFFER_TIMESTAMP_IS_VALID (buffer) ||
+      !GST_BUFFER_TIMESTAMP_IS_VALID (inbuffer))
+    return FALSE;
+
+  // Time passed since the oldest stashed buffer, measured in stream time.
+  elapsed = GST_CLOCK_DIFF (GST_BUFFER_TIMESTAMP (buffer),
+      GST_BUFFER_TIMESTAMP (inbuffer));
+
+  return (elapsed >= (GstClockTimeDiff) mlconverter->deadline) ? TRUE : FALSE;
+}
+
 static gboolean
 gst_ml_video_converter_prepare_buffer_queues (GstMLVideoConverter * mlconverter,
     GstBuffer * inbuffer)
@@ -1312,13 +1736,14 @@ gst_ml_video_converter_prepare_buffer_queues (GstMLVideoConverter * mlconverter,
   }
 
   // TODO Add handling for depth and ROI_CUMULATIVE
-  if (mlconverter->mode == GST_ML_CONVERSION_MODE_ROI_CUMULATIVE) {
+  if (GST_CONVERSION_MODE_IS_ROI (mlconverter->mode)) {
     // Accumulative ROI batch mode, base decisions on the number of ROI metas.
     n_regions = gst_buffer_get_region_of_interest_n_meta (inbuffer,
         mlconverter->roi_stage_ids);
 
     // Buffer does not contain ROI metas, process buffers in the internal queue
     // and set buffer as queued_buf to the base class for subsequent processing.
+    // In packed mode this is reached only when the batch deadline has expired.
     if (n_regions == 0) {
       GST_BASE_TRANSFORM (mlconverter)->queued_buf = gst_buffer_ref (inbuffer);
       return TRUE;
@@ -1338,7 +1763,15 @@ gst_ml_video_converter_prepare_buffer_queues (GstMLVideoConverter * mlconverter,
           mlconverter->next_roi_id, mlconverter->roi_stage_ids);
     }
 
-    if (n_regions < n_batch) {
+    if ((n_regions < n_batch) &&
+        gst_ml_video_converter_deadline_expired (mlconverter, inbuffer)) {
+      // Oldest stashed ROI exceeded the deadline, process a partial batch.
+      GST_DEBUG_OBJECT (mlconverter, "Batch deadline expired, processing %u "
+          "out of %u positions", n_regions, n_batch);
+
+      g_queue_push_tail (mlconverter->bufqueue, gst_buffer_ref (inbuffer));
+      return TRUE;
+    } else if (n_regions < n_batch) {
       // Not enough ROIs, stash current buffer and check again on next buffer.
       g_queue_push_tail (mlconverter->bufqueue, gst_buffer_ref (inbuffer));
       return FALSE;
@@ -1389,6 +1822,61 @@ gst_ml_video_converter_prepare_buffer_queues (GstMLVideoConverter * mlconverter,
   return FALSE;
 }
 
+static gboolean
+gst_ml_video_converter_composition_required (GstMLVideoConverter * mlconverter)
+{
+  GstVideoComposition *composition = &(mlconverter->composition);
+  const GstVideoInfo *ininfo = composition->blits[0].info;
+
+  // Perform transformation only when custom normalization coefficients are set,
+  // when there are multiple blit elements (buffers), or when there is only a
+  // single blit element which does not have the required parameters for output.
+  return (mlconverter->backend != GST_VCE_BACKEND_NONE) &&
+      ((composition->n_blits > 1) ||
+          is_conversion_required (ininfo, composition->info) ||
+          ((mlconverter->mean->len != 0) && (mlconverter->sigma->len != 0)));
+}
+
+static gboolean
+gst_ml_video_converter_lookup_output (GstMLVideoConverter * mlconverter,
+    GstBuffer * inbuffer, GstBuffer ** outbuffer)
+{
+  GstBuffer *buffer = NULL;
+
+  // Muxed streams are split into child buffers which are never shared.
+  if (GST_VIDEO_INFO_MULTIVIEW_MODE (mlconverter->ininfo) ==
+          GST_VIDEO_MULTIVIEW_MODE_SEPARATED)
+    return TRUE;
+
+  // Buffer will be dropped by the transform, nothing to look for.
+  if (!gst_ml_video_converter_prepare_buffer_queues (mlconverter, inbuffer))
+    return TRUE;
+
+  // Composition is needed for the lookup, it is reused by the transform.
+  if (!gst_ml_video_converter_setup_composition (mlconverter, *outbuffer))
+    return FALSE;
+
+  if (!gst_ml_video_converter_composition_required (mlconverter))
+    return TRUE;
+
+  buffer = gst_video_converter_engine_lookup (mlconverter->converter,
+      &(mlconverter->composition));
+
+  if (buffer == NULL)
+    return TRUE;
+
+  GST_LOG_OBJECT (mlconverter, "Sharing output %" GST_PTR_FORMAT, buffer);
+
+  gst_ml_video_converter_cleanup_composition (mlconverter);
+
+  // Return the acquired buffer back to the pool and use the shared one.
+  gst_buffer_unref (*outbuffer);
+  *outbuffer = buffer;
+
+  mlconverter->shared = TRUE;
+  return TRUE;
+}
+
 static gboolean
 gst_ml_video_converter_normalize (GstMLVideoConverter * mlconverter)
 {
@@ -1929,6 +2417,32 @@ gst_ml_video_converter_query (GstBaseTransform * base,
       GST_DEBUG_OBJECT (mlconverter, "Stage ID %u", mlconverter->stage_id);
       return TRUE;
     }
+    case GST_QUERY_LATENCY:
+    {
+      GstClockTime min = 0, max = GST_CLOCK_TIME_NONE;
+      gboolean live = FALSE;
+
+      // Only the packed mode delays buffers for a bounded amount of time.
+      if ((direction != GST_PAD_SRC) || (mlconverter->deadline == 0) ||
+          (mlconverter->mode != GST_ML_CONVERSION_MODE_ROI_PACKED))
+        break;
+
+      if (!GST_BASE_TRANSFORM_CLASS (parent_class)->query (base, direction, query))
+        return FALSE;
+
+      gst_query_parse_latency (query, &live, &min, &max);
+
+      min += mlconverter->deadline;
+
+      if (GST_CLOCK_TIME_IS_VALID (max))
+        max += mlconverter->deadline;
+
+      gst_query_set_latency (query, live, min, max);
+
+      GST_DEBUG_OBJECT (mlconverter, "Latency min %" GST_TIME_FORMAT " max %"
+          GST_TIME_FORMAT, GST_TIME_ARGS (min), GST_TIME_ARGS (max));
+      return TRUE;
+    }
     default:
       break;
   }
@@ -1969,6 +2483,70 @@ gst_ml_video_converter_sink_event (GstBaseTransform * base, GstEvent * event)
   return GST_BASE_TRANSFORM_CLASS (parent_class)->sink_event (base, event);
 }
 
+static gboolean
+gst_ml_video_converter_src_event (GstBaseTransform * base, GstEvent * event)
+{
+  GstMLVideoConverter *mlconverter = GST_ML_VIDEO_CONVERTER (base);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CUSTOM_UPSTREAM:
+    {
+      const GstStructure *structure = gst_event_get_structure (event);
+      const GValue *regions = NULL, *entry = NULL;
+      gdouble left = G_MAXDOUBLE, top = G_MAXDOUBLE, right = 0.0, bottom = 0.0;
+      gdouble region[4] = { 0.0, };
+      guint idx = 0, num = 0, length = 0;
+
+      // Not a supported custom event, pass it to the default handling function.
+      if ((structure == NULL) ||
+          !gst_structure_has_name (structure, "ml-detection-regions"))
+        break;
+
+      regions = gst_structure_get_value (structure, "regions");
+      length = (regions != NULL) ? gst_value_array_get_size (regions) : 0;
+
+      // Union of the regions detected by the post-process in the last frame.
+      for (idx = 0; idx < length; idx++) {
+        entry = gst_value_array_get_value (regions, idx);
+
+        if (gst_value_array_get_size (entry) != 4)
+          continue;
+
+        for (num = 0; num < 4; num++)
+          region[num] = g_value_get_double (gst_value_array_get_value (entry, num));
+
+        left = MIN (left, region[0]);
+        top = MIN (top, region[1]);
+        right = MAX (right, region[0] + region[2]);
+        bottom = MAX (bottom, region[1] + region[3]);
+      }
+
+      GST_OBJECT_LOCK (mlconverter);
+
+      if ((left < right) && (top < bottom)) {
+        mlconverter->detections[0] = left;
+        mlconverter->detections[1] = top;
+        mlconverter->detections[2] = right - left;
+        mlconverter->detections[3] = bottom - top;
+      } else {
+        mlconverter->detections[2] = 0.0;
+      }
+
+      GST_OBJECT_UNLOCK (mlconverter);
+
+      GST_TRACE_OBJECT (mlconverter, "Received %u detection regions", length);
+
+      // The regions are meant for the nearest pre-process, do not propagate.
+      gst_event_unref (event);
+      return TRUE;
+    }
+    default:
+      break;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->src_event (base, event);
+}
+
 static GstCaps *
 gst_ml_video_converter_transform_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter)
@@ -2177,6 +2755,25 @@ gst_ml_video_converter_set_caps (GstBaseTransform * base, GstCaps * incaps,
     return FALSE;
   }
 
+  if ((mlconverter->mode == GST_ML_CONVERSION_MODE_IMAGE_TILED) &&
+      ((mlconverter->tensorlayout.d != -1) ||
+          (GST_VIDEO_INFO_MULTIVIEW_MODE (&ininfo) ==
+              GST_VIDEO_MULTIVIEW_MODE_SEPARATED))) {
+    GST_ERROR_OBJECT (mlconverter, "Tensors with depth and muxed streams are "
+        "not allowed in tiled mode!");
+    return FALSE;
+  }
+
+  if (mlconverter->roicrop &&
+      ((mlconverter->mode != GST_ML_CONVERSION_MODE_IMAGE_NON_CUMULATIVE) ||
+          (mlconverter->tensorlayout.d != -1) ||
+          (GST_VIDEO_INFO_MULTIVIEW_MODE (&ininfo) ==
+              GST_VIDEO_MULTIVIEW_MODE_SEPARATED))) {
+    GST_ERROR_OBJECT (mlconverter, "ROI crop is supported only in non-muxed "
+        "'image-batch-non-cumulative' mode without tensor depth!");
+    return FALSE;
+  }
+
   // Get the number of bytes that represent a give ML type.
   n_bytes = gst_ml_type_get_size (mlinfo.type);
 
@@ -2255,6 +2852,10 @@ gst_ml_video_converter_set_caps (GstBaseTransform * base, GstCaps * incaps,
   mlconverter->vinfo = gst_video_info_copy (&outinfo);
   mlconverter->mlinfo = gst_ml_info_copy (&mlinfo);
 
+  // Tile geometry depends only on the frame and tensor dimensions.
+  if (mlconverter->mode == GST_ML_CONVERSION_MODE_IMAGE_TILED)
+    gst_ml_video_converter_setup_tiles (mlconverter);
+
   // Initialize video converter engine.
   if (mlconverter->converter != NULL)
     gst_video_converter_engine_free (mlconverter->converter);
@@ -2340,6 +2941,18 @@ gst_ml_video_converter_stop (GstBaseTransform * base)
   mlconverter->next_roi_id = -1;
   mlconverter->next_mem_idx = -1;
 
+  mlconverter->n_cropped = 0;
+
+  GST_OBJECT_LOCK (mlconverter);
+  mlconverter->detections[2] = 0.0;
+  GST_OBJECT_UNLOCK (mlconverter);
+
+  // Release outputs published for reuse by other converters.
+  if (mlconverter->converter != NULL)
+    gst_video_converter_engine_flush (mlconverter->converter);
+
+  mlconverter->shared = FALSE;
+
   g_queue_clear_full (mlconverter->bufqueue, (GDestroyNotify) gst_buffer_unref);
 
   GST_INFO_OBJECT (mlconverter, "All processing has been stopped");
@@ -2371,10 +2984,13 @@ gst_ml_video_converter_prepare_output_buffer (GstBaseTransform * base,
       GST_BUFFER_FLAG_IS_SET (inbuffer, GST_BUFFER_FLAG_GAP))
     *outbuffer = gst_buffer_new ();
 
-  // Mode is one of the ROI modes and there are no previous buffers.
+  // Mode is one of the ROI modes and there are no previous buffers, or the
+  // mode is packed and the stashed ROIs have not yet exceeded the deadline.
   // Check whether there are ROI metas suitable for processing.
-  if ((*outbuffer == NULL) && g_queue_is_empty (bufqueue) &&
-      GST_CONVERSION_MODE_IS_ROI (mlconverter->mode)) {
+  if ((*outbuffer == NULL) && GST_CONVERSION_MODE_IS_ROI (mlconverter->mode) &&
+      (g_queue_is_empty (bufqueue) ||
+          ((mlconverter->mode == GST_ML_CONVERSION_MODE_ROI_PACKED) &&
+              !gst_ml_video_converter_deadline_expired (mlconverter, inbuffer)))) {
     GstVideoRegionOfInterestMeta *roimeta = NULL;
     gpointer state = NULL;
 
@@ -2389,6 +3005,13 @@ gst_ml_video_converter_prepare_output_buffer (GstBaseTransform * base,
       *outbuffer = gst_buffer_new ();
   }
 
+  // Tiled mode with ROI gating and none of the tiles contains a region.
+  if ((*outbuffer == NULL) &&
+      (mlconverter->mode == GST_ML_CONVERSION_MODE_IMAGE_TILED) &&
+      mlconverter->tileroi &&
+      !gst_ml_video_converter_has_active_tiles (mlconverter, inbuffer))
+    *outbuffer = gst_buffer_new ();
+
   if ((*outbuffer == NULL) &&
       gst_buffer_pool_acquire_buffer (pool, outbuffer, NULL) != GST_FLOW_OK) {
     GST_ERROR_OBJECT (mlconverter, "Failed to acquire output buffer!");
@@ -2398,6 +3021,17 @@ gst_ml_video_converter_prepare_output_buffer (GstBaseTransform * base,
   // Copy the timestamps from the input buffer.
   gst_buffer_copy_into (*outbuffer, inbuffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
 
+  // Another converter may have already produced identical output for the frame.
+  if (mlconverter->shareout && (mlconverter->converter != NULL) &&
+      (mlconverter->mode == GST_ML_CONVERSION_MODE_IMAGE_NON_CUMULATIVE) &&
+      (gst_buffer_get_size (*outbuffer) != 0) &&
+      !gst_ml_video_converter_lookup_output (mlconverter, inbuffer,
+          outbuffer)) {
+    GST_ERROR_OBJECT (mlconverter, "Failed to setup composition!");
+    gst_clear_buffer (outbuffer);
+    return GST_FLOW_ERROR;
+  }
+
   // If the output buffer is an empty shell, setup flags and additiona batch metas.
   if (gst_buffer_get_size (*outbuffer) == 0) {
     GstStructure *structure = NULL;
@@ -2415,7 +3049,7 @@ gst_ml_video_converter_prepare_output_buffer (GstBaseTransform * base,
         GstClockTime timestamp = GST_CLOCK_TIME_NONE;
         guint stream_id = 0;
 
-        sscanf (gst_structure_get_name (pmeta->info), "mux-stream-%2u", &stream_id);
+        sscanf (gst_structure_get_name (pmeta->info), "mux-stream-%u", &stream_id);
         gst_structure_get_uint64 (pmeta->info, "timestamp", &timestamp);
 
         structure = gst_structure_new (gst_batch_channel_name (idx++),
@@ -2448,9 +3082,7 @@ gst_ml_video_converter_transform (GstBaseTransform * base,
     GstBuffer * inbuffer, GstBuffer * outbuffer)
 {
   GstMLVideoConverter *mlconverter = GST_ML_VIDEO_CONVERTER (base);
-  const GstVideoInfo *ininfo = NULL, *outinfo = NULL;
   GstClockTime time = GST_CLOCK_TIME_NONE;
-  guint n_blits = 0;
   gboolean success = TRUE;
 
   // GAP buffer, nothing to do. Propagate output buffer downstream.
@@ -2458,31 +3090,37 @@ gst_ml_video_converter_transform (GstBaseTransform * base,
       GST_BUFFER_FLAG_IS_SET (outbuffer, GST_BUFFER_FLAG_GAP))
     return GST_FLOW_OK;
 
-  if (!gst_ml_video_converter_prepare_buffer_queues (mlconverter, inbuffer)) {
-    GST_TRACE_OBJECT (mlconverter, "Internal buffer queues not yet ready");
-    return GST_BASE_TRANSFORM_FLOW_DROPPED;
+  // Output was produced by another converter, propagate it downstream.
+  if (mlconverter->shared) {
+    mlconverter->shared = FALSE;
+    return GST_FLOW_OK;
   }
 
   time = gst_util_get_timestamp ();
-  success = gst_ml_video_converter_setup_composition (mlconverter, outbuffer);
 
-  if (!success) {
-    GST_ERROR_OBJECT (mlconverter, "Failed to setup composition!");
-    return GST_FLOW_ERROR;
-  }
+  // Composition may have been already set up during the output lookup.
+  if (mlconverter->composition.buffer != outbuffer) {
+    if (!gst_ml_video_converter_prepare_buffer_queues (mlconverter, inbuffer)) {
+      GST_TRACE_OBJECT (mlconverter, "Internal buffer queues not yet ready");
+      return GST_BASE_TRANSFORM_FLOW_DROPPED;
+    }
 
-  n_blits = mlconverter->composition.n_blits;
-  ininfo = mlconverter->composition.blits[0].info;
-  outinfo = mlconverter->composition.info;
+    success = gst_ml_video_converter_setup_composition (mlconverter, outbuffer);
 
-  // Perform transformation only when custom normalization coefficients are set,
-  // when there are multiple blit elements (buffers), or when there is only a
-  // single blit element which does not have the required parameters for output.
-  if (mlconverter->backend != GST_VCE_BACKEND_NONE &&
-      ((n_blits > 1) || is_conversion_required (ininfo, outinfo) ||
-          ((mlconverter->mean->len != 0) && (mlconverter->sigma->len != 0)))) {
+    if (!success) {
+      GST_ERROR_OBJECT (mlconverter, "Failed to setup composition!");
+      return GST_FLOW_ERROR;
+    }
+  }
+
+  if (gst_ml_video_converter_composition_required (mlconverter)) {
     success = gst_video_converter_engine_compose (mlconverter->converter,
         &(mlconverter->composition), 1, NULL);
+
+    // Make the output available to other converters processing this frame.
+    if (success && mlconverter->shareout)
+      gst_video_converter_engine_publish (mlconverter->converter,
+          &(mlconverter->composition));
   } else {
     // There is not need for frame conversion, apply only normalization.
     success = gst_ml_video_converter_normalize (mlconverter);
@@ -2542,6 +3180,30 @@ gst_ml_video_converter_set_property (GObject * object, guint prop_id,
       }
       break;
     }
+    case PROP_BATCH_DEADLINE:
+      mlconverter->deadline = g_value_get_uint64 (value);
+      break;
+    case PROP_TILE_OVERLAP:
+      mlconverter->overlap = g_value_get_double (value);
+      break;
+    case PROP_MAX_TILES:
+      mlconverter->maxtiles = g_value_get_uint (value);
+      break;
+    case PROP_TILE_ON_ROI:
+      mlconverter->tileroi = g_value_get_boolean (value);
+      break;
+    case PROP_ROI_CROP:
+      mlconverter->roicrop = g_value_get_boolean (value);
+      break;
+    case PROP_ROI_CROP_PADDING:
+      mlconverter->padding = g_value_get_double (value);
+      break;
+    case PROP_REFRESH_INTERVAL:
+      mlconverter->refresh = g_value_get_uint (value);
+      break;
+    case PROP_SHARE_OUTPUT:
+      mlconverter->shareout = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2597,6 +3259,30 @@ gst_ml_video_converter_get_property (GObject * object, guint prop_id,
       g_value_unset (&val);
       break;
     }
+    case PROP_BATCH_DEADLINE:
+      g_value_set_uint64 (value, mlconverter->deadline);
+      break;
+    case PROP_TILE_OVERLAP:
+      g_value_set_double (value, mlconverter->overlap);
+      break;
+    case PROP_MAX_TILES:
+      g_value_set_uint (value, mlconverter->maxtiles);
+      break;
+    case PROP_TILE_ON_ROI:
+      g_value_set_boolean (value, mlconverter->tileroi);
+      break;
+    case PROP_ROI_CROP:
+      g_value_set_boolean (value, mlconverter->roicrop);
+      break;
+    case PROP_ROI_CROP_PADDING:
+      g_value_set_double (value, mlconverter->padding);
+      break;
+    case PROP_REFRESH_INTERVAL:
+      g_value_set_uint (value, mlconverter->refresh);
+      break;
+    case PROP_SHARE_OUTPUT:
+      g_value_set_boolean (value, mlconverter->shareout);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2636,6 +3322,9 @@ gst_ml_video_converter_finalize (GObject * object)
   if (mlconverter->roi_stage_ids != NULL)
     g_array_free (mlconverter->roi_stage_ids, TRUE);
 
+  if (mlconverter->tiles != NULL)
+    g_array_free (mlconverter->tiles, TRUE);
+
   gst_ml_stage_unregister_unique_index (mlconverter->stage_id);
 
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (mlconverter));
@@ -2690,6 +3379,60 @@ gst_ml_video_converter_class_init (GstMLVideoConverterClass * klass)
               "One of B, G or R value.", 0.0, 255.0, DEFAULT_PROP_SIGMA,
               G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_BATCH_DEADLINE,
+      g_param_spec_uint64 ("batch-deadline", "Batch Deadline",
+          "Maximum time in nanoseconds (stream time) the oldest stashed ROI "
+          "waits for the tensor batch to be filled in 'roi-batch-packed' mode "
+          "before a partially filled batch is processed (0 = no deadline)",
+          0, G_MAXUINT64, DEFAULT_PROP_BATCH_DEADLINE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_TILE_OVERLAP,
+      g_param_spec_double ("tile-overlap", "Tile Overlap",
+          "Minimum overlap between neighbouring tiles as a fraction of the "
+          "tile size in 'image-tiled' mode",
+          0.0, 0.9, DEFAULT_PROP_TILE_OVERLAP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_MAX_TILES,
+      g_param_spec_uint ("max-tiles", "Max Tiles",
+          "Maximum number of tiles per frame in 'image-tiled' mode, tiles are "
+          "enlarged until they fit (0 = tensor batch size)",
+          0, G_MAXUINT, DEFAULT_PROP_MAX_TILES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_TILE_ON_ROI,
+      g_param_spec_boolean ("tile-on-roi", "Tile On ROI",
+          "In 'image-tiled' mode process only the tiles which intersect with "
+          "ROI metas from a previous (e.g. coarse full frame) detection stage. "
+          "Frames without such ROI metas produce GAP buffers",
+          DEFAULT_PROP_TILE_ON_ROI,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_ROI_CROP,
+      g_param_spec_boolean ("roi-crop", "ROI Crop",
+          "In 'image-batch-non-cumulative' mode convert only the area around "
+          "the ROI metas attached to the frame (e.g. from previous detections "
+          "or object tracker) instead of the full frame",
+          DEFAULT_PROP_ROI_CROP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_ROI_CROP_PADDING,
+      g_param_spec_double ("roi-crop-padding", "ROI Crop Padding",
+          "Padding added on each side of the ROIs union as a fraction of its "
+          "dimensions in 'roi-crop' mode",
+          0.0, 1.0, DEFAULT_PROP_ROI_CROP_PADDING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_REFRESH_INTERVAL,
+      g_param_spec_uint ("refresh-interval", "Refresh Interval",
+          "Number of frames after which the full frame is converted in "
+          "'roi-crop' mode in order to detect new objects (0 = only when "
+          "there are no ROIs)",
+          0, G_MAXUINT, DEFAULT_PROP_REFRESH_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_SHARE_OUTPUT,
+      g_param_spec_boolean ("share-output", "Share Output",
+          "In 'image-batch-non-cumulative' mode reuse the output of another "
+          "converter which already performed identical conversion of the same "
+          "frame (e.g. parallel branches after a tee) and publish own output "
+          "for reuse. Shared output buffers are not writable",
+          DEFAULT_PROP_SHARE_OUTPUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (element,
       "Machine Learning Video Converter", "Filter/Video/Scaler",
@@ -2707,6 +3450,7 @@ gst_ml_video_converter_class_init (GstMLVideoConverterClass * klass)
 
   base->query = GST_DEBUG_FUNCPTR (gst_ml_video_converter_query);
   base->sink_event = GST_DEBUG_FUNCPTR (gst_ml_video_converter_sink_event);
+  base->src_event = GST_DEBUG_FUNCPTR (gst_ml_video_converter_src_event);
 
   base->transform_caps =
       GST_DEBUG_FUNCPTR (gst_ml_video_converter_transform_caps);
@@ -2747,13 +3491,26 @@ gst_ml_video_converter_init (GstMLVideoConverter * mlconverter)
 
   mlconverter->tensorlayout = GST_ML_TENSOR_LAYOUT_NHWC;
 
+  mlconverter->tiles = g_array_new (FALSE, FALSE, sizeof (GstVideoRectangle));
+  mlconverter->n_cropped = 0;
+  mlconverter->detections[2] = 0.0;
+
   mlconverter->converter = NULL;
+  mlconverter->shared = FALSE;
 
   mlconverter->backend = DEFAULT_PROP_ENGINE_BACKEND;
   mlconverter->disposition = DEFAULT_PROP_IMAGE_DISPOSITION;
   mlconverter->pixlayout = DEFAULT_PROP_SUBPIXEL_LAYOUT;
   mlconverter->mean = g_array_new (FALSE, FALSE, sizeof (gdouble));
   mlconverter->sigma = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  mlconverter->deadline = DEFAULT_PROP_BATCH_DEADLINE;
+  mlconverter->overlap = DEFAULT_PROP_TILE_OVERLAP;
+  mlconverter->maxtiles = DEFAULT_PROP_MAX_TILES;
+  mlconverter->tileroi = DEFAULT_PROP_TILE_ON_ROI;
+  mlconverter->roicrop = DEFAULT_PROP_ROI_CROP;
+  mlconverter->padding = DEFAULT_PROP_ROI_CROP_PADDING;
+  mlconverter->refresh = DEFAULT_PROP_REFRESH_INTERVAL;
+  mlconverter->shareout = DEFAULT_PROP_SHARE_OUTPUT;
 
   // Handle buffers with GAP flag internally.
   gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (mlconverter), TRUE);
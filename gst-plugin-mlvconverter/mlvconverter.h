@@ -68,6 +68,8 @@ typedef enum {
   GST_ML_CONVERSION_MODE_IMAGE_CUMULATIVE,
   GST_ML_CONVERSION_MODE_ROI_NON_CUMULATIVE,
   GST_ML_CONVERSION_MODE_ROI_CUMULATIVE,
+  GST_ML_CONVERSION_MODE_ROI_PACKED,
+  GST_ML_CONVERSION_MODE_IMAGE_TILED,
 } GstConversionMode;
 
 typedef enum {
@@ -130,9 +132,21 @@ struct _GstMLVideoConverter {
   // Tensor layout configured
   GstTensorLayout      tensorlayout;
 
+  /// Tile regions (GstVideoRectangle) inside the input frame, tiled mode only.
+  GArray               *tiles;
+
+  /// Running count of converted frames, used for the periodic full frame
+  /// refresh in ROI crop mode.
+  guint                n_cropped;
+  /// Union (X, Y, W, H) of the last regions fed back by the ML post-process in
+  /// ROI crop mode, relative to the frame. Width of 0 if there are none.
+  gdouble              detections[4];
+
   /// Video converter engine.
   GstVideoConvEngine   *converter;
   GstVideoComposition  composition;
+  /// Whether the output buffer was produced by another converter.
+  gboolean             shared;
 
   /// Properties.
   GstConversionMode    mode;
@@ -141,6 +155,14 @@ struct _GstMLVideoConverter {
   GstVideoPixelLayout  pixlayout;
   GArray               *mean;
   GArray               *sigma;
+  GstClockTime         deadline;
+  gdouble              overlap;
+  guint                maxtiles;
+  gboolean             tileroi;
+  gboolean             roicrop;
+  gdouble              padding;
+  guint                refresh;
+  gboolean             shareout;
 };
 
 struct _GstMLVideoConverterClass {
@@ -39,6 +39,7 @@ BYTETracker::BYTETracker(const ByteTrackerConfig &config)
     match_thresh = 0.8f;
 
     frame_id = 0;
+    track_count = 0;
     max_time_lost = int(config.frame_rate / 30.0f * config.track_buffer);
 
     QMOT_LOG_DEBUG("BYTETracker constructor, max_time_lost = %d", max_time_lost);
@@ -46,267 +47,369 @@ BYTETracker::BYTETracker(const ByteTrackerConfig &config)
     QMOT_LOG_DEBUG("BYTETracker constructor, config.track_buffer = %d", config.track_buffer);
 
     track_wh_smooth_factor = config.wh_smooth_factor;
+
+    reid_thresh = config.reid_thresh;
+    reid_gallery_size = max(config.reid_gallery_size, 1);
+
+    m_feature_dim = 0;
+    m_appearance_fused = false;
+
+    m_cost_rows = 0;
+    m_cost_cols = 0;
 }
 
 BYTETracker::~BYTETracker()
 {
 }
 
-vector<STrack> BYTETracker::update(const vector<ByteTrackerObject>& objects)
+void ByteTrackerFrame::clear()
 {
-    // QMOT_LOG_DEBUG("--------------------------- frame %d ---------------------------", this->frame_id);
+    activated_stracks.clear();
+    refind_stracks.clear();
+    removed_stracks.clear();
+    lost_stracks.clear();
 
-    ////////////////// Step 1: Get detections //////////////////
-    this->frame_id++;
-    vector<STrack*> activated_stracks;
-    vector<STrack*> refind_stracks;
-    vector<STrack*> removed_stracks;
-    vector<STrack*> lost_stracks;
+    detections.clear();
+    detections_low.clear();
+    detections_cp.clear();
 
-    vector<STrack*> detections_all;
-    vector<STrack*> detections;
-    vector<STrack*> detections_low;
-    vector<STrack*> detections_cp;
-    vector<STrack*> detections_ambiguous; // detections which are close to more than one tracks in first association
+    unconfirmed.clear();
+    tracked_stracks.clear();
+    strack_pool.clear();
+    r_tracked_stracks.clear();
 
-    vector<STrack> output_stracks;
+    matches.clear();
+    u_track.clear();
+    u_detection.clear();
+    u_unconfirmed.clear();
+}
 
-    vector<STrack*> unconfirmed;
-    vector<STrack*> tracked_stracks;
-    vector<STrack*> strack_pool;
-    vector<STrack*> r_tracked_stracks;
+int BYTETracker::next_id()
+{
+    return ++this->track_count;
+}
 
-    // Calculate maximum overlap(IOU) between each detection box
-    // Our detection boxes are from instance mask, so basically there won't be large overlapped boxes
-    vector<float> adjacency_ious(objects.size(), 0.f);
-    for (size_t i = 0; i < adjacency_ious.size(); i++) {
-        for (size_t j = 0; j < adjacency_ious.size(); j++) {
-            if (i != j) {
-                // compute "intersection over self"
-                float iou = compute_intersection_over_self (
-                    objects[i].bounding_box[0],
-                    objects[i].bounding_box[1],
-                    objects[i].bounding_box[2],
-                    objects[i].bounding_box[3],
-                    objects[j].bounding_box[0],
-                    objects[j].bounding_box[1],
-                    objects[j].bounding_box[2],
-                    objects[j].bounding_box[3]);
-                adjacency_ious[i] = max(adjacency_ious[i], iou);
-            }
+// The embedding of the detection points into a buffer which is reused on the
+// next update, tracks keep their own copies in the gallery instead.
+STrack *BYTETracker::acquire_strack(const STrack &detection)
+{
+    STrack *strack = nullptr;
+
+    if (this->m_free_stracks.empty()) {
+        this->m_strack_arena.push_back(detection);
+        strack = &this->m_strack_arena.back();
+    } else {
+        strack = this->m_free_stracks.back();
+        this->m_free_stracks.pop_back();
+
+        *strack = detection;
+    }
+
+    strack->reid_feature = nullptr;
+    return strack;
+}
+
+void BYTETracker::release_strack(STrack *strack)
+{
+    this->m_free_stracks.push_back(strack);
+}
+
+// Calculate maximum overlap (intersection over self) between each detection
+// box. Boxes are swept in order of their left edge, so only the pairs which
+// overlap horizontally are compared instead of all of them.
+void BYTETracker::compute_adjacency(const vector<ByteTrackerObject> &objects)
+{
+    size_t n_objects = objects.size();
+
+    this->m_adjacency.assign(n_objects, 0.f);
+    this->m_sweep_order.resize(n_objects);
+
+    for (size_t i = 0; i < n_objects; i++)
+        this->m_sweep_order[i] = i;
+
+    sort(this->m_sweep_order.begin(), this->m_sweep_order.end(),
+        [&objects] (uint32_t l, uint32_t r) {
+            return objects[l].bounding_box[0] < objects[r].bounding_box[0];
+        });
+
+    for (size_t i = 0; i < n_objects; i++) {
+        uint32_t idx_a = this->m_sweep_order[i];
+        const float *box_a = objects[idx_a].bounding_box;
+
+        for (size_t j = i + 1; j < n_objects; j++) {
+            uint32_t idx_b = this->m_sweep_order[j];
+            const float *box_b = objects[idx_b].bounding_box;
+
+            // This and all following boxes start right of box A.
+            if (box_b[0] >= box_a[2])
+                break;
+
+            float w_intersect = min(box_a[2], box_b[2]) - max(box_a[0], box_b[0]);
+            float h_intersect = min(box_a[3], box_b[3]) - max(box_a[1], box_b[1]);
+
+            if (w_intersect <= 0.f || h_intersect <= 0.f)
+                continue;
+
+            this->m_adjacency[idx_a] = max(this->m_adjacency[idx_a],
+                compute_intersection_over_self(box_a[0], box_a[1], box_a[2],
+                    box_a[3], box_b[0], box_b[1], box_b[2], box_b[3]));
+            this->m_adjacency[idx_b] = max(this->m_adjacency[idx_b],
+                compute_intersection_over_self(box_b[0], box_b[1], box_b[2],
+                    box_b[3], box_a[0], box_a[1], box_a[2], box_a[3]));
         }
     }
+}
+
+// Copy the embeddings of the detections as unit vectors so that the cosine
+// distance reduces to a dot product. Embeddings of a frame come from a single
+// model, ones with a different dimension than the first are ignored.
+void BYTETracker::normalize_features(const vector<ByteTrackerObject> &objects)
+{
+    this->m_feature_dim = 0;
 
-    if (objects.size() > 0) {
-        for (size_t i = 0; i < objects.size(); i++) {
-            vector<float> tlbr_;
-            tlbr_.resize(4);
-            /*tlbr_[0] = objects[i].rect.x;
-            tlbr_[1] = objects[i].rect.y;
-            tlbr_[2] = objects[i].rect.x + objects[i].rect.width;
-            tlbr_[3] = objects[i].rect.y + objects[i].rect.height;*/
-            tlbr_[0] = objects[i].bounding_box[0];
-            tlbr_[1] = objects[i].bounding_box[1];
-            tlbr_[2] = objects[i].bounding_box[2];
-            tlbr_[3] = objects[i].bounding_box[3];
-
-            float score = objects[i].prob;
-
-            STrack *strack = new STrack(STrack::tlbr_to_tlwh(tlbr_), score, objects[i].label);
-            strack->adjacency_overlap = adjacency_ious[i];
-
-            detections_all.push_back(strack);
-
-            if (score >= track_thresh)
-                detections.push_back(strack);
-            else
-                detections_low.push_back(strack);
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objects[i].feature != nullptr && objects[i].n_feature > 0) {
+            this->m_feature_dim = objects[i].n_feature;
+            break;
         }
     }
 
+    if (this->m_feature_dim == 0)
+        return;
+
+    size_t dim = this->m_feature_dim;
+    this->m_features.resize(objects.size() * dim);
+
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objects[i].feature == nullptr || objects[i].n_feature != int(dim))
+            continue;
+
+        Eigen::Map<const Eigen::VectorXf> feature(objects[i].feature, dim);
+        Eigen::Map<Eigen::VectorXf> normalized(&this->m_features[i * dim], dim);
+
+        float norm = feature.norm();
+
+        if (!(norm > 0.f))
+            continue;
+
+        normalized = feature / norm;
+        this->m_detections[i].reid_feature = normalized.data();
+    }
+}
+
+void BYTETracker::update_appearance(STrack *track, const STrack *detection)
+{
+    // Embeddings of detections overlapped by other boxes are mixed with the
+    // appearance of their neighbours, keep them out of the gallery.
+    if (detection->reid_feature == nullptr ||
+        detection->adjacency_overlap > 0.5f)
+        return;
+
+    track->update_reid(detection->reid_feature, this->m_feature_dim,
+        this->reid_gallery_size);
+}
+
+const vector<STrack*> &BYTETracker::update(const vector<ByteTrackerObject>& objects)
+{
+    // QMOT_LOG_DEBUG("--------------------------- frame %d ---------------------------", this->frame_id);
+
+    ////////////////// Step 1: Get detections //////////////////
+    this->frame_id++;
+
+    ByteTrackerFrame &frame = this->m_frame;
+    frame.clear();
+
+    // Our detection boxes are from instance mask, so basically there won't be large overlapped boxes
+    compute_adjacency(objects);
+
+    // All detections are created before taking pointers to them, the vector
+    // may reallocate while it grows.
+    this->m_detections.clear();
+    for (size_t i = 0; i < objects.size(); i++) {
+        this->m_detections.emplace_back(
+            STrack::tlbr_to_tlwh(objects[i].bounding_box), objects[i].prob,
+            objects[i].label);
+        this->m_detections.back().adjacency_overlap = this->m_adjacency[i];
+    }
+
+    normalize_features(objects);
+
+    for (size_t i = 0; i < this->m_detections.size(); i++) {
+        STrack *strack = &this->m_detections[i];
+
+        if (strack->score >= track_thresh)
+            frame.detections.push_back(strack);
+        else
+            frame.detections_low.push_back(strack);
+    }
+
     // Add newly detected tracklets to tracked_stracks
     for (size_t i = 0; i < this->m_tracked_stracks.size(); i++) {
         if (this->m_tracked_stracks[i]->state == TrackState::New)
-            unconfirmed.push_back(this->m_tracked_stracks[i]);
+            frame.unconfirmed.push_back(this->m_tracked_stracks[i]);
         else
-            tracked_stracks.push_back(this->m_tracked_stracks[i]);
+            frame.tracked_stracks.push_back(this->m_tracked_stracks[i]);
     }
 
-    ////////////////// Step 2: First association, with IoU //////////////////
-    strack_pool = joint_stracks(tracked_stracks, this->m_lost_stracks);
+    ////////////////// Step 2: First association, with IoU and appearance //////////////////
+    joint_stracks(frame.strack_pool, frame.tracked_stracks, this->m_lost_stracks);
 
-    STrack::multi_predict(strack_pool, this->kalman_filter);
+    STrack::multi_predict(frame.strack_pool, this->kalman_filter);
 
     //change object bounding box to prediction
-    for (size_t i = 0; i < strack_pool.size(); i++) {
-        strack_pool[i]->static_tlwh();
-        strack_pool[i]->static_tlbr();
+    for (size_t i = 0; i < frame.strack_pool.size(); i++) {
+        frame.strack_pool[i]->static_tlwh();
+        frame.strack_pool[i]->static_tlbr();
     }
 
-    vector<vector<float> > dists;
-    uint32_t dist_size = 0, dist_size_size = 0;
-    dists = iou_distance(strack_pool, detections, dist_size, dist_size_size);
-
-    // 1. find ambiguous detections which are close to more than one tracks
-    // 2. find ambiguous tracks which are close to more than one detections
+    iou_distance(frame.strack_pool, frame.detections);
+    fuse_appearance(frame.strack_pool, frame.detections);
+    linear_assignment(match_thresh, frame.matches, frame.u_track, frame.u_detection);
 
-    // recompute distance without ambiguous detections
-    dists = iou_distance(strack_pool, detections, dist_size, dist_size_size);
-
-    vector<vector<uint32_t> > matches;
-    vector<uint32_t> u_track, u_detection;
-    linear_assignment(dists, dist_size, dist_size_size, match_thresh, matches, u_track, u_detection);
-
-    for (size_t i = 0; i < matches.size(); i++) {
-        STrack *track = strack_pool[matches[i][0]];
-        STrack *det = detections[matches[i][1]];
+    for (size_t i = 0; i < frame.matches.size(); i++) {
+        STrack *track = frame.strack_pool[frame.matches[i].first];
+        STrack *det = frame.detections[frame.matches[i].second];
         //convert from distance to score, the larger the better
-        float iou_score = 1 - dists[matches[i][0]][matches[i][1]];
+        float iou_score = 1 - iou_cost(frame.matches[i].first, frame.matches[i].second);
+        update_appearance(track, det);
         if (track->state == TrackState::Tracked) {
             //update the tracker with matched detection
             track->update(*det, this->frame_id, iou_score, this->track_wh_smooth_factor);
             // update corresponding detection id
             track->matched_detection_id = det->matched_detection_id;
-            activated_stracks.push_back(track);
+            frame.activated_stracks.push_back(track);
         }
         else {
-            track->re_activate(*det, this->frame_id, false, iou_score);
+            track->re_activate(*det, this->frame_id, iou_score);
             // update corresponding detection id
             track->matched_detection_id = det->matched_detection_id;
-            refind_stracks.push_back(track);
+            frame.refind_stracks.push_back(track);
         }
     }
 
     ////////////////// Step 3: Second association, using low score dets //////////////////
-    for (size_t i = 0; i < u_detection.size(); i++) {
-        detections_cp.push_back(detections[u_detection[i]]);
+    for (size_t i = 0; i < frame.u_detection.size(); i++) {
+        frame.detections_cp.push_back(frame.detections[frame.u_detection[i]]);
     }
-    detections.clear();
-    detections.assign(detections_low.begin(), detections_low.end());
 
-    for (size_t i = 0; i < u_track.size(); i++) {
-        if (strack_pool[u_track[i]]->state == TrackState::Tracked) {
-            r_tracked_stracks.push_back(strack_pool[u_track[i]]);
+    for (size_t i = 0; i < frame.u_track.size(); i++) {
+        STrack *track = frame.strack_pool[frame.u_track[i]];
+
+        if (track->state == TrackState::Tracked) {
+            frame.r_tracked_stracks.push_back(track);
         }
         else {
-            strack_pool[u_track[i]]->matched_detection_id = -1;
-            lost_stracks.push_back(strack_pool[u_track[i]]);
+            track->matched_detection_id = -1;
+            frame.lost_stracks.push_back(track);
         }
     }
 
-    dists.clear();
-    dists = iou_distance(r_tracked_stracks, detections, dist_size, dist_size_size);
+    frame.matches.clear();
+    frame.u_track.clear();
+    frame.u_detection.clear();
 
-    matches.clear();
-    u_track.clear();
-    u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.5, matches, u_track, u_detection);
+    iou_distance(frame.r_tracked_stracks, frame.detections_low);
+    linear_assignment(0.5, frame.matches, frame.u_track, frame.u_detection);
 
-    for (size_t i = 0; i < matches.size(); i++) {
-        STrack *track = r_tracked_stracks[matches[i][0]];
-        STrack *det = detections[matches[i][1]];
-        float iou_score = 1 - dists[matches[i][0]][matches[i][1]]; //convert from distance to score, the larger the better
+    for (size_t i = 0; i < frame.matches.size(); i++) {
+        STrack *track = frame.r_tracked_stracks[frame.matches[i].first];
+        STrack *det = frame.detections_low[frame.matches[i].second];
+        float iou_score = 1 - cost(frame.matches[i].first, frame.matches[i].second); //convert from distance to score, the larger the better
+        update_appearance(track, det);
         if (track->state == TrackState::Tracked) {
             track->update(*det, this->frame_id, iou_score, this->track_wh_smooth_factor);
             track->matched_detection_id = det->matched_detection_id; // update corresponding detection id
-            activated_stracks.push_back(track);
+            frame.activated_stracks.push_back(track);
         }
         else {
-            track->re_activate(*det, this->frame_id, false, iou_score);
+            track->re_activate(*det, this->frame_id, iou_score);
             track->matched_detection_id = det->matched_detection_id; // update corresponding detection id
-            refind_stracks.push_back(track);
+            frame.refind_stracks.push_back(track);
         }
     }
 
-    for (size_t i = 0; i < u_track.size(); i++) {
-        STrack *track = r_tracked_stracks[u_track[i]];
+    for (size_t i = 0; i < frame.u_track.size(); i++) {
+        STrack *track = frame.r_tracked_stracks[frame.u_track[i]];
         track->mark_lost();
         track->matched_detection_id = -1;
-        lost_stracks.push_back(track);
+        frame.lost_stracks.push_back(track);
     }
 
     // Deal with unconfirmed tracks, usually tracks with only one beginning frame
-    detections.clear();
-    detections.assign(detections_cp.begin(), detections_cp.end());
-
-    dists.clear();
-    dists = iou_distance(unconfirmed, detections, dist_size, dist_size_size);
+    frame.matches.clear();
+    frame.u_detection.clear();
 
-    matches.clear();
-    vector<uint32_t> u_unconfirmed;
-    u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.7f, matches, u_unconfirmed, u_detection);
+    iou_distance(frame.unconfirmed, frame.detections_cp);
+    linear_assignment(0.7f, frame.matches, frame.u_unconfirmed, frame.u_detection);
 
-    for (size_t i = 0; i < matches.size(); i++) {
-        float iou_score = 1 - dists[matches[i][0]][matches[i][1]]; //convert from distance to score, the larger the better
+    for (size_t i = 0; i < frame.matches.size(); i++) {
+        float iou_score = 1 - cost(frame.matches[i].first, frame.matches[i].second); //convert from distance to score, the larger the better
 
-        STrack *track = unconfirmed[matches[i][0]];
-        STrack *det = detections[matches[i][1]];
+        STrack *track = frame.unconfirmed[frame.matches[i].first];
+        STrack *det = frame.detections_cp[frame.matches[i].second];
+        update_appearance(track, det);
         track->update(*det, this->frame_id, iou_score, this->track_wh_smooth_factor);
         track->matched_detection_id = det->matched_detection_id; // update corresponding detection id
-        activated_stracks.push_back(track);
+        frame.activated_stracks.push_back(track);
     }
 
-    for (size_t i = 0; i < u_unconfirmed.size(); i++) {
-        STrack *track = unconfirmed[u_unconfirmed[i]];
+    for (size_t i = 0; i < frame.u_unconfirmed.size(); i++) {
+        STrack *track = frame.unconfirmed[frame.u_unconfirmed[i]];
         track->mark_removed();
-        removed_stracks.push_back(track);
+        frame.removed_stracks.push_back(track);
     }
 
     ////////////////// Step 4: Init new stracks //////////////////
     //activation is only on newly unmatched high-confidence detection
-    for (size_t i = 0; i < u_detection.size(); i++) {
-        if (detections[u_detection[i]]->score < this->high_thresh)
+    for (size_t i = 0; i < frame.u_detection.size(); i++) {
+        STrack *det = frame.detections_cp[frame.u_detection[i]];
+
+        if (det->score < this->high_thresh)
             continue;
 
-        STrack *track = new STrack(*detections[u_detection[i]]); // copy constructor
-        track->activate(this->kalman_filter, this->frame_id);
-        activated_stracks.push_back(track);
+        STrack *track = acquire_strack(*det);
+        track->activate(this->kalman_filter, next_id(), this->frame_id);
+        update_appearance(track, det);
+        frame.activated_stracks.push_back(track);
 
         QMOT_LOG_DEBUG("Init new track: %d", track->track_id);
     }
 
-    // Delete all detections
-    for (size_t i = 0; i < detections_all.size(); i++) {
-        delete detections_all[i];
-    }
-
     ////////////////// Step 5: Update state - ychiao //////////////////
     // (1) update this->m_tracked_stracks: combine activated_stracks and refind_stracks
     // unconfirmed tracks are already in activated_stracks
-    this->m_tracked_stracks.clear();
-    this->m_tracked_stracks = joint_stracks(this->m_tracked_stracks, activated_stracks);
-    this->m_tracked_stracks = joint_stracks(this->m_tracked_stracks, refind_stracks);
+    joint_stracks(this->m_tracked_stracks, frame.activated_stracks,
+        frame.refind_stracks);
 
     // (2) update this->m_lost_tracks and this->m_removed_stracks
     this->m_lost_stracks.clear();
     this->m_removed_stracks.clear();
-    for (size_t i = 0; i < lost_stracks.size(); i++) {
-        if (this->frame_id - lost_stracks[i]->end_frame() > this->max_time_lost)
-          this->m_removed_stracks.push_back(lost_stracks[i]);
+    for (size_t i = 0; i < frame.lost_stracks.size(); i++) {
+        if (this->frame_id - frame.lost_stracks[i]->end_frame() > this->max_time_lost)
+          this->m_removed_stracks.push_back(frame.lost_stracks[i]);
         else
-          this->m_lost_stracks.push_back(lost_stracks[i]);
+          this->m_lost_stracks.push_back(frame.lost_stracks[i]);
     }
 
-    for (size_t i = 0; i < removed_stracks.size(); i++)
-      this->m_removed_stracks.push_back(removed_stracks[i]);
+    for (size_t i = 0; i < frame.removed_stracks.size(); i++)
+      this->m_removed_stracks.push_back(frame.removed_stracks[i]);
 
-    // Do not keep removed tracks for memory efficiency
+    // Do not keep removed tracks, hand them back to the arena
     for (size_t i = 0; i < this->m_removed_stracks.size(); i++)
-      delete this->m_removed_stracks[i];
+      release_strack(this->m_removed_stracks[i]);
 
     this->m_removed_stracks.clear();
 
     // returned the tracked tracks
-    for (size_t i = 0; i < this->m_tracked_stracks.size(); i++)
-      output_stracks.push_back(*this->m_tracked_stracks[i]);
+    this->m_output_stracks.assign(this->m_tracked_stracks.begin(),
+        this->m_tracked_stracks.end());
 
     // add the lost tracks (no matched detections)
-    for (size_t i = 0; i < this->m_lost_stracks.size(); i++)
-      output_stracks.push_back(*this->m_lost_stracks[i]);
+    this->m_output_stracks.insert(this->m_output_stracks.end(),
+        this->m_lost_stracks.begin(), this->m_lost_stracks.end());
 
     // print_statistics();
-    return output_stracks;
+    return this->m_output_stracks;
 }
 
 void BYTETracker::print_statistics()
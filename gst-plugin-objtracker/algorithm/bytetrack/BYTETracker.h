@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <deque>
 #include <fstream>
 #include <string>
 
@@ -43,6 +44,10 @@ struct ByteTrackerObject {
   float bounding_box[4] = { 0, 0, 0, 0 }; // x0, y0, x1, y1
   int   label;
   float prob;
+
+  // Optional appearance embedding, n_feature floats or NULL.
+  const float *feature = nullptr;
+  int   n_feature = 0;
 };
 
 
@@ -56,6 +61,10 @@ class ByteTrackerConfig {
     // tracker confidence thresholds
     track_thresh = 0.5f; // high threshold of detection confidence for 1st round of matching
     high_thresh = 0.6f; // threshold of detection confidence for initialize new track
+
+    // appearance association, used only when detections carry embeddings
+    reid_thresh = 0.25f;
+    reid_gallery_size = 10;
   }
 
   ~ByteTrackerConfig() {};
@@ -69,6 +78,46 @@ class ByteTrackerConfig {
   // tracker confidence thresholds
   float track_thresh; // high threshold of detection confidence for 1st round of matching
   float high_thresh; // threshold of detection confidence for initialize new track
+
+  float reid_thresh; // maximum cosine distance for a match by appearance
+  int   reid_gallery_size; // number of embeddings kept per track
+};
+
+
+// Per-frame track lists, kept in the tracker so their storage is reused.
+struct ByteTrackerFrame {
+  void clear();
+
+  vector<STrack*>                 activated_stracks;
+  vector<STrack*>                 refind_stracks;
+  vector<STrack*>                 removed_stracks;
+  vector<STrack*>                 lost_stracks;
+
+  vector<STrack*>                 detections;
+  vector<STrack*>                 detections_low;
+  vector<STrack*>                 detections_cp;
+
+  vector<STrack*>                 unconfirmed;
+  vector<STrack*>                 tracked_stracks;
+  vector<STrack*>                 strack_pool;
+  vector<STrack*>                 r_tracked_stracks;
+
+  vector<pair<uint32_t, uint32_t> > matches;
+  vector<uint32_t>                u_track;
+  vector<uint32_t>                u_detection;
+  vector<uint32_t>                u_unconfirmed;
+};
+
+// Corners and areas of a set of boxes, one array per component so that the
+// pairwise IoU loop runs over contiguous memory.
+struct ByteTrackerBoxes {
+  void assign(const vector<STrack*> &stracks);
+
+  vector<float>                   x1;
+  vector<float>                   y1;
+  vector<float>                   x2;
+  vector<float>                   y2;
+  vector<float>                   area;
 };
 
 
@@ -77,40 +126,47 @@ class BYTETracker {
   BYTETracker(const ByteTrackerConfig &config);
   ~BYTETracker();
 
-  vector<STrack> update(const vector<ByteTrackerObject>& objects);
+  // The returned tracks are owned by the tracker and valid until next update.
+  const vector<STrack*> &update(const vector<ByteTrackerObject>& objects);
   // Scalar get_color(int idx);
 
  private:
-  vector<STrack*> joint_stracks(vector<STrack*> &tlista, vector<STrack> &tlistb);
-  vector<STrack> joint_stracks(vector<STrack> &tlista, vector<STrack> &tlistb);
-  vector<STrack*> joint_stracks(vector<STrack*> &tlista, vector<STrack*> &tlistb);
-
-  vector<STrack> sub_stracks(vector<STrack> &tlista, vector<STrack> &tlistb);
-  vector<STrack*> sub_stracks(vector<STrack*> &tlista, vector<STrack*> &tlistb);
-  void remove_duplicate_stracks(vector<STrack> &resa, vector<STrack> &resb,
-      vector<STrack> &stracksa, vector<STrack> &stracksb);
-
-  void linear_assignment(vector<vector<float> > &cost_matrix,
-      uint32_t cost_matrix_size, uint32_t cost_matrix_size_size, float thresh,
-      vector<vector<uint32_t> > &matches, vector<uint32_t> &unmatched_a,
-      vector<uint32_t> &unmatched_b);
-  vector<vector<float> > iou_distance(vector<STrack*> &atracks,
-      vector<STrack> &btracks, uint32_t &dist_size, uint32_t &dist_size_size);
-  vector<vector<float> > iou_distance(vector<STrack*> &atracks,
-      vector<STrack*> &btracks, uint32_t &dist_size, uint32_t &dist_size_size);
-  vector<vector<float> > iou_distance(vector<STrack> &atracks,
-      vector<STrack> &btracks);
-  vector<vector<float> > ious(vector<vector<float> > &atlbrs,
-      vector<vector<float> > &btlbrs);
+  int next_id();
+
+  STrack *acquire_strack(const STrack &detection);
+  void release_strack(STrack *strack);
+
+  void joint_stracks(vector<STrack*> &res, const vector<STrack*> &tlista,
+      const vector<STrack*> &tlistb);
+
+  void compute_adjacency(const vector<ByteTrackerObject> &objects);
+
+  void normalize_features(const vector<ByteTrackerObject> &objects);
+  void fuse_appearance(const vector<STrack*> &atracks,
+      const vector<STrack*> &detections);
+  void update_appearance(STrack *track, const STrack *detection);
+
+  void linear_assignment(float thresh,
+      vector<pair<uint32_t, uint32_t> > &matches,
+      vector<uint32_t> &unmatched_a, vector<uint32_t> &unmatched_b);
+  void iou_distance(const vector<STrack*> &atracks,
+      const vector<STrack*> &btracks);
+  float cost(uint32_t row, uint32_t col) const {
+    return m_cost_matrix[row * m_cost_cols + col];
+  }
+  float iou_cost(uint32_t row, uint32_t col) const {
+    return m_appearance_fused ? m_iou_matrix[row * m_cost_cols + col] :
+        cost(row, col);
+  }
   float compute_iou(float box1_x1, float box1_y1, float box1_x2, float box1_y2,
       float box2_x1, float box2_y1, float box2_x2, float box2_y2);
   float compute_intersection_over_self(float box1_x1, float box1_y1,
       float box1_x2, float box1_y2, float box2_x1, float box2_y1,
       float box2_x2, float box2_y2);
 
-  double lapjv(const vector<vector<float> > &cost, vector<int32_t> &rowsol,
-      vector<int32_t> &colsol, bool extend_cost = false,
-      float cost_limit = LONG_MAX, bool return_cost = true);
+  double lapjv(vector<int32_t> &rowsol, vector<int32_t> &colsol,
+      bool extend_cost = false, float cost_limit = LONG_MAX,
+      bool return_cost = true);
 
   void print_statistics();
 
@@ -125,10 +181,62 @@ class BYTETracker {
   int                             frame_id;
   int                             max_time_lost;
 
+  // Track IDs are counted per tracker, i.e. per stream.
+  int                             track_count;
+
   vector<STrack*>                 m_tracked_stracks;
   vector<STrack*>                 m_lost_stracks;
   vector<STrack*>                 m_removed_stracks;
+  vector<STrack*>                 m_output_stracks;
   byte_kalman::KalmanFilter       kalman_filter;
 
   float                           track_wh_smooth_factor;
+
+  float                           reid_thresh;
+  int                             reid_gallery_size;
+
+  // Track arena, deque keeps the addresses stable while it grows. Removed
+  // tracks go to the free list and are recycled for new tracks.
+  deque<STrack>                   m_strack_arena;
+  vector<STrack*>                 m_free_stracks;
+
+  // Detections of the current frame, storage reused across frames.
+  vector<STrack>                  m_detections;
+
+  // Largest intersection over self of each detection with its neighbours and
+  // the detection indices sorted by left edge for the sweep.
+  vector<float>                   m_adjacency;
+  vector<uint32_t>                m_sweep_order;
+
+  ByteTrackerFrame                m_frame;
+  ByteTrackerBoxes                m_boxes_a;
+  ByteTrackerBoxes                m_boxes_b;
+  vector<int>                     m_joint_ids;
+
+  // Row major IoU distance matrix of the current association.
+  vector<float>                   m_cost_matrix;
+  uint32_t                        m_cost_rows;
+  uint32_t                        m_cost_cols;
+
+  // L2 normalized embeddings of the detections, one row per detection, and
+  // their dimension. The dimension is 0 when the frame has no embeddings.
+  vector<float>                   m_features;
+  int                             m_feature_dim;
+
+  // Appearance association buffers. The IoU matrix is kept aside once the
+  // cost matrix is fused with the appearance distances.
+  vector<float>                   m_queries;
+  vector<uint32_t>                m_query_cols;
+  vector<DETECTBOX>               m_query_boxes;
+  vector<float>                   m_gating;
+  vector<float>                   m_iou_matrix;
+  bool                            m_appearance_fused;
+
+  // Linear assignment buffers.
+  vector<int32_t>                 m_rowsol;
+  vector<int32_t>                 m_colsol;
+  vector<double>                  m_lap_cost;
+  vector<double*>                 m_lap_rows;
+  vector<int>                     m_lap_x;
+  vector<int>                     m_lap_y;
 };
@@ -29,21 +29,16 @@
 
 #include "STrack.h"
 
-STrack::STrack(vector<float> tlwh_, float score, int det_id) {
-    _tlwh.resize(4);
-    _tlwh.assign(tlwh_.begin(), tlwh_.end());
+STrack::STrack(const array<float, 4> &tlwh_, float score, int det_id) {
+    _tlwh = tlwh_;
 
     is_activated = false;
     track_id = 0;
     state = TrackState::New;
 
-    tlwh.resize(4);
-    tlbr.resize(4);
-
     static_tlwh();
     static_tlbr();
 
-    smoothed_wh.resize(2);
     smoothed_wh[0] = this->tlwh[2];
     smoothed_wh[1] = this->tlwh[3];
 
@@ -55,40 +50,31 @@ STrack::STrack(vector<float> tlwh_, float score, int det_id) {
     //init the matched detection
     this->matched_detection_id = det_id; //no original set yet
     this->iou_with_det = 1.0f;
-    this->current_detection_tlbr.resize(4);
-    this->current_detection_tlbr[0] = tlbr[0];
-    this->current_detection_tlbr[1] = tlbr[1];
-    this->current_detection_tlbr[2] = tlbr[2];
-    this->current_detection_tlbr[3] = tlbr[3];
-
-    this->prev_motion.resize(4);
-    std::fill(this->prev_motion.begin(), this->prev_motion.end(), 0.f);
+    this->current_detection_tlbr = tlbr;
+    this->prev_motion.fill(0.f);
 
     // init reid members
     adjacency_overlap = 0.f;
+    reid_feature = nullptr;
+    reid_dim = 0;
+    reid_count = 0;
+    reid_head = 0;
     reid_priority = 0;
     max_reid_capacity = 10;
     ambiguous_iou = false;
+
+    kalman_filter = nullptr;
 }
 
 STrack::~STrack() {}
 
-void STrack::activate(byte_kalman::KalmanFilter &kalman_filter, int frame_id) {
-    this->kalman_filter = kalman_filter;
-    this->track_id = this->next_id();
-
-    vector<float> _tlwh_tmp(4);
-    _tlwh_tmp[0] = this->_tlwh[0];
-    _tlwh_tmp[1] = this->_tlwh[1];
-    _tlwh_tmp[2] = this->_tlwh[2];
-    _tlwh_tmp[3] = this->_tlwh[3];
-    vector<float> xyah = tlwh_to_xyah(_tlwh_tmp);
-    DETECTBOX xyah_box;
-    xyah_box[0] = xyah[0];
-    xyah_box[1] = xyah[1];
-    xyah_box[2] = xyah[2];
-    xyah_box[3] = xyah[3];
-    auto mc = this->kalman_filter.initiate(xyah_box);
+void STrack::activate(byte_kalman::KalmanFilter &kalman_filter, int track_id,
+                      int frame_id) {
+    this->kalman_filter = &kalman_filter;
+    this->track_id = track_id;
+
+    DETECTBOX xyah_box = tlwh_to_xyah(this->_tlwh);
+    auto mc = this->kalman_filter->initiate(xyah_box);
     this->mean = mc.first;
     this->covariance = mc.second;
 
@@ -109,22 +95,13 @@ void STrack::activate(byte_kalman::KalmanFilter &kalman_filter, int frame_id) {
     //activation is only on new unmatched high-conf detection, so iou is to itself, i.e. 1.0
     this->iou_with_det = 1.0f;
 
-    this->prev_motion[0] = 0.f;
-    this->prev_motion[1] = 0.f;
-    this->prev_motion[2] = 0.f;
-    this->prev_motion[3] = 0.f;
+    this->prev_motion.fill(0.f);
 }
 
-void STrack::re_activate(STrack &new_track, int frame_id, bool new_id,
-                         float iou_score) {
+void STrack::re_activate(STrack &new_track, int frame_id, float iou_score) {
 
-    vector<float> xyah = tlwh_to_xyah(new_track.tlwh);
-    DETECTBOX xyah_box;
-    xyah_box[0] = xyah[0];
-    xyah_box[1] = xyah[1];
-    xyah_box[2] = xyah[2];
-    xyah_box[3] = xyah[3];
-    auto mc = this->kalman_filter.update(this->mean, this->covariance, xyah_box);
+    DETECTBOX xyah_box = tlwh_to_xyah(new_track.tlwh);
+    auto mc = this->kalman_filter->update(this->mean, this->covariance, xyah_box);
     this->mean = mc.first;
     this->covariance = mc.second;
 
@@ -140,21 +117,12 @@ void STrack::re_activate(STrack &new_track, int frame_id, bool new_id,
     this->is_activated = true;
     this->frame_id = frame_id;
     this->score = new_track.score;
-    if (new_id)
-        this->track_id = next_id();
 
     //record the matched detection
     this->matched_detection_id = new_track.matched_detection_id;
     this->iou_with_det = iou_score;
-    this->current_detection_tlbr[0] = new_track.tlbr[0];
-    this->current_detection_tlbr[1] = new_track.tlbr[1];
-    this->current_detection_tlbr[2] = new_track.tlbr[2];
-    this->current_detection_tlbr[3] = new_track.tlbr[3];
-
-    this->prev_motion[0] = 0.f;
-    this->prev_motion[1] = 0.f;
-    this->prev_motion[2] = 0.f;
-    this->prev_motion[3] = 0.f;
+    this->current_detection_tlbr = new_track.tlbr;
+    this->prev_motion.fill(0.f);
 }
 
 void STrack::update(STrack &new_track, int frame_id, float iou_score,
@@ -163,14 +131,9 @@ void STrack::update(STrack &new_track, int frame_id, float iou_score,
     this->frame_id = frame_id;
     this->tracklet_len++;
 
-    vector<float> xyah = tlwh_to_xyah(new_track.tlwh);
-    DETECTBOX xyah_box;
-    xyah_box[0] = xyah[0];
-    xyah_box[1] = xyah[1];
-    xyah_box[2] = xyah[2];
-    xyah_box[3] = xyah[3];
+    DETECTBOX xyah_box = tlwh_to_xyah(new_track.tlwh);
 
-    auto mc = this->kalman_filter.update(this->mean, this->covariance, xyah_box);
+    auto mc = this->kalman_filter->update(this->mean, this->covariance, xyah_box);
     this->mean = mc.first;
     this->covariance = mc.second;
 
@@ -204,10 +167,7 @@ void STrack::update(STrack &new_track, int frame_id, float iou_score,
         }
     }
     else {
-        this->current_detection_tlbr[0] = new_track.tlbr[0];
-        this->current_detection_tlbr[1] = new_track.tlbr[1];
-        this->current_detection_tlbr[2] = new_track.tlbr[2];
-        this->current_detection_tlbr[3] = new_track.tlbr[3];
+        this->current_detection_tlbr = new_track.tlbr;
     }
 }
 
@@ -231,28 +191,26 @@ void STrack::static_tlwh() {
 }
 
 void STrack::static_tlbr() {
-    tlbr.clear();
-    tlbr.assign(tlwh.begin(), tlwh.end());
+    tlbr = tlwh;
     tlbr[2] += tlbr[0];
     tlbr[3] += tlbr[1];
 }
 
-vector<float> STrack::tlwh_to_xyah(vector<float> tlwh_tmp) {
-    vector<float> tlwh_output = tlwh_tmp;
-    tlwh_output[0] += tlwh_output[2] / 2;
-    tlwh_output[1] += tlwh_output[3] / 2;
-    tlwh_output[2] /= tlwh_output[3];
-    return tlwh_output;
+DETECTBOX STrack::tlwh_to_xyah(const array<float, 4> &tlwh_tmp) {
+    DETECTBOX xyah;
+    xyah[0] = tlwh_tmp[0] + tlwh_tmp[2] / 2;
+    xyah[1] = tlwh_tmp[1] + tlwh_tmp[3] / 2;
+    xyah[2] = tlwh_tmp[2] / tlwh_tmp[3];
+    xyah[3] = tlwh_tmp[3];
+    return xyah;
 }
 
-vector<float> STrack::to_xyah() {
+DETECTBOX STrack::to_xyah() {
     return tlwh_to_xyah(tlwh);
 }
 
-vector<float> STrack::tlbr_to_tlwh(vector<float> &tlbr) {
-    tlbr[2] -= tlbr[0];
-    tlbr[3] -= tlbr[1];
-    return tlbr;
+array<float, 4> STrack::tlbr_to_tlwh(const float tlbr[4]) {
+    return { tlbr[0], tlbr[1], tlbr[2] - tlbr[0], tlbr[3] - tlbr[1] };
 }
 
 void STrack::mark_lost() {
@@ -267,18 +225,12 @@ void STrack::mark_removed() {
     this->iou_with_det = 0;
 }
 
-int STrack::next_id() {
-    static int _count = 0;
-    _count++;
-    return _count;
-}
-
 int STrack::end_frame() {
     return this->frame_id;
 }
 
 void STrack::multi_predict(vector<STrack*> &stracks, byte_kalman::KalmanFilter &kalman_filter) {
-    for (int i = 0; i < stracks.size(); i++) {
+    for (size_t i = 0; i < stracks.size(); i++) {
         /*if (stracks[i]->state != TrackState::Tracked)
         {
             stracks[i]->mean[7] = 0;
@@ -287,16 +239,22 @@ void STrack::multi_predict(vector<STrack*> &stracks, byte_kalman::KalmanFilter &
     }
 }
 
-void STrack::update_reid(vector<float> &feature, int bbox_size, int frame_id) {
-    if (this->reid_feature_list.size() == this->max_reid_capacity) {
-        this->reid_feature_list.pop_back();
-        this->reid_timestamp_list.pop_back();
-        this->bbox_size_list.pop_back();
+void STrack::update_reid(const float *feature, int dim, int capacity) {
+    // The gallery is a fixed ring, the oldest embedding is overwritten once
+    // it is full. The first reid_count rows are always the valid ones.
+    if (this->reid_dim != dim || this->max_reid_capacity != capacity) {
+        this->reid_dim = dim;
+        this->max_reid_capacity = capacity;
+        this->reid_count = 0;
+        this->reid_head = 0;
+        this->reid_gallery.resize(size_t(dim) * capacity);
     }
 
-    this->reid_feature_list.push_front(feature);
-    this->reid_timestamp_list.push_front(frame_id);
-    this->bbox_size_list.push_front(bbox_size);
+    copy(feature, feature + dim,
+        this->reid_gallery.begin() + size_t(this->reid_head) * dim);
+
+    this->reid_head = (this->reid_head + 1) % capacity;
+    this->reid_count = min(this->reid_count + 1, capacity);
 
     this->reid_priority = 0;
 }
@@ -29,7 +29,8 @@
 
 #pragma once
 
-#include <list>
+#include <algorithm>
+#include <array>
 #include <map>
 
 #include "kalmanFilter.h"
@@ -42,42 +43,41 @@ enum TrackState { New = 0, Tracked, Lost, Removed };
 
 class STrack {
  public:
-  STrack(vector<float> tlwh_, float score, int det_id = -1);
+  STrack(const array<float, 4> &tlwh_, float score, int det_id = -1);
   ~STrack();
 
-  vector<float> static tlbr_to_tlwh(vector<float> &tlbr);
+  array<float, 4> static tlbr_to_tlwh(const float tlbr[4]);
   void static multi_predict(vector<STrack*> &stracks,
       byte_kalman::KalmanFilter &kalman_filter);
   void static_tlwh();
   void static_tlbr();
-  vector<float> tlwh_to_xyah(vector<float> tlwh_tmp);
-  vector<float> to_xyah();
+  DETECTBOX tlwh_to_xyah(const array<float, 4> &tlwh_tmp);
+  DETECTBOX to_xyah();
   void mark_lost();
   void mark_removed();
-  int next_id();
   int end_frame();
 
-  void activate(byte_kalman::KalmanFilter &kalman_filter, int frame_id);
-  void re_activate(STrack &new_track, int frame_id, bool new_id = false,
-      float iou_score = 0);
+  void activate(byte_kalman::KalmanFilter &kalman_filter, int track_id,
+      int frame_id);
+  void re_activate(STrack &new_track, int frame_id, float iou_score = 0);
   void update(STrack &new_track, int frame_id, float iou_score = 0,
       float sz_smooth_factor = 0.9f);
 
-  void update_reid(vector<float> &feature, int bbox_size, int frame_id);
+  void update_reid(const float *feature, int dim, int capacity);
 
  public:
   bool                            is_activated; // flag for confirmed and unconfirmed tracks
   int                             track_id;
   int                             state;
 
-  vector<float>                   _tlwh; // detection box when initializd, will not change
-  vector<float>                   tlwh;
-  vector<float>                   tlbr;
+  array<float, 4>                 _tlwh; // detection box when initializd, will not change
+  array<float, 4>                 tlwh;
+  array<float, 4>                 tlbr;
   int                             frame_id;
   int                             tracklet_len;
   int                             start_frame;
 
-  vector<float>                   smoothed_wh; // size of two
+  array<float, 2>                 smoothed_wh;
 
   KAL_MEAN                        mean;
   KAL_COVA                        covariance;
@@ -86,18 +86,21 @@ class STrack {
   // ADDED members
   int                             matched_detection_id; // original index of the matched detection
   float                           iou_with_det;
-  vector<float>                   current_detection_tlbr;
-  vector<float>                   prev_motion; // for temporal smoothing
+  array<float, 4>                 current_detection_tlbr;
+  array<float, 4>                 prev_motion; // for temporal smoothing
 
   // ReID related members
   float                           adjacency_overlap; // maximum overlap ratio (IOU) with other detection boxes
-  list<vector<float>>             reid_feature_list;
-  list<int>                       reid_timestamp_list;
-  list<int>                       bbox_size_list;
+  const float                     *reid_feature; // normalized embedding of a detection, valid during one update, NULL for tracks
+  vector<float>                   reid_gallery; // ring of the last reid_count embeddings, reid_dim floats each
+  int                             reid_dim;
+  int                             reid_count;
+  int                             reid_head;
   int                             reid_priority;
   int                             max_reid_capacity;
   bool                            ambiguous_iou;
 
  private:
-  byte_kalman::KalmanFilter       kalman_filter;
+  // Filter of the owning tracker, set on activation.
+  byte_kalman::KalmanFilter       *kalman_filter;
 };
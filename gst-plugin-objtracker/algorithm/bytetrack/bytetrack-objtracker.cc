@@ -7,8 +7,6 @@
 
 #include "objtracker-data.h"
 
-BYTETracker *tracker;
-
 extern "C" {
   void *TrackerAlgoCreate (std::map<std::string, ParameterType> params);
   std::vector<TrackerAlgoOutputData> TrackerAlgoExecute (void *tracker,
@@ -57,11 +55,19 @@ void *TrackerAlgoCreate (std::map<std::string, ParameterType> params)
       return NULL;
     }
     config.high_thresh = std::get<float> (it->second);
-  }
 
-  tracker = new BYTETracker (config);
+    // Appearance association parameters are optional.
+    it = params.find ("reid-thresh");
+    if (it != params.end())
+      config.reid_thresh = std::get<float> (it->second);
+
+    it = params.find ("reid-gallery-size");
+    if (it != params.end())
+      config.reid_gallery_size = std::get<int> (it->second);
+  }
 
-  return tracker;
+  // Each instance keeps its own state, instances may run in parallel.
+  return new BYTETracker (config);
 }
 
 std::vector<TrackerAlgoOutputData> TrackerAlgoExecute (void *tracker,
@@ -72,6 +78,8 @@ std::vector<TrackerAlgoOutputData> TrackerAlgoExecute (void *tracker,
   TrackerAlgoOutputData result;
   std::vector<TrackerAlgoOutputData> results;
 
+  objects.reserve (data.size ());
+
   for (size_t i = 0; i < data.size (); i++) {
     object.bounding_box[0] = data[i].x;
     object.bounding_box[1] = data[i].y;
@@ -79,25 +87,30 @@ std::vector<TrackerAlgoOutputData> TrackerAlgoExecute (void *tracker,
     object.bounding_box[3] = data[i].y + data[i].h;
     object.prob = data[i].prob / 100.0;
     object.label = data[i].detection_id;
+    object.feature = data[i].embedding;
+    object.n_feature = data[i].n_embedding;
 
     objects.push_back (object);
   }
 
-  std::vector<STrack> stracks = ((BYTETracker *)tracker)->update (objects);
+  const std::vector<STrack*> &stracks =
+      ((BYTETracker *)tracker)->update (objects);
+
+  results.reserve (stracks.size ());
 
-  for (const auto& strack : stracks) {
-    if (strack.state == TrackState::Removed)
+  for (const STrack *strack : stracks) {
+    if (strack->state == TrackState::Removed)
       continue;
 
-    auto cx = (strack.tlbr[2] + strack.tlbr[0]) / 2;
-    auto cy = (strack.tlbr[3] + strack.tlbr[1]) / 2;
+    auto cx = (strack->tlbr[2] + strack->tlbr[0]) / 2;
+    auto cy = (strack->tlbr[3] + strack->tlbr[1]) / 2;
 
-    result.x = cx - strack.smoothed_wh[0] / 2;
-    result.y = cy - strack.smoothed_wh[1] / 2;
-    result.w = strack.smoothed_wh[0];
-    result.h = strack.smoothed_wh[1];
-    result.matched_detection_id = strack.matched_detection_id;
-    result.track_id = strack.track_id;
+    result.x = cx - strack->smoothed_wh[0] / 2;
+    result.y = cy - strack->smoothed_wh[1] / 2;
+    result.w = strack->smoothed_wh[0];
+    result.h = strack->smoothed_wh[1];
+    result.matched_detection_id = strack->matched_detection_id;
+    result.track_id = strack->track_id;
 
     results.push_back (result);
   }
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+// Replays detection streams through the ByteTrack module and reports the
+// per-frame update time. Detections are either read from a MOT challenge
+// style file (frame,id,x,y,w,h,score,...) or generated for a sweep over the
+// number of objects per frame. Generated detections optionally carry
+// appearance embeddings in order to measure the association by appearance.
+//
+//   bytetrack-replay -i det.txt
+//   bytetrack-replay -n 100,200,300,400,500 -f 600
+//   bytetrack-replay -n 100,300 -e 128
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "objtracker-data.h"
+
+extern "C" {
+  void *TrackerAlgoCreate (std::map<std::string, ParameterType> params);
+  std::vector<TrackerAlgoOutputData> TrackerAlgoExecute (void *tracker,
+      std::vector<TrackerAlgoInputData> data);
+  void TrackerAlgoDelete (void *tracker);
+}
+
+#define DEFAULT_N_FRAMES      300
+#define DEFAULT_N_WARMUP      10
+#define DEFAULT_SWEEP         "100,200,300,400,500"
+#define DEFAULT_SEED          1
+#define DEFAULT_N_EMBEDDING   0
+
+#define FRAME_WIDTH           1920.0f
+#define FRAME_HEIGHT          1080.0f
+
+// Fraction of the objects which are not detected in a frame.
+#define MISS_RATE             0.05f
+
+// Standard deviation of the per frame noise added to each component of the
+// object embeddings, relative to the components of the object itself.
+#define EMBEDDING_NOISE       0.3f
+
+using Frame = std::vector<TrackerAlgoInputData>;
+using Features = std::vector<float>;
+
+struct ReplayStats {
+  double mean;
+  double p50;
+  double p95;
+  double p99;
+  double max;
+  double tracks;
+};
+
+static void
+usage (const char * name)
+{
+  fprintf (stderr,
+      "Usage: %s [-i FILE | -n N[,N...]] [-e DIM] [-f FRAMES] [-w WARMUP]\n"
+      "          [-s SEED]\n"
+      "  -i FILE    Replay detections from a MOT style text file\n"
+      "             (frame,id,x,y,w,h,score,...), one detection per line\n"
+      "  -n LIST    Generate streams with these numbers of objects per frame\n"
+      "             (default " DEFAULT_SWEEP ")\n"
+      "  -e DIM     Size of the embeddings of generated detections, 0 to\n"
+      "             generate detections without embeddings (default %d)\n"
+      "  -f FRAMES  Number of generated frames per stream (default %d)\n"
+      "  -w WARMUP  Number of leading frames excluded from the statistics\n"
+      "             (default %d)\n"
+      "  -s SEED    Seed of the generated streams (default %d)\n",
+      name, DEFAULT_N_EMBEDDING, DEFAULT_N_FRAMES, DEFAULT_N_WARMUP,
+      DEFAULT_SEED);
+}
+
+static bool
+load_detections (const char * filename, std::vector<Frame> & frames)
+{
+  std::ifstream file (filename);
+  std::string line;
+
+  if (!file.is_open ()) {
+    fprintf (stderr, "Failed to open '%s'!\n", filename);
+    return false;
+  }
+
+  while (std::getline (file, line)) {
+    TrackerAlgoInputData detection = {};
+    float values[7] = {};
+    std::istringstream stream (line);
+    std::string field;
+    int n_values = 0;
+
+    while (n_values < 7 && std::getline (stream, field, ','))
+      values[n_values++] = std::strtof (field.c_str (), NULL);
+
+    // Skip empty lines and lines without a score.
+    if (n_values < 7 || values[0] < 1)
+      continue;
+
+    size_t index = (size_t) values[0] - 1;
+
+    if (frames.size () <= index)
+      frames.resize (index + 1);
+
+    detection.x = values[2];
+    detection.y = values[3];
+    detection.w = values[4];
+    detection.h = values[5];
+    // The module expects the confidence in percent.
+    detection.prob = (values[6] <= 1.0f) ? values[6] * 100.0f : values[6];
+    detection.detection_id = frames[index].size ();
+
+    frames[index].push_back (detection);
+  }
+
+  return !frames.empty ();
+}
+
+// Objects move with constant velocity and bounce off the frame edges. Box
+// positions are jittered and a few objects are missed in every frame. Each
+// object has a random appearance, its embedding in a frame is that plus noise.
+static void
+generate_detections (int n_objects, int n_frames, int n_embedding,
+    unsigned seed, std::vector<Frame> & frames,
+    std::vector<Features> & features)
+{
+  struct Object { float x, y, w, h, vx, vy, prob; Features appearance; };
+  std::vector<Object> objects (n_objects);
+  std::mt19937 rng (seed);
+  std::uniform_real_distribution<float> unit (0.0f, 1.0f);
+  std::normal_distribution<float> jitter (0.0f, 1.0f);
+
+  for (Object &object : objects) {
+    object.w = 16.0f + unit (rng) * 80.0f;
+    object.h = 32.0f + unit (rng) * 120.0f;
+    object.x = unit (rng) * (FRAME_WIDTH - object.w);
+    object.y = unit (rng) * (FRAME_HEIGHT - object.h);
+    object.vx = (unit (rng) - 0.5f) * 8.0f;
+    object.vy = (unit (rng) - 0.5f) * 4.0f;
+    object.prob = 30.0f + unit (rng) * 65.0f;
+    object.appearance.resize (n_embedding);
+
+    for (float &value : object.appearance)
+      value = jitter (rng);
+  }
+
+  frames.assign (n_frames, Frame ());
+
+  // Embeddings of a frame are sized for all objects up front, the detections
+  // point into them.
+  features.assign (n_frames, Features (size_t (n_objects) * n_embedding));
+
+  for (int idx = 0; idx < n_frames; idx++) {
+    Frame &frame = frames[idx];
+
+    frame.reserve (n_objects);
+
+    for (Object &object : objects) {
+      object.x += object.vx;
+      object.y += object.vy;
+
+      if (object.x < 0.0f || object.x + object.w > FRAME_WIDTH)
+        object.vx = -object.vx;
+      if (object.y < 0.0f || object.y + object.h > FRAME_HEIGHT)
+        object.vy = -object.vy;
+
+      if (unit (rng) < MISS_RATE)
+        continue;
+
+      TrackerAlgoInputData detection = {};
+
+      detection.x = object.x + jitter (rng);
+      detection.y = object.y + jitter (rng);
+      detection.w = object.w + jitter (rng);
+      detection.h = object.h + jitter (rng);
+      detection.prob = std::clamp (object.prob + jitter (rng) * 5.0f,
+          1.0f, 99.0f);
+      detection.detection_id = frame.size ();
+
+      if (n_embedding > 0) {
+        float *embedding = &features[idx][frame.size () * n_embedding];
+
+        for (int n = 0; n < n_embedding; n++)
+          embedding[n] = object.appearance[n] +
+              jitter (rng) * EMBEDDING_NOISE;
+
+        detection.embedding = embedding;
+        detection.n_embedding = n_embedding;
+      }
+
+      frame.push_back (detection);
+    }
+  }
+}
+
+static bool
+replay (const std::vector<Frame> & frames, size_t n_warmup,
+    ReplayStats & stats)
+{
+  std::vector<double> durations;
+  std::map<std::string, ParameterType> params;
+  size_t n_tracks = 0;
+  void *tracker = NULL;
+
+  if ((tracker = TrackerAlgoCreate (params)) == NULL) {
+    fprintf (stderr, "Failed to create tracker!\n");
+    return false;
+  }
+
+  durations.reserve (frames.size ());
+
+  for (size_t idx = 0; idx < frames.size (); idx++) {
+    auto start = std::chrono::steady_clock::now ();
+    std::vector<TrackerAlgoOutputData> results =
+        TrackerAlgoExecute (tracker, frames[idx]);
+    auto end = std::chrono::steady_clock::now ();
+
+    if (idx < n_warmup)
+      continue;
+
+    durations.push_back (
+        std::chrono::duration<double, std::micro> (end - start).count ());
+    n_tracks += results.size ();
+  }
+
+  TrackerAlgoDelete (tracker);
+
+  if (durations.empty ()) {
+    fprintf (stderr, "No frames left after %zu warmup frames!\n", n_warmup);
+    return false;
+  }
+
+  stats.tracks = (double) n_tracks / durations.size ();
+  stats.mean = 0.0;
+
+  for (double duration : durations)
+    stats.mean += duration;
+
+  stats.mean /= durations.size ();
+
+  std::sort (durations.begin (), durations.end ());
+
+  stats.p50 = durations[(durations.size () - 1) * 50 / 100];
+  stats.p95 = durations[(durations.size () - 1) * 95 / 100];
+  stats.p99 = durations[(durations.size () - 1) * 99 / 100];
+  stats.max = durations.back ();
+
+  return true;
+}
+
+static double
+mean_detections (const std::vector<Frame> & frames)
+{
+  size_t n_detections = 0;
+
+  for (const Frame &frame : frames)
+    n_detections += frame.size ();
+
+  return frames.empty () ? 0.0 : (double) n_detections / frames.size ();
+}
+
+static void
+print_stats (const char * name, const std::vector<Frame> & frames,
+    const ReplayStats & stats)
+{
+  printf ("%-20s %7zu %8.1f %8.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name,
+      frames.size (), mean_detections (frames), stats.tracks, stats.mean,
+      stats.p50, stats.p95, stats.p99, stats.max);
+}
+
+int
+main (int argc, char * argv[])
+{
+  std::vector<Frame> frames;
+  std::vector<Features> features;
+  std::string sweep = DEFAULT_SWEEP;
+  const char *filename = NULL;
+  int n_frames = DEFAULT_N_FRAMES, n_warmup = DEFAULT_N_WARMUP;
+  int n_embedding = DEFAULT_N_EMBEDDING;
+  unsigned seed = DEFAULT_SEED;
+  ReplayStats stats = {};
+  int option = 0;
+
+  while ((option = getopt (argc, argv, "i:n:e:f:w:s:h")) != -1) {
+    switch (option) {
+      case 'i':
+        filename = optarg;
+        break;
+      case 'n':
+        sweep = optarg;
+        break;
+      case 'e':
+        n_embedding = atoi (optarg);
+        break;
+      case 'f':
+        n_frames = atoi (optarg);
+        break;
+      case 'w':
+        n_warmup = atoi (optarg);
+        break;
+      case 's':
+        seed = strtoul (optarg, NULL, 10);
+        break;
+      default:
+        usage (argv[0]);
+        return (option == 'h') ? 0 : 1;
+    }
+  }
+
+  if (n_frames <= 0 || n_warmup < 0 || n_embedding < 0) {
+    usage (argv[0]);
+    return 1;
+  }
+
+  printf ("%-20s %7s %8s %8s %9s %9s %9s %9s %9s\n", "stream", "frames",
+      "dets", "tracks", "mean[us]", "p50[us]", "p95[us]", "p99[us]",
+      "max[us]");
+
+  if (filename != NULL) {
+    if (!load_detections (filename, frames) ||
+        !replay (frames, n_warmup, stats))
+      return 1;
+
+    print_stats (basename (filename), frames, stats);
+    return 0;
+  }
+
+  std::istringstream stream (sweep);
+  std::string field;
+
+  while (std::getline (stream, field, ',')) {
+    int n_objects = atoi (field.c_str ());
+    std::string name = "synthetic-" + std::to_string (n_objects);
+
+    if (n_embedding > 0)
+      name += "-e" + std::to_string (n_embedding);
+
+    if (n_objects <= 0) {
+      fprintf (stderr, "Invalid number of objects '%s'!\n", field.c_str ());
+      return 1;
+    }
+
+    generate_detections (n_objects, n_frames, n_embedding, seed, frames,
+        features);
+
+    if (!replay (frames, n_warmup, stats))
+      return 1;
+
+    print_stats (name.c_str (), frames, stats);
+  }
+
+  return 0;
+}
@@ -49,11 +49,11 @@ namespace byte_kalman
 		int ndim = 4;
 		double dt = 1.;
 
-		_motion_mat = Eigen::MatrixXf::Identity(8, 8);
+		_motion_mat.setIdentity();
 		for (int i = 0; i < ndim; i++) {
 			_motion_mat(i, ndim + i) = dt;
 		}
-		_update_mat = Eigen::MatrixXf::Identity(4, 8);
+		_update_mat.setIdentity();
 
 		this->_std_weight_position = 1. / 20;
 		this->_std_weight_velocity = 1. / 160;
@@ -172,10 +172,33 @@ namespace byte_kalman
 		for (DETECTBOX box : measurements) {
 			d.row(pos++) = box - mean1;
 		}
-		Eigen::Matrix<float, -1, -1, Eigen::RowMajor> factor = covariance1.llt().matrixL();
-		Eigen::Matrix<float, -1, -1> z = factor.triangularView<Eigen::Lower>().solve<Eigen::OnTheRight>(d).transpose();
-		auto zz = ((z.array())*(z.array())).matrix();
-		auto square_maha = zz.colwise().sum();
-		return square_maha;
+		// Squared Mahalanobis distance d * S^-1 * d^T with S = L * L^T,
+		// i.e. the squared norm of L^-1 * d^T.
+		Eigen::Matrix<float, 4, -1> z =
+			covariance1.llt().matrixL().solve(d.transpose());
+		return z.colwise().squaredNorm();
+	}
+
+	// Same as above but with fixed size temporaries and a caller owned
+	// output, it is evaluated for every track on every frame.
+	void
+		KalmanFilter::gating_distance(
+			const KAL_MEAN &mean,
+			const KAL_COVA &covariance,
+			const std::vector<DETECTBOX> &measurements,
+			std::vector<float> &distances)
+	{
+		KAL_HDATA pa = this->project(mean, covariance);
+		Eigen::LLT<KAL_HCOVA> llt(pa.second);
+
+		distances.resize(measurements.size());
+
+		for (size_t i = 0; i < measurements.size(); i++) {
+			Eigen::Matrix<float, 4, 1> d =
+				(measurements[i] - pa.first).transpose();
+
+			llt.matrixL().solveInPlace(d);
+			distances[i] = d.squaredNorm();
+		}
 	}
 }
@@ -50,6 +50,11 @@ namespace byte_kalman
 			const KAL_COVA& covariance,
 			const std::vector<DETECTBOX>& measurements,
 			bool only_position = false);
+		void gating_distance(
+			const KAL_MEAN& mean,
+			const KAL_COVA& covariance,
+			const std::vector<DETECTBOX>& measurements,
+			std::vector<float>& distances);
 
 	private:
 		Eigen::Matrix<float, 8, 8, Eigen::RowMajor> _motion_mat;
@@ -27,327 +27,214 @@
  * SPDX-License-Identifier: BSD-3-Clause-Clear
  */
 
+#include <algorithm>
+
 #include "BYTETracker.h"
 #include "lapjv.h"
 
 using namespace std;
 
-vector<STrack*> BYTETracker::joint_stracks(vector<STrack*> &tlista,
-                                           vector<STrack> &tlistb) {
-
-    map<uint32_t, uint32_t> exists;
-    vector<STrack*> res;
-    for (size_t i = 0; i < tlista.size(); i++) {
-        exists.insert(pair<uint32_t, uint32_t>(tlista[i]->track_id, 1));
-        res.push_back(tlista[i]);
-    }
-    for (size_t i = 0; i < tlistb.size(); i++) {
-        uint32_t tid = tlistb[i].track_id;
-        if (!exists[tid] || exists.count(tid) == 0) {
-            exists[tid] = 1;
-            res.push_back(&tlistb[i]);
-        }
-    }
-    return res;
-}
-
-vector<STrack> BYTETracker::joint_stracks(vector<STrack> &tlista,
-                                          vector<STrack> &tlistb) {
-    map<uint32_t, uint32_t> exists;
-    vector<STrack> res;
-    for (size_t i = 0; i < tlista.size(); i++) {
-        exists.insert(pair<uint32_t, uint32_t>(tlista[i].track_id, 1));
-        res.push_back(tlista[i]);
-    }
-    for (size_t i = 0; i < tlistb.size(); i++) {
-        uint32_t tid = tlistb[i].track_id;
-        if (!exists[tid] || exists.count(tid) == 0) {
-            exists[tid] = 1;
-            res.push_back(tlistb[i]);
-        }
-    }
-    return res;
-}
-
-vector<STrack*> BYTETracker::joint_stracks(vector<STrack*> &tlista,
-                                           vector<STrack*> &tlistb) {
-
-    map<uint32_t, uint32_t> exists;
-    vector<STrack*> res;
-    for (size_t i = 0; i < tlista.size(); i++) {
-        exists.insert(pair<uint32_t, uint32_t>(tlista[i]->track_id, 1));
-        res.push_back(tlista[i]);
-    }
-    for (size_t i = 0; i < tlistb.size(); i++) {
-        uint32_t tid = tlistb[i]->track_id;
-        if (!exists[tid] || exists.count(tid) == 0) {
-            exists[tid] = 1;
-            res.push_back(tlistb[i]);
-        }
-    }
-    return res;
-}
+void BYTETracker::joint_stracks(vector<STrack*> &res,
+                                const vector<STrack*> &tlista,
+                                const vector<STrack*> &tlistb) {
 
-vector<STrack> BYTETracker::sub_stracks(vector<STrack> &tlista,
-                                        vector<STrack> &tlistb) {
+    res.assign(tlista.begin(), tlista.end());
 
-    map<uint32_t, STrack> stracks;
+    this->m_joint_ids.clear();
     for (size_t i = 0; i < tlista.size(); i++)
-      stracks.insert(pair<uint32_t, STrack>(tlista[i].track_id, tlista[i]));
-
-    for (size_t i = 0; i < tlistb.size(); i++) {
-        uint32_t tid = tlistb[i].track_id;
-        if (stracks.count(tid) != 0)
-          stracks.erase(tid);
-    }
-
-    vector<STrack> res;
-    std::map<uint32_t, STrack>::iterator  it;
-    for (it = stracks.begin(); it != stracks.end(); ++it)
-      res.push_back(it->second);
-
-    return res;
-}
-
-vector<STrack*> BYTETracker::sub_stracks(vector<STrack*> &tlista,
-                                         vector<STrack*> &tlistb) {
+        this->m_joint_ids.push_back(tlista[i]->track_id);
 
-    map<uint32_t, STrack*> stracks;
-    for (size_t i = 0; i < tlista.size(); i++)
-        stracks.insert(pair<uint32_t, STrack*>(tlista[i]->track_id, tlista[i]));
+    sort(this->m_joint_ids.begin(), this->m_joint_ids.end());
 
     for (size_t i = 0; i < tlistb.size(); i++) {
-        uint32_t tid = tlistb[i]->track_id;
-        if (stracks.count(tid) != 0) {
-            stracks.erase(tid);
-        }
+        if (!binary_search(this->m_joint_ids.begin(), this->m_joint_ids.end(),
+                tlistb[i]->track_id))
+            res.push_back(tlistb[i]);
     }
-
-    vector<STrack*> res;
-    std::map<uint32_t, STrack*>::iterator  it;
-    for (it = stracks.begin(); it != stracks.end(); ++it)
-        res.push_back(it->second);
-
-    return res;
 }
 
+void ByteTrackerBoxes::assign(const vector<STrack*> &stracks) {
+    size_t n = stracks.size();
 
-//remove tracks that have large overlap (i.e. small iou distance),
-//keep the one with longer tracker history, return the remaining once
-void BYTETracker::remove_duplicate_stracks(std::vector<STrack> &resa,
-                                           std::vector<STrack> &resb,
-                                           std::vector<STrack> &stracksa,
-                                           std::vector<STrack> &stracksb) {
-
-    std::vector<std::vector<float> > pdist = iou_distance(stracksa, stracksb);  // dist = 1 - iou
-    std::vector<std::pair<uint32_t, uint32_t> > pairs;
-    for (size_t i = 0; i < pdist.size(); i++) {
-        for (size_t j = 0; j < pdist[i].size(); j++) {
-            if (pdist[i][j] < 0.15)
-              pairs.push_back(pair<uint32_t, uint32_t>(i, j));
-        }
-    }
-
-    std::vector<uint32_t> dupa, dupb;
-    for (size_t i = 0; i < pairs.size(); i++) {
-        uint32_t timep = stracksa[pairs[i].first].frame_id - stracksa[pairs[i].first].start_frame;
-        uint32_t timeq = stracksb[pairs[i].second].frame_id - stracksb[pairs[i].second].start_frame;
-        if (timep >= timeq)
-          dupb.push_back(pairs[i].second);
-        else
-          dupa.push_back(pairs[i].first);
-    }
+    x1.resize(n);
+    y1.resize(n);
+    x2.resize(n);
+    y2.resize(n);
+    area.resize(n);
 
-    for (size_t i = 0; i < stracksa.size(); i++) {
-        std::vector<uint32_t>::iterator iter = find(dupa.begin(), dupa.end(), i);
-        if (iter == dupa.end())
-          resa.push_back(stracksa[i]);
-    }
+    for (size_t i = 0; i < n; i++) {
+        const array<float, 4> &tlbr = stracks[i]->tlbr;
 
-    for (size_t i = 0; i < stracksb.size(); i++) {
-        std::vector<uint32_t>::iterator iter = find(dupb.begin(), dupb.end(), i);
-        if (iter == dupb.end())
-          resb.push_back(stracksb[i]);
+        x1[i] = tlbr[0];
+        y1[i] = tlbr[1];
+        x2[i] = tlbr[2];
+        y2[i] = tlbr[3];
+        area[i] = (tlbr[2] - tlbr[0] + 1) * (tlbr[3] - tlbr[1] + 1);
     }
 }
 
-void BYTETracker::linear_assignment(vector<vector<float> > &cost_matrix,
-                                    uint32_t cost_matrix_size,
-                                    uint32_t cost_matrix_size_size, float thresh,
-                                    vector<vector<uint32_t> > &matches,
+void BYTETracker::linear_assignment(float thresh,
+                                    vector<pair<uint32_t, uint32_t> > &matches,
                                     vector<uint32_t> &unmatched_a,
                                     vector<uint32_t> &unmatched_b) {
 
-    if (cost_matrix.size() == 0) {
-        for (size_t i = 0; i < cost_matrix_size; i++)
+    if (this->m_cost_rows * this->m_cost_cols == 0) {
+        for (size_t i = 0; i < this->m_cost_rows; i++)
           unmatched_a.push_back(i);
 
-        for (size_t i = 0; i < cost_matrix_size_size; i++)
+        for (size_t i = 0; i < this->m_cost_cols; i++)
           unmatched_b.push_back(i);
 
         return;
     }
 
-    vector<int32_t> rowsol; vector<int32_t> colsol;
-    float c = (float) lapjv(cost_matrix, rowsol, colsol, true, thresh);
-    for (size_t i = 0; i < rowsol.size(); i++) {
-        if (rowsol[i] >= 0)  {
-            vector<uint32_t> match;
-            match.push_back(i);
-            match.push_back(rowsol[i]);
-            matches.push_back(match);
-        } else {
+    lapjv(this->m_rowsol, this->m_colsol, true, thresh, false);
+    for (size_t i = 0; i < this->m_rowsol.size(); i++) {
+        if (this->m_rowsol[i] >= 0)
+            matches.emplace_back(i, this->m_rowsol[i]);
+        else
             unmatched_a.push_back(i);
-        }
     }
 
-    for (size_t i = 0; i < colsol.size(); i++) {
-        if (colsol[i] < 0)
+    for (size_t i = 0; i < this->m_colsol.size(); i++) {
+        if (this->m_colsol[i] < 0)
           unmatched_b.push_back(i);
     }
 }
 
-vector<vector<float> > BYTETracker::ious(vector<vector<float> > &atlbrs, vector<vector<float> > &btlbrs)
-{
-    vector<vector<float> > ious;
-    if (atlbrs.size()*btlbrs.size() == 0)
-      return ious;
-
-    ious.resize(atlbrs.size());
-    for (size_t i = 0; i < ious.size(); i++)
-      ious[i].resize(btlbrs.size());
-
-    //bbox_ious
-    for (size_t k = 0; k < btlbrs.size(); k++) {
-        vector<float> ious_tmp;
-        float box_area = (btlbrs[k][2] - btlbrs[k][0] + 1)*(btlbrs[k][3] - btlbrs[k][1] + 1);
-        for (size_t n = 0; n < atlbrs.size(); n++) {
-            float iw = min(atlbrs[n][2], btlbrs[k][2]) - max(atlbrs[n][0], btlbrs[k][0]) + 1;
-            if (iw > 0) {
-                float ih = min(atlbrs[n][3], btlbrs[k][3]) - max(atlbrs[n][1], btlbrs[k][1]) + 1;
-                if(ih > 0) {
-                    float ua = (atlbrs[n][2] - atlbrs[n][0] + 1)*(atlbrs[n][3] - atlbrs[n][1] + 1) + box_area - iw * ih;
-                    ious[n][k] = iw * ih / ua;
-                } else {
-                    ious[n][k] = 0.0;
-                }
-            } else {
-                ious[n][k] = 0.0;
-            }
+// Fill the cost matrix with the IoU distances between both sets of tracks.
+void BYTETracker::iou_distance(const vector<STrack*> &atracks,
+                               const vector<STrack*> &btracks) {
+
+    this->m_cost_rows = (uint32_t) atracks.size();
+    this->m_cost_cols = (uint32_t) btracks.size();
+    this->m_appearance_fused = false;
+
+    if (this->m_cost_rows * this->m_cost_cols == 0)
+        return;
+
+    this->m_cost_matrix.resize(this->m_cost_rows * this->m_cost_cols);
+
+    this->m_boxes_a.assign(atracks);
+    this->m_boxes_b.assign(btracks);
+
+    const float *bx1 = this->m_boxes_b.x1.data();
+    const float *by1 = this->m_boxes_b.y1.data();
+    const float *bx2 = this->m_boxes_b.x2.data();
+    const float *by2 = this->m_boxes_b.y2.data();
+    const float *barea = this->m_boxes_b.area.data();
+
+    //bbox_ious, branch free so that the inner loop vectorizes
+    for (uint32_t n = 0; n < this->m_cost_rows; n++) {
+        float ax1 = this->m_boxes_a.x1[n], ay1 = this->m_boxes_a.y1[n];
+        float ax2 = this->m_boxes_a.x2[n], ay2 = this->m_boxes_a.y2[n];
+        float aarea = this->m_boxes_a.area[n];
+        float *row = &this->m_cost_matrix[n * this->m_cost_cols];
+
+        for (uint32_t k = 0; k < this->m_cost_cols; k++) {
+            float iw = max(min(ax2, bx2[k]) - max(ax1, bx1[k]) + 1, 0.0f);
+            float ih = max(min(ay2, by2[k]) - max(ay1, by1[k]) + 1, 0.0f);
+            float intersection = iw * ih;
+            float ua = aarea + barea[k] - intersection;
+
+            row[k] = 1 - intersection / ua;
         }
     }
-
-    return ious;
 }
 
-vector<vector<float> > BYTETracker::iou_distance(vector<STrack*> &atracks,
-                                                 vector<STrack> &btracks,
-                                                 uint32_t &dist_size,
-                                                 uint32_t &dist_size_size) {
+// Lower the IoU distances with the cosine distances between the embeddings of
+// the detections and the gallery of each track. A pair is matched by
+// appearance only if it is close enough and the detection lies inside the
+// Kalman gate of the track, otherwise the IoU distance is kept.
+void BYTETracker::fuse_appearance(const vector<STrack*> &atracks,
+                                  const vector<STrack*> &detections) {
 
-    vector<vector<float> > cost_matrix;
-    if (atracks.size() * btracks.size() == 0) {
-        dist_size = (uint32_t) atracks.size();
-        dist_size_size = (uint32_t) btracks.size();
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic,
+        Eigen::RowMajor> MATRIX;
 
-        return cost_matrix;
-    }
+    const float gating_threshold = byte_kalman::KalmanFilter::chi2inv95[4];
+    const int dim = this->m_feature_dim;
 
-    vector<vector<float> > atlbrs, btlbrs;
+    if (dim == 0 || this->m_cost_rows * this->m_cost_cols == 0)
+        return;
 
-    for (size_t i = 0; i < atracks.size(); i++)
-      atlbrs.push_back(atracks[i]->tlbr);
-    for (size_t i = 0; i < btracks.size(); i++)
-      btlbrs.push_back(btracks[i].tlbr);
+    this->m_queries.clear();
+    this->m_query_cols.clear();
+    this->m_query_boxes.clear();
 
-    dist_size = (uint32_t) atracks.size();
-    dist_size_size = (uint32_t) btracks.size();
+    for (uint32_t k = 0; k < this->m_cost_cols; k++) {
+        STrack *detection = detections[k];
 
-    vector<vector<float> > _ious = ious(atlbrs, btlbrs);
+        if (detection->reid_feature == nullptr)
+            continue;
 
-    for (size_t i = 0; i < _ious.size();i++) {
-        vector<float> _iou;
-        for (size_t j = 0; j < _ious[i].size(); j++)
-          _iou.push_back(1 - _ious[i][j]);
-        cost_matrix.push_back(_iou);
+        this->m_queries.insert(this->m_queries.end(), detection->reid_feature,
+            detection->reid_feature + dim);
+        this->m_query_cols.push_back(k);
+        this->m_query_boxes.push_back(detection->to_xyah());
     }
 
-    return cost_matrix;
-}
+    uint32_t n_queries = this->m_query_cols.size();
 
-vector<vector<float> > BYTETracker::iou_distance(vector<STrack*> &atracks,
-                                                 vector<STrack*> &btracks,
-                                                 uint32_t &dist_size,
-                                                 uint32_t &dist_size_size) {
+    if (n_queries == 0)
+        return;
 
-    vector<vector<float> > cost_matrix;
-    if (atracks.size() * btracks.size() == 0) {
-        dist_size = (uint32_t) atracks.size();
-        dist_size_size = (uint32_t) btracks.size();
+    Eigen::Map<const MATRIX> queries(this->m_queries.data(), n_queries, dim);
 
-        return cost_matrix;
-    }
+    for (uint32_t n = 0; n < this->m_cost_rows; n++) {
+        STrack *track = atracks[n];
 
-    vector<vector<float> > atlbrs, btlbrs;
-    for (size_t i = 0; i < atracks.size(); i++)
-      atlbrs.push_back(atracks[i]->tlbr);
+        if (track->reid_count == 0 || track->reid_dim != dim)
+            continue;
 
-    for (size_t i = 0; i < btracks.size(); i++)
-      btlbrs.push_back(btracks[i]->tlbr);
+        if (!this->m_appearance_fused) {
+            this->m_iou_matrix.assign(this->m_cost_matrix.begin(),
+                this->m_cost_matrix.end());
+            this->m_appearance_fused = true;
+        }
 
-    dist_size = (uint32_t) atracks.size();
-    dist_size_size = (uint32_t) btracks.size();
+        // Appearance is compared only for the detections inside the gate,
+        // which usually are just a few for each track.
+        this->kalman_filter.gating_distance(track->mean, track->covariance,
+            this->m_query_boxes, this->m_gating);
 
-    vector<vector<float> > _ious = ious(atlbrs, btlbrs);
+        Eigen::Map<const MATRIX> gallery(track->reid_gallery.data(),
+            track->reid_count, dim);
 
-    for (size_t i = 0; i < _ious.size();i++) {
-        vector<float> _iou;
-        for (size_t j = 0; j < _ious[i].size(); j++) {
-            _iou.push_back(1 - _ious[i][j]);
-        }
-        cost_matrix.push_back(_iou);
-    }
+        float *row = &this->m_cost_matrix[n * this->m_cost_cols];
 
-    return cost_matrix;
-}
+        for (uint32_t q = 0; q < n_queries; q++) {
+            if (this->m_gating[q] > gating_threshold)
+                continue;
 
-vector<vector<float> > BYTETracker::iou_distance(vector<STrack> &atracks,
-                                                 vector<STrack> &btracks) {
-
-    vector<vector<float> > atlbrs, btlbrs;
-    for (size_t i = 0; i < atracks.size(); i++)
-      atlbrs.push_back(atracks[i].tlbr);
-    for (size_t i = 0; i < btracks.size(); i++)
-      btlbrs.push_back(btracks[i].tlbr);
-
-    vector<vector<float> > _ious = ious(atlbrs, btlbrs);
-    vector<vector<float> > cost_matrix;
-    for (size_t i = 0; i < _ious.size(); i++) {
-        vector<float> _iou;
-        for (size_t j = 0; j < _ious[i].size(); j++) {
-            _iou.push_back(1 - _ious[i][j]);
+            // Embeddings are normalized, so the cosine similarity is a dot
+            // product which Eigen evaluates with SIMD. The nearest gallery
+            // entry is kept.
+            float similarity = -1.0f;
+
+            for (int g = 0; g < track->reid_count; g++)
+                similarity = max(similarity, gallery.row(g).dot(queries.row(q)));
+
+            float distance = 1.0f - similarity;
+
+            if (distance > this->reid_thresh)
+                continue;
+
+            row[this->m_query_cols[q]] =
+                min(row[this->m_query_cols[q]], distance);
         }
-        cost_matrix.push_back(_iou);
     }
-
-    return cost_matrix;
 }
 
-double BYTETracker::lapjv(const vector<vector<float> > &cost,
-                          vector<int32_t> &rowsol, vector<int32_t> &colsol,
+double BYTETracker::lapjv(vector<int32_t> &rowsol, vector<int32_t> &colsol,
                           bool extend_cost, float cost_limit, bool return_cost) {
 
-    vector<vector<float> > cost_c;
-    cost_c.assign(cost.begin(), cost.end());
-
-    vector<vector<float> > cost_c_extended;
-
-    uint32_t n_rows = (uint32_t) cost.size();
-    uint32_t n_cols = (uint32_t) cost[0].size();
+    uint32_t n_rows = this->m_cost_rows;
+    uint32_t n_cols = this->m_cost_cols;
     rowsol.resize(n_rows);
     colsol.resize(n_cols);
 
-    int n = 0;
+    uint32_t n = 0;
     if (n_rows == n_cols) {
         n = n_rows;
     }
@@ -359,61 +246,47 @@ double BYTETracker::lapjv(const vector<vector<float> > &cost,
         }
     }
 
-    if (extend_cost || cost_limit < LONG_MAX) {
+    if (extend_cost || cost_limit < LONG_MAX)
         n = n_rows + n_cols;
-        cost_c_extended.resize(n);
-        for (size_t i = 0; i < cost_c_extended.size(); i++)
-            cost_c_extended[i].resize(n);
+
+    // Square cost matrix handed to the solver, reused across calls.
+    this->m_lap_cost.resize(n * n);
+    this->m_lap_rows.resize(n);
+    this->m_lap_x.resize(n);
+    this->m_lap_y.resize(n);
+
+    double **cost_ptr = this->m_lap_rows.data();
+    for (size_t i = 0; i < n; i++)
+        cost_ptr[i] = &this->m_lap_cost[i * n];
+
+    if (n != n_rows) {
+        double fill = 0.0;
 
         if (cost_limit < LONG_MAX) {
-            for (size_t i = 0; i < cost_c_extended.size(); i++) {
-                for (size_t j = 0; j < cost_c_extended[i].size(); j++) {
-                    cost_c_extended[i][j] = cost_limit / 2.0f;
-                }
-            }
+            fill = cost_limit / 2.0f;
         } else {
             float cost_max = -1;
-            for (size_t i = 0; i < cost_c.size(); i++) {
-                for (size_t j = 0; j < cost_c[i].size(); j++) {
-                    if (cost_c[i][j] > cost_max)
-                        cost_max = cost_c[i][j];
-                }
-            }
-            for (size_t i = 0; i < cost_c_extended.size(); i++) {
-                for (size_t j = 0; j < cost_c_extended[i].size(); j++) {
-                    cost_c_extended[i][j] = cost_max + 1;
-                }
+            for (size_t i = 0; i < this->m_cost_matrix.size(); i++) {
+                if (this->m_cost_matrix[i] > cost_max)
+                    cost_max = this->m_cost_matrix[i];
             }
+            fill = cost_max + 1;
         }
 
-        for (size_t i = n_rows; i < cost_c_extended.size(); i++) {
-            for (size_t j = n_cols; j < cost_c_extended[i].size(); j++) {
-                cost_c_extended[i][j] = 0;
-            }
-        }
-        for (size_t i = 0; i < n_rows; i++) {
-            for (size_t j = 0; j < n_cols; j++) {
-                cost_c_extended[i][j] = cost_c[i][j];
-            }
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++)
+                cost_ptr[i][j] = (i >= n_rows && j >= n_cols) ? 0 : fill;
         }
-
-        cost_c.clear();
-        cost_c.assign(cost_c_extended.begin(), cost_c_extended.end());
     }
 
-    double **cost_ptr;
-    cost_ptr = new double *[sizeof(double *) * n];
-    for (size_t i = 0; i < n; i++)
-        cost_ptr[i] = new double[sizeof(double) * n];
-
-    for (size_t i = 0; i < n; i++) {
-        for (size_t j = 0; j < n; j++) {
-            cost_ptr[i][j] = cost_c[i][j];
+    for (size_t i = 0; i < n_rows; i++) {
+        for (size_t j = 0; j < n_cols; j++) {
+            cost_ptr[i][j] = cost(i, j);
         }
     }
 
-    int* x_c = new int[sizeof(int) * n];
-    int *y_c = new int[sizeof(int) * n];
+    int *x_c = this->m_lap_x.data();
+    int *y_c = this->m_lap_y.data();
 
     int ret = lapjv::lapjv_internal(n, cost_ptr, x_c, y_c);
     if (ret != 0) {
@@ -426,9 +299,9 @@ double BYTETracker::lapjv(const vector<vector<float> > &cost,
 
     if (n != n_rows) {
         for (size_t i = 0; i < n; i++) {
-            if (x_c[i] >= n_cols)
+            if (x_c[i] >= (int) n_cols)
                 x_c[i] = -1;
-            if (y_c[i] >= n_rows)
+            if (y_c[i] >= (int) n_rows)
                 y_c[i] = -1;
         }
 
@@ -444,20 +317,19 @@ double BYTETracker::lapjv(const vector<vector<float> > &cost,
                   opt += cost_ptr[i][rowsol[i]];
             }
         }
-    } else if (return_cost) {
-        for (size_t i = 0; i < rowsol.size(); i++) {
-            opt += cost_ptr[i][rowsol[i]];
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            rowsol[i] = x_c[i];
+            colsol[i] = y_c[i];
         }
-    }
 
-    for (size_t i = 0; i < n; i++) {
-        delete[]cost_ptr[i];
+        if (return_cost) {
+            for (size_t i = 0; i < rowsol.size(); i++) {
+                opt += cost_ptr[i][rowsol[i]];
+            }
+        }
     }
 
-    delete[]cost_ptr;
-    delete[]x_c;
-    delete[]y_c;
-
     return opt;
 }
 
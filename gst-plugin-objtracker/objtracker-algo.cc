@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <gst/ml/gstmlmeta.h>
+
 #include "objtracker-data.h"
 
 #define GST_CAT_DEFAULT gst_objtracker_algo_debug
@@ -60,13 +62,47 @@ typedef std::vector<TrackerAlgoOutputData> (*TrackerAlgoExecute)
  */
 typedef void (*TrackerAlgoDelete) (void *tracker);
 
+/**
+ * _GstObjTrackerChannel:
+ * @id: Stream ID of the channel.
+ * @subalgo: Pointer to private algorithm structure of the stream.
+ * @roiregions: Pointer to roi metadata hash table.
+ * @bboxregions: Pointer to bbox hash table.
+ * @data: Input data of the current frame.
+ * @results: Output data of the current frame.
+ * @structure: Text entry of the current frame, only for text input.
+ * @active: Whether the stream is part of the current frame.
+ *
+ * State of the object tracker for a single stream.
+ */
+struct _GstObjTrackerChannel {
+  gint                                id;
+  gpointer                            subalgo;
+  GHashTable                          *roiregions;
+  GHashTable                          *bboxregions;
+
+  std::vector<TrackerAlgoInputData>   data;
+  std::vector<TrackerAlgoOutputData>  results;
+  GstStructure                        *structure;
+  gboolean                            active;
+};
+
+typedef struct _GstObjTrackerChannel GstObjTrackerChannel;
+
 /**
  * _GstObjTrackerAlgo:
  * @handle: Library handle.
  * @name: Library (Algorithm) name.
- * @subalgo: Pointer to private algorithm structure.
- * @roiregions: Pointer to roi metadata hash table.
- * @bboxregions: Pointer to bbox hash table.
+ * @params: Parameters used to create the algorithm of each stream.
+ * @batched: Whether the input contains results of multiple streams.
+ * @channels: Hash table with the tracker state of each stream.
+ * @active: Channels which are part of the current frame.
+ * @workers: Thread pool updating channels in parallel in batched mode.
+ * @lock: Lock protecting the number of pending channels.
+ * @wakeup: Signalled when all pending channels have been processed.
+ * @n_pending: Number of channels pushed to the workers and not yet processed.
+ * @tensor: Name of the tensor with the ROI embeddings, 0 if not used.
+ * @embeddings: Dequantized ROI embeddings of the current frame.
  *
  * @algocreate: Function pointer to the subalgo 'TrackerAlgoCreate' API.
  * @algoexecute: Function pointer to the subalgo 'TrackerAlgoExecute' API.
@@ -77,9 +113,19 @@ typedef void (*TrackerAlgoDelete) (void *tracker);
 struct _GstObjTrackerAlgo {
   gpointer                  handle;
   gchar                     *name;
-  gpointer                  subalgo;
-  GHashTable                *roiregions;
-  GHashTable                *bboxregions;
+
+  ParameterTypeMap          *params;
+  gboolean                  batched;
+  GHashTable                *channels;
+  GPtrArray                 *active;
+
+  GThreadPool               *workers;
+  GMutex                    lock;
+  GCond                     wakeup;
+  guint                     n_pending;
+
+  GQuark                    tensor;
+  GArray                    *embeddings;
 
   /// Interface functions.
   TrackerAlgoCreate         algocreate;
@@ -163,6 +209,154 @@ gst_objtracker_algo_symbol (gpointer handle, const gchar * name,
   return TRUE;
 }
 
+// Batched track IDs carry the stream ID in their upper byte, as the ROI meta
+// IDs do, so that tracks of different streams never share an ID.
+static inline guint
+gst_objtracker_algo_track_id (GstObjTrackerAlgo * algo,
+    GstObjTrackerChannel * channel, gint track_id)
+{
+  if (!algo->batched)
+    return track_id;
+
+  return (((guint) channel->id << GST_MUX_STREAM_ID_OFFSET) &
+      GST_MUX_STREAM_ID_MASK) | ((guint) track_id & ~GST_MUX_STREAM_ID_MASK);
+}
+
+static void
+gst_objtracker_algo_free_channel (GstObjTrackerAlgo * algo,
+    GstObjTrackerChannel * channel)
+{
+  if (channel->subalgo != NULL)
+    algo->algodelete (channel->subalgo);
+
+  if (channel->roiregions != NULL)
+    g_hash_table_destroy (channel->roiregions);
+
+  if (channel->bboxregions != NULL)
+    g_hash_table_destroy (channel->bboxregions);
+
+  delete channel;
+}
+
+static GstObjTrackerChannel *
+gst_objtracker_algo_get_channel (GstObjTrackerAlgo * algo, gint id)
+{
+  GstObjTrackerChannel *channel = NULL;
+
+  channel = (GstObjTrackerChannel *) g_hash_table_lookup (algo->channels,
+      GINT_TO_POINTER (id));
+
+  if (channel != NULL)
+    return channel;
+
+  channel = new GstObjTrackerChannel ();
+  channel->id = id;
+
+  channel->subalgo = algo->algocreate (*(algo->params));
+
+  channel->roiregions = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) gst_region_meta_entry_free);
+  channel->bboxregions = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) gst_structure_free);
+
+  if (channel->subalgo == NULL) {
+    GST_ERROR ("Failed to create %s algo for stream %d!", algo->name, id);
+    gst_objtracker_algo_free_channel (algo, channel);
+    return NULL;
+  }
+
+  g_hash_table_insert (algo->channels, GINT_TO_POINTER (id), channel);
+
+  GST_DEBUG ("Created %s algo for stream %d", algo->name, id);
+  return channel;
+}
+
+static void
+gst_objtracker_algo_activate_channel (GstObjTrackerAlgo * algo,
+    GstObjTrackerChannel * channel)
+{
+  if (channel->active)
+    return;
+
+  channel->active = TRUE;
+  channel->data.clear ();
+
+  g_ptr_array_add (algo->active, channel);
+}
+
+static void
+gst_objtracker_algo_worker (gpointer data, gpointer userdata)
+{
+  GstObjTrackerChannel *channel = (GstObjTrackerChannel *) data;
+  GstObjTrackerAlgo *algo = GST_OBJTRACKER_ALGO_CAST (userdata);
+
+  channel->results = algo->algoexecute (channel->subalgo, channel->data);
+
+  g_mutex_lock (&algo->lock);
+
+  if (--(algo->n_pending) == 0)
+    g_cond_signal (&algo->wakeup);
+
+  g_mutex_unlock (&algo->lock);
+}
+
+// Run the algorithm of all active channels. The first channel is processed
+// by the calling thread while the rest are distributed over the workers.
+static void
+gst_objtracker_algo_process (GstObjTrackerAlgo * algo)
+{
+  GstObjTrackerChannel *channel = NULL;
+  guint idx = 0;
+
+  if (algo->active->len == 0)
+    return;
+
+  if (algo->workers == NULL || algo->active->len == 1) {
+    for (idx = 0; idx < algo->active->len; idx++) {
+      channel = (GstObjTrackerChannel *) g_ptr_array_index (algo->active, idx);
+      channel->results = algo->algoexecute (channel->subalgo, channel->data);
+    }
+
+    return;
+  }
+
+  g_mutex_lock (&algo->lock);
+  algo->n_pending = algo->active->len - 1;
+  g_mutex_unlock (&algo->lock);
+
+  for (idx = 1; idx < algo->active->len; idx++) {
+    channel = (GstObjTrackerChannel *) g_ptr_array_index (algo->active, idx);
+    g_thread_pool_push (algo->workers, channel, NULL);
+  }
+
+  channel = (GstObjTrackerChannel *) g_ptr_array_index (algo->active, 0);
+  channel->results = algo->algoexecute (channel->subalgo, channel->data);
+
+  g_mutex_lock (&algo->lock);
+
+  while (algo->n_pending > 0)
+    g_cond_wait (&algo->wakeup, &algo->lock);
+
+  g_mutex_unlock (&algo->lock);
+}
+
+static void
+gst_objtracker_algo_deactivate_channels (GstObjTrackerAlgo * algo)
+{
+  for (guint idx = 0; idx < algo->active->len; idx++) {
+    GstObjTrackerChannel *channel =
+        (GstObjTrackerChannel *) g_ptr_array_index (algo->active, idx);
+
+    g_hash_table_remove_all (channel->roiregions);
+    g_hash_table_remove_all (channel->bboxregions);
+
+    channel->structure = NULL;
+    channel->active = FALSE;
+  }
+
+  g_ptr_array_set_size (algo->active, 0);
+}
+
 GstObjTrackerAlgo *
 gst_objtracker_algo_new (const gchar * name)
 {
@@ -174,6 +368,9 @@ gst_objtracker_algo_new (const gchar * name)
   gst_objtracker_algo_init_debug_category ();
 
   algo = g_new0 (GstObjTrackerAlgo, 1);
+
+  g_mutex_init (&algo->lock);
+  g_cond_init (&algo->wakeup);
   location = g_strdup_printf ("%s/libobjtracker-%s.so",
       GST_QTI_OBJTRACKER_ALGORITHM, name);
 
@@ -210,17 +407,36 @@ gst_objtracker_algo_new (const gchar * name)
 void
 gst_objtracker_algo_free (GstObjTrackerAlgo * algo)
 {
+  GHashTableIter iter;
+  gpointer channel = NULL;
+
   if (NULL == algo)
     return;
 
-  if (algo->subalgo != NULL)
-    algo->algodelete (algo->subalgo);
+  // Wait for the workers before destroying the channels they operate on.
+  if (algo->workers != NULL)
+    g_thread_pool_free (algo->workers, FALSE, TRUE);
 
-  if (algo->roiregions != NULL)
-    g_hash_table_destroy (algo->roiregions);
+  if (algo->channels != NULL) {
+    g_hash_table_iter_init (&iter, algo->channels);
 
-  if (algo->bboxregions != NULL)
-    g_hash_table_destroy (algo->bboxregions);
+    while (g_hash_table_iter_next (&iter, NULL, &channel))
+      gst_objtracker_algo_free_channel (algo,
+          (GstObjTrackerChannel *) channel);
+
+    g_hash_table_destroy (algo->channels);
+  }
+
+  if (algo->active != NULL)
+    g_ptr_array_free (algo->active, TRUE);
+
+  if (algo->embeddings != NULL)
+    g_array_free (algo->embeddings, TRUE);
+
+  delete algo->params;
+
+  g_mutex_clear (&algo->lock);
+  g_cond_clear (&algo->wakeup);
 
   if (algo->handle != NULL)
     dlclose (algo->handle);
@@ -240,11 +456,9 @@ gst_objtracker_algo_init (GstObjTrackerAlgo * algo)
 {
   g_return_val_if_fail (algo != NULL, FALSE);
 
-  algo->roiregions = g_hash_table_new_full (NULL, NULL, NULL,
-      (GDestroyNotify) gst_region_meta_entry_free);
-
-  algo->bboxregions = g_hash_table_new_full (NULL, NULL, NULL,
-      (GDestroyNotify) gst_structure_free);
+  algo->channels = g_hash_table_new (NULL, NULL);
+  algo->active = g_ptr_array_new ();
+  algo->embeddings = g_array_new (FALSE, FALSE, sizeof (gfloat));
 
   return TRUE;
 }
@@ -255,23 +469,43 @@ gst_objtracker_algo_set_opts (GstObjTrackerAlgo * algo,
 {
   GstStructure *parameters = NULL;
   std::map<std::string, ParameterType> params;
+  const gchar *name = NULL;
+  guint n_workers = 1;
   const GValue *frame_rate = NULL, *track_buffer = NULL,
-      *wh_smooth_factor = NULL, *track_thresh = NULL, *high_thresh = NULL;
+      *wh_smooth_factor = NULL, *track_thresh = NULL, *high_thresh = NULL,
+      *reid_thresh = NULL, *reid_gallery_size = NULL;
   gdouble value;
-  gboolean success = TRUE;
 
   g_return_val_if_fail (algo != NULL, FALSE);
 
-  if (options == NULL) {
-    algo->subalgo = algo->algocreate (params);
-    return (algo->subalgo != NULL);
+  if (options != NULL) {
+    gst_structure_get_boolean (options, GST_OBJTRACKER_ALGO_OPT_BATCHED,
+        &(algo)->batched);
+    gst_structure_get_uint (options, GST_OBJTRACKER_ALGO_OPT_WORKERS,
+        &n_workers);
+
+    if ((name = gst_structure_get_string (options,
+            GST_OBJTRACKER_ALGO_OPT_EMBEDDINGS)) != NULL)
+      algo->tensor = g_quark_from_string (name);
   }
 
-  success = gst_structure_has_field (options,
-      GST_OBJTRACKER_ALGO_OPT_PARAMETERS);
-  if (!success) {
-    GST_ERROR ("Missing parameters field!");
-    return FALSE;
+  if (algo->batched && n_workers > 1) {
+    GError *error = NULL;
+
+    algo->workers = g_thread_pool_new (gst_objtracker_algo_worker, algo,
+        n_workers - 1, TRUE, &error);
+
+    if (algo->workers == NULL) {
+      GST_ERROR ("Failed to create worker threads: %s!", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+  }
+
+  if ((options == NULL) ||
+      !gst_structure_has_field (options, GST_OBJTRACKER_ALGO_OPT_PARAMETERS)) {
+    algo->params = new ParameterTypeMap (params);
+    return (gst_objtracker_algo_get_channel (algo, 0) != NULL);
   }
 
   parameters = GST_STRUCTURE (g_value_get_boxed (
@@ -352,54 +586,56 @@ gst_objtracker_algo_set_opts (GstObjTrackerAlgo * algo,
   value = g_value_get_double (gst_value_array_get_value (high_thresh, 0));
   params.emplace ("high-thresh", (float)value);
 
-  algo->subalgo = algo->algocreate (params);
+  // Optional parameters for association by appearance embeddings.
+  reid_thresh = gst_structure_get_value (parameters, "reid-thresh");
+  reid_gallery_size = gst_structure_get_value (parameters, "reid-gallery-size");
 
-  return (algo->subalgo != NULL);
+  if (reid_thresh != NULL && gst_value_array_get_size (reid_thresh) != 1) {
+    GST_ERROR ("Expecting %u reid-thresh entries but received %u!", 1,
+        gst_value_array_get_size (reid_thresh));
+    return FALSE;
+  } else if (reid_thresh != NULL) {
+    value = g_value_get_double (gst_value_array_get_value (reid_thresh, 0));
+    params.emplace ("reid-thresh", (float)value);
+  }
+
+  if (reid_gallery_size != NULL &&
+      gst_value_array_get_size (reid_gallery_size) != 1) {
+    GST_ERROR ("Expecting %u reid-gallery-size entries but received %u!", 1,
+        gst_value_array_get_size (reid_gallery_size));
+    return FALSE;
+  } else if (reid_gallery_size != NULL) {
+    params.emplace ("reid-gallery-size",
+        g_value_get_int (gst_value_array_get_value (reid_gallery_size, 0)));
+  }
+
+  algo->params = new ParameterTypeMap (params);
+
+  // Create the first stream right away in order to validate the parameters.
+  return (gst_objtracker_algo_get_channel (algo, 0) != NULL);
 }
 
-gboolean
-gst_objtracker_algo_execute_text (GstObjTrackerAlgo * algo,
-    gchar * input_text, gchar ** output_text)
+static void
+gst_objtracker_algo_parse_text (GstObjTrackerAlgo * algo,
+    GstObjTrackerChannel * channel, GstStructure * structure)
 {
   TrackerAlgoInputData item;
   gpointer key = NULL;
-  std::vector<TrackerAlgoInputData> data;
-  std::vector<TrackerAlgoOutputData> results;
-  GValue list = G_VALUE_INIT;
-  gboolean success = FALSE;
   const GValue *bboxes = NULL, *val = NULL;
-  GValue array = G_VALUE_INIT, value = G_VALUE_INIT;
-  GValue trackerbboxes = G_VALUE_INIT;
-  GstStructure *structure = NULL, *entry = NULL;
-  GstStructure *region = NULL, *trackerregion = NULL;
+  GstStructure *entry = NULL, *region = NULL;
   gdouble confidence = 0.0;
   guint size = 0, idx = 0, id = 0;
 
-  g_value_init (&list, GST_TYPE_LIST);
-  g_value_init (&array, GST_TYPE_ARRAY);
-  g_value_init (&trackerbboxes, GST_TYPE_ARRAY);
-
-  success = gst_value_deserialize (&list, input_text);
-  if (!success) {
-    GST_ERROR ("Failed to deserialize input data!");
-    goto cleanup;
-  }
-
-  if (gst_value_list_get_size (&list) == 0) {
-    GST_ERROR ("Input contains no data!");
-    return FALSE;
-  }
-
-  // TODO: Add support for more than one element in the list
-  val = gst_value_list_get_value (&list, 0);
-  structure = GST_STRUCTURE (g_value_get_boxed (val));
-
   bboxes = gst_structure_get_value (structure, "bounding-boxes");
   if ((size = gst_value_array_get_size (bboxes)) == 0) {
-    GST_INFO ("There are no bounding-boxes!");
-    goto cleanup;
+    GST_INFO ("There are no bounding-boxes for stream %d!", channel->id);
+    return;
   }
 
+  gst_objtracker_algo_activate_channel (algo, channel);
+  channel->structure = structure;
+  channel->data.reserve (size);
+
   for (idx = 0; idx < size; idx++) {
     val = gst_value_array_get_value (bboxes, idx);
     entry = GST_STRUCTURE (g_value_get_boxed (val));
@@ -415,21 +651,36 @@ gst_objtracker_algo_execute_text (GstObjTrackerAlgo * algo,
     gst_structure_get_double (entry, "confidence", &confidence);
     item.prob = confidence;
 
+    item.embedding = NULL;
+    item.n_embedding = 0;
+
     key = GUINT_TO_POINTER (id);
     region = gst_structure_copy (entry);
-    g_hash_table_insert (algo->bboxregions, key, region);
+    g_hash_table_insert (channel->bboxregions, key, region);
 
-    data.push_back(item);
+    channel->data.push_back(item);
   }
 
   //remove bounding-boxes
   gst_structure_remove_field (structure, "bounding-boxes");
+}
+
+static void
+gst_objtracker_algo_update_text (GstObjTrackerAlgo * algo,
+    GstObjTrackerChannel * channel)
+{
+  gpointer key = NULL;
+  GValue array = G_VALUE_INIT, value = G_VALUE_INIT;
+  GValue trackerbboxes = G_VALUE_INIT;
+  GstStructure *region = NULL, *trackerregion = NULL;
+  std::vector<TrackerAlgoOutputData> &results = channel->results;
 
-  results = algo->algoexecute (algo->subalgo, data);
+  g_value_init (&array, GST_TYPE_ARRAY);
+  g_value_init (&trackerbboxes, GST_TYPE_ARRAY);
 
   for (size_t i = 0; i < results.size(); i++) {
     key = GUINT_TO_POINTER (results[i].matched_detection_id);
-    region = (GstStructure *) g_hash_table_lookup (algo->bboxregions,
+    region = (GstStructure *) g_hash_table_lookup (channel->bboxregions,
         key);
 
     if (region == NULL)
@@ -451,7 +702,8 @@ gst_objtracker_algo_execute_text (GstObjTrackerAlgo * algo,
     g_value_reset (&array);
 
     gst_structure_set (trackerregion, "tracking-id", G_TYPE_UINT,
-        results[i].track_id, NULL);
+        gst_objtracker_algo_track_id (algo, channel, results[i].track_id),
+        NULL);
 
     g_value_unset (&value);
     g_value_init (&value, GST_TYPE_STRUCTURE);
@@ -459,19 +711,80 @@ gst_objtracker_algo_execute_text (GstObjTrackerAlgo * algo,
     gst_value_array_append_value (&trackerbboxes, &value);
     g_value_unset (&value);
 
-    g_hash_table_remove (algo->bboxregions, key);
+    g_hash_table_remove (channel->bboxregions, key);
+  }
+
+  gst_structure_set_value (channel->structure, "bounding-boxes",
+      &trackerbboxes);
+
+  g_value_unset (&array);
+  g_value_unset (&trackerbboxes);
+}
+
+gboolean
+gst_objtracker_algo_execute_text (GstObjTrackerAlgo * algo,
+    gchar * input_text, gchar ** output_text)
+{
+  GstObjTrackerChannel *channel = NULL;
+  GValue list = G_VALUE_INIT;
+  gboolean success = FALSE;
+  const GValue *val = NULL;
+  GstStructure *structure = NULL;
+  guint idx = 0, n_entries = 0;
+  gint id = 0;
+
+  g_value_init (&list, GST_TYPE_LIST);
+
+  success = gst_value_deserialize (&list, input_text);
+  if (!success) {
+    GST_ERROR ("Failed to deserialize input data!");
+    goto cleanup;
+  }
+
+  if ((n_entries = gst_value_list_get_size (&list)) == 0) {
+    GST_ERROR ("Input contains no data!");
+    g_value_unset (&list);
+    return FALSE;
+  }
+
+  // Without batching only the first entry is tracked.
+  if (!algo->batched)
+    n_entries = 1;
+
+  for (idx = 0; idx < n_entries; idx++) {
+    val = gst_value_list_get_value (&list, idx);
+    structure = GST_STRUCTURE (g_value_get_boxed (val));
+
+    // Entries of a batch carry the ID of the stream they originate from.
+    if (!algo->batched)
+      id = 0;
+    else if (!gst_structure_get_int (structure, "stream-id", &id))
+      id = idx;
+
+    if ((channel = gst_objtracker_algo_get_channel (algo, id)) == NULL)
+      continue;
+
+    if (channel->active) {
+      GST_WARNING ("Multiple entries for stream %d, skipping!", id);
+      continue;
+    }
+
+    gst_objtracker_algo_parse_text (algo, channel, structure);
   }
 
-  gst_structure_set_value (structure, "bounding-boxes", &trackerbboxes);
+  gst_objtracker_algo_process (algo);
+
+  for (idx = 0; idx < algo->active->len; idx++) {
+    channel = (GstObjTrackerChannel *) g_ptr_array_index (algo->active, idx);
+    gst_objtracker_algo_update_text (algo, channel);
+  }
 
 cleanup:
   *output_text = gst_value_serialize (&list);
 
   g_value_unset (&list);
-  g_value_unset (&array);
-  g_value_unset (&trackerbboxes);
 
-  g_hash_table_remove_all (algo->bboxregions);
+  gst_objtracker_algo_deactivate_channels (algo);
 
   return (*output_text != NULL) ? TRUE : FALSE;
 }
@@ -486,18 +799,146 @@ gst_objtracker_remove_roimeta (GstBuffer * buffer, GstMeta ** meta,
   return TRUE;
 }
 
+// Map the ROI embeddings which a re-identification model attached to the
+// buffer. The tensor meta ID is the index of the buffer memory holding them,
+// the last tensor dimension is the embedding size and each row belongs to
+// the ROI meta at the same position in the buffer.
+static const gfloat *
+gst_objtracker_algo_map_embeddings (GstObjTrackerAlgo * algo,
+    GstBuffer * buffer, GstMapInfo * map, guint * n_rows, guint * n_cols)
+{
+  GstMLTensorMeta *mlmeta = NULL;
+  GstMemory *memory = NULL;
+  GstMeta *meta = NULL;
+  gpointer state = NULL;
+  gfloat *embeddings = NULL;
+  gsize idx = 0, n_values = 0;
+  guint n_rois = 0;
+
+  // Embeddings are used only when explicitly requested.
+  if (algo->tensor == 0)
+    return NULL;
+
+  while ((meta = gst_buffer_iterate_meta_filtered (buffer, &state,
+              GST_ML_TENSOR_META_API_TYPE)) != NULL) {
+    if (GST_ML_TENSOR_META_CAST (meta)->name == algo->tensor) {
+      mlmeta = GST_ML_TENSOR_META_CAST (meta);
+      break;
+    }
+  }
+
+  if (mlmeta == NULL)
+    return NULL;
+
+  if ((mlmeta->n_dimensions < 2) ||
+      (mlmeta->dimensions[mlmeta->n_dimensions - 1] == 0) ||
+      (mlmeta->id >= gst_buffer_n_memory (buffer))) {
+    GST_WARNING ("Invalid embeddings tensor, ignoring it!");
+    return NULL;
+  }
+
+  memory = gst_buffer_peek_memory (buffer, mlmeta->id);
+
+  if (gst_memory_get_sizes (memory, NULL, NULL) <
+          gst_ml_tensor_meta_size (mlmeta)) {
+    GST_WARNING ("Embeddings memory is smaller than the tensor, ignoring it!");
+    return NULL;
+  }
+
+  if (!gst_memory_map (memory, map, GST_MAP_READ)) {
+    GST_ERROR ("Failed to map embeddings memory!");
+    return NULL;
+  }
+
+  n_values = gst_ml_tensor_meta_size (mlmeta) /
+      gst_ml_type_get_size (mlmeta->type);
+
+  *n_cols = mlmeta->dimensions[mlmeta->n_dimensions - 1];
+  *n_rows = n_values / *n_cols;
+
+  n_rois = gst_buffer_get_n_meta (buffer,
+      GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE);
+
+  // Rows are matched to the ROIs by position, that works only one to one.
+  if (*n_rows != n_rois) {
+    GST_WARNING ("Embeddings tensor has %u rows for %u ROIs, ignoring it!",
+        *n_rows, n_rois);
+    gst_memory_unmap (memory, map);
+    return NULL;
+  }
+
+  switch (mlmeta->type) {
+    case GST_ML_TYPE_FLOAT32:
+      return (const gfloat *) map->data;
+    case GST_ML_TYPE_INT8:
+      g_array_set_size (algo->embeddings, n_values);
+      embeddings = (gfloat *) algo->embeddings->data;
+
+      for (idx = 0; idx < n_values; idx++)
+        embeddings[idx] = (((gint8 *) map->data)[idx] - mlmeta->qoffset) *
+            mlmeta->qscale;
+
+      return embeddings;
+    case GST_ML_TYPE_UINT8:
+      g_array_set_size (algo->embeddings, n_values);
+      embeddings = (gfloat *) algo->embeddings->data;
+
+      for (idx = 0; idx < n_values; idx++)
+        embeddings[idx] = (((guint8 *) map->data)[idx] - mlmeta->qoffset) *
+            mlmeta->qscale;
+
+      return embeddings;
+    default:
+      GST_WARNING ("Unsupported embeddings tensor type %d, ignoring it!",
+          mlmeta->type);
+      break;
+  }
+
+  gst_memory_unmap (memory, map);
+  return NULL;
+}
+
 gboolean
 gst_objtracker_algo_execute_buffer (GstObjTrackerAlgo * algo,
     GstBuffer * buffer)
 {
+  GstObjTrackerChannel *channel = NULL;
   GstVideoRegionOfInterestMeta *roimeta = NULL;
-  gpointer state = NULL, key = NULL;
+  GstMeta *meta = NULL;
+  gpointer state = NULL, mstate = NULL, key = NULL;
   TrackerAlgoInputData item;
-  std::vector<TrackerAlgoInputData> data;
-  std::vector<TrackerAlgoOutputData> results;
   GstStructure *param = NULL;
   GstRegionMetaEntry *region = NULL;
+  GstMapInfo map = {};
+  const gfloat *embeddings = NULL;
   gdouble confidence = 0.0;
+  guint idx = 0, n_rois = 0, n_rows = 0, n_cols = 0;
+  gint id = 0;
+
+  embeddings = gst_objtracker_algo_map_embeddings (algo, buffer, &map,
+      &n_rows, &n_cols);
+
+  if (algo->batched) {
+    // Streams present in the batch are updated even without detections
+    // in order to age their tracks.
+    while ((meta = gst_buffer_iterate_meta_filtered (buffer, &mstate,
+                GST_PROTECTION_META_API_TYPE)) != NULL) {
+      const gchar *name =
+          gst_structure_get_name (GST_PROTECTION_META_CAST (meta)->info);
+
+      // Only streams with a 'mux-stream' protection meta are in the batch.
+      if (sscanf (name, "mux-stream-%u", &idx) != 1)
+        continue;
+
+      if ((channel = gst_objtracker_algo_get_channel (algo, idx)) != NULL)
+        gst_objtracker_algo_activate_channel (algo, channel);
+    }
+  }
+
+  // Without batching the single stream is always updated.
+  if (!algo->batched &&
+      (channel = gst_objtracker_algo_get_channel (algo, 0)) != NULL)
+    gst_objtracker_algo_activate_channel (algo, channel);
 
   while ((roimeta = GST_BUFFER_ITERATE_ROI_METAS (buffer, state)) != NULL) {
     item.x = roimeta->x;
@@ -506,53 +947,76 @@ gst_objtracker_algo_execute_buffer (GstObjTrackerAlgo * algo,
     item.h = roimeta->h;
     item.detection_id = roimeta->id;
 
+    item.embedding = (n_rois < n_rows) ? (embeddings + n_rois * n_cols) : NULL;
+    item.n_embedding = (item.embedding != NULL) ? n_cols : 0;
+    n_rois++;
+
     param = gst_video_region_of_interest_meta_get_param (roimeta,
         "ObjectDetection");
 
     if (param == NULL)
       continue;
 
+    // Batched ROI IDs are prefixed with the ID of their stream.
+    id = algo->batched ? (((guint) roimeta->id & GST_MUX_STREAM_ID_MASK) >>
+        GST_MUX_STREAM_ID_OFFSET) : 0;
+
+    if ((channel = gst_objtracker_algo_get_channel (algo, id)) == NULL)
+      continue;
+
+    gst_objtracker_algo_activate_channel (algo, channel);
+
     gst_structure_get_double (param, "confidence", &confidence);
     item.prob = confidence;
 
     key = GUINT_TO_POINTER (roimeta->id);
     region = gst_region_meta_entry_new (roimeta);
-    g_hash_table_insert (algo->roiregions, key, region);
+    g_hash_table_insert (channel->roiregions, key, region);
 
-    data.push_back(item);
+    channel->data.push_back(item);
   }
 
   //remove origin ROI metas
   gst_buffer_foreach_meta (buffer, gst_objtracker_remove_roimeta, NULL);
 
-  results = algo->algoexecute (algo->subalgo, data);
-
-  for (size_t i = 0; i < results.size(); i++) {
-    key = GUINT_TO_POINTER (results[i].matched_detection_id);
-    region = (GstRegionMetaEntry *) g_hash_table_lookup (algo->roiregions, key);
-
-    if (region == NULL)
-      continue;
-
-    roimeta = gst_buffer_add_video_region_of_interest_meta_id (buffer,
-        region->roi_type, region->x, region->y, region->w, region->h);
-
-    roimeta->x = results[i].x;
-    roimeta->y = results[i].y;
-    roimeta->w = results[i].w;
-    roimeta->h = results[i].h;
-    roimeta->id = region->id;
-    roimeta->parent_id = region->parent_id;
-    roimeta->params = (GList *) g_steal_pointer (&(region->params));
-    g_hash_table_remove (algo->roiregions, key);
-
-    param = gst_video_region_of_interest_meta_get_param (roimeta,
-        "ObjectDetection");
-    gst_structure_set (param, "tracking-id", G_TYPE_UINT, results[i].track_id,
-        NULL);
+  gst_objtracker_algo_process (algo);
+
+  if (embeddings != NULL)
+    gst_memory_unmap (map.memory, &map);
+
+  for (idx = 0; idx < algo->active->len; idx++) {
+    channel = (GstObjTrackerChannel *) g_ptr_array_index (algo->active, idx);
+    std::vector<TrackerAlgoOutputData> &results = channel->results;
+
+    for (size_t i = 0; i < results.size(); i++) {
+      key = GUINT_TO_POINTER (results[i].matched_detection_id);
+      region = (GstRegionMetaEntry *) g_hash_table_lookup (
+          channel->roiregions, key);
+
+      if (region == NULL)
+        continue;
+
+      roimeta = gst_buffer_add_video_region_of_interest_meta_id (buffer,
+          region->roi_type, region->x, region->y, region->w, region->h);
+
+      roimeta->x = results[i].x;
+      roimeta->y = results[i].y;
+      roimeta->w = results[i].w;
+      roimeta->h = results[i].h;
+      roimeta->id = region->id;
+      roimeta->parent_id = region->parent_id;
+      roimeta->params = (GList *) g_steal_pointer (&(region->params));
+      g_hash_table_remove (channel->roiregions, key);
+
+      param = gst_video_region_of_interest_meta_get_param (roimeta,
+          "ObjectDetection");
+      gst_structure_set (param, "tracking-id", G_TYPE_UINT,
+          gst_objtracker_algo_track_id (algo, channel, results[i].track_id),
+          NULL);
+    }
   }
 
-  g_hash_table_remove_all (algo->roiregions);
+  gst_objtracker_algo_deactivate_channels (algo);
 
   return TRUE;
 }
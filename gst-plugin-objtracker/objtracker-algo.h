@@ -27,6 +27,45 @@ GST_DEBUG_CATEGORY_EXTERN (gst_objtracker_algo_debug);
  */
 #define GST_OBJTRACKER_ALGO_OPT_PARAMETERS "GstObjTrackerAlgo.parameters"
 
+/**
+ * GST_OBJTRACKER_ALGO_OPT_BATCHED
+ *
+ * #G_TYPE_BOOLEAN: Whether the input contains results of multiple streams.
+ *                  Each stream is tracked by a separate algorithm instance.
+ *                  For text input the stream is identified by the 'stream-id'
+ *                  field of each list entry or by its position in the list.
+ *                  For buffers it is taken from the stream ID embedded in the
+ *                  ROI meta ID. Track IDs carry the stream ID in their upper
+ *                  byte, the same way as the ROI meta IDs.
+ * Default: FALSE
+ *
+ * To be used as a possible option for 'gst_objtracker_algo_configure'.
+ */
+#define GST_OBJTRACKER_ALGO_OPT_BATCHED "GstObjTrackerAlgo.batched"
+
+/**
+ * GST_OBJTRACKER_ALGO_OPT_WORKERS
+ *
+ * #G_TYPE_UINT: Number of threads used to update streams in parallel in
+ *               batched mode. 1 updates the streams one after another.
+ * Default: 1
+ *
+ * To be used as a possible option for 'gst_objtracker_algo_configure'.
+ */
+#define GST_OBJTRACKER_ALGO_OPT_WORKERS "GstObjTrackerAlgo.workers"
+
+/**
+ * GST_OBJTRACKER_ALGO_OPT_EMBEDDINGS
+ *
+ * #G_TYPE_STRING: Name of the GstMLTensorMeta on the input buffer holding the
+ *                 re-identification embeddings, one row per ROI meta in ROI
+ *                 order. If NULL, embeddings are not used.
+ * Default: NULL
+ *
+ * To be used as a possible option for 'gst_objtracker_algo_configure'.
+ */
+#define GST_OBJTRACKER_ALGO_OPT_EMBEDDINGS "GstObjTrackerAlgo.embeddings"
+
 typedef struct _GstObjTrackerAlgo GstObjTrackerAlgo;
 
 
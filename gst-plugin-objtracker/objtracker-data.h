@@ -24,6 +24,11 @@ struct _TrackerAlgoInputData {
   float h;
   int   detection_id;
   float prob;
+
+  // Optional appearance embedding of the detection, valid only during the
+  // execute call. NULL if the detection has no embedding.
+  const float *embedding;
+  int         n_embedding;
 };
 
 struct _TrackerAlgoOutputData {
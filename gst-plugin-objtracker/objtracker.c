@@ -41,12 +41,19 @@ typedef enum {
 
 #define DEFAULT_PROP_ALGO_BACKEND           GST_OBJTRACK_BACKEND_BYTETRACK
 #define DEFAULT_PROP_PARAMETERS             NULL
+#define DEFAULT_PROP_BATCHED                FALSE
+#define DEFAULT_PROP_WORKERS                4
+#define DEFAULT_PROP_EMBEDDINGS             NULL
+#define MAX_PROP_WORKERS                    16
 
 enum
 {
   PROP_0,
   PROP_ALGO_BACKEND,
   PROP_PARAMETERS,
+  PROP_BATCHED,
+  PROP_WORKERS,
+  PROP_EMBEDDINGS,
 };
 
 static GstStaticPadTemplate gst_objtracker_sink_template =
@@ -131,19 +138,30 @@ gst_objtracker_set_caps (GstBaseTransform * base, GstCaps * incaps,
     return FALSE;
   }
 
+  structure = gst_structure_new ("options",
+      GST_OBJTRACKER_ALGO_OPT_BATCHED, G_TYPE_BOOLEAN, objtracker->batched,
+      GST_OBJTRACKER_ALGO_OPT_WORKERS, G_TYPE_UINT, objtracker->workers,
+      NULL);
+
+  if (objtracker->embeddings != NULL)
+    gst_structure_set (structure,
+        GST_OBJTRACKER_ALGO_OPT_EMBEDDINGS, G_TYPE_STRING,
+        objtracker->embeddings, NULL);
+
   if (objtracker->algoparameters != NULL)
-    structure = gst_structure_new ("options",
-      GST_OBJTRACKER_ALGO_OPT_PARAMETERS, GST_TYPE_STRUCTURE,
-          objtracker->algoparameters, NULL);
-  else
-    structure = NULL;
+    gst_structure_set (structure,
+        GST_OBJTRACKER_ALGO_OPT_PARAMETERS, GST_TYPE_STRUCTURE,
+        objtracker->algoparameters, NULL);
 
   if (!gst_objtracker_algo_set_opts (objtracker->algo, structure)) {
     GST_ELEMENT_ERROR (objtracker, RESOURCE, FAILED, (NULL),
         ("Failed to set algo options!"));
+    gst_structure_free (structure);
     return FALSE;
   }
 
+  gst_structure_free (structure);
+
   GST_DEBUG_OBJECT (objtracker, "Output caps: %" GST_PTR_FORMAT, outcaps);
 
   return TRUE;
@@ -269,6 +287,16 @@ gst_objtracker_set_property (GObject * object, guint prop_id,
       g_value_unset (&structure);
       break;
     }
+    case PROP_BATCHED:
+      objtracker->batched = g_value_get_boolean (value);
+      break;
+    case PROP_WORKERS:
+      objtracker->workers = g_value_get_uint (value);
+      break;
+    case PROP_EMBEDDINGS:
+      g_free (objtracker->embeddings);
+      objtracker->embeddings = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -296,6 +324,15 @@ gst_objtracker_get_property (GObject * object, guint prop_id,
       g_free (string);
       break;
     }
+    case PROP_BATCHED:
+      g_value_set_boolean (value, objtracker->batched);
+      break;
+    case PROP_WORKERS:
+      g_value_set_uint (value, objtracker->workers);
+      break;
+    case PROP_EMBEDDINGS:
+      g_value_set_string (value, objtracker->embeddings);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -313,6 +350,8 @@ gst_objtracker_finalize (GObject * object)
   if (objtracker->algoparameters != NULL)
     gst_structure_free (objtracker->algoparameters);
 
+  g_free (objtracker->embeddings);
+
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (objtracker));
 }
 
@@ -338,9 +377,35 @@ gst_objtracker_class_init (GstObjTrackerClass * klass)
       g_param_spec_string ("parameters", "Parameters",
           "Parameters, parameters used by chosen object tracker algorithm "
           "in GstStructure string format. "
-          "Applicable only for some algorithms.",
+          "Applicable only for some algorithms. ByteTrack also associates "
+          "by appearance ('reid-thresh', 'reid-gallery-size') when the "
+          "'embeddings' property is set.",
           DEFAULT_PROP_PARAMETERS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_BATCHED,
+      g_param_spec_boolean ("batched", "Batched",
+          "Input contains detections of multiple streams (e.g. from qtibatch). "
+          "Each stream is tracked independently, the upper byte of its track "
+          "IDs holds the stream ID so they are unique across the batch.",
+          DEFAULT_PROP_BATCHED,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_WORKERS,
+      g_param_spec_uint ("workers", "Workers",
+          "Number of threads updating the trackers of a batch in parallel, "
+          "applicable only in batched mode.",
+          1, MAX_PROP_WORKERS, DEFAULT_PROP_WORKERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_EMBEDDINGS,
+      g_param_spec_string ("embeddings", "Embeddings",
+          "Name of the GstMLTensorMeta on the input buffer which holds the "
+          "re-identification embeddings. The tensor needs one row per ROI "
+          "meta, in ROI order, and its ID is the index of its buffer memory. "
+          "Not set disables association by appearance.",
+          DEFAULT_PROP_EMBEDDINGS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 
   gst_element_class_set_static_metadata (element, "Object Tracker",
       "Filter/Effect/Converter",
@@ -366,6 +431,9 @@ gst_objtracker_init (GstObjTracker * objtracker)
 
   objtracker->algo = NULL;
   objtracker->algoparameters = DEFAULT_PROP_PARAMETERS;
+  objtracker->batched = DEFAULT_PROP_BATCHED;
+  objtracker->workers = DEFAULT_PROP_WORKERS;
+  objtracker->embeddings = DEFAULT_PROP_EMBEDDINGS;
 
   // Handle buffers with GAP flag internally.
   gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (objtracker), TRUE);
@@ -36,6 +36,9 @@ struct _GstObjTracker {
   ///Properties
   gint                  backend;
   GstStructure          *algoparameters;
+  gboolean              batched;
+  guint                 workers;
+  gchar                 *embeddings;
 };
 
 struct _GstObjTrackerClass {
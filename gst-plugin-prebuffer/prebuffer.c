@@ -0,0 +1,741 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "prebuffer.h"
+
+#include <string.h>
+
+#include <gst/video/video.h>
+
+#define GST_CAT_DEFAULT gst_prebuffer_debug
+GST_DEBUG_CATEGORY (gst_prebuffer_debug);
+
+#define gst_prebuffer_parent_class parent_class
+G_DEFINE_TYPE (GstPreBuffer, gst_prebuffer, GST_TYPE_ELEMENT);
+
+#define GST_PREBUFFER_CAPS \
+    "video/x-h264, alignment = (string) au; " \
+    "video/x-h265, alignment = (string) au"
+
+#define DEFAULT_PROP_MAX_SIZE_TIME    (5 * GST_SECOND)
+#define DEFAULT_PROP_MAX_SIZE_BYTES   (8 * 1024 * 1024)
+#define DEFAULT_PROP_POST_ROLL        (5 * GST_SECOND)
+#define DEFAULT_PROP_TRIGGER_CLASSES  NULL
+#define DEFAULT_PROP_MIN_CONFIDENCE   0.0
+
+#define GST_PREBUFFER_ENTRY_TIME(entry) \
+    (GST_CLOCK_TIME_IS_VALID ((entry)->dts) ? (entry)->dts : (entry)->pts)
+
+enum
+{
+  PROP_0,
+  PROP_MAX_SIZE_TIME,
+  PROP_MAX_SIZE_BYTES,
+  PROP_POST_ROLL,
+  PROP_TRIGGER_CLASSES,
+  PROP_MIN_CONFIDENCE,
+};
+
+static GstStaticPadTemplate gst_prebuffer_sink_pad_template =
+    GST_STATIC_PAD_TEMPLATE ("sink",
+        GST_PAD_SINK,
+        GST_PAD_ALWAYS,
+        GST_STATIC_CAPS (GST_PREBUFFER_CAPS)
+    );
+
+static GstStaticPadTemplate gst_prebuffer_src_pad_template =
+    GST_STATIC_PAD_TEMPLATE ("src",
+        GST_PAD_SRC,
+        GST_PAD_ALWAYS,
+        GST_STATIC_CAPS (GST_PREBUFFER_CAPS)
+    );
+
+static void
+gst_prebuffer_reset (GstPreBuffer * prebuf)
+{
+  g_array_set_size (prebuf->entries, 0);
+  prebuf->writepos = 0;
+}
+
+// Remove the oldest GOP from the arena. The most recent GOP is removed only
+// when forced, as the pre-roll always has to start with a key frame.
+static gboolean
+gst_prebuffer_drop_gop (GstPreBuffer * prebuf, gboolean force)
+{
+  GstPreBufferEntry *entry = NULL;
+  guint idx = 0;
+
+  for (idx = 1; idx < prebuf->entries->len; idx++) {
+    entry = &g_array_index (prebuf->entries, GstPreBufferEntry, idx);
+
+    if (!(entry->flags & GST_BUFFER_FLAG_DELTA_UNIT))
+      break;
+  }
+
+  if (idx == prebuf->entries->len) {
+    if (!force)
+      return FALSE;
+
+    gst_prebuffer_reset (prebuf);
+    return TRUE;
+  }
+
+  GST_LOG_OBJECT (prebuf, "Dropping GOP of %u access units", idx);
+
+  g_array_remove_range (prebuf->entries, 0, idx);
+  return TRUE;
+}
+
+// Find contiguous space in the arena, the oldest GOPs are dropped until the
+// requested size fits.
+static gboolean
+gst_prebuffer_reserve (GstPreBuffer * prebuf, gsize size, gsize * offset)
+{
+  GstPreBufferEntry *head = NULL;
+
+  if (size > prebuf->arenasize)
+    return FALSE;
+
+  while (TRUE) {
+    if (prebuf->entries->len == 0) {
+      prebuf->writepos = 0;
+      *offset = 0;
+      return TRUE;
+    }
+
+    head = &g_array_index (prebuf->entries, GstPreBufferEntry, 0);
+
+    if (prebuf->writepos > head->offset) {
+      // Free space is at the end and the start of the arena.
+      if ((prebuf->arenasize - prebuf->writepos) >= size) {
+        *offset = prebuf->writepos;
+        return TRUE;
+      } else if (head->offset >= size) {
+        *offset = 0;
+        return TRUE;
+      }
+    } else if ((head->offset - prebuf->writepos) >= size) {
+      *offset = prebuf->writepos;
+      return TRUE;
+    }
+
+    gst_prebuffer_drop_gop (prebuf, TRUE);
+  }
+
+  return FALSE;
+}
+
+static void
+gst_prebuffer_store (GstPreBuffer * prebuf, GstBuffer * buffer)
+{
+  GstPreBufferEntry entry = { 0, };
+  GstPreBufferEntry *first = NULL, *last = NULL;
+  gboolean keyframe = FALSE;
+
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER)) {
+    gst_buffer_replace (&prebuf->header, NULL);
+    prebuf->header = gst_buffer_copy_deep (buffer);
+    return;
+  }
+
+  keyframe = !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  entry.size = gst_buffer_get_size (buffer);
+
+  if (!gst_prebuffer_reserve (prebuf, entry.size, &entry.offset)) {
+    GST_WARNING_OBJECT (prebuf, "Access unit of %" G_GSIZE_FORMAT " bytes "
+        "exceeds the arena size, pre-roll dropped", entry.size);
+    gst_prebuffer_reset (prebuf);
+    return;
+  }
+
+  // The pre-roll has to start with a key frame, possibly dropped above.
+  if ((prebuf->entries->len == 0) && !keyframe)
+    return;
+
+  gst_buffer_extract (buffer, 0, prebuf->arena + entry.offset, entry.size);
+
+  entry.pts = GST_BUFFER_PTS (buffer);
+  entry.dts = GST_BUFFER_DTS (buffer);
+  entry.duration = GST_BUFFER_DURATION (buffer);
+  entry.flags = GST_BUFFER_FLAGS (buffer) & GST_BUFFER_FLAG_DELTA_UNIT;
+
+  g_array_append_val (prebuf->entries, entry);
+  prebuf->writepos = entry.offset + entry.size;
+
+  if (prebuf->max_size_time == 0)
+    return;
+
+  // Keep the duration within limits, the most recent GOP is always kept.
+  do {
+    first = &g_array_index (prebuf->entries, GstPreBufferEntry, 0);
+    last = &g_array_index (prebuf->entries, GstPreBufferEntry,
+        prebuf->entries->len - 1);
+
+    if (!GST_CLOCK_TIME_IS_VALID (GST_PREBUFFER_ENTRY_TIME (first)) ||
+        !GST_CLOCK_TIME_IS_VALID (GST_PREBUFFER_ENTRY_TIME (last)))
+      break;
+
+    if (GST_CLOCK_DIFF (GST_PREBUFFER_ENTRY_TIME (first),
+            GST_PREBUFFER_ENTRY_TIME (last)) <= (gint64) prebuf->max_size_time)
+      break;
+  } while (gst_prebuffer_drop_gop (prebuf, FALSE));
+}
+
+// Copy out the buffered access units, all of them share a single memory.
+static GstBufferList *
+gst_prebuffer_take_preroll (GstPreBuffer * prebuf)
+{
+  GstBufferList *list = NULL;
+  GstMemory *memory = NULL;
+  GstMapInfo map = GST_MAP_INFO_INIT;
+  GstPreBufferEntry *entry = NULL;
+  gsize size = 0, position = 0;
+  guint idx = 0;
+
+  if (prebuf->entries->len == 0)
+    return NULL;
+
+  for (idx = 0; idx < prebuf->entries->len; idx++)
+    size += g_array_index (prebuf->entries, GstPreBufferEntry, idx).size;
+
+  memory = gst_allocator_alloc (NULL, size, NULL);
+
+  if ((memory == NULL) || !gst_memory_map (memory, &map, GST_MAP_WRITE)) {
+    GST_ERROR_OBJECT (prebuf, "Failed to allocate %" G_GSIZE_FORMAT " bytes "
+        "for the pre-roll!", size);
+
+    if (memory != NULL)
+      gst_memory_unref (memory);
+
+    gst_prebuffer_reset (prebuf);
+    return NULL;
+  }
+
+  for (idx = 0; idx < prebuf->entries->len; idx++) {
+    entry = &g_array_index (prebuf->entries, GstPreBufferEntry, idx);
+
+    memcpy (map.data + position, prebuf->arena + entry->offset, entry->size);
+    position += entry->size;
+  }
+
+  gst_memory_unmap (memory, &map);
+
+  list = gst_buffer_list_new_sized (prebuf->entries->len + 1);
+
+  if (prebuf->header != NULL)
+    gst_buffer_list_add (list, gst_buffer_ref (prebuf->header));
+
+  for (idx = 0, position = 0; idx < prebuf->entries->len; idx++) {
+    GstBuffer *buffer = gst_buffer_new ();
+
+    entry = &g_array_index (prebuf->entries, GstPreBufferEntry, idx);
+
+    gst_buffer_append_memory (buffer,
+        gst_memory_share (memory, position, entry->size));
+    position += entry->size;
+
+    GST_BUFFER_PTS (buffer) = entry->pts;
+    GST_BUFFER_DTS (buffer) = entry->dts;
+    GST_BUFFER_DURATION (buffer) = entry->duration;
+    GST_BUFFER_FLAG_SET (buffer, entry->flags);
+
+    gst_buffer_list_add (list, buffer);
+  }
+
+  gst_memory_unref (memory);
+
+  GST_DEBUG_OBJECT (prebuf, "Pre-roll of %u access units, %" G_GSIZE_FORMAT
+      " bytes", prebuf->entries->len, size);
+
+  gst_prebuffer_reset (prebuf);
+  return list;
+}
+
+static gboolean
+gst_prebuffer_match_detections (GstPreBuffer * prebuf, GstBuffer * buffer)
+{
+  GstMeta *meta = NULL;
+  gpointer state = NULL;
+
+  if (prebuf->labels == NULL)
+    return FALSE;
+
+  while ((meta = gst_buffer_iterate_meta_filtered (buffer, &state,
+              GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)) != NULL) {
+    GstVideoRegionOfInterestMeta *roimeta =
+        (GstVideoRegionOfInterestMeta *) meta;
+    GstStructure *param = NULL;
+    gdouble confidence = 0.0;
+
+    if (!g_strv_contains ((const gchar * const *) prebuf->labels,
+            g_quark_to_string (roimeta->roi_type)))
+      continue;
+
+    param = gst_video_region_of_interest_meta_get_param (roimeta,
+        "ObjectDetection");
+
+    if (param != NULL)
+      gst_structure_get_double (param, "confidence", &confidence);
+
+    if (confidence < prebuf->min_confidence)
+      continue;
+
+    GST_DEBUG_OBJECT (prebuf, "Detection '%s' with confidence %.2f triggered "
+        "recording", g_quark_to_string (roimeta->roi_type), confidence);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+static void
+gst_prebuffer_post_recording (GstPreBuffer * prebuf, gboolean recording,
+    GstClockTime timestamp)
+{
+  GstStructure *structure = NULL;
+
+  GST_INFO_OBJECT (prebuf, "Recording %s at %" GST_TIME_FORMAT,
+      recording ? "started" : "stopped", GST_TIME_ARGS (timestamp));
+
+  structure = gst_structure_new ("GstPreBufferRecording",
+      "recording", G_TYPE_BOOLEAN, recording,
+      "running-time", G_TYPE_UINT64, timestamp, NULL);
+
+  gst_element_post_message (GST_ELEMENT (prebuf),
+      gst_message_new_element (GST_OBJECT (prebuf), structure));
+}
+
+// Keep downstream informed about the stream progress while nothing is output,
+// otherwise async sinks never pre-roll until recording is triggered.
+static void
+gst_prebuffer_push_gap (GstPreBuffer * prebuf, GstBuffer * buffer)
+{
+  GstClockTime timestamp = GST_BUFFER_PTS_IS_VALID (buffer) ?
+      GST_BUFFER_PTS (buffer) : GST_BUFFER_DTS (buffer);
+
+  if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+    return;
+
+  gst_pad_push_event (prebuf->srcpad,
+      gst_event_new_gap (timestamp, GST_BUFFER_DURATION (buffer)));
+}
+
+static gboolean
+gst_prebuffer_trigger (GstPreBuffer * prebuf)
+{
+  GST_DEBUG_OBJECT (prebuf, "Trigger recording");
+
+  GST_PREBUFFER_LOCK (prebuf);
+  prebuf->triggered = TRUE;
+  GST_PREBUFFER_UNLOCK (prebuf);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_prebuffer_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstPreBuffer *prebuf = GST_PREBUFFER (parent);
+  GstBufferList *list = NULL;
+  GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+  gboolean triggered = FALSE, recording = FALSE, forcekey = FALSE;
+  gboolean started = FALSE, stopped = FALSE, keyunit = FALSE, gap = FALSE;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  GST_PREBUFFER_LOCK (prebuf);
+
+  if (prebuf->segment.format == GST_FORMAT_TIME) {
+    timestamp = GST_BUFFER_DTS_IS_VALID (buffer) ?
+        GST_BUFFER_DTS (buffer) : GST_BUFFER_PTS (buffer);
+    timestamp = gst_segment_to_running_time (&prebuf->segment,
+        GST_FORMAT_TIME, timestamp);
+  }
+
+  triggered = prebuf->triggered ||
+      gst_prebuffer_match_detections (prebuf, buffer);
+  prebuf->triggered = FALSE;
+
+  if (triggered) {
+    // Every trigger extends the post-roll.
+    prebuf->deadline = GST_CLOCK_TIME_IS_VALID (timestamp) ?
+        timestamp + prebuf->post_roll : GST_CLOCK_TIME_NONE;
+
+    if (!prebuf->recording) {
+      list = gst_prebuffer_take_preroll (prebuf);
+      prebuf->recording = started = TRUE;
+
+      // No key frame was buffered yet, the live data has to wait for one.
+      prebuf->waitkey = (list == NULL);
+    }
+  } else if (prebuf->recording && GST_CLOCK_TIME_IS_VALID (timestamp) &&
+      GST_CLOCK_TIME_IS_VALID (prebuf->deadline) &&
+      (timestamp >= prebuf->deadline)) {
+    prebuf->recording = FALSE;
+    prebuf->waitkey = FALSE;
+    stopped = TRUE;
+  }
+
+  // Live data has to start with a key frame, stream headers are let through.
+  if (prebuf->waitkey &&
+      !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER) &&
+      !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+    prebuf->waitkey = FALSE;
+    keyunit = TRUE;
+  }
+
+  // Request a key frame instead of waiting for the next regular one.
+  forcekey = started && prebuf->waitkey;
+
+  if (!(recording = prebuf->recording))
+    gst_prebuffer_store (prebuf, buffer);
+  else if (prebuf->waitkey &&
+      !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER))
+    recording = FALSE;
+
+  gap = !recording && (prebuf->segment.format == GST_FORMAT_TIME);
+
+  GST_PREBUFFER_UNLOCK (prebuf);
+
+  if (started || stopped)
+    gst_prebuffer_post_recording (prebuf, started, timestamp);
+
+  if (forcekey) {
+    GST_DEBUG_OBJECT (prebuf, "No buffered key frame, requesting one");
+    gst_pad_push_event (prebuf->sinkpad,
+        gst_video_event_new_upstream_force_key_unit (GST_CLOCK_TIME_NONE,
+            TRUE, 0));
+  }
+
+  if (!recording) {
+    if (gap)
+      gst_prebuffer_push_gap (prebuf, buffer);
+
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  }
+
+  if (list != NULL) {
+    list = gst_buffer_list_make_writable (list);
+    GST_BUFFER_FLAG_SET (gst_buffer_list_get_writable (list, 0),
+        GST_BUFFER_FLAG_DISCONT);
+
+    ret = gst_pad_push_list (prebuf->srcpad, list);
+  } else if (started || keyunit) {
+    buffer = gst_buffer_make_writable (buffer);
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  }
+
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_unref (buffer);
+    return ret;
+  }
+
+  return gst_pad_push (prebuf->srcpad, buffer);
+}
+
+static gboolean
+gst_prebuffer_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstPreBuffer *prebuf = GST_PREBUFFER (parent);
+
+  GST_LOG_OBJECT (prebuf, "Received %s event: %p",
+      GST_EVENT_TYPE_NAME (event), event);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_SEGMENT:
+      GST_PREBUFFER_LOCK (prebuf);
+      gst_event_copy_segment (event, &prebuf->segment);
+      GST_PREBUFFER_UNLOCK (prebuf);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      GST_PREBUFFER_LOCK (prebuf);
+      gst_segment_init (&prebuf->segment, GST_FORMAT_UNDEFINED);
+      gst_prebuffer_reset (prebuf);
+      GST_PREBUFFER_UNLOCK (prebuf);
+      break;
+    default:
+      break;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static GstStateChangeReturn
+gst_prebuffer_change_state (GstElement * element, GstStateChange transition)
+{
+  GstPreBuffer *prebuf = GST_PREBUFFER (element);
+  GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      GST_PREBUFFER_LOCK (prebuf);
+
+      prebuf->arenasize = prebuf->max_size_bytes;
+      prebuf->arena = g_try_malloc (prebuf->arenasize);
+
+      if (prebuf->arena == NULL) {
+        GST_PREBUFFER_UNLOCK (prebuf);
+        GST_ELEMENT_ERROR (prebuf, RESOURCE, NO_SPACE_LEFT, (NULL),
+            ("Failed to allocate arena of %u bytes!", prebuf->max_size_bytes));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+
+      gst_prebuffer_reset (prebuf);
+      gst_segment_init (&prebuf->segment, GST_FORMAT_UNDEFINED);
+
+      prebuf->triggered = FALSE;
+      prebuf->recording = FALSE;
+      prebuf->waitkey = FALSE;
+      prebuf->deadline = GST_CLOCK_TIME_NONE;
+
+      GST_PREBUFFER_UNLOCK (prebuf);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_PREBUFFER_LOCK (prebuf);
+
+      gst_prebuffer_reset (prebuf);
+      gst_buffer_replace (&prebuf->header, NULL);
+
+      g_clear_pointer (&prebuf->arena, g_free);
+      prebuf->arenasize = 0;
+
+      GST_PREBUFFER_UNLOCK (prebuf);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_prebuffer_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPreBuffer *prebuf = GST_PREBUFFER (object);
+
+  GST_PREBUFFER_LOCK (prebuf);
+
+  switch (property_id) {
+    case PROP_MAX_SIZE_TIME:
+      prebuf->max_size_time = g_value_get_uint64 (value);
+      break;
+    case PROP_MAX_SIZE_BYTES:
+      prebuf->max_size_bytes = g_value_get_uint (value);
+      break;
+    case PROP_POST_ROLL:
+      prebuf->post_roll = g_value_get_uint64 (value);
+      break;
+    case PROP_TRIGGER_CLASSES:
+    {
+      guint idx = 0;
+
+      g_free (prebuf->classes);
+      g_clear_pointer (&prebuf->labels, g_strfreev);
+
+      prebuf->classes = g_value_dup_string (value);
+
+      if ((prebuf->classes == NULL) || (prebuf->classes[0] == '\0'))
+        break;
+
+      prebuf->labels = g_strsplit (prebuf->classes, ",", -1);
+
+      for (idx = 0; prebuf->labels[idx] != NULL; idx++)
+        g_strstrip (prebuf->labels[idx]);
+      break;
+    }
+    case PROP_MIN_CONFIDENCE:
+      prebuf->min_confidence = g_value_get_double (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+
+  GST_PREBUFFER_UNLOCK (prebuf);
+}
+
+static void
+gst_prebuffer_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPreBuffer *prebuf = GST_PREBUFFER (object);
+
+  GST_PREBUFFER_LOCK (prebuf);
+
+  switch (property_id) {
+    case PROP_MAX_SIZE_TIME:
+      g_value_set_uint64 (value, prebuf->max_size_time);
+      break;
+    case PROP_MAX_SIZE_BYTES:
+      g_value_set_uint (value, prebuf->max_size_bytes);
+      break;
+    case PROP_POST_ROLL:
+      g_value_set_uint64 (value, prebuf->post_roll);
+      break;
+    case PROP_TRIGGER_CLASSES:
+      g_value_set_string (value, prebuf->classes);
+      break;
+    case PROP_MIN_CONFIDENCE:
+      g_value_set_double (value, prebuf->min_confidence);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+
+  GST_PREBUFFER_UNLOCK (prebuf);
+}
+
+static void
+gst_prebuffer_finalize (GObject * object)
+{
+  GstPreBuffer *prebuf = GST_PREBUFFER (object);
+
+  gst_buffer_replace (&prebuf->header, NULL);
+  g_array_free (prebuf->entries, TRUE);
+  g_free (prebuf->arena);
+
+  g_strfreev (prebuf->labels);
+  g_free (prebuf->classes);
+
+  g_mutex_clear (&prebuf->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (prebuf));
+}
+
+static void
+gst_prebuffer_init (GstPreBuffer * prebuf)
+{
+  g_mutex_init (&prebuf->lock);
+
+  prebuf->sinkpad = gst_pad_new_from_static_template (
+      &gst_prebuffer_sink_pad_template, "sink");
+  gst_pad_set_chain_function (prebuf->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_prebuffer_sink_chain));
+  gst_pad_set_event_function (prebuf->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_prebuffer_sink_event));
+  GST_PAD_SET_PROXY_CAPS (prebuf->sinkpad);
+  gst_element_add_pad (GST_ELEMENT (prebuf), prebuf->sinkpad);
+
+  prebuf->srcpad = gst_pad_new_from_static_template (
+      &gst_prebuffer_src_pad_template, "src");
+  GST_PAD_SET_PROXY_CAPS (prebuf->srcpad);
+  gst_element_add_pad (GST_ELEMENT (prebuf), prebuf->srcpad);
+
+  gst_segment_init (&prebuf->segment, GST_FORMAT_UNDEFINED);
+
+  prebuf->arena = NULL;
+  prebuf->arenasize = 0;
+  prebuf->writepos = 0;
+  prebuf->entries = g_array_new (FALSE, FALSE, sizeof (GstPreBufferEntry));
+  prebuf->header = NULL;
+
+  prebuf->triggered = FALSE;
+  prebuf->recording = FALSE;
+  prebuf->waitkey = FALSE;
+  prebuf->deadline = GST_CLOCK_TIME_NONE;
+
+  prebuf->max_size_time = DEFAULT_PROP_MAX_SIZE_TIME;
+  prebuf->max_size_bytes = DEFAULT_PROP_MAX_SIZE_BYTES;
+  prebuf->post_roll = DEFAULT_PROP_POST_ROLL;
+  prebuf->classes = DEFAULT_PROP_TRIGGER_CLASSES;
+  prebuf->labels = NULL;
+  prebuf->min_confidence = DEFAULT_PROP_MIN_CONFIDENCE;
+}
+
+static void
+gst_prebuffer_class_init (GstPreBufferClass * klass)
+{
+  GObjectClass *gobject = G_OBJECT_CLASS (klass);
+  GstElementClass *element = GST_ELEMENT_CLASS (klass);
+
+  gobject->set_property = GST_DEBUG_FUNCPTR (gst_prebuffer_set_property);
+  gobject->get_property = GST_DEBUG_FUNCPTR (gst_prebuffer_get_property);
+  gobject->finalize = GST_DEBUG_FUNCPTR (gst_prebuffer_finalize);
+
+  g_object_class_install_property (gobject, PROP_MAX_SIZE_TIME,
+      g_param_spec_uint64 ("max-size-time", "Max Size Time",
+          "Maximum duration in nanoseconds of the pre-roll, the oldest GOPs "
+          "are dropped beyond it while the most recent one is always kept "
+          "(0 = limited only by max-size-bytes)",
+          0, G_MAXUINT64, DEFAULT_PROP_MAX_SIZE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_MAX_SIZE_BYTES,
+      g_param_spec_uint ("max-size-bytes", "Max Size Bytes",
+          "Size of the arena preallocated for the pre-roll data",
+          1024, G_MAXUINT, DEFAULT_PROP_MAX_SIZE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_POST_ROLL,
+      g_param_spec_uint64 ("post-roll", "Post Roll",
+          "Time in nanoseconds for which live data is forwarded after the "
+          "last trigger",
+          0, G_MAXUINT64, DEFAULT_PROP_POST_ROLL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_TRIGGER_CLASSES,
+      g_param_spec_string ("trigger-classes", "Trigger Classes",
+          "Comma separated labels of the ObjectDetection ROI metas attached "
+          "to the incoming buffers which trigger recording, e.g. 'person,car'",
+          DEFAULT_PROP_TRIGGER_CLASSES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_MIN_CONFIDENCE,
+      g_param_spec_double ("min-confidence", "Min Confidence",
+          "Minimum confidence of a detection in order to trigger recording",
+          0.0, 100.0, DEFAULT_PROP_MIN_CONFIDENCE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
+  g_signal_new_class_handler ("trigger", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_CALLBACK (gst_prebuffer_trigger),
+      NULL, NULL, NULL, G_TYPE_BOOLEAN, 0);
+
+  element->change_state = GST_DEBUG_FUNCPTR (gst_prebuffer_change_state);
+
+  gst_element_class_add_static_pad_template (element,
+      &gst_prebuffer_sink_pad_template);
+  gst_element_class_add_static_pad_template (element,
+      &gst_prebuffer_src_pad_template);
+
+  gst_element_class_set_static_metadata (element,
+      "Pre-event buffer", "Codec/Video/Filter",
+      "Keeps a GOP aligned ring of encoded video and outputs it together with "
+      "the live data once recording is triggered", "QTI");
+
+  GST_DEBUG_CATEGORY_INIT (gst_prebuffer_debug, "qtiprebuffer", 0,
+      "QTI Pre-event Buffer Plugin");
+}
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  return gst_element_register (plugin, "qtiprebuffer", GST_RANK_NONE,
+      GST_TYPE_PREBUFFER);
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    qtiprebuffer,
+    "QTI Plugin for pre-event buffering of encoded video",
+    plugin_init,
+    PACKAGE_VERSION,
+    PACKAGE_LICENSE,
+    PACKAGE_SUMMARY,
+    PACKAGE_ORIGIN
+)
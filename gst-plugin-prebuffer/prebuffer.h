@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GST_PREBUFFER_H__
+#define __GST_PREBUFFER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_PREBUFFER (gst_prebuffer_get_type())
+#define GST_PREBUFFER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_PREBUFFER, GstPreBuffer))
+#define GST_PREBUFFER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass), GST_TYPE_PREBUFFER, GstPreBufferClass))
+#define GST_IS_PREBUFFER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_PREBUFFER))
+#define GST_IS_PREBUFFER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_PREBUFFER))
+#define GST_PREBUFFER_CAST(obj) ((GstPreBuffer *)(obj))
+
+#define GST_PREBUFFER_GET_LOCK(obj) (&GST_PREBUFFER(obj)->lock)
+#define GST_PREBUFFER_LOCK(obj)     g_mutex_lock(GST_PREBUFFER_GET_LOCK(obj))
+#define GST_PREBUFFER_UNLOCK(obj)   g_mutex_unlock(GST_PREBUFFER_GET_LOCK(obj))
+
+typedef struct _GstPreBuffer GstPreBuffer;
+typedef struct _GstPreBufferClass GstPreBufferClass;
+typedef struct _GstPreBufferEntry GstPreBufferEntry;
+
+struct _GstPreBufferEntry
+{
+  /// Position and size of the access unit data in the arena.
+  gsize           offset;
+  gsize           size;
+
+  GstClockTime    pts;
+  GstClockTime    dts;
+  GstClockTime    duration;
+  GstBufferFlags  flags;
+};
+
+struct _GstPreBuffer
+{
+  GstElement      parent;
+
+  /// Global mutex lock.
+  GMutex          lock;
+
+  GstPad          *sinkpad;
+  GstPad          *srcpad;
+
+  /// Segment of the incoming stream.
+  GstSegment      segment;
+
+  /// Preallocated arena with the data of the buffered access units.
+  guint8          *arena;
+  gsize           arenasize;
+  /// Position in the arena where the next access unit is written.
+  gsize           writepos;
+  /// Buffered access units (GstPreBufferEntry), starting with a key frame.
+  GArray          *entries;
+  /// Copy of the most recent stream header buffer.
+  GstBuffer       *header;
+
+  /// Trigger requested via signal, handled with the next buffer.
+  gboolean        triggered;
+  /// Whether pre-roll was flushed and live data is forwarded.
+  gboolean        recording;
+  /// Recording started without buffered key frame, live data waits for one.
+  gboolean        waitkey;
+  /// Running time until which the live data is forwarded.
+  GstClockTime    deadline;
+
+  /// Properties.
+  guint64         max_size_time;
+  guint           max_size_bytes;
+  guint64         post_roll;
+  gchar           *classes;
+  gchar           **labels;
+  gdouble         min_confidence;
+};
+
+struct _GstPreBufferClass
+{
+  GstElementClass parent;
+};
+
+G_GNUC_INTERNAL GType gst_prebuffer_get_type (void);
+
+G_END_DECLS
+
+#endif // __GST_PREBUFFER_H__
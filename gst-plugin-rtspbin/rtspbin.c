@@ -24,6 +24,15 @@ G_DEFINE_TYPE (GstRtspBin, gst_rtsp_bin, GST_TYPE_BIN);
 #define DEFAULT_PROP_ADDRESS     "127.0.0.1"
 #define DEFAULT_PROP_PORT        "8900"
 #define DEFAULT_PROP_MPOINT      "/live"
+#define DEFAULT_PROP_MAX_LATENCY 500
+#define DEFAULT_PROP_GOP_CACHE   TRUE
+
+// Maximum number of buffers waiting for the client in sync mode.
+#define MAX_BUFFERS              30
+// Maximum number of buffers in the GOP cache of a pad.
+#define MAX_GOP_CACHE_BUFFERS    300
+// Spacing of the cached GOP buffers when replayed as a burst to a new media.
+#define GOP_BURST_INTERVAL       GST_MSECOND
 
 enum
 {
@@ -32,6 +41,8 @@ enum
   PROP_ADDRESS,
   PROP_PORT,
   PROP_MPOINT,
+  PROP_MAX_LATENCY,
+  PROP_GOP_CACHE,
 };
 
 #define GST_RTSP_BIN_CAPS \
@@ -74,79 +85,306 @@ gst_rtsp_bin_mode_get_type (void)
   return gtype;
 }
 
-// Called when the media pipeline is uninitialized
+// Timestamp used for ordering, DTS if available otherwise PTS.
+static inline GstClockTime
+gst_rtsp_bin_buffer_time (GstBuffer * buffer)
+{
+  return GST_BUFFER_DTS_IS_VALID (buffer) ?
+      GST_BUFFER_DTS (buffer) : GST_BUFFER_PTS (buffer);
+}
+
+static inline gboolean
+gst_rtsp_bin_buffer_is_keyframe (GstBuffer * buffer)
+{
+  return !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT) &&
+      !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER);
+}
+
 static void
-gst_rtsp_media_unprepared (GstRTSPMedia * media, gpointer userdata)
+gst_rtsp_bin_buffers_clear (GQueue * queue)
+{
+  while (!g_queue_is_empty (queue))
+    gst_buffer_unref (GST_BUFFER (g_queue_pop_head (queue)));
+}
+
+// Keep copies of the buffers since the most recent key frame. Copies are
+// used in order not to hold the encoder output buffers for a whole GOP.
+static void
+gst_rtsp_bin_sinkpad_cache_buffer (GstRtspBinSinkPad * sinkpad,
+    GstBuffer * buffer)
+{
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER)) {
+    if (sinkpad->header)
+      gst_buffer_unref (sinkpad->header);
+
+    sinkpad->header = gst_buffer_copy_deep (buffer);
+    return;
+  }
+
+  if (gst_rtsp_bin_buffer_is_keyframe (buffer)) {
+    gst_rtsp_bin_buffers_clear (sinkpad->gopcache);
+  } else if (g_queue_is_empty (sinkpad->gopcache)) {
+    // No key frame received yet.
+    return;
+  } else if (g_queue_get_length (sinkpad->gopcache) >= MAX_GOP_CACHE_BUFFERS) {
+    GST_DEBUG_OBJECT (sinkpad, "GOP longer than %u buffers, cache disabled "
+        "until next key frame", MAX_GOP_CACHE_BUFFERS);
+    gst_rtsp_bin_buffers_clear (sinkpad->gopcache);
+    return;
+  }
+
+  g_queue_push_tail (sinkpad->gopcache, gst_buffer_copy_deep (buffer));
+}
+
+// Start a new media from the cached GOP so that the client does not have to
+// wait for the next key frame from the encoder. The GOP is retimestamped into
+// a short burst ending at its newest buffer, otherwise the whole session would
+// trail the live stream by the age of the GOP.
+static gboolean
+gst_rtsp_bin_sinkpad_seed_buffers (GstRtspBinSinkPad * sinkpad)
 {
-  GstRtspBin *rtspbin = (GstRtspBin *) userdata;
   GList *list = NULL;
+  GstBuffer *buffer = NULL, *header = NULL;
+  GstClockTime newest = GST_CLOCK_TIME_NONE, offset = 0, time = 0;
+  guint idx = 0, length = g_queue_get_length (sinkpad->gopcache);
 
-  GST_RTSP_BIN_LOCK (rtspbin);
-  rtspbin->media_prepared = FALSE;
-  GST_RTSP_BIN_UNLOCK (rtspbin);
+  if (length == 0)
+    return FALSE;
 
-  for (list = rtspbin->sinkpads; list; list = list->next) {
-    GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (list->data);
+  newest = gst_rtsp_bin_buffer_time (g_queue_peek_tail (sinkpad->gopcache));
 
-    GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+  if (sinkpad->header != NULL) {
+    header = gst_buffer_copy (sinkpad->header);
+    g_queue_push_tail (sinkpad->buffers, header);
+  }
 
-    if (sinkpad->appsrc)
-      g_clear_pointer (&(sinkpad->appsrc), gst_object_unref);
+  for (list = sinkpad->gopcache->head; list != NULL; list = list->next, idx++) {
+    // Timestamps are changed on a shallow copy, memory is shared.
+    buffer = gst_buffer_copy (GST_BUFFER (list->data));
+    time = gst_rtsp_bin_buffer_time (buffer);
+    offset = (length - 1 - idx) * GOP_BURST_INTERVAL;
 
-    gst_data_queue_set_flushing (sinkpad->buffers, TRUE);
-    gst_data_queue_flush (sinkpad->buffers);
+    if (GST_CLOCK_TIME_IS_VALID (newest) && GST_CLOCK_TIME_IS_VALID (time) &&
+        (newest >= offset) && (newest - offset > time)) {
+      GstClockTime shift = (newest - offset) - time;
 
-    GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+      if (GST_BUFFER_PTS_IS_VALID (buffer))
+        GST_BUFFER_PTS (buffer) += shift;
+
+      if (GST_BUFFER_DTS_IS_VALID (buffer))
+        GST_BUFFER_DTS (buffer) += shift;
+    }
+
+    // Stream header goes out together with the cached key frame.
+    if ((header != NULL) && (idx == 0)) {
+      GST_BUFFER_PTS (header) = GST_BUFFER_PTS (buffer);
+      GST_BUFFER_DTS (header) = GST_BUFFER_DTS (buffer);
+    }
+
+    g_queue_push_tail (sinkpad->buffers, buffer);
   }
 
-  GST_INFO_OBJECT (rtspbin, "Media unprepared");
+  GST_DEBUG_OBJECT (sinkpad, "Seeded %u buffers from the GOP cache",
+      g_queue_get_length (sinkpad->buffers));
+
+  return TRUE;
 }
 
-// This signal callback triggers when appsrc needs data
+// Drop the queue to its most recent key frame when the buffers have been
+// waiting for longer than the allowed latency.
 static void
-gst_appsrc_need_data (GstElement *appsrc, guint size, gpointer userdata)
+gst_rtsp_bin_sinkpad_trim_buffers (GstRtspBinSinkPad * sinkpad,
+    GstClockTime max_latency)
+{
+  GList *list = NULL;
+  GstClockTime first = GST_CLOCK_TIME_NONE, last = GST_CLOCK_TIME_NONE;
+  guint idx = 0, length = g_queue_get_length (sinkpad->buffers);
+
+  if (length < 2)
+    return;
+
+  first = gst_rtsp_bin_buffer_time (g_queue_peek_head (sinkpad->buffers));
+  last = gst_rtsp_bin_buffer_time (g_queue_peek_tail (sinkpad->buffers));
+
+  if (!GST_CLOCK_TIME_IS_VALID (first) || !GST_CLOCK_TIME_IS_VALID (last) ||
+      (last < first) || ((last - first) <= max_latency))
+    return;
+
+  for (list = sinkpad->buffers->tail, idx = length; list != NULL;
+      list = list->prev, idx--) {
+    if (gst_rtsp_bin_buffer_is_keyframe (GST_BUFFER (list->data)))
+      break;
+  }
+
+  // No newer key frame than the oldest buffer, wait for the next one.
+  if ((list == NULL) || (idx == 1)) {
+    gst_rtsp_bin_buffers_clear (sinkpad->buffers);
+    sinkpad->need_keyframe = TRUE;
+  } else {
+    for (idx -= 1; idx > 0; idx--)
+      gst_buffer_unref (GST_BUFFER (g_queue_pop_head (sinkpad->buffers)));
+  }
+
+  GST_DEBUG_OBJECT (sinkpad, "Latency %" GST_TIME_FORMAT " exceeded, dropped "
+      "%u buffers", GST_TIME_ARGS (last - first),
+      length - g_queue_get_length (sinkpad->buffers));
+}
+
+static void
+gst_rtsp_bin_sinkpad_worker_task (gpointer userdata)
 {
   GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (userdata);
-  GstDataQueueItem *item = NULL;
+  GstRtspBin *rtspbin = GST_RTSP_BIN (GST_OBJECT_PARENT (sinkpad));
+  GstElement *appsrc = NULL;
   GstBuffer *buffer = NULL;
-  GstFlowReturn ret;
-  GstClockTime duration = 0;
+  GstClockTime timestamp = GST_CLOCK_TIME_NONE, basetime = GST_CLOCK_TIME_NONE;
+  GstFlowReturn ret = GST_FLOW_OK;
 
   GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
 
-  if (!gst_data_queue_pop (sinkpad->buffers, &item)) {
+  while (g_queue_is_empty (sinkpad->buffers) && !sinkpad->flushing)
+    g_cond_wait (&sinkpad->wakeup, GST_RTSP_BIN_SINKPAD_GET_LOCK (sinkpad));
+
+  if (sinkpad->flushing || (NULL == sinkpad->appsrc)) {
     GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
     return;
   }
 
-  buffer = gst_buffer_ref (GST_BUFFER (item->object));
-  item->destroy (item);
+  buffer = GST_BUFFER (g_queue_pop_head (sinkpad->buffers));
+  appsrc = gst_object_ref (sinkpad->appsrc);
 
-  if (GST_BUFFER_TIMESTAMP_IS_VALID (buffer)) {
-    if (sinkpad->last_timestamp != 0) {
-      duration = GST_BUFFER_PTS (buffer) - sinkpad->last_timestamp;
-    }
-    sinkpad->last_timestamp = GST_BUFFER_PTS (buffer);
+  GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+
+  timestamp = gst_rtsp_bin_buffer_time (buffer);
+
+  GST_RTSP_BIN_LOCK (rtspbin);
+
+  if (!GST_CLOCK_TIME_IS_VALID (rtspbin->basetime))
+    rtspbin->basetime = timestamp;
+
+  basetime = rtspbin->basetime;
+  GST_RTSP_BIN_UNLOCK (rtspbin);
+
+  if (GST_CLOCK_TIME_IS_VALID (timestamp) && (timestamp < basetime)) {
+    GST_DEBUG_OBJECT (sinkpad, "Drop buffer %" GST_TIME_FORMAT " preceding "
+        "media start %" GST_TIME_FORMAT, GST_TIME_ARGS (timestamp),
+        GST_TIME_ARGS (basetime));
+
+    gst_buffer_unref (buffer);
+    gst_object_unref (appsrc);
+    return;
+  }
+
+  buffer = gst_buffer_make_writable (buffer);
 
-    // Increment current timestamp
-    sinkpad->current_timestamp += duration;
+  // Media timestamps start from 0 at the running time of its first buffer.
+  if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
+    if (GST_BUFFER_PTS_IS_VALID (buffer))
+      GST_BUFFER_PTS (buffer) -= basetime;
 
-    GST_BUFFER_PTS (buffer) = sinkpad->current_timestamp;
-    GST_BUFFER_DTS (buffer) = sinkpad->current_timestamp;
+    if (GST_BUFFER_DTS_IS_VALID (buffer))
+      GST_BUFFER_DTS (buffer) -= basetime;
   }
 
   GST_BUFFER_OFFSET (buffer) = -1;
   GST_BUFFER_OFFSET_END (buffer) = -1;
 
-  GST_DEBUG_OBJECT (sinkpad, "Push buffer timestamp - %" G_GINT64_FORMAT,
-      GST_BUFFER_PTS (buffer));
+  GST_DEBUG_OBJECT (sinkpad, "Push buffer timestamp - %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
 
-  g_signal_emit_by_name (sinkpad->appsrc, "push-buffer", buffer, &ret);
+  g_signal_emit_by_name (appsrc, "push-buffer", buffer, &ret);
+
+  if (ret != GST_FLOW_OK)
+    GST_DEBUG_OBJECT (sinkpad, "Push buffer returned %s",
+        gst_flow_get_name (ret));
 
-  // Free the buffer
   gst_buffer_unref (buffer);
+  gst_object_unref (appsrc);
+
+  // Signal free space in sync mode and buffer hand over for EOS.
+  GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+  g_cond_broadcast (&sinkpad->wakeup);
+  GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+}
+
+static gboolean
+gst_rtsp_bin_sinkpad_start_task (GstRtspBinSinkPad * sinkpad)
+{
+  if (sinkpad->worktask != NULL)
+    return TRUE;
+
+  sinkpad->worktask =
+      gst_task_new (gst_rtsp_bin_sinkpad_worker_task, sinkpad, NULL);
+  gst_task_set_lock (sinkpad->worktask, &sinkpad->worklock);
+
+  if (!gst_task_start (sinkpad->worktask)) {
+    GST_ERROR_OBJECT (sinkpad, "Failed to start worker task!");
+    return FALSE;
+  }
+
+  GST_INFO_OBJECT (sinkpad, "Started task %p", sinkpad->worktask);
+  return TRUE;
+}
+
+static void
+gst_rtsp_bin_sinkpad_stop_task (GstRtspBinSinkPad * sinkpad)
+{
+  GstTask *task = NULL;
+
+  GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+
+  sinkpad->flushing = TRUE;
+  g_cond_broadcast (&sinkpad->wakeup);
+
+  task = sinkpad->worktask;
+  sinkpad->worktask = NULL;
 
   GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+
+  if (NULL == task)
+    return;
+
+  if (!gst_task_stop (task))
+    GST_WARNING_OBJECT (sinkpad, "Failed to stop worker task!");
+
+  // Make sure task is not running.
+  g_rec_mutex_lock (&sinkpad->worklock);
+  g_rec_mutex_unlock (&sinkpad->worklock);
+
+  if (!gst_task_join (task))
+    GST_ERROR_OBJECT (sinkpad, "Failed to join worker task!");
+
+  GST_INFO_OBJECT (sinkpad, "Removing task %p", task);
+  gst_object_unref (task);
+}
+
+// Called when the media pipeline is uninitialized
+static void
+gst_rtsp_media_unprepared (GstRTSPMedia * media, gpointer userdata)
+{
+  GstRtspBin *rtspbin = (GstRtspBin *) userdata;
+  GList *list = NULL;
+
+  GST_RTSP_BIN_LOCK (rtspbin);
+  rtspbin->media_prepared = FALSE;
+  GST_RTSP_BIN_UNLOCK (rtspbin);
+
+  for (list = rtspbin->sinkpads; list; list = list->next) {
+    GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (list->data);
+
+    gst_rtsp_bin_sinkpad_stop_task (sinkpad);
+
+    GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+
+    if (sinkpad->appsrc)
+      g_clear_pointer (&(sinkpad->appsrc), gst_object_unref);
+
+    gst_rtsp_bin_buffers_clear (sinkpad->buffers);
+
+    GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+  }
+
+  GST_INFO_OBJECT (rtspbin, "Media unprepared");
 }
 
 // Called when a new media pipeline is constructed. We can query the
@@ -160,6 +398,12 @@ gst_rtsp_factory_media_configure (GstRTSPMediaFactory * factory,
   guint idx = 0;
   GList *list = NULL;
   gchar appsrc_name[50];
+  GstClockTime basetime = GST_CLOCK_TIME_NONE;
+  gboolean gop_cache = FALSE, seeded = FALSE;
+
+  GST_RTSP_BIN_LOCK (rtspbin);
+  gop_cache = rtspbin->gop_cache;
+  GST_RTSP_BIN_UNLOCK (rtspbin);
 
   // Get the element used for providing the streams of the media
   element = gst_rtsp_media_get_element (media);
@@ -168,30 +412,45 @@ gst_rtsp_factory_media_configure (GstRTSPMediaFactory * factory,
   for (list = rtspbin->sinkpads; list; list = list->next) {
     GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (list->data);
     GstStructure *structure = gst_caps_get_structure (sinkpad->caps, 0);
+    GstBuffer *buffer = NULL;
 
     if (!structure) {
       GST_ERROR_OBJECT (rtspbin, "Cannot get sinkpad structure");
+      gst_object_unref (element);
       return;
     }
 
     snprintf (appsrc_name, sizeof (appsrc_name), "appsrc%d", idx);
 
+    GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+
     // Get appsrc instance
     sinkpad->appsrc =
         gst_bin_get_by_name_recurse_up (GST_BIN (element), appsrc_name);
     gst_util_set_object_arg (G_OBJECT (sinkpad->appsrc), "format", "time");
-    g_object_set (G_OBJECT (sinkpad->appsrc), "caps", sinkpad->caps, NULL);
+    g_object_set (G_OBJECT (sinkpad->appsrc), "caps", sinkpad->caps,
+        "block", TRUE, NULL);
 
-    g_signal_connect (sinkpad->appsrc, "need-data",
-        G_CALLBACK (gst_appsrc_need_data), sinkpad);
+    sinkpad->flushing = FALSE;
+    sinkpad->need_keyframe = FALSE;
 
-    // Reset timestamps
-    sinkpad->current_timestamp = 0;
-    sinkpad->last_timestamp = 0;
+    // Buffers held in sync mode are sent first, otherwise start from the GOP.
+    if (gop_cache && g_queue_is_empty (sinkpad->buffers))
+      seeded |= gst_rtsp_bin_sinkpad_seed_buffers (sinkpad);
 
-    idx++;
+    // Media time base is the running time of the earliest queued buffer, for
+    // a seeded GOP that is the start of its burst just before the live edge.
+    if ((buffer = g_queue_peek_head (sinkpad->buffers)) != NULL) {
+      GstClockTime timestamp = gst_rtsp_bin_buffer_time (buffer);
+
+      if (GST_CLOCK_TIME_IS_VALID (timestamp) &&
+          (!GST_CLOCK_TIME_IS_VALID (basetime) || (timestamp < basetime)))
+        basetime = timestamp;
+    }
+
+    GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
 
-    gst_data_queue_set_flushing (sinkpad->buffers, FALSE);
+    idx++;
   }
 
   // Make sure datails freed when the media is gone
@@ -203,11 +462,59 @@ gst_rtsp_factory_media_configure (GstRTSPMediaFactory * factory,
   g_signal_connect (media, "unprepared",
       (GCallback) gst_rtsp_media_unprepared, rtspbin);
 
-  GST_INFO_OBJECT (rtspbin, "Media configured");
+  GST_INFO_OBJECT (rtspbin, "Media configured, base time %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (basetime));
 
   GST_RTSP_BIN_LOCK (rtspbin);
+  rtspbin->basetime = basetime;
+  rtspbin->seeded = seeded;
   rtspbin->media_prepared = TRUE;
   GST_RTSP_BIN_UNLOCK (rtspbin);
+
+  for (list = rtspbin->sinkpads; list; list = list->next)
+    gst_rtsp_bin_sinkpad_start_task (GST_RTSP_BIN_SINKPAD (list->data));
+}
+
+// Called when a client starts playing. Clients joining an already running
+// shared media request a key frame so that they can start decoding early.
+static void
+gst_rtsp_bin_client_play_request (GstRTSPClient * client, GstRTSPContext * ctx,
+    gpointer userdata)
+{
+  GstRtspBin *rtspbin = (GstRtspBin *) userdata;
+  GList *list = NULL;
+  gboolean seeded = FALSE;
+
+  GST_RTSP_BIN_LOCK (rtspbin);
+  seeded = rtspbin->seeded;
+  rtspbin->seeded = FALSE;
+  GST_RTSP_BIN_UNLOCK (rtspbin);
+
+  // First client of the media already starts from the cached key frame.
+  if (seeded)
+    return;
+
+  for (list = rtspbin->sinkpads; list; list = list->next) {
+    GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (list->data);
+    GstStructure *structure = gst_caps_get_structure (sinkpad->caps, 0);
+
+    if (!gst_structure_has_name (structure, "video/x-h264") &&
+        !gst_structure_has_name (structure, "video/x-h265"))
+      continue;
+
+    GST_DEBUG_OBJECT (sinkpad, "Request key frame for new client");
+    gst_pad_push_event (GST_PAD (sinkpad),
+        gst_video_event_new_upstream_force_key_unit (GST_CLOCK_TIME_NONE,
+            TRUE, 0));
+  }
+}
+
+static void
+gst_rtsp_bin_client_connected (GstRTSPServer * server, GstRTSPClient * client,
+    gpointer userdata)
+{
+  g_signal_connect (client, "play-request",
+      (GCallback) gst_rtsp_bin_client_play_request, userdata);
 }
 
 static GstRTSPFilterResult
@@ -311,13 +618,13 @@ gst_rtsp_bin_init_server (GstRtspBin * rtspbin)
     }
 
     if (gst_structure_has_name (structure, "video/x-h264")) {
-      g_string_append_printf (string, "appsrc is-live=true name=appsrc%d ! queue ! rtph264pay pt=96 ! queue name=pay%d ", idx, idx);
+      g_string_append_printf (string, "appsrc is-live=true name=appsrc%d ! rtph264pay pt=96 config-interval=-1 ! queue name=pay%d ", idx, idx);
     } else if (gst_structure_has_name (structure, "video/x-h265")) {
-      g_string_append_printf (string, "appsrc is-live=true name=appsrc%d ! queue ! rtph265pay pt=97 ! queue name=pay%d ", idx, idx);
+      g_string_append_printf (string, "appsrc is-live=true name=appsrc%d ! rtph265pay pt=97 config-interval=-1 ! queue name=pay%d ", idx, idx);
     } else if (gst_structure_has_name (structure, "audio/mpeg")) {
-      g_string_append_printf (string, "appsrc is-live=true name=appsrc%d ! queue ! rtpmp4apay pt=97 ! queue name=pay%d ", idx, idx);
+      g_string_append_printf (string, "appsrc is-live=true name=appsrc%d ! rtpmp4apay pt=97 ! queue name=pay%d ", idx, idx);
     } else if (gst_structure_has_name (structure, "text/x-raw")) {
-      g_string_append_printf (string, "appsrc is-live=true name=appsrc%d ! queue ! rtpgstpay pt=98 ! queue name=pay%d ", idx, idx);
+      g_string_append_printf (string, "appsrc is-live=true name=appsrc%d ! rtpgstpay pt=98 ! queue name=pay%d ", idx, idx);
     }
 
     idx++;
@@ -337,6 +644,10 @@ gst_rtsp_bin_init_server (GstRtspBin * rtspbin)
   g_signal_connect (rtspbin->factory, "media-configure",
       (GCallback) gst_rtsp_factory_media_configure, rtspbin);
 
+  // Track the clients joining the shared media.
+  g_signal_connect (rtspbin->server, "client-connected",
+      (GCallback) gst_rtsp_bin_client_connected, rtspbin);
+
   // Attach the RTSP server to the main context.
   if (0 == gst_rtsp_server_attach (rtspbin->server, NULL)) {
     GST_ERROR_OBJECT (rtspbin,
@@ -354,45 +665,78 @@ gst_rtsp_bin_init_server (GstRtspBin * rtspbin)
   return TRUE;
 }
 
-static void
-gst_data_queue_free_item (gpointer userdata)
-{
-  GstDataQueueItem *item = userdata;
-
-  if (item->object != NULL)
-    gst_buffer_unref (GST_BUFFER (item->object));
-
-  g_slice_free (GstDataQueueItem, item);
-}
-
 static GstFlowReturn
 gst_rtsp_bin_sink_pad_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer)
 {
   GstRtspBin *rtspbin = GST_RTSP_BIN (parent);
   GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (pad);
-  GstDataQueueItem *item = NULL;
+  GstRtspBinMode mode = DEFAULT_PROP_MODE;
+  GstClockTime max_latency = 0;
+  gboolean prepared = FALSE, gop_cache = FALSE;
 
   GST_RTSP_BIN_LOCK (rtspbin);
 
-  if (rtspbin->mode == GST_RTSPBIN_MODE_ASYNC && !rtspbin->media_prepared) {
+  mode = rtspbin->mode;
+  prepared = rtspbin->media_prepared;
+  gop_cache = rtspbin->gop_cache;
+  max_latency = rtspbin->max_latency * GST_MSECOND;
+
+  GST_RTSP_BIN_UNLOCK (rtspbin);
+
+  buffer = gst_buffer_make_writable (buffer);
+
+  GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+
+  // Queued buffers carry running time, mapped to media time on push.
+  if (sinkpad->segment.format == GST_FORMAT_TIME) {
+    if (GST_BUFFER_PTS_IS_VALID (buffer))
+      GST_BUFFER_PTS (buffer) = gst_segment_to_running_time (
+          &sinkpad->segment, GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+
+    if (GST_BUFFER_DTS_IS_VALID (buffer))
+      GST_BUFFER_DTS (buffer) = gst_segment_to_running_time (
+          &sinkpad->segment, GST_FORMAT_TIME, GST_BUFFER_DTS (buffer));
+  }
+
+  if (gop_cache)
+    gst_rtsp_bin_sinkpad_cache_buffer (sinkpad, buffer);
+
+  if (mode == GST_RTSPBIN_MODE_ASYNC && !prepared) {
+    GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
     gst_buffer_unref (buffer);
-    GST_RTSP_BIN_UNLOCK (rtspbin);
     return GST_FLOW_OK;
   }
 
-  GST_RTSP_BIN_UNLOCK (rtspbin);
+  // After a latency overrun resume only from a key frame.
+  if (sinkpad->need_keyframe &&
+      GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT) &&
+      !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER)) {
+    GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  } else if (gst_rtsp_bin_buffer_is_keyframe (buffer)) {
+    sinkpad->need_keyframe = FALSE;
+  }
+
+  // In sync mode wait until the client has consumed some of the buffers.
+  while (mode == GST_RTSPBIN_MODE_SYNC && !sinkpad->flushing &&
+      g_queue_get_length (sinkpad->buffers) >= MAX_BUFFERS)
+    g_cond_wait (&sinkpad->wakeup, GST_RTSP_BIN_SINKPAD_GET_LOCK (sinkpad));
+
+  if (sinkpad->flushing) {
+    GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  }
 
-  item = g_slice_new0 (GstDataQueueItem);
-  item->object = GST_MINI_OBJECT (buffer);
-  item->size = gst_buffer_get_size (buffer);
-  item->duration = GST_BUFFER_DURATION (buffer);
-  item->visible = TRUE;
-  item->destroy = gst_data_queue_free_item;
+  g_queue_push_tail (sinkpad->buffers, buffer);
 
-  // Push the buffer into the queue or free it on failure.
-  if (!gst_data_queue_push (sinkpad->buffers, item))
-    item->destroy (item);
+  if (mode == GST_RTSPBIN_MODE_ASYNC && max_latency > 0)
+    gst_rtsp_bin_sinkpad_trim_buffers (sinkpad, max_latency);
+
+  g_cond_broadcast (&sinkpad->wakeup);
+  GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
 
   return GST_FLOW_OK;
 }
@@ -465,15 +809,75 @@ gst_rtsp_bin_sink_pad_event (GstPad * pad, GstObject * parent, GstEvent * event)
       }
     }
     break;
+    case GST_EVENT_SEGMENT:
+    {
+      GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (pad);
+
+      GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+      gst_event_copy_segment (event, &sinkpad->segment);
+      GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+    }
+    break;
+    case GST_EVENT_FLUSH_START:
+    {
+      GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (pad);
+
+      GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+
+      // Release the chain waiting for free space in sync mode.
+      sinkpad->flushing = TRUE;
+      g_cond_broadcast (&sinkpad->wakeup);
+
+      if (sinkpad->worktask != NULL)
+        gst_task_pause (sinkpad->worktask);
+
+      GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+    }
+    break;
+    case GST_EVENT_FLUSH_STOP:
+    {
+      GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (pad);
+
+      GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+
+      // Flushed data is not sent, resume with the next key frame.
+      gst_rtsp_bin_buffers_clear (sinkpad->buffers);
+      gst_rtsp_bin_buffers_clear (sinkpad->gopcache);
+      gst_segment_init (&sinkpad->segment, GST_FORMAT_UNDEFINED);
+
+      sinkpad->need_keyframe = TRUE;
+      sinkpad->flushing = FALSE;
+
+      if (sinkpad->worktask != NULL)
+        gst_task_start (sinkpad->worktask);
+
+      GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+    }
+    break;
     case GST_EVENT_EOS:
     {
       GstMessage *message;
       guint32 seqnum;
       GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (pad);
+      GstElement *appsrc = NULL;
+
+      GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+
+      // Let the worker task hand over the queued buffers first.
+      while (!g_queue_is_empty (sinkpad->buffers) && !sinkpad->flushing &&
+          (sinkpad->worktask != NULL))
+        g_cond_wait (&sinkpad->wakeup, GST_RTSP_BIN_SINKPAD_GET_LOCK (sinkpad));
 
-      // Send EOS to the appsrc attached to the pad
       if (sinkpad->appsrc)
-        gst_element_send_event (sinkpad->appsrc, gst_event_new_eos ());
+        appsrc = gst_object_ref (sinkpad->appsrc);
+
+      GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+
+      // Send EOS to the appsrc attached to the pad
+      if (appsrc) {
+        gst_element_send_event (appsrc, gst_event_new_eos ());
+        gst_object_unref (appsrc);
+      }
 
       // When all other sink pads are in EOS state post EOS.
       if (gst_rtsp_bin_all_sink_pads_eos (rtspbin, pad)) {
@@ -506,6 +910,19 @@ gst_rtsp_bin_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      for (list = rtspbin->sinkpads; list; list = list->next) {
+        GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (list->data);
+
+        GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+        sinkpad->flushing = FALSE;
+        gst_segment_init (&sinkpad->segment, GST_FORMAT_UNDEFINED);
+        GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
+      }
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      // Unblock the streaming threads before the pads are deactivated.
+      for (list = rtspbin->sinkpads; list; list = list->next)
+        gst_rtsp_bin_sinkpad_stop_task (GST_RTSP_BIN_SINKPAD (list->data));
       break;
     default:
       break;
@@ -518,8 +935,11 @@ gst_rtsp_bin_change_state (GstElement * element, GstStateChange transition)
       for (list = rtspbin->sinkpads; list; list = list->next) {
         GstRtspBinSinkPad *sinkpad = GST_RTSP_BIN_SINKPAD (list->data);
 
-        gst_data_queue_set_flushing (sinkpad->buffers, TRUE);
-        gst_data_queue_flush (sinkpad->buffers);
+        GST_RTSP_BIN_SINKPAD_LOCK (sinkpad);
+        gst_rtsp_bin_buffers_clear (sinkpad->buffers);
+        gst_rtsp_bin_buffers_clear (sinkpad->gopcache);
+        g_clear_pointer (&(sinkpad->header), gst_buffer_unref);
+        GST_RTSP_BIN_SINKPAD_UNLOCK (sinkpad);
       }
 
       gst_rtsp_bin_deinit_server (rtspbin);
@@ -590,6 +1010,8 @@ gst_rtsp_bin_release_pad (GstElement * element, GstPad * pad)
 
   GST_DEBUG_OBJECT (rtspbin, "Releasing pad: %s", GST_PAD_NAME (pad));
 
+  gst_rtsp_bin_sinkpad_stop_task (GST_RTSP_BIN_SINKPAD (pad));
+
   GST_RTSP_BIN_LOCK (rtspbin);
   rtspbin->sinkpads = g_list_remove (rtspbin->sinkpads, pad);
   GST_RTSP_BIN_UNLOCK (rtspbin);
@@ -618,6 +1040,12 @@ gst_rtsp_bin_set_property (GObject * object, guint prop_id,
     case PROP_MPOINT:
       rtspbin->mpoint = g_strdup (g_value_get_string (value));
       break;
+    case PROP_MAX_LATENCY:
+      rtspbin->max_latency = g_value_get_uint (value);
+      break;
+    case PROP_GOP_CACHE:
+      rtspbin->gop_cache = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -647,6 +1075,12 @@ gst_rtsp_bin_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_MPOINT:
       g_value_set_string (value, rtspbin->mpoint);
       break;
+    case PROP_MAX_LATENCY:
+      g_value_set_uint (value, rtspbin->max_latency);
+      break;
+    case PROP_GOP_CACHE:
+      g_value_set_boolean (value, rtspbin->gop_cache);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -698,6 +1132,20 @@ gst_rtsp_bin_class_init (GstRtspBinClass *klass)
       g_param_spec_string ("mpoint", "MPoint",
           "Mounting point",
           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_MAX_LATENCY,
+      g_param_spec_uint ("max-latency", "Max latency",
+          "Maximum time in milliseconds the buffers can wait for the clients "
+          "in async mode, on overrun the queue is dropped to its most recent "
+          "key frame (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_PROP_MAX_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_GOP_CACHE,
+      g_param_spec_boolean ("gop-cache", "GOP cache",
+          "Keep the most recent GOP of each stream and start new media from "
+          "its key frame instead of waiting for the next one",
+          DEFAULT_PROP_GOP_CACHE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 
 
   gst_element_class_set_static_metadata (element, "RTSP streaming Bin",
@@ -715,12 +1163,16 @@ gst_rtsp_bin_init (GstRtspBin * rtspbin)
   rtspbin->address = DEFAULT_PROP_ADDRESS;
   rtspbin->port = DEFAULT_PROP_PORT;
   rtspbin->mpoint = DEFAULT_PROP_MPOINT;
+  rtspbin->max_latency = DEFAULT_PROP_MAX_LATENCY;
+  rtspbin->gop_cache = DEFAULT_PROP_GOP_CACHE;
 
   rtspbin->nextidx = 0;
   rtspbin->sinkpads = NULL;
   rtspbin->server = NULL;
   rtspbin->factory = NULL;
   rtspbin->media_prepared = FALSE;
+  rtspbin->basetime = GST_CLOCK_TIME_NONE;
+  rtspbin->seeded = FALSE;
 
   GST_OBJECT_FLAG_SET (rtspbin, GST_ELEMENT_FLAG_SINK);
 }
@@ -51,12 +51,18 @@ struct _GstRtspBin
   GstRTSPMediaFactory *factory;
   /// Prepared flag
   gboolean            media_prepared;
+  /// Running time which maps to timestamp 0 in the media.
+  GstClockTime        basetime;
+  /// Media was started from the cached GOPs, no key frame request needed.
+  gboolean            seeded;
 
   /// Properties.
   GstRtspBinMode      mode;
   gchar               *address;
   gchar               *port;
   gchar               *mpoint;
+  guint               max_latency;
+  gboolean            gop_cache;
 };
 
 struct _GstRtspBinClass
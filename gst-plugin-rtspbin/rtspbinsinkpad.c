@@ -5,8 +5,6 @@
 
 #include "rtspbinsinkpad.h"
 
-#define MAX_BUFFERS 30
-
 GST_DEBUG_CATEGORY_STATIC (gst_rtsp_bin_sinkpad_debug);
 #define GST_CAT_DEFAULT gst_rtsp_bin_sinkpad_debug
 
@@ -30,7 +28,17 @@ gst_rtsp_bin_sinkpad_finalize (GObject * object)
     sinkpad->appsrc = NULL;
   }
 
-  gst_object_unref (GST_OBJECT_CAST (sinkpad->buffers));
+  g_queue_free_full (sinkpad->buffers, (GDestroyNotify) gst_buffer_unref);
+  g_queue_free_full (sinkpad->gopcache, (GDestroyNotify) gst_buffer_unref);
+
+  if (sinkpad->header)
+    gst_buffer_unref (sinkpad->header);
+
+  if (sinkpad->worktask)
+    gst_object_unref (sinkpad->worktask);
+
+  g_cond_clear (&sinkpad->wakeup);
+  g_rec_mutex_clear (&sinkpad->worklock);
 
   G_OBJECT_CLASS (gst_rtsp_bin_sinkpad_parent_class)->finalize(object);
 }
@@ -46,23 +54,24 @@ gst_rtsp_bin_sinkpad_class_init (GstRtspBinSinkPadClass * klass)
       "qtirtspbin", 0, "QTI Rtsp Bin sink pad");
 }
 
-static gboolean
-queue_is_full_cb (GstDataQueue * queue, guint visible, guint bytes,
-                  guint64 time, gpointer checkdata)
-{
-  return (visible >= MAX_BUFFERS) ? TRUE : FALSE;
-}
-
 static void
 gst_rtsp_bin_sinkpad_init (GstRtspBinSinkPad * sinkpad)
 {
   g_mutex_init (&sinkpad->lock);
+  g_cond_init (&sinkpad->wakeup);
+  g_rec_mutex_init (&sinkpad->worklock);
 
   sinkpad->index = 0;
   sinkpad->caps = NULL;
   sinkpad->appsrc = NULL;
-  sinkpad->current_timestamp = 0;
-  sinkpad->last_timestamp = 0;
+  gst_segment_init (&sinkpad->segment, GST_FORMAT_UNDEFINED);
+
+  sinkpad->buffers = g_queue_new ();
+  sinkpad->flushing = FALSE;
+  sinkpad->need_keyframe = FALSE;
+
+  sinkpad->gopcache = g_queue_new ();
+  sinkpad->header = NULL;
 
-  sinkpad->buffers = gst_data_queue_new (queue_is_full_cb, NULL, NULL, NULL);
+  sinkpad->worktask = NULL;
 }
@@ -8,7 +8,6 @@
 
 #include <gst/gst.h>
 #include <gst/video/video.h>
-#include <gst/base/gstdataqueue.h>
 
 G_BEGIN_DECLS
 
@@ -47,12 +46,27 @@ struct _GstRtspBinSinkPad {
   GstCaps       *caps;
   /// Appsrc instance linked to the pad
   GstElement    *appsrc;
-  /// Current timestamp from the begining of the stream start
-  GstClockTime  current_timestamp;
-  /// Last timestamp
-  GstClockTime  last_timestamp;
-  /// Pad buffers queue
-  GstDataQueue  *buffers;
+  /// Segment of the incoming stream, used for running time conversion.
+  GstSegment    segment;
+
+  /// Buffers (in running time) waiting to be pushed into the appsrc.
+  GQueue        *buffers;
+  /// Condition signalled when the buffers queue changes.
+  GCond         wakeup;
+  /// Whether the buffers queue is flushing.
+  gboolean      flushing;
+  /// Drop delta units until next key frame after latency overrun.
+  gboolean      need_keyframe;
+
+  /// Copies of the buffers since the most recent key frame.
+  GQueue        *gopcache;
+  /// Copy of the most recent stream header buffer.
+  GstBuffer     *header;
+
+  /// Worker task pushing the queued buffers into the appsrc.
+  GstTask       *worktask;
+  /// Worker task mutex.
+  GRecMutex     worklock;
 };
 
 struct _GstRtspBinSinkPadClass {
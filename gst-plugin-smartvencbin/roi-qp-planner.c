@@ -0,0 +1,547 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "roi-qp-planner.h"
+
+#include <math.h>
+#include <string.h>
+
+#define GST_CAT_DEFAULT roi_qp_planner_category ()
+
+// QP delta corresponding to one step in the class quality table.
+#define GST_ROI_QP_PLANNER_QUALITY_STEP   (3)
+// Number of detection sets after which an unseen track is forgotten.
+#define GST_ROI_QP_PLANNER_TRACK_TIMEOUT  (30)
+// Weight of the newest sample in the track velocity average.
+#define GST_ROI_QP_PLANNER_VELOCITY_ALPHA (0.5)
+// Maximum number of queued detection sets, older ones are dropped.
+#define GST_ROI_QP_PLANNER_MAX_QUEUED     (16)
+
+typedef struct _GstRoiDetection GstRoiDetection;
+typedef struct _GstRoiDetections GstRoiDetections;
+typedef struct _GstRoiTrack GstRoiTrack;
+
+struct _GstRoiDetection {
+  // Class label of the detected object.
+  GQuark  label;
+  // Normalized bounding box.
+  gdouble x, y, w, h;
+  // Tracker ID, -1 if the object is not tracked.
+  gint64  id;
+};
+
+struct _GstRoiDetections {
+  GstClockTime timestamp;
+  // Array of GstRoiDetection.
+  GArray       *objects;
+};
+
+struct _GstRoiTrack {
+  // Center of the bounding box when last seen, normalized.
+  gdouble      cx, cy;
+  // Velocity in normalized units per second.
+  gdouble      vx, vy;
+  // Timestamp when the track was last seen.
+  GstClockTime timestamp;
+  // Sequence number of the detection set which last contained the track.
+  guint64      seqnum;
+};
+
+struct _GstRoiQpPlanner {
+  // Lock protecting the queue and the tuning, the ML pad pushes from its own
+  // streaming thread while the maps are planned from the encode worker.
+  GMutex       lock;
+
+  // Queue with GstRoiDetections ordered by timestamp.
+  GQueue       *detections;
+  // Latest consumed detections, kept to plan maps for following frames.
+  GstRoiDetections *latest;
+  // Tracked objects, indexed by tracker ID.
+  GHashTable   *tracks;
+  // Number of consumed detection sets.
+  guint64      seqnum;
+
+  // Frame and macroblock geometry.
+  guint        width;
+  guint        height;
+  guint        mb_size;
+  guint        n_columns;
+  guint        n_rows;
+
+  // Smoothed QP delta per macroblock.
+  gfloat       *state;
+  // QP deltas of the map last handed to the encoder.
+  gint8        *applied;
+  // Timestamp of the previously planned frame.
+  GstClockTime prevts;
+
+  // Tuning.
+  GstStructure *qualities;
+  gint         background;
+  gdouble      smoothing;
+  gdouble      budget;
+};
+
+static GstDebugCategory *
+roi_qp_planner_category (void)
+{
+  static gsize catonce = 0;
+
+  if (g_once_init_enter (&catonce)) {
+    gsize catdone = (gsize) _gst_debug_category_new ("roi-qp-planner", 0,
+        "ROI QP planner");
+    g_once_init_leave (&catonce, catdone);
+  }
+  return (GstDebugCategory *) catonce;
+}
+
+static void
+gst_roi_detections_free (gpointer data)
+{
+  GstRoiDetections *detections = (GstRoiDetections *) data;
+
+  if (detections == NULL)
+    return;
+
+  g_array_free (detections->objects, TRUE);
+  g_slice_free (GstRoiDetections, detections);
+}
+
+GstRoiQpPlanner *
+gst_roi_qp_planner_new (void)
+{
+  GstRoiQpPlanner *planner = g_new0 (GstRoiQpPlanner, 1);
+
+  g_mutex_init (&planner->lock);
+
+  planner->detections = g_queue_new ();
+  planner->tracks = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+      g_free, g_free);
+  planner->prevts = GST_CLOCK_TIME_NONE;
+
+  planner->background = 0;
+  planner->smoothing = 0.0;
+  planner->budget = 0.0;
+
+  return planner;
+}
+
+void
+gst_roi_qp_planner_free (GstRoiQpPlanner * planner)
+{
+  g_queue_free_full (planner->detections, gst_roi_detections_free);
+  gst_roi_detections_free (planner->latest);
+  g_hash_table_destroy (planner->tracks);
+
+  if (planner->qualities != NULL)
+    gst_structure_free (planner->qualities);
+
+  g_free (planner->state);
+  g_free (planner->applied);
+  g_mutex_clear (&planner->lock);
+
+  g_free (planner);
+}
+
+void
+gst_roi_qp_planner_configure (GstRoiQpPlanner * planner, guint width,
+    guint height, guint mb_size)
+{
+  g_mutex_lock (&planner->lock);
+
+  width = (width != 0) ? width : planner->width;
+  height = (height != 0) ? height : planner->height;
+  mb_size = (mb_size != 0) ? mb_size : planner->mb_size;
+
+  if ((planner->width == width) && (planner->height == height) &&
+      (planner->mb_size == mb_size)) {
+    g_mutex_unlock (&planner->lock);
+    return;
+  }
+
+  planner->width = width;
+  planner->height = height;
+  planner->mb_size = mb_size;
+
+  g_clear_pointer (&planner->state, g_free);
+  g_clear_pointer (&planner->applied, g_free);
+  planner->n_columns = planner->n_rows = 0;
+
+  if ((mb_size != 0) && (width != 0) && (height != 0)) {
+    planner->n_columns = (width + mb_size - 1) / mb_size;
+    planner->n_rows = (height + mb_size - 1) / mb_size;
+    planner->state = g_new0 (gfloat, planner->n_columns * planner->n_rows);
+    // Encoder without a map behaves as if a flat map was set.
+    planner->applied = g_new0 (gint8, planner->n_columns * planner->n_rows);
+  }
+
+  GST_INFO ("Configured %ux%u, MB size %u, map %ux%u", width, height, mb_size,
+      planner->n_columns, planner->n_rows);
+
+  g_mutex_unlock (&planner->lock);
+}
+
+void
+gst_roi_qp_planner_set_tuning (GstRoiQpPlanner * planner,
+    const GstStructure * qualities, gint background, gdouble smoothing,
+    gdouble budget)
+{
+  g_mutex_lock (&planner->lock);
+
+  if (planner->qualities != NULL)
+    gst_structure_free (planner->qualities);
+
+  planner->qualities =
+      (qualities != NULL) ? gst_structure_copy (qualities) : NULL;
+
+  planner->background = CLAMP (background, GST_ROI_QP_PLANNER_MIN_DELTA,
+      GST_ROI_QP_PLANNER_MAX_DELTA);
+  planner->smoothing = CLAMP (smoothing, 0.0, 0.99);
+  planner->budget = MAX (budget, 0.0);
+
+  g_mutex_unlock (&planner->lock);
+}
+
+static void
+gst_roi_qp_planner_parse_entry (GArray * objects, GstStructure * entry)
+{
+  GstRoiDetection object = { 0, };
+  const GValue *value = NULL;
+  guint id = 0;
+
+  if ((value = gst_structure_get_value (entry, "rectangle")) == NULL)
+    return;
+
+  if (gst_value_array_get_size (value) != 4) {
+    GST_ERROR ("Badly formed ROI rectangle, expected 4 entries but received "
+        "%u!", gst_value_array_get_size (value));
+    return;
+  }
+
+  object.label = gst_structure_get_name_id (entry);
+  object.x = g_value_get_float (gst_value_array_get_value (value, 0));
+  object.y = g_value_get_float (gst_value_array_get_value (value, 1));
+  object.w = g_value_get_float (gst_value_array_get_value (value, 2));
+  object.h = g_value_get_float (gst_value_array_get_value (value, 3));
+  object.id = -1;
+
+  if (gst_structure_get_uint (entry, "tracking-id", &id))
+    object.id = id;
+
+  g_array_append_val (objects, object);
+}
+
+void
+gst_roi_qp_planner_push_ml_data (GstRoiQpPlanner * planner, gchar * data,
+    GstClockTime timestamp)
+{
+  GstRoiDetections *detections = NULL;
+  gchar *remaining = data, *token = NULL;
+
+  detections = g_slice_new0 (GstRoiDetections);
+  detections->timestamp = timestamp;
+  detections->objects =
+      g_array_new (FALSE, FALSE, sizeof (GstRoiDetection));
+
+  while ((token = strtok_r (remaining, "\n", &remaining))) {
+    GValue list = G_VALUE_INIT;
+    guint idx = 0, num = 0;
+
+    g_value_init (&list, GST_TYPE_LIST);
+
+    if (!gst_value_deserialize (&list, token)) {
+      GST_ERROR ("Failed to deserialize ML data!");
+      g_value_unset (&list);
+      continue;
+    }
+
+    for (idx = 0; idx < gst_value_list_get_size (&list); idx++) {
+      const GValue *entry = gst_value_list_get_value (&list, idx);
+      GstStructure *structure = GST_STRUCTURE (g_value_get_boxed (entry));
+      const GValue *boxes = NULL;
+
+      if (!gst_structure_has_name (structure, "ObjectDetection"))
+        continue;
+
+      boxes = gst_structure_get_value (structure, "bounding-boxes");
+
+      if (boxes == NULL)
+        continue;
+
+      for (num = 0; num < gst_value_array_get_size (boxes); num++) {
+        const GValue *value = gst_value_array_get_value (boxes, num);
+
+        gst_roi_qp_planner_parse_entry (detections->objects,
+            GST_STRUCTURE (g_value_get_boxed (value)));
+      }
+    }
+
+    g_value_unset (&list);
+  }
+
+  GST_LOG ("Received %u detections at %" GST_TIME_FORMAT,
+      detections->objects->len, GST_TIME_ARGS (timestamp));
+
+  g_mutex_lock (&planner->lock);
+
+  g_queue_push_tail (planner->detections, detections);
+
+  // Encoder may be stalled, don't grow the queue indefinitely.
+  while (g_queue_get_length (planner->detections) >
+      GST_ROI_QP_PLANNER_MAX_QUEUED)
+    gst_roi_detections_free (g_queue_pop_head (planner->detections));
+
+  g_mutex_unlock (&planner->lock);
+}
+
+static void
+gst_roi_qp_planner_update_tracks (GstRoiQpPlanner * planner,
+    GstRoiDetections * detections)
+{
+  GHashTableIter iter;
+  gpointer value = NULL;
+  guint idx = 0;
+
+  planner->seqnum++;
+
+  for (idx = 0; idx < detections->objects->len; idx++) {
+    GstRoiDetection *object =
+        &g_array_index (detections->objects, GstRoiDetection, idx);
+    GstRoiTrack *track = NULL;
+    gdouble cx = object->x + object->w / 2, cy = object->y + object->h / 2;
+
+    if (object->id < 0)
+      continue;
+
+    track = g_hash_table_lookup (planner->tracks, &object->id);
+
+    if (track == NULL) {
+      gint64 *key = g_new (gint64, 1);
+
+      *key = object->id;
+      track = g_new0 (GstRoiTrack, 1);
+      g_hash_table_insert (planner->tracks, key, track);
+    } else if (GST_CLOCK_TIME_IS_VALID (track->timestamp) &&
+        (detections->timestamp > track->timestamp)) {
+      gdouble seconds = (gdouble) (detections->timestamp - track->timestamp) /
+          GST_SECOND;
+      gdouble alpha = GST_ROI_QP_PLANNER_VELOCITY_ALPHA;
+
+      track->vx += alpha * (((cx - track->cx) / seconds) - track->vx);
+      track->vy += alpha * (((cy - track->cy) / seconds) - track->vy);
+    }
+
+    track->cx = cx;
+    track->cy = cy;
+    track->timestamp = detections->timestamp;
+    track->seqnum = planner->seqnum;
+  }
+
+  // Forget tracks which haven't been seen for a while.
+  g_hash_table_iter_init (&iter, planner->tracks);
+
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    GstRoiTrack *track = (GstRoiTrack *) value;
+
+    if ((planner->seqnum - track->seqnum) > GST_ROI_QP_PLANNER_TRACK_TIMEOUT)
+      g_hash_table_iter_remove (&iter);
+  }
+}
+
+static gint
+gst_roi_qp_planner_class_delta (GstRoiQpPlanner * planner, GQuark label)
+{
+  gint quality = 0;
+
+  if ((planner->qualities != NULL) &&
+      gst_structure_id_has_field (planner->qualities, label))
+    gst_structure_get_int (planner->qualities, g_quark_to_string (label),
+        &quality);
+
+  return CLAMP (-quality * GST_ROI_QP_PLANNER_QUALITY_STEP,
+      GST_ROI_QP_PLANNER_MIN_DELTA, GST_ROI_QP_PLANNER_MAX_DELTA);
+}
+
+static void
+gst_roi_qp_planner_fill_target (GstRoiQpPlanner * planner, gfloat * target,
+    GstClockTime timestamp, GstClockTime interval)
+{
+  GstRoiDetections *detections = planner->latest;
+  guint idx = 0, n_mbs = planner->n_columns * planner->n_rows;
+
+  for (idx = 0; idx < n_mbs; idx++)
+    target[idx] = planner->background;
+
+  if (detections == NULL)
+    return;
+
+  for (idx = 0; idx < detections->objects->len; idx++) {
+    GstRoiDetection *object =
+        &g_array_index (detections->objects, GstRoiDetection, idx);
+    gdouble left = object->x, top = object->y;
+    gdouble right = object->x + object->w, bottom = object->y + object->h;
+    gint delta = gst_roi_qp_planner_class_delta (planner, object->label);
+    gint col = 0, row = 0, col0, col1, row0, row1;
+    GstRoiTrack *track = NULL;
+
+    if (object->id >= 0)
+      track = g_hash_table_lookup (planner->tracks, &object->id);
+
+    // Move tracked objects to where they are expected in this frame and
+    // stretch the box along the motion so it still covers them next frame.
+    if ((track != NULL) && GST_CLOCK_TIME_IS_VALID (timestamp) &&
+        (timestamp >= detections->timestamp)) {
+      gdouble seconds = (gdouble) (timestamp - detections->timestamp) /
+          GST_SECOND;
+      gdouble lead = GST_CLOCK_TIME_IS_VALID (interval) ?
+          (gdouble) interval / GST_SECOND : 0.0;
+
+      left += track->vx * seconds;
+      right += track->vx * seconds;
+      top += track->vy * seconds;
+      bottom += track->vy * seconds;
+
+      if (track->vx > 0)
+        right += track->vx * lead;
+      else
+        left += track->vx * lead;
+
+      if (track->vy > 0)
+        bottom += track->vy * lead;
+      else
+        top += track->vy * lead;
+    }
+
+    col0 = floor (CLAMP (left, 0.0, 1.0) * planner->width / planner->mb_size);
+    col1 = ceil (CLAMP (right, 0.0, 1.0) * planner->width / planner->mb_size);
+    row0 = floor (CLAMP (top, 0.0, 1.0) * planner->height / planner->mb_size);
+    row1 = ceil (CLAMP (bottom, 0.0, 1.0) * planner->height / planner->mb_size);
+
+    col1 = MIN (col1, (gint) planner->n_columns);
+    row1 = MIN (row1, (gint) planner->n_rows);
+
+    // Overlapping objects keep the best quality of them.
+    for (row = row0; row < row1; row++) {
+      for (col = col0; col < col1; col++) {
+        gfloat *value = &target[row * planner->n_columns + col];
+        *value = MIN (*value, delta);
+      }
+    }
+  }
+}
+
+GArray *
+gst_roi_qp_planner_get_map (GstRoiQpPlanner * planner, GstClockTime timestamp)
+{
+  GArray *map = NULL;
+  GstRoiDetections *detections = NULL;
+  GstClockTime interval = GST_CLOCK_TIME_NONE;
+  gfloat *target = NULL;
+  gdouble ratio = 0.0, offset = 0.0;
+  gboolean changed = FALSE;
+  guint idx = 0, n_mbs = 0;
+
+  g_mutex_lock (&planner->lock);
+
+  // Consume all detections made on this or earlier frames.
+  while ((detections = g_queue_peek_head (planner->detections)) != NULL) {
+    if (GST_CLOCK_TIME_IS_VALID (timestamp) &&
+        (detections->timestamp > timestamp))
+      break;
+
+    g_queue_pop_head (planner->detections);
+    gst_roi_qp_planner_update_tracks (planner, detections);
+
+    gst_roi_detections_free (planner->latest);
+    planner->latest = detections;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (planner->prevts) &&
+      GST_CLOCK_TIME_IS_VALID (timestamp) && (timestamp > planner->prevts))
+    interval = timestamp - planner->prevts;
+
+  planner->prevts = timestamp;
+
+  // Geometry is not known yet, detections are kept for the following frames.
+  if (planner->state == NULL) {
+    g_mutex_unlock (&planner->lock);
+    return NULL;
+  }
+
+  n_mbs = planner->n_columns * planner->n_rows;
+  target = g_new (gfloat, n_mbs);
+
+  gst_roi_qp_planner_fill_target (planner, target, timestamp, interval);
+
+  // Quality is raised immediately while it is lowered gradually, this avoids
+  // pumping when an object is missed by the detector for a few frames.
+  for (idx = 0; idx < n_mbs; idx++) {
+    gfloat *state = &planner->state[idx];
+
+    if (target[idx] <= *state)
+      *state = target[idx];
+    else
+      *state = planner->smoothing * (*state) +
+          (1.0 - planner->smoothing) * target[idx];
+
+    // Relative bitrate of the macroblock, it doubles every 6 QP steps.
+    ratio += pow (2.0, -(*state) / 6.0);
+  }
+
+  g_free (target);
+
+  ratio /= n_mbs;
+
+  // Shift the whole map when the estimated bitrate exceeds the budget.
+  if ((planner->budget > 0.0) && (ratio > planner->budget))
+    offset = ceil (6.0 * log2 (ratio / planner->budget));
+
+  for (idx = 0; idx < n_mbs; idx++) {
+    gint value = lrintf (planner->state[idx] + offset);
+
+    value = CLAMP (value, GST_ROI_QP_PLANNER_MIN_DELTA,
+        GST_ROI_QP_PLANNER_MAX_DELTA);
+
+    changed |= (planner->applied[idx] != value);
+    planner->applied[idx] = value;
+  }
+
+  GST_LOG ("Planned map for %" GST_TIME_FORMAT " with %u objects, estimated "
+      "bitrate ratio %.2f, offset %.0f%s", GST_TIME_ARGS (timestamp),
+      (planner->latest != NULL) ? planner->latest->objects->len : 0, ratio,
+      offset, changed ? "" : ", unchanged");
+
+  // The previous map remains set on the encoder.
+  if (!changed) {
+    g_mutex_unlock (&planner->lock);
+    return NULL;
+  }
+
+  map = g_array_sized_new (FALSE, FALSE, sizeof (gint8), n_mbs);
+  g_array_append_vals (map, planner->applied, n_mbs);
+
+  g_mutex_unlock (&planner->lock);
+  return map;
+}
+
+void
+gst_roi_qp_planner_flush (GstRoiQpPlanner * planner)
+{
+  g_mutex_lock (&planner->lock);
+
+  g_queue_free_full (planner->detections, gst_roi_detections_free);
+  planner->detections = g_queue_new ();
+
+  g_clear_pointer (&planner->latest, gst_roi_detections_free);
+  g_hash_table_remove_all (planner->tracks);
+
+  if (planner->state != NULL)
+    memset (planner->state, 0,
+        planner->n_columns * planner->n_rows * sizeof (gfloat));
+
+  planner->prevts = GST_CLOCK_TIME_NONE;
+
+  g_mutex_unlock (&planner->lock);
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef _GST_ROI_QP_PLANNER_H_
+#define _GST_ROI_QP_PLANNER_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+// Supported QP delta range of the encoder macroblock map.
+#define GST_ROI_QP_PLANNER_MIN_DELTA  (-31)
+#define GST_ROI_QP_PLANNER_MAX_DELTA  (30)
+
+typedef struct _GstRoiQpPlanner GstRoiQpPlanner;
+
+/**
+ * gst_roi_qp_planner_new:
+ *
+ * Create planner which turns ML detections into per macroblock QP delta maps.
+ *
+ * return: Pointer to the planner.
+ */
+GstRoiQpPlanner *
+gst_roi_qp_planner_new (void);
+
+/**
+ * gst_roi_qp_planner_free:
+ * @planner: Pointer to the planner.
+ *
+ * Free the planner and all queued detections.
+ */
+void
+gst_roi_qp_planner_free (GstRoiQpPlanner * planner);
+
+/**
+ * gst_roi_qp_planner_configure:
+ * @planner: Pointer to the planner.
+ * @width: Width of the encoded frames.
+ * @height: Height of the encoded frames.
+ * @mb_size: Side length of the encoder macroblock.
+ *
+ * Set the frame geometry, zero values keep the current setting. Maps are
+ * planned once the geometry is complete, the smoothing state is reset
+ * whenever it changes.
+ */
+void
+gst_roi_qp_planner_configure (GstRoiQpPlanner * planner, guint width,
+    guint height, guint mb_size);
+
+/**
+ * gst_roi_qp_planner_set_tuning:
+ * @planner: Pointer to the planner.
+ * @qualities: Class to quality table, e.g. "ROIQPs,person=2,car=1,tree=-1".
+ *             Each quality step lowers the QP of the class by 3.
+ * @background: QP delta applied on macroblocks without detections.
+ * @smoothing: Weight of the previous map when a region loses quality [0, 1).
+ * @budget: Maximum estimated bitrate relative to a flat QP map, 0 to disable.
+ *
+ * Update the planner tuning, takes effect from the next map.
+ */
+void
+gst_roi_qp_planner_set_tuning (GstRoiQpPlanner * planner,
+    const GstStructure * qualities, gint background, gdouble smoothing,
+    gdouble budget);
+
+/**
+ * gst_roi_qp_planner_push_ml_data:
+ * @planner: Pointer to the planner.
+ * @data: Serialized list of ObjectDetection structures.
+ * @timestamp: Timestamp of the frame on which the detections were made.
+ *
+ * Queue detections for the frame with the given timestamp.
+ */
+void
+gst_roi_qp_planner_push_ml_data (GstRoiQpPlanner * planner, gchar * data,
+    GstClockTime timestamp);
+
+/**
+ * gst_roi_qp_planner_get_map:
+ * @planner: Pointer to the planner.
+ * @timestamp: Timestamp of the frame which is about to be encoded.
+ *
+ * Consume all detections up to the given timestamp and plan the QP delta
+ * map for the frame from the latest detections. Tracked objects are
+ * extrapolated to the frame time.
+ *
+ * return: Map of gint8 QP deltas in raster order (transfer full) or NULL
+ *         if the map is unchanged or the geometry is not known yet.
+ */
+GArray *
+gst_roi_qp_planner_get_map (GstRoiQpPlanner * planner, GstClockTime timestamp);
+
+/**
+ * gst_roi_qp_planner_flush:
+ * @planner: Pointer to the planner.
+ *
+ * Drop queued detections, tracks and smoothing state.
+ */
+void
+gst_roi_qp_planner_flush (GstRoiQpPlanner * planner);
+
+G_END_DECLS
+
+#endif // _GST_ROI_QP_PLANNER_H_
@@ -25,6 +25,7 @@ enum {
 
 #define GST_CONTROLS_MAX_SIZE               256
 #define GST_TYPE_VENC_BIN_ENCODER           (gst_venc_bin_encoder_get_type())
+#define GST_TYPE_VENC_BIN_ROI_MODE          (gst_venc_bin_roi_mode_get_type())
 
 #define DEFAULT_PROP_ENCODER                GST_VENC_BIN_C2_ENC
 #define DEFAULT_PROP_MAX_BITRATE            (6000000)
@@ -32,6 +33,10 @@ enum {
 #define DEFAULT_PROP_MAX_GOP_LENGTH         (600)
 #define DEFAULT_PROP_SMART_FRAMERATE        (TRUE)
 #define DEFAULT_PROP_SMART_GOP              (TRUE)
+#define DEFAULT_PROP_ROI_MODE               GST_VENC_BIN_ROI_MODE_VIDEOCTRL
+#define DEFAULT_PROP_ROI_BACKGROUND_QP      (4)
+#define DEFAULT_PROP_ROI_SMOOTHING          (0.8)
+#define DEFAULT_PROP_ROI_BITRATE_BUDGET     (1.0)
 
 enum
 {
@@ -45,6 +50,10 @@ enum
   PROP_LEVELS_OVERRIDE,
   PROP_ROI_QUALITY_CFG,
   PROP_MIN_BUFFERS,
+  PROP_ROI_MODE,
+  PROP_ROI_BACKGROUND_QP,
+  PROP_ROI_SMOOTHING,
+  PROP_ROI_BITRATE_BUDGET,
 };
 
 #define GST_VIDEO_FORMATS "{ NV12, NV12_Q08C }"
@@ -119,6 +128,28 @@ gst_venc_bin_encoder_get_type (void)
   return gtype;
 }
 
+static GType
+gst_venc_bin_roi_mode_get_type (void)
+{
+  static GType gtype = 0;
+  static const GEnumValue variants[] = {
+    { GST_VENC_BIN_ROI_MODE_VIDEOCTRL,
+        "ROI rectangles decided by the VideoCtrl library.",
+        "videoctrl"
+    },
+    { GST_VENC_BIN_ROI_MODE_PLANNER,
+        "Macroblock QP map planned from the ML detections and tracks.",
+        "planner"
+    },
+    {0, NULL, NULL},
+  };
+
+  if (!gtype)
+    gtype = g_enum_register_static ("GstBinRoiMode", variants);
+
+  return gtype;
+}
+
 static gboolean
 gst_venc_bin_update_encoder (GstVideoEncBin * vencbin)
 {
@@ -381,6 +412,14 @@ gst_venc_init_session (GstVideoEncBin * vencbin, GstCaps * caps)
   }
 
   gst_smartcodec_engine_init (vencbin->engine, caps);
+
+  if (vencbin->planner != NULL) {
+    GstVideoInfo info;
+
+    if (gst_video_info_from_caps (&info, caps))
+      gst_roi_qp_planner_configure (vencbin->planner,
+          GST_VIDEO_INFO_WIDTH (&info), GST_VIDEO_INFO_HEIGHT (&info), 0);
+  }
 }
 
 static void
@@ -424,6 +463,32 @@ gst_venc_init_video_crtl_session (GstVideoEncBin * vencbin, GstCaps * caps)
       vencbin);
 }
 
+// Configure the planner macroblock size as soon as the encoder output format
+// is known, detections consumed before the first encoded frame are not lost.
+static GstPadProbeReturn
+gst_venc_encoder_caps_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstVideoEncBin *vencbin = GST_VENC_BIN (user_data);
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstStructure *structure = NULL;
+  GstCaps *caps = NULL;
+
+  if ((GST_EVENT_TYPE (event) != GST_EVENT_CAPS) || (vencbin->planner == NULL))
+    return GST_PAD_PROBE_OK;
+
+  gst_event_parse_caps (event, &caps);
+  structure = gst_caps_get_structure (caps, 0);
+
+  // Macroblock size as expected by the encoder for its QP map.
+  if (gst_structure_has_name (structure, "video/x-h264"))
+    gst_roi_qp_planner_configure (vencbin->planner, 0, 0, 16);
+  else if (gst_structure_has_name (structure, "video/x-h265"))
+    gst_roi_qp_planner_configure (vencbin->planner, 0, 0, 32);
+
+  return GST_PAD_PROBE_OK;
+}
+
 GstPadProbeReturn
 gst_venc_encoder_output_probe (GstPad * pad, GstPadProbeInfo * info,
     gpointer user_data)
@@ -439,8 +504,13 @@ gst_venc_encoder_output_probe (GstPad * pad, GstPadProbeInfo * info,
   }
 
   if (!vencbin->output_caps_processed) {
-    gst_smartcodec_engine_process_output_caps (vencbin->engine,
-        gst_pad_get_current_caps (pad));
+    GstCaps *caps = gst_pad_get_current_caps (pad);
+
+    gst_smartcodec_engine_process_output_caps (vencbin->engine, caps);
+
+    if (caps != NULL)
+      gst_caps_unref (caps);
+
     vencbin->output_caps_processed = TRUE;
   }
 
@@ -524,6 +594,47 @@ gst_venc_set_roi_qp (GstVideoEncBin * vencbin, RectDeltaQPs * qps)
   }
 }
 
+static void
+gst_venc_set_roi_mb_map (GstVideoEncBin * vencbin, GArray * map)
+{
+  GValue array = G_VALUE_INIT, value = G_VALUE_INIT;
+  guint idx = 0;
+
+  switch (vencbin->encoder_type) {
+    case GST_VENC_BIN_C2_ENC:
+      break;
+    default:
+      GST_WARNING_OBJECT (vencbin, "ROI MB map is handled only for Codec2");
+      return;
+  }
+
+  g_value_init (&array, GST_TYPE_ARRAY);
+  g_value_init (&value, G_TYPE_CHAR);
+
+  for (idx = 0; idx < map->len; idx++) {
+    g_value_set_schar (&value, g_array_index (map, gint8, idx));
+    gst_value_array_append_value (&array, &value);
+  }
+
+  GST_DEBUG_OBJECT (vencbin, "Set ROI MB map with %u entries", map->len);
+  g_object_set_property (G_OBJECT (vencbin->encoder), "roi-mb-map-info",
+      &array);
+
+  g_value_unset (&value);
+  g_value_unset (&array);
+}
+
+static void
+gst_venc_bin_update_roi_tuning (GstVideoEncBin * vencbin)
+{
+  if (vencbin->planner == NULL)
+    return;
+
+  gst_roi_qp_planner_set_tuning (vencbin->planner, vencbin->roi_qualitys,
+      vencbin->roi_background_qp, vencbin->roi_smoothing,
+      vencbin->roi_bitrate_budget);
+}
+
 static void
 gst_free_ctrl_queue_item (gpointer data)
 {
@@ -669,6 +780,21 @@ gst_venc_bin_ml_pad_chain (GstPad * pad, GstObject * parent,
   }
 
   gchar *data =  g_strndup ((const gchar *) memmap.data, memmap.size);
+  gboolean planner = FALSE;
+
+  GST_VENC_BIN_LOCK (vencbin);
+  planner = (vencbin->roi_mode == GST_VENC_BIN_ROI_MODE_PLANNER);
+  GST_VENC_BIN_UNLOCK (vencbin);
+
+  // Both parsers tokenize the string in place, the planner gets a copy.
+  if (data && planner && (vencbin->planner != NULL)) {
+    gchar *copy = g_strdup (data);
+
+    gst_roi_qp_planner_push_ml_data (vencbin->planner, copy,
+        GST_BUFFER_TIMESTAMP (buffer));
+    g_free (copy);
+  }
+
   if (data) {
     GST_DEBUG_OBJECT (vencbin, "gst_smartcodec_engine_push_ml_buff");
     gst_smartcodec_engine_push_ml_buff (vencbin->engine, data,
@@ -746,7 +872,19 @@ gst_venc_bin_worker_task (gpointer user_data)
         break;
       }
 
-      if (has_roi) {
+      if (vencbin->roi_mode == GST_VENC_BIN_ROI_MODE_PLANNER) {
+        GArray *map = gst_roi_qp_planner_get_map (vencbin->planner,
+            GST_BUFFER_TIMESTAMP (buffer));
+
+        if (map != NULL) {
+          gst_venc_set_roi_mb_map (vencbin, map);
+          g_array_free (map, TRUE);
+        }
+
+        // Rectangles from VideoCtrl are not used, only release them.
+        if (has_roi && (buf_pts >= ml_pts))
+          gst_smartcodec_engine_remove_rois_from_queue (vencbin->engine);
+      } else if (has_roi) {
         GST_DEBUG_OBJECT (vencbin, "buf_pts - %ld, ml_pts - %ld",
             buf_pts, ml_pts);
 
@@ -886,6 +1024,10 @@ gst_venc_bin_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      GST_VENC_BIN_LOCK (vencbin);
+      gst_venc_bin_update_roi_tuning (vencbin);
+      GST_VENC_BIN_UNLOCK (vencbin);
+
       gst_data_queue_set_flushing (vencbin->main_frames, FALSE);
       gst_venc_bin_start_worker_task (vencbin);
       gst_data_queue_set_flushing (vencbin->ctrl_frames, FALSE);
@@ -904,6 +1046,9 @@ gst_venc_bin_change_state (GstElement * element, GstStateChange transition)
       gst_venc_bin_stop_worker_task (vencbin);
       gst_data_queue_set_flushing (vencbin->ctrl_frames, TRUE);
       gst_data_queue_flush (vencbin->ctrl_frames);
+
+      if (vencbin->planner != NULL)
+        gst_roi_qp_planner_flush (vencbin->planner);
       break;
     default:
       break;
@@ -1019,6 +1164,8 @@ gst_venc_bin_set_property (GObject * object, guint prop_id,
 
       vencbin->roi_qualitys = GST_STRUCTURE (g_value_dup_boxed (&value));
       g_value_unset (&value);
+
+      gst_venc_bin_update_roi_tuning (vencbin);
       break;
     }
     case PROP_MIN_BUFFERS:
@@ -1026,6 +1173,21 @@ gst_venc_bin_set_property (GObject * object, guint prop_id,
       vencbin->min_buffers = g_value_get_uint (value);
       break;
     }
+    case PROP_ROI_MODE:
+      vencbin->roi_mode = g_value_get_enum (value);
+      break;
+    case PROP_ROI_BACKGROUND_QP:
+      vencbin->roi_background_qp = g_value_get_int (value);
+      gst_venc_bin_update_roi_tuning (vencbin);
+      break;
+    case PROP_ROI_SMOOTHING:
+      vencbin->roi_smoothing = g_value_get_double (value);
+      gst_venc_bin_update_roi_tuning (vencbin);
+      break;
+    case PROP_ROI_BITRATE_BUDGET:
+      vencbin->roi_bitrate_budget = g_value_get_double (value);
+      gst_venc_bin_update_roi_tuning (vencbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1088,6 +1250,18 @@ gst_venc_bin_get_property (GObject * object, guint prop_id, GValue * value,
       g_value_set_uint (value, vencbin->min_buffers);
       break;
     }
+    case PROP_ROI_MODE:
+      g_value_set_enum (value, vencbin->roi_mode);
+      break;
+    case PROP_ROI_BACKGROUND_QP:
+      g_value_set_int (value, vencbin->roi_background_qp);
+      break;
+    case PROP_ROI_SMOOTHING:
+      g_value_set_double (value, vencbin->roi_smoothing);
+      break;
+    case PROP_ROI_BITRATE_BUDGET:
+      g_value_set_double (value, vencbin->roi_bitrate_budget);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1112,6 +1286,11 @@ gst_venc_bin_finalize (GObject * object)
     vencbin->engine = NULL;
   }
 
+  if (vencbin->planner != NULL) {
+    gst_roi_qp_planner_free (vencbin->planner);
+    vencbin->planner = NULL;
+  }
+
   if (vencbin->ctrl_frames != NULL) {
     gst_data_queue_set_flushing (vencbin->ctrl_frames, TRUE);
     gst_data_queue_flush (vencbin->ctrl_frames);
@@ -1218,6 +1397,35 @@ gst_venc_bin_class_init (GstVideoEncBinClass *klass)
           "The default value is overriden based on the video stream.",
           0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_ROI_MODE,
+      g_param_spec_enum ("roi-mode", "ROI mode",
+          "Source of the ROI quantization. The planner generates a macroblock "
+          "QP map from the ML detections using 'roi-quality-cfg' as class "
+          "quality table, each quality step lowers the QP by 3 (Codec2 only)",
+          GST_TYPE_VENC_BIN_ROI_MODE, DEFAULT_PROP_ROI_MODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_ROI_BACKGROUND_QP,
+      g_param_spec_int ("roi-background-qp", "ROI background QP",
+          "QP delta applied by the planner on areas without detections",
+          GST_ROI_QP_PLANNER_MIN_DELTA, GST_ROI_QP_PLANNER_MAX_DELTA,
+          DEFAULT_PROP_ROI_BACKGROUND_QP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_ROI_SMOOTHING,
+      g_param_spec_double ("roi-smoothing", "ROI smoothing",
+          "Temporal smoothing of the planner map when a region loses quality, "
+          "weight of the previous map (0 = no smoothing)",
+          0.0, 0.99, DEFAULT_PROP_ROI_SMOOTHING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_ROI_BITRATE_BUDGET,
+      g_param_spec_double ("roi-bitrate-budget", "ROI bitrate budget",
+          "Maximum estimated bitrate of the planner map relative to a flat "
+          "QP map, the whole map is raised when exceeded (0 = disabled)",
+          0.0, 16.0, DEFAULT_PROP_ROI_BITRATE_BUDGET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
 
   gst_element_class_set_static_metadata (element, "Smart Video Encode Bin",
       "Generic/Bin/Encoder", "Smart control over video encoding", "QTI");
@@ -1264,6 +1472,12 @@ gst_venc_bin_init (GstVideoEncBin * vencbin)
 
   vencbin->levels_override = NULL;
   vencbin->roi_qualitys = NULL;
+  vencbin->roi_mode = DEFAULT_PROP_ROI_MODE;
+  vencbin->roi_background_qp = DEFAULT_PROP_ROI_BACKGROUND_QP;
+  vencbin->roi_smoothing = DEFAULT_PROP_ROI_SMOOTHING;
+  vencbin->roi_bitrate_budget = DEFAULT_PROP_ROI_BITRATE_BUDGET;
+
+  vencbin->planner = gst_roi_qp_planner_new ();
 
   gst_video_info_init (&vencbin->video_ctrl_info);
   vencbin->ctrl_frames =
@@ -1315,6 +1529,8 @@ gst_venc_bin_init (GstVideoEncBin * vencbin)
   GST_INFO_OBJECT (vencbin, "Adding probe to encoder src pad");
   gst_pad_add_probe (vencbin->srcpad, GST_PAD_PROBE_TYPE_BUFFER,
       (GstPadProbeCallback) gst_venc_encoder_output_probe, vencbin, NULL);
+  gst_pad_add_probe (vencbin->srcpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) gst_venc_encoder_caps_probe, vencbin, NULL);
 
   gst_pad_set_active (vencbin->srcpad, TRUE);
   gst_element_add_pad (GST_ELEMENT_CAST (vencbin), vencbin->srcpad);
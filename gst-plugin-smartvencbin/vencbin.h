@@ -16,6 +16,7 @@
 #include <gst/base/gstdataqueue.h>
 
 #include "smart-codec-engine.h"
+#include "roi-qp-planner.h"
 
 G_BEGIN_DECLS
 
@@ -45,6 +46,11 @@ typedef enum {
   GST_VENC_BIN_V4L2_H265_ENC,
 } GstBinEncoderType;
 
+typedef enum {
+  GST_VENC_BIN_ROI_MODE_VIDEOCTRL,
+  GST_VENC_BIN_ROI_MODE_PLANNER,
+} GstBinRoiMode;
+
 struct _GstCtrlFrameData
 {
   GstBuffer *buffer;
@@ -81,8 +87,15 @@ struct _GstVideoEncBin
   guint             max_goplength;
   GstStructure      *levels_override;
   GstStructure      *roi_qualitys;
+  GstBinRoiMode     roi_mode;
+  gint              roi_background_qp;
+  gdouble           roi_smoothing;
+  gdouble           roi_bitrate_budget;
   gboolean          output_caps_processed;
 
+  // In-tree planner producing macroblock QP maps from the ML detections.
+  GstRoiQpPlanner   *planner;
+
   // Ctrl pad frames queue
   GstDataQueue      *ctrl_frames;
   // Ctrl stream video info
@@ -32,6 +32,10 @@
 * SPDX-License-Identifier: BSD-3-Clause-Clear
 */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <arpa/inet.h>
 #include <stdint.h>
 
@@ -50,6 +54,16 @@ free_pl_struct (GstPayloadInfo * pl_info)
     pl_info->message = NULL;
   }
 
+  if (pl_info->subscribe != NULL) {
+    g_free (pl_info->subscribe);
+    pl_info->subscribe = NULL;
+  }
+
+  if (pl_info->ring_setup != NULL) {
+    g_free (pl_info->ring_setup);
+    pl_info->ring_setup = NULL;
+  }
+
   if (pl_info->buffer_info != NULL) {
     g_free (pl_info->buffer_info);
     pl_info->buffer_info = NULL;
@@ -84,161 +98,199 @@ free_pl_struct (GstPayloadInfo * pl_info)
     g_ptr_array_free (pl_info->lm_meta_info, TRUE);
     pl_info->lm_meta_info = NULL;
   }
+
+  if (pl_info->ring_record_info != NULL) {
+    g_ptr_array_free (pl_info->ring_record_info, TRUE);
+    pl_info->ring_record_info = NULL;
+  }
 }
 
-gint
-send_socket_message (gint sock, GstPayloadInfo * pl_info)
+// Drop the references to payloads owned by someone else (e.g. an arena).
+// The pointer arrays must have been created without element free function.
+void
+release_pl_struct (GstPayloadInfo * pl_info)
 {
-  struct cmsghdr *cmsg = NULL;
-  GPtrArray * send_arr = g_ptr_array_new ();
-  struct msghdr msg = {0};
-  gchar buf[CMSG_SPACE (sizeof (*pl_info->fds) * GST_PL_INFO_GET_N_FDS (pl_info))];
+  if (pl_info->mem_block_info != NULL)
+    g_ptr_array_set_size (pl_info->mem_block_info, 0);
 
-  uint32_t payload_len = 0, msg_len_net;
-  gint data_size = 0;
+  if (pl_info->protection_metadata_info != NULL)
+    g_ptr_array_set_size (pl_info->protection_metadata_info, 0);
 
-  memset (buf, 0, sizeof (buf));
+  if (pl_info->roi_meta_info != NULL)
+    g_ptr_array_set_size (pl_info->roi_meta_info, 0);
 
-  if (pl_info->fd_count != NULL)
-    g_ptr_array_add (send_arr, pl_info->fd_count);
+  if (pl_info->class_meta_info != NULL)
+    g_ptr_array_set_size (pl_info->class_meta_info, 0);
 
-  if (pl_info->buffer_info != NULL)
-    g_ptr_array_add (send_arr, pl_info->buffer_info);
+  if (pl_info->lm_meta_info != NULL)
+    g_ptr_array_set_size (pl_info->lm_meta_info, 0);
 
-  if (pl_info->message != NULL)
-    g_ptr_array_add (send_arr, pl_info->message);
+  if (pl_info->ring_record_info != NULL)
+    g_ptr_array_set_size (pl_info->ring_record_info, 0);
 
-  if (pl_info->return_buffer != NULL)
-    g_ptr_array_add (send_arr, pl_info->return_buffer);
+  pl_info->message = NULL;
+  pl_info->subscribe = NULL;
+  pl_info->ring_setup = NULL;
+  pl_info->buffer_info = NULL;
+  pl_info->return_buffer = NULL;
+  pl_info->fd_count = NULL;
+  pl_info->fds = NULL;
+}
 
-  if (pl_info->mem_block_info != NULL) {
-    for (guint i = 0; i < pl_info->mem_block_info->len; i++) {
-      g_ptr_array_add (send_arr, g_ptr_array_index (pl_info->mem_block_info, i));
-    }
-  }
+static guint
+collect_payload_array (GPtrArray * array, struct iovec * io, guint index)
+{
+  if (array == NULL)
+    return 0;
 
-  if (pl_info->protection_metadata_info != NULL) {
-    for (guint i = 0; i < pl_info->protection_metadata_info->len; i++) {
-      g_ptr_array_add (send_arr, g_ptr_array_index (pl_info->protection_metadata_info, i));
-    }
+  for (guint i = 0; (io != NULL) && (i < array->len); i++) {
+    io[index + i].iov_base = g_ptr_array_index (array, i);
+    io[index + i].iov_len = get_payload_size (io[index + i].iov_base);
   }
 
-  if (pl_info->roi_meta_info != NULL) {
-    for (guint i = 0; i < pl_info->roi_meta_info->len; i++) {
-      g_ptr_array_add (send_arr, g_ptr_array_index (pl_info->roi_meta_info, i));
-    }
-  }
+  return array->len;
+}
 
-  if (pl_info->class_meta_info != NULL) {
-    for (guint i = 0; i < pl_info->class_meta_info->len; i++) {
-      g_ptr_array_add (send_arr, g_ptr_array_index (pl_info->class_meta_info, i));
+// Fill the IO vector with the payloads of the message in their wire order.
+// When io is NULL only the number of payloads is returned.
+static guint
+collect_payloads (GstPayloadInfo * pl_info, struct iovec * io)
+{
+  gpointer singles[] = { pl_info->fd_count, pl_info->buffer_info,
+      pl_info->message, pl_info->return_buffer, pl_info->subscribe,
+      pl_info->ring_setup };
+  guint n_payloads = 0;
+
+  for (guint i = 0; i < G_N_ELEMENTS (singles); i++) {
+    if (singles[i] == NULL)
+      continue;
+
+    if (io != NULL) {
+      io[n_payloads].iov_base = singles[i];
+      io[n_payloads].iov_len = get_payload_size (singles[i]);
     }
-  }
 
-  if (pl_info->lm_meta_info != NULL) {
-    for (guint i = 0; i < pl_info->lm_meta_info->len; i++) {
-      g_ptr_array_add (send_arr, g_ptr_array_index (pl_info->lm_meta_info, i));
-    }
+    n_payloads++;
   }
 
-  struct iovec io[send_arr->len];
+  n_payloads += collect_payload_array (pl_info->mem_block_info, io, n_payloads);
+  n_payloads += collect_payload_array (
+      pl_info->protection_metadata_info, io, n_payloads);
+  n_payloads += collect_payload_array (pl_info->roi_meta_info, io, n_payloads);
+  n_payloads += collect_payload_array (pl_info->class_meta_info, io, n_payloads);
+  n_payloads += collect_payload_array (pl_info->lm_meta_info, io, n_payloads);
+  n_payloads += collect_payload_array (
+      pl_info->ring_record_info, io, n_payloads);
 
-  for (guint i = 0; i < send_arr->len; i++) {
-    gpointer ptr = g_ptr_array_index (send_arr, i);
+  return n_payloads;
+}
 
-    GST_DEBUG ("Sending payload with msg_id: %d and size %d",
-        GST_SOCKET_MSG_IDENTITY (ptr), get_payload_size (ptr));
+gint
+send_socket_message (gint sock, GstPayloadInfo * pl_info)
+{
+  return send_socket_messages (sock, &pl_info, 1);
+}
 
-    io[i].iov_base = ptr;
-    io[i].iov_len = get_payload_size (ptr);
-    payload_len += io[i].iov_len;
-  }
+// Every message goes out as two records, the length prefix and the payloads.
+// All records of all messages are handed to the kernel with one sendmmsg.
+gint
+send_socket_messages (gint sock, GstPayloadInfo ** pl_infos, guint n_infos)
+{
+  guint n_payloads = 0, n_msgs = n_infos * 2, n_sent = 0, idx = 0;
+
+  g_return_val_if_fail (n_infos > 0, -1);
+
+  for (guint i = 0; i < n_infos; i++)
+    n_payloads += collect_payloads (pl_infos[i], NULL);
+
+  struct iovec io[n_payloads + n_infos];
+  struct mmsghdr msgs[n_msgs];
+  uint32_t msg_len_net[n_infos];
+  union {
+    struct cmsghdr hdr;
+    gchar buf[CMSG_SPACE (sizeof (gint) * GST_MAX_MEM_BLOCKS)];
+  } control[n_infos];
+
+  memset (msgs, 0, sizeof (msgs));
+  memset (control, 0, sizeof (control));
+
+  for (guint i = 0; i < n_infos; i++) {
+    GstPayloadInfo *pl_info = pl_infos[i];
+    struct msghdr *prefix = &msgs[i * 2].msg_hdr;
+    struct msghdr *msg = &msgs[i * 2 + 1].msg_hdr;
+    uint32_t payload_len = 0;
+    guint n_fds = 0, n = 0;
+
+    n = collect_payloads (pl_info, &io[idx + 1]);
+
+    for (guint j = 0; j < n; j++) {
+      GST_DEBUG ("Sending payload with msg_id: %d and size %zu",
+          GST_SOCKET_MSG_IDENTITY (io[idx + 1 + j].iov_base),
+          io[idx + 1 + j].iov_len);
+      payload_len += io[idx + 1 + j].iov_len;
+    }
 
-  msg.msg_name = NULL;
-  msg.msg_namelen = 0;
+    // Send the message length first as prefix
+    // Convert to network byte order, for compatibility with different host env
+    msg_len_net[i] = htonl (payload_len);
+    io[idx].iov_base = &msg_len_net[i];
+    io[idx].iov_len = sizeof (msg_len_net[i]);
 
-  msg.msg_iov = io;
-  msg.msg_iovlen = send_arr->len;
-
-  if (pl_info->fds != NULL && pl_info->fd_count != NULL &&
-      GST_PL_INFO_GET_N_FDS (pl_info) > 0) {
-    msg.msg_control = buf;
-    msg.msg_controllen = sizeof (buf);
-    cmsg = CMSG_FIRSTHDR (&msg);
-    cmsg->cmsg_level = SOL_SOCKET;
-    cmsg->cmsg_type = SCM_RIGHTS;
-    cmsg->cmsg_len = CMSG_LEN (
-        (sizeof (*pl_info->fds)) * (GST_PL_INFO_GET_N_FDS (pl_info)));
-    msg.msg_controllen = cmsg->cmsg_len;
-
-    memmove (CMSG_DATA (cmsg), pl_info->fds, cmsg->cmsg_len);
-  }
+    prefix->msg_iov = &io[idx];
+    prefix->msg_iovlen = 1;
 
-  // Send the message length first as prefix
-  // Convert to network byte order, for compatibility with different host env
-  msg_len_net = htonl (payload_len);
-  data_size = send (sock, &msg_len_net, sizeof (msg_len_net), 0);
-  if (data_size != sizeof (msg_len_net)) {
-    GST_ERROR ("Failed to send message length");
-    return data_size;
-  }
+    msg->msg_iov = &io[idx + 1];
+    msg->msg_iovlen = n;
 
-  errno = 0;
-  data_size = sendmsg (sock, &msg, 0);
+    n_fds = MIN (GST_PL_INFO_GET_N_FDS (pl_info), GST_MAX_MEM_BLOCKS);
 
-  return data_size;
-}
+    if (pl_info->fds != NULL && n_fds > 0) {
+      struct cmsghdr *cmsg = NULL;
 
-gint
-receive_socket_message (gint sock, GstPayloadInfo * pl_info, int msg_flags)
-{
-  struct msghdr msg = {0};
-  struct iovec io;
-  g_autofree gchar *io_buf = NULL;
-  gchar buf[CMSG_SPACE (sizeof (*pl_info->fds) * GST_MAX_MEM_BLOCKS)] = {0};
-  ssize_t recv_len;
-  uint32_t msg_len_net, msg_len;
+      msg->msg_control = control[i].buf;
+      msg->msg_controllen = CMSG_SPACE (sizeof (*pl_info->fds) * n_fds);
 
-  recv_len = recv (sock, &msg_len_net, sizeof (msg_len_net), msg_flags | MSG_WAITALL);
-  if (recv_len != sizeof (msg_len_net)) {
-      GST_ERROR ("Failed to read message length, returned %zd", recv_len);
-      return recv_len;
-  }
+      cmsg = CMSG_FIRSTHDR (msg);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN (sizeof (*pl_info->fds) * n_fds);
 
-  // Convert to host byte order
-  msg_len = ntohl (msg_len_net);
+      memmove (CMSG_DATA (cmsg), pl_info->fds, sizeof (*pl_info->fds) * n_fds);
+    }
 
-  // Allocate buffer for the full message
-  io_buf = g_malloc (msg_len);
-  if (!io_buf) {
-      GST_ERROR ("Failed to allocate buffer %s", strerror (errno));
-      return -1;
+    idx += n + 1;
   }
 
-  io.iov_base = io_buf;
-  io.iov_len = msg_len;
+  while (n_sent < n_msgs) {
+    gint ret = 0;
 
-  msg.msg_name = NULL;
-  msg.msg_namelen = 0;
+    errno = 0;
+    ret = sendmmsg (sock, &msgs[n_sent], n_msgs - n_sent, 0);
 
-  msg.msg_iov = &io;
-  msg.msg_iovlen = 1;
+    if (ret < 0 && errno == EINTR)
+      continue;
 
-  msg.msg_control = buf;
-  msg.msg_controllen = sizeof (buf);
+    if (ret <= 0) {
+      GST_ERROR ("Failed to send %u messages, sent %u records: %s",
+          n_infos, n_sent, strerror (errno));
+      return -1;
+    }
 
-  errno = 0;
-  recv_len = recvmsg (sock, &msg, msg_flags | MSG_WAITALL);
+    n_sent += ret;
+  }
 
-  if (recv_len < 0)
-    return recv_len;
+  return n_infos;
+}
 
-  for (ssize_t offset = 0; offset < recv_len; ) {
+void
+parse_socket_payloads (gchar * data, gssize length, GstPayloadInfo * pl_info)
+{
+  for (gssize offset = 0; offset < length; ) {
     gpointer payload;
-    gpointer iterator = io_buf + offset;
+    gpointer iterator = data + offset;
     gint size = get_payload_size (iterator);
 
-    if (size == -1) {
+    if (size == -1 || (offset + size) > length) {
       break;
     }
 
@@ -252,39 +304,122 @@ receive_socket_message (gint sock, GstPayloadInfo * pl_info, int msg_flags)
       case MESSAGE_EOS:
       case MESSAGE_DISCONNECT:
         pl_info->message = (GstMessagePayload *) payload;
+        payload = NULL;
+        break;
+      case MESSAGE_SUBSCRIBE:
+        pl_info->subscribe = (GstSubscribePayload *) payload;
+        payload = NULL;
+        break;
+      case MESSAGE_RING_SETUP:
+        pl_info->ring_setup = (GstRingSetupPayload *) payload;
+        payload = NULL;
+        break;
+      case MESSAGE_RING_RECORD:
+        if (pl_info->ring_record_info != NULL) {
+          g_ptr_array_add (pl_info->ring_record_info, payload);
+          payload = NULL;
+        }
         break;
       case MESSAGE_BUFFER_INFO:
         pl_info->buffer_info = (GstBufferPayload *) payload;
+        payload = NULL;
         break;
       case MESSAGE_FRAME:
       case MESSAGE_TENSOR:
       case MESSAGE_TEXT:
-        g_ptr_array_add (pl_info->mem_block_info, payload);
+        if (pl_info->mem_block_info != NULL) {
+          g_ptr_array_add (pl_info->mem_block_info, payload);
+          payload = NULL;
+        }
         break;
       case MESSAGE_RETURN_BUFFER:
         pl_info->return_buffer = (GstReturnBufferPayload *) payload;
+        payload = NULL;
         break;
       case MESSAGE_FD_COUNT:
         pl_info->fd_count = (GstFdCountPayload *) payload;
+        payload = NULL;
         break;
       case MESSAGE_PROTECTION_META:
-        g_ptr_array_add (pl_info->protection_metadata_info, payload);
+        if (pl_info->protection_metadata_info != NULL) {
+          g_ptr_array_add (pl_info->protection_metadata_info, payload);
+          payload = NULL;
+        }
         break;
       case MESSAGE_VIDEO_ROI_META:
-        g_ptr_array_add (pl_info->roi_meta_info, payload);
+        if (pl_info->roi_meta_info != NULL) {
+          g_ptr_array_add (pl_info->roi_meta_info, payload);
+          payload = NULL;
+        }
         break;
       case MESSAGE_VIDEO_CLASS_META:
-        g_ptr_array_add (pl_info->class_meta_info, payload);
+        if (pl_info->class_meta_info != NULL) {
+          g_ptr_array_add (pl_info->class_meta_info, payload);
+          payload = NULL;
+        }
         break;
       case MESSAGE_VIDEO_LM_META:
-        g_ptr_array_add (pl_info->lm_meta_info, payload);
+        if (pl_info->lm_meta_info != NULL) {
+          g_ptr_array_add (pl_info->lm_meta_info, payload);
+          payload = NULL;
+        }
         break;
       default:
         break;
     }
 
+    // Payload was not claimed by the message info.
+    free (payload);
+
     offset += size;
   }
+}
+
+gint
+receive_socket_message (gint sock, GstPayloadInfo * pl_info, int msg_flags)
+{
+  struct msghdr msg = {0};
+  struct iovec io;
+  g_autofree gchar *io_buf = NULL;
+  gchar buf[CMSG_SPACE (sizeof (*pl_info->fds) * GST_MAX_MEM_BLOCKS)] = {0};
+  ssize_t recv_len;
+  uint32_t msg_len_net, msg_len;
+
+  recv_len = recv (sock, &msg_len_net, sizeof (msg_len_net), msg_flags | MSG_WAITALL);
+  if (recv_len != sizeof (msg_len_net)) {
+      GST_ERROR ("Failed to read message length, returned %zd", recv_len);
+      return recv_len;
+  }
+
+  // Convert to host byte order
+  msg_len = ntohl (msg_len_net);
+
+  // Allocate buffer for the full message
+  io_buf = g_malloc (msg_len);
+  if (!io_buf) {
+      GST_ERROR ("Failed to allocate buffer %s", strerror (errno));
+      return -1;
+  }
+
+  io.iov_base = io_buf;
+  io.iov_len = msg_len;
+
+  msg.msg_name = NULL;
+  msg.msg_namelen = 0;
+
+  msg.msg_iov = &io;
+  msg.msg_iovlen = 1;
+
+  msg.msg_control = buf;
+  msg.msg_controllen = sizeof (buf);
+
+  errno = 0;
+  recv_len = recvmsg (sock, &msg, msg_flags | MSG_WAITALL);
+
+  if (recv_len < 0)
+    return recv_len;
+
+  parse_socket_payloads (io_buf, recv_len, pl_info);
 
   if ((pl_info->fds != NULL) && (pl_info->fd_count != NULL) &&
       (GST_PL_INFO_GET_N_FDS (pl_info) > 0)) {
@@ -299,6 +434,80 @@ receive_socket_message (gint sock, GstPayloadInfo * pl_info, int msg_flags)
   return recv_len;
 }
 
+// Drain up to n_infos already queued control messages with one recvmmsg.
+// Only for small messages without file descriptors (returns, subscriptions,
+// disconnects). Returns the number of filled message infos.
+gint
+receive_socket_messages (gint sock, GstPayloadInfo * pl_infos, guint n_infos)
+{
+  guint32 records[GST_MAX_BATCH_MESSAGES * 2][GST_MAX_SMALL_MESSAGE_SIZE / 4];
+  guint32 tail[GST_MAX_SMALL_MESSAGE_SIZE / 4];
+  struct mmsghdr msgs[GST_MAX_BATCH_MESSAGES * 2];
+  struct iovec io[GST_MAX_BATCH_MESSAGES * 2];
+  guint n_records = MIN (n_infos, GST_MAX_BATCH_MESSAGES) * 2, n_parsed = 0;
+  gint n_recv = 0, idx = 0;
+
+  memset (msgs, 0, sizeof (msgs));
+
+  for (guint i = 0; i < n_records; i++) {
+    io[i].iov_base = records[i];
+    io[i].iov_len = sizeof (records[i]);
+
+    msgs[i].msg_hdr.msg_iov = &io[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  errno = 0;
+  n_recv = recvmmsg (sock, msgs, n_records, MSG_DONTWAIT, NULL);
+
+  if (n_recv < 0)
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+
+  while (idx < n_recv) {
+    gchar *payloads = NULL;
+    gssize length = 0;
+    uint32_t msg_len = 0;
+
+    if (msgs[idx].msg_len != sizeof (uint32_t)) {
+      GST_WARNING ("Expected message length prefix, got %u bytes",
+          msgs[idx].msg_len);
+      idx++;
+      continue;
+    }
+
+    msg_len = ntohl (records[idx][0]);
+
+    if (msg_len > GST_MAX_SMALL_MESSAGE_SIZE) {
+      GST_ERROR ("Message of %u bytes is too large for batched receive",
+          msg_len);
+      return -1;
+    }
+
+    if ((idx + 1) < n_recv) {
+      payloads = (gchar *) records[idx + 1];
+      length = msgs[idx + 1].msg_len;
+
+      if (msgs[idx + 1].msg_hdr.msg_flags & MSG_TRUNC) {
+        GST_ERROR ("Truncated message of %u bytes", msg_len);
+        return -1;
+      }
+    } else {
+      // The sender queued the prefix but not yet the payloads, wait for them.
+      length = recv (sock, tail, sizeof (tail), MSG_WAITALL);
+
+      if (length < 0)
+        return -1;
+
+      payloads = (gchar *) tail;
+    }
+
+    parse_socket_payloads (payloads, length, &pl_infos[n_parsed++]);
+    idx += 2;
+  }
+
+  return n_parsed;
+}
+
 gint
 get_payload_size (gpointer payload) {
   switch (GST_SOCKET_MSG_IDENTITY (payload)) {
@@ -338,8 +547,78 @@ get_payload_size (gpointer payload) {
     case MESSAGE_VIDEO_LM_META:
       return sizeof (GstVideoLmMetaPayload);
       break;
+    case MESSAGE_SUBSCRIBE:
+      return sizeof (GstSubscribePayload);
+      break;
+    case MESSAGE_RING_SETUP:
+      return sizeof (GstRingSetupPayload);
+      break;
+    case MESSAGE_RING_RECORD:
+      return sizeof (GstRingRecordPayload);
+      break;
 
     default:
       return -1;
   }
 }
+
+void
+payload_arena_init (GstPayloadArena * arena, gsize size)
+{
+  arena->data = g_malloc (size);
+  arena->size = size;
+  arena->offset = 0;
+  arena->overflow = NULL;
+}
+
+gpointer
+payload_arena_alloc (GstPayloadArena * arena, gsize size)
+{
+  gsize offset = GST_ROUND_UP_8 (arena->offset);
+  gpointer payload = NULL;
+
+  if ((offset + size) <= arena->size) {
+    payload = arena->data + offset;
+  } else {
+    payload = g_malloc (size);
+    arena->overflow = g_slist_prepend (arena->overflow, payload);
+  }
+
+  // Offset keeps growing on overflow, it is the new size on the next reset.
+  arena->offset = offset + size;
+  return payload;
+}
+
+void
+payload_arena_reset (GstPayloadArena * arena)
+{
+  if (arena->overflow != NULL) {
+    g_slist_free_full (arena->overflow, g_free);
+    arena->overflow = NULL;
+  }
+
+  if (arena->offset > arena->size) {
+    GST_DEBUG ("Growing payload arena from %" G_GSIZE_FORMAT " to %"
+        G_GSIZE_FORMAT " bytes", arena->size, arena->offset);
+
+    g_free (arena->data);
+    arena->data = g_malloc (arena->offset);
+    arena->size = arena->offset;
+  }
+
+  arena->offset = 0;
+}
+
+void
+payload_arena_clear (GstPayloadArena * arena)
+{
+  if (arena->overflow != NULL) {
+    g_slist_free_full (arena->overflow, g_free);
+    arena->overflow = NULL;
+  }
+
+  g_free (arena->data);
+  arena->data = NULL;
+  arena->size = 0;
+  arena->offset = 0;
+}
@@ -59,6 +59,8 @@
     (socket->mode == DATA_MODE_TEXT || socket->mode == DATA_MODE_VIDEO ? 1 : 0))
 
 #define GST_MAX_MEM_BLOCKS 10
+#define GST_MAX_BATCH_MESSAGES 32
+#define GST_MAX_SMALL_MESSAGE_SIZE 256
 #define GST_SERIALIZED_QUARK_MAX_SIZE 32
 #define GST_SERIALIZED_STRUCUTRE_MAX_SZIE 256
 #define GST_MAX_LABELS 32
@@ -87,6 +89,10 @@ typedef struct _GstVideoKeypointLinkSer GstVideoKeypointLinkSer;
 typedef struct _GstVideoRoiMetaPayload GstVideoRoiMetaPayload;
 typedef struct _GstVideoClassMetaPayload GstVideoClassMetaPayload;
 typedef struct _GstVideoLmMetaPayload GstVideoLmMetaPayload;
+typedef struct _GstSubscribePayload GstSubscribePayload;
+typedef struct _GstRingSetupPayload GstRingSetupPayload;
+typedef struct _GstRingRecordPayload GstRingRecordPayload;
+typedef struct _GstPayloadArena GstPayloadArena;
 
 struct __attribute__((packed, aligned(4))) _GstMessagePayload {
   guint32 identity; // Message identity / type
@@ -220,13 +226,48 @@ struct __attribute__((packed, aligned(4))) _GstVideoLmMetaPayload {
   gsize xtraparams_size;
 };
 
+// Sent by a consumer right after it connects to a sink in server mode.
+// interval is the minimum PTS distance between two delivered buffers,
+// 0 means every buffer is delivered.
+struct __attribute__((packed, aligned(4))) _GstSubscribePayload {
+  guint32 identity; // Message identity / type
+  guint64 interval;
+};
+
+// Offered by the sink with the memfd of its shared memory ring attached,
+// and echoed back by a consumer which mapped the ring.
+struct __attribute__((packed, aligned(4))) _GstRingSetupPayload {
+  guint32 identity; // Message identity / type
+  guint64 capacity;
+};
+
+// Contents of a shared memory ring record.
+typedef enum {
+  RING_CONTENTS_TEXT,     // Raw bytes of a text memory block.
+  RING_CONTENTS_PAYLOADS  // Serialized protection/ROI/class/landmarks payloads.
+} GstRingContents;
+
+// Describes a record in the shared memory ring instead of carrying it.
+struct __attribute__((packed, aligned(4))) _GstRingRecordPayload {
+  guint32 identity; // Message identity / type
+  guint32 contents;
+  guint64 seq;
+  guint64 position;
+  guint64 size;
+};
+
 // Struct used to pass info to send and receive functions.
 // message carries a message (EOS/DISCONNECT).
 // buffer_info is the buffer description (BUFFER).
 // return_buffer carries the id of the return buffer (RETURN_BUFFER).
 // mem_block_info carries fd/non-fd memory info (FRAME/TENSOR/TEXT).
+// subscribe carries the consumer delivery parameters (SUBSCRIBE).
+// ring_setup carries the shared memory ring offer or its ack (RING_SETUP).
+// ring_record_info describes records in the shared memory ring (RING_RECORD).
 struct __attribute__((packed, aligned(4))) _GstPayloadInfo {
   GstMessagePayload *      message;
+  GstSubscribePayload *    subscribe;
+  GstRingSetupPayload *    ring_setup;
   GstBufferPayload *       buffer_info;
   GstReturnBufferPayload * return_buffer;
   GstFdCountPayload *      fd_count;
@@ -236,6 +277,7 @@ struct __attribute__((packed, aligned(4))) _GstPayloadInfo {
   GPtrArray *              roi_meta_info;
   GPtrArray *              class_meta_info;
   GPtrArray *              lm_meta_info;
+  GPtrArray *              ring_record_info;
 };
 
 // List of message identities
@@ -252,15 +294,46 @@ enum
   MESSAGE_PROTECTION_META, //8
   MESSAGE_VIDEO_ROI_META,  //9
   MESSAGE_VIDEO_CLASS_META,//10
-  MESSAGE_VIDEO_LM_META    //11
+  MESSAGE_VIDEO_LM_META,   //11
+  MESSAGE_SUBSCRIBE,       //12
+  MESSAGE_RING_SETUP,      //13
+  MESSAGE_RING_RECORD      //14
+};
+
+// Bump allocator for the payloads of outgoing messages.
+// Allocations stay valid until the next payload_arena_reset(). Requests which
+// do not fit are served from the heap and the arena is grown on reset, so
+// after a few buffers the steady state does not allocate at all.
+struct _GstPayloadArena {
+  guint8 *data;
+  gsize  size;
+  gsize  offset;
+  GSList *overflow;
 };
 
 void
 free_pl_struct (GstPayloadInfo * pl_info);
+void
+release_pl_struct (GstPayloadInfo * pl_info);
 gint
 send_socket_message (gint sock, GstPayloadInfo * pl_info);
 gint
+send_socket_messages (gint sock, GstPayloadInfo ** pl_infos, guint n_infos);
+gint
 receive_socket_message (gint sock, GstPayloadInfo * pl_info, int msg_flags);
 gint
+receive_socket_messages (gint sock, GstPayloadInfo * pl_infos, guint n_infos);
+gint
 get_payload_size (gpointer payload);
+void
+parse_socket_payloads (gchar * data, gssize length, GstPayloadInfo * pl_info);
+
+void
+payload_arena_init (GstPayloadArena * arena, gsize size);
+gpointer
+payload_arena_alloc (GstPayloadArena * arena, gsize size);
+void
+payload_arena_reset (GstPayloadArena * arena);
+void
+payload_arena_clear (GstPayloadArena * arena);
 #endif  // __GST_QTI_SOCKET_H__
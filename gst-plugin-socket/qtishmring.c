@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "qtishmring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define SHM_RING_MAGIC   0x52494e47 // 'RING'
+#define SHM_RING_VERSION 1
+
+// Largest record as a fraction of the capacity, leaves slack to the consumers.
+#define SHM_RING_MAX_RECORD_DIVISOR 4
+
+typedef struct _GstShmRingHeader GstShmRingHeader;
+typedef struct _GstShmRecordHeader GstShmRecordHeader;
+
+// Lives at the start of the shared memory, followed by the records area.
+struct _GstShmRingHeader {
+  guint32 magic;
+  guint32 version;
+  guint64 capacity;
+
+  // Absolute position up to which the producer may be writing.
+  guint64 reserved;
+  // Absolute position up to which all records are complete.
+  guint64 committed;
+} __attribute__((aligned(64)));
+
+struct _GstShmRecordHeader {
+  guint64 seq;
+  guint64 size;
+};
+
+struct _GstShmRing {
+  gint             fd;
+  gsize            capacity;
+
+  GstShmRingHeader *header;
+  guint8           *records;
+
+  // Producer only, sequence number of the next record.
+  guint64          seq;
+};
+
+static GstShmRing *
+shm_ring_map (gint fd, gsize capacity, gboolean writable)
+{
+  GstShmRing *ring = NULL;
+  gpointer data = NULL;
+  gint prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+
+  data = mmap (NULL, sizeof (GstShmRingHeader) + capacity, prot, MAP_SHARED,
+      fd, 0);
+
+  if (data == MAP_FAILED) {
+    GST_ERROR ("Failed to map ring of %" G_GSIZE_FORMAT " bytes: %s",
+        capacity, strerror (errno));
+    return NULL;
+  }
+
+  ring = g_new0 (GstShmRing, 1);
+
+  ring->fd = fd;
+  ring->capacity = capacity;
+  ring->header = (GstShmRingHeader *) data;
+  ring->records = (guint8 *) data + sizeof (GstShmRingHeader);
+  ring->seq = 1;
+
+  return ring;
+}
+
+GstShmRing *
+shm_ring_new (gsize capacity)
+{
+  GstShmRing *ring = NULL;
+  gint fd = -1;
+
+  capacity = GST_ROUND_UP_8 (capacity);
+
+  fd = memfd_create ("qtisocketring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    GST_ERROR ("Failed to create memfd: %s", strerror (errno));
+    return NULL;
+  }
+
+  if (ftruncate (fd, sizeof (GstShmRingHeader) + capacity) < 0) {
+    GST_ERROR ("Failed to resize memfd: %s", strerror (errno));
+    close (fd);
+    return NULL;
+  }
+
+  // Consumers map the ring as well, it must not shrink under them.
+  if (fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) < 0)
+    GST_WARNING ("Failed to seal memfd: %s", strerror (errno));
+
+  if ((ring = shm_ring_map (fd, capacity, TRUE)) == NULL) {
+    close (fd);
+    return NULL;
+  }
+
+  ring->header->magic = SHM_RING_MAGIC;
+  ring->header->version = SHM_RING_VERSION;
+  ring->header->capacity = capacity;
+
+  __atomic_store_n (&ring->header->reserved, 0, __ATOMIC_SEQ_CST);
+  __atomic_store_n (&ring->header->committed, 0, __ATOMIC_SEQ_CST);
+
+  GST_DEBUG ("Created ring of %" G_GSIZE_FORMAT " bytes, fd %d", capacity, fd);
+  return ring;
+}
+
+GstShmRing *
+shm_ring_import (gint fd, gsize capacity)
+{
+  GstShmRing *ring = NULL;
+
+  if ((ring = shm_ring_map (fd, capacity, FALSE)) == NULL) {
+    close (fd);
+    return NULL;
+  }
+
+  if (ring->header->magic != SHM_RING_MAGIC ||
+      ring->header->version != SHM_RING_VERSION ||
+      ring->header->capacity != capacity) {
+    GST_ERROR ("Invalid ring header, magic 0x%x version %u capacity %"
+        G_GUINT64_FORMAT, ring->header->magic, ring->header->version,
+        ring->header->capacity);
+    shm_ring_free (ring);
+    return NULL;
+  }
+
+  GST_DEBUG ("Imported ring of %" G_GSIZE_FORMAT " bytes, fd %d", capacity, fd);
+  return ring;
+}
+
+void
+shm_ring_free (GstShmRing * ring)
+{
+  munmap (ring->header, sizeof (GstShmRingHeader) + ring->capacity);
+  close (ring->fd);
+
+  g_free (ring);
+}
+
+gint
+shm_ring_get_fd (GstShmRing * ring)
+{
+  return ring->fd;
+}
+
+gsize
+shm_ring_get_capacity (GstShmRing * ring)
+{
+  return ring->capacity;
+}
+
+// Reserve a contiguous record of the given size for writing.
+// Returns NULL if the record is too large for the ring.
+gpointer
+shm_ring_reserve (GstShmRing * ring, gsize size, guint64 * seq,
+    guint64 * position)
+{
+  GstShmRecordHeader *record = NULL;
+  guint64 start = 0, offset = 0;
+  gsize length = GST_ROUND_UP_8 (sizeof (GstShmRecordHeader) + size);
+
+  if (length > (ring->capacity / SHM_RING_MAX_RECORD_DIVISOR))
+    return NULL;
+
+  start = __atomic_load_n (&ring->header->reserved, __ATOMIC_RELAXED);
+  offset = start % ring->capacity;
+
+  // Records are never split, skip the tail of the ring if it is too short.
+  if ((offset + length) > ring->capacity)
+    start += ring->capacity - offset;
+
+  // Publish the new frontier before any byte of the old records is touched.
+  __atomic_store_n (&ring->header->reserved, start + length, __ATOMIC_SEQ_CST);
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+  record = (GstShmRecordHeader *) (ring->records + (start % ring->capacity));
+  record->seq = ring->seq;
+  record->size = size;
+
+  *seq = ring->seq++;
+  *position = start;
+
+  return (guint8 *) record + sizeof (GstShmRecordHeader);
+}
+
+void
+shm_ring_commit (GstShmRing * ring, guint64 position)
+{
+  GstShmRecordHeader *record =
+      (GstShmRecordHeader *) (ring->records + (position % ring->capacity));
+
+  __atomic_store_n (&ring->header->committed,
+      position + GST_ROUND_UP_8 (sizeof (GstShmRecordHeader) + record->size),
+      __ATOMIC_RELEASE);
+}
+
+// Copy a record out of the ring.
+// Returns FALSE if the record was already overwritten by the producer.
+gboolean
+shm_ring_read (GstShmRing * ring, guint64 seq, guint64 position, gsize size,
+    gpointer data)
+{
+  GstShmRecordHeader record;
+  guint64 committed = 0, reserved = 0;
+  guint8 *source = ring->records + (position % ring->capacity);
+
+  committed = __atomic_load_n (&ring->header->committed, __ATOMIC_ACQUIRE);
+
+  if ((position + sizeof (GstShmRecordHeader) + size) > committed) {
+    GST_WARNING ("Record %" G_GUINT64_FORMAT " is not committed", seq);
+    return FALSE;
+  }
+
+  if (((position % ring->capacity) + sizeof (GstShmRecordHeader) + size) >
+          ring->capacity) {
+    GST_WARNING ("Record %" G_GUINT64_FORMAT " is out of bounds", seq);
+    return FALSE;
+  }
+
+  memcpy (&record, source, sizeof (GstShmRecordHeader));
+  memcpy (data, source + sizeof (GstShmRecordHeader), size);
+
+  // The copies above must complete before the frontier is checked.
+  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+  reserved = __atomic_load_n (&ring->header->reserved, __ATOMIC_RELAXED);
+
+  if (reserved > (position + ring->capacity)) {
+    GST_WARNING ("Record %" G_GUINT64_FORMAT " was overwritten", seq);
+    return FALSE;
+  }
+
+  if (record.seq != seq || record.size != size) {
+    GST_WARNING ("Record mismatch, expected %" G_GUINT64_FORMAT " of %"
+        G_GSIZE_FORMAT " bytes, got %" G_GUINT64_FORMAT " of %"
+        G_GUINT64_FORMAT " bytes", seq, size, record.seq, record.size);
+    return FALSE;
+  }
+
+  return TRUE;
+}
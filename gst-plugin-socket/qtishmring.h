@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GST_QTI_SHM_RING_H__
+#define __GST_QTI_SHM_RING_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+// Shared memory ring carrying variable size records between one producer
+// (qtisocketsink) and any number of consumers (qtisocketsrc).
+//
+// The ring is backed by a memfd which is passed once over the socket when
+// the connection is established. Afterwards the socket carries only small
+// descriptors (sequence number, position and size) of the records.
+//
+// Positions are absolute and only grow, the byte offset in the ring is the
+// position modulo the capacity. The producer never waits for the consumers,
+// it publishes how far it has reserved before writing, and a consumer checks
+// after copying a record out that this frontier did not lap the record.
+typedef struct _GstShmRing GstShmRing;
+
+GstShmRing *
+shm_ring_new (gsize capacity);
+
+GstShmRing *
+shm_ring_import (gint fd, gsize capacity);
+
+void
+shm_ring_free (GstShmRing * ring);
+
+gint
+shm_ring_get_fd (GstShmRing * ring);
+
+gsize
+shm_ring_get_capacity (GstShmRing * ring);
+
+gpointer
+shm_ring_reserve (GstShmRing * ring, gsize size, guint64 * seq,
+    guint64 * position);
+
+void
+shm_ring_commit (GstShmRing * ring, guint64 position);
+
+gboolean
+shm_ring_read (GstShmRing * ring, guint64 seq, guint64 position, gsize size,
+    gpointer data);
+
+G_END_DECLS
+
+#endif // __GST_QTI_SHM_RING_H__
@@ -45,6 +45,7 @@
 #include <gst/video/video-utils.h>
 
 #include <errno.h>
+#include <sys/time.h>
 
 #define gst_socket_sink_parent_class parent_class
 G_DEFINE_TYPE (GstFdSocketSink, gst_socket_sink, GST_TYPE_BASE_SINK);
@@ -58,11 +59,29 @@ GST_DEBUG_CATEGORY_STATIC (gst_socket_sink_debug);
     "text/x-raw"
 
 #define POLL_TIMEOUT_MS 100000
+#define SERVER_POLL_TIMEOUT_MS 100
+#define CONSUMER_SEND_TIMEOUT_MS 1000
+#define PAYLOAD_ARENA_SIZE (64 * 1024)
+
+#define MAX_CONSUMERS 64
+
+#define DEFAULT_PROP_MAX_CONSUMERS 0
+#define DEFAULT_PROP_BATCH_SIZE    1
+#define DEFAULT_PROP_BATCH_LATENCY (20 * GST_MSECOND)
+#define DEFAULT_PROP_SHM_RING_SIZE 0
+
+#define MIN_SHM_RING_SIZE (64 * 1024)
+
+#define MAX_SHM_RING_SIZE (256 * 1024 * 1024)
 
 enum
 {
   PROP_0,
-  PROP_SOCKET
+  PROP_SOCKET,
+  PROP_MAX_CONSUMERS,
+  PROP_BATCH_SIZE,
+  PROP_BATCH_LATENCY,
+  PROP_SHM_RING_SIZE,
 };
 
 static GstStaticPadTemplate socket_sink_template =
@@ -117,6 +136,18 @@ gst_socket_sink_set_property (GObject * object, guint prop_id,
     case PROP_SOCKET:
       gst_socket_sink_set_location (sink, g_value_get_string (value));
       break;
+    case PROP_MAX_CONSUMERS:
+      sink->max_consumers = g_value_get_uint (value);
+      break;
+    case PROP_BATCH_SIZE:
+      sink->batch_size = g_value_get_uint (value);
+      break;
+    case PROP_BATCH_LATENCY:
+      sink->batch_latency = g_value_get_uint64 (value);
+      break;
+    case PROP_SHM_RING_SIZE:
+      sink->ring_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -135,6 +166,18 @@ gst_socket_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_SOCKET:
       g_value_set_string (value, sink->sockfile);
       break;
+    case PROP_MAX_CONSUMERS:
+      g_value_set_uint (value, sink->max_consumers);
+      break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, sink->batch_size);
+      break;
+    case PROP_BATCH_LATENCY:
+      g_value_set_uint64 (value, sink->batch_latency);
+      break;
+    case PROP_SHM_RING_SIZE:
+      g_value_set_uint (value, sink->ring_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -142,6 +185,30 @@ gst_socket_sink_get_property (GObject * object, guint prop_id, GValue * value,
   GST_OBJECT_UNLOCK (sink);
 }
 
+static gboolean
+gst_socket_sink_offer_ring (GstFdSocketSink * sink, gint sock)
+{
+  GstPayloadInfo pl_info = {0};
+  GstRingSetupPayload setup = { .identity = MESSAGE_RING_SETUP };
+  GstFdCountPayload fd_count = { .identity = MESSAGE_FD_COUNT, .n_fds = 1 };
+  gint fd = shm_ring_get_fd (sink->ring);
+
+  setup.capacity = shm_ring_get_capacity (sink->ring);
+
+  pl_info.ring_setup = &setup;
+  pl_info.fd_count = &fd_count;
+  pl_info.fds = &fd;
+
+  if (send_socket_message (sock, &pl_info) < 0) {
+    GST_WARNING_OBJECT (sink, "Failed to offer shared memory ring");
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (sink, "Offered shared memory ring of %" G_GUINT64_FORMAT
+      " bytes", setup.capacity);
+  return TRUE;
+}
+
 static gboolean
 gst_socket_sink_try_connect (GstFdSocketSink * sink)
 {
@@ -173,6 +240,14 @@ gst_socket_sink_try_connect (GstFdSocketSink * sink)
     return FALSE;
   }
 
+  // Offer the ring before any buffer, the render does not send until connected.
+  if (sink->ring != NULL && !gst_socket_sink_offer_ring (sink, sink->socket)) {
+    close (sink->socket);
+    sink->socket = 0;
+    g_mutex_unlock (&sink->socklock);
+    return FALSE;
+  }
+
   g_mutex_unlock (&sink->socklock);
 
   g_atomic_int_set (&sink->connected, TRUE);
@@ -211,10 +286,11 @@ gst_socket_deinitialize_for_buffers (GstFdSocketSink * sink)
 }
 
 static GstVideoRoiMetaPayload*
-gst_socket_serialize_roi_meta (GstVideoRegionOfInterestMeta * roi_meta)
+gst_socket_serialize_roi_meta (GstPayloadArena * arena,
+    GstVideoRegionOfInterestMeta * roi_meta)
 {
   GstVideoRoiMetaPayload *roi_meta_pl =
-      g_malloc (sizeof (GstVideoRoiMetaPayload));
+      payload_arena_alloc (arena, sizeof (GstVideoRoiMetaPayload));
   const GstStructure *object_detection = NULL, *xtraparams = NULL;
   const gchar *label = NULL;
   gsize label_size = 0, label_maxsize = 0;
@@ -285,10 +361,11 @@ gst_socket_serialize_roi_meta (GstVideoRegionOfInterestMeta * roi_meta)
 }
 
 static GstVideoClassMetaPayload*
-gst_socket_serialize_class_meta (GstVideoClassificationMeta * class_meta)
+gst_socket_serialize_class_meta (GstPayloadArena * arena,
+    GstVideoClassificationMeta * class_meta)
 {
   GstVideoClassMetaPayload *class_meta_pl =
-      g_malloc (sizeof (GstVideoClassMetaPayload));
+      payload_arena_alloc (arena, sizeof (GstVideoClassMetaPayload));
   GArray *labels = NULL;
   gsize labels_maxsize = 0;
 
@@ -349,10 +426,11 @@ gst_socket_serialize_class_meta (GstVideoClassificationMeta * class_meta)
 }
 
 static GstVideoLmMetaPayload*
-gst_socket_serialize_lm_meta (GstVideoLandmarksMeta *lm_meta)
+gst_socket_serialize_lm_meta (GstPayloadArena * arena,
+    GstVideoLandmarksMeta *lm_meta)
 {
   GstVideoLmMetaPayload *lm_meta_pl =
-      g_malloc (sizeof (GstVideoLmMetaPayload));
+      payload_arena_alloc (arena, sizeof (GstVideoLmMetaPayload));
   GArray *kps = NULL, *links = NULL;
   gsize kps_maxsize = 0, links_maxsize = 0;
 
@@ -433,80 +511,160 @@ gst_socket_serialize_lm_meta (GstVideoLandmarksMeta *lm_meta)
   return lm_meta_pl;
 }
 
+static GstRingRecordPayload *
+gst_socket_sink_ring_reserve (GstFdSocketSink * sink, GstPayloadInfo * pl_info,
+    GstRingContents contents, gsize size, guint8 ** data)
+{
+  GstRingRecordPayload *record = NULL;
+  guint64 seq = 0, position = 0;
+
+  if ((*data = shm_ring_reserve (sink->ring, size, &seq, &position)) == NULL)
+    return NULL;
+
+  record = payload_arena_alloc (&sink->arena, sizeof (GstRingRecordPayload));
+
+  record->identity = MESSAGE_RING_RECORD;
+  record->contents = contents;
+  record->seq = seq;
+  record->position = position;
+  record->size = size;
+
+  g_ptr_array_add (pl_info->ring_record_info, record);
+  return record;
+}
+
+static gboolean
+gst_socket_sink_ring_write_memory (GstFdSocketSink * sink,
+    GstPayloadInfo * pl_info, GstMemory * memory)
+{
+  GstRingRecordPayload *record = NULL;
+  GstMapInfo map_info;
+  guint8 *data = NULL;
+
+  if (!gst_memory_map (memory, &map_info, GST_MAP_READ)) {
+    GST_ERROR_OBJECT (sink, "Failed to map text memory block");
+    return FALSE;
+  }
+
+  record = gst_socket_sink_ring_reserve (sink, pl_info, RING_CONTENTS_TEXT,
+      map_info.size, &data);
+
+  if (record != NULL) {
+    memcpy (data, map_info.data, map_info.size);
+    shm_ring_commit (sink->ring, record->position);
+  }
+
+  gst_memory_unmap (memory, &map_info);
+  return (record != NULL);
+}
+
+// Move the metadata payloads into one ring record, the message carries only
+// its descriptor. Payloads stay inline if they do not fit in the ring.
+static void
+gst_socket_sink_ring_write_payloads (GstFdSocketSink * sink,
+    GstPayloadInfo * pl_info)
+{
+  GPtrArray *arrays[] = { pl_info->protection_metadata_info,
+      pl_info->roi_meta_info, pl_info->class_meta_info, pl_info->lm_meta_info };
+  GstRingRecordPayload *record = NULL;
+  guint8 *data = NULL;
+  gsize size = 0, offset = 0;
+
+  for (guint i = 0; i < G_N_ELEMENTS (arrays); i++) {
+    for (guint j = 0; j < arrays[i]->len; j++)
+      size += get_payload_size (g_ptr_array_index (arrays[i], j));
+  }
+
+  if (size == 0)
+    return;
+
+  record = gst_socket_sink_ring_reserve (sink, pl_info, RING_CONTENTS_PAYLOADS,
+      size, &data);
+
+  if (record == NULL) {
+    GST_LOG_OBJECT (sink, "Metadata of %" G_GSIZE_FORMAT " bytes does not fit "
+        "in the ring, sending inline", size);
+    return;
+  }
+
+  for (guint i = 0; i < G_N_ELEMENTS (arrays); i++) {
+    for (guint j = 0; j < arrays[i]->len; j++) {
+      gpointer payload = g_ptr_array_index (arrays[i], j);
+      gint length = get_payload_size (payload);
+
+      memcpy (data + offset, payload, length);
+      offset += length;
+    }
+
+    g_ptr_array_set_size (arrays[i], 0);
+  }
+
+  shm_ring_commit (sink->ring, record->position);
+}
+
 static GstFlowReturn
-gst_socket_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
+gst_socket_sink_serialize_buffer (GstFdSocketSink * sink, GstBuffer * buffer,
+    GstPayloadInfo * pl_info, gint * memory_fds, guint * n_memory)
 {
-  GstFdSocketSink *sink = GST_SOCKET_SINK (bsink);
   GstBufferPayload * buffer_pl = NULL;
   GstMemory *memory = NULL;
   GstMeta *meta = NULL;
   gpointer state = NULL;
-  GstPayloadInfo pl_info = {0};
-  gint memory_fds[GST_MAX_MEM_BLOCKS]; // todo expand
-  gint memory_fds_send[GST_MAX_MEM_BLOCKS]; // todo expand
-  guint n_memory = 0;
-  gint n_memory_send = 0;
-
-  GST_DEBUG_OBJECT (sink, "gst_socket_sink_render %d", sink->mode);
 
-  g_mutex_lock (&sink->socklock);
-  if (!g_atomic_int_get (&sink->connected) ||
-       g_atomic_int_get (&sink->should_disconnect) ||
-       g_atomic_int_get (&sink->should_stop)) {
-    g_mutex_unlock (&sink->socklock);
-    return GST_FLOW_OK;
+  if (sink->mode != DATA_MODE_TEXT &&
+      sink->mode != DATA_MODE_TENSOR &&
+      sink->mode != DATA_MODE_VIDEO) {
+    GST_ERROR_OBJECT (sink, "Unsupported mode: %d", sink->mode);
+    return GST_FLOW_ERROR;
   }
-  g_mutex_unlock (&sink->socklock);
-
-  pl_info.protection_metadata_info = g_ptr_array_new_full (
-      gst_socket_sink_get_protection_meta_count (buffer), g_free);
 
   while ((meta = gst_buffer_iterate_meta_filtered (buffer, &state,
       GST_PROTECTION_META_API_TYPE))) {
     GstProtectionMetadataPayload * pmeta_pl = NULL;
-    const gchar * pmeta = gst_structure_to_string (
+    gchar * pmeta = gst_structure_to_string (
         GST_PROTECTION_META_CAST (meta)->info);
 
     gsize size = strlen (pmeta) + 1;
 
-    pmeta_pl = g_malloc (sizeof (GstProtectionMetadataPayload));
-
     GST_DEBUG_OBJECT (sink, "Add protetion metadata: %s", pmeta);
 
-    pmeta_pl->identity = MESSAGE_PROTECTION_META;
-
     if (sizeof (pmeta_pl->contents) < size) {
         GST_ERROR_OBJECT (sink, "Got too much data");
-        free_pl_struct (&pl_info);
+        g_free (pmeta);
         return GST_FLOW_ERROR;
     }
 
+    pmeta_pl = payload_arena_alloc (&sink->arena,
+        sizeof (GstProtectionMetadataPayload));
+
+    pmeta_pl->identity = MESSAGE_PROTECTION_META;
+
     memmove (pmeta_pl->contents, pmeta, size);
+    g_free (pmeta);
 
     pmeta_pl->size = size;
     pmeta_pl->maxsize = sizeof (pmeta_pl->contents);
-    g_ptr_array_add (pl_info.protection_metadata_info, pmeta_pl);
+    g_ptr_array_add (pl_info->protection_metadata_info, pmeta_pl);
   }
 
-  n_memory = gst_buffer_n_memory (buffer);
-  if (n_memory != GST_EXPECTED_MEM_BLOCKS(sink)) {
+  *n_memory = gst_buffer_n_memory (buffer);
+  if (*n_memory != GST_EXPECTED_MEM_BLOCKS(sink) ||
+      *n_memory > GST_MAX_MEM_BLOCKS) {
     GST_ERROR_OBJECT (sink, "Invalid number of memory buffers!");
     return GST_FLOW_ERROR;
   }
 
-  buffer_pl = g_malloc (sizeof (GstBufferPayload));
+  buffer_pl = payload_arena_alloc (&sink->arena, sizeof (GstBufferPayload));
+  memset (buffer_pl, 0, sizeof (GstBufferPayload));
 
-  pl_info.mem_block_info =
-      g_ptr_array_new_full (GST_EXPECTED_MEM_BLOCKS(sink), g_free);
   buffer_pl->identity = MESSAGE_BUFFER_INFO;
   buffer_pl->pts = GST_BUFFER_PTS (buffer);
   buffer_pl->dts = GST_BUFFER_DTS (buffer);
   buffer_pl->duration = GST_BUFFER_DURATION (buffer);
   buffer_pl->use_buffer_pool = buffer->pool != NULL;
-  pl_info.buffer_info = buffer_pl;
+  pl_info->buffer_info = buffer_pl;
 
-  //From here needs batching logic
-  for (guint i = 0; i < n_memory; i++) {
+  for (guint i = 0; i < *n_memory; i++) {
     gsize size = 0;
     gsize maxsize = 0;
 
@@ -522,13 +680,16 @@ gst_socket_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
       *(buffer_pl->buf_id) = -1;
       buffer_pl->use_buffer_pool = 0;
 
+      if (sink->ring != NULL &&
+          gst_socket_sink_ring_write_memory (sink, pl_info, memory))
+        continue;
+
       if (sizeof (text_pl->contents) < size) {
         GST_ERROR ("Got too much text from memory block");
-        free_pl_struct (&pl_info);
         return GST_FLOW_ERROR;
       }
 
-      text_pl = g_malloc (sizeof (GstTextPayload));
+      text_pl = payload_arena_alloc (&sink->arena, sizeof (GstTextPayload));
 
       text_pl->identity = MESSAGE_TEXT;
 
@@ -538,9 +699,8 @@ gst_socket_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
 
       text_pl->size = size;
       text_pl->maxsize = maxsize;
-      g_ptr_array_add (pl_info.mem_block_info, text_pl);
+      g_ptr_array_add (pl_info->mem_block_info, text_pl);
     } else if (!gst_is_fd_memory (memory)) {
-      free_pl_struct (&pl_info);
       GST_ERROR_OBJECT (sink, "Memory allocator is not fd");
       return GST_FLOW_ERROR;
     }
@@ -558,7 +718,7 @@ gst_socket_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
         return GST_FLOW_ERROR;
       }
 
-      tensor_pl = g_malloc (sizeof (GstTensorPayload));
+      tensor_pl = payload_arena_alloc (&sink->arena, sizeof (GstTensorPayload));
 
       tensor_pl->identity = MESSAGE_TENSOR;
       tensor_pl->type = mlmeta->type;
@@ -572,12 +732,11 @@ gst_socket_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
 
       tensor_pl->size = size;
       tensor_pl->maxsize = maxsize;
-      g_ptr_array_add (pl_info.mem_block_info, tensor_pl);
+      g_ptr_array_add (pl_info->mem_block_info, tensor_pl);
     }
 
     if (sink->mode == DATA_MODE_VIDEO) {
       GstFramePayload * frame_pl = NULL;
-      GstMeta *meta_i = NULL;
 
       memory_fds[i] = gst_fd_memory_get_fd (memory);
       buffer_pl->buf_id[i] = memory_fds[i];
@@ -588,7 +747,7 @@ gst_socket_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
         return GST_FLOW_ERROR;
       }
 
-      frame_pl = g_malloc (sizeof (GstFramePayload));
+      frame_pl = payload_arena_alloc (&sink->arena, sizeof (GstFramePayload));
 
       frame_pl->identity = MESSAGE_FRAME;
       frame_pl->width = meta->width;
@@ -604,90 +763,577 @@ gst_socket_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
 
       frame_pl->size = size;
       frame_pl->maxsize = maxsize;
-      g_ptr_array_add (pl_info.mem_block_info, frame_pl);
-
-      pl_info.roi_meta_info = g_ptr_array_new ();
-      pl_info.class_meta_info = g_ptr_array_new ();
-      pl_info.lm_meta_info = g_ptr_array_new ();
-
-      while ((meta_i = gst_buffer_iterate_meta (buffer, &state))) {
-        if (meta_i->info->api == GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE) {
-          GstVideoRegionOfInterestMeta *roi_meta =
-              GST_VIDEO_ROI_META_CAST (meta_i);
-          GstVideoRoiMetaPayload *roi_meta_pl =
-              gst_socket_serialize_roi_meta (roi_meta);
-          g_ptr_array_add (pl_info.roi_meta_info, roi_meta_pl);
-        }
-        else if (meta_i->info->api == GST_VIDEO_CLASSIFICATION_META_API_TYPE) {
-          GstVideoClassificationMeta *class_meta =
-              GST_VIDEO_CLASSIFICATION_META_CAST (meta_i);
-          GstVideoClassMetaPayload *class_meta_pl =
-              gst_socket_serialize_class_meta (class_meta);
-          g_ptr_array_add (pl_info.class_meta_info, class_meta_pl);
-        }
-        else if (meta_i->info->api == GST_VIDEO_LANDMARKS_META_API_TYPE) {
-          GstVideoLandmarksMeta *lm_meta =
-              GST_VIDEO_LANDMARKS_META_CAST (meta_i);
-          GstVideoLmMetaPayload *lm_meta_pl =
-              gst_socket_serialize_lm_meta (lm_meta);
-          g_ptr_array_add (pl_info.lm_meta_info, lm_meta_pl);
-        }
+      g_ptr_array_add (pl_info->mem_block_info, frame_pl);
+    }
+  }
+
+  if (sink->mode == DATA_MODE_VIDEO) {
+    state = NULL;
+
+    while ((meta = gst_buffer_iterate_meta (buffer, &state))) {
+      if (meta->info->api == GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE) {
+        GstVideoRegionOfInterestMeta *roi_meta =
+            GST_VIDEO_ROI_META_CAST (meta);
+        GstVideoRoiMetaPayload *roi_meta_pl =
+            gst_socket_serialize_roi_meta (&sink->arena, roi_meta);
+        g_ptr_array_add (pl_info->roi_meta_info, roi_meta_pl);
+      }
+      else if (meta->info->api == GST_VIDEO_CLASSIFICATION_META_API_TYPE) {
+        GstVideoClassificationMeta *class_meta =
+            GST_VIDEO_CLASSIFICATION_META_CAST (meta);
+        GstVideoClassMetaPayload *class_meta_pl =
+            gst_socket_serialize_class_meta (&sink->arena, class_meta);
+        g_ptr_array_add (pl_info->class_meta_info, class_meta_pl);
+      }
+      else if (meta->info->api == GST_VIDEO_LANDMARKS_META_API_TYPE) {
+        GstVideoLandmarksMeta *lm_meta =
+            GST_VIDEO_LANDMARKS_META_CAST (meta);
+        GstVideoLmMetaPayload *lm_meta_pl =
+            gst_socket_serialize_lm_meta (&sink->arena, lm_meta);
+        g_ptr_array_add (pl_info->lm_meta_info, lm_meta_pl);
       }
     }
+  }
 
-    if (sink->mode != DATA_MODE_TEXT &&
-        sink->mode != DATA_MODE_TENSOR &&
-        sink->mode != DATA_MODE_VIDEO) {
-      GST_ERROR_OBJECT (sink, "Unsupported mode: %d", sink->mode);
-      return GST_FLOW_ERROR;
+  if (sink->ring != NULL)
+    gst_socket_sink_ring_write_payloads (sink, pl_info);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_socket_consumer_wants_buffer (GstSocketConsumer * consumer,
+    GstBuffer * buffer)
+{
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+
+  if (consumer->interval == 0 || !GST_CLOCK_TIME_IS_VALID (pts))
+    return TRUE;
+
+  // Tolerate a quarter interval of jitter, so that a 15 fps subscription to
+  // a 30 fps stream reliably gets every second buffer.
+  if (GST_CLOCK_TIME_IS_VALID (consumer->last_pts) &&
+      (pts >= consumer->last_pts) &&
+      (pts + consumer->interval / 4) < (consumer->last_pts + consumer->interval))
+    return FALSE;
+
+  consumer->last_pts = pts;
+  return TRUE;
+}
+
+// Send the pending messages of every consumer and recycle the batch payloads.
+// Must be called with the socklock held.
+static void
+gst_socket_sink_flush_consumers (GstFdSocketSink * sink)
+{
+  for (guint idx = 0; idx < sink->consumers->len; idx++) {
+    GstSocketConsumer *consumer = g_ptr_array_index (sink->consumers, idx);
+
+    if (consumer->n_pending == 0)
+      continue;
+
+    if (send_socket_messages (consumer->socket, consumer->pending,
+            consumer->n_pending) < 0) {
+      GST_WARNING_OBJECT (sink, "Failed to send %u messages to consumer %d, "
+          "dropping it", consumer->n_pending, consumer->socket);
+
+      // Message thread will see the hang up and release its buffers.
+      shutdown (consumer->socket, SHUT_RDWR);
     }
 
+    consumer->n_pending = 0;
+  }
+
+  for (guint idx = 0; idx < sink->n_frames; idx++)
+    release_pl_struct (&sink->frames[idx]);
+
+  sink->n_frames = 0;
+  payload_arena_reset (&sink->arena);
+}
+
+// Whether the oldest buffer of a partial batch waited for the latency bound.
+// Must be called with the socklock held.
+static gboolean
+gst_socket_sink_batch_expired (GstFdSocketSink * sink)
+{
+  gint64 elapsed = 0;
+
+  if ((sink->n_frames == 0) || (sink->batch_latency == 0))
+    return FALSE;
+
+  elapsed = g_get_monotonic_time () - sink->batch_start;
+  return (elapsed * GST_USECOND) >= sink->batch_latency;
+}
+
+static GstFlowReturn
+gst_socket_sink_render_consumers (GstFdSocketSink * sink, GstBuffer * buffer)
+{
+  GstPayloadInfo *frame = NULL;
+  gint memory_fds[GST_MAX_MEM_BLOCKS] = {0};
+  guint n_memory = 0, n_queued = 0;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&sink->socklock);
+
+  if (sink->consumers->len == 0) {
+    g_mutex_unlock (&sink->socklock);
+    GST_LOG_OBJECT (sink, "No consumers, dropping buffer %p", buffer);
+    return GST_FLOW_OK;
+  }
+
+  // Buffer is serialized once and the payloads are shared by all consumers.
+  frame = &sink->frames[sink->n_frames];
+
+  ret = gst_socket_sink_serialize_buffer (sink, buffer, frame, memory_fds,
+      &n_memory);
+  if (ret != GST_FLOW_OK) {
+    release_pl_struct (frame);
+    g_mutex_unlock (&sink->socklock);
+    return ret;
+  }
+
+  for (guint idx = 0; idx < sink->consumers->len; idx++) {
+    GstSocketConsumer *consumer = g_ptr_array_index (sink->consumers, idx);
+    GstPayloadInfo *pl_info = NULL;
+    gboolean send_fds = (buffer->pool == NULL);
+
+    g_mutex_lock (&consumer->lock);
+
+    if (consumer->disconnecting ||
+        (sink->ring != NULL && !consumer->ring_ready) ||
+        !gst_socket_consumer_wants_buffer (consumer, buffer)) {
+      g_mutex_unlock (&consumer->lock);
+      continue;
+    }
+
+    pl_info = payload_arena_alloc (&sink->arena, sizeof (GstPayloadInfo));
+    *pl_info = *frame;
+
+    pl_info->fd_count = NULL;
+    pl_info->fds = NULL;
+
     if (sink->mode != DATA_MODE_TEXT) {
-      g_mutex_lock (&sink->bufmaplock);
-      if (!buffer->pool ||
-          !g_hash_table_contains (sink->bufmap, GINT_TO_POINTER (memory_fds[i]))) {
-        memory_fds_send[n_memory_send++] = memory_fds[i];
-        g_hash_table_insert (sink->bufmap, GINT_TO_POINTER (memory_fds[i]), buffer);
-      } else {
-        g_hash_table_insert (sink->bufmap, GINT_TO_POINTER (memory_fds[i]), buffer);
+      // The receiver expects either all fds of a buffer or none of them.
+      for (guint i = 0; i < n_memory; i++) {
+        if (!g_hash_table_contains (consumer->bufmap,
+                GINT_TO_POINTER (memory_fds[i])))
+          send_fds = TRUE;
+      }
+
+      // Each consumer holds its own reference until it returns the buffer.
+      for (guint i = 0; i < n_memory; i++) {
+        g_hash_table_insert (consumer->bufmap,
+            GINT_TO_POINTER (memory_fds[i]), buffer);
+        consumer->bufcount++;
+
+        gst_buffer_ref (buffer);
       }
-      sink->bufcount++;
-      g_mutex_unlock (&sink->bufmaplock);
 
-      gst_buffer_ref (buffer);
+      if (send_fds) {
+        pl_info->fd_count =
+            payload_arena_alloc (&sink->arena, sizeof (GstFdCountPayload));
+        pl_info->fd_count->identity = MESSAGE_FD_COUNT;
+        pl_info->fd_count->n_fds = n_memory;
+
+        pl_info->fds = payload_arena_alloc (&sink->arena,
+            sizeof (gint) * n_memory);
+        memcpy (pl_info->fds, memory_fds, sizeof (gint) * n_memory);
+      }
     }
+
+    consumer->pending[consumer->n_pending++] = pl_info;
+    g_mutex_unlock (&consumer->lock);
+
+    n_queued++;
+  }
+
+  GST_LOG_OBJECT (sink, "Buffer %p queued for %u of %u consumers", buffer,
+      n_queued, sink->consumers->len);
+
+  // Latency of the batch is measured from its first buffer.
+  if (sink->n_frames++ == 0)
+    sink->batch_start = g_get_monotonic_time ();
+
+  if ((sink->n_frames >= sink->batch_size) ||
+      gst_socket_sink_batch_expired (sink))
+    gst_socket_sink_flush_consumers (sink);
+
+  g_mutex_unlock (&sink->socklock);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_socket_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
+{
+  GstFdSocketSink *sink = GST_SOCKET_SINK (bsink);
+  GstPayloadInfo *pl_info = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint memory_fds[GST_MAX_MEM_BLOCKS] = {0};
+  gint memory_fds_send[GST_MAX_MEM_BLOCKS]; // todo expand
+  guint n_memory = 0;
+  gint n_memory_send = 0;
+
+  GST_DEBUG_OBJECT (sink, "gst_socket_sink_render %d", sink->mode);
+
+  if (sink->max_consumers > 0)
+    return gst_socket_sink_render_consumers (sink, buffer);
+
+  g_mutex_lock (&sink->socklock);
+  if (!g_atomic_int_get (&sink->connected) ||
+       g_atomic_int_get (&sink->should_disconnect) ||
+       g_atomic_int_get (&sink->should_stop)) {
+    g_mutex_unlock (&sink->socklock);
+    return GST_FLOW_OK;
+  }
+  g_mutex_unlock (&sink->socklock);
+
+  if (sink->ring != NULL && !g_atomic_int_get (&sink->ring_ready)) {
+    GST_LOG_OBJECT (sink, "Shared memory ring not acknowledged yet, dropping "
+        "buffer %p", buffer);
+    return GST_FLOW_OK;
+  }
+
+  pl_info = &sink->frames[0];
+
+  ret = gst_socket_sink_serialize_buffer (sink, buffer, pl_info, memory_fds,
+      &n_memory);
+  if (ret != GST_FLOW_OK) {
+    release_pl_struct (pl_info);
+    payload_arena_reset (&sink->arena);
+    return ret;
+  }
+
+  for (guint i = 0; (sink->mode != DATA_MODE_TEXT) && (i < n_memory); i++) {
+    g_mutex_lock (&sink->bufmaplock);
+    if (!buffer->pool ||
+        !g_hash_table_contains (sink->bufmap, GINT_TO_POINTER (memory_fds[i]))) {
+      memory_fds_send[n_memory_send++] = memory_fds[i];
+      g_hash_table_insert (sink->bufmap, GINT_TO_POINTER (memory_fds[i]), buffer);
+    } else {
+      g_hash_table_insert (sink->bufmap, GINT_TO_POINTER (memory_fds[i]), buffer);
+    }
+    sink->bufcount++;
+    g_mutex_unlock (&sink->bufmaplock);
+
+    gst_buffer_ref (buffer);
   }
 
   if (n_memory_send > 0) {
-    pl_info.fd_count = g_malloc (sizeof (GstFdCountPayload));
-    pl_info.fd_count->identity = MESSAGE_FD_COUNT;
-    pl_info.fd_count->n_fds = n_memory_send;
+    pl_info->fd_count =
+        payload_arena_alloc (&sink->arena, sizeof (GstFdCountPayload));
+    pl_info->fd_count->identity = MESSAGE_FD_COUNT;
+    pl_info->fd_count->n_fds = n_memory_send;
   }
 
   if (sink->mode == DATA_MODE_TEXT) {
-    pl_info.fds = NULL;
+    pl_info->fds = NULL;
   } else {
-    pl_info.fds = memory_fds_send;
+    pl_info->fds = memory_fds_send;
   }
 
-  if (send_socket_message (sink->socket, &pl_info) < 0) {
+  if (send_socket_message (sink->socket, pl_info) < 0) {
     if (sink->mode == DATA_MODE_TEXT) {
       GST_ERROR_OBJECT (sink, "Send text message failed! %d", errno);
     } else {
       GST_ERROR_OBJECT (sink, "Send Fd message failed! %d", errno);
     }
 
-    free_pl_struct (&pl_info);
+    ret = GST_FLOW_ERROR;
+  }
 
-    return GST_FLOW_ERROR;
+  release_pl_struct (pl_info);
+  payload_arena_reset (&sink->arena);
+
+  if (ret == GST_FLOW_OK)
+    GST_DEBUG_OBJECT (sink, "Sent data of type %d; Number of mem blocks sent: %d",
+        sink->mode, n_memory_send);
+
+  return ret;
+}
+
+static GstSocketConsumer *
+gst_socket_consumer_new (gint socket)
+{
+  GstSocketConsumer *consumer = g_new0 (GstSocketConsumer, 1);
+  struct timeval timeout = {
+    .tv_sec = CONSUMER_SEND_TIMEOUT_MS / 1000,
+    .tv_usec = (CONSUMER_SEND_TIMEOUT_MS % 1000) * 1000
+  };
+
+  consumer->socket = socket;
+  consumer->bufmap = g_hash_table_new (NULL, NULL);
+  consumer->interval = 0;
+  consumer->last_pts = GST_CLOCK_TIME_NONE;
+
+  g_mutex_init (&consumer->lock);
+
+  // A stuck consumer must not stall the delivery to all the others.
+  if (setsockopt (socket, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+          sizeof (timeout)) < 0)
+    GST_WARNING ("Failed to set send timeout for consumer %d", socket);
+
+  return consumer;
+}
+
+static void
+gst_socket_consumer_free (GstSocketConsumer * consumer)
+{
+  GHashTableIter iter;
+  gpointer key = NULL, value = NULL;
+
+  g_mutex_lock (&consumer->lock);
+
+  g_hash_table_iter_init (&iter, consumer->bufmap);
+
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    if (value != NULL)
+      gst_buffer_unref (GST_BUFFER (value));
   }
 
-  free_pl_struct (&pl_info);
+  g_hash_table_destroy (consumer->bufmap);
+  g_mutex_unlock (&consumer->lock);
 
-  GST_DEBUG_OBJECT (sink, "Sent data of type %d; Number of mem blocks sent: %d",
-      sink->mode, n_memory_send);
+  shutdown (consumer->socket, SHUT_RDWR);
+  close (consumer->socket);
 
-  return GST_FLOW_OK;
+  g_mutex_clear (&consumer->lock);
+  g_free (consumer);
+}
+
+static void
+gst_socket_sink_accept_consumer (GstFdSocketSink * sink, gint listen_sock)
+{
+  GstSocketConsumer *consumer = NULL;
+  gint sock = accept (listen_sock, NULL, NULL);
+
+  if (sock < 0) {
+    GST_WARNING_OBJECT (sink, "Socket accept failed: %s", strerror (errno));
+    return;
+  }
+
+  if (sink->consumers->len >= sink->max_consumers) {
+    GST_WARNING_OBJECT (sink, "Rejecting consumer, limit of %u reached",
+        sink->max_consumers);
+    close (sock);
+    return;
+  }
+
+  if (sink->ring != NULL && !gst_socket_sink_offer_ring (sink, sock)) {
+    close (sock);
+    return;
+  }
+
+  consumer = gst_socket_consumer_new (sock);
+
+  g_mutex_lock (&sink->socklock);
+  g_ptr_array_add (sink->consumers, consumer);
+  g_mutex_unlock (&sink->socklock);
+
+  GST_INFO_OBJECT (sink, "Consumer %d connected, %u in total", sock,
+      sink->consumers->len);
+}
+
+static void
+gst_socket_sink_remove_consumer (GstFdSocketSink * sink,
+    GstSocketConsumer * consumer)
+{
+  g_mutex_lock (&sink->socklock);
+  g_ptr_array_remove (sink->consumers, consumer);
+  g_mutex_unlock (&sink->socklock);
+
+  GST_INFO_OBJECT (sink, "Consumer %d disconnected, %u remaining",
+      consumer->socket, sink->consumers->len);
+
+  gst_socket_consumer_free (consumer);
+}
+
+// Handle the queued messages of a consumer.
+// Returns FALSE when the consumer is gone and should be removed.
+static gboolean
+gst_socket_sink_process_consumer (GstFdSocketSink * sink,
+    GstSocketConsumer * consumer, gshort revents)
+{
+  GstPayloadInfo pl_infos[GST_MAX_BATCH_MESSAGES];
+  gint n_infos = 0;
+  gboolean active = TRUE;
+
+  if (revents & (POLLHUP | POLLERR)) {
+    GST_DEBUG_OBJECT (sink, "Consumer %d socket closed", consumer->socket);
+    return FALSE;
+  }
+
+  if (revents & POLLIN) {
+    memset (pl_infos, 0, sizeof (pl_infos));
+
+    n_infos = receive_socket_messages (consumer->socket, pl_infos,
+        GST_MAX_BATCH_MESSAGES);
+
+    if (n_infos < 0) {
+      GST_DEBUG_OBJECT (sink, "Consumer %d receive failed", consumer->socket);
+      return FALSE;
+    }
+  }
+
+  g_mutex_lock (&consumer->lock);
+
+  for (gint idx = 0; idx < n_infos; idx++) {
+    GstPayloadInfo *pl_info = &pl_infos[idx];
+
+    if (pl_info->subscribe != NULL) {
+      consumer->interval = pl_info->subscribe->interval;
+
+      GST_INFO_OBJECT (sink, "Consumer %d subscribed with interval %"
+          GST_TIME_FORMAT, consumer->socket,
+          GST_TIME_ARGS (consumer->interval));
+    }
+
+    if (pl_info->ring_setup != NULL) {
+      GST_DEBUG_OBJECT (sink, "Consumer %d mapped the shared memory ring",
+          consumer->socket);
+      consumer->ring_ready = TRUE;
+    }
+
+    if (GST_PL_INFO_IS_MESSAGE (pl_info, MESSAGE_DISCONNECT)) {
+      GST_DEBUG_OBJECT (sink, "Consumer %d MESSAGE_DISCONNECT",
+          consumer->socket);
+      consumer->disconnecting = TRUE;
+    }
+
+    if (pl_info->return_buffer != NULL && pl_info->fd_count != NULL) {
+      gint n_fds = MIN (pl_info->fd_count->n_fds, GST_MAX_MEM_BLOCKS);
+
+      for (gint i = 0; i < n_fds; i++) {
+        gint buf_id = pl_info->return_buffer->buf_id[i];
+        GstBuffer *buffer =
+            g_hash_table_lookup (consumer->bufmap, GINT_TO_POINTER (buf_id));
+
+        if (buffer == NULL) {
+          GST_WARNING_OBJECT (sink, "Consumer %d returned unknown buf_id: %d",
+              consumer->socket, buf_id);
+          continue;
+        }
+
+        g_hash_table_insert (consumer->bufmap, GINT_TO_POINTER (buf_id), NULL);
+        consumer->bufcount--;
+
+        gst_buffer_unref (buffer);
+      }
+    }
+
+    free_pl_struct (pl_info);
+  }
+
+  active = !(consumer->disconnecting && consumer->bufcount == 0);
+  g_mutex_unlock (&consumer->lock);
+
+  return active;
+}
+
+static gpointer
+gst_socket_sink_serve_loop (gpointer user_data)
+{
+  GstFdSocketSink *sink = GST_SOCKET_SINK (user_data);
+  struct sockaddr_un address = {0};
+  gint listen_sock = -1, timeout = SERVER_POLL_TIMEOUT_MS;
+
+  if ((listen_sock = socket (AF_UNIX, SOCK_SEQPACKET, 0)) < 0) {
+    GST_ERROR_OBJECT (sink, "Socket creation error");
+    return NULL;
+  }
+
+  unlink (sink->sockfile);
+
+  address.sun_family = AF_UNIX;
+  g_strlcpy (address.sun_path, sink->sockfile, sizeof (address.sun_path));
+
+  if (bind (listen_sock, (struct sockaddr *) &address, sizeof (address)) < 0) {
+    GST_ERROR_OBJECT (sink, "Socket bind failed: %s", strerror (errno));
+    close (listen_sock);
+    return NULL;
+  }
+
+  if (listen (listen_sock, sink->max_consumers) < 0) {
+    GST_ERROR_OBJECT (sink, "Socket listen failed: %s", strerror (errno));
+    close (listen_sock);
+    unlink (sink->sockfile);
+    return NULL;
+  }
+
+  g_mutex_lock (&sink->socklock);
+  sink->socket = listen_sock;
+  g_mutex_unlock (&sink->socklock);
+
+  g_atomic_int_set (&sink->connected, TRUE);
+
+  GST_DEBUG_OBJECT (sink, "Serving up to %u consumers", sink->max_consumers);
+
+  // Wake up often enough to send partial batches within the latency bound.
+  if (sink->batch_latency > 0 && sink->batch_size > 1)
+    timeout = CLAMP (GST_TIME_AS_MSECONDS (sink->batch_latency), 1,
+        SERVER_POLL_TIMEOUT_MS);
+
+  while (!g_atomic_int_get (&sink->should_stop)) {
+    guint n_consumers = sink->consumers->len;
+    struct pollfd poll_fds[n_consumers + 1];
+    gint ret = 0;
+
+    poll_fds[0].fd = listen_sock;
+    poll_fds[0].events = POLLIN;
+
+    for (guint idx = 0; idx < n_consumers; idx++) {
+      GstSocketConsumer *consumer = g_ptr_array_index (sink->consumers, idx);
+
+      poll_fds[idx + 1].fd = consumer->socket;
+      poll_fds[idx + 1].events = POLLIN;
+    }
+
+    ret = poll (poll_fds, n_consumers + 1, timeout);
+    if (ret < 0 && errno != EINTR) {
+      GST_ERROR_OBJECT (sink, "Socket poll error: %s", strerror (errno));
+      break;
+    }
+
+    // No buffer arrived in time to fill the batch, send what is pending.
+    g_mutex_lock (&sink->socklock);
+
+    if (gst_socket_sink_batch_expired (sink)) {
+      GST_LOG_OBJECT (sink, "Batch latency expired, sending %u of %u buffers",
+          sink->n_frames, sink->batch_size);
+      gst_socket_sink_flush_consumers (sink);
+    }
+
+    g_mutex_unlock (&sink->socklock);
+
+    // Walk backwards, removing a consumer does not shift unvisited ones.
+    for (guint idx = n_consumers; idx > 0; idx--) {
+      GstSocketConsumer *consumer =
+          g_ptr_array_index (sink->consumers, idx - 1);
+      gshort revents = (ret > 0) ? poll_fds[idx].revents : 0;
+
+      if (!gst_socket_sink_process_consumer (sink, consumer, revents))
+        gst_socket_sink_remove_consumer (sink, consumer);
+    }
+
+    if (ret > 0 && (poll_fds[0].revents & POLLIN))
+      gst_socket_sink_accept_consumer (sink, listen_sock);
+  }
+
+  g_atomic_int_set (&sink->connected, FALSE);
+
+  while (sink->consumers->len > 0)
+    gst_socket_sink_remove_consumer (sink,
+        g_ptr_array_index (sink->consumers, 0));
+
+  g_mutex_lock (&sink->socklock);
+  sink->socket = -1;
+  g_mutex_unlock (&sink->socklock);
+
+  shutdown (listen_sock, SHUT_RDWR);
+  close (listen_sock);
+  unlink (sink->sockfile);
+
+  return NULL;
 }
 
 static gpointer
@@ -772,6 +1418,13 @@ gst_socket_sink_wait_message_loop (gpointer user_data)
           break;
         }
 
+        if (pl_info.ring_setup != NULL) {
+          GST_DEBUG_OBJECT (sink, "Shared memory ring acknowledged");
+          g_atomic_int_set (&sink->ring_ready, TRUE);
+          free_pl_struct (&pl_info);
+          break;
+        }
+
         if (GST_PL_INFO_IS_MESSAGE (&pl_info, MESSAGE_DISCONNECT)) {
           GST_DEBUG_OBJECT (sink, "MESSAGE_DISCONNECT");
           g_atomic_int_set (&sink->should_disconnect, TRUE);
@@ -818,6 +1471,7 @@ gst_socket_sink_wait_message_loop (gpointer user_data)
         g_mutex_lock (&sink->socklock);
 
         g_atomic_int_set (&sink->connected, FALSE);
+        g_atomic_int_set (&sink->ring_ready, FALSE);
 
         if (sink->socket > 0) {
           shutdown (sink->socket, SHUT_RDWR);
@@ -865,14 +1519,51 @@ gst_socket_sink_start (GstBaseSink * basesink)
   g_atomic_int_set (&sink->should_disconnect, FALSE);
   g_atomic_int_set (&sink->connected, FALSE);
 
+  payload_arena_init (&sink->arena, PAYLOAD_ARENA_SIZE);
+
+  g_atomic_int_set (&sink->ring_ready, FALSE);
+
+  if (sink->ring_size > 0) {
+    sink->ring = shm_ring_new (MAX (sink->ring_size, MIN_SHM_RING_SIZE));
+  }
+
+  if (sink->ring_size > 0 && sink->ring == NULL) {
+    GST_ERROR_OBJECT (sink, "Failed to create shared memory ring!");
+    payload_arena_clear (&sink->arena);
+    return FALSE;
+  }
+
+  for (guint idx = 0; idx < sink->batch_size; idx++) {
+    GstPayloadInfo *frame = &sink->frames[idx];
+
+    memset (frame, 0, sizeof (GstPayloadInfo));
+
+    frame->mem_block_info = g_ptr_array_new ();
+    frame->protection_metadata_info = g_ptr_array_new ();
+    frame->roi_meta_info = g_ptr_array_new ();
+    frame->class_meta_info = g_ptr_array_new ();
+    frame->lm_meta_info = g_ptr_array_new ();
+    frame->ring_record_info = g_ptr_array_new ();
+  }
+
+  sink->n_frames = 0;
+  sink->consumers = g_ptr_array_new ();
+
   sink->msg_thread = NULL;
 
   sink->state = GST_SOCKET_TRY_CONNECT;
 
   g_mutex_lock (&sink->msglock);
   if (sink->msg_thread == NULL) {
-    if ((sink->msg_thread = g_thread_new ("Msg thread",
-        gst_socket_sink_wait_message_loop, sink)) == NULL) {
+    if (sink->max_consumers > 0) {
+      sink->msg_thread = g_thread_new ("Serve thread",
+          gst_socket_sink_serve_loop, sink);
+    } else {
+      sink->msg_thread = g_thread_new ("Msg thread",
+          gst_socket_sink_wait_message_loop, sink);
+    }
+
+    if (sink->msg_thread == NULL) {
       g_mutex_unlock (&sink->msglock);
       return FALSE;
     }
@@ -901,6 +1592,24 @@ gst_socket_sink_stop (GstBaseSink * basesink)
     g_hash_table_destroy (sink->bufmap);
   }
 
+  if (sink->consumers) {
+    g_ptr_array_free (sink->consumers, TRUE);
+    sink->consumers = NULL;
+  }
+
+  for (guint idx = 0; idx < sink->batch_size; idx++) {
+    release_pl_struct (&sink->frames[idx]);
+    free_pl_struct (&sink->frames[idx]);
+  }
+
+  sink->n_frames = 0;
+  payload_arena_clear (&sink->arena);
+
+  if (sink->ring != NULL) {
+    shm_ring_free (sink->ring);
+    sink->ring = NULL;
+  }
+
   g_mutex_clear (&sink->bufmaplock);
   g_mutex_clear (&sink->socklock);
 
@@ -951,6 +1660,26 @@ gst_socket_sink_query (GstBaseSink * bsink, GstQuery * query)
   return retval;
 }
 
+static void
+gst_socket_sink_send_consumers_eos (GstFdSocketSink * sink,
+    GstPayloadInfo * pl_info)
+{
+  g_mutex_lock (&sink->socklock);
+
+  if (sink->n_frames > 0)
+    gst_socket_sink_flush_consumers (sink);
+
+  for (guint idx = 0; idx < sink->consumers->len; idx++) {
+    GstSocketConsumer *consumer = g_ptr_array_index (sink->consumers, idx);
+
+    if (send_socket_message (consumer->socket, pl_info) < 0)
+      GST_WARNING_OBJECT (sink, "Unable to send EOS message to consumer %d.",
+          consumer->socket);
+  }
+
+  g_mutex_unlock (&sink->socklock);
+}
+
 static gboolean
 gst_socket_sink_event (GstBaseSink *bsink, GstEvent *event)
 {
@@ -964,11 +1693,19 @@ gst_socket_sink_event (GstBaseSink *bsink, GstEvent *event)
     case GST_EVENT_EOS:
       GST_INFO_OBJECT (sink, "EOS event");
 
-      g_atomic_int_set (&sink->should_stop, TRUE);
-
       msg.identity = MESSAGE_EOS;
       pl_info.message = &msg;
 
+      if (sink->max_consumers > 0) {
+        gst_socket_sink_send_consumers_eos (sink, &pl_info);
+
+        // No more buffers will follow, let the serve thread disconnect.
+        g_atomic_int_set (&sink->should_stop, TRUE);
+        break;
+      }
+
+      g_atomic_int_set (&sink->should_stop, TRUE);
+
       if (g_atomic_int_get (&sink->connected) &&
             (send_socket_message (sink->socket, &pl_info) < 0)) {
         GST_WARNING_OBJECT (sink, "Unable to send EOS message.");
@@ -998,6 +1735,14 @@ gst_socket_sink_init (GstFdSocketSink * sink)
   sink->msg_thread = NULL;
   sink->socket = -1;
   sink->mode = DATA_MODE_NONE;
+  sink->max_consumers = DEFAULT_PROP_MAX_CONSUMERS;
+  sink->batch_size = DEFAULT_PROP_BATCH_SIZE;
+  sink->batch_latency = DEFAULT_PROP_BATCH_LATENCY;
+  sink->batch_start = 0;
+  sink->consumers = NULL;
+  sink->n_frames = 0;
+  sink->ring_size = DEFAULT_PROP_SHM_RING_SIZE;
+  sink->ring = NULL;
 
   g_atomic_int_set (&sink->should_stop, FALSE);
 
@@ -1060,6 +1805,39 @@ gst_socket_sink_class_init (GstFdSocketSinkClass * klass)
         G_PARAM_READWRITE |G_PARAM_STATIC_STRINGS |
         GST_PARAM_MUTABLE_READY));
 
+  g_object_class_install_property (gobject, PROP_MAX_CONSUMERS,
+    g_param_spec_uint ("max-consumers", "Maximum consumers",
+        "Listen on the socket and serve up to this many qtisocketsrc elements "
+        "in 'subscribe' mode. When 0 the sink connects to a single listening "
+        "qtisocketsrc instead", 0, MAX_CONSUMERS, DEFAULT_PROP_MAX_CONSUMERS,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+        GST_PARAM_MUTABLE_READY));
+
+  g_object_class_install_property (gobject, PROP_BATCH_SIZE,
+    g_param_spec_uint ("batch-size", "Batch size",
+        "Number of buffers coalesced into a single send call to each consumer "
+        "(applies only when 'max-consumers' is set)", 1,
+        GST_MAX_BATCH_MESSAGES, DEFAULT_PROP_BATCH_SIZE,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+        GST_PARAM_MUTABLE_READY));
+
+  g_object_class_install_property (gobject, PROP_BATCH_LATENCY,
+    g_param_spec_uint64 ("batch-latency", "Batch latency",
+        "Maximum time in nanoseconds a buffer waits for its batch to fill "
+        "before a partial batch is sent (0 = wait for a full batch or EOS)",
+        0, G_MAXUINT64, DEFAULT_PROP_BATCH_LATENCY,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+        GST_PARAM_MUTABLE_READY));
+
+  g_object_class_install_property (gobject, PROP_SHM_RING_SIZE,
+    g_param_spec_uint ("shm-ring-size", "Shared memory ring size",
+        "Size in bytes of a shared memory ring carrying text and metadata "
+        "payloads, the socket then carries only their descriptors. The ring "
+        "is offered at connect time and buffers are delivered only once a "
+        "consumer accepts it. 0 disables the ring", 0, MAX_SHM_RING_SIZE,
+        DEFAULT_PROP_SHM_RING_SIZE, G_PARAM_READWRITE |
+        G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY));
+
   gst_element_class_set_static_metadata (gstelement,
       "QTI Socket Sink Element", "Socket Sink Element",
       "This plugin sends a GST buffer over Unix Domain Socket", "QTI");
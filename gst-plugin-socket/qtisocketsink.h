@@ -40,6 +40,7 @@
 #include <gst/ml/ml-info.h>
 
 #include "qtifdsocket.h"
+#include "qtishmring.h"
 
 G_BEGIN_DECLS
 
@@ -56,6 +57,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstFdSocketSink GstFdSocketSink;
 typedef struct _GstFdSocketSinkClass GstFdSocketSinkClass;
+typedef struct _GstSocketConsumer GstSocketConsumer;
 
 typedef enum {
   GST_SOCKET_TRY_CONNECT,
@@ -63,6 +65,31 @@ typedef enum {
   GST_SOCKET_DISCONNECT
 } GstSocketState;
 
+// A qtisocketsrc connected to the sink when it runs in server mode.
+struct _GstSocketConsumer {
+  gint         socket;
+
+  // Protects bufmap, bufcount, interval and disconnecting.
+  GMutex       lock;
+
+  // Buffers sent to this consumer keyed by memory fd, NULL once returned.
+  GHashTable   *bufmap;
+  gint         bufcount;
+
+  // Minimum PTS distance between delivered buffers, 0 for every buffer.
+  GstClockTime interval;
+  GstClockTime last_pts;
+
+  gboolean     disconnecting;
+
+  // Whether the consumer mapped the shared memory ring.
+  gboolean     ring_ready;
+
+  // Messages waiting for the next batched send, owned by the render thread.
+  GstPayloadInfo *pending[GST_MAX_BATCH_MESSAGES];
+  guint          n_pending;
+};
+
 struct _GstFdSocketSink {
   GstBaseSink parent;
 
@@ -88,6 +115,28 @@ struct _GstFdSocketSink {
   GstMLInfo *mlinfo;
 
   GstFdSocketDataType mode;
+
+  // Server mode, 0 means a single qtisocketsrc listening on the socket.
+  guint     max_consumers;
+  guint     batch_size;
+  // Maximum time a partial batch is held back, 0 to wait for a full batch.
+  guint64   batch_latency;
+
+  // List of GstSocketConsumer, modified only by the message thread and
+  // always under socklock.
+  GPtrArray *consumers;
+
+  // Optional shared memory ring for text and metadata payloads.
+  guint      ring_size;
+  GstShmRing *ring;
+  gint       ring_ready;
+
+  // Payloads of the buffers in the current batch.
+  GstPayloadArena arena;
+  GstPayloadInfo  frames[GST_MAX_BATCH_MESSAGES];
+  guint           n_frames;
+  // Monotonic time in microseconds when the first buffer of the batch queued.
+  gint64          batch_start;
 };
 
 struct _GstFdSocketSinkClass {
@@ -45,8 +45,13 @@
 #include <gst/video/video-frame.h>
 #include <gst/utils/common-utils.h>
 
-#define DEFAULT_SOCKET   NULL
-#define DEFAULT_TIMEOUT  1000
+#define DEFAULT_SOCKET         NULL
+#define DEFAULT_TIMEOUT        1000
+#define DEFAULT_SUBSCRIBE      FALSE
+#define DEFAULT_MAX_FPS_N      0
+#define DEFAULT_MAX_FPS_D      1
+
+#define CONNECT_RETRY_US       10000
 
 #define gst_socket_src_parent_class parent_class
 G_DEFINE_TYPE (GstFdSocketSrc, gst_socket_src, GST_TYPE_PUSH_SRC);
@@ -63,7 +68,9 @@ enum
 {
   PROP_0,
   PROP_SOCKET,
-  PROP_TIMEOUT
+  PROP_TIMEOUT,
+  PROP_SUBSCRIBE,
+  PROP_MAX_FRAMERATE,
 };
 
 static GstStaticPadTemplate socket_src_template =
@@ -181,6 +188,13 @@ gst_socket_src_set_property (GObject * object, guint prop_id,
       GST_DEBUG_OBJECT (src, "Socket poll timeout %" GST_TIME_FORMAT,
           GST_TIME_ARGS (timeout));
       break;
+    case PROP_SUBSCRIBE:
+      src->subscribe = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_FRAMERATE:
+      src->fps_n = gst_value_get_fraction_numerator (value);
+      src->fps_d = gst_value_get_fraction_denominator (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -235,6 +249,12 @@ gst_socket_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_TIMEOUT:
       g_value_set_uint64 (value, src->timeout);
       break;
+    case PROP_SUBSCRIBE:
+      g_value_set_boolean (value, src->subscribe);
+      break;
+    case PROP_MAX_FRAMERATE:
+      gst_value_set_fraction (value, src->fps_n, src->fps_d);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -242,13 +262,10 @@ gst_socket_src_get_property (GObject * object, guint prop_id, GValue * value,
   GST_OBJECT_UNLOCK (src);
 }
 
-static gpointer
-gst_socket_src_connection_handler (gpointer userdata)
+static gboolean
+gst_socket_src_accept (GstFdSocketSrc * src)
 {
-  GstFdSocketSrc *src = GST_SOCKET_SRC (userdata);
-
   struct sockaddr_un address = {0};
-  GstBufferPool *pool = NULL;
   gint addrlen = 0;
 
   g_mutex_lock (&src->mutex);
@@ -257,7 +274,7 @@ gst_socket_src_connection_handler (gpointer userdata)
   if (src->socket < 0) {
     GST_ERROR_OBJECT (src, "Socket creation error");
     g_mutex_unlock (&src->mutex);
-    return NULL;
+    return FALSE;
   }
 
   unlink (src->sockfile);
@@ -270,7 +287,7 @@ gst_socket_src_connection_handler (gpointer userdata)
     GST_ERROR_OBJECT (src, "Socket bind failed");
     src->stop_thread = TRUE;
     g_mutex_unlock (&src->mutex);
-    return NULL;
+    return FALSE;
   }
 
   if (listen (src->socket, 3) < 0) {
@@ -279,7 +296,7 @@ gst_socket_src_connection_handler (gpointer userdata)
     src->socket = 0;
     src->stop_thread = TRUE;
     g_mutex_unlock (&src->mutex);
-    return NULL;
+    return FALSE;
   }
 
   GST_DEBUG_OBJECT (src, "Socket accept");
@@ -295,9 +312,76 @@ gst_socket_src_connection_handler (gpointer userdata)
     g_mutex_lock (&src->mutex);
     src->stop_thread = TRUE;
     g_mutex_unlock (&src->mutex);
-    return NULL;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_socket_src_subscribe (GstFdSocketSrc * src)
+{
+  struct sockaddr_un address = {0};
+  GstPayloadInfo pl_info = {0};
+  GstSubscribePayload subscribe = { .identity = MESSAGE_SUBSCRIBE };
+  gint sock = -1;
+
+  address.sun_family = AF_UNIX;
+  g_strlcpy (address.sun_path, src->sockfile, sizeof (address.sun_path));
+
+  // The serving qtisocketsink may not be up yet, keep trying until stopped.
+  while (TRUE) {
+    g_mutex_lock (&src->mutex);
+    if (src->stop_thread) {
+      g_mutex_unlock (&src->mutex);
+      return FALSE;
+    }
+    g_mutex_unlock (&src->mutex);
+
+    if ((sock = socket (AF_UNIX, SOCK_SEQPACKET, 0)) < 0) {
+      GST_ERROR_OBJECT (src, "Socket creation error");
+      return FALSE;
+    }
+
+    if (connect (sock, (struct sockaddr *) &address, sizeof (address)) == 0)
+      break;
+
+    close (sock);
+    usleep (CONNECT_RETRY_US);
+  }
+
+  subscribe.interval = (src->fps_n > 0) ?
+      gst_util_uint64_scale_int (GST_SECOND, src->fps_d, src->fps_n) : 0;
+  pl_info.subscribe = &subscribe;
+
+  if (send_socket_message (sock, &pl_info) < 0) {
+    GST_ERROR_OBJECT (src, "Failed to send subscribe message");
+    close (sock);
+    return FALSE;
   }
 
+  GST_DEBUG_OBJECT (src, "Subscribed with interval %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (subscribe.interval));
+
+  src->client_sock = sock;
+  return TRUE;
+}
+
+static gpointer
+gst_socket_src_connection_handler (gpointer userdata)
+{
+  GstFdSocketSrc *src = GST_SOCKET_SRC (userdata);
+  GstBufferPool *pool = NULL;
+  gboolean success = FALSE;
+
+  if (src->subscribe)
+    success = gst_socket_src_subscribe (src);
+  else
+    success = gst_socket_src_accept (src);
+
+  if (!success)
+    return NULL;
+
   src->fdmap = g_hash_table_new (NULL, NULL);
   g_mutex_init (&src->fdmaplock);
 
@@ -388,11 +472,23 @@ gst_socket_src_socket_release (GstFdSocketSrc * src)
 
   g_thread_join (src->thread);
 
+  if (src->ring != NULL) {
+    shm_ring_free (src->ring);
+    src->ring = NULL;
+  }
+
+  g_free (src->ring_scratch);
+  src->ring_scratch = NULL;
+  src->ring_scratch_size = 0;
+
   g_mutex_lock (&src->mutex);
 
   src->thread = NULL;
   src->thread_done = FALSE;
-  unlink (src->sockfile);
+
+  // In subscribe mode the socket file belongs to the serving qtisocketsink.
+  if (!src->subscribe)
+    unlink (src->sockfile);
 
   g_mutex_unlock (&src->mutex);
 
@@ -473,7 +569,8 @@ gst_socket_src_flush_socket_queue (GstFdSocketSrc * src)
         .protection_metadata_info = g_ptr_array_new (),
         .roi_meta_info = g_ptr_array_new (),
         .class_meta_info = g_ptr_array_new (),
-        .lm_meta_info = g_ptr_array_new ()
+        .lm_meta_info = g_ptr_array_new (),
+        .ring_record_info = g_ptr_array_new_with_free_func (free)
       };
 
       gint fds[GST_MAX_MEM_BLOCKS] = {0};
@@ -510,19 +607,108 @@ gst_socket_src_flush_socket_queue (GstFdSocketSrc * src)
   } while (ret > 0);
 }
 
+static void
+gst_socket_src_accept_ring (GstFdSocketSrc * src, GstPayloadInfo * pl_info)
+{
+  GstPayloadInfo ack_info = {0};
+  GstRingSetupPayload ack = { .identity = MESSAGE_RING_SETUP };
+
+  if (GST_PL_INFO_GET_N_FDS (pl_info) != 1) {
+    GST_WARNING_OBJECT (src, "Shared memory ring offered without its fd");
+    return;
+  }
+
+  if (src->ring != NULL)
+    shm_ring_free (src->ring);
+
+  src->ring = shm_ring_import (pl_info->fds[0], pl_info->ring_setup->capacity);
+
+  if (src->ring == NULL) {
+    GST_WARNING_OBJECT (src, "Failed to map shared memory ring of %"
+        G_GUINT64_FORMAT " bytes", pl_info->ring_setup->capacity);
+    return;
+  }
+
+  ack.capacity = shm_ring_get_capacity (src->ring);
+  ack_info.ring_setup = &ack;
+
+  if (send_socket_message (src->client_sock, &ack_info) < 0) {
+    GST_WARNING_OBJECT (src, "Failed to acknowledge shared memory ring");
+    return;
+  }
+
+  GST_DEBUG_OBJECT (src, "Mapped shared memory ring of %" G_GUINT64_FORMAT
+      " bytes", ack.capacity);
+}
+
+// Copy the ring records referenced by the message out of the ring. Metadata
+// payloads are appended to the message arrays, text is returned as memory.
+static gboolean
+gst_socket_src_read_ring_records (GstFdSocketSrc * src,
+    GstPayloadInfo * pl_info, GList ** memories)
+{
+  gboolean success = TRUE;
+
+  for (guint i = 0; i < pl_info->ring_record_info->len; i++) {
+    GstRingRecordPayload *record =
+        g_ptr_array_index (pl_info->ring_record_info, i);
+    guint8 *data = NULL;
+
+    if (src->ring == NULL) {
+      GST_WARNING_OBJECT (src, "Ring record received without a ring");
+      return FALSE;
+    }
+
+    if (record->contents == RING_CONTENTS_TEXT) {
+      data = g_malloc (record->size);
+    } else {
+      if (src->ring_scratch_size < record->size) {
+        src->ring_scratch = g_realloc (src->ring_scratch, record->size);
+        src->ring_scratch_size = record->size;
+      }
+
+      data = src->ring_scratch;
+    }
+
+    if (!shm_ring_read (src->ring, record->seq, record->position,
+            record->size, data)) {
+      GST_WARNING_OBJECT (src, "Ring record %" G_GUINT64_FORMAT " was "
+          "overwritten before it was read", record->seq);
+
+      if (record->contents == RING_CONTENTS_TEXT)
+        g_free (data);
+
+      success = FALSE;
+      continue;
+    }
+
+    if (record->contents == RING_CONTENTS_TEXT) {
+      *memories = g_list_append (*memories, gst_memory_new_wrapped (0, data,
+          record->size, 0, record->size, data, g_free));
+    } else {
+      parse_socket_payloads ((gchar *) data, record->size, pl_info);
+    }
+  }
+
+  return success;
+}
+
 static GstFlowReturn
 gst_socket_src_fill_buffer (GstFdSocketSrc * src, GstBuffer ** outbuf)
 {
   GstAllocator *allocator = NULL;
   GstMemory *gstmemory = NULL;
   GstBuffer *gstbuffer = NULL;
+  GList *ring_memories = NULL;
+  gboolean ring_intact = TRUE;
   GstBufferReleaseData * release_data = g_malloc0 (sizeof (GstBufferReleaseData));
   GstPayloadInfo pl_info = {
       .mem_block_info = g_ptr_array_new (),
       .protection_metadata_info = g_ptr_array_new (),
       .roi_meta_info = g_ptr_array_new (),
       .class_meta_info = g_ptr_array_new (),
-      .lm_meta_info = g_ptr_array_new ()
+      .lm_meta_info = g_ptr_array_new (),
+      .ring_record_info = g_ptr_array_new_with_free_func (free)
   };
 
   gint fds[GST_MAX_MEM_BLOCKS] = {0};
@@ -553,10 +739,29 @@ gst_socket_src_fill_buffer (GstFdSocketSrc * src, GstBuffer ** outbuf)
     return GST_FLOW_EOS;
   }
 
+  if (pl_info.ring_setup != NULL) {
+    gst_socket_src_accept_ring (src, &pl_info);
+    g_free (release_data);
+    free_pl_struct (&pl_info);
+    return GST_FLOW_CUSTOM_SUCCESS;
+  }
+
+  if (pl_info.buffer_info == NULL) {
+    GST_ERROR_OBJECT (src, "Didn't receive GstBufferPayload");
+    g_free (release_data);
+    free_pl_struct (&pl_info);
+    return GST_FLOW_ERROR;
+  }
+
+  if (pl_info.ring_record_info->len > 0)
+    ring_intact = gst_socket_src_read_ring_records (src, &pl_info,
+        &ring_memories);
+
   for (guint i = 0; i < pl_info.mem_block_info->len; i++) {
     gpointer ptr = g_ptr_array_index (pl_info.mem_block_info, i);
 
     if (get_payload_size (ptr) == -1) {
+      g_list_free_full (ring_memories, (GDestroyNotify) gst_memory_unref);
       g_free (release_data);
       free_pl_struct (&pl_info);
       return GST_FLOW_ERROR;
@@ -584,9 +789,6 @@ gst_socket_src_fill_buffer (GstFdSocketSrc * src, GstBuffer ** outbuf)
     }
   }
 
-  if (pl_info.buffer_info == NULL)
-    GST_ERROR_OBJECT (src, "Didn't receive GstBufferPayload");
-
   //Start logic for batching from here
   for (guint i = 0; i < pl_info.mem_block_info->len; i++) {
     release_data->buf_id[i] = pl_info.buffer_info->buf_id[i];
@@ -843,6 +1045,15 @@ gst_socket_src_fill_buffer (GstFdSocketSrc * src, GstBuffer ** outbuf)
     gst_buffer_append_memory (gstbuffer, gstmemory);
   }
 
+  // Text carried in the shared memory ring follows the inline text blocks.
+  for (GList *list = ring_memories; list != NULL; list = list->next)
+    gst_buffer_append_memory (gstbuffer, GST_MEMORY_CAST (list->data));
+
+  g_list_free (ring_memories);
+
+  if (!ring_intact)
+    GST_BUFFER_FLAG_SET (gstbuffer, GST_BUFFER_FLAG_CORRUPTED);
+
   if (src->mode != DATA_MODE_TEXT) {
     // Unreference the allocator so that it is owned only by the gstmemory.
     gst_object_unref (allocator);
@@ -991,10 +1202,17 @@ gst_socket_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 
   g_mutex_unlock (&src->mutex);
 
-  GstFlowReturn ret = gst_socket_src_wait_buffer (src);
-  g_return_val_if_fail (ret == GST_FLOW_OK, ret);
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  // Control messages such as the ring offer do not produce a buffer.
+  do {
+    ret = gst_socket_src_wait_buffer (src);
+    g_return_val_if_fail (ret == GST_FLOW_OK, ret);
+
+    ret = gst_socket_src_fill_buffer (src, outbuf);
+  } while (ret == GST_FLOW_CUSTOM_SUCCESS);
 
-  return gst_socket_src_fill_buffer (src, outbuf);
+  return ret;
 }
 
 static void
@@ -1020,6 +1238,9 @@ gst_socket_src_init (GstFdSocketSrc * src)
   src->mlinfo = NULL;
   src->pool = NULL;
   src->mode = DATA_MODE_NONE;
+  src->subscribe = DEFAULT_SUBSCRIBE;
+  src->fps_n = DEFAULT_MAX_FPS_N;
+  src->fps_d = DEFAULT_MAX_FPS_D;
 
   g_cond_init (&src->cond);
   g_mutex_init (&src->mutex);
@@ -1060,6 +1281,21 @@ gst_socket_src_class_init (GstFdSocketSrcClass * klass)
         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
         GST_PARAM_MUTABLE_READY | G_PARAM_CONSTRUCT));
 
+  g_object_class_install_property (gobject, PROP_SUBSCRIBE,
+    g_param_spec_boolean ("subscribe", "Subscribe",
+        "Connect as one of the consumers of a qtisocketsink with "
+        "'max-consumers' set, instead of listening for a single qtisocketsink",
+        DEFAULT_SUBSCRIBE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+        GST_PARAM_MUTABLE_READY));
+
+  g_object_class_install_property (gobject, PROP_MAX_FRAMERATE,
+    gst_param_spec_fraction ("max-framerate", "Maximum framerate",
+        "Maximum rate at which the serving qtisocketsink delivers buffers "
+        "(applies only in 'subscribe' mode, 0/1 delivers every buffer)",
+        0, 1, G_MAXINT, 1, DEFAULT_MAX_FPS_N, DEFAULT_MAX_FPS_D,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+        GST_PARAM_MUTABLE_READY));
+
   gst_element_class_set_static_metadata (gstelement,
       "QTI Socket Source Element", "Socket Source Element",
       "This plugin receive GST buffer over Unix Domain Socket", "QTI");
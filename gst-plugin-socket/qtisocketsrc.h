@@ -40,6 +40,7 @@
 #include <gst/ml/ml-info.h>
 
 #include "qtifdsocket.h"
+#include "qtishmring.h"
 
 G_BEGIN_DECLS
 
@@ -84,6 +85,11 @@ struct _GstFdSocketSrc {
 
   gchar *sockfile;
 
+  // Connect to a qtisocketsink serving multiple consumers instead of listening.
+  gboolean subscribe;
+  gint     fps_n;
+  gint     fps_d;
+
   gint socket;
   gint client_sock;
 
@@ -92,6 +98,11 @@ struct _GstFdSocketSrc {
 
   GstBufferPool *pool;
 
+  // Shared memory ring offered by the sink and a scratch copy of its records.
+  GstShmRing *ring;
+  guint8     *ring_scratch;
+  gsize      ring_scratch_size;
+
   GstSegment segment;
 
   GstMLInfo *mlinfo;
@@ -9,8 +9,10 @@
 
 #include "sync.h"
 
+#include <stdio.h>
+
 #define GST_CAT_DEFAULT gst_sync_debug
-GST_DEBUG_CATEGORY_STATIC (gst_sync_debug);
+GST_DEBUG_CATEGORY (gst_sync_debug);
 
 #define gst_sync_parent_class parent_class
 G_DEFINE_TYPE (GstSync, gst_sync, GST_TYPE_ELEMENT);
@@ -21,6 +23,19 @@ G_DEFINE_TYPE (GstSync, gst_sync, GST_TYPE_ELEMENT);
 #define GST_SYNC_SRC_CAPS \
     "video/x-raw(ANY); "
 
+#define DEFAULT_PROP_MAX_LATENESS   (-1)
+#define DEFAULT_PROP_DECIMATION     1
+
+// Buffers released later than this are accounted as late.
+#define GST_SYNC_LATE_THRESHOLD     GST_MSECOND
+
+enum
+{
+  PROP_0,
+  PROP_MAX_LATENESS,
+  PROP_DECIMATION,
+};
+
 static GstStaticPadTemplate gst_sync_sink_pad_template =
     GST_STATIC_PAD_TEMPLATE ("sink",
         GST_PAD_SINK,
@@ -35,52 +50,326 @@ static GstStaticPadTemplate gst_sync_src_pad_template =
         GST_STATIC_CAPS (GST_SYNC_SRC_CAPS)
     );
 
+static GstStaticPadTemplate gst_sync_request_sink_pad_template =
+    GST_STATIC_PAD_TEMPLATE ("sink_%u",
+        GST_PAD_SINK,
+        GST_PAD_REQUEST,
+        GST_STATIC_CAPS (GST_SYNC_SINK_CAPS)
+    );
+
+static GstStaticPadTemplate gst_sync_sometimes_src_pad_template =
+    GST_STATIC_PAD_TEMPLATE ("src_%u",
+        GST_PAD_SRC,
+        GST_PAD_SOMETIMES,
+        GST_STATIC_CAPS (GST_SYNC_SRC_CAPS)
+    );
+
+static GstSyncSinkPad *
+gst_sync_next_pending_pad (GstSync * sync)
+{
+  GstSyncSinkPad *nextpad = NULL;
+  GList *list = NULL;
+
+  for (list = sync->sinkpads; list != NULL; list = list->next) {
+    GstSyncSinkPad *sinkpad = GST_SYNC_SINK_PAD (list->data);
+
+    if (!sinkpad->pending || sinkpad->released)
+      continue;
+
+    if ((nextpad == NULL) || (sinkpad->time < nextpad->time))
+      nextpad = sinkpad;
+  }
+
+  return nextpad;
+}
+
+static void
+gst_sync_worker_task (gpointer userdata)
+{
+  GstSync *sync = GST_SYNC (userdata);
+  GstSyncSinkPad *sinkpad = NULL;
+  GstClock *clock = NULL;
+  GstClockID clockid = NULL;
+  GstClockTime now = 0;
+  GList *list = NULL;
+
+  GST_SYNC_LOCK (sync);
+
+  while (sync->active && !(sinkpad = gst_sync_next_pending_pad (sync)))
+    g_cond_wait (&sync->wakeup, &sync->lock);
+
+  if (!sync->active) {
+    GST_SYNC_UNLOCK (sync);
+    return;
+  }
+
+  // Without a clock all pending buffers are released immediately.
+  if (sync->clock != NULL) {
+    clock = gst_object_ref (sync->clock);
+    now = gst_clock_get_time (clock);
+  }
+
+  if ((clock != NULL) && (sinkpad->time > now)) {
+    GST_TRACE_OBJECT (sinkpad, "Waiting for %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (sinkpad->time - now));
+
+    clockid = gst_clock_new_single_shot_id (clock, sinkpad->time);
+
+    sync->clockid = clockid;
+    sync->waittime = sinkpad->time;
+
+    GST_SYNC_UNLOCK (sync);
+
+    // Unscheduled when a buffer due before this one arrives or on stop.
+    gst_clock_id_wait (clockid, NULL);
+
+    GST_SYNC_LOCK (sync);
+
+    sync->clockid = NULL;
+    sync->waittime = GST_CLOCK_TIME_NONE;
+
+    GST_SYNC_UNLOCK (sync);
+
+    gst_clock_id_unref (clockid);
+    gst_object_unref (clock);
+    return;
+  }
+
+  // Release all streams whose buffers are due by now.
+  for (list = sync->sinkpads; list != NULL; list = list->next) {
+    sinkpad = GST_SYNC_SINK_PAD (list->data);
+
+    if (!sinkpad->pending || sinkpad->released)
+      continue;
+
+    if ((clock != NULL) && (sinkpad->time > now))
+      continue;
+
+    sinkpad->lateness =
+        (clock != NULL) ? GST_CLOCK_DIFF (sinkpad->time, now) : 0;
+    sinkpad->released = TRUE;
+
+    GST_TRACE_OBJECT (sinkpad, "Released with lateness %" GST_STIME_FORMAT,
+        GST_STIME_ARGS (sinkpad->lateness));
+  }
+
+  g_cond_broadcast (&sync->wakeup);
+  GST_SYNC_UNLOCK (sync);
+
+  if (clock != NULL)
+    gst_object_unref (clock);
+}
+
+static gboolean
+gst_sync_start_task (GstSync * sync)
+{
+  GST_SYNC_LOCK (sync);
+
+  if (sync->active) {
+    GST_SYNC_UNLOCK (sync);
+    return TRUE;
+  }
+
+  sync->worktask = gst_task_new (gst_sync_worker_task, sync, NULL);
+  gst_task_set_lock (sync->worktask, &sync->worklock);
+
+  GST_INFO_OBJECT (sync, "Created task %p", sync->worktask);
+
+  sync->active = TRUE;
+  GST_SYNC_UNLOCK (sync);
+
+  if (!gst_task_start (sync->worktask)) {
+    GST_ERROR_OBJECT (sync, "Failed to start worker task!");
+    return FALSE;
+  }
+
+  GST_INFO_OBJECT (sync, "Started task %p", sync->worktask);
+  return TRUE;
+}
+
+static gboolean
+gst_sync_stop_task (GstSync * sync)
+{
+  GST_SYNC_LOCK (sync);
+
+  if (!sync->active) {
+    GST_SYNC_UNLOCK (sync);
+    return TRUE;
+  }
+
+  GST_INFO_OBJECT (sync, "Stopping task %p", sync->worktask);
+
+  if (!gst_task_stop (sync->worktask))
+    GST_WARNING_OBJECT (sync, "Failed to stop worker task!");
+
+  sync->active = FALSE;
+
+  // Wake up the task in case it waits for the clock or for pending buffers.
+  if (sync->clockid != NULL)
+    gst_clock_id_unschedule (sync->clockid);
+
+  g_cond_broadcast (&sync->wakeup);
+  GST_SYNC_UNLOCK (sync);
+
+  // Make sure task is not running.
+  g_rec_mutex_lock (&sync->worklock);
+  g_rec_mutex_unlock (&sync->worklock);
+
+  if (!gst_task_join (sync->worktask)) {
+    GST_ERROR_OBJECT (sync, "Failed to join worker task!");
+    return FALSE;
+  }
+
+  GST_INFO_OBJECT (sync, "Removing task %p", sync->worktask);
+
+  gst_object_unref (sync->worktask);
+  sync->worktask = NULL;
+
+  return TRUE;
+}
+
+static void
+gst_sync_set_flushing (GstSync * sync, GstSyncSinkPad * sinkpad,
+    gboolean flushing)
+{
+  GST_SYNC_LOCK (sync);
+
+  sinkpad->flushing = flushing;
+
+  // Release the streaming thread in case it waits for its buffer to be due.
+  if (flushing)
+    g_cond_broadcast (&sync->wakeup);
+
+  GST_SYNC_UNLOCK (sync);
+}
+
+static void
+gst_sync_send_qos (GstSyncSinkPad * sinkpad, GstClockTime timestamp,
+    GstClockTimeDiff lateness)
+{
+  GstClockTime runningtime = GST_CLOCK_TIME_NONE;
+
+  if (sinkpad->segment.format == GST_FORMAT_TIME)
+    runningtime = gst_segment_to_running_time (&sinkpad->segment,
+        GST_FORMAT_TIME, timestamp);
+
+  if (!GST_CLOCK_TIME_IS_VALID (runningtime))
+    runningtime = timestamp;
+
+  GST_DEBUG_OBJECT (sinkpad, "Sending QoS, lateness %" GST_STIME_FORMAT
+      " at %" GST_TIME_FORMAT, GST_STIME_ARGS (lateness),
+      GST_TIME_ARGS (runningtime));
+
+  gst_pad_push_event (GST_PAD (sinkpad),
+      gst_event_new_qos (GST_QOS_TYPE_UNDERFLOW, 1.0, lateness, runningtime));
+}
+
 static GstFlowReturn
 gst_sync_sinkpad_chain (GstPad * pad, GstObject * parent, GstBuffer * in_buffer)
 {
   GstSync *sync = GST_SYNC (parent);
+  GstSyncSinkPad *sinkpad = GST_SYNC_SINK_PAD (pad);
+  GstClockTime timestamp = GST_BUFFER_TIMESTAMP (in_buffer);
+  GstClockTimeDiff lateness = 0;
+  gint64 max_lateness = -1;
+  const char *discont =
+      GST_BUFFER_IS_DISCONT (in_buffer) ? " with discontinuity" : "";
+
+  GST_SYNC_LOCK (sync);
 
   if (sync->clock == NULL) {
-    GST_TRACE_OBJECT (sync, "SKIP buffer, no clock");
+    GST_SYNC_UNLOCK (sync);
+
+    GST_TRACE_OBJECT (pad, "SKIP buffer, no clock");
     gst_buffer_unref (in_buffer);
     return GST_FLOW_OK;
   }
 
-  GstClockTime real_ts = gst_clock_get_time (sync->clock);
+  // Keep only the first out of every N buffers.
+  if ((sinkpad->n_received++ % sync->decimation) != 0) {
+    GST_SYNC_UNLOCK (sync);
 
-  if (sync->have_start_time) {
-    const char *discont =
-        GST_BUFFER_IS_DISCONT (in_buffer) ? " with discontinuity" : "";
-    GstClockTime expected_real_ts =
-        sync->stream_start_real_time + GST_BUFFER_TIMESTAMP (in_buffer);
-    gboolean early = real_ts < expected_real_ts;
+    GST_TRACE_OBJECT (pad, "ts: %" GST_TIME_FORMAT "%s, decimated",
+        GST_TIME_ARGS (timestamp), discont);
 
-    if (early) {
-      GstClockID cid = gst_clock_new_single_shot_id (sync->clock,
-          expected_real_ts);
+    gst_sync_sink_pad_account (sinkpad, GST_SYNC_FRAME_DROPPED);
+    gst_buffer_unref (in_buffer);
+    return GST_FLOW_OK;
+  }
 
-      GST_TRACE_OBJECT (sync, "ts: %" GST_TIME_FORMAT " %s, waiting for %ld ms",
-          GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (in_buffer)),
-          discont, (expected_real_ts - real_ts) / 1000000);
-      gst_clock_id_wait (cid, NULL);
-      gst_clock_id_unref (cid);
-    } else {
-      GST_TRACE_OBJECT (sync, "ts: %" GST_TIME_FORMAT " %s, pad on time",
-          GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (in_buffer)), discont);
-    }
-  } else {
-    sync->stream_start_real_time = real_ts - GST_BUFFER_TIMESTAMP (in_buffer);
+  // The first buffer of any stream sets the base time shared by all streams.
+  if (!sync->have_start_time && GST_CLOCK_TIME_IS_VALID (timestamp)) {
+    sync->stream_start_real_time =
+        gst_clock_get_time (sync->clock) - timestamp;
     sync->have_start_time = TRUE;
   }
 
-  GST_TRACE_OBJECT (sync, "Push buffer");
-  return gst_pad_push (sync->srcpad, in_buffer);
+  if (GST_CLOCK_TIME_IS_VALID (timestamp) && sync->have_start_time) {
+    sinkpad->time = sync->stream_start_real_time + timestamp;
+    sinkpad->released = FALSE;
+    sinkpad->pending = TRUE;
+
+    // Interrupt the timer if this buffer is due before the one it waits for.
+    if ((sync->clockid != NULL) && (sinkpad->time < sync->waittime))
+      gst_clock_id_unschedule (sync->clockid);
+
+    g_cond_broadcast (&sync->wakeup);
+
+    GST_TRACE_OBJECT (pad, "ts: %" GST_TIME_FORMAT "%s, waiting for release",
+        GST_TIME_ARGS (timestamp), discont);
+
+    while (!sinkpad->released && !sinkpad->flushing)
+      g_cond_wait (&sync->wakeup, &sync->lock);
+
+    sinkpad->pending = FALSE;
+    lateness = sinkpad->lateness;
+  }
+
+  if (sinkpad->flushing) {
+    GST_SYNC_UNLOCK (sync);
+
+    GST_TRACE_OBJECT (pad, "Flushing, dropping buffer");
+    gst_buffer_unref (in_buffer);
+    return GST_FLOW_FLUSHING;
+  }
+
+  max_lateness = sync->max_lateness;
+  GST_SYNC_UNLOCK (sync);
+
+  // Let upstream know it falls behind, only when the drop policy is active.
+  if ((max_lateness >= 0) && (lateness > GST_SYNC_LATE_THRESHOLD))
+    gst_sync_send_qos (sinkpad, timestamp, lateness);
+
+  if ((max_lateness >= 0) && (lateness > max_lateness)) {
+    GST_TRACE_OBJECT (pad, "ts: %" GST_TIME_FORMAT "%s, dropped, late by %"
+        GST_STIME_FORMAT, GST_TIME_ARGS (timestamp), discont,
+        GST_STIME_ARGS (lateness));
+
+    gst_sync_sink_pad_account (sinkpad, GST_SYNC_FRAME_DROPPED);
+    gst_buffer_unref (in_buffer);
+    return GST_FLOW_OK;
+  }
+
+  if (lateness > GST_SYNC_LATE_THRESHOLD) {
+    GST_TRACE_OBJECT (pad, "ts: %" GST_TIME_FORMAT "%s, late by %"
+        GST_STIME_FORMAT, GST_TIME_ARGS (timestamp), discont,
+        GST_STIME_ARGS (lateness));
+    gst_sync_sink_pad_account (sinkpad, GST_SYNC_FRAME_LATE);
+  } else {
+    GST_TRACE_OBJECT (pad, "ts: %" GST_TIME_FORMAT "%s, pad on time",
+        GST_TIME_ARGS (timestamp), discont);
+    gst_sync_sink_pad_account (sinkpad, GST_SYNC_FRAME_ON_TIME);
+  }
+
+  GST_TRACE_OBJECT (pad, "Push buffer");
+  return gst_pad_push (sinkpad->srcpad, in_buffer);
 }
 
 static gboolean
 gst_sync_sinkpad_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
   GstSync *sync = GST_SYNC (parent);
+  GstSyncSinkPad *sinkpad = GST_SYNC_SINK_PAD (pad);
   gboolean success = TRUE;
 
   switch (GST_EVENT_TYPE (event)) {
@@ -93,7 +382,7 @@ gst_sync_sinkpad_event (GstPad * pad, GstObject * parent, GstEvent * event)
       GST_DEBUG_OBJECT (pad, "Setting caps %" GST_PTR_FORMAT, caps);
 
       // Get the negotiated caps between the srcpad and its peer.
-      srccaps = gst_pad_get_allowed_caps (GST_PAD (sync->srcpad));
+      srccaps = gst_pad_get_allowed_caps (sinkpad->srcpad);
       GST_DEBUG_OBJECT (pad, "Source caps %" GST_PTR_FORMAT, srccaps);
 
       intersect = gst_caps_intersect (srccaps, caps);
@@ -110,11 +399,11 @@ gst_sync_sinkpad_event (GstPad * pad, GstObject * parent, GstEvent * event)
         return FALSE;
       }
 
-      if (gst_pad_has_current_caps (GST_PAD (sync->srcpad))) {
-        srccaps = gst_pad_get_current_caps (GST_PAD (sync->srcpad));
+      if (gst_pad_has_current_caps (sinkpad->srcpad)) {
+        srccaps = gst_pad_get_current_caps (sinkpad->srcpad);
 
         if (!gst_caps_is_equal (srccaps, caps))
-          gst_pad_mark_reconfigure (GST_PAD (sync->srcpad));
+          gst_pad_mark_reconfigure (sinkpad->srcpad);
 
         gst_caps_unref (srccaps);
       }
@@ -124,12 +413,25 @@ gst_sync_sinkpad_event (GstPad * pad, GstObject * parent, GstEvent * event)
       GST_DEBUG_OBJECT (pad, "Negotiated caps %" GST_PTR_FORMAT, caps);
 
       GST_DEBUG_OBJECT (pad, "Pushing new caps %" GST_PTR_FORMAT, caps);
-      gst_pad_push_event (GST_PAD (sync->srcpad), gst_event_new_caps (caps));
+      gst_pad_push_event (sinkpad->srcpad, gst_event_new_caps (caps));
 
       gst_event_unref (event);
 
       break;
     }
+    case GST_EVENT_SEGMENT:
+      gst_event_copy_segment (event, &sinkpad->segment);
+      success = gst_pad_push_event (sinkpad->srcpad, event);
+      break;
+    case GST_EVENT_FLUSH_START:
+      gst_sync_set_flushing (sync, sinkpad, TRUE);
+      success = gst_pad_push_event (sinkpad->srcpad, event);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_sync_set_flushing (sync, sinkpad, FALSE);
+      gst_segment_init (&sinkpad->segment, GST_FORMAT_UNDEFINED);
+      success = gst_pad_push_event (sinkpad->srcpad, event);
+      break;
     default:
       success = gst_pad_event_default (pad, parent, event);
       break;
@@ -138,11 +440,204 @@ gst_sync_sinkpad_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return success;
 }
 
+static GstIterator *
+gst_sync_iterate_internal_links (GstPad * pad, GstObject * parent)
+{
+  GstPad *opposite = NULL;
+  GstIterator *iterator = NULL;
+  GValue value = G_VALUE_INIT;
+
+  // Each sink pad is linked only to the source pad of the same stream.
+  if (GST_IS_SYNC_SINK_PAD (pad))
+    opposite = GST_SYNC_SINK_PAD (pad)->srcpad;
+  else
+    opposite = GST_PAD (gst_pad_get_element_private (pad));
+
+  if (opposite == NULL)
+    return NULL;
+
+  g_value_init (&value, GST_TYPE_PAD);
+  g_value_set_object (&value, opposite);
+
+  iterator = gst_iterator_new_single (GST_TYPE_PAD, &value);
+  g_value_unset (&value);
+
+  return iterator;
+}
+
+static GstPad *
+gst_sync_add_stream (GstSync * sync, GstPadTemplate * sinktempl,
+    GstPadTemplate * srctempl, const gchar * sinkname, const gchar * srcname)
+{
+  GstElement *element = GST_ELEMENT (sync);
+  GstPad *sinkpad = NULL, *srcpad = NULL;
+
+  sinkpad = g_object_new (GST_TYPE_SYNC_SINK_PAD, "name", sinkname,
+      "direction", sinktempl->direction, "template", sinktempl, NULL);
+  srcpad = gst_pad_new_from_template (srctempl, srcname);
+
+  if ((sinkpad == NULL) || (srcpad == NULL)) {
+    GST_ERROR_OBJECT (sync, "Failed to create %s/%s pads!", sinkname, srcname);
+
+    if (sinkpad != NULL)
+      gst_object_unref (sinkpad);
+
+    if (srcpad != NULL)
+      gst_object_unref (srcpad);
+
+    return NULL;
+  }
+
+  GST_SYNC_SINK_PAD_CAST (sinkpad)->srcpad = srcpad;
+  gst_pad_set_element_private (srcpad, sinkpad);
+
+  gst_pad_set_chain_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_sync_sinkpad_chain));
+  gst_pad_set_event_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_sync_sinkpad_event));
+  gst_pad_set_iterate_internal_links_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_sync_iterate_internal_links));
+  gst_pad_set_iterate_internal_links_function (srcpad,
+      GST_DEBUG_FUNCPTR (gst_sync_iterate_internal_links));
+
+  GST_OBJECT_FLAG_SET (sinkpad, GST_PAD_FLAG_PROXY_ALLOCATION);
+
+  if (!gst_element_add_pad (element, sinkpad)) {
+    GST_ERROR_OBJECT (sync, "Failed to add sink pad %s!", sinkname);
+
+    gst_object_unref (sinkpad);
+    gst_object_unref (srcpad);
+    return NULL;
+  }
+
+  if (!gst_element_add_pad (element, srcpad)) {
+    GST_ERROR_OBJECT (sync, "Failed to add source pad %s!", srcname);
+
+    gst_element_remove_pad (element, sinkpad);
+    gst_object_unref (srcpad);
+    return NULL;
+  }
+
+  GST_SYNC_LOCK (sync);
+  sync->sinkpads = g_list_append (sync->sinkpads, sinkpad);
+  GST_SYNC_UNLOCK (sync);
+
+  return sinkpad;
+}
+
+static GstPad *
+gst_sync_request_pad (GstElement * element, GstPadTemplate * templ,
+    const gchar * reqname, const GstCaps * caps)
+{
+  GstSync *sync = GST_SYNC (element);
+  GstPadTemplate *srctempl = NULL;
+  GstPad *pad = NULL;
+  gchar *sinkname = NULL, *srcname = NULL;
+  guint index = 0;
+
+  GST_SYNC_LOCK (sync);
+
+  if (reqname && sscanf (reqname, "sink_%u", &index) == 1) {
+    // Update the next sink pad index.
+    sync->nextidx = (index >= sync->nextidx) ? index + 1 : sync->nextidx;
+  } else {
+    index = sync->nextidx++;
+  }
+
+  GST_SYNC_UNLOCK (sync);
+
+  sinkname = g_strdup_printf ("sink_%u", index);
+  srcname = g_strdup_printf ("src_%u", index);
+
+  srctempl = gst_static_pad_template_get (&gst_sync_sometimes_src_pad_template);
+  pad = gst_sync_add_stream (sync, templ, srctempl, sinkname, srcname);
+  gst_object_unref (srctempl);
+
+  g_free (sinkname);
+  g_free (srcname);
+
+  if (pad == NULL)
+    return NULL;
+
+  GST_DEBUG_OBJECT (sync, "Created pad: %s", GST_PAD_NAME (pad));
+  return pad;
+}
+
+static void
+gst_sync_release_pad (GstElement * element, GstPad * pad)
+{
+  GstSync *sync = GST_SYNC (element);
+  GstPad *srcpad = GST_SYNC_SINK_PAD (pad)->srcpad;
+
+  GST_DEBUG_OBJECT (sync, "Releasing pad: %s", GST_PAD_NAME (pad));
+
+  GST_SYNC_LOCK (sync);
+  sync->sinkpads = g_list_remove (sync->sinkpads, pad);
+  GST_SYNC_UNLOCK (sync);
+
+  gst_sync_set_flushing (sync, GST_SYNC_SINK_PAD (pad), TRUE);
+
+  // Removing the sink pad waits for its streaming thread to finish.
+  gst_object_ref (srcpad);
+  gst_element_remove_pad (element, pad);
+  gst_element_remove_pad (element, srcpad);
+  gst_object_unref (srcpad);
+}
+
+static GstStateChangeReturn
+gst_sync_change_state (GstElement * element, GstStateChange transition)
+{
+  GstSync *sync = GST_SYNC (element);
+  GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+  GList *list = NULL;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      GST_SYNC_LOCK (sync);
+
+      sync->have_start_time = FALSE;
+
+      for (list = sync->sinkpads; list != NULL; list = list->next) {
+        GstSyncSinkPad *sinkpad = GST_SYNC_SINK_PAD (list->data);
+
+        sinkpad->flushing = FALSE;
+        sinkpad->n_received = 0;
+        gst_segment_init (&sinkpad->segment, GST_FORMAT_UNDEFINED);
+
+        gst_sync_sink_pad_reset (sinkpad);
+      }
+
+      GST_SYNC_UNLOCK (sync);
+
+      gst_sync_start_task (sync);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_SYNC_LOCK (sync);
+
+      for (list = sync->sinkpads; list != NULL; list = list->next)
+        GST_SYNC_SINK_PAD (list->data)->flushing = TRUE;
+
+      g_cond_broadcast (&sync->wakeup);
+      GST_SYNC_UNLOCK (sync);
+
+      gst_sync_stop_task (sync);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  return ret;
+}
+
 static gboolean
 gst_sync_set_clock (GstElement * element, GstClock * clock)
 {
   GstSync *sync = GST_SYNC (element);
 
+  GST_SYNC_LOCK (sync);
+
   if (sync->clock) {
     gst_object_unref (sync->clock);
     sync->clock = NULL;
@@ -151,7 +646,55 @@ gst_sync_set_clock (GstElement * element, GstClock * clock)
   if (clock != NULL)
     sync->clock = gst_object_ref (clock);
 
-  return TRUE;
+  GST_SYNC_UNLOCK (sync);
+
+  return GST_ELEMENT_CLASS (parent_class)->set_clock (element, clock);
+}
+
+static void
+gst_sync_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSync *sync = GST_SYNC (object);
+
+  GST_SYNC_LOCK (sync);
+
+  switch (property_id) {
+    case PROP_MAX_LATENESS:
+      sync->max_lateness = g_value_get_int64 (value);
+      break;
+    case PROP_DECIMATION:
+      sync->decimation = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+
+  GST_SYNC_UNLOCK (sync);
+}
+
+static void
+gst_sync_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSync *sync = GST_SYNC (object);
+
+  GST_SYNC_LOCK (sync);
+
+  switch (property_id) {
+    case PROP_MAX_LATENESS:
+      g_value_set_int64 (value, sync->max_lateness);
+      break;
+    case PROP_DECIMATION:
+      g_value_set_uint (value, sync->decimation);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+
+  GST_SYNC_UNLOCK (sync);
 }
 
 static void
@@ -164,30 +707,50 @@ gst_sync_finalize (GObject * object)
     sync->clock = NULL;
   }
 
+  g_list_free (sync->sinkpads);
+
+  g_rec_mutex_clear (&sync->worklock);
+
+  g_cond_clear (&sync->wakeup);
+  g_mutex_clear (&sync->lock);
+
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (sync));
 }
 
 static void
 gst_sync_init (GstSync * sync)
 {
+  GstPadTemplate *sinktempl = NULL, *srctempl = NULL;
+
+  g_mutex_init (&sync->lock);
+  g_cond_init (&sync->wakeup);
+
+  sync->nextidx = 0;
+  sync->sinkpads = NULL;
+
+  sync->worktask = NULL;
+  g_rec_mutex_init (&sync->worklock);
+  sync->active = FALSE;
+
+  sync->clockid = NULL;
+  sync->waittime = GST_CLOCK_TIME_NONE;
+
   sync->clock = NULL;
   sync->have_start_time = FALSE;
 
-  sync->sinkpad =
-      gst_pad_new_from_static_template (&gst_sync_sink_pad_template, "sink");
-
-  sync->srcpad =
-      gst_pad_new_from_static_template (&gst_sync_src_pad_template, "src");
+  sync->max_lateness = DEFAULT_PROP_MAX_LATENESS;
+  sync->decimation = DEFAULT_PROP_DECIMATION;
 
-  gst_pad_set_chain_function (sync->sinkpad,
-      GST_DEBUG_FUNCPTR (gst_sync_sinkpad_chain));
-  gst_pad_set_event_function (sync->sinkpad,
-      GST_DEBUG_FUNCPTR (gst_sync_sinkpad_event));
+  sinktempl = gst_static_pad_template_get (&gst_sync_sink_pad_template);
+  srctempl = gst_static_pad_template_get (&gst_sync_src_pad_template);
 
-  GST_OBJECT_FLAG_SET (sync->sinkpad, GST_PAD_FLAG_PROXY_ALLOCATION);
+  sync->sinkpad =
+      gst_sync_add_stream (sync, sinktempl, srctempl, "sink", "src");
+  sync->srcpad = (sync->sinkpad != NULL) ?
+      GST_SYNC_SINK_PAD (sync->sinkpad)->srcpad : NULL;
 
-  gst_element_add_pad (GST_ELEMENT (sync), sync->sinkpad);
-  gst_element_add_pad (GST_ELEMENT (sync), sync->srcpad);
+  gst_object_unref (sinktempl);
+  gst_object_unref (srctempl);
 }
 
 static void
@@ -196,18 +759,42 @@ gst_sync_class_init (GstSyncClass * klass)
   GObjectClass *gobject = G_OBJECT_CLASS (klass);
   GstElementClass *element = GST_ELEMENT_CLASS (klass);
 
+  gobject->set_property = GST_DEBUG_FUNCPTR (gst_sync_set_property);
+  gobject->get_property = GST_DEBUG_FUNCPTR (gst_sync_get_property);
   gobject->finalize = GST_DEBUG_FUNCPTR (gst_sync_finalize);
 
+  g_object_class_install_property (gobject, PROP_MAX_LATENESS,
+      g_param_spec_int64 ("max-lateness", "Max Lateness",
+          "Maximum lateness in nanoseconds after which frames are dropped "
+          "and QoS events are sent upstream (-1 = push all late frames)",
+          -1, G_MAXINT64, DEFAULT_PROP_MAX_LATENESS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_DECIMATION,
+      g_param_spec_uint ("decimation", "Decimation",
+          "Keep only 1 out of every N frames on each stream",
+          1, G_MAXUINT, DEFAULT_PROP_DECIMATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
   element->set_clock = GST_DEBUG_FUNCPTR (gst_sync_set_clock);
+  element->request_new_pad = GST_DEBUG_FUNCPTR (gst_sync_request_pad);
+  element->release_pad = GST_DEBUG_FUNCPTR (gst_sync_release_pad);
+  element->change_state = GST_DEBUG_FUNCPTR (gst_sync_change_state);
 
   gst_element_class_add_static_pad_template (element,
       &gst_sync_sink_pad_template);
   gst_element_class_add_static_pad_template (element,
       &gst_sync_src_pad_template);
+  gst_element_class_add_static_pad_template_with_gtype (element,
+      &gst_sync_request_sink_pad_template, GST_TYPE_SYNC_SINK_PAD);
+  gst_element_class_add_static_pad_template (element,
+      &gst_sync_sometimes_src_pad_template);
 
   gst_element_class_set_static_metadata (element,
       "Sync", "Video/Audio/Text/Muxer",
-      "Filter that throttles pipeline throughput to real time", "QTI");
+      "Filter that throttles the throughput of one or more streams to "
+      "real time", "QTI");
 
   GST_DEBUG_CATEGORY_INIT (gst_sync_debug, "qtisync", 0,
       "QTI Sync Plugin");
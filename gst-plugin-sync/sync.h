@@ -8,6 +8,8 @@
 
 #include <gst/gst.h>
 
+#include "syncpads.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_SYNC (gst_sync_get_type())
@@ -21,6 +23,10 @@ G_BEGIN_DECLS
   (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_SYNC))
 #define GST_SYNC_CAST(obj) ((GstSync *)(obj))
 
+#define GST_SYNC_GET_LOCK(obj) (&GST_SYNC(obj)->lock)
+#define GST_SYNC_LOCK(obj)     g_mutex_lock(GST_SYNC_GET_LOCK(obj))
+#define GST_SYNC_UNLOCK(obj)   g_mutex_unlock(GST_SYNC_GET_LOCK(obj))
+
 typedef struct _GstSync GstSync;
 typedef struct _GstSyncClass GstSyncClass;
 
@@ -28,12 +34,36 @@ struct _GstSync
 {
   GstElement parent;
 
+  /// Global mutex lock, protects the pending state of all sink pads.
+  GMutex lock;
+  /// Signalled when a sink pad has a new pending buffer or it was released.
+  GCond wakeup;
+
+  /// Always present stream pads.
   GstPad *srcpad;
   GstPad *sinkpad;
 
+  /// Next available index for the request pads.
+  guint nextidx;
+  /// List of all sink pads, including the always present one.
+  GList *sinkpads;
+
+  /// Timer task releasing the pending buffers of all streams.
+  GstTask *worktask;
+  GRecMutex worklock;
+  gboolean active;
+
+  /// Clock ID on which the timer task currently waits and its time.
+  GstClockID clockid;
+  GstClockTime waittime;
+
   GstClock *clock;
   gboolean have_start_time;
   GstClockTimeDiff stream_start_real_time;
+
+  /// Properties.
+  gint64 max_lateness;
+  guint decimation;
 };
 
 struct _GstSyncClass
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "syncpads.h"
+
+GST_DEBUG_CATEGORY_EXTERN (gst_sync_debug);
+#define GST_CAT_DEFAULT gst_sync_debug
+
+G_DEFINE_TYPE(GstSyncSinkPad, gst_sync_sink_pad, GST_TYPE_PAD);
+
+enum
+{
+  PROP_0,
+  PROP_ON_TIME,
+  PROP_LATE,
+  PROP_DROPPED,
+};
+
+void
+gst_sync_sink_pad_account (GstSyncSinkPad * pad, GstSyncFrameStatus status)
+{
+  GST_OBJECT_LOCK (pad);
+
+  switch (status) {
+    case GST_SYNC_FRAME_ON_TIME:
+      pad->n_ontime++;
+      break;
+    case GST_SYNC_FRAME_LATE:
+      pad->n_late++;
+      break;
+    case GST_SYNC_FRAME_DROPPED:
+      pad->n_dropped++;
+      break;
+  }
+
+  GST_OBJECT_UNLOCK (pad);
+}
+
+void
+gst_sync_sink_pad_reset (GstSyncSinkPad * pad)
+{
+  GST_OBJECT_LOCK (pad);
+
+  pad->n_ontime = 0;
+  pad->n_late = 0;
+  pad->n_dropped = 0;
+
+  GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_sync_sink_pad_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSyncSinkPad *pad = GST_SYNC_SINK_PAD (object);
+
+  GST_OBJECT_LOCK (pad);
+
+  switch (property_id) {
+    case PROP_ON_TIME:
+      g_value_set_uint64 (value, pad->n_ontime);
+      break;
+    case PROP_LATE:
+      g_value_set_uint64 (value, pad->n_late);
+      break;
+    case PROP_DROPPED:
+      g_value_set_uint64 (value, pad->n_dropped);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+
+  GST_OBJECT_UNLOCK (pad);
+}
+
+void
+gst_sync_sink_pad_class_init (GstSyncSinkPadClass * klass)
+{
+  GObjectClass *gobject = (GObjectClass *) klass;
+
+  gobject->get_property = GST_DEBUG_FUNCPTR (gst_sync_sink_pad_get_property);
+
+  g_object_class_install_property (gobject, PROP_ON_TIME,
+      g_param_spec_uint64 ("on-time", "On time",
+          "Number of frames pushed on time", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_LATE,
+      g_param_spec_uint64 ("late", "Late",
+          "Number of frames pushed late but within the max lateness",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_DROPPED,
+      g_param_spec_uint64 ("dropped", "Dropped",
+          "Number of frames dropped due to lateness or rate decimation",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
+
+void
+gst_sync_sink_pad_init (GstSyncSinkPad * pad)
+{
+  pad->srcpad = NULL;
+  gst_segment_init (&pad->segment, GST_FORMAT_UNDEFINED);
+
+  pad->time = GST_CLOCK_TIME_NONE;
+  pad->pending = FALSE;
+  pad->released = FALSE;
+  pad->lateness = 0;
+  pad->flushing = FALSE;
+
+  pad->n_received = 0;
+
+  pad->n_ontime = 0;
+  pad->n_late = 0;
+  pad->n_dropped = 0;
+}
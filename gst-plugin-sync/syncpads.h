@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GST_SYNC_PADS_H__
+#define __GST_SYNC_PADS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_SYNC_SINK_PAD (gst_sync_sink_pad_get_type())
+#define GST_SYNC_SINK_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_SYNC_SINK_PAD,\
+      GstSyncSinkPad))
+#define GST_SYNC_SINK_PAD_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_SYNC_SINK_PAD,\
+      GstSyncSinkPadClass))
+#define GST_IS_SYNC_SINK_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_SYNC_SINK_PAD))
+#define GST_IS_SYNC_SINK_PAD_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_SYNC_SINK_PAD))
+#define GST_SYNC_SINK_PAD_CAST(obj) ((GstSyncSinkPad *)(obj))
+
+typedef struct _GstSyncSinkPad GstSyncSinkPad;
+typedef struct _GstSyncSinkPadClass GstSyncSinkPadClass;
+
+typedef enum {
+  GST_SYNC_FRAME_ON_TIME,
+  GST_SYNC_FRAME_LATE,
+  GST_SYNC_FRAME_DROPPED,
+} GstSyncFrameStatus;
+
+struct _GstSyncSinkPad {
+  /// Inherited parent structure.
+  GstPad        parent;
+
+  /// Source pad on which the paced buffers of this stream are pushed.
+  GstPad        *srcpad;
+  /// Segment of the stream, used for the QoS timestamps.
+  GstSegment    segment;
+
+  /// Real time at which the pending buffer is due, protected by element lock.
+  GstClockTime  time;
+  /// Whether the streaming thread waits for the pending buffer to be released.
+  gboolean      pending;
+  /// Whether the pending buffer was released by the timer thread.
+  gboolean      released;
+  /// How late the pending buffer was released.
+  GstClockTimeDiff lateness;
+  /// Whether the pad is flushing, releases the waiting streaming thread.
+  gboolean      flushing;
+
+  /// Number of received buffers, used for rate decimation.
+  guint64       n_received;
+
+  /// Frame statistics, protected by the pad object lock.
+  guint64       n_ontime;
+  guint64       n_late;
+  guint64       n_dropped;
+};
+
+struct _GstSyncSinkPadClass {
+  /// Inherited parent structure.
+  GstPadClass   parent;
+};
+
+GType gst_sync_sink_pad_get_type (void);
+
+void gst_sync_sink_pad_account (GstSyncSinkPad * pad,
+                                GstSyncFrameStatus status);
+
+void gst_sync_sink_pad_reset (GstSyncSinkPad * pad);
+
+G_END_DECLS
+
+#endif // __GST_SYNC_PADS_H__
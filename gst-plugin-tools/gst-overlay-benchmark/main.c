@@ -0,0 +1,358 @@
+/*
+* Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+* SPDX-License-Identifier: BSD-3-Clause-Clear
+*/
+
+// Measures the per-frame cost of qtivoverlay for a sweep over the number of
+// detection ROIs per frame. Frames from the source get synthetic ROI metas
+// attached right before the overlay and the time between its sink and source
+// pads is reported.
+//
+//   gst-overlay-benchmark -r 1,10,50,100,200 -f 600
+//   gst-overlay-benchmark -r 100 -l 0
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#define DEFAULT_SWEEP         "1,10,25,50,100,200"
+#define DEFAULT_SOURCE        "videotestsrc pattern=black"
+#define DEFAULT_FORMAT        "NV12"
+#define DEFAULT_WIDTH         1920
+#define DEFAULT_HEIGHT        1080
+#define DEFAULT_N_FRAMES      300
+#define DEFAULT_N_WARMUP      10
+#define DEFAULT_N_LABELS      10
+
+#define PIPELINE_DESCRIPTION \
+    "%s name=source ! video/x-raw,format=%s,width=%d,height=%d ! " \
+    "qtivoverlay name=overlay ! fakesink sync=false"
+
+// Bounding box color in RGBA format.
+#define ROI_COLOR             0x00FF00FF
+
+typedef struct _GstBenchmarkContext GstBenchmarkContext;
+
+struct _GstBenchmarkContext {
+  // Number of ROIs attached to each frame.
+  guint   n_rois;
+  // Number of distinct labels, 0 for a unique label for every ROI.
+  guint   n_labels;
+
+  gint    width;
+  gint    height;
+
+  // Index of the current frame and the time it entered the overlay.
+  guint   frame;
+  gint64  start;
+
+  // Per-frame durations in microseconds, without the warmup frames.
+  GArray  *durations;
+};
+
+/// Command line option variables.
+static gchar *sweep = NULL;
+static gchar *source = NULL;
+static gchar *format = NULL;
+static gint width = DEFAULT_WIDTH;
+static gint height = DEFAULT_HEIGHT;
+static gint n_frames = DEFAULT_N_FRAMES;
+static gint n_warmup = DEFAULT_N_WARMUP;
+static gint n_labels = DEFAULT_N_LABELS;
+
+static const GOptionEntry entries[] = {
+    {"rois", 'r', 0, G_OPTION_ARG_STRING, &sweep,
+        "Comma separated numbers of ROIs per frame (default "
+        DEFAULT_SWEEP ")", "N[,N...]"
+    },
+    {"source", 's', 0, G_OPTION_ARG_STRING, &source,
+        "Source element, it has to support the 'num-buffers' property "
+        "(default '" DEFAULT_SOURCE "')", "DESCRIPTION"
+    },
+    {"format", 'c', 0, G_OPTION_ARG_STRING, &format,
+        "Video format (default " DEFAULT_FORMAT ")", "FORMAT"
+    },
+    {"width", 'W', 0, G_OPTION_ARG_INT, &width,
+        "Video width", "WIDTH"
+    },
+    {"height", 'H', 0, G_OPTION_ARG_INT, &height,
+        "Video height", "HEIGHT"
+    },
+    {"frames", 'f', 0, G_OPTION_ARG_INT, &n_frames,
+        "Number of measured frames per ROI count", "FRAMES"
+    },
+    {"warmup", 'w', 0, G_OPTION_ARG_INT, &n_warmup,
+        "Number of leading frames excluded from the statistics", "WARMUP"
+    },
+    {"labels", 'l', 0, G_OPTION_ARG_INT, &n_labels,
+        "Number of distinct labels, 0 gives every ROI of every frame a "
+        "unique label in order to defeat the label cache", "LABELS"
+    },
+    {NULL}
+};
+
+// Boxes are laid out on a grid which shifts with every frame.
+static void
+attach_roi_metas (GstBenchmarkContext * ctx, GstBuffer * buffer)
+{
+  GstVideoRegionOfInterestMeta *roimeta = NULL;
+  GstStructure *objparam = NULL;
+  gchar name[32] = { 0, };
+  guint idx = 0, n_columns = 0, x = 0, y = 0, w = 0, h = 0;
+
+  while (n_columns * n_columns < ctx->n_rois)
+    n_columns++;
+
+  w = MAX (ctx->width / (n_columns + 1), 8);
+  h = MAX (ctx->height / (n_columns + 1), 8);
+
+  for (idx = 0; idx < ctx->n_rois; idx++) {
+    x = ((idx % n_columns) * w + ctx->frame * 2) % (ctx->width - w);
+    y = ((idx / n_columns) * h + ctx->frame) % (ctx->height - h);
+
+    g_snprintf (name, sizeof (name), "object-%u",
+        (ctx->n_labels != 0) ? (idx % ctx->n_labels) : idx);
+
+    roimeta = gst_buffer_add_video_region_of_interest_meta (buffer, name,
+        x, y, w * 3 / 4, h * 3 / 4);
+    roimeta->id = idx;
+
+    objparam = gst_structure_new ("ObjectDetection",
+        "confidence", G_TYPE_DOUBLE, 90.0,
+        "color", G_TYPE_UINT, ROI_COLOR, NULL);
+
+    // The tracking ID is part of the label text, change it for every frame.
+    if (ctx->n_labels == 0)
+      gst_structure_set (objparam, "tracking-id", G_TYPE_UINT, ctx->frame,
+          NULL);
+
+    gst_video_region_of_interest_meta_add_param (roimeta, objparam);
+  }
+}
+
+static GstPadProbeReturn
+overlay_sink_probe (GstPad * pad, GstPadProbeInfo * info, gpointer userdata)
+{
+  GstBenchmarkContext *ctx = userdata;
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  buffer = gst_buffer_make_writable (buffer);
+  attach_roi_metas (ctx, buffer);
+
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+  ctx->start = g_get_monotonic_time ();
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+overlay_src_probe (GstPad * pad, GstPadProbeInfo * info, gpointer userdata)
+{
+  GstBenchmarkContext *ctx = userdata;
+  gdouble duration = g_get_monotonic_time () - ctx->start;
+
+  if (ctx->frame++ >= (guint) n_warmup)
+    g_array_append_val (ctx->durations, duration);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static gint
+compare_durations (gconstpointer a, gconstpointer b)
+{
+  gdouble l_value = *((const gdouble *) a), r_value = *((const gdouble *) b);
+  return (l_value > r_value) - (l_value < r_value);
+}
+
+static gboolean
+add_pad_probe (GstElement * element, const gchar * name,
+    GstPadProbeCallback callback, GstBenchmarkContext * ctx)
+{
+  GstPad *pad = gst_element_get_static_pad (element, name);
+
+  if (pad == NULL) {
+    g_printerr ("ERROR: Failed to get '%s' pad of overlay!\n", name);
+    return FALSE;
+  }
+
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, callback, ctx, NULL);
+  gst_object_unref (pad);
+
+  return TRUE;
+}
+
+static gboolean
+run_pipeline (GstBenchmarkContext * ctx)
+{
+  GstElement *pipeline = NULL, *element = NULL;
+  GstBus *bus = NULL;
+  GstMessage *message = NULL;
+  GError *error = NULL;
+  gchar *description = NULL;
+  gboolean success = FALSE;
+
+  description = g_strdup_printf (PIPELINE_DESCRIPTION, source, format,
+      ctx->width, ctx->height);
+
+  pipeline = gst_parse_launch (description, &error);
+  g_free (description);
+
+  if (pipeline == NULL) {
+    g_printerr ("ERROR: Failed to create pipeline: %s!\n",
+        GST_STR_NULL (error->message));
+    g_clear_error (&error);
+    return FALSE;
+  }
+
+  g_clear_error (&error);
+
+  element = gst_bin_get_by_name (GST_BIN (pipeline), "source");
+  g_object_set (element, "num-buffers", n_warmup + n_frames, NULL);
+  gst_object_unref (element);
+
+  element = gst_bin_get_by_name (GST_BIN (pipeline), "overlay");
+  success = add_pad_probe (element, "sink", overlay_sink_probe, ctx) &&
+      add_pad_probe (element, "src", overlay_src_probe, ctx);
+  gst_object_unref (element);
+
+  if (!success) {
+    gst_object_unref (pipeline);
+    return FALSE;
+  }
+
+  if (gst_element_set_state (pipeline, GST_STATE_PLAYING) ==
+          GST_STATE_CHANGE_FAILURE) {
+    g_printerr ("ERROR: Failed to transition to PLAYING state!\n");
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+    return FALSE;
+  }
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR) {
+    gchar *debug = NULL;
+
+    gst_message_parse_error (message, &error, &debug);
+    g_printerr ("ERROR: %s\n%s\n", error->message, GST_STR_NULL (debug));
+
+    g_clear_error (&error);
+    g_free (debug);
+
+    success = FALSE;
+  }
+
+  gst_message_unref (message);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return success;
+}
+
+static void
+print_stats (GstBenchmarkContext * ctx)
+{
+  GArray *durations = ctx->durations;
+  gdouble mean = 0.0;
+  guint idx = 0, last = durations->len - 1;
+
+  for (idx = 0; idx < durations->len; idx++)
+    mean += g_array_index (durations, gdouble, idx);
+
+  mean /= durations->len;
+
+  g_array_sort (durations, compare_durations);
+
+  g_print ("%6u %7u %9.1f %9.1f %9.1f %9.1f %9.1f\n", ctx->n_rois,
+      durations->len, mean,
+      g_array_index (durations, gdouble, last * 50 / 100),
+      g_array_index (durations, gdouble, last * 95 / 100),
+      g_array_index (durations, gdouble, last * 99 / 100),
+      g_array_index (durations, gdouble, last));
+}
+
+gint
+main (gint argc, gchar *argv[])
+{
+  GOptionContext *optctx = NULL;
+  GError *error = NULL;
+  gchar **counts = NULL;
+  guint idx = 0;
+  gint status = 0;
+
+  optctx = g_option_context_new ("- qtivoverlay per-frame cost benchmark");
+  g_option_context_add_main_entries (optctx, entries, NULL);
+  g_option_context_add_group (optctx, gst_init_get_option_group ());
+
+  if (!g_option_context_parse (optctx, &argc, &argv, &error)) {
+    g_printerr ("ERROR: Failed to parse command line options: %s!\n",
+        GST_STR_NULL (error->message));
+
+    g_clear_error (&error);
+    g_option_context_free (optctx);
+    return -1;
+  }
+
+  g_option_context_free (optctx);
+
+  if (n_frames <= 0 || n_warmup < 0 || n_labels < 0 ||
+      width <= 16 || height <= 16) {
+    g_printerr ("ERROR: Invalid frames, warmup, labels or dimensions!\n");
+    return -1;
+  }
+
+  if (sweep == NULL)
+    sweep = g_strdup (DEFAULT_SWEEP);
+  if (source == NULL)
+    source = g_strdup (DEFAULT_SOURCE);
+  if (format == NULL)
+    format = g_strdup (DEFAULT_FORMAT);
+
+  g_print ("%6s %7s %9s %9s %9s %9s %9s\n", "rois", "frames", "mean[us]",
+      "p50[us]", "p95[us]", "p99[us]", "max[us]");
+
+  counts = g_strsplit (sweep, ",", -1);
+
+  for (idx = 0; counts[idx] != NULL; idx++) {
+    GstBenchmarkContext ctx = { 0, };
+    gint64 n_rois = g_ascii_strtoll (counts[idx], NULL, 10);
+
+    if (n_rois <= 0 || n_rois > G_MAXUINT16) {
+      g_printerr ("ERROR: Invalid number of ROIs '%s'!\n", counts[idx]);
+      status = -1;
+      break;
+    }
+
+    ctx.n_rois = n_rois;
+    ctx.n_labels = n_labels;
+    ctx.width = width;
+    ctx.height = height;
+    ctx.durations = g_array_sized_new (FALSE, FALSE, sizeof (gdouble),
+        n_frames);
+
+    if (run_pipeline (&ctx) && ctx.durations->len > 0) {
+      print_stats (&ctx);
+    } else {
+      g_printerr ("ERROR: No frames measured with %u ROIs!\n", ctx.n_rois);
+      status = -1;
+    }
+
+    g_array_free (ctx.durations, TRUE);
+
+    if (status != 0)
+      break;
+  }
+
+  g_strfreev (counts);
+
+  g_free (format);
+  g_free (source);
+  g_free (sweep);
+
+  gst_deinit ();
+
+  return status;
+}
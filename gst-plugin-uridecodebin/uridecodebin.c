@@ -9,14 +9,22 @@
 
 #include "uridecodebin.h"
 
+#include <string.h>
+
+#include <gst/allocators/allocators.h>
+#include <gst/allocators/gstqtiallocator.h>
+
 #define GST_CAT_DEFAULT gst_uri_decodebin_debug
 GST_DEBUG_CATEGORY_STATIC (gst_uri_decodebin_debug);
 
 #define gst_uri_decodebin_parent_class parent_class
 G_DEFINE_TYPE (GstQtiURIDecodeBin, gst_uri_decodebin, GST_TYPE_BIN);
 
-#define DEFAULT_PROP_URI            NULL
-#define DEFAULT_PROP_ITERATIONS     G_MAXUINT
+#define DEFAULT_PROP_URI             NULL
+#define DEFAULT_PROP_ITERATIONS      G_MAXUINT
+#define DEFAULT_PROP_REPLAY          FALSE
+#define DEFAULT_PROP_REPLAY_MAX_SIZE 512
+#define DEFAULT_PROP_REPLAY_REALTIME FALSE
 
 #define DEFAULT_CUR_ITER            0
 #define DEFAULT_N_DECODERS          0
@@ -29,8 +37,456 @@ enum
   PROP_0,
   PROP_URI,
   PROP_ITERATIONS,
+  PROP_REPLAY,
+  PROP_REPLAY_MAX_SIZE,
+  PROP_REPLAY_REALTIME,
+};
+
+typedef struct _GstQtiReplayStream GstQtiReplayStream;
+
+struct _GstQtiReplayStream {
+  GstQtiURIDecodeBin *qtibin;
+
+  // Exposed (ghost) source pad of the stream.
+  GstPad             *pad;
+
+  // Deep copies of the buffers decoded during the first iteration.
+  GQueue             buffers;
+  // Whether the first iteration has been fully decoded into the cache.
+  gboolean           complete;
+  // Timestamp range covered by the cached buffers.
+  GstClockTime       start;
+  GstClockTime       end;
+
+  // Task replaying the cached buffers.
+  GstTask            *task;
+  GRecMutex          tasklock;
+  // Clock ID used for real time pacing.
+  GstClockID         clockid;
+  // Whether the task is being stopped.
+  gboolean           flushing;
+
+  // Replay iteration and position of the next buffer in the cache.
+  guint              iteration;
+  guint              index;
 };
 
+static gboolean gst_uri_decodebin_loop_eos (GstQtiURIDecodeBin * qtibin,
+    GstPad * pad);
+
+static GstQtiReplayStream *
+gst_uri_decodebin_replay_stream_new (GstQtiURIDecodeBin * qtibin, GstPad * pad)
+{
+  GstQtiReplayStream *stream = g_slice_new0 (GstQtiReplayStream);
+
+  stream->qtibin = qtibin;
+  stream->pad = pad;
+
+  g_queue_init (&stream->buffers);
+  stream->complete = FALSE;
+  stream->start = GST_CLOCK_TIME_NONE;
+  stream->end = GST_CLOCK_TIME_NONE;
+
+  stream->task = NULL;
+  g_rec_mutex_init (&stream->tasklock);
+  stream->clockid = NULL;
+  stream->flushing = FALSE;
+
+  stream->iteration = 0;
+  stream->index = 0;
+
+  return stream;
+}
+
+static void
+gst_uri_decodebin_replay_stream_stop (GstQtiReplayStream * stream)
+{
+  GstQtiURIDecodeBin *qtibin = stream->qtibin;
+
+  GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+
+  stream->flushing = TRUE;
+
+  if (stream->clockid != NULL)
+    gst_clock_id_unschedule (stream->clockid);
+
+  GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+
+  if (stream->task == NULL)
+    return;
+
+  gst_task_stop (stream->task);
+
+  // Make sure task is not running.
+  g_rec_mutex_lock (&stream->tasklock);
+  g_rec_mutex_unlock (&stream->tasklock);
+
+  if (!gst_task_join (stream->task))
+    GST_WARNING_OBJECT (stream->pad, "Failed to join replay task!");
+
+  gst_object_unref (stream->task);
+  stream->task = NULL;
+}
+
+// Must be called with the bin lock taken.
+static void
+gst_uri_decodebin_replay_stream_clear (GstQtiReplayStream * stream)
+{
+  GstBuffer *buffer = NULL;
+
+  while ((buffer = g_queue_pop_head (&stream->buffers)) != NULL) {
+    stream->qtibin->cache_size -= gst_buffer_get_size (buffer);
+    gst_buffer_unref (buffer);
+  }
+
+  stream->complete = FALSE;
+  stream->start = GST_CLOCK_TIME_NONE;
+  stream->end = GST_CLOCK_TIME_NONE;
+
+  stream->flushing = FALSE;
+  stream->iteration = 0;
+  stream->index = 0;
+}
+
+static void
+gst_uri_decodebin_replay_stream_free (GstQtiReplayStream * stream)
+{
+  gst_uri_decodebin_replay_stream_stop (stream);
+
+  GST_QTI_URI_DECODEBIN_LOCK (stream->qtibin);
+  gst_uri_decodebin_replay_stream_clear (stream);
+  GST_QTI_URI_DECODEBIN_UNLOCK (stream->qtibin);
+
+  g_rec_mutex_clear (&stream->tasklock);
+  g_slice_free (GstQtiReplayStream, stream);
+}
+
+static void
+gst_uri_decodebin_replay_wait (GstQtiReplayStream * stream, GstBuffer * buffer)
+{
+  GstElement *element = GST_ELEMENT_CAST (stream->qtibin);
+  GstClock *clock = NULL;
+  GstEvent *event = NULL;
+  const GstSegment *segment = NULL;
+  GstClockID clockid = NULL;
+  GstClockTime time = GST_CLOCK_TIME_NONE;
+
+  if (!GST_BUFFER_PTS_IS_VALID (buffer))
+    return;
+
+  if ((clock = gst_element_get_clock (element)) == NULL)
+    return;
+
+  event = gst_pad_get_sticky_event (stream->pad, GST_EVENT_SEGMENT, 0);
+
+  if (event != NULL) {
+    gst_event_parse_segment (event, &segment);
+    time = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+        GST_BUFFER_PTS (buffer));
+    gst_event_unref (event);
+  }
+
+  if (!GST_CLOCK_TIME_IS_VALID (time)) {
+    gst_object_unref (clock);
+    return;
+  }
+
+  time += gst_element_get_base_time (element);
+
+  GST_QTI_URI_DECODEBIN_LOCK (stream->qtibin);
+
+  if (!stream->flushing)
+    clockid = stream->clockid = gst_clock_new_single_shot_id (clock, time);
+
+  GST_QTI_URI_DECODEBIN_UNLOCK (stream->qtibin);
+
+  if (clockid != NULL)
+    gst_clock_id_wait (clockid, NULL);
+
+  GST_QTI_URI_DECODEBIN_LOCK (stream->qtibin);
+  stream->clockid = NULL;
+  GST_QTI_URI_DECODEBIN_UNLOCK (stream->qtibin);
+
+  if (clockid != NULL)
+    gst_clock_id_unref (clockid);
+
+  gst_object_unref (clock);
+}
+
+static void
+gst_uri_decodebin_replay_task (gpointer userdata)
+{
+  GstQtiReplayStream *stream = (GstQtiReplayStream *) userdata;
+  GstQtiURIDecodeBin *qtibin = stream->qtibin;
+  GstBuffer *buffer = NULL;
+  GstClockTime offset = 0, duration = 0;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gboolean eos = FALSE;
+
+  GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+
+  // Start next iteration once all cached buffers have been replayed.
+  if (stream->index >= g_queue_get_length (&stream->buffers)) {
+    stream->iteration++;
+    stream->index = 0;
+
+    GST_INFO_OBJECT (stream->pad, "Replay iteration %u completed",
+        stream->iteration);
+  }
+
+  eos = !qtibin->loop || (stream->iteration >= qtibin->iterations) ||
+      g_queue_is_empty (&stream->buffers);
+
+  if (!eos) {
+    // Prefer the stream duration used by the seek based looping.
+    duration = (qtibin->duration > 0) ? (GstClockTime) qtibin->duration :
+        (GstClockTime) GST_CLOCK_DIFF (stream->start, stream->end);
+    offset = stream->iteration * duration;
+
+    // Timestamps are changed on a shallow copy, memory is shared.
+    buffer = gst_buffer_copy (
+        g_queue_peek_nth (&stream->buffers, stream->index));
+    stream->index++;
+
+    if (stream->iteration > qtibin->cur_iter)
+      qtibin->cur_iter = stream->iteration;
+  }
+
+  GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+
+  if (eos) {
+    GST_INFO_OBJECT (stream->pad, "Replay finished, pushing EOS");
+
+    gst_pad_push_event (stream->pad, gst_event_new_eos ());
+    gst_task_pause (stream->task);
+    return;
+  }
+
+  if (GST_BUFFER_PTS_IS_VALID (buffer))
+    GST_BUFFER_PTS (buffer) += offset;
+
+  if (GST_BUFFER_DTS_IS_VALID (buffer))
+    GST_BUFFER_DTS (buffer) += offset;
+
+  if (qtibin->replay_realtime)
+    gst_uri_decodebin_replay_wait (stream, buffer);
+
+  GST_TRACE_OBJECT (stream->pad, "Replaying %" GST_PTR_FORMAT, buffer);
+
+  ret = gst_pad_push (stream->pad, buffer);
+
+  if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED)
+    return;
+
+  GST_INFO_OBJECT (stream->pad, "Pausing replay task, reason: %s",
+      gst_flow_get_name (ret));
+
+  if (ret == GST_FLOW_NOT_NEGOTIATED || ret < GST_FLOW_EOS) {
+    GST_ELEMENT_FLOW_ERROR (qtibin, ret);
+    gst_pad_push_event (stream->pad, gst_event_new_eos ());
+  }
+
+  gst_task_pause (stream->task);
+}
+
+// Must be called with the bin lock taken.
+static void
+gst_uri_decodebin_replay_start (GstQtiURIDecodeBin * qtibin)
+{
+  GList *list = NULL;
+
+  GST_INFO_OBJECT (qtibin, "Decoded %u streams into %" G_GSIZE_FORMAT " bytes "
+      "of cache, starting replay", qtibin->n_cached, qtibin->cache_size);
+
+  for (list = qtibin->streams; list != NULL; list = g_list_next (list)) {
+    GstQtiReplayStream *stream = list->data;
+
+    // The first iteration was played while decoding.
+    stream->iteration = 1;
+    stream->index = 0;
+
+    if (stream->task == NULL) {
+      stream->task = gst_task_new (gst_uri_decodebin_replay_task, stream, NULL);
+      gst_task_set_lock (stream->task, &stream->tasklock);
+    }
+
+    if (!gst_task_start (stream->task))
+      GST_ERROR_OBJECT (stream->pad, "Failed to start replay task!");
+  }
+}
+
+// Decoder pool buffers must be returned, copy them into memory of the same
+// kind. Downstream negotiated memory:GBM or DMA caps and imports the FDs.
+static GstBuffer *
+gst_uri_decodebin_replay_copy (GstQtiURIDecodeBin * qtibin, GstBuffer * buffer)
+{
+  GstBuffer *copy = NULL;
+  GstMemory *memory = NULL;
+  GstMapInfo inmap, outmap;
+
+  if ((gst_buffer_n_memory (buffer) == 0) ||
+      !gst_is_fd_memory (gst_buffer_peek_memory (buffer, 0)))
+    return gst_buffer_copy_deep (buffer);
+
+  if (qtibin->allocator == NULL) {
+    GST_WARNING_OBJECT (qtibin, "No DMA allocator for FD backed buffers!");
+    return NULL;
+  }
+
+  memory = gst_allocator_alloc (qtibin->allocator,
+      gst_buffer_get_size (buffer), NULL);
+
+  if (memory == NULL) {
+    GST_WARNING_OBJECT (qtibin, "Failed to allocate DMA memory!");
+    return NULL;
+  }
+
+  if (!gst_buffer_map (buffer, &inmap, GST_MAP_READ)) {
+    GST_WARNING_OBJECT (qtibin, "Failed to map %" GST_PTR_FORMAT, buffer);
+    gst_memory_unref (memory);
+    return NULL;
+  }
+
+  if (!gst_memory_map (memory, &outmap, GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (qtibin, "Failed to map DMA memory!");
+    gst_buffer_unmap (buffer, &inmap);
+    gst_memory_unref (memory);
+    return NULL;
+  }
+
+  memcpy (outmap.data, inmap.data, inmap.size);
+
+  gst_memory_unmap (memory, &outmap);
+  gst_buffer_unmap (buffer, &inmap);
+
+  // Plane offsets in the video meta are relative to the whole buffer and
+  // remain valid for the single contiguous memory block.
+  copy = gst_buffer_new ();
+  gst_buffer_append_memory (copy, memory);
+  gst_buffer_copy_into (copy, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+
+  return copy;
+}
+
+// Must be called with the bin lock taken.
+static void
+gst_uri_decodebin_replay_overflow (GstQtiURIDecodeBin * qtibin)
+{
+  GList *list = NULL;
+
+  GST_WARNING_OBJECT (qtibin, "Decoded frames exceed the replay cache size of "
+      "%u MiB, falling back to seek based looping", qtibin->replay_max_size);
+
+  qtibin->overflow = TRUE;
+  qtibin->n_cached = 0;
+
+  for (list = qtibin->streams; list != NULL; list = g_list_next (list))
+    gst_uri_decodebin_replay_stream_clear (list->data);
+}
+
+static GstPadProbeReturn
+gst_uri_decodebin_cache_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstQtiReplayStream *stream = (GstQtiReplayStream *) user_data;
+  GstQtiURIDecodeBin *qtibin = stream->qtibin;
+  GstPadProbeReturn ret = GST_PAD_PROBE_OK;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    GstClockTime end = GST_CLOCK_TIME_NONE;
+    gsize maxsize = (gsize) qtibin->replay_max_size * 1024 * 1024;
+
+    GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+
+    if (qtibin->overflow || stream->complete || qtibin->cur_iter != 0) {
+      GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+      return GST_PAD_PROBE_OK;
+    }
+
+    if ((qtibin->cache_size + gst_buffer_get_size (buffer)) > maxsize) {
+      gst_uri_decodebin_replay_overflow (qtibin);
+      GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+      return GST_PAD_PROBE_OK;
+    }
+
+    GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+
+    buffer = gst_uri_decodebin_replay_copy (qtibin, buffer);
+
+    if (GST_BUFFER_PTS_IS_VALID (buffer)) {
+      end = GST_BUFFER_PTS (buffer);
+
+      if (GST_BUFFER_DURATION_IS_VALID (buffer))
+        end += GST_BUFFER_DURATION (buffer);
+    }
+
+    GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+
+    // Without a copy the stream cannot be replayed, loop by seeking instead.
+    if ((buffer == NULL) && !qtibin->overflow)
+      gst_uri_decodebin_replay_overflow (qtibin);
+
+    // Cache may have been dropped in the meantime by another stream.
+    if (buffer == NULL) {
+      GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+      return GST_PAD_PROBE_OK;
+    } else if (qtibin->overflow) {
+      GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+      gst_buffer_unref (buffer);
+      return GST_PAD_PROBE_OK;
+    }
+
+    qtibin->cache_size += gst_buffer_get_size (buffer);
+
+    if (!GST_CLOCK_TIME_IS_VALID (stream->start) &&
+        GST_BUFFER_PTS_IS_VALID (buffer))
+      stream->start = GST_BUFFER_PTS (buffer);
+
+    if (GST_CLOCK_TIME_IS_VALID (end) &&
+        (!GST_CLOCK_TIME_IS_VALID (stream->end) || (end > stream->end)))
+      stream->end = end;
+
+    g_queue_push_tail (&stream->buffers, buffer);
+
+    GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+    gboolean draining = FALSE;
+
+    if (GST_EVENT_TYPE (event) != GST_EVENT_EOS)
+      return GST_PAD_PROBE_OK;
+
+    GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+
+    if ((draining = (qtibin->n_draining > 0)))
+      qtibin->n_draining--;
+
+    // Keep the EOS while the cached buffers are going to be replayed.
+    if (!qtibin->overflow && qtibin->loop && (qtibin->iterations > 1) &&
+        !g_queue_is_empty (&stream->buffers)) {
+      stream->complete = TRUE;
+      qtibin->n_cached++;
+
+      if (qtibin->n_cached == g_list_length (qtibin->streams))
+        gst_uri_decodebin_replay_start (qtibin);
+
+      ret = GST_PAD_PROBE_DROP;
+    } else if (draining && qtibin->overflow) {
+      // Cache overflowed while the decoder was draining, loop by seeking.
+      if (gst_uri_decodebin_loop_eos (qtibin, pad))
+        ret = GST_PAD_PROBE_DROP;
+    }
+
+    GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+
+    GST_LOG_OBJECT (pad, "%s %" GST_PTR_FORMAT,
+        (ret == GST_PAD_PROBE_DROP) ? "Drop" : "Forward", event);
+  }
+
+  return ret;
+}
+
 static GstPadProbeReturn
 gst_uri_decodebin_buffer_probe_cb (GstPad * pad, GstPadProbeInfo * info,
     gpointer user_data)
@@ -61,10 +517,18 @@ static gboolean
 gst_element_send_seek (gpointer user_data)
 {
   GstElement *element = GST_ELEMENT_CAST (user_data);
+  GstEvent *event = NULL;
   gboolean success = FALSE;
 
-  success = gst_element_seek_simple (element, GST_FORMAT_TIME,
-      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, 0);
+  event = gst_event_new_seek (1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, GST_SEEK_TYPE_SET, 0,
+      GST_SEEK_TYPE_NONE, 0);
+
+  // Bypass the bin send_event() as this seek continues the current replay
+  // while flushing seeks from the application start over.
+  GST_STATE_LOCK (element);
+  success = GST_ELEMENT_CLASS (parent_class)->send_event (element, event);
+  GST_STATE_UNLOCK (element);
 
   if (success)
     GST_DEBUG_OBJECT (element, "Seeking back to start of file");
@@ -74,6 +538,33 @@ gst_element_send_seek (gpointer user_data)
   return G_SOURCE_REMOVE;
 }
 
+// Account the EOS of one stream for the seek based looping, returns whether
+// the EOS has to be dropped. Must be called with the bin lock taken.
+static gboolean
+gst_uri_decodebin_loop_eos (GstQtiURIDecodeBin * qtibin, GstPad * pad)
+{
+  gboolean drop = FALSE;
+
+  // Determine whether to drop the current EOS event.
+  drop = qtibin->loop && (qtibin->cur_iter + 1 < qtibin->iterations);
+
+  qtibin->n_eos++;
+
+  // Increase the iteration counter if one iteration has finished for all pads.
+  if (qtibin->n_eos == qtibin->n_decoders) {
+    GST_INFO_OBJECT (pad, "Iteration %d completed", qtibin->cur_iter + 1);
+
+    qtibin->n_eos = DEFAULT_N_EOS;
+
+    if (drop)
+      g_idle_add (gst_element_send_seek, qtibin);
+
+    qtibin->cur_iter += 1;
+  }
+
+  return drop;
+}
+
 static GstPadProbeReturn
 gst_uri_decodebin_query_probe_cb (GstPad * pad, GstPadProbeInfo * info,
     gpointer user_data)
@@ -173,23 +664,16 @@ gst_uri_decodebin_event_probe_cb (GstPad * pad, GstPadProbeInfo * info,
 
       GST_QTI_URI_DECODEBIN_LOCK (qtibin);
 
-      // Determine whether to drop the current EOS event.
-      drop = qtibin->loop && (qtibin->cur_iter + 1 < qtibin->iterations);
-
-      qtibin->n_eos++;
-
-      // Increase the iteration counter if one iteration has finished for all pads.
-      if (qtibin->n_eos == qtibin->n_decoders) {
-        GST_INFO_OBJECT (pad, "Iteration %d completed", qtibin->cur_iter + 1);
-
-        qtibin->n_eos = DEFAULT_N_EOS;
-
-        if (drop)
-          g_idle_add (gst_element_send_seek, qtibin);
-
-        qtibin->cur_iter += 1;
+      // Let the decoder drain, further iterations are replayed from the cache.
+      // Should the cache overflow meanwhile, looping resumes at the output.
+      if (qtibin->replay && !qtibin->overflow) {
+        qtibin->n_draining++;
+        GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+        return GST_PAD_PROBE_OK;
       }
 
+      drop = gst_uri_decodebin_loop_eos (qtibin, pad);
+
       GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
 
       GST_LOG_OBJECT (pad, "%s %" GST_PTR_FORMAT, drop ? "Drop" : "Forward",
@@ -203,7 +687,9 @@ gst_uri_decodebin_event_probe_cb (GstPad * pad, GstPadProbeInfo * info,
 
       GST_QTI_URI_DECODEBIN_LOCK (qtibin);
 
-      drop = qtibin->loop && (qtibin->cur_iter < qtibin->iterations);
+      // Only the flushes of the seeks between iterations are hidden.
+      drop = qtibin->loop && (qtibin->cur_iter < qtibin->iterations) &&
+          !qtibin->restarting;
 
       GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
 
@@ -218,23 +704,77 @@ gst_uri_decodebin_event_probe_cb (GstPad * pad, GstPadProbeInfo * info,
   return GST_PAD_PROBE_OK;
 }
 
+static void
+gst_uri_decodebin_replay_reset (GstQtiURIDecodeBin * qtibin)
+{
+  GList *list = NULL;
+
+  for (list = qtibin->streams; list != NULL; list = g_list_next (list))
+    gst_uri_decodebin_replay_stream_stop (list->data);
+
+  GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+
+  for (list = qtibin->streams; list != NULL; list = g_list_next (list))
+    gst_uri_decodebin_replay_stream_clear (list->data);
+
+  qtibin->n_cached = 0;
+  qtibin->n_draining = 0;
+  qtibin->overflow = FALSE;
+
+  GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+}
+
 static gboolean
 gst_uri_decodebin_send_event (GstElement * element, GstEvent * event)
 {
   GstQtiURIDecodeBin *qtibin = GST_QTI_URI_DECODEBIN (element);
+  gboolean restart = FALSE, success = FALSE;
+
+  // The flushes of a seek are generated inside the bin and never reach here.
+  if (GST_EVENT_TYPE(event) == GST_EVENT_SEEK) {
+    GstSeekFlags flags = GST_SEEK_FLAG_NONE;
+
+    gst_event_parse_seek (event, NULL, NULL, &flags, NULL, NULL, NULL, NULL);
+    restart = (flags & GST_SEEK_FLAG_FLUSH) ? TRUE : FALSE;
+  } else if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_START) {
+    restart = TRUE;
+  }
 
   GST_QTI_URI_DECODEBIN_LOCK (qtibin);
 
-  if (GST_EVENT_TYPE(event) == GST_EVENT_EOS)
+  if (GST_EVENT_TYPE(event) == GST_EVENT_EOS) {
     qtibin->loop = FALSE;
-  else if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_START)
+  } else if (restart) {
     qtibin->cur_iter = DEFAULT_CUR_ITER;
-  else if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP)
+    qtibin->n_eos = DEFAULT_N_EOS;
+  }
+
+  // A flushing seek carries no FLUSH_STOP, resume looping right away.
+  if ((GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP) ||
+      (restart && (GST_EVENT_TYPE(event) == GST_EVENT_SEEK)))
     qtibin->loop = TRUE;
 
   GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
 
-  return GST_ELEMENT_CLASS (parent_class)->send_event (element, event);
+  // Flushing seek restarts decoding, the cache is filled again.
+  if (restart)
+    gst_uri_decodebin_replay_reset (qtibin);
+
+  if (!restart || (GST_EVENT_TYPE(event) != GST_EVENT_SEEK))
+    return GST_ELEMENT_CLASS (parent_class)->send_event (element, event);
+
+  // Let the flushes of the seek, sent while it is handled, reach downstream.
+  GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+  qtibin->restarting = TRUE;
+  GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+
+  success = GST_ELEMENT_CLASS (parent_class)->send_event (element, event);
+
+  GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+  qtibin->restarting = FALSE;
+  GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+
+  return success;
 }
 
 static void
@@ -282,6 +822,7 @@ gst_uri_decodebin_pad_added_cb (GstElement * element, GstPad * pad,
 {
   GstPad *newpad = NULL;
   GstPadTemplate *pad_tmpl = NULL;
+  GstQtiReplayStream *stream = NULL;
   gchar *padname = NULL;
 
   GST_DEBUG_OBJECT (element, "pad: %s", GST_PAD_NAME (pad));
@@ -300,6 +841,22 @@ gst_uri_decodebin_pad_added_cb (GstElement * element, GstPad * pad,
   gst_element_add_pad (GST_ELEMENT_CAST (qtibin), newpad);
 
   g_object_set_data (G_OBJECT (pad), "qtibin.ghostpad", newpad);
+
+  if (!qtibin->replay || !gst_uri_has_protocol (qtibin->uri, "file"))
+    return;
+
+  stream = gst_uri_decodebin_replay_stream_new (qtibin, newpad);
+
+  GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+  qtibin->streams = g_list_append (qtibin->streams, stream);
+  GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+
+  g_object_set_data (G_OBJECT (pad), "qtibin.stream", stream);
+
+  // Cache the decoded buffers of the first iteration.
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, gst_uri_decodebin_cache_probe_cb,
+      stream, NULL);
 }
 
 static void
@@ -307,9 +864,20 @@ gst_uri_decodebin_pad_removed_cb (GstElement * element, GstPad * pad,
     GstQtiURIDecodeBin * qtibin)
 {
   GstPad *ghost = NULL;
+  GstQtiReplayStream *stream = NULL;
 
   GST_DEBUG_OBJECT (element, "Pad %s:%s", GST_DEBUG_PAD_NAME (pad));
   ghost = g_object_get_data (G_OBJECT (pad), "qtibin.ghostpad");
+  stream = g_object_get_data (G_OBJECT (pad), "qtibin.stream");
+
+  if (stream != NULL) {
+    GST_QTI_URI_DECODEBIN_LOCK (qtibin);
+    qtibin->streams = g_list_remove (qtibin->streams, stream);
+    GST_QTI_URI_DECODEBIN_UNLOCK (qtibin);
+
+    g_object_set_data (G_OBJECT (pad), "qtibin.stream", NULL);
+    gst_uri_decodebin_replay_stream_free (stream);
+  }
 
   if (ghost == NULL) {
     GST_WARNING_OBJECT (element, "no ghost pad found");
@@ -339,6 +907,15 @@ gst_uri_decodebin_set_property (GObject * object, guint prop_id,
     case PROP_ITERATIONS:
       qtibin->iterations = g_value_get_uint (value);
       break;
+    case PROP_REPLAY:
+      qtibin->replay = g_value_get_boolean (value);
+      break;
+    case PROP_REPLAY_MAX_SIZE:
+      qtibin->replay_max_size = g_value_get_uint (value);
+      break;
+    case PROP_REPLAY_REALTIME:
+      qtibin->replay_realtime = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -358,6 +935,15 @@ gst_uri_decodebin_get_property (GObject * object, guint prop_id,
     case PROP_ITERATIONS:
       g_value_set_uint (value, qtibin->iterations);
       break;
+    case PROP_REPLAY:
+      g_value_set_boolean (value, qtibin->replay);
+      break;
+    case PROP_REPLAY_MAX_SIZE:
+      g_value_set_uint (value, qtibin->replay_max_size);
+      break;
+    case PROP_REPLAY_REALTIME:
+      g_value_set_boolean (value, qtibin->replay_realtime);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -371,6 +957,12 @@ gst_uri_decodebin_change_state (GstElement * element, GstStateChange transition)
   GstStateChangeReturn ret = GST_STATE_CHANGE_FAILURE;
 
   switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      // Replay cache memory for decoders with DMA output.
+      if (qtibin->replay && (qtibin->allocator == NULL))
+        qtibin->allocator =
+            gst_qti_allocator_new (GST_FD_MEMORY_FLAG_KEEP_MAPPED);
+      break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
     {
       gint64 duration = 0;
@@ -394,6 +986,9 @@ gst_uri_decodebin_change_state (GstElement * element, GstStateChange transition)
       break;
   }
 
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    gst_uri_decodebin_replay_reset (qtibin);
+
   ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
 
   switch (transition) {
@@ -418,8 +1013,15 @@ gst_uri_decodebin_finalize (GObject * obj)
 {
   GstQtiURIDecodeBin *qtibin = GST_QTI_URI_DECODEBIN (obj);
 
+  g_list_free_full (qtibin->streams,
+      (GDestroyNotify) gst_uri_decodebin_replay_stream_free);
+  qtibin->streams = NULL;
+
   g_free (qtibin->uri);
 
+  if (qtibin->allocator != NULL)
+    gst_object_unref (qtibin->allocator);
+
   g_mutex_clear (&qtibin->lock);
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -447,6 +1049,25 @@ gst_uri_decodebin_class_init (GstQtiURIDecodeBinClass * klass)
           "This property is only used for file sources.", 1, G_MAXUINT,
           DEFAULT_PROP_ITERATIONS, G_PARAM_CONSTRUCT | G_PARAM_READWRITE |
           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject, PROP_REPLAY,
+      g_param_spec_boolean ("replay", "Replay",
+          "Decode the file stream only once into a memory cache and replay "
+          "the decoded frames for the remaining iterations instead of seeking "
+          "back and decoding again.", DEFAULT_PROP_REPLAY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_REPLAY_MAX_SIZE,
+      g_param_spec_uint ("replay-max-size", "Replay max size",
+          "Maximum size in MiB of the replay cache, if the decoded frames do "
+          "not fit the stream is looped by seeking.", 1, G_MAXUINT,
+          DEFAULT_PROP_REPLAY_MAX_SIZE, G_PARAM_READWRITE |
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_REPLAY_REALTIME,
+      g_param_spec_boolean ("replay-realtime", "Replay realtime",
+          "Pace the replayed frames against the pipeline clock instead of "
+          "pushing them as fast as downstream accepts.",
+          DEFAULT_PROP_REPLAY_REALTIME, G_PARAM_READWRITE |
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY));
 
   gst_element_class_add_static_pad_template (element, &srctemplate);
 
@@ -460,14 +1081,25 @@ gst_uri_decodebin_init (GstQtiURIDecodeBin * qtibin)
 {
   qtibin->uri = DEFAULT_PROP_URI;
   qtibin->iterations = DEFAULT_PROP_ITERATIONS;
+  qtibin->replay = DEFAULT_PROP_REPLAY;
+  qtibin->replay_max_size = DEFAULT_PROP_REPLAY_MAX_SIZE;
+  qtibin->replay_realtime = DEFAULT_PROP_REPLAY_REALTIME;
+
+  qtibin->streams = NULL;
+  qtibin->n_cached = 0;
+  qtibin->cache_size = 0;
+  qtibin->overflow = FALSE;
+  qtibin->allocator = NULL;
 
   qtibin->cur_iter = DEFAULT_CUR_ITER;
   qtibin->n_decoders = DEFAULT_N_DECODERS;
   qtibin->n_eos = DEFAULT_N_EOS;
+  qtibin->n_draining = 0;
 
   qtibin->duration = DEFAULT_DURATION;
 
   qtibin->loop = DEFAULT_LOOP;
+  qtibin->restarting = FALSE;
 
   qtibin->uridecodebin = gst_element_factory_make ("uridecodebin3", NULL);
   gst_bin_add (GST_BIN_CAST (qtibin), qtibin->uridecodebin);
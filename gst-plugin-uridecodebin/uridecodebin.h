@@ -46,16 +46,34 @@ struct _GstQtiURIDecodeBin
   guint         cur_iter;
   guint         n_decoders;
   guint         n_eos;
+  /// EOS events let through the decoders to drain them into the replay cache.
+  guint         n_draining;
 
   /// Timestamps Implementation
   gint64        duration;
 
   /// States of the Element.
   gboolean      loop;
+  /// Whether a flushing seek from the application is being forwarded.
+  gboolean      restarting;
+
+  /// Replay cache, list of GstQtiReplayStream for each source pad.
+  GList         *streams;
+  /// Number of streams which have been decoded completely into the cache.
+  guint         n_cached;
+  /// Total size in bytes of the cached decoded buffers.
+  gsize         cache_size;
+  /// Whether the cache exceeded its maximum size and replay was abandoned.
+  gboolean      overflow;
+  /// DMA allocator for caching buffers of decoders with FD backed output.
+  GstAllocator  *allocator;
 
   /// Properties.
   gchar         *uri;
   guint         iterations;
+  gboolean      replay;
+  guint         replay_max_size;
+  gboolean      replay_realtime;
 };
 
 struct _GstQtiURIDecodeBinClass
@@ -38,6 +38,8 @@
 
 #include "videocomposer.h"
 
+#include <string.h>
+
 #include <gst/allocators/gstqtiallocator.h>
 #include <gst/video/video-utils.h>
 #include <gst/utils/common-utils.h>
@@ -67,6 +69,7 @@ G_DEFINE_TYPE_WITH_CODE (GstVideoComposer, gst_video_composer,
 
 #define DEFAULT_PROP_ENGINE_BACKEND (gst_video_converter_default_backend())
 #define DEFAULT_PROP_BACKGROUND     0xFF808080
+#define DEFAULT_PROP_INCREMENTAL    FALSE
 
 #define GST_VCOMPOSER_MAX_QUEUE_LEN 16
 
@@ -84,8 +87,12 @@ enum
   PROP_0,
   PROP_ENGINE_BACKEND,
   PROP_BACKGROUND,
+  PROP_INCREMENTAL,
 };
 
+// Serial number of the output frame whose composition a buffer contains.
+static G_DEFINE_QUARK (VideoComposerSerialQuark, gst_video_composer_serial);
+
 static GstCaps *
 gst_video_composer_sink_caps (void)
 {
@@ -274,6 +281,257 @@ gst_video_composer_index_compare (const GstVideoComposerSinkPad * pad,
   return pad->index - (*index);
 }
 
+static inline gboolean
+gst_video_composer_rectangles_intersect (const GstVideoRectangle * l_rect,
+    const GstVideoRectangle * r_rect)
+{
+  return (l_rect->x < (r_rect->x + r_rect->w)) &&
+      (r_rect->x < (l_rect->x + l_rect->w)) &&
+      (l_rect->y < (r_rect->y + r_rect->h)) &&
+      (r_rect->y < (l_rect->y + l_rect->h));
+}
+
+static gboolean
+gst_video_composer_blits_equal (const GstVideoBlit * l_blit,
+    const GstVideoBlit * r_blit)
+{
+  if ((l_blit->mask != r_blit->mask) || (l_blit->alpha != r_blit->alpha))
+    return FALSE;
+
+  if ((l_blit->mask & GST_VCE_MASK_SOURCE) && memcmp (&(l_blit->source),
+          &(r_blit->source), sizeof (GstVideoQuadrilateral)) != 0)
+    return FALSE;
+
+  if ((l_blit->mask & GST_VCE_MASK_DESTINATION) && memcmp (
+          &(l_blit->destination), &(r_blit->destination),
+          sizeof (GstVideoRectangle)) != 0)
+    return FALSE;
+
+  if ((l_blit->mask & GST_VCE_MASK_ROTATION) &&
+      (l_blit->rotate != r_blit->rotate))
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gst_video_composer_blit_rectangle (const GstVideoBlit * vblit,
+    const GstVideoInfo * info, GstVideoRectangle * rect)
+{
+  gint width = GST_VIDEO_INFO_WIDTH (info);
+  gint height = GST_VIDEO_INFO_HEIGHT (info);
+  gint x = 0, y = 0, w = width, h = height;
+
+  if (vblit->mask & GST_VCE_MASK_DESTINATION) {
+    x = vblit->destination.x;
+    y = vblit->destination.y;
+    w = vblit->destination.w;
+    h = vblit->destination.h;
+  }
+
+  // Clip the region to the dimensions of the output frame.
+  rect->x = CLAMP (x, 0, width);
+  rect->y = CLAMP (y, 0, height);
+  rect->w = CLAMP (x + w, 0, width) - rect->x;
+  rect->h = CLAMP (y + h, 0, height) - rect->y;
+}
+
+static void
+gst_video_composer_track_sinkpad (GstVideoComposerSinkPad * sinkpad,
+    const GstVideoBlit * vblit, const GstVideoInfo * info, guint position,
+    GArray * damage)
+{
+  GstVideoRectangle rect = { 0, };
+  gboolean changed = FALSE;
+
+  // Sink pad no longer contributes, the region it covered is exposed.
+  if (vblit == NULL) {
+    if (sinkpad->lastvisible)
+      g_array_append_val (damage, sinkpad->lastrect);
+
+    sinkpad->lastbuffer = NULL;
+    sinkpad->lastvisible = FALSE;
+    return;
+  }
+
+  gst_video_composer_blit_rectangle (vblit, info, &rect);
+
+  // Buffers are recycled by upstream pools, compare timestamps as well.
+  changed = !sinkpad->lastvisible || (sinkpad->lastbuffer != vblit->buffer) ||
+      (sinkpad->lastpts != GST_BUFFER_PTS (vblit->buffer)) ||
+      (sinkpad->lastposition != position) ||
+      !gst_video_composer_blits_equal (&(sinkpad->lastblit), vblit);
+
+  if (changed && sinkpad->lastvisible)
+    g_array_append_val (damage, sinkpad->lastrect);
+
+  if (changed)
+    g_array_append_val (damage, rect);
+
+  sinkpad->lastbuffer = vblit->buffer;
+  sinkpad->lastpts = GST_BUFFER_PTS (vblit->buffer);
+  sinkpad->lastblit = *vblit;
+  sinkpad->lastrect = rect;
+  sinkpad->lastposition = position;
+  sinkpad->lastvisible = TRUE;
+}
+
+static gboolean
+gst_video_composer_rectangle_covered (GstVideoComposer * vcomposer,
+    const GstVideoRectangle * rect, const GstVideoComposition * composition)
+{
+  GArray *pieces = vcomposer->pieces;
+  GstVideoRectangle cover = { 0, }, piece = { 0, }, part = { 0, };
+  gint top = 0, bottom = 0;
+  guint idx = 0, num = 0;
+
+  g_array_set_size (pieces, 0);
+  g_array_append_vals (pieces, rect, 1);
+
+  for (idx = 0; (idx < composition->n_blits) && (pieces->len > 0); idx++) {
+    const GstVideoBlit *vblit = &(composition->blits[idx]);
+
+    // Only opaque blits replace the content underneath them.
+    if ((vblit->alpha != G_MAXUINT8) || GST_VIDEO_INFO_HAS_ALPHA (vblit->info))
+      continue;
+
+    gst_video_composer_blit_rectangle (vblit, composition->info, &cover);
+
+    // Replace the pieces overlapped by this blit with their uncovered parts.
+    for (num = pieces->len; num > 0; num--) {
+      piece = g_array_index (pieces, GstVideoRectangle, num - 1);
+
+      if (!gst_video_composer_rectangles_intersect (&piece, &cover))
+        continue;
+
+      g_array_remove_index_fast (pieces, num - 1);
+
+      top = MAX (piece.y, cover.y);
+      bottom = MIN (piece.y + piece.h, cover.y + cover.h);
+
+      if (piece.y < top) {
+        part.x = piece.x; part.y = piece.y;
+        part.w = piece.w; part.h = top - piece.y;
+        g_array_append_val (pieces, part);
+      }
+
+      if (bottom < (piece.y + piece.h)) {
+        part.x = piece.x; part.y = bottom;
+        part.w = piece.w; part.h = piece.y + piece.h - bottom;
+        g_array_append_val (pieces, part);
+      }
+
+      if (piece.x < cover.x) {
+        part.x = piece.x; part.y = top;
+        part.w = cover.x - piece.x; part.h = bottom - top;
+        g_array_append_val (pieces, part);
+      }
+
+      if ((cover.x + cover.w) < (piece.x + piece.w)) {
+        part.x = cover.x + cover.w; part.y = top;
+        part.w = piece.x + piece.w - part.x; part.h = bottom - top;
+        g_array_append_val (pieces, part);
+      }
+    }
+  }
+
+  return (pieces->len == 0) ? TRUE : FALSE;
+}
+
+static gboolean
+gst_video_composer_damaged_composition (GstVideoComposer * vcomposer,
+    GstBuffer * outbuffer, const GstVideoComposition * composition,
+    GstVideoComposition * dirty)
+{
+  GArray *damage = vcomposer->damage, *rects = NULL;
+  GstVideoRectangle rect = { 0, };
+  gboolean *marked = NULL, extended = TRUE;
+  guint serial = 0, idx = 0, num = 0, n_dirty = 0;
+
+  serial = GPOINTER_TO_UINT (gst_mini_object_get_qdata (
+      GST_MINI_OBJECT (outbuffer), gst_video_composer_serial_quark ()));
+
+  // The downstream pool handed a buffer with unknown or too old content.
+  if ((serial < vcomposer->baseline) ||
+      ((vcomposer->serial - serial) > GST_VIDEO_COMPOSER_MAX_BUFFER_AGE)) {
+    GST_LOG_OBJECT (vcomposer, "Buffer %p content is unknown, serial %u "
+        "current %u", outbuffer, serial, vcomposer->serial);
+    return FALSE;
+  }
+
+  // Accumulate the damage since the buffer was composed for the last time.
+  g_array_set_size (damage, 0);
+
+  for (num = serial + 1; num <= vcomposer->serial; num++) {
+    rects = vcomposer->damages[num % GST_VIDEO_COMPOSER_MAX_BUFFER_AGE];
+    g_array_append_vals (damage, rects->data, rects->len);
+  }
+
+  *dirty = *composition;
+
+  dirty->blits = vcomposer->dirtyblits;
+  dirty->n_blits = 0;
+  dirty->bgfill = FALSE;
+
+  // Buffer already contains the composition for the current output frame.
+  if (damage->len == 0)
+    return TRUE;
+
+  marked = g_newa (gboolean, composition->n_blits);
+  memset (marked, 0, composition->n_blits * sizeof (gboolean));
+
+  // Blits are redrawn in their entirety, extend the damage with the regions
+  // of all blits which overlap it until no more blits are affected.
+  while (extended) {
+    extended = FALSE;
+
+    for (idx = 0; idx < composition->n_blits; idx++) {
+      if (marked[idx])
+        continue;
+
+      gst_video_composer_blit_rectangle (&(composition->blits[idx]),
+          composition->info, &rect);
+
+      for (num = 0; num < damage->len; num++) {
+        if (!gst_video_composer_rectangles_intersect (&rect,
+                &g_array_index (damage, GstVideoRectangle, num)))
+          continue;
+
+        g_array_append_val (damage, rect);
+
+        marked[idx] = extended = TRUE;
+        n_dirty++;
+        break;
+      }
+    }
+  }
+
+  if (n_dirty == composition->n_blits) {
+    GST_LOG_OBJECT (vcomposer, "All blits are damaged");
+    return FALSE;
+  }
+
+  // The engines can fill the background only on the whole frame, any
+  // damaged region without opaque content requires full composition.
+  for (num = 0; num < damage->len; num++) {
+    rect = g_array_index (damage, GstVideoRectangle, num);
+
+    if (!gst_video_composer_rectangle_covered (vcomposer, &rect, composition)) {
+      GST_LOG_OBJECT (vcomposer, "Background exposed in region [%d %d %d %d]",
+          rect.x, rect.y, rect.w, rect.h);
+      return FALSE;
+    }
+  }
+
+  // Keep the Z axis order of the damaged blits.
+  for (idx = 0; idx < composition->n_blits; idx++) {
+    if (marked[idx])
+      dirty->blits[dirty->n_blits++] = composition->blits[idx];
+  }
+
+  return TRUE;
+}
+
 static GstBufferPool *
 gst_video_composer_create_pool (GstVideoComposer * vcomposer, GstCaps * caps,
     GstVideoAlignment * align, GstAllocationParams * params)
@@ -491,6 +749,10 @@ gst_video_composer_decide_allocation (GstAggregator * aggregator,
   if (vcomposer->outpool != NULL)
     gst_buffer_pool_set_active (vcomposer->outpool, FALSE);
 
+  GST_VIDEO_COMPOSER_LOCK (vcomposer);
+  vcomposer->invalidate = TRUE;
+  GST_VIDEO_COMPOSER_UNLOCK (vcomposer);
+
   gst_clear_object (&vcomposer->outpool);
   vcomposer->outpool = pool;
 
@@ -739,6 +1001,10 @@ gst_video_composer_negotiated_src_caps (GstAggregator * aggregator,
 
   vcomposer->converter = gst_video_converter_engine_new (vcomposer->backend, NULL);
 
+  GST_VIDEO_COMPOSER_LOCK (vcomposer);
+  vcomposer->invalidate = TRUE;
+  GST_VIDEO_COMPOSER_UNLOCK (vcomposer);
+
   return GST_AGGREGATOR_CLASS (parent_class)->negotiated_src_caps (aggregator, caps);
 }
 
@@ -761,6 +1027,10 @@ gst_video_composer_flush (GstAggregator * aggregator)
   GST_INFO_OBJECT (vcomposer, "Flushing video converter engine");
   gst_video_converter_engine_flush (vcomposer->converter);
 
+  GST_VIDEO_COMPOSER_LOCK (vcomposer);
+  vcomposer->invalidate = TRUE;
+  GST_VIDEO_COMPOSER_UNLOCK (vcomposer);
+
   return GST_AGGREGATOR_CLASS (parent_class)->flush (aggregator);
 }
 
@@ -793,18 +1063,50 @@ gst_video_composer_aggregate_frames (GstVideoAggregator * vaggregator,
   GstVideoComposer *vcomposer = GST_VIDEO_COMPOSER (vaggregator);
   GList *list = NULL;
   GstVideoComposition composition = GST_VCE_COMPOSITION_INIT;
+  GstVideoComposition dirty = GST_VCE_COMPOSITION_INIT;
+  GstVideoComposition *request = &composition;
+  GArray *damage = NULL;
   GstClockTime time = GST_CLOCK_TIME_NONE;
-  gboolean success = TRUE;
-  guint idx = 0, n_inputs = 0;
+  gboolean success = TRUE, incremental = FALSE;
+  guint idx = 0, n_inputs = 0, n_blits = 0;
   const GstVideoMeta *meta = NULL;
 
   // Get start time for performance measurements.
   time = gst_util_get_timestamp ();
 
+  GST_VIDEO_COMPOSER_LOCK (vcomposer);
+
+  composition.bgcolor = vcomposer->background;
+  incremental = vcomposer->incremental;
+
+  // Buffers composed prior to this frame can no longer be partially updated.
+  if (vcomposer->invalidate || (composition.bgcolor != vcomposer->lastbgcolor))
+    vcomposer->baseline = vcomposer->serial + 1;
+
+  vcomposer->invalidate = FALSE;
+  vcomposer->lastbgcolor = composition.bgcolor;
+
+  GST_VIDEO_COMPOSER_UNLOCK (vcomposer);
+
+  // Serial number of this output frame and the regions damaged in it.
+  vcomposer->serial++;
+
+  damage = vcomposer->damages[vcomposer->serial % GST_VIDEO_COMPOSER_MAX_BUFFER_AGE];
+  g_array_set_size (damage, 0);
+
   GST_OBJECT_LOCK (vaggregator);
 
-  composition.n_blits = GST_ELEMENT (vcomposer)->numsinkpads;
-  composition.blits = g_new0 (GstVideoBlit, composition.n_blits);
+  n_blits = GST_ELEMENT (vcomposer)->numsinkpads;
+
+  // Grow the persistent blits arrays if new sink pads were requested.
+  if (n_blits > vcomposer->n_blits) {
+    vcomposer->blits = g_renew (GstVideoBlit, vcomposer->blits, n_blits);
+    vcomposer->dirtyblits = g_renew (GstVideoBlit, vcomposer->dirtyblits, n_blits);
+    vcomposer->n_blits = n_blits;
+  }
+
+  composition.blits = vcomposer->blits;
+  composition.info = &GST_VIDEO_AGGREGATOR (vaggregator)->info;
 
   for (list = GST_ELEMENT (vcomposer)->sinkpads; list != NULL; list = list->next) {
     GstVideoComposerSinkPad *sinkpad = GST_VIDEO_COMPOSER_SINKPAD (list->data);
@@ -820,13 +1122,18 @@ gst_video_composer_aggregate_frames (GstVideoAggregator * vaggregator,
 
     // GAP input buffer, nothing to do.
     if (inbuffer == NULL || (gst_buffer_get_size (inbuffer) == 0 &&
-        GST_BUFFER_FLAG_IS_SET (inbuffer, GST_BUFFER_FLAG_GAP)))
+        GST_BUFFER_FLAG_IS_SET (inbuffer, GST_BUFFER_FLAG_GAP))) {
+      gst_video_composer_track_sinkpad (sinkpad, NULL, composition.info, 0,
+          damage);
       continue;
+    }
 
     // Index to the current blit object to be populated.
     idx = n_inputs;
 
     vblit = &(composition.blits[idx]);
+    memset (vblit, 0, sizeof (GstVideoBlit));
+
     vblit->buffer = inbuffer;
 
     vblit->info = &GST_VIDEO_AGGREGATOR_PAD (sinkpad)->info;
@@ -865,14 +1172,16 @@ gst_video_composer_aggregate_frames (GstVideoAggregator * vaggregator,
 
     GST_VIDEO_COMPOSER_SINKPAD_UNLOCK (sinkpad);
 
+    // Accumulate the regions which changed since the previous output frame.
+    gst_video_composer_track_sinkpad (sinkpad, vblit, composition.info, idx,
+        damage);
+
     // Increase the number of populated blit objects.
     n_inputs++;
 
     GST_TRACE_OBJECT (sinkpad, "Prepared %" GST_PTR_FORMAT, inbuffer);
   }
 
-  composition.info = &GST_VIDEO_AGGREGATOR (vaggregator)->info;
-
   GST_OBJECT_UNLOCK (vaggregator);
 
   // Return a GAP buffer if there are no lit objects available.
@@ -882,10 +1191,6 @@ gst_video_composer_aggregate_frames (GstVideoAggregator * vaggregator,
     goto cleanup;
   }
 
-  // Resize the blits array as actual number is less then the maximum.
-  if (n_inputs < composition.n_blits)
-    composition.blits = g_renew (GstVideoBlit, composition.blits, n_inputs);
-
   composition.n_blits = n_inputs;
 
   composition.buffer = outbuffer;
@@ -899,21 +1204,31 @@ gst_video_composer_aggregate_frames (GstVideoAggregator * vaggregator,
   if (!success)
     GST_WARNING_OBJECT (vcomposer, "Failed to derive info from meta");
 
-  GST_VIDEO_COMPOSER_LOCK (vcomposer);
-  composition.bgcolor = vcomposer->background;
-  GST_VIDEO_COMPOSER_UNLOCK (vcomposer);
-
   // Transfer metadata from the input buffers to the output buffer.
   gst_video_composition_populate_output_metas (vcomposer, &composition);
 
-  success = gst_video_converter_engine_compose (vcomposer->converter,
-      &composition, 1, NULL);
+  // Redraw only the damaged regions if the buffer content is known.
+  if (incremental && gst_video_composer_damaged_composition (vcomposer,
+          outbuffer, &composition, &dirty))
+    request = &dirty;
+
+  GST_LOG_OBJECT (vcomposer, "Composing %u out of %u blits", request->n_blits,
+      composition.n_blits);
+
+  // Nothing to submit when the buffer already contains the current frame.
+  success = (request->n_blits == 0) || gst_video_converter_engine_compose (
+      vcomposer->converter, request, 1, NULL);
 
   if (!success) {
     GST_WARNING_OBJECT (vcomposer, "Failed to submit request to converter!");
     goto cleanup;
   }
 
+  // Mark the buffer as containing the composition for this output frame.
+  gst_mini_object_set_qdata (GST_MINI_OBJECT (outbuffer),
+      gst_video_composer_serial_quark (), GUINT_TO_POINTER (vcomposer->serial),
+      NULL);
+
   // Get time difference between current time and start.
   time = GST_CLOCK_DIFF (time, gst_util_get_timestamp ());
 
@@ -921,9 +1236,12 @@ gst_video_composer_aggregate_frames (GstVideoAggregator * vaggregator,
       G_GINT64_FORMAT " ms", GST_TIME_AS_MSECONDS (time),
       (GST_TIME_AS_USECONDS (time) % 1000));
 
+  return GST_FLOW_OK;
+
 cleanup:
-  if (composition.blits != NULL)
-    g_free (composition.blits);
+  // Buffer content doesn't match any output frame.
+  gst_mini_object_set_qdata (GST_MINI_OBJECT (outbuffer),
+      gst_video_composer_serial_quark (), NULL, NULL);
 
   return success ? GST_FLOW_OK : GST_FLOW_ERROR;
 }
@@ -997,6 +1315,11 @@ gst_video_composer_release_pad (GstElement * element, GstPad * pad)
 
   GST_ELEMENT_CLASS (parent_class)->release_pad (GST_ELEMENT (vcomposer), pad);
 
+  // The composition state of the released pad is lost with it.
+  GST_VIDEO_COMPOSER_LOCK (vcomposer);
+  vcomposer->invalidate = TRUE;
+  GST_VIDEO_COMPOSER_UNLOCK (vcomposer);
+
   gst_pad_mark_reconfigure (GST_AGGREGATOR_SRC_PAD (vcomposer));
 }
 
@@ -1015,6 +1338,9 @@ gst_video_composer_set_property (GObject * object, guint prop_id,
     case PROP_BACKGROUND:
       vcomposer->background = g_value_get_uint (value);
       break;
+    case PROP_INCREMENTAL:
+      vcomposer->incremental = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1038,6 +1364,9 @@ gst_video_composer_get_property (GObject * object, guint prop_id,
     case PROP_BACKGROUND:
       g_value_set_uint (value, vcomposer->background);
       break;
+    case PROP_INCREMENTAL:
+      g_value_set_boolean (value, vcomposer->incremental);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1050,10 +1379,20 @@ static void
 gst_video_composer_finalize (GObject * object)
 {
   GstVideoComposer *vcomposer = GST_VIDEO_COMPOSER (object);
+  guint idx = 0;
 
   if (vcomposer->converter != NULL)
     gst_video_converter_engine_free (vcomposer->converter);
 
+  for (idx = 0; idx < GST_VIDEO_COMPOSER_MAX_BUFFER_AGE; idx++)
+    g_array_free (vcomposer->damages[idx], TRUE);
+
+  g_array_free (vcomposer->damage, TRUE);
+  g_array_free (vcomposer->pieces, TRUE);
+
+  g_free (vcomposer->blits);
+  g_free (vcomposer->dirtyblits);
+
   if (vcomposer->outpool != NULL) {
     gst_buffer_pool_set_active (vcomposer->outpool, FALSE);
     gst_object_unref (vcomposer->outpool);
@@ -1089,6 +1428,12 @@ gst_video_composer_class_init (GstVideoComposerClass * klass)
           "Background color", 0, 0xFFFFFFFF, DEFAULT_PROP_BACKGROUND,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_INCREMENTAL,
+      g_param_spec_boolean ("incremental", "Incremental",
+          "Redraw only the regions which changed since the output buffer was "
+          "composed last time. Downstream must not modify buffers in place",
+          DEFAULT_PROP_INCREMENTAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
 
   gst_element_class_set_static_metadata (element,
       "Video composer", "Filter/Editor/Video/Compositor/Scaler",
@@ -1129,12 +1474,30 @@ gst_video_composer_class_init (GstVideoComposerClass * klass)
 static void
 gst_video_composer_init (GstVideoComposer * vcomposer)
 {
+  guint idx = 0;
+
   g_mutex_init (&vcomposer->lock);
 
   vcomposer->outpool = NULL;
 
+  vcomposer->blits = NULL;
+  vcomposer->dirtyblits = NULL;
+  vcomposer->n_blits = 0;
+
+  vcomposer->serial = 0;
+  vcomposer->baseline = 0;
+  vcomposer->invalidate = TRUE;
+  vcomposer->lastbgcolor = DEFAULT_PROP_BACKGROUND;
+
+  for (idx = 0; idx < GST_VIDEO_COMPOSER_MAX_BUFFER_AGE; idx++)
+    vcomposer->damages[idx] = g_array_new (FALSE, FALSE, sizeof (GstVideoRectangle));
+
+  vcomposer->damage = g_array_new (FALSE, FALSE, sizeof (GstVideoRectangle));
+  vcomposer->pieces = g_array_new (FALSE, FALSE, sizeof (GstVideoRectangle));
+
   vcomposer->backend = DEFAULT_PROP_ENGINE_BACKEND;
   vcomposer->background = DEFAULT_PROP_BACKGROUND;
+  vcomposer->incremental = DEFAULT_PROP_INCREMENTAL;
 
   GST_AGGREGATOR_PAD (GST_AGGREGATOR (vcomposer)->srcpad)->segment.position =
       GST_CLOCK_TIME_NONE;
@@ -61,6 +61,9 @@ G_BEGIN_DECLS
 #define GST_VIDEO_COMPOSER_UNLOCK(obj) \
   g_mutex_unlock(GST_VIDEO_COMPOSER_GET_LOCK(obj))
 
+// Number of previous output frames for which damage regions are kept.
+#define GST_VIDEO_COMPOSER_MAX_BUFFER_AGE 8
+
 typedef struct _GstVideoComposer GstVideoComposer;
 typedef struct _GstVideoComposerClass GstVideoComposerClass;
 
@@ -76,9 +79,29 @@ struct _GstVideoComposer {
   /// Video converter engine.
   GstVideoConvEngine   *converter;
 
+  /// Persistent blit objects for all and for only the damaged sink pads.
+  GstVideoBlit         *blits;
+  GstVideoBlit         *dirtyblits;
+  guint                n_blits;
+
+  /// Serial number of the output frame, stored in the output buffers.
+  guint                serial;
+  /// Output buffers with serial lower than this must be fully recomposed.
+  guint                baseline;
+  /// Request to fully recompose the next output frame.
+  gboolean             invalidate;
+  /// Background color used for the last output frame.
+  guint32              lastbgcolor;
+  /// Damaged regions (GstVideoRectangle) of the last output frames.
+  GArray               *damages[GST_VIDEO_COMPOSER_MAX_BUFFER_AGE];
+  /// Scratch arrays for damage accumulation and coverage calculations.
+  GArray               *damage;
+  GArray               *pieces;
+
   /// Properties.
   GstVideoConvBackend  backend;
   guint                background;
+  gboolean             incremental;
 };
 
 struct _GstVideoComposerClass {
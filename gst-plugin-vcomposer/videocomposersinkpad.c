@@ -577,4 +577,9 @@ gst_video_composer_sinkpad_init (GstVideoComposerSinkPad * sinkpad)
   sinkpad->flip_h        = DEFAULT_PROP_FLIP_HORIZONTAL;
   sinkpad->flip_v        = DEFAULT_PROP_FLIP_VERTICAL;
   sinkpad->rotation      = DEFAULT_PROP_ROTATE;
+
+  sinkpad->lastbuffer    = NULL;
+  sinkpad->lastpts       = GST_CLOCK_TIME_NONE;
+  sinkpad->lastposition  = 0;
+  sinkpad->lastvisible   = FALSE;
 }
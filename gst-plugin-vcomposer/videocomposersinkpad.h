@@ -38,6 +38,7 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <gst/video/gstvideoaggregator.h>
+#include <gst/video/video-converter-engine.h>
 
 #include "videocomposerutils.h"
 
@@ -85,6 +86,14 @@ struct _GstVideoComposerSinkPad {
   GstVideoComposerRotate  rotation;
   gdouble                 alpha;
   gint                    zorder;
+
+  /// State of the last composed output frame, owned by the aggregate thread.
+  GstBuffer               *lastbuffer;
+  GstClockTime            lastpts;
+  GstVideoBlit            lastblit;
+  GstVideoRectangle       lastrect;
+  guint                   lastposition;
+  gboolean                lastvisible;
 };
 
 struct _GstVideoComposerSinkPadClass {
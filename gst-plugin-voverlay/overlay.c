@@ -8,6 +8,7 @@
 #endif
 
 #include "overlay.h"
+#include "overlayyuv.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,6 +39,15 @@ G_DEFINE_TYPE (GstVOverlay, gst_overlay, GST_TYPE_BASE_TRANSFORM);
 #define MAX_LABEL_LENGTH            48
 #define LABEL_FONTSIZE              40
 
+// Label atlas layout, each slot fits half of the maximum label length.
+#define LABEL_ATLAS_COLUMNS         2
+#define LABEL_ATLAS_ROWS            32
+
+// Maximum number of text masks kept for drawing directly into YUV frames.
+#define MAX_TEXT_MASKS              128
+
+#define DEFAULT_PROP_DIRECT_DRAW    FALSE
+
 enum
 {
   PROP_0,
@@ -46,8 +56,12 @@ enum
   PROP_STRINGS,
   PROP_PRIVACY_MASKS,
   PROP_STATIC_IMAGES,
+  PROP_DIRECT_DRAW,
 };
 
+// Cairo context drawing on the mapped memory of an overlay buffer.
+static G_DEFINE_QUARK (CairoContextQuark, gst_cairo_context);
+
 static GstCaps *
 gst_overlay_sink_caps (void)
 {
@@ -369,12 +383,29 @@ gst_cairo_draw_arrow (cairo_t * context, guint color, gdouble x, gdouble y,
   return (cairo_status (context) == CAIRO_STATUS_SUCCESS) ? TRUE : FALSE;
 }
 
+static inline void
+gst_cairo_select_font (cairo_t * context)
+{
+  cairo_font_options_t *options = NULL;
+
+  // Select font.
+  cairo_select_font_face (context, "@cairo:Georgia",
+      CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+  cairo_set_antialias (context, CAIRO_ANTIALIAS_BEST);
+
+  // Set font options.
+  options = cairo_font_options_create ();
+  cairo_font_options_set_antialias (options, CAIRO_ANTIALIAS_BEST);
+
+  cairo_set_font_options (context, options);
+  cairo_font_options_destroy (options);
+}
+
 static inline gboolean
-gst_cairo_draw_setup (GstVideoBlit * blit, GstVideoFrame * frame,
+gst_cairo_draw_begin (GstVideoBlit * blit, GstVideoFrame * frame,
     cairo_surface_t ** surface, cairo_t ** context)
 {
   cairo_format_t format;
-  cairo_font_options_t *options = NULL;
   gboolean success = FALSE;
 
   success = gst_video_frame_map (frame, blit->info, blit->buffer,
@@ -402,26 +433,48 @@ gst_cairo_draw_setup (GstVideoBlit * blit, GstVideoFrame * frame,
       return FALSE;
   }
 
-  *surface = cairo_image_surface_create_for_data (
-      GST_VIDEO_FRAME_PLANE_DATA (frame, 0), format,
-      GST_VIDEO_FRAME_WIDTH (frame), GST_VIDEO_FRAME_HEIGHT (frame),
-      GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0));
-  g_return_val_if_fail (*surface, FALSE);
+  // Overlay buffers are kept mapped, reuse the context from previous draws.
+  *context = gst_mini_object_get_qdata (GST_MINI_OBJECT (blit->buffer),
+      gst_cairo_context_quark ());
 
-  *context = cairo_create (*surface);
-  g_return_val_if_fail (*context, FALSE);
+  if ((*context != NULL) && (cairo_image_surface_get_data (cairo_get_target (
+          *context)) != GST_VIDEO_FRAME_PLANE_DATA (frame, 0)))
+    *context = NULL;
 
-  // Select font.
-  cairo_select_font_face (*context, "@cairo:Georgia",
-      CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-  cairo_set_antialias (*context, CAIRO_ANTIALIAS_BEST);
+  if (*context == NULL) {
+    *surface = cairo_image_surface_create_for_data (
+        GST_VIDEO_FRAME_PLANE_DATA (frame, 0), format,
+        GST_VIDEO_FRAME_WIDTH (frame), GST_VIDEO_FRAME_HEIGHT (frame),
+        GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0));
+    g_return_val_if_fail (*surface, FALSE);
 
-  // Set font options.
-  options = cairo_font_options_create ();
-  cairo_font_options_set_antialias (options, CAIRO_ANTIALIAS_BEST);
+    *context = cairo_create (*surface);
+    g_return_val_if_fail (*context, FALSE);
 
-  cairo_set_font_options (*context, options);
-  cairo_font_options_destroy (options);
+    // The context holds its own reference to the surface.
+    cairo_surface_destroy (*surface);
+
+    gst_cairo_select_font (*context);
+
+    // Context lives as long as the buffer, which returns to its pool.
+    gst_mini_object_set_qdata (GST_MINI_OBJECT (blit->buffer),
+        gst_cairo_context_quark (), *context, (GDestroyNotify) cairo_destroy);
+  }
+
+  *surface = cairo_get_target (*context);
+
+  // Drawing state is restored in gst_cairo_draw_cleanup().
+  cairo_save (*context);
+
+  return TRUE;
+}
+
+static inline gboolean
+gst_cairo_draw_setup (GstVideoBlit * blit, GstVideoFrame * frame,
+    cairo_surface_t ** surface, cairo_t ** context)
+{
+  if (!gst_cairo_draw_begin (blit, frame, surface, context))
+    return FALSE;
 
   // Clear any leftovers from previous operations.
   cairo_set_operator (*context, CAIRO_OPERATOR_CLEAR);
@@ -441,13 +494,36 @@ static inline void
 gst_cairo_draw_cleanup (GstVideoFrame * frame, cairo_surface_t * surface,
     cairo_t * context)
 {
+  cairo_restore (context);
+
   // Flush to ensure all writing to the surface has been done.
   cairo_surface_flush (surface);
 
   gst_video_frame_unmap (frame);
+}
 
-  cairo_destroy (context);
-  cairo_surface_destroy (surface);
+static inline guint
+gst_overlay_contrast_color (guint color)
+{
+  // Choose the best contrasting color to the background.
+  return GST_COLOR_ALPHA (color) +
+      (((GST_COLOR_RED (color) > 0x7F) ? 0x00 : 0xFF) << 8) +
+      (((GST_COLOR_GREEN (color) > 0x7F) ? 0x00 : 0xFF) << 16) +
+      (((GST_COLOR_BLUE (color) > 0x7F) ? 0x00 : 0xFF) << 24);
+}
+
+static inline gboolean
+gst_cairo_draw_label (cairo_t * context, guint color, gdouble x, gdouble y,
+    gchar * text, gdouble fontsize)
+{
+  // Fill the label background.
+  cairo_set_source_rgba (context, GST_FLOAT_COLOR_BLUE (color),
+      GST_FLOAT_COLOR_GREEN (color), GST_FLOAT_COLOR_RED (color),
+      GST_FLOAT_COLOR_ALPHA (color));
+  cairo_paint (context);
+
+  return gst_cairo_draw_text (context, gst_overlay_contrast_color (color),
+      x, y, text, fontsize);
 }
 
 static inline void
@@ -553,6 +629,22 @@ gst_overlay_create_pool (GstVOverlay * overlay, GstCaps * caps)
   return pool;
 }
 
+static inline guint
+gst_overlay_label_text (GstClassLabel * label, GstStructure * objparam,
+    gchar * text)
+{
+  guint track_id = -1;
+
+  if (objparam != NULL &&
+      gst_structure_get_uint (objparam, "tracking-id", &track_id)) {
+    const gchar *name = g_quark_to_string (label->name);
+    return g_snprintf (text, MAX_LABEL_LENGTH, "%s-%u", name, track_id);
+  }
+
+  return g_snprintf (text, MAX_LABEL_LENGTH, "%s",
+      g_quark_to_string (label->name));
+}
+
 static gboolean
 gst_overlay_handle_classification_entry (GstVOverlay * overlay,
     cairo_t * context, GstVideoBlit * blit, GstClassLabel * label,
@@ -561,9 +653,8 @@ gst_overlay_handle_classification_entry (GstVOverlay * overlay,
   gchar text[MAX_LABEL_LENGTH] = { 0, };
   GstVideoRectangle source = {0}, *destination = NULL;
   gdouble x = 1.0, y = 1.0, fontsize = LABEL_FONTSIZE;
-  guint length = 0, color = 0xFFFFFFFF;
+  guint length = 0;
   gboolean success = TRUE;
-  guint track_id = -1;
 
   if (GST_FLOAT_COLOR_ALPHA (label->color) == 0.0)
     return success;
@@ -574,33 +665,12 @@ gst_overlay_handle_classification_entry (GstVOverlay * overlay,
   destination->w = source.w;
   destination->h = source.h;
 
-  if (objparam != NULL &&
-      gst_structure_get_uint (objparam, "tracking-id", &track_id)) {
-    const gchar *name = g_quark_to_string (label->name);
-    length = g_snprintf (text, MAX_LABEL_LENGTH, "%s-%u", name, track_id);
-  } else {
-    length = g_snprintf (text, MAX_LABEL_LENGTH, "%s",
-       g_quark_to_string (label->name));
-  }
-
-
-  color = label->color;
+  length = gst_overlay_label_text (label, objparam, text);
 
   GST_TRACE_OBJECT (overlay, "Label: %s, Color: 0x%X, Position: [%.2f %.2f],"
-      " Fontsize: %.2f", text, color, x, y, fontsize);
-
-  cairo_set_source_rgba (context, GST_FLOAT_COLOR_BLUE (color),
-      GST_FLOAT_COLOR_GREEN (color), GST_FLOAT_COLOR_RED (color),
-      GST_FLOAT_COLOR_ALPHA (color));
-  cairo_paint (context);
-
-  // Choose the best contrasting color to the background.
-  color = GST_COLOR_ALPHA (color);
-  color += ((GST_COLOR_RED (label->color) > 0x7F) ? 0x00 : 0xFF) << 8;
-  color += ((GST_COLOR_GREEN (label->color) > 0x7F) ? 0x00 : 0xFF) << 16;
-  color += ((GST_COLOR_BLUE (label->color) > 0x7F) ? 0x00 : 0xFF) << 24;
+      " Fontsize: %.2f", text, label->color, x, y, fontsize);
 
-  success = gst_cairo_draw_text (context, color, x, y, text, fontsize);
+  success = gst_cairo_draw_label (context, label->color, x, y, text, fontsize);
 
   // Update the source and destination with the actual text dimensions.
   destination->w = source.w = ceil (length * fontsize * 3.0F / 5.0F);
@@ -1211,6 +1281,257 @@ gst_overlay_video_blit_initialize (GstVOverlay * overlay, guint ovltype,
   return TRUE;
 }
 
+static void
+gst_overlay_label_atlas_reset (GstVOverlay * overlay)
+{
+  GstOverlayLabel *label = NULL;
+
+  // Labels are owned by the queue, the hash table only indexes them.
+  g_hash_table_remove_all (overlay->labels);
+
+  while ((label = g_queue_pop_head (overlay->lrulabels)) != NULL)
+    gst_overlay_label_free (label);
+
+  // Unreference atlas twice as 2nd refcount marks its blits as cached.
+  if (overlay->atlas != NULL) {
+    gst_buffer_unref (overlay->atlas);
+    gst_buffer_unref (overlay->atlas);
+    overlay->atlas = NULL;
+  }
+
+  if (overlay->atlaspool != NULL) {
+    gst_buffer_pool_set_active (overlay->atlaspool, FALSE);
+    gst_clear_object (&overlay->atlaspool);
+  }
+
+  if (overlay->atlasinfo != NULL) {
+    gst_video_info_free (overlay->atlasinfo);
+    overlay->atlasinfo = NULL;
+  }
+}
+
+static gboolean
+gst_overlay_label_atlas_render (GstVOverlay * overlay,
+    const GstVideoRectangle * slot, gchar * text, guint color,
+    gdouble fontsize)
+{
+  cairo_surface_t *surface = NULL;
+  cairo_t *context = NULL;
+  GstVideoFrame frame = {0,};
+  GstVideoBlit blit = GST_VCE_BLIT_INIT;
+  gboolean success = FALSE;
+
+  blit.buffer = overlay->atlas;
+  blit.info = overlay->atlasinfo;
+
+  success = gst_cairo_draw_begin (&blit, &frame, &surface, &context);
+  g_return_val_if_fail (success, FALSE);
+
+  // Restrict drawing to the slot, other slots hold labels which are in use.
+  cairo_rectangle (context, slot->x, slot->y, slot->w, slot->h);
+  cairo_clip (context);
+  cairo_translate (context, slot->x, slot->y);
+
+  // Clear the label which previously occupied this slot.
+  cairo_set_operator (context, CAIRO_OPERATOR_CLEAR);
+  cairo_paint (context);
+  cairo_set_operator (context, CAIRO_OPERATOR_OVER);
+
+  success = gst_cairo_draw_label (context, color, 1.0, 1.0, text, fontsize);
+
+  gst_cairo_draw_cleanup (&frame, surface, context);
+
+  return success;
+}
+
+static gboolean
+gst_overlay_label_atlas_fetch (GstVOverlay * overlay, GstVideoBlit * blit,
+    gchar * text, guint color, gdouble fontsize)
+{
+  GstOverlayLabel *label = NULL;
+  GstVideoRectangle source = {0}, slot = {0};
+  gchar key[MAX_LABEL_LENGTH + 32] = { 0, };
+  guint n_slots = LABEL_ATLAS_COLUMNS * LABEL_ATLAS_ROWS;
+  gint width = 0;
+
+  if (overlay->atlaspool == NULL)
+    return FALSE;
+
+  slot.w = GST_VIDEO_INFO_WIDTH (overlay->atlasinfo) / LABEL_ATLAS_COLUMNS;
+  slot.h = GST_VIDEO_INFO_HEIGHT (overlay->atlasinfo) / LABEL_ATLAS_ROWS;
+
+  // Width of the text, using the same estimation as for dedicated buffers.
+  width = ceil (strlen (text) * fontsize * 3.0F / 5.0F);
+
+  if ((width > slot.w) || (fontsize > slot.h))
+    return FALSE;
+
+  if (overlay->atlas == NULL) {
+    if (!gst_buffer_pool_is_active (overlay->atlaspool) &&
+        !gst_buffer_pool_set_active (overlay->atlaspool, TRUE)) {
+      GST_ERROR_OBJECT (overlay, "Failed to activate label atlas pool!");
+      return FALSE;
+    }
+
+    if (gst_buffer_pool_acquire_buffer (overlay->atlaspool, &(overlay->atlas),
+            NULL) != GST_FLOW_OK) {
+      GST_ERROR_OBJECT (overlay, "Failed to acquire label atlas buffer!");
+      return FALSE;
+    }
+
+    // Increase the buffer refcount, this will be used as indicator that
+    // the blit objects using the atlas are cached and must not free it.
+    gst_buffer_ref (overlay->atlas);
+  }
+
+  g_snprintf (key, sizeof (key), "%.2f:%08X:%s", fontsize, color, text);
+
+  if ((label = g_hash_table_lookup (overlay->labels, key)) != NULL) {
+    // Move the label to the head of the least recently used queue.
+    g_queue_unlink (overlay->lrulabels, label->link);
+    g_queue_push_head_link (overlay->lrulabels, label->link);
+  } else if (g_queue_get_length (overlay->lrulabels) < n_slots) {
+    label = g_new0 (GstOverlayLabel, 1);
+    label->slot = g_queue_get_length (overlay->lrulabels);
+
+    g_queue_push_head (overlay->lrulabels, label);
+    label->link = overlay->lrulabels->head;
+  } else {
+    label = g_queue_peek_tail (overlay->lrulabels);
+
+    // All slots are occupied by labels which are used in the current frame.
+    if (label->frame == overlay->n_frames)
+      return FALSE;
+
+    GST_TRACE_OBJECT (overlay, "Evicting label '%s' from slot %u",
+        GST_STR_NULL (label->key), label->slot);
+
+    // Slot may hold a label which previously failed to render.
+    if (label->key != NULL)
+      g_hash_table_remove (overlay->labels, label->key);
+
+    g_clear_pointer (&(label->key), g_free);
+
+    g_queue_unlink (overlay->lrulabels, label->link);
+    g_queue_push_head_link (overlay->lrulabels, label->link);
+  }
+
+  slot.x = (label->slot % LABEL_ATLAS_COLUMNS) * slot.w;
+  slot.y = (label->slot / LABEL_ATLAS_COLUMNS) * slot.h;
+
+  // Rasterize new labels, the text is drawn only once for its lifetime.
+  if (label->key == NULL) {
+    if (!gst_overlay_label_atlas_render (overlay, &slot, text, color, fontsize)) {
+      GST_ERROR_OBJECT (overlay, "Failed to render label '%s'!", text);
+
+      // Keep the slot without a label, it will be the first to be reused.
+      g_queue_unlink (overlay->lrulabels, label->link);
+      g_queue_push_tail_link (overlay->lrulabels, label->link);
+
+      label->frame = 0;
+      return FALSE;
+    }
+
+    label->key = g_strdup (key);
+    label->width = width;
+
+    g_hash_table_insert (overlay->labels, label->key, label);
+  }
+
+  label->frame = overlay->n_frames;
+
+  blit->buffer = overlay->atlas;
+  blit->info = overlay->atlasinfo;
+  blit->mask = (GST_VCE_MASK_SOURCE | GST_VCE_MASK_DESTINATION);
+  blit->alpha = G_MAXUINT8;
+
+  source.x = slot.x;
+  source.y = slot.y;
+  source.w = label->width;
+  source.h = slot.h;
+
+  gst_video_quadrilateral_from_rectangle (&(blit->source), &source);
+
+  // The default value is for 1080p resolution, scale up/down based on that.
+  blit->destination.x = blit->destination.y = 0;
+  blit->destination.w =
+      source.w * (GST_VIDEO_INFO_HEIGHT (overlay->vinfo) / 1080.0F);
+  blit->destination.h =
+      source.h * (GST_VIDEO_INFO_HEIGHT (overlay->vinfo) / 1080.0F);
+
+  GST_TRACE_OBJECT (overlay, "Label '%s' from atlas slot %u: [%d %d %d %d]",
+      text, label->slot, source.x, source.y, source.w, source.h);
+
+  return TRUE;
+}
+
+static gboolean
+gst_overlay_draw_label_blit (GstVOverlay * overlay, GstVideoBlit * blit,
+    GstClassLabel * label, GstStructure * objparam)
+{
+  cairo_surface_t *surface = NULL;
+  cairo_t *context = NULL;
+  GstVideoFrame frame = {0,};
+  gchar text[MAX_LABEL_LENGTH] = { 0, };
+  gboolean success = FALSE;
+
+  gst_overlay_label_text (label, objparam, text);
+
+  // Labels repeat across frames, take the already rendered one from the atlas.
+  if (gst_overlay_label_atlas_fetch (overlay, blit, text, label->color,
+          LABEL_FONTSIZE))
+    return TRUE;
+
+  // Atlas is exhausted or the label doesn't fit, draw it in its own buffer.
+  success = gst_overlay_video_blit_initialize (overlay,
+      GST_OVERLAY_TYPE_CLASSIFICATION, blit);
+  g_return_val_if_fail (success, FALSE);
+
+  success = gst_cairo_draw_setup (blit, &frame, &surface, &context);
+  g_return_val_if_fail (success, FALSE);
+
+  success = gst_overlay_handle_classification_entry (overlay, context, blit,
+      label, objparam);
+
+  gst_cairo_draw_cleanup (&frame, surface, context);
+
+  return success;
+}
+
+static GstClassLabel *
+gst_overlay_detection_label (GstBuffer * buffer,
+    GstVideoRegionOfInterestMeta * roimeta, GstStructure * objparam,
+    GstClassLabel * deflabel)
+{
+  GstVideoClassificationMeta *classmeta = NULL;
+  GstClassLabel *label = NULL;
+  GstMeta *meta = NULL;
+  gpointer state = NULL;
+
+  // Fetch the top label from classification derived from this ROI.
+  while ((meta = gst_buffer_iterate_meta_filtered (buffer, &state,
+              GST_VIDEO_CLASSIFICATION_META_API_TYPE)) != NULL) {
+    classmeta = GST_VIDEO_CLASSIFICATION_META_CAST (meta);
+
+    if (classmeta->parent_id != roimeta->id)
+      continue;
+
+    label = &(g_array_index (classmeta->labels, GstClassLabel, 0));
+
+    if (GST_FLOAT_COLOR_ALPHA (label->color) != 0.0)
+      return label;
+  }
+
+  // Fallback to the ROI type and the color of the bounding box.
+  label = deflabel;
+
+  label->name = roimeta->roi_type;
+  gst_structure_get_uint (objparam, "color", &(label->color));
+  gst_structure_get_double (objparam, "confidence", &(label->confidence));
+
+  return label;
+}
+
 static gboolean
 gst_overlay_draw_detection_entries (GstVOverlay * overlay,
     GstVideoComposition * composition, guint * index)
@@ -1219,7 +1540,6 @@ gst_overlay_draw_detection_entries (GstVOverlay * overlay,
   GstVideoFrame frame = {0,};
   GstVideoRegionOfInterestMeta *roimeta = NULL;
   GstVideoLandmarksMeta *lmkmeta = NULL;
-  GstVideoClassificationMeta *classmeta = NULL;
   GstVideoBlit *blit = NULL;
   GstStructure *objparam = NULL;
   GstMeta *meta = NULL, *submeta = NULL;
@@ -1230,7 +1550,8 @@ gst_overlay_draw_detection_entries (GstVOverlay * overlay,
               GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)) != NULL) {
     cairo_surface_t *surface = NULL;
     cairo_t *context = NULL;
-    gboolean haslabel = FALSE, haslndmrks = FALSE;
+    GstClassLabel deflabel = { 0, }, *label = NULL;
+    gboolean haslndmrks = FALSE;
 
     roimeta = GST_VIDEO_ROI_META_CAST (meta);
 
@@ -1284,57 +1605,25 @@ gst_overlay_draw_detection_entries (GstVOverlay * overlay,
 
     gst_cairo_draw_cleanup (&frame, surface, context);
 
-    // Second blit object is for the detection label.
-    blit = &(composition->blits[(*index) + 1]);
+    // Increase the index with the populated bounding box blit object.
+    *index += 1;
 
-    success = gst_overlay_video_blit_initialize(overlay,
-        GST_OVERLAY_TYPE_CLASSIFICATION, blit);
+    label = gst_overlay_detection_label (outbuffer, roimeta, objparam,
+        &deflabel);
 
-    success = gst_cairo_draw_setup (blit, &frame, &surface, &context);
-    g_return_val_if_fail (success, FALSE);
+    // Nothing to draw, skip the auxiliary label blit.
+    if (GST_FLOAT_COLOR_ALPHA (label->color) == 0.0)
+      continue;
+
+    // Second blit object is for the detection label.
+    blit = &(composition->blits[(*index)]);
+
+    success &= gst_overlay_draw_label_blit (overlay, blit, label, objparam);
 
     // Initialize the destination X/Y of the auxiliary label blit.
     blit->destination.x = roimeta->x;
     blit->destination.y = roimeta->y;
 
-    // Fetch the top label from classification derived from this ROI.
-    while ((submeta = gst_buffer_iterate_meta_filtered (outbuffer, &substate,
-                GST_VIDEO_CLASSIFICATION_META_API_TYPE)) != NULL) {
-      GstClassLabel *label = NULL;
-      classmeta = GST_VIDEO_CLASSIFICATION_META_CAST (submeta);
-
-      if (classmeta->parent_id != roimeta->id)
-        continue;
-
-      label = &(g_array_index (classmeta->labels, GstClassLabel, 0));
-
-      if (GST_FLOAT_COLOR_ALPHA (label->color) == 0.0)
-        continue;
-
-      success &= gst_overlay_handle_classification_entry (overlay, context,
-          blit, label, objparam);
-
-      haslabel = TRUE;
-      break;
-    }
-
-    substate = NULL;
-
-    if (!haslabel) {
-      GstClassLabel label = { 0, };
-
-      label.name = roimeta->roi_type;
-      gst_structure_get_uint (objparam, "color", &(label.color));
-      gst_structure_get_double (objparam, "confidence", &(label.confidence));
-
-      if (GST_FLOAT_COLOR_ALPHA (label.color) != 0.0) {
-        success &= gst_overlay_handle_classification_entry (overlay, context,
-            blit, &label, objparam);
-      }
-    }
-
-    gst_cairo_draw_cleanup (&frame, surface, context);
-
     // Correct the destination of the auxiliary label blit.
     if ((blit->destination.y -= blit->destination.h) < 0)
       blit->destination.y = roimeta->y + roimeta->h;
@@ -1343,8 +1632,8 @@ gst_overlay_draw_detection_entries (GstVOverlay * overlay,
             GST_VIDEO_INFO_WIDTH (overlay->vinfo))
       blit->destination.x = roimeta->x + roimeta->w - blit->destination.w;
 
-    // Increase the index with the number of populated blit objects.
-    *index += 2;
+    // Increase the index with the populated label blit object.
+    *index += 1;
   }
 
   if (!success) {
@@ -1360,7 +1649,6 @@ gst_overlay_draw_classification_entries (GstVOverlay * overlay,
     GstVideoComposition * composition, guint * index)
 {
   GstBuffer *outbuffer = composition->buffer;
-  GstVideoFrame frame = {0,};
   GstVideoClassificationMeta *classmeta = NULL;
   GstVideoBlit *blit = NULL;
   GstClassLabel *label = NULL;
@@ -1371,9 +1659,6 @@ gst_overlay_draw_classification_entries (GstVOverlay * overlay,
 
   while ((meta = gst_buffer_iterate_meta_filtered (outbuffer, &state,
               GST_VIDEO_CLASSIFICATION_META_API_TYPE)) != NULL) {
-    cairo_surface_t *surface = NULL;
-    cairo_t *context = NULL;
-
     classmeta = GST_VIDEO_CLASSIFICATION_META_CAST (meta);
 
     // Derived metas will be handled inside the detection entry function.
@@ -1387,21 +1672,12 @@ gst_overlay_draw_classification_entries (GstVOverlay * overlay,
       if (GST_FLOAT_COLOR_ALPHA (label->color) == 0.0)
         continue;
 
-      success = gst_overlay_video_blit_initialize (overlay,
-          GST_OVERLAY_TYPE_CLASSIFICATION, blit);
+      success = gst_overlay_draw_label_blit (overlay, blit, label, NULL);
       g_return_val_if_fail (success, FALSE);
 
       // Set Y axis offset due to the multiple labels.
       blit->destination.y = offset;
 
-      success = gst_cairo_draw_setup (blit, &frame, &surface, &context);
-
-      g_return_val_if_fail (success, FALSE);
-
-      success &= gst_overlay_handle_classification_entry (overlay, context,
-          blit, label, NULL);
-      gst_cairo_draw_cleanup (&frame, surface, context);
-
       // Increase the Y axis offset for the next label blit.
       offset += blit->destination.h;
     }
@@ -1740,9 +2016,349 @@ gst_overlay_draw_static_image_entries (GstVOverlay * overlay,
   return TRUE;
 }
 
+static const GstOverlayTextMask *
+gst_overlay_text_mask_fetch (GstVOverlay * overlay, const gchar * text,
+    gdouble fontsize)
+{
+  GstOverlayTextMask *mask = NULL;
+  cairo_surface_t *surface = NULL;
+  cairo_t *context = NULL;
+  gchar key[MAX_LABEL_LENGTH + 32] = { 0, };
+  gdouble offset = fontsize / LABEL_FONTSIZE;
+  gboolean success = FALSE;
+
+  g_snprintf (key, sizeof (key), "%.2f:%s", fontsize, text);
+
+  if ((mask = g_hash_table_lookup (overlay->textmasks, key)) != NULL) {
+    // Move the mask to the head of the least recently used queue.
+    g_queue_unlink (overlay->lrutextmasks, mask->link);
+    g_queue_push_head_link (overlay->lrutextmasks, mask->link);
+    return mask;
+  }
+
+  mask = g_new0 (GstOverlayTextMask, 1);
+
+  // Same text dimensions estimation as for labels in overlay buffers.
+  mask->width = ceil (strlen (text) * fontsize * 3.0F / 5.0F);
+  mask->height = ceil (fontsize);
+  mask->stride = cairo_format_stride_for_width (CAIRO_FORMAT_A8, mask->width);
+  mask->data = g_malloc0 (mask->stride * mask->height);
+
+  surface = cairo_image_surface_create_for_data (mask->data, CAIRO_FORMAT_A8,
+      mask->width, mask->height, mask->stride);
+  context = cairo_create (surface);
+
+  gst_cairo_select_font (context);
+
+  // Only the text coverage is stored, the color is applied during blending.
+  success = gst_cairo_draw_text (context, 0xFFFFFFFF, offset, offset,
+      (gchar *) text, fontsize);
+  cairo_surface_flush (surface);
+
+  cairo_destroy (context);
+  cairo_surface_destroy (surface);
+
+  if (!success) {
+    GST_ERROR_OBJECT (overlay, "Failed to render text mask '%s'!", text);
+    gst_overlay_text_mask_free (mask);
+    return NULL;
+  }
+
+  mask->key = g_strdup (key);
+
+  g_queue_push_head (overlay->lrutextmasks, mask);
+  mask->link = overlay->lrutextmasks->head;
+
+  g_hash_table_insert (overlay->textmasks, mask->key, mask);
+
+  // Masks are used immediately, the least recently used one can be dropped.
+  if (g_queue_get_length (overlay->lrutextmasks) > MAX_TEXT_MASKS) {
+    GstOverlayTextMask *lrumask = g_queue_pop_tail (overlay->lrutextmasks);
+
+    GST_TRACE_OBJECT (overlay, "Evicting text mask '%s'", lrumask->key);
+
+    g_hash_table_remove (overlay->textmasks, lrumask->key);
+    gst_overlay_text_mask_free (lrumask);
+  }
+
+  return mask;
+}
+
+static const GstOverlayTextMask *
+gst_overlay_yuv_label_mask (GstVOverlay * overlay, GstVideoFrame * frame,
+    GstClassLabel * label, GstStructure * objparam)
+{
+  gchar text[MAX_LABEL_LENGTH] = { 0, };
+  gdouble fontsize = 0.0;
+
+  gst_overlay_label_text (label, objparam, text);
+
+  // The default value is for 1080p resolution, scale up/down based on that.
+  fontsize = LABEL_FONTSIZE * (GST_VIDEO_FRAME_HEIGHT (frame) / 1080.0F);
+
+  return gst_overlay_text_mask_fetch (overlay, text, fontsize);
+}
+
+static void
+gst_overlay_yuv_draw_label (GstVOverlay * overlay, GstVideoFrame * frame,
+    const GstOverlayTextMask * mask, guint labelcolor, gint x, gint y)
+{
+  GstOverlayYuvColor color;
+
+  GST_TRACE_OBJECT (overlay, "Label: %s, Color: 0x%X, Rectangle: [%d %d %d %d]",
+      mask->key, labelcolor, x, y, mask->width, mask->height);
+
+  gst_overlay_yuv_color (frame, labelcolor, &color);
+  gst_overlay_yuv_fill_rectangle (frame, &color, x, y, mask->width,
+      mask->height);
+
+  gst_overlay_yuv_color (frame, gst_overlay_contrast_color (labelcolor),
+      &color);
+  gst_overlay_yuv_draw_mask (frame, &color, x, y, mask->data, mask->width,
+      mask->height, mask->stride);
+}
+
+static void
+gst_overlay_yuv_draw_landmarks (GstVOverlay * overlay, GstVideoFrame * frame,
+    GArray * keypoints, GArray * links)
+{
+  GstOverlayYuvColor color;
+  guint idx = 0;
+
+  for (idx = 0; idx < keypoints->len; idx++) {
+    GstVideoKeypoint *kp = &(g_array_index (keypoints, GstVideoKeypoint, idx));
+
+    if (GST_FLOAT_COLOR_ALPHA (kp->color) == 0.0)
+      continue;
+
+    GST_TRACE_OBJECT (overlay, "Keypoint: %s, Position: [%d %d], "
+        "Confidence: %.2f, Color: 0x%X", g_quark_to_string (kp->name),
+        kp->x, kp->y, kp->confidence, kp->color);
+
+    gst_overlay_yuv_color (frame, kp->color, &color);
+    gst_overlay_yuv_fill_circle (frame, &color, kp->x, kp->y, 2.0);
+  }
+
+  for (idx = 0; (links != NULL) && (idx < links->len); idx++) {
+    GstVideoKeypointLink *link = NULL;
+    GstVideoKeypoint *s_kp = NULL, *d_kp = NULL;
+
+    link = &(g_array_index (links, GstVideoKeypointLink, idx));
+    s_kp = &(g_array_index (keypoints, GstVideoKeypoint, link->s_kp_idx));
+    d_kp = &(g_array_index (keypoints, GstVideoKeypoint, link->d_kp_idx));
+
+    if (GST_FLOAT_COLOR_ALPHA (s_kp->color) == 0.0)
+      continue;
+
+    gst_overlay_yuv_color (frame, s_kp->color, &color);
+    gst_overlay_yuv_draw_line (frame, &color, s_kp->x, s_kp->y, d_kp->x,
+        d_kp->y, 4.0);
+  }
+}
+
+static gboolean
+gst_overlay_yuv_draw_detection_entries (GstVOverlay * overlay,
+    GstVideoFrame * frame)
+{
+  GstVideoRegionOfInterestMeta *roimeta = NULL;
+  GstVideoLandmarksMeta *lmkmeta = NULL;
+  GstStructure *objparam = NULL;
+  GstMeta *meta = NULL, *submeta = NULL;
+  GstOverlayYuvColor color;
+  gpointer state = NULL, substate = NULL;
+  gboolean success = TRUE;
+
+  while ((meta = gst_buffer_iterate_meta_filtered (frame->buffer, &state,
+              GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)) != NULL) {
+    GstClassLabel deflabel = { 0, }, *label = NULL;
+    const GstOverlayTextMask *mask = NULL;
+    gint x = 0, y = 0;
+    guint boxcolor = 0x000000FF;
+    gboolean haslndmrks = FALSE;
+
+    roimeta = GST_VIDEO_ROI_META_CAST (meta);
+
+    // Skip if ROI is a ImageRegion with actual data (populated by vsplit).
+    if (roimeta->roi_type == g_quark_from_static_string ("ImageRegion"))
+      continue;
+
+    // Extract the structure containing ROI parameters.
+    objparam = gst_video_region_of_interest_meta_get_param (roimeta,
+        "ObjectDetection");
+    gst_structure_get_uint (objparam, "color", &boxcolor);
+
+    GST_TRACE_OBJECT (overlay, "Rectangle: [%d %d %d %d], Color: 0x%X",
+        roimeta->x, roimeta->y, roimeta->w, roimeta->h, boxcolor);
+
+    gst_overlay_yuv_color (frame, boxcolor, &color);
+    gst_overlay_yuv_draw_rectangle (frame, &color, roimeta->x, roimeta->y,
+        roimeta->w, roimeta->h, 4);
+
+    // Process all landmarks metas derived from this ROI.
+    while ((submeta = gst_buffer_iterate_meta_filtered (frame->buffer,
+                &substate, GST_VIDEO_LANDMARKS_META_API_TYPE)) != NULL) {
+      lmkmeta = GST_VIDEO_LANDMARKS_META_CAST (submeta);
+
+      if (lmkmeta->parent_id != roimeta->id)
+        continue;
+
+      gst_overlay_yuv_draw_landmarks (overlay, frame, lmkmeta->keypoints,
+          lmkmeta->links);
+      haslndmrks = TRUE;
+    }
+
+    substate = NULL;
+
+    // Process any additional landmarks if present.
+    if (!haslndmrks && gst_structure_has_field (objparam, "landmarks")) {
+      GArray *keypoints = NULL;
+
+      gst_structure_get (objparam, "landmarks", G_TYPE_ARRAY, &keypoints, NULL);
+      gst_overlay_yuv_draw_landmarks (overlay, frame, keypoints, NULL);
+
+      g_array_unref (keypoints);
+    }
+
+    label = gst_overlay_detection_label (frame->buffer, roimeta, objparam,
+        &deflabel);
+
+    if (GST_FLOAT_COLOR_ALPHA (label->color) == 0.0)
+      continue;
+
+    if ((mask = gst_overlay_yuv_label_mask (overlay, frame, label,
+            objparam)) == NULL) {
+      success = FALSE;
+      continue;
+    }
+
+    x = roimeta->x;
+    y = roimeta->y;
+
+    // Place the label above the box or below it if there is no space.
+    if ((y -= mask->height) < 0)
+      y = roimeta->y + roimeta->h;
+
+    if ((x + mask->width) > (gint) GST_VIDEO_FRAME_WIDTH (frame))
+      x = roimeta->x + roimeta->w - mask->width;
+
+    gst_overlay_yuv_draw_label (overlay, frame, mask, label->color, x, y);
+  }
+
+  return success;
+}
+
+static void
+gst_overlay_yuv_draw_landmarks_entries (GstVOverlay * overlay,
+    GstVideoFrame * frame)
+{
+  GstVideoLandmarksMeta *lmkmeta = NULL;
+  GstMeta *meta = NULL;
+  gpointer state = NULL;
+
+  while ((meta = gst_buffer_iterate_meta_filtered (frame->buffer, &state,
+              GST_VIDEO_LANDMARKS_META_API_TYPE)) != NULL) {
+    lmkmeta = GST_VIDEO_LANDMARKS_META_CAST (meta);
+
+    // Derived metas are handled inside the detection entries function.
+    if (gst_buffer_has_valid_parent_meta (frame->buffer, lmkmeta->parent_id))
+      continue;
+
+    gst_overlay_yuv_draw_landmarks (overlay, frame, lmkmeta->keypoints,
+        lmkmeta->links);
+  }
+}
+
+static gboolean
+gst_overlay_yuv_draw_classification_entries (GstVOverlay * overlay,
+    GstVideoFrame * frame)
+{
+  GstVideoClassificationMeta *classmeta = NULL;
+  const GstOverlayTextMask *mask = NULL;
+  GstClassLabel *label = NULL;
+  GstMeta *meta = NULL;
+  gpointer state = NULL;
+  guint num = 0;
+  gint offset = 0;
+  gboolean success = TRUE;
+
+  while ((meta = gst_buffer_iterate_meta_filtered (frame->buffer, &state,
+              GST_VIDEO_CLASSIFICATION_META_API_TYPE)) != NULL) {
+    classmeta = GST_VIDEO_CLASSIFICATION_META_CAST (meta);
+
+    // Derived metas are handled inside the detection entries function.
+    if (gst_buffer_has_valid_parent_meta (frame->buffer, classmeta->parent_id))
+      continue;
+
+    for (num = 0; num < classmeta->labels->len; num++) {
+      label = &(g_array_index (classmeta->labels, GstClassLabel, num));
+
+      if (GST_FLOAT_COLOR_ALPHA (label->color) == 0.0)
+        continue;
+
+      if ((mask = gst_overlay_yuv_label_mask (overlay, frame, label,
+              NULL)) == NULL) {
+        success = FALSE;
+        continue;
+      }
+
+      // Stack the labels on top of each other in the upper left corner.
+      gst_overlay_yuv_draw_label (overlay, frame, mask, label->color, 0, offset);
+      offset += mask->height;
+    }
+  }
+
+  return success;
+}
+
+static void
+gst_overlay_yuv_draw_bbox_entries (GstVOverlay * overlay, GstVideoFrame * frame)
+{
+  GstOverlayYuvColor color;
+  guint num = 0;
+
+  for (num = 0; num < overlay->bboxes->len; num++) {
+    GstOverlayBBox *bbox = &g_array_index (overlay->bboxes, GstOverlayBBox, num);
+
+    // Skip this bounding box entry as it has been disabled or alpha is 0.
+    if (!bbox->enable || GST_FLOAT_COLOR_ALPHA (bbox->color) == 0.0)
+      continue;
+
+    gst_overlay_yuv_color (frame, bbox->color, &color);
+    gst_overlay_yuv_draw_rectangle (frame, &color, bbox->destination.x,
+        bbox->destination.y, bbox->destination.w, bbox->destination.h, 4);
+  }
+}
+
+static gboolean
+gst_overlay_yuv_draw_entries (GstVOverlay * overlay, GstBuffer * buffer)
+{
+  GstVideoFrame frame = {0,};
+  gboolean success = TRUE;
+
+  // Shapes and text are rasterized straight into the frame planes, only the
+  // touched pixels are read and written without any intermediate buffers.
+  if (!gst_video_frame_map (&frame, overlay->vinfo, buffer,
+          GST_MAP_READWRITE | GST_VIDEO_FRAME_MAP_FLAG_NO_REF)) {
+    GST_ERROR_OBJECT (overlay, "Failed to map buffer!");
+    return FALSE;
+  }
+
+  GST_OVERLAY_LOCK (overlay);
+
+  success &= gst_overlay_yuv_draw_detection_entries (overlay, &frame);
+  gst_overlay_yuv_draw_landmarks_entries (overlay, &frame);
+  success &= gst_overlay_yuv_draw_classification_entries (overlay, &frame);
+  gst_overlay_yuv_draw_bbox_entries (overlay, &frame);
+
+  GST_OVERLAY_UNLOCK (overlay);
+
+  gst_video_frame_unmap (&frame);
+  return success;
+}
+
 static gboolean
 gst_overlay_draw_ovelay_blits (GstVOverlay * overlay,
-    GstVideoComposition * composition)
+    GstVideoComposition * composition, gboolean direct)
 {
   GstBuffer *outbuffer = composition->buffer;
   GstMeta *meta = NULL;
@@ -1768,6 +2384,9 @@ gst_overlay_draw_ovelay_blits (GstVOverlay * overlay,
 
   GST_OVERLAY_LOCK (overlay);
 
+  // Labels drawn for this frame must not be evicted from the atlas.
+  overlay->n_frames++;
+
   // Add the number of manually set bounding boxes.
   composition->n_blits += overlay->bboxes->len;
   // Add the number of manually set timestamps.
@@ -1782,27 +2401,33 @@ gst_overlay_draw_ovelay_blits (GstVOverlay * overlay,
   // Allocate maximum possible blit structures for each of the entries.
   composition->blits = g_new0 (GstVideoBlit, composition->n_blits);
 
-  // Iterate over the buffer meta and process the supported entries.
-  success = gst_overlay_draw_detection_entries (overlay, composition, &index);
-  if (!success)
-    goto cleanup;
-
-  success = gst_overlay_draw_landmarks_entries (overlay, composition, &index);
-  if (!success)
-    goto cleanup;
-
-  success = gst_overlay_draw_classification_entries (overlay, composition, &index);
-  if (!success)
-    goto cleanup;
+  // Detections, landmarks, labels and boxes may be already drawn in the frame.
+  if (!direct) {
+    // Iterate over the buffer meta and process the supported entries.
+    success = gst_overlay_draw_detection_entries (overlay, composition, &index);
+    if (!success)
+      goto cleanup;
+
+    success = gst_overlay_draw_landmarks_entries (overlay, composition, &index);
+    if (!success)
+      goto cleanup;
+
+    success =
+        gst_overlay_draw_classification_entries (overlay, composition, &index);
+    if (!success)
+      goto cleanup;
+  }
 
   success = gst_overlay_draw_optclflow_entries (overlay, composition, &index);
   if (!success)
     goto cleanup;
 
   // Process manually set bounding boxes.
-  success = gst_overlay_draw_bbox_entries (overlay, composition, &index);
-  if (!success)
-    goto cleanup;
+  if (!direct) {
+    success = gst_overlay_draw_bbox_entries (overlay, composition, &index);
+    if (!success)
+      goto cleanup;
+  }
 
   // Process manually set timestamps.
   success = gst_overlay_draw_timestamp_entries (overlay, composition, &index);
@@ -1895,6 +2520,7 @@ gst_overlay_set_caps (GstBaseTransform * base, GstCaps * incaps,
 {
   GstVOverlay *overlay = GST_OVERLAY (base);
   GstVideoInfo info = { 0 };
+  GstCaps *caps = NULL;
   guint ovltype = 0, width = 0, height = 0;
   gint num = 1, denum = 1;
 
@@ -1921,8 +2547,6 @@ gst_overlay_set_caps (GstBaseTransform * base, GstCaps * incaps,
 
   // Initialize internal overlay buffer pools.
   for (ovltype = 0; ovltype < GST_OVERLAY_TYPE_MAX; ovltype++) {
-    GstCaps *caps = NULL;
-
     width = GST_VIDEO_INFO_WIDTH (overlay->vinfo);
     height = GST_VIDEO_INFO_HEIGHT (overlay->vinfo);
 
@@ -1977,6 +2601,22 @@ gst_overlay_set_caps (GstBaseTransform * base, GstCaps * incaps,
     gst_caps_unref (caps);
   }
 
+  // Release the previous label atlas and create a pool for the new one.
+  gst_overlay_label_atlas_reset (overlay);
+
+  width = GST_VIDEO_INFO_WIDTH (overlay->ovlinfos[GST_OVERLAY_TYPE_CLASSIFICATION]);
+  height = GST_ROUND_UP_4 (LABEL_FONTSIZE) * LABEL_ATLAS_ROWS;
+
+  caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING, "BGRA",
+      "width", G_TYPE_INT, width, "height", G_TYPE_INT, height, NULL);
+
+  if (gst_video_info_from_caps (&info, caps)) {
+    overlay->atlaspool = gst_overlay_create_pool (overlay, caps);
+    overlay->atlasinfo = gst_video_info_copy (&info);
+  }
+
+  gst_caps_unref (caps);
+
   gst_base_transform_set_passthrough (base, FALSE);
   gst_base_transform_set_in_place (base, TRUE);
 
@@ -2011,7 +2651,7 @@ gst_overlay_transform_ip (GstBaseTransform * base, GstBuffer * buffer)
   GstVOverlay *overlay = GST_OVERLAY (base);
   GstVideoComposition composition = GST_VCE_COMPOSITION_INIT;
   GstClockTime time = GST_CLOCK_TIME_NONE;
-  gboolean success = FALSE;
+  gboolean success = FALSE, direct = FALSE;
 
   // GAP buffer, nothing to do. Propagate buffer downstream.
   if (gst_buffer_get_size (buffer) == 0 &&
@@ -2035,16 +2675,25 @@ gst_overlay_transform_ip (GstBaseTransform * base, GstBuffer * buffer)
 
   composition.info = overlay->vinfo;
 
+  GST_OVERLAY_LOCK (overlay);
+  direct = overlay->directdraw && gst_overlay_yuv_is_supported (overlay->vinfo);
+  GST_OVERLAY_UNLOCK (overlay);
+
+  // Draw the supported entries directly into the frame without composition.
+  if (direct && !gst_overlay_yuv_draw_entries (overlay, buffer)) {
+    GST_ERROR_OBJECT (overlay, "Failed to draw overlays into the frame!");
+    return GST_FLOW_ERROR;
+  }
+
   // Extract metadata entries from the buffer and create overlay blit objects.
-  if (!gst_overlay_draw_ovelay_blits (overlay, &composition)) {
+  if (!gst_overlay_draw_ovelay_blits (overlay, &composition, direct)) {
     GST_ERROR_OBJECT (overlay, "Failed to draw overlay frames!");
     return GST_FLOW_ERROR;
   }
 
   // Check if there is need for applying any overlay frames.
-  if (composition.blits == NULL && composition.n_blits == 0) {
-    return GST_FLOW_OK;
-  }
+  if (composition.blits == NULL && composition.n_blits == 0)
+    goto done;
 
   success = gst_video_converter_engine_compose (overlay->converter,
       &composition, 1, NULL);
@@ -2056,6 +2705,7 @@ gst_overlay_transform_ip (GstBaseTransform * base, GstBuffer * buffer)
     return GST_FLOW_ERROR;
   }
 
+done:
   time = GST_CLOCK_DIFF (time, gst_util_get_timestamp ());
 
   GST_LOG_OBJECT (overlay, "Process took %" G_GINT64_FORMAT ".%03"
@@ -2161,6 +2811,9 @@ gst_overlay_set_property (GObject * object, guint prop_id,
       if (!gst_extract_static_images (&list, overlay->simages))
         GST_ERROR_OBJECT (overlay, "Failed to exract static images!");
 
+      break;
+    case PROP_DIRECT_DRAW:
+      overlay->directdraw = g_value_get_boolean (value);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -2202,6 +2855,9 @@ gst_overlay_get_property (GObject * object, guint prop_id,
       string = gst_serialize_static_images (overlay->simages);
       g_value_take_string (value, string);
       break;
+    case PROP_DIRECT_DRAW:
+      g_value_set_boolean (value, overlay->directdraw);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2233,6 +2889,16 @@ gst_overlay_finalize (GObject * object)
 
   gst_video_converter_engine_free (overlay->converter);
 
+  gst_overlay_label_atlas_reset (overlay);
+
+  g_hash_table_destroy (overlay->labels);
+  g_queue_free (overlay->lrulabels);
+
+  // Text masks are owned by the queue, the hash table only indexes them.
+  g_hash_table_destroy (overlay->textmasks);
+  g_queue_free_full (overlay->lrutextmasks,
+      (GDestroyNotify) gst_overlay_text_mask_free);
+
   for (idx = 0; idx < GST_OVERLAY_TYPE_MAX; idx++) {
     if (overlay->ovlpools[idx] != NULL)
       gst_object_unref (overlay->ovlpools[idx]);
@@ -2310,6 +2976,14 @@ gst_overlay_class_init (GstVOverlayClass * klass)
           "\\\"Mask2,color=0xRRGGBBAA,rectangle=<0,0,20,10>;\\\",(structure)"
           "\\\"Mask3,color=0xRRGGBBAA,polygon=<<2,2>,<2,4>,<4,4>>;\\\"}\"", NULL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_DIRECT_DRAW,
+      g_param_spec_boolean ("direct-draw", "Direct draw",
+          "Draw detection boxes, landmarks, labels and bounding boxes directly "
+          "into the planes of NV12/NV21 frames instead of composing them from "
+          "intermediate RGBA overlay buffers. Only the drawn pixels are "
+          "touched. Other formats and overlay types are always composed.",
+          DEFAULT_PROP_DIRECT_DRAW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING));
 
   gst_element_class_set_static_metadata (element, "Video Overlay",
       "Filter/Effect", "Generic plugin to extract meta like ROI from image "
@@ -2341,6 +3015,17 @@ gst_overlay_init (GstVOverlay * overlay)
     overlay->ovlinfos[idx] = NULL;
   }
 
+  overlay->atlaspool = NULL;
+  overlay->atlasinfo = NULL;
+  overlay->atlas = NULL;
+
+  overlay->labels = g_hash_table_new (g_str_hash, g_str_equal);
+  overlay->lrulabels = g_queue_new ();
+  overlay->n_frames = 0;
+
+  overlay->textmasks = g_hash_table_new (g_str_hash, g_str_equal);
+  overlay->lrutextmasks = g_queue_new ();
+
   overlay->converter = NULL;
 
   overlay->bboxes = g_array_new (FALSE, TRUE, sizeof (GstOverlayBBox));
@@ -2348,6 +3033,7 @@ gst_overlay_init (GstVOverlay * overlay)
   overlay->strings = g_array_new (FALSE, TRUE, sizeof (GstOverlayString));
   overlay->simages = g_array_new (FALSE, TRUE, sizeof (GstOverlayImage));
   overlay->masks = g_array_new (FALSE, TRUE, sizeof (GstOverlayMask));
+  overlay->directdraw = DEFAULT_PROP_DIRECT_DRAW;
 
   g_array_set_clear_func (overlay->timestamps,
       (GDestroyNotify) gst_overlay_timestamp_free);
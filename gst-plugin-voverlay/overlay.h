@@ -49,6 +49,21 @@ struct _GstVOverlay {
   /// Video info for the intermediary buffers produced by the pools.
   GstVideoInfo         *ovlinfos[GST_OVERLAY_TYPE_MAX];
 
+  /// Atlas with cached classification labels, each one in a separate slot.
+  GstBufferPool        *atlaspool;
+  GstVideoInfo         *atlasinfo;
+  GstBuffer            *atlas;
+  /// Cached labels (GstOverlayLabel) and their least recently used order.
+  GHashTable           *labels;
+  GQueue               *lrulabels;
+  /// Number of processed frames, used to detect labels in use.
+  guint64              n_frames;
+
+  /// Cached text masks (GstOverlayTextMask) used when drawing directly
+  /// into YUV frames and their least recently used order.
+  GHashTable           *textmasks;
+  GQueue               *lrutextmasks;
+
   /// Video converter engine.
   GstVideoConvEngine   *converter;
 
@@ -58,6 +73,7 @@ struct _GstVOverlay {
   GArray               *strings;
   GArray               *simages;
   GArray               *masks;
+  gboolean             directdraw;
 };
 
 struct _GstVOverlayClass {
@@ -55,6 +55,21 @@ gst_overlay_image_free (GstOverlayImage * simage)
     g_free (simage->path);
 }
 
+void
+gst_overlay_label_free (GstOverlayLabel * label)
+{
+  g_free (label->key);
+  g_free (label);
+}
+
+void
+gst_overlay_text_mask_free (GstOverlayTextMask * mask)
+{
+  g_free (mask->data);
+  g_free (mask->key);
+  g_free (mask);
+}
+
 gboolean
 gst_extract_bboxes (const GValue * value, GArray * bboxes)
 {
@@ -33,6 +33,8 @@ typedef struct _GstOverlayBBox GstOverlayBBox;
 typedef struct _GstOverlayString GstOverlayString;
 typedef struct _GstOverlayImage GstOverlayImage;
 typedef struct _GstOverlayMask GstOverlayMask;
+typedef struct _GstOverlayLabel GstOverlayLabel;
+typedef struct _GstOverlayTextMask GstOverlayTextMask;
 
 enum
 {
@@ -230,6 +232,44 @@ struct _GstOverlayImage {
   GstVideoBlit      blit;
 };
 
+/**
+ * GstOverlayLabel:
+ * @key: Font size, color and text of the label, used as lookup key.
+ * @slot: Index of the label atlas slot containing the rendered label.
+ * @width: Width of the rendered label in pixels.
+ * @frame: Number of the frame in which the label was last used.
+ * @link: Position of the label in the least recently used queue.
+ *
+ * Classification label rendered in the label atlas.
+ */
+struct _GstOverlayLabel {
+  gchar             *key;
+  guint             slot;
+  gint              width;
+  guint64           frame;
+  GList             *link;
+};
+
+/**
+ * GstOverlayTextMask:
+ * @key: Font size and text of the mask, used as lookup key.
+ * @data: Rasterized text coverage, 1 byte per pixel.
+ * @width: Width of the mask in pixels.
+ * @height: Height of the mask in pixels.
+ * @stride: Number of bytes between the mask rows.
+ * @link: Position of the mask in the least recently used queue.
+ *
+ * Text rendered only as alpha coverage, blended directly into YUV frames.
+ */
+struct _GstOverlayTextMask {
+  gchar             *key;
+  guint8            *data;
+  gint              width;
+  gint              height;
+  gint              stride;
+  GList             *link;
+};
+
 void
 gst_overlay_timestamp_free (GstOverlayTimestamp * timestamp);
 
@@ -239,6 +279,12 @@ gst_overlay_string_free (GstOverlayString * string);
 void
 gst_overlay_image_free (GstOverlayImage * simage);
 
+void
+gst_overlay_label_free (GstOverlayLabel * label);
+
+void
+gst_overlay_text_mask_free (GstOverlayTextMask * mask);
+
 gboolean
 gst_extract_bboxes (const GValue * value, GArray * bboxes);
 
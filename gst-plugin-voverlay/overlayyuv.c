@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "overlayyuv.h"
+
+#include <string.h>
+#include <math.h>
+
+#include <gst/utils/common-utils.h>
+
+// Maximum number of horizontal spans a shape can have on a single row.
+#define GST_OVERLAY_MAX_SPANS 2
+
+typedef struct _GstOverlayOutline GstOverlayOutline;
+typedef struct _GstOverlayQuad GstOverlayQuad;
+typedef struct _GstOverlayCircle GstOverlayCircle;
+
+// Returns the number of [start, end) pixel spans which the shape occupies
+// on the given row, the spans are stored as pairs in the array.
+typedef guint (*GstOverlaySpansFunc) (gconstpointer shape, gint row,
+    gint * spans);
+
+struct _GstOverlayOutline {
+  GstVideoRectangle outer;
+  GstVideoRectangle inner;
+};
+
+struct _GstOverlayQuad {
+  gdouble x[4];
+  gdouble y[4];
+};
+
+struct _GstOverlayCircle {
+  gdouble x;
+  gdouble y;
+  gdouble radius;
+};
+
+static inline void
+gst_overlay_yuv_blend (guint8 * pixel, guint8 value, guint alpha)
+{
+  *pixel = *pixel + ((((gint) value) - ((gint) *pixel)) * ((gint) alpha)) / 255;
+}
+
+static inline void
+gst_overlay_yuv_chroma_offsets (const GstVideoFrame * frame, guint * uoffset,
+    guint * voffset)
+{
+  // Chroma plane is interleaved, NV21 stores the V component first.
+  *uoffset = (GST_VIDEO_FRAME_FORMAT (frame) == GST_VIDEO_FORMAT_NV21) ? 1 : 0;
+  *voffset = (GST_VIDEO_FRAME_FORMAT (frame) == GST_VIDEO_FORMAT_NV21) ? 0 : 1;
+}
+
+static guint
+gst_overlay_rectangle_spans (gconstpointer shape, gint row, gint * spans)
+{
+  const GstVideoRectangle *rectangle = shape;
+
+  if ((row < rectangle->y) || (row >= (rectangle->y + rectangle->h)))
+    return 0;
+
+  spans[0] = rectangle->x;
+  spans[1] = rectangle->x + rectangle->w;
+
+  return 1;
+}
+
+static guint
+gst_overlay_outline_spans (gconstpointer shape, gint row, gint * spans)
+{
+  const GstOverlayOutline *outline = shape;
+  const GstVideoRectangle *outer = &(outline->outer), *inner = &(outline->inner);
+
+  if ((row < outer->y) || (row >= (outer->y + outer->h)))
+    return 0;
+
+  spans[0] = outer->x;
+  spans[1] = outer->x + outer->w;
+
+  // Top and bottom edges or the box is thinner than its lines.
+  if ((inner->w <= 0) || (inner->h <= 0) ||
+      (row < inner->y) || (row >= (inner->y + inner->h)))
+    return 1;
+
+  // Left and right edges, leave the inside of the box untouched.
+  spans[1] = inner->x;
+
+  spans[2] = inner->x + inner->w;
+  spans[3] = outer->x + outer->w;
+
+  return 2;
+}
+
+static guint
+gst_overlay_quad_spans (gconstpointer shape, gint row, gint * spans)
+{
+  const GstOverlayQuad *quad = shape;
+  gdouble y = row + 0.5, x = 0.0, left = G_MAXDOUBLE, right = -G_MAXDOUBLE;
+  guint idx = 0, next = 0;
+
+  // Intersect the pixel centre line with each of the quadrilateral edges.
+  for (idx = 0; idx < 4; idx++) {
+    next = (idx + 1) % 4;
+
+    if (quad->y[idx] == quad->y[next])
+      continue;
+
+    if ((y < MIN (quad->y[idx], quad->y[next])) ||
+        (y >= MAX (quad->y[idx], quad->y[next])))
+      continue;
+
+    x = quad->x[idx] + (y - quad->y[idx]) *
+        (quad->x[next] - quad->x[idx]) / (quad->y[next] - quad->y[idx]);
+
+    left = MIN (left, x);
+    right = MAX (right, x);
+  }
+
+  if (left > right)
+    return 0;
+
+  // Cover the pixels whose centres lie inside the quadrilateral.
+  spans[0] = ceil (left - 0.5);
+  spans[1] = floor (right - 0.5) + 1;
+
+  // Lines thinner than a pixel still need to be visible.
+  if (spans[1] <= spans[0]) {
+    spans[0] = floor ((left + right) / 2.0);
+    spans[1] = spans[0] + 1;
+  }
+
+  return 1;
+}
+
+static guint
+gst_overlay_circle_spans (gconstpointer shape, gint row, gint * spans)
+{
+  const GstOverlayCircle *circle = shape;
+  gdouble dx = 0.0, dy = row + 0.5 - circle->y;
+
+  if (fabs (dy) > circle->radius)
+    return 0;
+
+  dx = sqrt ((circle->radius * circle->radius) - (dy * dy));
+
+  spans[0] = ceil (circle->x - dx - 0.5);
+  spans[1] = floor (circle->x + dx - 0.5) + 1;
+
+  return (spans[1] > spans[0]) ? 1 : 0;
+}
+
+static void
+gst_overlay_yuv_fill_spans (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, GstOverlaySpansFunc func,
+    gconstpointer shape, gint top, gint bottom)
+{
+  gint spans[2][GST_OVERLAY_MAX_SPANS * 2];
+  guint n_spans[2] = { 0, 0 };
+  guint8 *luma = NULL, *chroma = NULL;
+  gint width = 0, height = 0, row = 0, line = 0, x = 0, left = 0, right = 0;
+  guint num = 0, uoffset = 0, voffset = 0, coverage = 0;
+
+  if (color->alpha == 0)
+    return;
+
+  width = GST_VIDEO_FRAME_WIDTH (frame);
+  height = GST_VIDEO_FRAME_HEIGHT (frame);
+
+  gst_overlay_yuv_chroma_offsets (frame, &uoffset, &voffset);
+
+  // Chroma is subsampled 2x2, walk the rows in pairs which share chroma.
+  top = MAX (top, 0) & ~1;
+  bottom = MIN (bottom, height);
+
+  for (row = top; row < bottom; row += 2) {
+    left = width;
+    right = 0;
+
+    for (line = 0; line < 2; line++) {
+      n_spans[line] = ((row + line) < bottom) ?
+          func (shape, row + line, spans[line]) : 0;
+
+      luma = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+      luma += (row + line) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+
+      for (num = 0; num < n_spans[line]; num++) {
+        gint *span = &(spans[line][num * 2]);
+
+        span[0] = CLAMP (span[0], 0, width);
+        span[1] = CLAMP (span[1], 0, width);
+
+        if (span[0] >= span[1])
+          continue;
+
+        if (color->alpha == 0xFF) {
+          memset (luma + span[0], color->y, span[1] - span[0]);
+        } else {
+          for (x = span[0]; x < span[1]; x++)
+            gst_overlay_yuv_blend (&luma[x], color->y, color->alpha);
+        }
+
+        left = MIN (left, span[0]);
+        right = MAX (right, span[1]);
+      }
+    }
+
+    chroma = GST_VIDEO_FRAME_PLANE_DATA (frame, 1);
+    chroma += (row / 2) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1);
+
+    // Weight each chroma sample by the number of luma pixels drawn over it.
+    for (x = (left & ~1); x < right; x += 2) {
+      coverage = 0;
+
+      for (line = 0; line < 2; line++) {
+        for (num = 0; num < n_spans[line]; num++) {
+          gint *span = &(spans[line][num * 2]);
+          coverage += MAX (0, MIN (x + 2, span[1]) - MAX (x, span[0]));
+        }
+      }
+
+      if (coverage == 0)
+        continue;
+
+      gst_overlay_yuv_blend (&chroma[x + uoffset], color->u,
+          (color->alpha * coverage) / 4);
+      gst_overlay_yuv_blend (&chroma[x + voffset], color->v,
+          (color->alpha * coverage) / 4);
+    }
+  }
+}
+
+gboolean
+gst_overlay_yuv_is_supported (const GstVideoInfo * info)
+{
+  return (GST_VIDEO_INFO_FORMAT (info) == GST_VIDEO_FORMAT_NV12) ||
+      (GST_VIDEO_INFO_FORMAT (info) == GST_VIDEO_FORMAT_NV21);
+}
+
+void
+gst_overlay_yuv_color (const GstVideoFrame * frame, guint color,
+    GstOverlayYuvColor * yuv)
+{
+  const GstVideoColorimetry *colorimetry =
+      &(GST_VIDEO_INFO_COLORIMETRY (&(frame->info)));
+  gdouble kr = 0.0, kb = 0.0, red = 0.0, green = 0.0, blue = 0.0, luma = 0.0;
+  gdouble offset = 16.0, yrange = 219.0, crange = 224.0;
+
+  // Fallback to BT.601 coefficients if the frame doesn't specify a matrix.
+  if (!gst_video_color_matrix_get_Kr_Kb (colorimetry->matrix, &kr, &kb)) {
+    kr = 0.299;
+    kb = 0.114;
+  }
+
+  if (colorimetry->range == GST_VIDEO_COLOR_RANGE_0_255) {
+    offset = 0.0;
+    yrange = crange = 255.0;
+  }
+
+  red = GST_FLOAT_COLOR_RED (color);
+  green = GST_FLOAT_COLOR_GREEN (color);
+  blue = GST_FLOAT_COLOR_BLUE (color);
+
+  luma = (kr * red) + ((1.0 - kr - kb) * green) + (kb * blue);
+
+  yuv->y = CLAMP (floor (offset + (luma * yrange) + 0.5), 0, 255);
+  yuv->u = CLAMP (floor (128.0 +
+      ((blue - luma) / (2.0 * (1.0 - kb)) * crange) + 0.5), 0, 255);
+  yuv->v = CLAMP (floor (128.0 +
+      ((red - luma) / (2.0 * (1.0 - kr)) * crange) + 0.5), 0, 255);
+  yuv->alpha = GST_COLOR_ALPHA (color);
+}
+
+void
+gst_overlay_yuv_fill_rectangle (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gint x, gint y, gint width, gint height)
+{
+  GstVideoRectangle rectangle = { x, y, width, height };
+
+  gst_overlay_yuv_fill_spans (frame, color, gst_overlay_rectangle_spans,
+      &rectangle, y, y + height);
+}
+
+void
+gst_overlay_yuv_draw_rectangle (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gint x, gint y, gint width, gint height,
+    gint linewidth)
+{
+  GstOverlayOutline outline;
+
+  // Lines are centered on the rectangle edges, same as a stroked path.
+  outline.outer.x = x - (linewidth / 2);
+  outline.outer.y = y - (linewidth / 2);
+  outline.outer.w = width + linewidth;
+  outline.outer.h = height + linewidth;
+
+  outline.inner.x = outline.outer.x + linewidth;
+  outline.inner.y = outline.outer.y + linewidth;
+  outline.inner.w = width - linewidth;
+  outline.inner.h = height - linewidth;
+
+  gst_overlay_yuv_fill_spans (frame, color, gst_overlay_outline_spans,
+      &outline, outline.outer.y, outline.outer.y + outline.outer.h);
+}
+
+void
+gst_overlay_yuv_draw_line (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gdouble x, gdouble y, gdouble dx,
+    gdouble dy, gdouble linewidth)
+{
+  GstOverlayQuad quad;
+  gdouble length = 0.0, nx = 0.0, ny = 0.0;
+  guint idx = 0;
+  gint top = G_MAXINT, bottom = G_MININT;
+
+  length = hypot (dx - x, dy - y);
+
+  if (length == 0.0)
+    return;
+
+  // Offset the line by half of its width along its normal on both sides.
+  nx = -(dy - y) / length * (linewidth / 2.0);
+  ny = (dx - x) / length * (linewidth / 2.0);
+
+  quad.x[0] = x + nx;
+  quad.y[0] = y + ny;
+  quad.x[1] = dx + nx;
+  quad.y[1] = dy + ny;
+  quad.x[2] = dx - nx;
+  quad.y[2] = dy - ny;
+  quad.x[3] = x - nx;
+  quad.y[3] = y - ny;
+
+  for (idx = 0; idx < 4; idx++) {
+    top = MIN (top, (gint) floor (quad.y[idx]));
+    bottom = MAX (bottom, (gint) ceil (quad.y[idx]) + 1);
+  }
+
+  gst_overlay_yuv_fill_spans (frame, color, gst_overlay_quad_spans, &quad,
+      top, bottom);
+}
+
+void
+gst_overlay_yuv_draw_polyline (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, const gdouble * points, guint n_points,
+    gdouble linewidth)
+{
+  guint idx = 0;
+
+  // Points are stored as consecutive X and Y coordinate pairs.
+  for (idx = 1; idx < n_points; idx++) {
+    gst_overlay_yuv_draw_line (frame, color, points[(idx - 1) * 2],
+        points[(idx - 1) * 2 + 1], points[idx * 2], points[idx * 2 + 1],
+        linewidth);
+  }
+}
+
+void
+gst_overlay_yuv_fill_circle (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gdouble x, gdouble y, gdouble radius)
+{
+  GstOverlayCircle circle = { x, y, radius };
+
+  gst_overlay_yuv_fill_spans (frame, color, gst_overlay_circle_spans, &circle,
+      floor (y - radius), ceil (y + radius) + 1);
+}
+
+void
+gst_overlay_yuv_draw_mask (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gint x, gint y, const guint8 * mask,
+    gint width, gint height, gint stride)
+{
+  const guint8 *source = NULL;
+  guint8 *luma = NULL, *chroma = NULL;
+  gint left = 0, right = 0, top = 0, bottom = 0, row = 0, line = 0, column = 0;
+  guint uoffset = 0, voffset = 0, coverage = 0;
+
+  if (color->alpha == 0)
+    return;
+
+  gst_overlay_yuv_chroma_offsets (frame, &uoffset, &voffset);
+
+  left = MAX (x, 0);
+  right = MIN (x + width, (gint) GST_VIDEO_FRAME_WIDTH (frame));
+  top = MAX (y, 0) & ~1;
+  bottom = MIN (y + height, (gint) GST_VIDEO_FRAME_HEIGHT (frame));
+
+  if (left >= right)
+    return;
+
+  for (row = top; row < bottom; row += 2) {
+    chroma = GST_VIDEO_FRAME_PLANE_DATA (frame, 1);
+    chroma += (row / 2) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1);
+
+    for (line = 0; line < 2; line++) {
+      if (((row + line) < y) || ((row + line) >= bottom))
+        continue;
+
+      source = mask + ((row + line - y) * stride) - x;
+
+      luma = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+      luma += (row + line) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+
+      for (column = left; column < right; column++) {
+        if (source[column] != 0)
+          gst_overlay_yuv_blend (&luma[column], color->y,
+              (source[column] * color->alpha) / 255);
+      }
+    }
+
+    // Average the mask over each 2x2 block for the shared chroma sample.
+    for (column = (left & ~1); column < right; column += 2) {
+      coverage = 0;
+
+      for (line = 0; line < 2; line++) {
+        if (((row + line) < y) || ((row + line) >= bottom))
+          continue;
+
+        source = mask + ((row + line - y) * stride) - x;
+
+        coverage += (column >= left) ? source[column] : 0;
+        coverage += ((column + 1) < right) ? source[column + 1] : 0;
+      }
+
+      if (coverage == 0)
+        continue;
+
+      gst_overlay_yuv_blend (&chroma[column + uoffset], color->u,
+          (coverage * color->alpha) / (4 * 255));
+      gst_overlay_yuv_blend (&chroma[column + voffset], color->v,
+          (coverage * color->alpha) / (4 * 255));
+    }
+  }
+}
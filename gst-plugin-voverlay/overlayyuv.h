@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __GST_QTI_OVERLAY_YUV_H__
+#define __GST_QTI_OVERLAY_YUV_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstOverlayYuvColor GstOverlayYuvColor;
+
+/**
+ * GstOverlayYuvColor:
+ * @y: Luma component.
+ * @u: Blue difference chroma component.
+ * @v: Red difference chroma component.
+ * @alpha: Opacity, 0 is fully transparent and 255 is fully opaque.
+ *
+ * Drawing color converted to the colorimetry of the frame.
+ */
+struct _GstOverlayYuvColor {
+  guint8 y;
+  guint8 u;
+  guint8 v;
+  guint8 alpha;
+};
+
+gboolean
+gst_overlay_yuv_is_supported (const GstVideoInfo * info);
+
+void
+gst_overlay_yuv_color (const GstVideoFrame * frame, guint color,
+    GstOverlayYuvColor * yuv);
+
+void
+gst_overlay_yuv_fill_rectangle (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gint x, gint y, gint width, gint height);
+
+void
+gst_overlay_yuv_draw_rectangle (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gint x, gint y, gint width, gint height,
+    gint linewidth);
+
+void
+gst_overlay_yuv_draw_line (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gdouble x, gdouble y, gdouble dx,
+    gdouble dy, gdouble linewidth);
+
+void
+gst_overlay_yuv_draw_polyline (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, const gdouble * points, guint n_points,
+    gdouble linewidth);
+
+void
+gst_overlay_yuv_fill_circle (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gdouble x, gdouble y, gdouble radius);
+
+void
+gst_overlay_yuv_draw_mask (GstVideoFrame * frame,
+    const GstOverlayYuvColor * color, gint x, gint y, const guint8 * mask,
+    gint width, gint height, gint stride);
+
+G_END_DECLS
+
+#endif // __GST_QTI_OVERLAY_YUV_H__
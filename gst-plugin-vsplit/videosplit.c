@@ -55,6 +55,8 @@ enum
 };
 
 typedef struct _GstVSplitRequest GstVSplitRequest;
+typedef struct _GstVideoSplitPlacement GstVideoSplitPlacement;
+typedef struct _GstVideoSplitShelf GstVideoSplitShelf;
 
 struct _GstVSplitRequest {
   GstMiniObject parent;
@@ -71,6 +73,25 @@ struct _GstVSplitRequest {
   GstClockTime  time;
 };
 
+// Position of a ROI crop inside one of the atlas canvases.
+struct _GstVideoSplitPlacement {
+  GstVideoRegionOfInterestMeta *roimeta;
+
+  // Index of the canvas or G_MAXUINT if the crop didn't fit.
+  guint             canvas;
+  GstVideoRectangle region;
+};
+
+// Horizontal row of crops inside an atlas canvas.
+struct _GstVideoSplitShelf {
+  guint canvas;
+
+  gint  y;
+  gint  height;
+  // Horizontal position of the next crop placed on this shelf.
+  gint  x;
+};
+
 GST_DEFINE_MINI_OBJECT_TYPE (GstVSplitRequest, gst_vsplit_request);
 
 static GstCaps *
@@ -185,7 +206,8 @@ gst_video_composition_cleanup (gpointer userdata)
   GstVideoComposition *composition = (GstVideoComposition*) userdata;
 
   // Free only video blits, output frame is owned by the request.
-  g_slice_free (GstVideoBlit, composition->blits);
+  g_slice_free1 (sizeof (GstVideoBlit) * composition->n_blits,
+      composition->blits);
 }
 
 static inline void
@@ -233,18 +255,18 @@ gst_buffer_find_region_of_interest_meta (GstBuffer * buffer, const guint index)
 
 static inline void
 gst_video_split_composition_populate_metas (GstVideoSplitSrcPad * srcpad,
-    GstVideoComposition * composition, GstVideoRegionOfInterestMeta * roimeta)
+    GstBuffer * outbuffer, GstVideoBlit * vblit,
+    GstVideoRegionOfInterestMeta * roimeta)
 {
-  GstBuffer *inbuffer = NULL, *outbuffer = NULL;
+  GstBuffer *inbuffer = NULL;
   GstVideoRectangle source = {0}, *destination = NULL;
   GstMeta *meta = NULL;
   gpointer state = NULL;
 
-  inbuffer = composition->blits[0].buffer;
-  outbuffer = composition->buffer;
+  inbuffer = vblit->buffer;
 
-  gst_video_quadrilateral_to_rectangle (&(composition->blits[0].source), &source);
-  destination = &(composition->blits[0].destination);
+  gst_video_quadrilateral_to_rectangle (&(vblit->source), &source);
+  destination = &(vblit->destination);
 
   while ((meta = gst_buffer_iterate_meta (inbuffer, &state))) {
     if (meta->info->api == GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE) {
@@ -296,6 +318,41 @@ gst_video_split_composition_populate_metas (GstVideoSplitSrcPad * srcpad,
   }
 }
 
+static inline void
+gst_video_split_attach_image_region (GstVideoSplitSrcPad * srcpad,
+    GstBuffer * outbuffer, GstVideoRectangle * destination,
+    GstVideoRegionOfInterestMeta * roimeta)
+{
+  GstVideoRegionOfInterestMeta *rmeta = NULL;
+
+  // Add ROI meta with the actual part of the buffer filled with image data.
+  rmeta = gst_buffer_add_video_region_of_interest_meta (outbuffer, "ImageRegion",
+      destination->x, destination->y, destination->w, destination->h);
+
+  // Propagate the original IDs of the ROI meta via the image region.
+  if (roimeta != NULL) {
+    GstStructure *structure = NULL;
+
+    rmeta->id = roimeta->id;
+    rmeta->parent_id = roimeta->parent_id;
+
+    // Transfer the additional ObjectDetection parameters if present.
+    structure = gst_video_region_of_interest_meta_get_param (roimeta,
+        "ObjectDetection");
+
+    if (structure != NULL) {
+      structure = gst_structure_copy (structure);
+      gst_structure_set (structure,
+          "label", G_TYPE_STRING, g_quark_to_string (roimeta->roi_type), NULL);
+
+      gst_video_region_of_interest_meta_add_param (rmeta, structure);
+    }
+  }
+
+  GST_TRACE_OBJECT (srcpad, "Attached 'ImageRegion' meta with ID[0x%X] parent "
+      "ID[0x%X] to buffer %p", rmeta->id, rmeta->parent_id, outbuffer);
+}
+
 static inline void
 gst_video_split_composition_update_regions (GstVideoSplitSrcPad * srcpad,
     GstVideoComposition * composition, GstVideoRegionOfInterestMeta * roimeta)
@@ -303,7 +360,6 @@ gst_video_split_composition_update_regions (GstVideoSplitSrcPad * srcpad,
   GstBuffer *outbuffer = NULL;
   GstVideoBlit *vblit = NULL;
   GstVideoRectangle source = {0}, *destination = NULL;
-  GstVideoRegionOfInterestMeta *rmeta = NULL;
   gint maxwidth = 0, maxheight = 0;
 
   outbuffer = composition->buffer;
@@ -340,32 +396,7 @@ gst_video_split_composition_update_regions (GstVideoSplitSrcPad * srcpad,
   destination->x += (maxwidth - destination->w) / 2;
   destination->y += (maxheight - destination->h) / 2;
 
-  // Add ROI meta with the actual part of the buffer filled with image data.
-  rmeta = gst_buffer_add_video_region_of_interest_meta (outbuffer, "ImageRegion",
-      destination->x, destination->y, destination->w, destination->h);
-
-  // Propagate the original IDs of the ROI meta via the image region.
-  if (roimeta != NULL) {
-    GstStructure *structure = NULL;
-
-    rmeta->id = roimeta->id;
-    rmeta->parent_id = roimeta->parent_id;
-
-    // Transfer the additional ObjectDetection parameters if present.
-    structure = gst_video_region_of_interest_meta_get_param (roimeta,
-        "ObjectDetection");
-
-    if (structure != NULL) {
-      structure = gst_structure_copy (structure);
-      gst_structure_set (structure,
-          "label", G_TYPE_STRING, g_quark_to_string (roimeta->roi_type), NULL);
-
-      gst_video_region_of_interest_meta_add_param (rmeta, structure);
-    }
-  }
-
-  GST_TRACE_OBJECT (srcpad, "Attached 'ImageRegion' meta with ID[0x%X] parent "
-      "ID[0x%X] to buffer %p", rmeta->id, rmeta->parent_id, outbuffer);
+  gst_video_split_attach_image_region (srcpad, outbuffer, destination, roimeta);
 }
 
 static gboolean
@@ -453,7 +484,8 @@ gst_video_split_srcpad_push_buffer (GstElement * element, GstPad * pad,
     outbuffer = g_array_index (buffers, GstBuffer*, idx);
 
     // Mark the first buffer in the bundle of frames that belong together.
-    if ((srcpad->mode == GST_VSPLIT_MODE_ROI_BATCH) && (idx == 0))
+    if (((srcpad->mode == GST_VSPLIT_MODE_ROI_BATCH) ||
+            (srcpad->mode == GST_VSPLIT_MODE_ROI_ATLAS)) && (idx == 0))
       GST_BUFFER_FLAG_SET (outbuffer, GST_VIDEO_BUFFER_FLAG_FIRST_IN_BUNDLE);
 
     gst_data_queue_push_object (srcpad->buffers, GST_MINI_OBJECT (outbuffer));
@@ -596,6 +628,240 @@ gst_video_split_stop_worker_task (GstVideoSplit * vsplit)
   return TRUE;
 }
 
+static inline void
+gst_video_split_composition_setup (GstVideoComposition * composition,
+    GstBuffer * outbuffer, GstVideoInfo * outinfo, guint n_blits)
+{
+  guint idx = 0;
+
+  composition->buffer = outbuffer;
+  composition->info = outinfo;
+  composition->datatype = GST_VCE_DATA_TYPE_U8;
+
+  composition->bgcolor = 0x00000000;
+  composition->bgfill = TRUE;
+
+  for (idx = 0; idx < GST_VCE_MAX_CHANNELS; ++idx) {
+    composition->scales[idx] = 1.0;
+    composition->offsets[idx] = 0.0;
+  }
+
+  composition->blits = g_slice_alloc0 (sizeof (GstVideoBlit) * n_blits);
+  composition->n_blits = n_blits;
+}
+
+static gint
+gst_video_split_placement_compare (gconstpointer a, gconstpointer b)
+{
+  const GstVideoSplitPlacement *l_placement =
+      *((const GstVideoSplitPlacement **) a);
+  const GstVideoSplitPlacement *r_placement =
+      *((const GstVideoSplitPlacement **) b);
+
+  // Tallest crops first, shelves are then opened with decreasing heights.
+  return r_placement->region.h - l_placement->region.h;
+}
+
+static guint
+gst_video_split_atlas_pack (GstVideoSplitSrcPad * srcpad,
+    GstVideoSplitPlacement * placements, guint n_placements)
+{
+  GPtrArray *order = NULL;
+  GArray *shelves = NULL;
+  gint *bottoms = NULL;
+  gint width = 0, height = 0;
+  guint idx = 0, num = 0, n_canvases = 0;
+
+  width = GST_VIDEO_INFO_WIDTH (srcpad->info);
+  height = GST_VIDEO_INFO_HEIGHT (srcpad->info);
+
+  order = g_ptr_array_sized_new (n_placements);
+  shelves = g_array_new (FALSE, FALSE, sizeof (GstVideoSplitShelf));
+  bottoms = g_new0 (gint, srcpad->maxcanvases);
+
+  for (idx = 0; idx < n_placements; idx++) {
+    GstVideoSplitPlacement *placement = &(placements[idx]);
+    GstVideoRectangle *region = &(placement->region);
+
+    region->w = placement->roimeta->w;
+    region->h = placement->roimeta->h;
+
+    // Downscale crops larger than the canvas while keeping the aspect ratio.
+    if ((region->w > width) || (region->h > height)) {
+      if ((region->w * height) > (region->h * width)) {
+        region->h = gst_util_uint64_scale_int (width, region->h, region->w);
+        region->w = width;
+      } else {
+        region->w = gst_util_uint64_scale_int (height, region->w, region->h);
+        region->h = height;
+      }
+    }
+
+    // Even dimensions keep the crops aligned to the chroma subsampling.
+    region->w = MAX (GST_ROUND_DOWN_2 (region->w), 2);
+    region->h = MAX (GST_ROUND_DOWN_2 (region->h), 2);
+
+    placement->canvas = G_MAXUINT;
+    g_ptr_array_add (order, placement);
+  }
+
+  g_ptr_array_sort (order, gst_video_split_placement_compare);
+
+  for (idx = 0; idx < order->len; idx++) {
+    GstVideoSplitPlacement *placement = g_ptr_array_index (order, idx);
+    GstVideoRectangle *region = &(placement->region);
+    GstVideoSplitShelf *shelf = NULL;
+
+    // First fit on an already opened shelf which is tall and wide enough.
+    for (num = 0; num < shelves->len; num++) {
+      shelf = &(g_array_index (shelves, GstVideoSplitShelf, num));
+
+      if ((region->h <= shelf->height) && ((shelf->x + region->w) <= width))
+        break;
+
+      shelf = NULL;
+    }
+
+    // Otherwise open a new shelf in the first canvas which has space left.
+    for (num = 0; (shelf == NULL) && (num < srcpad->maxcanvases); num++) {
+      GstVideoSplitShelf newshelf = { num, bottoms[num], region->h, 0 };
+
+      if ((bottoms[num] + region->h) > height)
+        continue;
+
+      bottoms[num] += region->h;
+
+      g_array_append_val (shelves, newshelf);
+      shelf = &(g_array_index (shelves, GstVideoSplitShelf, shelves->len - 1));
+    }
+
+    if (shelf == NULL) {
+      GST_WARNING_OBJECT (srcpad, "No space left in %u canvases, dropping ROI "
+          "with ID[0x%X]!", srcpad->maxcanvases, placement->roimeta->id);
+      continue;
+    }
+
+    region->x = shelf->x;
+    region->y = shelf->y;
+
+    shelf->x += region->w;
+
+    placement->canvas = shelf->canvas;
+    n_canvases = MAX (n_canvases, shelf->canvas + 1);
+  }
+
+  g_free (bottoms);
+  g_array_free (shelves, TRUE);
+  g_ptr_array_free (order, TRUE);
+
+  return n_canvases;
+}
+
+static gboolean
+gst_video_split_populate_atlas_compositions (GstVideoSplit * vsplit,
+    GstVideoSplitSrcPad * srcpad, GstBuffer * inbuffer, GPtrArray * buffers,
+    GArray * compositions, guint n_metas)
+{
+  GstVideoInfo *ininfo = GST_VIDEO_SPLIT_SINKPAD (vsplit->sinkpad)->info;
+  GstVideoSplitPlacement *placements = NULL;
+  GPtrArray *outbuffers = NULL;
+  GstBuffer *outbuffer = NULL;
+  GstVideoComposition *composition = NULL;
+  guint idx = 0, num = 0, id = 0, n_canvases = 0, n_blits = 0;
+  gboolean success = TRUE;
+
+  placements = g_new0 (GstVideoSplitPlacement, n_metas);
+
+  for (idx = 0; idx < n_metas; idx++)
+    placements[idx].roimeta =
+        gst_buffer_find_region_of_interest_meta (inbuffer, idx);
+
+  // Find the number of canvases and the position of each crop in them.
+  n_canvases = gst_video_split_atlas_pack (srcpad, placements, n_metas);
+
+  // None of the crops fit, the pad will produce GAP buffer.
+  if (n_canvases == 0) {
+    g_free (placements);
+    return TRUE;
+  }
+
+  outbuffers = g_ptr_array_sized_new (n_canvases);
+  g_ptr_array_set_size (outbuffers, n_canvases);
+
+  idx = g_list_index (vsplit->srcpads, srcpad);
+  g_ptr_array_index (buffers, idx) = outbuffers;
+
+  id = compositions->len;
+  g_array_set_size (compositions, compositions->len + n_canvases);
+
+  for (num = 0; num < n_canvases; num++, id++) {
+    GstVideoMeta *meta = NULL;
+
+    success = gst_video_split_acquire_output_buffer (srcpad, inbuffer, &outbuffer);
+
+    if (!success) {
+      GST_ERROR_OBJECT (srcpad, "Failed to acquire video frame!");
+      break;
+    }
+
+    composition = &(g_array_index (compositions, GstVideoComposition, id));
+    g_ptr_array_index (outbuffers, num) = outbuffer;
+
+    meta = gst_buffer_get_video_meta (outbuffer);
+
+    if (!gst_video_info_modify_with_meta (srcpad->info, meta))
+      GST_ERROR_OBJECT (vsplit, "Failed to derive info from meta");
+
+    for (idx = 0, n_blits = 0; idx < n_metas; idx++)
+      n_blits += (placements[idx].canvas == num) ? 1 : 0;
+
+    gst_video_split_composition_setup (composition, outbuffer, srcpad->info,
+        n_blits);
+
+    // Each crop placed on this canvas is a separate blit from the input.
+    for (idx = 0, n_blits = 0; idx < n_metas; idx++) {
+      GstVideoSplitPlacement *placement = &(placements[idx]);
+      GstVideoRegionOfInterestMeta *roimeta = placement->roimeta;
+      GstVideoBlit *vblit = NULL;
+      GstVideoRectangle source = {0};
+
+      if (placement->canvas != num)
+        continue;
+
+      vblit = &(composition->blits[n_blits++]);
+
+      vblit->buffer = inbuffer;
+      vblit->info = ininfo;
+      vblit->mask = GST_VCE_MASK_SOURCE | GST_VCE_MASK_DESTINATION;
+
+      vblit->alpha = G_MAXUINT8;
+      vblit->rotate = GST_VCE_ROTATE_0;
+
+      source.x = roimeta->x;
+      source.y = roimeta->y;
+      source.w = roimeta->w;
+      source.h = roimeta->h;
+
+      gst_video_quadrilateral_from_rectangle (&(vblit->source), &source);
+      vblit->destination = placement->region;
+
+      // Record the crop position and transfer its metas into the canvas.
+      gst_video_split_attach_image_region (srcpad, outbuffer,
+          &(vblit->destination), roimeta);
+      gst_video_split_composition_populate_metas (srcpad, outbuffer, vblit,
+          roimeta);
+
+      GST_TRACE_OBJECT (srcpad, "Composition [%u] Canvas [%u] Regions: [%d %d "
+          "%d %d] -> [%d %d %d %d]", id, num, source.x, source.y, source.w,
+          source.h, vblit->destination.x, vblit->destination.y,
+          vblit->destination.w, vblit->destination.h);
+    }
+  }
+
+  g_free (placements);
+  return success;
+}
+
 static gboolean
 gst_video_split_populate_frames_and_compositions (GstVideoSplit * vsplit,
     GstBuffer * inbuffer, GPtrArray * buffers, GArray * compositions)
@@ -606,7 +872,7 @@ gst_video_split_populate_frames_and_compositions (GstVideoSplit * vsplit,
   GstVideoComposition *composition = NULL;
   GstVideoRegionOfInterestMeta *roimeta = NULL;
   gpointer state = NULL;
-  guint idx = 0, num = 0, id = 0, n_metas = 0, n_entries = 0, i = 0;
+  guint idx = 0, num = 0, id = 0, n_metas = 0, n_entries = 0;
   gboolean success = TRUE;
   GstVideoMeta *meta = NULL;
   GstVideoInfo *ininfo = NULL;
@@ -643,6 +909,22 @@ gst_video_split_populate_frames_and_compositions (GstVideoSplit * vsplit,
     if ((srcpad->mode == GST_VSPLIT_MODE_ROI_BATCH) && (n_metas == 0))
       continue;
 
+    // Skip this pad as there is no ROI meta in atlas ROI mode.
+    if ((srcpad->mode == GST_VSPLIT_MODE_ROI_ATLAS) && (n_metas == 0))
+      continue;
+
+    // All ROI crops are packed together into a few output buffers.
+    if (srcpad->mode == GST_VSPLIT_MODE_ROI_ATLAS) {
+      success = gst_video_split_populate_atlas_compositions (vsplit, srcpad,
+          inbuffer, buffers, compositions, n_metas);
+
+      if (!success)
+        break;
+
+      id = compositions->len;
+      continue;
+    }
+
     n_entries = (srcpad->mode == GST_VSPLIT_MODE_ROI_BATCH) ? n_metas : 1;
     outbuffers = g_ptr_array_sized_new (n_entries);
     g_ptr_array_set_size (outbuffers, n_entries);
@@ -675,20 +957,7 @@ gst_video_split_populate_frames_and_compositions (GstVideoSplit * vsplit,
       if (!success)
         GST_ERROR_OBJECT (vsplit, "Failed to derive info from meta");
 
-      composition->buffer = outbuffer;
-      composition->info = outinfo;
-      composition->datatype = GST_VCE_DATA_TYPE_U8;
-
-      composition->bgcolor = 0x00000000;
-      composition->bgfill = TRUE;
-
-      for (i = 0; i < GST_VCE_MAX_CHANNELS; ++i) {
-        composition->scales[i] = 1.0;
-        composition->offsets[i] = 0.0;
-      }
-
-      composition->blits = g_slice_new0 (GstVideoBlit);
-      composition->n_blits = 1;
+      gst_video_split_composition_setup (composition, outbuffer, outinfo, 1);
 
       vblit = &(composition->blits[0]);
 
@@ -709,7 +978,8 @@ gst_video_split_populate_frames_and_compositions (GstVideoSplit * vsplit,
 
       // Update source/destination regions and output buffer meta.
       gst_video_split_composition_update_regions (srcpad, composition, roimeta);
-      gst_video_split_composition_populate_metas (srcpad, composition, roimeta);
+      gst_video_split_composition_populate_metas (srcpad, outbuffer, vblit,
+          roimeta);
 
       gst_video_quadrilateral_to_rectangle (&(vblit->source), &source);
       destination = &(vblit->destination);
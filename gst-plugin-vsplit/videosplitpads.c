@@ -19,6 +19,7 @@ GST_DEBUG_CATEGORY_EXTERN (gst_video_split_debug);
 #define GST_TYPE_VIDEO_SPLIT_MODE   (gst_video_split_mode_get_type())
 
 #define DEFAULT_PROP_MODE           GST_VSPLIT_MODE_NONE
+#define DEFAULT_PROP_MAX_CANVASES   1
 #define DEFAULT_PROP_MIN_BUFFERS    2
 #define DEFAULT_PROP_MAX_BUFFERS    20
 #define GST_VSPLIT_MAX_QUEUE_LEN    16
@@ -27,6 +28,7 @@ enum
 {
   PROP_0,
   PROP_MODE,
+  PROP_MAX_CANVASES,
 };
 
 static gboolean
@@ -90,6 +92,14 @@ gst_video_split_mode_get_type (void)
         "next plugin downstream. In case no ROI meta is present the pad will "
         "produce GAP buffer.", "batch-roi-meta"
     },
+    { GST_VSPLIT_MODE_ROI_ATLAS,
+        "Incoming buffer is checked for ROI meta. The crops for all meta "
+        "entries are packed next to each other into one or more buffers with "
+        "the negotiated pad caps, up to 'max-canvases'. The placement of each "
+        "crop is recorded in an 'ImageRegion' ROI meta with the ID of the "
+        "original ROI meta. In case no ROI meta is present the pad will "
+        "produce GAP buffer.", "atlas-roi-meta"
+    },
     {0, NULL, NULL},
   };
 
@@ -802,7 +812,8 @@ gst_video_split_srcpad_fixate_caps (GstVideoSplitSrcPad * srcpad,
   gboolean success = TRUE;
 
   // Overwrite the default multiview mode depending on the pad mode.
-  if (srcpad->mode == GST_VSPLIT_MODE_ROI_BATCH)
+  if ((srcpad->mode == GST_VSPLIT_MODE_ROI_BATCH) ||
+      (srcpad->mode == GST_VSPLIT_MODE_ROI_ATLAS))
     mviewmode = GST_VIDEO_MULTIVIEW_MODE_MULTIVIEW_FRAME_BY_FRAME;
 
   // Prefer caps with feature memory:GBM and removeall others.
@@ -1062,6 +1073,9 @@ gst_video_split_srcpad_set_property (GObject * object, guint prop_id,
     case PROP_MODE:
       srcpad->mode = g_value_get_enum (value);
       break;
+    case PROP_MAX_CANVASES:
+      srcpad->maxcanvases = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1078,6 +1092,9 @@ gst_video_split_srcpad_get_property (GObject * object, guint prop_id,
     case PROP_MODE:
       g_value_set_enum (value, srcpad->mode);
       break;
+    case PROP_MAX_CANVASES:
+      g_value_set_uint (value, srcpad->maxcanvases);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1122,6 +1139,13 @@ gst_video_split_srcpad_class_init (GstVideoSplitSrcPadClass * klass)
           GST_TYPE_VIDEO_SPLIT_MODE, DEFAULT_PROP_MODE,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject, PROP_MAX_CANVASES,
+      g_param_spec_uint ("max-canvases", "Max canvases",
+          "Maximum number of buffers per frame into which the ROI crops are "
+          "packed in 'atlas-roi-meta' mode. Crops which do not fit are dropped.",
+          1, DEFAULT_PROP_MAX_BUFFERS / 2, DEFAULT_PROP_MAX_CANVASES,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 void
@@ -1142,4 +1166,5 @@ gst_video_split_srcpad_init (GstVideoSplitSrcPad * pad)
       gst_data_queue_new (queue_is_full_cb, NULL, queue_empty_cb, pad);
 
   pad->mode = DEFAULT_PROP_MODE;
+  pad->maxcanvases = DEFAULT_PROP_MAX_CANVASES;
 }
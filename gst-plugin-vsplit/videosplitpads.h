@@ -77,6 +77,7 @@ typedef enum {
   GST_VSPLIT_MODE_FORCE_TRANSFORM,
   GST_VSPLIT_MODE_ROI_SINGLE,
   GST_VSPLIT_MODE_ROI_BATCH,
+  GST_VSPLIT_MODE_ROI_ATLAS,
 } GstVideoSplitMode;
 
 struct _GstVideoSplitSinkPad {
@@ -133,6 +134,7 @@ struct _GstVideoSplitSrcPad {
 
   /// Properties.
   GstVideoSplitMode mode;
+  guint             maxcanvases;
 };
 
 struct _GstVideoSplitSrcPadClass {
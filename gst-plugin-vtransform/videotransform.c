@@ -96,6 +96,7 @@ enum
   PROP_FLIP_VERTICAL,
   PROP_ROTATE,
   PROP_CROP,
+  PROP_PERSPECTIVE,
   PROP_DESTINATION,
   PROP_BACKGROUND,
 };
@@ -204,6 +205,13 @@ gst_video_transform_translate_rotation (GstVideoTransformRotate rotation)
   return GST_VCE_ROTATE_0;
 }
 
+static inline gboolean
+gst_video_transform_has_perspective (GstVideoTransform * vtrans)
+{
+  // Bottom-right point cannot be at the origin in a valid quadrilateral.
+  return (vtrans->perspective.d.x != 0) || (vtrans->perspective.d.y != 0);
+}
+
 static void
 gst_video_transform_determine_passthrough (GstVideoTransform * vtrans)
 {
@@ -230,6 +238,7 @@ gst_video_transform_determine_passthrough (GstVideoTransform * vtrans)
     passthrough &= vtrans->destination.w == 0 || vtrans->destination.h == 0;
   }
 
+  passthrough &= !gst_video_transform_has_perspective (vtrans);
   passthrough &= !vtrans->flip_h && !vtrans->flip_v;
   passthrough &= vtrans->rotation == GST_VIDEO_TRANSFORM_ROTATE_NONE;
 
@@ -1677,6 +1686,12 @@ gst_video_transform_transform (GstBaseTransform * base, GstBuffer * inbuffer,
     blit.mask |= GST_VCE_MASK_SOURCE;
   }
 
+  // Perspective quadrilateral takes precedence over the crop rectangle.
+  if (gst_video_transform_has_perspective (vtrans)) {
+    blit.source = vtrans->perspective;
+    blit.mask |= GST_VCE_MASK_SOURCE;
+  }
+
   if ((vtrans->destination.w != 0) && (vtrans->destination.h != 0)) {
     blit.destination = vtrans->destination;
     blit.mask |= GST_VCE_MASK_DESTINATION;
@@ -1804,6 +1819,23 @@ gst_video_transform_set_property (GObject * object, guint prop_id,
       vtrans->crop.h = height;
       break;
     }
+    case PROP_PERSPECTIVE:
+    {
+      GstVideoPoint *points[4] = { &(vtrans->perspective.a),
+          &(vtrans->perspective.b), &(vtrans->perspective.c),
+          &(vtrans->perspective.d) };
+      guint idx = 0;
+
+      g_return_if_fail (gst_value_array_get_size (value) == 8);
+
+      for (idx = 0; idx < 4; idx++) {
+        points[idx]->x =
+            g_value_get_int (gst_value_array_get_value (value, idx * 2));
+        points[idx]->y =
+            g_value_get_int (gst_value_array_get_value (value, idx * 2 + 1));
+      }
+      break;
+    }
     case PROP_DESTINATION:
     {
       guint x = 0, y = 0, width = 0, height = 0;
@@ -1886,6 +1918,25 @@ gst_video_transform_get_property (GObject * object, guint prop_id,
       gst_value_array_append_value (value, &val);
       break;
     }
+    case PROP_PERSPECTIVE:
+    {
+      GstVideoPoint *points[4] = { &(vtrans->perspective.a),
+          &(vtrans->perspective.b), &(vtrans->perspective.c),
+          &(vtrans->perspective.d) };
+      GValue val = G_VALUE_INIT;
+      guint idx = 0;
+
+      g_value_init (&val, G_TYPE_INT);
+
+      for (idx = 0; idx < 4; idx++) {
+        g_value_set_int (&val, points[idx]->x);
+        gst_value_array_append_value (value, &val);
+
+        g_value_set_int (&val, points[idx]->y);
+        gst_value_array_append_value (value, &val);
+      }
+      break;
+    }
     case PROP_DESTINATION:
     {
       GValue val = G_VALUE_INIT;
@@ -1987,6 +2038,16 @@ gst_video_transform_class_init (GstVideoTransformClass * klass)
               G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS),
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property (gobject, PROP_PERSPECTIVE,
+      gst_param_spec_array ("perspective", "Perspective quadrilateral",
+          "The source quadrilateral inside the input which is warped onto the "
+          "destination rectangle, points are upper-left, bottom-left, "
+          "upper-right and bottom-right ('<AX, AY, BX, BY, CX, CY, DX, DY>')",
+          g_param_spec_int ("value", "Point Value",
+              "One of the X or Y point coordinates.", G_MININT, G_MAXINT, 0,
+              G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
   g_object_class_install_property (gobject, PROP_DESTINATION,
       gst_param_spec_array ("destination", "Destination rectangle",
           "Destination rectangle inside the output ('<X, Y, WIDTH, HEIGHT >')",
@@ -2046,6 +2107,10 @@ gst_video_transform_init (GstVideoTransform * vtrans)
   vtrans->crop.y = DEFAULT_PROP_CROP_Y;
   vtrans->crop.w = DEFAULT_PROP_CROP_WIDTH;
   vtrans->crop.h = DEFAULT_PROP_CROP_HEIGHT;
+  vtrans->perspective.a.x = vtrans->perspective.a.y = 0;
+  vtrans->perspective.b.x = vtrans->perspective.b.y = 0;
+  vtrans->perspective.c.x = vtrans->perspective.c.y = 0;
+  vtrans->perspective.d.x = vtrans->perspective.d.y = 0;
   vtrans->destination.x = DEFAULT_PROP_DESTINATION_X;
   vtrans->destination.y = DEFAULT_PROP_DESTINATION_Y;
   vtrans->destination.w = DEFAULT_PROP_DESTINATION_WIDTH;
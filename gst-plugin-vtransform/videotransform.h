@@ -96,6 +96,7 @@ struct _GstVideoTransform {
   gboolean                flip_h;
   GstVideoTransformRotate rotation;
   GstVideoRectangle       crop;
+  GstVideoQuadrilateral   perspective;
   GstVideoRectangle       destination;
   guint                   background;
 };